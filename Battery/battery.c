@@ -14,12 +14,14 @@
 #include "m1_bq27421.h"
 #include "m1_power_ctl.h"
 #include "m1_bq25896.h"
+#include "m1_fusb302.h"
 #include "m1_log_debug.h"
 #include "m1_i2c.h"
 #include "m1_rf_spi.h"
 #include "m1_sdcard.h"
 #include "m1_esp32_hal.h"
 #include "uiView.h"
+#include "m1_tasks.h"
 #include "battery.h"
 
 /*************************** D E F I N E S ************************************/
@@ -78,6 +80,8 @@
 #define BQ2589X_IOTG_DEFAULT_IDX		 IOTG_1200mA // Default index of the Boost current array, 1200mA
 #define BQ2589X_SLPTO_DEFAULT_IDX		 SLEEP_SHIP_TIMEOUT_60S // Default index of the Sleep/Ship timeout array, 60 seconds
 
+#define BATTERY_FAST_CHARGE_INPUT_MW	15000 // Negotiated input that allows the higher charge current
+
 //************************** C O N S T A N T **********************************/
 static const uint16_t bq2589x_VCHG[4] = {3840, 4096, 4192, 4208}; // Charge voltage
 static const uint16_t bq2589x_ICHG[6] = {512, 1024, 1536, 2048, 2560, 3072};  // Charge current
@@ -90,15 +94,23 @@ static const uint16_t bq2589x_IOTG[5] = {500, 750, 1200, 1650, 2150}; // Boost c
 //************************** S T R U C T U R E S *******************************
 
 /***************************** V A R I A B L E S ******************************/
-S_M1_Power_Status_t power_status;
+S_M1_Power_Status_t power_status; // Snapshot, only changed by battery_status_update()
 TaskHandle_t		battery_task_hdl;
 
+static uint32_t snapshot_period_ms = TASKDELAY_BATTERY_INFO_TIMER;
+static volatile bool snapshot_stale = true; // Set by the charger and gauge interrupts
+
 /********************* F U N C T I O N   P R O T O T Y P E S ******************/
 
 //static void batteryThread(void *param);
 void battery_service_init(void);
 uint32_t battery_power_status_get(S_M1_Power_Status_t *pSystemPowerStatus);
 void battery_status_update(void);
+bool battery_status_poll(void);
+void battery_status_invalidate(void);
+void battery_status_period_set(uint32_t period_ms);
+uint32_t battery_status_period_get(void);
+void battery_input_limit_set(uint16_t mv, uint16_t ma);
 static void bq25896_SetDefaultConfig(void);
 /*************** F U N C T I O N   I M P L E M E N T A T I O N ****************/
 
@@ -115,6 +127,8 @@ void battery_service_init(void)
 	bq25896_SetDefaultConfig();
 
 	bq27421_init( 2100, 3200, 240); // Capacity(mA), terminate voltage(mV), taper current(mA, may be terminal current)
+
+	pd_fusb302_init(); // Negotiates the input power, see battery_input_limit_set()
 }
 
 
@@ -152,65 +166,167 @@ static void bq25896_SetDefaultConfig(void)
 
 /*============================================================================*/
 /**
-  * @brief
-  * @param
-  * @retval
+  * @brief  Copies the last snapshot of the gauge and charger. No I2C traffic,
+  *         the snapshot is refreshed by battery_status_poll().
+  * @param  pSystemPowerStatus copy of the snapshot
+  * @retval TRUE if the snapshot has been read at least once
   */
 /*============================================================================*/
 uint32_t battery_power_status_get(S_M1_Power_Status_t *pSystemPowerStatus)
 {
+	taskENTER_CRITICAL();
 	*pSystemPowerStatus = power_status; //data cpy
+	taskEXIT_CRITICAL();
+
+	return (pSystemPowerStatus->updated_ms!=0) ? TRUE : FALSE;
+} // uint32_t battery_power_status_get(S_M1_Power_Status_t *pSystemPowerStatus)
 
-	return TRUE;
-}
 
 
 /*============================================================================*/
 /**
-  * @brief
-  * @param
-  * @retval
+  * @brief  Reads the gauge and the charger into the snapshot now
+  * @param  None
+  * @retval None
   */
 /*============================================================================*/
 void battery_status_update(void)
 {
+	S_M1_Power_Status_t status = {0};
 	bq27421_info bat_info={0,};
-	bq27421_update(&bat_info);
+	uint8_t chrg_regs[REG12_ADDR - REGISTER0B_ADDR + 1] = {0};
+
+	snapshot_stale = false; // An interrupt from now on asks for another read
+	if ( !bq27421_update(&bat_info) )
+		M1_LOG_W(M1_LOGDB_TAG, "Gauge read failed\r\n");
+
 	////////////////////////////////////////
-	// Battery Charger fault
-	// 0 Normal, 1: Input, 2: Thermal Shutdown, 3: Safety Timer Expiration
-	power_status.fault = bq_getCHRG_FAULT();
+	// Battery Charger, REG0B status to REG12 charge current in one read
+	if ( !bq_readRegisters(REGISTER0B_ADDR, chrg_regs, sizeof(chrg_regs)) )
+		M1_LOG_W(M1_LOGDB_TAG, "Charger read failed\r\n");
 
+	// 0 Normal, 1: Input, 2: Thermal Shutdown, 3: Safety Timer Expiration
+	status.fault = (chrg_regs[REG0C_ADDR - REGISTER0B_ADDR] & REG0C_CHRG_FAULT) >> 4;
 	// 0: no charge 1: pre-charge 2: fast charge 3: charge complete
-	power_status.stat = bq_getCHRG_STAT();
+	status.stat = (chrg_regs[0] & REG0B_CHRG_STAT) >> 3;
 
-	power_status.consumption_current = bat_info.current_mA;
-	//power_status.battery_voltage = bat_info.voltage_mV / 1000.0f + 0.05;
-	power_status.battery_voltage = bat_info.voltage_mV;
-	power_status.battery_temp = (uint8_t)bat_info.temp_degC;
-	power_status.soh_state = bat_info.soh_state;
+	// Bus voltage and charge current of the conversion started last time
+	status.charge_voltage = (float)(chrg_regs[REG11_ADDR - REGISTER0B_ADDR] & REG11_VBUSV) * 0.1;
+	if ( status.charge_voltage > 0 )
+		status.charge_voltage += 2.6;
+	status.charge_current = chrg_regs[REG12_ADDR - REGISTER0B_ADDR] * 50;
+	bq_startOneShotADC();
 
-	power_status.flags = bat_info.flags;
-	power_status.status = bat_info.status;
+	status.consumption_current = bat_info.current_mA;
+	status.battery_voltage = bat_info.voltage_mV;
+	status.battery_temp = (uint8_t)bat_info.temp_degC;
+	status.soh_state = bat_info.soh_state;
 
-	power_status.battery_level = bat_info.soc_percent;
-	power_status.battery_health = bat_info.soh_percent;
+	status.flags = bat_info.flags;
+	status.status = bat_info.status;
 
-	////////////////////////////////////////
-	// Battery Charger
-	// Charge Voltage, Bus voltage
-	bq_startADC();
-	bq_oneShotADC();
+	status.battery_level = bat_info.soc_percent;
+	status.battery_health = bat_info.soh_percent;
+	status.remaining_capacity = bat_info.remainingCapacity_mAh;
+	status.full_capacity = bat_info.fullChargeCapacity_mAh;
 
-	power_status.charge_voltage = bq_getVBUSV();
+	status.updated_ms = HAL_GetTick();
+	if ( !status.updated_ms )
+		status.updated_ms = 1; // 0 means never read
 
-	// Charge Current
-	power_status.charge_current = bq_getICHGR();
+	taskENTER_CRITICAL();
+	power_status = status;
+	taskEXIT_CRITICAL();
+} // void battery_status_update(void)
 
-	// battery temperature
-	//power_status.battery_temp = (int)bq_getTSPCT();
 
-	bq_stopADC();
-}
+
+/*============================================================================*/
+/**
+  * @brief  Refreshes the snapshot when the period has passed or the charger
+  *         or gauge interrupt reported a change. Called by the system task.
+  * @param  None
+  * @retval true if the snapshot was read again
+  */
+/*============================================================================*/
+bool battery_status_poll(void)
+{
+	uint32_t updated_ms = power_status.updated_ms;
+
+	if ( !snapshot_stale && updated_ms && (HAL_GetTick() - updated_ms) < snapshot_period_ms )
+		return false;
+
+	battery_status_update();
+
+	return true;
+} // bool battery_status_poll(void)
 
 
+
+/*============================================================================*/
+/**
+  * @brief  Asks for a refresh at the next poll, may be called from an ISR
+  * @param  None
+  * @retval None
+  */
+/*============================================================================*/
+void battery_status_invalidate(void)
+{
+	snapshot_stale = true;
+} // void battery_status_invalidate(void)
+
+
+
+/*============================================================================*/
+/**
+  * @brief  Sets how often the snapshot is read when nothing changes
+  * @param  period_ms clamped to BATTERY_SNAPSHOT_PERIOD_MIN..MAX
+  * @retval None
+  */
+/*============================================================================*/
+void battery_status_period_set(uint32_t period_ms)
+{
+	if ( period_ms < BATTERY_SNAPSHOT_PERIOD_MIN )
+		period_ms = BATTERY_SNAPSHOT_PERIOD_MIN;
+	else if ( period_ms > BATTERY_SNAPSHOT_PERIOD_MAX )
+		period_ms = BATTERY_SNAPSHOT_PERIOD_MAX;
+	snapshot_period_ms = period_ms;
+} // void battery_status_period_set(uint32_t period_ms)
+
+
+
+uint32_t battery_status_period_get(void)
+{
+	return snapshot_period_ms;
+} // uint32_t battery_status_period_get(void)
+
+
+
+/*============================================================================*/
+/**
+  * @brief  Sets the charger input to the power negotiated over USB PD. The
+  *         charge current goes up with the input power, a 5V port keeps the
+  *         defaults.
+  * @param  mv contract voltage
+  * @param  ma contract current, 0 if there is no contract
+  * @retval None
+  */
+/*============================================================================*/
+void battery_input_limit_set(uint16_t mv, uint16_t ma)
+{
+	if ( !ma )
+	{
+		bq_setIINLIM(bq2589x_IINLIM[BQ2589X_IINLIM_DEFAULT_IDX]);
+		bq_setICHG(bq2589x_ICHG[BQ2589X_ICHG_DEFAULT_IDX]);
+	}
+	else
+	{
+		bq_setIINLIM((ma > BQ2589X_IINLIM_MAX) ? BQ2589X_IINLIM_MAX : ma);
+		if ( (uint32_t)mv*ma >= BATTERY_FAST_CHARGE_INPUT_MW*1000UL )
+			bq_setICHG(bq2589x_ICHG[ICHG_1536mA]);
+		else
+			bq_setICHG(bq2589x_ICHG[BQ2589X_ICHG_DEFAULT_IDX]);
+	}
+	M1_LOG_I(M1_LOGDB_TAG, "Input %umV %umA\r\n", mv, ma);
+	battery_status_invalidate();
+} // void battery_input_limit_set(uint16_t mv, uint16_t ma)
@@ -10,6 +10,11 @@
 #ifndef BATTERY_H_
 #define BATTERY_H_
 
+#include <stdint.h>
+#include <stdbool.h>
+
+#define BATTERY_SNAPSHOT_PERIOD_MIN		500		// ms
+#define BATTERY_SNAPSHOT_PERIOD_MAX		60000	// ms
 
 typedef enum
 {
@@ -33,11 +38,20 @@ typedef struct
 	uint8_t     soh_state;
 	uint16_t    flags;
 	uint16_t    status;
+
+	uint16_t	remaining_capacity;		// mAh
+	uint16_t	full_capacity;			// mAh
+	uint32_t	updated_ms;				// Tick of the last refresh, 0 if never
 } S_M1_Power_Status_t;
 
 //extern S_M1_Power_Status_t power_status;
 uint32_t battery_power_status_get(S_M1_Power_Status_t *pSystemPowerStatus);
 void battery_status_update(void);
+bool battery_status_poll(void);
+void battery_status_invalidate(void);
+void battery_status_period_set(uint32_t period_ms);
+uint32_t battery_status_period_get(void);
+void battery_input_limit_set(uint16_t mv, uint16_t ma);
 void battery_service_init(void);
 
 #endif /* BATTERY_H_ */
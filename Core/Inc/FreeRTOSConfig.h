@@ -71,10 +71,11 @@ extern uint32_t SystemCoreClock;
 #define configTICK_RATE_HZ                       ((TickType_t)1000)
 #define configMAX_PRIORITIES                     ( 56 )
 #define configMINIMAL_STACK_SIZE                 ((uint16_t)256)
-#define configTOTAL_HEAP_SIZE                    ((size_t)122880)
+#define configTOTAL_HEAP_SIZE                    ((size_t)81920) /* System tasks and queues are static, see m1_tasks.c */
 #define configSTACK_ALLOCATION_FROM_SEPARATE_HEAP 0
 #define configMAX_TASK_NAME_LEN                  ( 32 )
 #define configUSE_TRACE_FACILITY                 1
+#define configGENERATE_RUN_TIME_STATS            1
 #define configUSE_16_BIT_TICKS                   0
 #define configUSE_MUTEXES                        1
 #define configQUEUE_REGISTRY_SIZE                8
@@ -130,6 +131,7 @@ to exclude the API function. */
 #define INCLUDE_xSemaphoreGetMutexHolder     1
 #define INCLUDE_uxTaskGetStackHighWaterMark  1
 #define INCLUDE_xTaskGetCurrentTaskHandle    1
+#define INCLUDE_xTaskGetIdleTaskHandle       1
 #define INCLUDE_eTaskGetState                1
 
 /* Cortex-M specific definitions. */
@@ -179,8 +181,16 @@ header file. */
 #if defined(__ICCARM__) || defined(__CC_ARM) || defined(__GNUC__)
 void PreSleepProcessing(uint32_t ulExpectedIdleTime);
 void PostSleepProcessing(uint32_t ulExpectedIdleTime);
+void configureTimerForRunTimeStats(void);
+unsigned long getRunTimeCounterValue(void);
 #endif /* defined(__ICCARM__) || defined(__CC_ARM) || defined(__GNUC__) */
 
+/* Run time stats time base (free-running TIM4, extended to 32 bits by its
+update interrupt), used by the CLI "top" and "power" commands */
+#define RUN_TIME_STATS_CLOCK_HZ   100000U /* 10 us resolution, a 32-bit counter wraps after ~11.9 h */
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS    configureTimerForRunTimeStats
+#define portGET_RUN_TIME_COUNTER_VALUE            getRunTimeCounterValue
+
 /* The configPRE_SLEEP_PROCESSING() and configPOST_SLEEP_PROCESSING() macros
 allow the application writer to add additional code before and after the MCU is
 placed into the low power state respectively. */
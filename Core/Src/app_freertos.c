@@ -57,6 +57,7 @@ const osThreadAttr_t dummytask_attributes = {
 
 /* Private function prototypes -----------------------------------------------*/
 /* USER CODE BEGIN FunctionPrototypes */
+extern uint32_t TIM_GetCounterCLKValue(uint16_t prescaler);
 
 /* USER CODE END FunctionPrototypes */
 
@@ -111,6 +112,60 @@ void MX_FREERTOS_Init(void) {
 
 }
 
+/* USER CODE BEGIN 1 */
+/* Functions needed when configGENERATE_RUN_TIME_STATS is on */
+/* TIM2 and TIM5, the 32-bit timers, belong to IR and LF RFID: TIM4 (16-bit,
+APB1) runs free at RUN_TIME_STATS_CLOCK_HZ and its update interrupt counts the
+upper half. DWT->CYCCNT would stop while the core sleeps. */
+static volatile uint32_t run_time_high;
+
+void configureTimerForRunTimeStats(void)
+{
+  if (TIM4->CR1 & TIM_CR1_CEN)
+    return; /* Started by m1_low_power_init() */
+  __HAL_RCC_TIM4_CLK_ENABLE();
+  TIM4->CR1 = 0;
+  TIM4->PSC = TIM_GetCounterCLKValue(0) / RUN_TIME_STATS_CLOCK_HZ - 1;
+  TIM4->ARR = 0xFFFFU;
+  TIM4->EGR = TIM_EGR_UG; /* Load the prescaler now */
+  TIM4->SR = 0;
+  run_time_high = 0;
+  TIM4->DIER = TIM_DIER_UIE;
+  HAL_NVIC_SetPriority(TIM4_IRQn, configLIBRARY_LOWEST_INTERRUPT_PRIORITY, 0); /* No FreeRTOS calls */
+  HAL_NVIC_EnableIRQ(TIM4_IRQn);
+  TIM4->CR1 = TIM_CR1_CEN;
+}
+
+void TIM4_IRQHandler(void)
+{
+  if (TIM4->SR & TIM_SR_UIF)
+  {
+    TIM4->SR = ~TIM_SR_UIF;
+    run_time_high++;
+  }
+}
+
+unsigned long getRunTimeCounterValue(void)
+{
+  uint32_t primask = __get_PRIMASK();
+  uint32_t high, low;
+
+  /* Also called with the interrupt masked: a wrap it has not counted yet is
+  still pending in SR */
+  __disable_irq();
+  high = run_time_high;
+  low = TIM4->CNT;
+  if (TIM4->SR & TIM_SR_UIF)
+  {
+    high++;
+    low = TIM4->CNT;
+  }
+  __set_PRIMASK(primask);
+
+  return (high << 16) | low;
+}
+/* USER CODE END 1 */
+
 /* Private application code --------------------------------------------------*/
 /* USER CODE BEGIN Application */
 
@@ -29,14 +29,18 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "FreeRTOSConfig.h"
 #include "FreeRTOS_CLI.h"
 #include "ff.h"
-#include "m1_bq27421.h"
+#include "battery.h"
 #include "m1_cli.h"
+#include "m1_cli_script.h"
 #include "m1_esp32_hal.h"
 #include "m1_fw_update_bl.h"
 #include "m1_log_debug.h"
+#include "m1_low_power.h"
 #include "m1_system.h"
+#include "m1_tasks.h"
 #include "m1_usb_cdc_msc.h"
 #include "main.h"
+#include "stdarg.h"
 #include "stdbool.h"
 #include "stdio.h"
 #include "stdlib.h"
@@ -97,6 +101,19 @@ BaseType_t cmd_cdcstats_help(void);
 BaseType_t cmd_cdcreset(char *pcWriteBuffer, size_t xWriteBufferLen,
                         const char *pcCommandString, uint8_t num_of_params);
 BaseType_t cmd_cdcreset_help(void);
+BaseType_t cmd_top(char *pcWriteBuffer, size_t xWriteBufferLen,
+                   const char *pcCommandString, uint8_t num_of_params);
+BaseType_t cmd_top_help(void);
+BaseType_t cmd_stream(char *pcWriteBuffer, size_t xWriteBufferLen,
+                      const char *pcCommandString, uint8_t num_of_params);
+BaseType_t cmd_stream_help(void);
+BaseType_t cmd_script(char *pcWriteBuffer, size_t xWriteBufferLen,
+                      const char *pcCommandString, uint8_t num_of_params);
+BaseType_t cmd_script_help(void);
+BaseType_t cmd_power(char *pcWriteBuffer, size_t xWriteBufferLen,
+                     const char *pcCommandString, uint8_t num_of_params);
+BaseType_t cmd_power_help(void);
+static void script_run_pending(void);
 
 const CLI_Command_Definition_t xCommandList[] = {
     {.pcCommand = "cls",
@@ -135,10 +152,11 @@ const CLI_Command_Definition_t xCommandList[] = {
      .pxCommandHelper = cmd_wifi_help,
      .cExpectedNumberOfParameters = 0},
     {.pcCommand = "battery",
-     .pcHelpString = "battery:\r\n Shows battery status\r\n\r\n",
+     .pcHelpString = "battery [period <ms>]:\r\n Shows battery status, or "
+                     "sets how often the gauge is read\r\n\r\n",
      .pxCommandInterpreter = cmd_battery,
      .pxCommandHelper = cmd_battery_help,
-     .cExpectedNumberOfParameters = 0},
+     .cExpectedNumberOfParameters = -1},
     {.pcCommand = "reboot",
      .pcHelpString = "reboot:\r\n Reboots the device\r\n\r\n",
      .pxCommandInterpreter = cmd_reboot,
@@ -150,7 +168,7 @@ const CLI_Command_Definition_t xCommandList[] = {
      .pxCommandHelper = cmd_memory_help,
      .cExpectedNumberOfParameters = 0},
     {.pcCommand = "cdcstats",
-     .pcHelpString = "cdcstats:\r\n Shows USB CLI RX diagnostics\r\n\r\n",
+     .pcHelpString = "cdcstats:\r\n Shows USB CLI RX and USB-UART bridge diagnostics\r\n\r\n",
      .pxCommandInterpreter = cmd_cdcstats,
      .pxCommandHelper = cmd_cdcstats_help,
      .cExpectedNumberOfParameters = 0},
@@ -159,6 +177,31 @@ const CLI_Command_Definition_t xCommandList[] = {
      .pxCommandInterpreter = cmd_cdcreset,
      .pxCommandHelper = cmd_cdcreset_help,
      .cExpectedNumberOfParameters = 0},
+    {.pcCommand = "top",
+     .pcHelpString = "top:\r\n Shows per-task CPU, stack and heap usage\r\n\r\n",
+     .pxCommandInterpreter = cmd_top,
+     .pxCommandHelper = cmd_top_help,
+     .cExpectedNumberOfParameters = 0},
+    {.pcCommand = "power",
+     .pcHelpString = "power:\r\n Shows idle sleep, wake-up sources and battery "
+                     "current (deltas since the last `power`)\r\n\r\n",
+     .pxCommandInterpreter = cmd_power,
+     .pxCommandHelper = cmd_power_help,
+     .cExpectedNumberOfParameters = 0},
+    {.pcCommand = "stream",
+     .pcHelpString =
+         "stream <subghz|lfrfid|ir|off|stats>:\r\n Streams live edge timings "
+         "as binary packets (tools/cdc_stream_rx.py)\r\n\r\n",
+     .pxCommandInterpreter = cmd_stream,
+     .pxCommandHelper = cmd_stream_help,
+     .cExpectedNumberOfParameters = 1},
+    {.pcCommand = "script",
+     .pcHelpString =
+         "script <file> [logfile]:\r\n Runs a command script from the SD "
+         "card, Ctrl-C aborts\r\n\r\n",
+     .pxCommandInterpreter = cmd_script,
+     .pxCommandHelper = cmd_script_help,
+     .cExpectedNumberOfParameters = -1},
     {
         .pcCommand = "dfu", /* The command string to type. */
         .pcHelpString = "dfu:\r\n Reboot to USB DFU mode\r\n\r\n",
@@ -284,6 +327,9 @@ void handleNewline(const char *const pcInputString, char *cOutputBuffer,
     *cOutputBuffer = 0x00; // Clear string after use
   } while (xMoreDataToFollow != pdFALSE);
 
+  /* A script runs its commands through the CLI, which is free again now */
+  script_run_pending();
+
   cliWrite(cli_prompt);
   *cInputIndex = 0;
   memset((void *)pcInputString, 0x00, MAX_INPUT_LENGTH);
@@ -564,48 +610,45 @@ BaseType_t cmd_wifi_help(void) { return pdFALSE; }
 /*============================================================================*/
 BaseType_t cmd_battery(char *pcWriteBuffer, size_t xWriteBufferLen,
                        const char *pcCommandString, uint8_t num_of_params) {
-  (void)pcCommandString;
-  (void)num_of_params;
-
-  uint16_t voltage = 0;
-  uint16_t capacity = 0;
-  uint16_t full_capacity = 0;
-  uint8_t soc = 0;
-
-  // Read battery voltage
-  bq27421_readVoltage_mV(&voltage);
-
-  // Read State of Charge (percentage)
-  soc = (uint8_t)bq27421_soc(FILTERED);
+  S_M1_Power_Status_t status;
+  const char *param;
+  BaseType_t param_len;
 
-  // Read remaining capacity
-  bq27421_readRemainingCapacity_mAh(&capacity);
-
-  // Read full charge capacity
-  bq27421_readFullChargeCapacity_mAh(&full_capacity);
-
-  size_t offset = 0;
-  int written;
-
-  written = snprintf(pcWriteBuffer + offset, xWriteBufferLen - offset,
-                     "Battery Status:\r\n");
-  if (written > 0 && (size_t)written < xWriteBufferLen - offset)
-    offset += (size_t)written;
+  (void)num_of_params;
 
-  written = snprintf(pcWriteBuffer + offset, xWriteBufferLen - offset,
-                     "  Level: %d%%\r\n", soc);
-  if (written > 0 && (size_t)written < xWriteBufferLen - offset)
-    offset += (size_t)written;
+  param = FreeRTOS_CLIGetParameter(pcCommandString, 1, &param_len);
+  if (param != NULL) {
+    if ((param_len != 6) || strncmp(param, "period", 6) ||
+        (param = FreeRTOS_CLIGetParameter(pcCommandString, 2, &param_len)) ==
+            NULL) {
+      (void)snprintf(pcWriteBuffer, xWriteBufferLen,
+                     "Usage: battery [period <ms>]\r\n");
+      return pdFALSE;
+    }
+    battery_status_period_set(strtoul(param, NULL, 10));
+    (void)snprintf(pcWriteBuffer, xWriteBufferLen,
+                   "Battery refresh period: %lu ms\r\n",
+                   (unsigned long)battery_status_period_get());
+    return pdFALSE;
+  }
 
-  written = snprintf(pcWriteBuffer + offset, xWriteBufferLen - offset,
-                     "  Voltage: %d mV\r\n", voltage);
-  if (written > 0 && (size_t)written < xWriteBufferLen - offset)
-    offset += (size_t)written;
+  // The snapshot of the system task, the gauge is not read here
+  if (!battery_power_status_get(&status)) {
+    (void)snprintf(pcWriteBuffer, xWriteBufferLen,
+                   "Battery Status: not read yet\r\n");
+    return pdFALSE;
+  }
 
-  written = snprintf(pcWriteBuffer + offset, xWriteBufferLen - offset,
-                     "  Capacity: %d/%d mAh\r\n", capacity, full_capacity);
-  if (written > 0 && (size_t)written < xWriteBufferLen - offset)
-    offset += (size_t)written;
+  (void)snprintf(pcWriteBuffer, xWriteBufferLen,
+                 "Battery Status:\r\n"
+                 "  Level: %u%%\r\n"
+                 "  Voltage: %u mV\r\n"
+                 "  Capacity: %u/%u mAh\r\n"
+                 "  Updated: %lu ms ago (every %lu ms)\r\n",
+                 status.battery_level, (unsigned)status.battery_voltage,
+                 status.remaining_capacity, status.full_capacity,
+                 (unsigned long)(HAL_GetTick() - status.updated_ms),
+                 (unsigned long)battery_status_period_get());
 
   return pdFALSE;
 }
@@ -698,17 +741,29 @@ BaseType_t cmd_memory_help(void) { return pdFALSE; }
 
 BaseType_t cmd_cdcstats(char *pcWriteBuffer, size_t xWriteBufferLen,
                         const char *pcCommandString, uint8_t num_of_params) {
+  S_M1_UsbBridge_Stats bridge;
+
   (void)pcCommandString;
   (void)num_of_params;
 
+  m1_usb_bridge_get_stats(&bridge);
   (void)snprintf(pcWriteBuffer, xWriteBufferLen,
                  "USB CLI RX Diagnostics:\r\n"
                  "  Dropped bytes: %lu\r\n"
                  "  High watermark: %lu bytes\r\n"
-                 "  Buffered now: %lu bytes\r\n",
+                 "  Buffered now: %lu bytes\r\n"
+                 "USB-UART bridge:\r\n"
+                 "  UART RX dropped: %lu bytes\r\n"
+                 "  USB RX pauses: %lu\r\n"
+                 "  UART TX timeouts: %lu\r\n"
+                 "  UART errors: %lu\r\n",
                  (unsigned long)CDC_CLI_RxDroppedBytes(),
                  (unsigned long)CDC_CLI_RxHighWatermark(),
-                 (unsigned long)CDC_CLI_RxBufferedBytes());
+                 (unsigned long)CDC_CLI_RxBufferedBytes(),
+                 (unsigned long)bridge.uart_rx_dropped,
+                 (unsigned long)bridge.usb_rx_pauses,
+                 (unsigned long)bridge.uart_tx_timeouts,
+                 (unsigned long)bridge.uart_errors);
   return pdFALSE;
 }
 
@@ -727,4 +782,586 @@ BaseType_t cmd_cdcreset(char *pcWriteBuffer, size_t xWriteBufferLen,
 
 BaseType_t cmd_cdcreset_help(void) { return pdFALSE; }
 
+/*============================================================================*/
+/*
+ * CLI command: Switch the USB CDC port to the binary edge timing stream of a
+ * capture source, or back to text. The capture itself is started on the
+ * device as usual. The command output goes to USART1 while streaming.
+ */
+/*============================================================================*/
+BaseType_t cmd_stream(char *pcWriteBuffer, size_t xWriteBufferLen,
+                      const char *pcCommandString, uint8_t num_of_params) {
+  const char *param;
+  BaseType_t param_len;
+  S_M1_CdcStream_Source source;
+  S_M1_CdcStream_Stats stats;
+
+  (void)num_of_params;
+
+  param = FreeRTOS_CLIGetParameter(pcCommandString, 1, &param_len);
+  if (param == NULL) {
+    (void)snprintf(pcWriteBuffer, xWriteBufferLen,
+                   "Usage: stream <subghz|lfrfid|ir|off|stats>\r\n");
+    return pdFALSE;
+  }
+
+  if ((param_len == 5) && !strncmp(param, "stats", 5)) {
+    m1_cdc_stream_get_stats(&stats);
+    (void)snprintf(pcWriteBuffer, xWriteBufferLen,
+                   "Stream: %s\r\n"
+                   "  Packets: %lu\r\n"
+                   "  Samples: %lu\r\n"
+                   "  Dropped samples: %lu\r\n"
+                   "  USB busy retries: %lu\r\n",
+                   m1_cdc_stream_source_name(m1_cdc_stream_source()),
+                   (unsigned long)stats.packets, (unsigned long)stats.samples,
+                   (unsigned long)stats.dropped,
+                   (unsigned long)stats.tx_errors);
+    return pdFALSE;
+  }
+
+  for (source = CDC_STREAM_SRC_NONE; source < CDC_STREAM_SRC_EOL; source++) {
+    const char *name = m1_cdc_stream_source_name(source);
+
+    if (((size_t)param_len == strlen(name)) &&
+        !strncmp(param, name, (size_t)param_len))
+      break;
+  }
+  if (source >= CDC_STREAM_SRC_EOL) {
+    (void)snprintf(pcWriteBuffer, xWriteBufferLen,
+                   "Unknown source, use subghz, lfrfid, ir or off\r\n");
+    return pdFALSE;
+  }
+  if (m1_usbcdc_mode == CDC_MODE_VCP) {
+    (void)snprintf(pcWriteBuffer, xWriteBufferLen,
+                   "USB port is in serial bridge mode\r\n");
+    return pdFALSE;
+  }
+
+  m1_usb_cdc_stream(source);
+  (void)snprintf(pcWriteBuffer, xWriteBufferLen, "Stream: %s\r\n",
+                 m1_cdc_stream_source_name(source));
+  return pdFALSE;
+}
+
+BaseType_t cmd_stream_help(void) { return pdFALSE; }
+
+/*============================================================================*/
+/*
+ * CLI command: Show per-task CPU share, stack high-water marks and heap
+ * fragmentation. "CPU%" and the deltas cover the time since the previous
+ * "top" (since boot on the first call), "Avg%" covers the time since boot.
+ */
+/*============================================================================*/
+#define TOP_MAX_TASKS 32 /* About 20 tasks are created, static and dynamic */
+#define TOP_HEAP_BINS 6 /* <64, <256, <1K, <4K, <16K, >=16K bytes */
+
+typedef struct {
+  TaskHandle_t handle;
+  configRUN_TIME_COUNTER_TYPE run_time;
+  configSTACK_DEPTH_TYPE stack_free;
+} S_Top_Prev_t;
+
+/* Static, so the report does not show up in the heap stats it prints */
+static TaskStatus_t top_tasks[TOP_MAX_TASKS];
+static configRUN_TIME_COUNTER_TYPE top_delta[TOP_MAX_TASKS];
+static UBaseType_t top_order[TOP_MAX_TASKS];
+static S_Top_Prev_t top_prev[TOP_MAX_TASKS];
+static UBaseType_t top_prev_count = 0;
+static TickType_t top_prev_tick = 0;
+static size_t top_prev_free_heap = configTOTAL_HEAP_SIZE;
+static size_t top_prev_allocs = 0, top_prev_frees = 0;
+static char top_output_buf[3072];
+static size_t top_output_len = 0;
+static size_t top_output_pos = 0;
+
+static void top_printf(const char *fmt, ...) {
+  va_list args;
+  int written;
+
+  va_start(args, fmt);
+  written = vsnprintf(top_output_buf + top_output_len,
+                      sizeof(top_output_buf) - top_output_len, fmt, args);
+  va_end(args);
+  if (written > 0 &&
+      (size_t)written < sizeof(top_output_buf) - top_output_len)
+    top_output_len += (size_t)written;
+}
+
+static char top_state_char(eTaskState state) {
+  switch (state) {
+  case eRunning:
+    return 'X';
+  case eReady:
+    return 'R';
+  case eBlocked:
+    return 'B';
+  case eSuspended:
+    return 'S';
+  default:
+    return 'D';
+  }
+}
+
+static const S_Top_Prev_t *top_find_prev(TaskHandle_t handle) {
+  UBaseType_t i;
+
+  for (i = 0; i < top_prev_count; i++) {
+    if (top_prev[i].handle == handle)
+      return &top_prev[i];
+  }
+  return NULL;
+}
+
+/* Tenths of a percent, e.g. 123 for 12.3% */
+static unsigned top_permille(uint64_t part, uint64_t total) {
+  return total ? (unsigned)((part * 1000U) / total) : 0U;
+}
+
+static void top_build_report(void) {
+  UBaseType_t num_tasks, i, j;
+  uint64_t total_delta = 0, total_run = 0;
+  configRUN_TIME_COUNTER_TYPE idle_delta = 0;
+  TickType_t now = xTaskGetTickCount();
+  HeapStats_t heap;
+  size_t bins[TOP_HEAP_BINS];
+  unsigned pm;
+
+  top_output_len = 0;
+
+  vPortGetHeapStats(&heap);
+  vPortGetHeapFreeBlockHistogram(bins, TOP_HEAP_BINS);
+
+  /* 0 only if there are more tasks than TOP_MAX_TASKS */
+  num_tasks = uxTaskGetSystemState(top_tasks, TOP_MAX_TASKS, NULL);
+  if (num_tasks == 0) {
+    top_printf("Task list changed, try again\r\n");
+    return;
+  }
+
+  for (i = 0; i < num_tasks; i++) {
+    const S_Top_Prev_t *prev = top_find_prev(top_tasks[i].xHandle);
+
+    top_delta[i] = top_tasks[i].ulRunTimeCounter -
+                   (prev ? prev->run_time : 0); /* Wraps correctly */
+    total_delta += top_delta[i];
+    total_run += top_tasks[i].ulRunTimeCounter;
+    if (top_tasks[i].xHandle == xTaskGetIdleTaskHandle())
+      idle_delta = top_delta[i];
+
+    /* Insertion sort, busiest task of this interval first */
+    for (j = i; j > 0 && top_delta[top_order[j - 1]] < top_delta[i]; j--)
+      top_order[j] = top_order[j - 1];
+    top_order[j] = i;
+  }
+
+  pm = 1000U - top_permille(idle_delta, total_delta);
+  top_printf("Interval: %lu ms  Tasks: %lu  CPU busy: %u.%u%%\r\n",
+             (unsigned long)((now - top_prev_tick) * portTICK_PERIOD_MS),
+             (unsigned long)num_tasks, pm / 10U, pm % 10U);
+  top_printf("Task             S Pri  CPU%%  Avg%% StkFree  Size dFree\r\n");
+
+  for (i = 0; i < num_tasks; i++) {
+    const TaskStatus_t *t = &top_tasks[top_order[i]];
+    const S_Top_Prev_t *prev = top_find_prev(t->xHandle);
+    uint32_t depth = m1_task_stack_depth(t->xHandle);
+    unsigned cpu = top_permille(top_delta[top_order[i]], total_delta);
+    unsigned avg = top_permille(t->ulRunTimeCounter, total_run);
+    char size_str[8] = "-";
+    char dfree_str[8] = "";
+
+    if (depth)
+      snprintf(size_str, sizeof(size_str), "%lu", (unsigned long)depth);
+    if (prev && prev->stack_free != t->usStackHighWaterMark)
+      snprintf(dfree_str, sizeof(dfree_str), "%+ld",
+               (long)t->usStackHighWaterMark - (long)prev->stack_free);
+
+    top_printf("%-16.16s %c %3lu %3u.%u %3u.%u %7lu %5s %5s\r\n",
+               t->pcTaskName, top_state_char(t->eCurrentState),
+               (unsigned long)t->uxCurrentPriority, cpu / 10U, cpu % 10U,
+               avg / 10U, avg % 10U, (unsigned long)t->usStackHighWaterMark,
+               size_str, dfree_str);
+  }
+  top_printf("(stack in 32-bit words)\r\n");
+
+  top_printf("Heap: %lu free, %lu min ever, %lu largest, %lu blocks\r\n",
+             (unsigned long)heap.xAvailableHeapSpaceInBytes,
+             (unsigned long)heap.xMinimumEverFreeBytesRemaining,
+             (unsigned long)heap.xSizeOfLargestFreeBlockInBytes,
+             (unsigned long)heap.xNumberOfFreeBlocks);
+  top_printf("  Interval: %+ld bytes, %lu allocs, %lu frees\r\n",
+             (long)heap.xAvailableHeapSpaceInBytes - (long)top_prev_free_heap,
+             (unsigned long)(heap.xNumberOfSuccessfulAllocations -
+                             top_prev_allocs),
+             (unsigned long)(heap.xNumberOfSuccessfulFrees - top_prev_frees));
+  top_printf("  Free blocks: <64:%lu <256:%lu <1K:%lu <4K:%lu <16K:%lu "
+             ">=16K:%lu\r\n",
+             (unsigned long)bins[0], (unsigned long)bins[1],
+             (unsigned long)bins[2], (unsigned long)bins[3],
+             (unsigned long)bins[4], (unsigned long)bins[5]);
+
+  /* Remember this snapshot for the next interval */
+  for (i = 0; i < num_tasks; i++) {
+    top_prev[i].handle = top_tasks[i].xHandle;
+    top_prev[i].run_time = top_tasks[i].ulRunTimeCounter;
+    top_prev[i].stack_free = top_tasks[i].usStackHighWaterMark;
+  }
+  top_prev_count = num_tasks;
+  top_prev_tick = now;
+  top_prev_free_heap = heap.xAvailableHeapSpaceInBytes;
+  top_prev_allocs = heap.xNumberOfSuccessfulAllocations;
+  top_prev_frees = heap.xNumberOfSuccessfulFrees;
+}
+
+BaseType_t cmd_top(char *pcWriteBuffer, size_t xWriteBufferLen,
+                   const char *pcCommandString, uint8_t num_of_params) {
+  (void)pcCommandString;
+  (void)num_of_params;
+
+  /* On first call, take the snapshot */
+  if (top_output_pos == 0)
+    top_build_report();
+
+  /* Output in chunks */
+  size_t remaining = top_output_len - top_output_pos;
+  size_t chunk =
+      (remaining < (xWriteBufferLen - 1)) ? remaining : (xWriteBufferLen - 1);
+  memcpy(pcWriteBuffer, top_output_buf + top_output_pos, chunk);
+  pcWriteBuffer[chunk] = '\0';
+  top_output_pos += chunk;
+
+  if (top_output_pos >= top_output_len) {
+    /* Done — reset for next invocation */
+    top_output_pos = 0;
+    return pdFALSE;
+  }
+  return pdTRUE; /* More data to follow */
+}
+
+BaseType_t cmd_top_help(void) { return pdFALSE; }
+
+/*============================================================================*/
+/*
+ * CLI command: Idle sleep and power profile
+ *
+ * Like top, the report is built once and written out in chunks. Rates are
+ * over the interval since the previous `power`.
+ */
+/*============================================================================*/
+static S_M1_PwrProf_Snapshot power_snap;
+static S_M1_PwrProf_Snapshot power_prev;
+static char power_output_buf[1024];
+static size_t power_output_len = 0;
+static size_t power_output_pos = 0;
+
+static void power_printf(const char *fmt, ...) {
+  va_list args;
+  int written;
+
+  va_start(args, fmt);
+  written = vsnprintf(power_output_buf + power_output_len,
+                      sizeof(power_output_buf) - power_output_len, fmt, args);
+  va_end(args);
+  if (written > 0 &&
+      (size_t)written < sizeof(power_output_buf) - power_output_len)
+    power_output_len += (size_t)written;
+}
+
+static unsigned power_permille(uint64_t part, uint64_t total) {
+  return total ? (unsigned)((part * 1000U) / total) : 0U;
+}
+
+static void power_build_report(void) {
+  const S_M1_PwrProf_Source *src;
+  const char *name;
+  uint64_t interval, interval_ms;
+  unsigned sleep_all, sleep_int;
+  uint32_t delta, rate_x10;
+  uint8_t i;
+
+  power_output_len = 0;
+  m1_low_power_get_profile(&power_snap);
+  interval = power_snap.total_time - power_prev.total_time;
+  interval_ms = power_snap.time_base_hz
+                    ? (interval * 1000U) / power_snap.time_base_hz
+                    : 0U;
+  sleep_all = power_permille(power_snap.sleep_time, power_snap.total_time);
+  sleep_int = power_permille(power_snap.sleep_time - power_prev.sleep_time,
+                             interval);
+
+  power_printf("Power profile (interval %lu ms):\r\n",
+               (unsigned long)interval_ms);
+  power_printf("  Asleep: %u.%u%% since boot, %u.%u%% interval\r\n",
+               sleep_all / 10U, sleep_all % 10U, sleep_int / 10U,
+               sleep_int % 10U);
+  power_printf("  Sleeps: %lu, aborted %lu\r\n",
+               (unsigned long)(power_snap.sleeps - power_prev.sleeps),
+               (unsigned long)(power_snap.aborts - power_prev.aborts));
+  power_printf("  Idle windows: <10ms %lu, <100ms %lu, <1s %lu, >=1s %lu\r\n",
+               (unsigned long)(power_snap.idle_windows[0] -
+                               power_prev.idle_windows[0]),
+               (unsigned long)(power_snap.idle_windows[1] -
+                               power_prev.idle_windows[1]),
+               (unsigned long)(power_snap.idle_windows[2] -
+                               power_prev.idle_windows[2]),
+               (unsigned long)(power_snap.idle_windows[3] -
+                               power_prev.idle_windows[3]));
+
+  power_printf("  Wake-ups/s:\r\n");
+  for (i = 0; i < power_snap.n_sources; i++) {
+    src = &power_snap.sources[i];
+    delta = m1_power_profile_source_delta(&power_prev, src);
+    if (delta == 0)
+      continue;
+    rate_x10 = interval_ms ? (uint32_t)(((uint64_t)delta * 10000U) /
+                                        interval_ms)
+                           : 0U;
+    name = m1_low_power_irq_name(src->irqn);
+    if (src->irqn == PWR_PROF_WAKE_UNKNOWN)
+      power_printf("    %-16s", "unknown");
+    else if (name != NULL)
+      power_printf("    %-16s", name);
+    else
+      power_printf("    IRQ %-12d", src->irqn);
+    power_printf(" %6lu.%lu\r\n", (unsigned long)(rate_x10 / 10U),
+                 (unsigned long)(rate_x10 % 10U));
+  }
+  if (power_snap.wake_other != power_prev.wake_other)
+    power_printf("    %-16s %lu wake-ups\r\n", "other",
+                 (unsigned long)(power_snap.wake_other -
+                                 power_prev.wake_other));
+
+  if (power_snap.current_samples == 0) {
+    power_printf("  Current: no discharge readings yet\r\n");
+  } else {
+    power_printf("  Current: %d mA at %u.%u%% asleep (%lu readings)\r\n",
+                 power_snap.last_current_mA,
+                 power_snap.last_sleep_permille / 10U,
+                 power_snap.last_sleep_permille % 10U,
+                 (unsigned long)power_snap.current_samples);
+    if (power_snap.model_valid)
+      power_printf("  Estimate: %ld mA awake, %ld mA asleep\r\n",
+                   (long)power_snap.awake_mA, (long)power_snap.sleep_mA);
+    else
+      power_printf("  Estimate: needs readings at different sleep shares\r\n");
+  }
+
+  power_prev = power_snap;
+}
+
+BaseType_t cmd_power(char *pcWriteBuffer, size_t xWriteBufferLen,
+                     const char *pcCommandString, uint8_t num_of_params) {
+  (void)pcCommandString;
+  (void)num_of_params;
+
+  if (power_output_pos == 0)
+    power_build_report();
+
+  size_t remaining = power_output_len - power_output_pos;
+  size_t chunk =
+      (remaining < (xWriteBufferLen - 1)) ? remaining : (xWriteBufferLen - 1);
+  memcpy(pcWriteBuffer, power_output_buf + power_output_pos, chunk);
+  pcWriteBuffer[chunk] = '\0';
+  power_output_pos += chunk;
+
+  if (power_output_pos >= power_output_len) {
+    power_output_pos = 0;
+    return pdFALSE;
+  }
+  return pdTRUE;
+}
+
+BaseType_t cmd_power_help(void) { return pdFALSE; }
+
+/*============================================================================*/
+/*
+ * CLI command: Run a command script from the SD card
+ *
+ * The command only stores the file names. FreeRTOS_CLIProcessCommand() is not
+ * re-entrant, the script runs from handleNewline() once this command has
+ * returned. Output of the script commands goes to the console and, when a
+ * log file is given, is appended to it.
+ */
+/*============================================================================*/
+#define SCRIPT_PATH_SIZE MAX_INPUT_LENGTH
+#define SCRIPT_ABORT_CHAR 0x03 /* Ctrl-C */
+
+static char script_path[SCRIPT_PATH_SIZE];
+static char script_log_path[SCRIPT_PATH_SIZE];
+static bool script_pending = false;
+static bool script_running = false;
+static char script_text[CLI_SCRIPT_MAX_SIZE + 1]; // The interpreter ends the last line after the text
+static FIL script_file;
+static FIL script_log;
+static bool script_log_open = false;
+
+static bool script_copy_param(const char *pcCommandString, UBaseType_t index,
+                              char *dst) {
+  const char *param;
+  BaseType_t param_len;
+
+  param = FreeRTOS_CLIGetParameter(pcCommandString, index, &param_len);
+  if (param == NULL || param_len >= SCRIPT_PATH_SIZE)
+    return false;
+  memcpy(dst, param, (size_t)param_len);
+  dst[param_len] = '\0';
+  return true;
+}
+
+BaseType_t cmd_script(char *pcWriteBuffer, size_t xWriteBufferLen,
+                      const char *pcCommandString, uint8_t num_of_params) {
+  BaseType_t param_len;
+
+  (void)num_of_params;
+
+  if (script_running) {
+    (void)snprintf(pcWriteBuffer, xWriteBufferLen,
+                   "script: scripts cannot run other scripts\r\n");
+    return pdFALSE;
+  }
+  if (!script_copy_param(pcCommandString, 1, script_path)) {
+    (void)snprintf(pcWriteBuffer, xWriteBufferLen,
+                   "Usage: script <file> [logfile]\r\n");
+    return pdFALSE;
+  }
+  script_log_path[0] = '\0';
+  if (FreeRTOS_CLIGetParameter(pcCommandString, 2, &param_len) != NULL &&
+      !script_copy_param(pcCommandString, 2, script_log_path)) {
+    (void)snprintf(pcWriteBuffer, xWriteBufferLen,
+                   "script: log file name too long\r\n");
+    return pdFALSE;
+  }
+  script_pending = true;
+  pcWriteBuffer[0] = '\0';
+  return pdFALSE;
+}
+
+BaseType_t cmd_script_help(void) { return pdFALSE; }
+
+/* Runs one CLI command and collects all of its output chunks */
+static void script_exec(const char *cmd, char *out, size_t out_size) {
+  BaseType_t xMoreDataToFollow;
+  size_t len = 0, n;
+
+  do {
+    xMoreDataToFollow = FreeRTOS_CLIProcessCommand(
+        cmd, cOutputBuffer, configCOMMAND_INT_MAX_OUTPUT_SIZE);
+    n = strlen(cOutputBuffer);
+    if (n > out_size - 1 - len)
+      n = out_size - 1 - len;
+    memcpy(out + len, cOutputBuffer, n);
+    len += n;
+    *cOutputBuffer = 0x00;
+  } while (xMoreDataToFollow != pdFALSE);
+  out[len] = '\0';
+}
+
+static void script_output(const char *text) {
+  UINT written;
+
+  cliWrite(text);
+  if (script_log_open)
+    (void)f_write(&script_log, text, strlen(text), &written);
+}
+
+/*
+ * Waits for ms, or only polls with ms 0. Console input is discarded while a
+ * script runs, Ctrl-C aborts it.
+ */
+static bool script_sleep(uint32_t ms) {
+  TickType_t start = xTaskGetTickCount();
+  TickType_t wait = pdMS_TO_TICKS(ms);
+  TickType_t elapsed;
+  uint32_t receivedValue;
+  uint8_t rx_byte;
+
+  for (;;) {
+    elapsed = xTaskGetTickCount() - start;
+    if (xTaskNotifyWait(pdFALSE, 0xFFFFFFFF, &receivedValue,
+                        (elapsed < wait) ? (wait - elapsed) : 0) == pdTRUE) {
+      if (((receivedValue >> 8) & 0xFF) == TASK_NOTIFY_USBCDC &&
+          h_usb_cli_rx_streambuf != NULL) {
+        while (xStreamBufferReceive(h_usb_cli_rx_streambuf, &rx_byte, 1, 0) ==
+               1) {
+          if (rx_byte == SCRIPT_ABORT_CHAR)
+            return true;
+        }
+      } else if ((receivedValue & 0xFF) == SCRIPT_ABORT_CHAR) {
+        return true;
+      }
+      continue;
+    }
+    if (elapsed >= wait)
+      return false;
+  }
+}
+
+static void script_run_pending(void) {
+  static const S_M1_CliScript_Ops ops = {.exec = script_exec,
+                                         .output = script_output,
+                                         .sleep = script_sleep,
+                                         .tick = HAL_GetTick};
+  S_M1_CliScript_Result result;
+  FRESULT fres;
+  UINT len = 0;
+  char msg[SCRIPT_PATH_SIZE + 48];
+
+  if (!script_pending)
+    return;
+  script_pending = false;
+
+  fres = f_open(&script_file, script_path, FA_READ);
+  if (fres != FR_OK) {
+    snprintf(msg, sizeof(msg), "script: cannot open %s (err %d)\r\n",
+             script_path, (int)fres);
+    cliWrite(msg);
+    return;
+  }
+  if (f_size(&script_file) > CLI_SCRIPT_MAX_SIZE) {
+    (void)f_close(&script_file);
+    snprintf(msg, sizeof(msg), "script: %s is larger than %u bytes\r\n",
+             script_path, (unsigned)CLI_SCRIPT_MAX_SIZE);
+    cliWrite(msg);
+    return;
+  }
+  fres = f_read(&script_file, script_text, CLI_SCRIPT_MAX_SIZE, &len);
+  (void)f_close(&script_file);
+  if (fres != FR_OK) {
+    snprintf(msg, sizeof(msg), "script: read error %d\r\n", (int)fres);
+    cliWrite(msg);
+    return;
+  }
+
+  if (script_log_path[0]) {
+    fres = f_open(&script_log, script_log_path, FA_WRITE | FA_OPEN_APPEND);
+    if (fres != FR_OK) {
+      snprintf(msg, sizeof(msg), "script: cannot open log %s (err %d)\r\n",
+               script_log_path, (int)fres);
+      cliWrite(msg);
+      return;
+    }
+    script_log_open = true;
+  }
+
+  snprintf(msg, sizeof(msg), "# script %s at tick %lu\r\n", script_path,
+           (unsigned long)HAL_GetTick());
+  script_output(msg);
+
+  script_running = true;
+  m1_cli_script_run(script_text, len, &ops, &result);
+  script_running = false;
+
+  snprintf(msg, sizeof(msg), "# %s at line %u: %lu commands, %lu passed, "
+           "%lu failed\r\n",
+           m1_cli_script_status_text(result.status), result.line,
+           (unsigned long)result.commands, (unsigned long)result.passed,
+           (unsigned long)result.failed);
+  script_output(msg);
+
+  if (script_log_open) {
+    (void)f_close(&script_log);
+    script_log_open = false;
+  }
+}
+
 #endif /* CLI_COMMANDS_H */
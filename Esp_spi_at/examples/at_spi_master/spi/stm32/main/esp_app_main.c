@@ -207,14 +207,9 @@ static void spi_trans_control_task(void* arg)
     spi_master_msg_t trans_msg = {0};
     uint32_t send_len = 0;
     esp_queue_elem_t *elem = NULL;
-    char *app_resp = NULL;
 
-    uint8_t *trans_data = (uint8_t*)malloc(SPI_TRANS_MAX_LEN * sizeof(uint8_t));
-    if (trans_data == NULL)
-    {
-        M1_LOG_E(TAG, "malloc fail\r\n");
-        return;
-    }
+    /* One spare byte for the terminator of a full length response */
+    static uint8_t trans_data[SPI_TRANS_MAX_LEN + 1];
 
     while (1)
     {
@@ -288,32 +283,25 @@ static void spi_trans_control_task(void* arg)
             printf("%s", trans_data);
             fflush(stdout);    //Force to print even if have not '\n'
 #endif // #ifdef M1_APP_ESP_RESPONSE_PRINT_ENABLE
-    		/* Allocate app struct for response */
-    		app_resp = (uint8_t *)malloc(recv_opt.transmit_len + 1);
-    		if (!app_resp)
-    		{
-    			M1_LOG_E(TAG, "Failed to allocate app_resp %d\r\n", recv_opt.transmit_len + 1);
-    			return;
-    		}
-    		strcpy(app_resp, trans_data);
-
     		xSemaphoreGive(esp_ctrl_req_sem);
 
-    		elem = (esp_queue_elem_t*)malloc(sizeof(esp_queue_elem_t));
+    		/* Allocate app struct for response */
+    		elem = esp_queue_elem_alloc(recv_opt.transmit_len);
 			if (!elem)
 			{
-				M1_LOG_E(TAG, "%s %u: Malloc failed\n",__func__,__LINE__);
-				return;
+				// The app is not reading, drop the response but keep the link alive
+				M1_LOG_E(TAG, "%s %u: response dropped, no memory\r\n",__func__,__LINE__);
+				spi_mutex_unlock();
+				continue;
 			}
-			elem->buf = app_resp;
-			elem->buf_len = recv_opt.transmit_len;
+			strcpy(elem->buf, (char *)trans_data);
 			elem->uid = current_uid;
 			if ( esp_queue_put(ctrl_msg_Q, (void*)elem) )
 			{
 				M1_LOG_E(TAG, "%s %u: ctrl Q put fail\r\n",__func__,__LINE__);
-				if (elem)
-					free(elem);
-				return;
+				esp_queue_elem_free(elem);
+				spi_mutex_unlock();
+				continue;
 			} // if ( esp_queue_put(ctrl_msg_Q, (void*)elem) )
 
 			xSemaphoreGive(esp_resp_read_sem);
@@ -328,7 +316,6 @@ static void spi_trans_control_task(void* arg)
         spi_mutex_unlock();
     } // while (1)
 
-    free(trans_data);
     vTaskDelete(NULL);
 }
 
@@ -402,7 +389,8 @@ static uint8_t *spi_AT_app_get_response(int *read_len, uint32_t *uid, int timeou
 		*read_len = elem->buf_len;
 		*uid = elem->uid;
 		buf = elem->buf;
-		free(elem);
+		elem->buf = NULL; // The caller owns the buffer now, see esp_free_mem()
+		esp_queue_elem_free(elem);
 		if ( esp_queue_check(ctrl_msg_Q) ) // There's still data in the queue?
 			xSemaphoreGive(esp_resp_read_sem); // Give the app the chance to read again
 		return buf;
@@ -543,12 +531,73 @@ static void esp_free_mem( char **buf_ptr)
 {
 	if ( *buf_ptr != NULL )
 	{
-		free (*buf_ptr);
+		esp_queue_buf_free(*buf_ptr); // Pooled response or heap string
 		*buf_ptr = NULL;
 	}
 } // static void esp_free_mem( char **buf_ptr)
 
 
+
+/*============================================================================*/
+/*
+ * This function sends one AT command line, CR LF included, without waiting for
+ * its response. The caller reads the response with esp_at_read_response().
+ */
+/*============================================================================*/
+uint8_t esp_at_send_line(const char *at_line)
+{
+	ctrl_cmd_t app_req = CTRL_CMD_DEFAULT_REQ();
+
+	if ( !esp32_main_init_done || !at_line )
+		return CTRL_ERR_INCORRECT_ARG;
+
+	app_req.at_cmd = (char *)at_line; // Copied into the SPI ring buffer
+	app_req.cmd_len = strlen(at_line);
+
+	return spi_AT_app_send_command(&app_req);
+} // uint8_t esp_at_send_line(const char *at_line)
+
+
+
+/*============================================================================*/
+/*
+ * This function copies the next response block of the ESP32 into dst, NUL
+ * terminated. A block may hold several lines. It returns the length copied,
+ * 0 if nothing came within timeout_ms. Unlike the blocking requests above, it
+ * is polled and does not log the timeouts.
+ */
+/*============================================================================*/
+int esp_at_read_response(char *dst, int size, uint32_t timeout_ms)
+{
+	esp_queue_elem_t *elem;
+	int len;
+
+	if ( !esp32_main_init_done || !dst || size <= 0 )
+		return 0;
+
+	if ( xSemaphoreTake(esp_resp_read_sem, pdMS_TO_TICKS(timeout_ms))!=pdPASS )
+	{
+		xSemaphoreGive(esp_ctrl_req_sem); // The ESP32 is quiet, let the next command go out
+		return 0;
+	}
+
+	elem = (esp_queue_elem_t *)esp_queue_get(ctrl_msg_Q);
+	if ( !elem )
+		return 0;
+
+	len = strlen(elem->buf);
+	if ( len >= size )
+		len = size - 1;
+	memcpy(dst, elem->buf, len);
+	dst[len] = '\0';
+	esp_queue_elem_free(elem);
+	if ( esp_queue_check(ctrl_msg_Q) ) // There's still data in the queue?
+		xSemaphoreGive(esp_resp_read_sem);
+
+	return len;
+} // int esp_at_read_response(char *dst, int size, uint32_t timeout_ms)
+
+
 uint8_t wifi_ap_scan_list(ctrl_cmd_t *app_req)
 {
 	char *rx_buf = NULL;
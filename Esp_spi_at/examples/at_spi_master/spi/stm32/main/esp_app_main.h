@@ -26,5 +26,7 @@ uint8_t wifi_disconnect_ap(ctrl_cmd_t *app_req);
 uint8_t ble_scan_list(ctrl_cmd_t *app_req);
 uint8_t ble_advertise(ctrl_cmd_t *app_req);
 uint8_t esp_dev_reset(ctrl_cmd_t *app_req);
+uint8_t esp_at_send_line(const char *at_line);
+int esp_at_read_response(char *dst, int size, uint32_t timeout_ms);
 
 #endif /* ESP_APP_MAIN_H_ */
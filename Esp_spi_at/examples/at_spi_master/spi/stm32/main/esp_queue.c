@@ -9,11 +9,30 @@
 #include <stdlib.h>
 #include <stdbool.h>
 #include "esp_queue.h"
+#include "m1_mem_pool.h"
+
+M1_MEM_POOL_STORAGE(node_pool_storage, sizeof(q_node_t), ESP_QUEUE_DEPTH_MAX);
+M1_MEM_POOL_STORAGE(elem_pool_storage, sizeof(esp_queue_elem_t), ESP_QUEUE_DEPTH_MAX);
+M1_MEM_POOL_STORAGE(resp_pool_storage, ESP_QUEUE_RESP_BLOCK_SIZE, ESP_QUEUE_RESP_BLOCKS);
+static S_M1_MemPool node_pool, elem_pool, resp_pool;
+static bool pools_ready = false;
+static esp_queue_t app_queue;
+
+static void esp_queue_pools_init(void)
+{
+	if (pools_ready)
+		return;
+
+	m1_mem_pool_init(&node_pool, node_pool_storage, sizeof(q_node_t), ESP_QUEUE_DEPTH_MAX);
+	m1_mem_pool_init(&elem_pool, elem_pool_storage, sizeof(esp_queue_elem_t), ESP_QUEUE_DEPTH_MAX);
+	m1_mem_pool_init(&resp_pool, resp_pool_storage, ESP_QUEUE_RESP_BLOCK_SIZE, ESP_QUEUE_RESP_BLOCKS);
+	pools_ready = true;
+}
 
 /* create new node */
 static q_node_t * new_q_node(void *data)
 {
-	q_node_t* new_node = (q_node_t*)malloc(sizeof(q_node_t));
+	q_node_t* new_node = (q_node_t*)m1_mem_pool_alloc(&node_pool);
 	if (!new_node)
 		return NULL;
 	new_node->data = data;
@@ -24,9 +43,9 @@ static q_node_t * new_q_node(void *data)
 /* Create app queue */
 esp_queue_t* create_esp_queue(void)
 {
-	esp_queue_t* q = (esp_queue_t*)malloc(sizeof(esp_queue_t));
-	if (!q)
-		return NULL;
+	esp_queue_t* q = &app_queue; /* The app uses a single queue */
+
+	esp_queue_pools_init();
 
 	q->front = q->rear = NULL;
 	return q;
@@ -44,7 +63,7 @@ int esp_queue_put(esp_queue_t* q, void *data)
 
 	new_node = new_q_node(data);
 	if (!new_node) {
-		printf("malloc failed in qpp_q_put\n");
+		printf("node pool empty in esp_queue_put\n");
 		return ESP_QUEUE_ERR_MEMORY;
 	}
 
@@ -78,7 +97,7 @@ void *esp_queue_get(esp_queue_t* q)
 
 	data = temp->data;
 
-	free(temp);
+	m1_mem_pool_free(&node_pool, temp);
 	temp = NULL;
 
 	/* If front is NULL, change rear also as NULL */
@@ -99,11 +118,8 @@ void esp_queue_reset(esp_queue_t *q)
 	{
 		temp = q->front;
 		q->front = q->front->next;
-		if (temp->data)
-		{
-			free(temp->data);
-		}
-		free(temp);
+		esp_queue_elem_free((esp_queue_elem_t *)temp->data);
+		m1_mem_pool_free(&node_pool, temp);
 	}
 	q->front = q->rear = NULL;
 } // void esp_queue_reset(esp_queue_t *q)
@@ -130,15 +146,51 @@ void esp_queue_destroy(esp_queue_t** q)
 		temp = (*q)->front;
 		(*q)->front = (*q)->front->next;
 
-		if (temp->data) {
-			free(temp->data);
-			temp->data = NULL;
-		}
-
-		free(temp);
+		esp_queue_elem_free((esp_queue_elem_t *)temp->data);
+		m1_mem_pool_free(&node_pool, temp);
 		temp = NULL;
 	}
 
-	free(*q);
 	*q = NULL;
 }
+
+/* Allocate an element and its response buffer (buf_len bytes + terminator) */
+esp_queue_elem_t *esp_queue_elem_alloc(int buf_len)
+{
+	esp_queue_elem_t *elem;
+
+	elem = (esp_queue_elem_t *)m1_mem_pool_alloc(&elem_pool);
+	if (!elem)
+		return NULL;
+
+	elem->buf = NULL;
+	if (buf_len < ESP_QUEUE_RESP_BLOCK_SIZE)
+		elem->buf = m1_mem_pool_alloc(&resp_pool);
+	if (!elem->buf)
+		elem->buf = malloc(buf_len + 1);
+	if (!elem->buf) {
+		m1_mem_pool_free(&elem_pool, elem);
+		return NULL;
+	}
+	elem->buf_len = buf_len;
+	return elem;
+}
+
+/* Free an element and the response buffer it still owns */
+void esp_queue_elem_free(esp_queue_elem_t *elem)
+{
+	if (!elem)
+		return;
+
+	esp_queue_buf_free(elem->buf);
+	m1_mem_pool_free(&elem_pool, elem);
+}
+
+/* Free a response buffer taken out of an element, from the pool or the heap */
+void esp_queue_buf_free(void *buf)
+{
+	if (m1_mem_pool_owns(&resp_pool, buf))
+		m1_mem_pool_free(&resp_pool, buf);
+	else
+		free(buf);
+}
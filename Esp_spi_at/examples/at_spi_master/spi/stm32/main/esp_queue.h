@@ -12,6 +12,12 @@
 #define ESP_QUEUE_ERR_UNINITALISED      -1
 #define ESP_QUEUE_ERR_MEMORY            -2
 
+/* Queue nodes, elements and short response buffers come from fixed pools.
+ * Longer responses fall back to the heap. */
+#define ESP_QUEUE_DEPTH_MAX             32
+#define ESP_QUEUE_RESP_BLOCK_SIZE       256
+#define ESP_QUEUE_RESP_BLOCKS           16
+
 #include <stdint.h>
 #include <stdbool.h>
 
@@ -37,5 +43,8 @@ int esp_queue_put(esp_queue_t* q, void *data);
 void esp_queue_reset(esp_queue_t *q);
 bool esp_queue_check(esp_queue_t* q);
 void esp_queue_destroy(esp_queue_t** q);
+esp_queue_elem_t *esp_queue_elem_alloc(int buf_len);
+void esp_queue_elem_free(esp_queue_elem_t *elem);
+void esp_queue_buf_free(void *buf);
 
 #endif /*__ESP_QUEUE_H__*/
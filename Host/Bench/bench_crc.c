@@ -0,0 +1,46 @@
+/* See COPYING.txt for license details. */
+
+/*
+*
+* bench_crc.c
+*
+* Throughput of the bit_util.c checksums on radio frame and file sized
+* buffers. Frames run the bitwise loops, the 4 KB buffers the slice-by-4
+* tables (the host has no CRC peripheral).
+*
+* M1 Project
+*
+*/
+
+#include <stdlib.h>
+#include "bit_util.h"
+#include "m1_host_bench.h"
+
+#define FRAME_BYTES		16
+#define BLOCK_BYTES		4096
+
+static uint8_t frame[FRAME_BYTES];
+static uint8_t block[BLOCK_BYTES];
+
+int main(int argc, char *argv[])
+{
+	uint32_t i;
+
+	bench_init(argc, argv);
+	for ( i = 0; i < sizeof(block); i++ )
+		block[i] = (uint8_t)rand();
+	memcpy(frame, block, sizeof(frame));
+
+	BENCH("crc8 frame", 1000000, FRAME_BYTES, bench_sink += crc8(frame, FRAME_BYTES, 0x07, 0x00));
+	BENCH("crc8le frame", 1000000, FRAME_BYTES, bench_sink += crc8le(frame, FRAME_BYTES, 0x07, 0xFF));
+	BENCH("crc16 frame", 1000000, FRAME_BYTES, bench_sink += crc16(frame, FRAME_BYTES, 0x1021, 0xFFFF));
+	BENCH("crc16lsb frame", 1000000, FRAME_BYTES, bench_sink += crc16lsb(frame, FRAME_BYTES, 0x8408, 0x0000));
+	BENCH("crc8 4 KB", 10000, BLOCK_BYTES, bench_sink += crc8(block, BLOCK_BYTES, 0x07, 0x00));
+	BENCH("crc16 4 KB", 10000, BLOCK_BYTES, bench_sink += crc16(block, BLOCK_BYTES, 0x1021, 0xFFFF));
+	BENCH("crc16lsb 4 KB", 10000, BLOCK_BYTES, bench_sink += crc16lsb(block, BLOCK_BYTES, 0x8408, 0x0000));
+	BENCH("crc32lsb 4 KB", 10000, BLOCK_BYTES, bench_sink += crc32lsb(block, BLOCK_BYTES, 0xEDB88320, 0xFFFFFFFF));
+	BENCH("lfsr_digest16 frame", 1000000, FRAME_BYTES, bench_sink += lfsr_digest16(frame, FRAME_BYTES, 0x8810, 0x1234));
+	BENCH("parity_bytes 4 KB", 10000, BLOCK_BYTES, bench_sink += parity_bytes(block, BLOCK_BYTES));
+
+	return 0;
+}
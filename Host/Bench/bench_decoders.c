@@ -0,0 +1,114 @@
+/* See COPYING.txt for license details. */
+
+/*
+*
+* bench_decoders.c
+*
+* Cost per packet of the Sub-GHz Princeton and LF RFID EM4100 decoders,
+* fed with synthesised capture timings
+*
+* M1 Project
+*
+*/
+
+#include "main.h"
+#include "m1_sub_ghz_decenc.h"
+#include "lfrfid.h"
+#include "m1_host_bench.h"
+
+#define PRINCETON_BITS		24
+#define PRINCETON_PULSES	(PRINCETON_BITS*2 + 1)
+#define EM4100_EDGES_MAX	(FRAME_BITS*2*2)
+#define EM4100_CHUNK		20
+
+static uint16_t princeton_pulses[PRINCETON_PULSES];
+static lfrfid_evt_t em4100_edges[EM4100_EDGES_MAX];
+static uint16_t em4100_edge_count;
+
+static void make_princeton(uint32_t code)
+{
+	uint16_t n = 0;
+	int8_t b;
+
+	for ( b = PRINCETON_BITS - 1; b >= 0; b-- )
+	{
+		princeton_pulses[n++] = ((code >> b) & 1) ? 1110 : 370;
+		princeton_pulses[n++] = ((code >> b) & 1) ? 370 : 1110;
+	}
+	princeton_pulses[n] = 12000;
+} // static void make_princeton(uint32_t code)
+
+
+
+// Two frames of level runs, see test_lfrfid.c
+static void make_em4100(void)
+{
+	static const uint8_t uid[EM4100_DECODED_DATA_SIZE] = {0x12, 0x34, 0x56, 0x78, 0x9A};
+	uint8_t frame[8], level = 2, v, l, half;
+	uint16_t bit, run = 0, n = 0, rep;
+
+	em4100_build_frame8_from_uid(frame, uid, sizeof(uid));
+	for ( rep = 0; rep < 2; rep++ )
+	{
+		for ( bit = 0; bit < FRAME_BITS; bit++ )
+		{
+			v = (frame[bit >> 3] >> (7 - (bit & 7))) & 1;
+			for ( half = 0; half < 2; half++ )
+			{
+				l = half ? !v : v;
+				if ( l!=level && run )
+				{
+					em4100_edges[n].t_us = run*T_256_US;
+					em4100_edges[n].edge = !level;
+					n++;
+					run = 0;
+				}
+				level = l;
+				run++;
+			}
+		}
+	}
+	em4100_edge_count = n;
+} // static void make_em4100(void)
+
+
+
+static uint32_t decode_em4100(void)
+{
+	uint16_t i, chunk;
+
+	lfrfid_decoder_begin();
+	for ( i = 0; i < em4100_edge_count; i += chunk )
+	{
+		chunk = (em4100_edge_count - i > EM4100_CHUNK) ? EM4100_CHUNK : em4100_edge_count - i;
+		if ( lfrfid_decoder_execute(LFRFIDProtocolEM4100, &em4100_edges[i], (uint8_t)chunk) )
+			return 1;
+	}
+
+	return 0;
+} // static uint32_t decode_em4100(void)
+
+
+
+int main(int argc, char *argv[])
+{
+	SubGHz_Dec_Info_t info;
+	uint16_t k;
+
+	bench_init(argc, argv);
+	make_princeton(0xA5C33C);
+	make_em4100();
+	subghz_decenc_init();
+	subghz_decenc_ctl.subghz_pulse_handler(12000);
+
+	BENCH("princeton packet", 200000, 0,
+	{
+		for ( k = 0; k < PRINCETON_PULSES; k++ )
+			subghz_decenc_ctl.subghz_pulse_handler(princeton_pulses[k]);
+		bench_sink += subghz_decenc_read(&info, false);
+	});
+
+	BENCH("em4100 2 frames", 20000, 0, bench_sink += decode_em4100());
+
+	return 0;
+}
@@ -0,0 +1,114 @@
+/* See COPYING.txt for license details. */
+
+/*
+*
+* bench_parsers.c
+*
+* Load time of the SD card file formats on the fake SD card: .ir remote
+* files, raw IR signals and NFC dumps in text and binary form
+*
+* M1 Project
+*
+*/
+
+#include <stdlib.h>
+#include "ff.h"
+#include "m1_ir_universal.h"
+#include "m1_ir_raw.h"
+#include "nfc_ctx.h"
+#include "nfc_dump_bin.h"
+#include "nfc_file.h"
+#include "nfc_storage.h"
+#include "m1_host_bench.h"
+
+#define BENCH_DIR			"0:/bench"
+#define BENCH_IR_FILE		BENCH_DIR "/remote.ir"
+#define BENCH_RAW_FILE		BENCH_DIR "/raw.ir"
+#define BENCH_NFC_FILE		BENCH_DIR "/tag.nfc"
+#define BENCH_NFB_FILE		BENCH_DIR "/tag.nfb"
+
+#define BENCH_IR_CMDS		40
+#define BENCH_NFC_PAGES		231		// NTAG216
+
+static S_IR_Device_t device;
+static S_IR_Raw_t raw;
+
+static void make_ir_file(void)
+{
+	FIL f;
+	uint16_t i;
+
+	f_open(&f, BENCH_IR_FILE, FA_CREATE_ALWAYS | FA_WRITE);
+	f_printf(&f, "Filetype: IR signals file\nVersion: 1\n");
+	for ( i = 0; i < BENCH_IR_CMDS; i++ )
+	{
+		f_printf(&f, "# \nname: Button_%d\ntype: parsed\nprotocol: NEC\n", i);
+		f_printf(&f, "address: %02X 00 00 00\ncommand: %02X 00 00 00\n", i, i*3);
+	}
+	f_close(&f);
+} // static void make_ir_file(void)
+
+
+
+static void make_raw_file(void)
+{
+	uint16_t i;
+
+	ir_raw_reset(&raw);
+	for ( i = 0; i < 600; i++ )
+		ir_raw_add(&raw, 400 + (i % 7)*100, !(i & 1));
+	ir_raw_finish(&raw);
+	ir_raw_save(BENCH_RAW_FILE, "Bench", &raw);
+} // static void make_raw_file(void)
+
+
+
+static void make_nfc_files(void)
+{
+	nfc_run_ctx_t *c = nfc_ctx_get();
+	uint32_t i;
+
+	nfc_ctx_begin_live();
+	memset(&c->head, 0, sizeof(c->head));
+	c->head.tech = M1NFC_TECH_A;
+	c->head.family = M1NFC_FAM_ULTRALIGHT;
+	c->head.uid_len = 7;
+	for ( i = 0; i < 7; i++ )
+		c->head.uid[i] = (uint8_t)(0x04 + i);
+	for ( i = 0; i < BENCH_NFC_PAGES*4; i++ )
+		g_nfc_dump_buf[i] = (uint8_t)rand();
+	memset(g_nfc_valid_bits, 0xFF, sizeof(g_nfc_valid_bits));
+	nfc_ctx_set_dump(4, BENCH_NFC_PAGES, 0, g_nfc_dump_buf, g_nfc_valid_bits, BENCH_NFC_PAGES - 1, true);
+
+	nfc_profile_save(BENCH_NFC_FILE, c);
+	nfc_dump_bin_save(BENCH_NFB_FILE, c, NULL);
+} // static void make_nfc_files(void)
+
+
+
+int main(int argc, char *argv[])
+{
+	uint32_t offset;
+
+	bench_init(argc, argv);
+	f_mkdir(BENCH_DIR);
+	nfc_ctx_module_init();
+	make_ir_file();
+	make_raw_file();
+	make_nfc_files();
+
+	BENCH("ir_universal_parse_file 40 cmds", 2000, 0, bench_sink += ir_universal_parse_file(BENCH_IR_FILE, &device));
+
+	ir_universal_parse_file(BENCH_RAW_FILE, &device);
+	offset = device.cmds[0].raw_offset;
+	BENCH("ir_raw_load 600 edges", 2000, 0, bench_sink += ir_raw_load(BENCH_RAW_FILE, offset, 38000, 33, &raw));
+
+	BENCH("nfc text load NTAG216", 200, 0,
+		bench_sink += nfc_storage_load_file(BENCH_NFC_FILE, g_nfc_dump_buf, sizeof(g_nfc_dump_buf),
+		                                    g_nfc_valid_bits, sizeof(g_nfc_valid_bits)));
+	BENCH("nfc binary load NTAG216", 2000, 0,
+		bench_sink += nfc_dump_bin_load(BENCH_NFB_FILE, g_nfc_dump_buf, sizeof(g_nfc_dump_buf),
+		                                g_nfc_valid_bits, sizeof(g_nfc_valid_bits)));
+
+	return 0;
+}
@@ -0,0 +1,89 @@
+/* See COPYING.txt for license details. */
+
+/*
+*
+* bench_ring_buffer.c
+*
+* Cost of moving data through m1_ring_buffer.c the way the Sub-GHz and
+* LF RFID capture paths do: per-slot inserts and block writes/reads, and
+* a Sub-GHz DMA block drained slot by slot or in one bulk write
+*
+* M1 Project
+*
+*/
+
+#include <stdint.h>
+#include "m1_ring_buffer.h"
+#include "m1_host_bench.h"
+
+#define RB_SLOTS		1024
+#define RB_BLOCK		64
+#define RB_DMA_BLOCK	256		// SUBGHZ_RX_DMA_BLOCK_SAMPLES
+
+static uint8_t storage[RB_SLOTS*sizeof(uint16_t)];
+static uint8_t block[RB_DMA_BLOCK*sizeof(uint16_t)];
+static uint16_t pulses[RB_DMA_BLOCK];
+static S_M1_RingBuffer rb;
+
+int main(int argc, char *argv[])
+{
+	uint16_t sample = 0;
+	uint32_t k;
+
+	bench_init(argc, argv);
+	m1_ringbuffer_init(&rb, storage, RB_SLOTS, sizeof(uint16_t));
+
+	BENCH("insert+read 1 slot", 1000000, sizeof(uint16_t),
+	{
+		sample++;
+		m1_ringbuffer_insert(&rb, (uint8_t *)&sample);
+		bench_sink += m1_ringbuffer_read(&rb, block, 1);
+	});
+
+	BENCH("insert 64 + read block", 100000, RB_BLOCK*sizeof(uint16_t),
+	{
+		for ( k = 0; k < RB_BLOCK; k++ )
+			m1_ringbuffer_insert(&rb, (uint8_t *)&sample);
+		bench_sink += m1_ringbuffer_read(&rb, block, RB_BLOCK);
+	});
+
+	BENCH("write + read block", 100000, RB_BLOCK*sizeof(uint16_t),
+	{
+		m1_ringbuffer_write(&rb, block, RB_BLOCK);
+		bench_sink += m1_ringbuffer_read(&rb, block, RB_BLOCK);
+	});
+
+	// Sub-GHz DMA block drain: one slot at a time vs staged and written once
+	BENCH("DMA block insert x256", 20000, RB_DMA_BLOCK*sizeof(uint16_t),
+	{
+		for ( k = 0; k < RB_DMA_BLOCK; k++ )
+		{
+			pulses[k] = (uint16_t)(k + sample);
+			if ( ringbuffer_get_empty_slots(&rb) )
+				m1_ringbuffer_insert(&rb, (uint8_t *)&pulses[k]);
+		}
+		bench_sink += m1_ringbuffer_read(&rb, block, RB_DMA_BLOCK);
+	});
+
+	BENCH("DMA block write x1", 20000, RB_DMA_BLOCK*sizeof(uint16_t),
+	{
+		for ( k = 0; k < RB_DMA_BLOCK; k++ )
+			pulses[k] = (uint16_t)(k + sample);
+		m1_ringbuffer_write(&rb, (uint8_t *)pulses, RB_DMA_BLOCK);
+		bench_sink += m1_ringbuffer_read(&rb, block, RB_DMA_BLOCK);
+	});
+
+	BENCH("peek + advance block", 100000, RB_BLOCK*sizeof(uint16_t),
+	{
+		m1_ringbuffer_write(&rb, block, RB_BLOCK);
+		bench_sink += m1_ringbuffer_peek(&rb, block, RB_BLOCK);
+		m1_ringbuffer_advance_read(&rb, RB_BLOCK);
+	});
+
+	BENCH("space queries", 1000000, 0,
+	{
+		bench_sink += ringbuffer_get_empty_slots(&rb) + ringbuffer_get_data_slots(&rb);
+	});
+
+	return 0;
+}
@@ -0,0 +1,88 @@
+/* See COPYING.txt for license details. */
+
+/*
+*
+* m1_host_bench.h
+*
+* Minimal timing harness of the host micro-benchmarks. Each benchmark is
+* one source file; "--quick" divides the iteration counts so ctest can run
+* it as a smoke test.
+*
+* M1 Project
+*
+*/
+
+#ifndef M1_HOST_BENCH_H_
+#define M1_HOST_BENCH_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_QUICK_DIVIDER		100
+
+static uint32_t bench_divider = 1;
+
+// Defeats dead code elimination of benchmarked results
+static volatile uint32_t bench_sink;
+
+static inline uint64_t bench_now_ns(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (uint64_t)now.tv_sec*1000000000ULL + (uint64_t)now.tv_nsec;
+} // static inline uint64_t bench_now_ns(void)
+
+
+
+static inline void bench_init(int argc, char *argv[])
+{
+	int i;
+
+	for ( i = 1; i < argc; i++ )
+	{
+		if ( !strcmp(argv[i], "--quick") )
+			bench_divider = BENCH_QUICK_DIVIDER;
+	}
+} // static inline void bench_init(int argc, char *argv[])
+
+
+
+// Iteration count of one measurement, at least 1 in quick mode
+static inline uint32_t bench_iterations(uint32_t full)
+{
+	return (full/bench_divider) ? full/bench_divider : 1;
+} // static inline uint32_t bench_iterations(uint32_t full)
+
+
+
+/*
+ * Prints one result line: time per iteration and, if bytes is not 0, the
+ * throughput over bytes processed per iteration
+ */
+static inline void bench_report(const char *name, uint64_t ns, uint32_t iterations, uint32_t bytes)
+{
+	double per_it = (double)ns/iterations;
+
+	if ( bytes )
+		printf("%-32s %10.1f ns/it %10.1f MB/s\n", name, per_it, bytes*1000.0/per_it);
+	else
+		printf("%-32s %10.1f ns/it\n", name, per_it);
+} // static inline void bench_report(const char *name, uint64_t ns, uint32_t iterations, uint32_t bytes)
+
+
+
+// Times n iterations of the statement block, bytes per iteration for MB/s
+#define BENCH(name, n, bytes, block) \
+	do { \
+		uint32_t _n = bench_iterations(n), _i; \
+		uint64_t _t0 = bench_now_ns(); \
+		for ( _i = 0; _i < _n; _i++ ) \
+		{ block; } \
+		bench_report(name, bench_now_ns() - _t0, _n, bytes); \
+	} while (0)
+
+#endif /* M1_HOST_BENCH_H_ */
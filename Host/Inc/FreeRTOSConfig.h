@@ -0,0 +1,53 @@
+/* See COPYING.txt for license details. */
+
+/*
+*
+* FreeRTOSConfig.h
+*
+* FreeRTOS configuration of the host build: the firmware configuration with
+* the settings that only make sense on the STM32 replaced.
+*
+* M1 Project
+*
+*/
+
+#ifndef M1_HOST_FREERTOS_CONFIG_H_
+#define M1_HOST_FREERTOS_CONFIG_H_
+
+#include "../../Core/Inc/FreeRTOSConfig.h"
+
+/* No newlib reentrancy structures on the host C library */
+#undef configUSE_NEWLIB_REENTRANT
+#define configUSE_NEWLIB_REENTRANT			0
+
+/* Threads have their own stacks, task stacks only hold the thread handle */
+#undef configCHECK_FOR_STACK_OVERFLOW
+#define configCHECK_FOR_STACK_OVERFLOW		0
+
+#undef configTOTAL_HEAP_SIZE
+#define configTOTAL_HEAP_SIZE				((size_t)(1024*1024))
+
+/* The idle hook takes the context switches requested by the tick thread */
+#undef configUSE_IDLE_HOOK
+#define configUSE_IDLE_HOOK					1
+
+#undef configUSE_TICKLESS_IDLE
+#define configUSE_TICKLESS_IDLE				0
+#undef configPRE_SLEEP_PROCESSING
+#undef configPOST_SLEEP_PROCESSING
+
+#undef configGENERATE_RUN_TIME_STATS
+#define configGENERATE_RUN_TIME_STATS		0
+#undef portCONFIGURE_TIMER_FOR_RUN_TIME_STATS
+#undef portGET_RUN_TIME_COUNTER_VALUE
+
+#undef configCPU_CLOCK_HZ
+#define configCPU_CLOCK_HZ					( 1000000000UL )
+
+#undef SysTick_Handler
+
+void vAssertCalled(const char *file, int line);
+#undef configASSERT
+#define configASSERT( x ) if ((x) == 0) vAssertCalled(__FILE__, __LINE__)
+
+#endif /* M1_HOST_FREERTOS_CONFIG_H_ */
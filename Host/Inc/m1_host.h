@@ -0,0 +1,48 @@
+/* See COPYING.txt for license details. */
+
+/*
+*
+* m1_host.h
+*
+* Helpers of the host build (Linux simulation of the firmware core)
+*
+* M1 Project
+*
+*/
+
+#ifndef M1_HOST_H_
+#define M1_HOST_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Environment variable holding the directory that backs the fake SD card */
+#define M1_HOST_SD_ROOT_ENV			"M1_HOST_SD_ROOT"
+#define M1_HOST_SD_ROOT_DEFAULT		"m1_sdcard"
+
+typedef void (*m1_host_task_fn)(void *param);
+
+/*
+ * Sets the host directory that backs drive "0:" and creates it if needed.
+ * Without a call the directory comes from M1_HOST_SD_ROOT_ENV, or
+ * M1_HOST_SD_ROOT_DEFAULT in the working directory.
+ */
+bool m1_host_sd_set_root(const char *path);
+
+/* Host directory that backs drive "0:" */
+const char *m1_host_sd_get_root(void);
+
+/*
+ * Maps a FatFs path ("0:/IR/tv.ir", "/IR/tv.ir") onto the host directory.
+ * Returns false if the result does not fit into out.
+ */
+bool m1_host_sd_map_path(const char *path, char *out, uint32_t out_size);
+
+/*
+ * Runs fn(param) in a FreeRTOS task at priority prio, with the scheduler
+ * started on the POSIX port, and returns once fn has returned. The scheduler
+ * can only be started once per process.
+ */
+void m1_host_run_task(m1_host_task_fn fn, void *param, uint32_t prio);
+
+#endif /* M1_HOST_H_ */
@@ -0,0 +1,21 @@
+/* See COPYING.txt for license details. */
+
+/*
+*
+* m1_host_defs.h
+*
+* Included ahead of every source of the host build (see cmake/host) for the
+* toolchain specific macros the firmware gets from newlib.
+*
+* M1 Project
+*
+*/
+
+#ifndef M1_HOST_DEFS_H_
+#define M1_HOST_DEFS_H_
+
+#ifndef _ATTRIBUTE
+#define _ATTRIBUTE(attrs)	__attribute__(attrs)
+#endif
+
+#endif /* M1_HOST_DEFS_H_ */
@@ -0,0 +1,99 @@
+/* See COPYING.txt for license details. */
+
+/*
+*
+* m1_host_dir.c
+*
+* Host directory listing for the fake SD card
+*
+* M1 Project
+*
+*/
+
+/*************************** I N C L U D E S **********************************/
+
+#include <dirent.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "m1_host_dir.h"
+
+//************************** S T R U C T U R E S *******************************
+
+typedef struct
+{
+	DIR *dir;
+	char path[PATH_MAX];
+} S_Host_Dir;
+
+/*************** F U N C T I O N   I M P L E M E N T A T I O N ****************/
+
+void *m1_host_dir_open(const char *path)
+{
+	S_Host_Dir *hdir;
+
+	hdir = (S_Host_Dir *)malloc(sizeof(S_Host_Dir));
+	if ( hdir==NULL )
+		return NULL;
+	hdir->dir = opendir(path);
+	if ( hdir->dir==NULL )
+	{
+		free(hdir);
+		return NULL;
+	}
+	snprintf(hdir->path, sizeof(hdir->path), "%s", path);
+
+	return hdir;
+} // void *m1_host_dir_open(const char *path)
+
+
+
+/*============================================================================*/
+/*
+ * Returns the next entry, without the "." and ".." entries like FatFs
+ */
+/*============================================================================*/
+bool m1_host_dir_read(void *dir, S_Host_Dir_Entry *entry)
+{
+	S_Host_Dir *hdir = (S_Host_Dir *)dir;
+	struct dirent *dent;
+	struct stat st;
+	char full[PATH_MAX + 256];
+
+	while ( (dent = readdir(hdir->dir))!=NULL )
+	{
+		if ( !strcmp(dent->d_name, ".") || !strcmp(dent->d_name, "..") )
+			continue;
+		snprintf(full, sizeof(full), "%s/%s", hdir->path, dent->d_name);
+		if ( stat(full, &st)!=0 )
+			continue;
+		entry->name = dent->d_name;
+		entry->is_dir = S_ISDIR(st.st_mode);
+		entry->size = entry->is_dir ? 0 : (uint64_t)st.st_size;
+		entry->mtime = st.st_mtime;
+		return true;
+	} // while ( (dent = readdir(hdir->dir))!=NULL )
+
+	return false;
+} // bool m1_host_dir_read(void *dir, S_Host_Dir_Entry *entry)
+
+
+
+void m1_host_dir_rewind(void *dir)
+{
+	rewinddir(((S_Host_Dir *)dir)->dir);
+} // void m1_host_dir_rewind(void *dir)
+
+
+
+void m1_host_dir_close(void *dir)
+{
+	S_Host_Dir *hdir = (S_Host_Dir *)dir;
+
+	if ( hdir==NULL )
+		return;
+	closedir(hdir->dir);
+	free(hdir);
+} // void m1_host_dir_close(void *dir)
@@ -0,0 +1,34 @@
+/* See COPYING.txt for license details. */
+
+/*
+*
+* m1_host_dir.h
+*
+* Host directory listing for the fake SD card. Kept apart from m1_host_sdcard.c
+* because FatFs and POSIX both define DIR.
+*
+* M1 Project
+*
+*/
+
+#ifndef M1_HOST_DIR_H_
+#define M1_HOST_DIR_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+typedef struct
+{
+	const char *name;
+	bool is_dir;
+	uint64_t size;
+	time_t mtime;
+} S_Host_Dir_Entry;
+
+void *m1_host_dir_open(const char *path);
+bool m1_host_dir_read(void *dir, S_Host_Dir_Entry *entry);
+void m1_host_dir_rewind(void *dir);
+void m1_host_dir_close(void *dir);
+
+#endif /* M1_HOST_DIR_H_ */
@@ -0,0 +1,124 @@
+/* See COPYING.txt for license details. */
+
+/*
+*
+* m1_host_freertos.c
+*
+* FreeRTOS application hooks of the host build
+*
+* M1 Project
+*
+*/
+
+/*************************** I N C L U D E S **********************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "m1_host.h"
+
+/*************************** D E F I N E S ************************************/
+
+#define HOST_MAIN_TASK_STACK_SIZE		configMINIMAL_STACK_SIZE
+
+//************************** C O N S T A N T **********************************/
+
+//************************** S T R U C T U R E S *******************************
+
+typedef struct
+{
+	m1_host_task_fn fn;
+	void *param;
+} S_Host_Task_Call;
+
+/***************************** V A R I A B L E S ******************************/
+
+static StaticTask_t idle_task_tcb;
+static StackType_t idle_task_stack[configMINIMAL_STACK_SIZE];
+static StaticTask_t timer_task_tcb;
+static StackType_t timer_task_stack[configTIMER_TASK_STACK_DEPTH];
+static StaticTask_t host_main_task_tcb;
+static StackType_t host_main_task_stack[HOST_MAIN_TASK_STACK_SIZE];
+
+/********************* F U N C T I O N   P R O T O T Y P E S ******************/
+
+void vPortIdleYield(void);
+static void host_main_task(void *param);
+
+/*************** F U N C T I O N   I M P L E M E N T A T I O N ****************/
+
+void vAssertCalled(const char *file, int line)
+{
+	fprintf(stderr, "configASSERT failed: %s:%d\n", file, line);
+	abort();
+} // void vAssertCalled(const char *file, int line)
+
+
+
+void vApplicationIdleHook(void)
+{
+	vPortIdleYield();
+} // void vApplicationIdleHook(void)
+
+
+
+void vApplicationMallocFailedHook(void)
+{
+	fprintf(stderr, "FreeRTOS heap exhausted\n");
+	abort();
+} // void vApplicationMallocFailedHook(void)
+
+
+
+void vApplicationGetIdleTaskMemory(StaticTask_t **ppxIdleTaskTCBBuffer, StackType_t **ppxIdleTaskStackBuffer, uint32_t *pulIdleTaskStackSize)
+{
+	*ppxIdleTaskTCBBuffer = &idle_task_tcb;
+	*ppxIdleTaskStackBuffer = idle_task_stack;
+	*pulIdleTaskStackSize = configMINIMAL_STACK_SIZE;
+} // void vApplicationGetIdleTaskMemory(...)
+
+
+
+void vApplicationGetTimerTaskMemory(StaticTask_t **ppxTimerTaskTCBBuffer, StackType_t **ppxTimerTaskStackBuffer, uint32_t *pulTimerTaskStackSize)
+{
+	*ppxTimerTaskTCBBuffer = &timer_task_tcb;
+	*ppxTimerTaskStackBuffer = timer_task_stack;
+	*pulTimerTaskStackSize = configTIMER_TASK_STACK_DEPTH;
+} // void vApplicationGetTimerTaskMemory(...)
+
+
+
+/*============================================================================*/
+/*
+ * Task started by m1_host_run_task()
+ */
+/*============================================================================*/
+static void host_main_task(void *param)
+{
+	S_Host_Task_Call *call = (S_Host_Task_Call *)param;
+
+	call->fn(call->param);
+	vTaskEndScheduler();
+} // static void host_main_task(void *param)
+
+
+
+/*============================================================================*/
+/*
+ * Runs a function in a task and returns once it has returned
+ */
+/*============================================================================*/
+void m1_host_run_task(m1_host_task_fn fn, void *param, uint32_t prio)
+{
+	static S_Host_Task_Call call;
+	TaskHandle_t hdl;
+
+	call.fn = fn;
+	call.param = param;
+	hdl = xTaskCreateStatic(host_main_task, "host_main", HOST_MAIN_TASK_STACK_SIZE, &call,
+							prio, host_main_task_stack, &host_main_task_tcb);
+	configASSERT(hdl != NULL);
+
+	vTaskStartScheduler();
+} // void m1_host_run_task(m1_host_task_fn fn, void *param, uint32_t prio)
@@ -0,0 +1,114 @@
+/* See COPYING.txt for license details. */
+
+/*
+*
+* m1_host_hal.c
+*
+* HAL, CMSIS-RTOS and logging functions used by the core modules, on top of
+* the host clock and stdout
+*
+* M1 Project
+*
+*/
+
+/*************************** I N C L U D E S **********************************/
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "main.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "cmsis_os2.h"
+#include "m1_log_debug.h"
+
+/*************************** D E F I N E S ************************************/
+
+// Most verbose level printed, LOG_DEBUG_LEVEL_WARN if not set
+#define HOST_LOG_LEVEL_ENV		"M1_HOST_LOG_LEVEL"
+
+/***************************** V A R I A B L E S ******************************/
+
+static int host_log_level = -1;
+
+/*************** F U N C T I O N   I M P L E M E N T A T I O N ****************/
+
+/*============================================================================*/
+/*
+ * Milliseconds since an arbitrary point, like the SysTick based HAL tick
+ */
+/*============================================================================*/
+uint32_t HAL_GetTick(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (uint32_t)((uint64_t)now.tv_sec*1000 + (uint64_t)now.tv_nsec/1000000);
+} // uint32_t HAL_GetTick(void)
+
+
+
+void HAL_Delay(uint32_t Delay)
+{
+	struct timespec pause;
+
+	pause.tv_sec = Delay/1000;
+	pause.tv_nsec = (long)(Delay%1000)*1000000L;
+	nanosleep(&pause, NULL);
+} // void HAL_Delay(uint32_t Delay)
+
+
+
+osStatus_t osDelay(uint32_t ticks)
+{
+	if ( xTaskGetSchedulerState()==taskSCHEDULER_NOT_STARTED )
+	{
+		HAL_Delay(ticks*1000/configTICK_RATE_HZ);
+	}
+	else if ( ticks )
+	{
+		vTaskDelay(ticks);
+	}
+
+	return osOK;
+} // osStatus_t osDelay(uint32_t ticks)
+
+
+
+void assert_failed(uint8_t *file, uint32_t line)
+{
+	fprintf(stderr, "assert_param failed: %s:%lu\n", (char *)file, (unsigned long)line);
+	abort();
+} // void assert_failed(uint8_t *file, uint32_t line)
+
+
+
+void Error_Handler(void)
+{
+	fprintf(stderr, "Error_Handler\n");
+	abort();
+} // void Error_Handler(void)
+
+
+
+void m1_logdb_printf(S_M1_LogDebugLevel_t level, const char *tag, const char *format, ...)
+{
+	static const char level_tag[] = "NEWIDT";
+	const char *env;
+	va_list args;
+
+	if ( host_log_level < 0 )
+	{
+		env = getenv(HOST_LOG_LEVEL_ENV);
+		host_log_level = (env!=NULL) ? atoi(env) : LOG_DEBUG_LEVEL_WARN;
+	}
+	if ( (int)level > host_log_level )
+		return;
+
+	printf("[%c][%s] ", level_tag[level <= LOG_DEBUG_LEVEL_TRACE ? level : 0], tag);
+	va_start(args, format);
+	vprintf(format, args);
+	va_end(args);
+} // void m1_logdb_printf(S_M1_LogDebugLevel_t level, const char *tag, const char *format, ...)
@@ -0,0 +1,865 @@
+/* See COPYING.txt for license details. */
+
+/*
+*
+* m1_host_sdcard.c
+*
+* Fake SD card of the host build: the FatFs file API and the m1_sdcard
+* status API on top of a host directory (see m1_host.h). Drive "0:" maps to
+* the root of that directory.
+*
+* M1 Project
+*
+*/
+
+/*************************** I N C L U D E S **********************************/
+
+#define _GNU_SOURCE // FNM_CASEFOLD
+#include <errno.h>
+#include <fnmatch.h>
+#include <limits.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+#include <time.h>
+#include <unistd.h>
+#include "ff.h"
+#include "m1_sdcard.h"
+#include "m1_host.h"
+#include "m1_host_dir.h"
+
+/*************************** D E F I N E S ************************************/
+
+#define HOST_SD_SECTOR_SIZE		512
+#define HOST_SD_CLUSTER_SECTORS	8 // 4 KB clusters
+#define HOST_SD_CLUSTER_SIZE	(HOST_SD_SECTOR_SIZE*HOST_SD_CLUSTER_SECTORS)
+
+#define HOST_FIL_OPEN			0x80 // FIL.flag: file is open on the host
+#define HOST_PRINTF_BUF_SIZE	256
+
+//************************** C O N S T A N T **********************************/
+
+//************************** S T R U C T U R E S *******************************
+
+/***************************** V A R I A B L E S ******************************/
+
+static char host_sd_root[PATH_MAX];
+static FATFS host_sd_fs;
+static S_M1_SDCard_Info host_sd_info;
+static S_M1_SDCard_Access_Status host_sd_status = SD_access_OK;
+static uint32_t host_sd_write_seq;
+
+/********************* F U N C T I O N   P R O T O T Y P E S ******************/
+
+static FRESULT host_sd_errno_to_fresult(int err);
+static FILE *host_sd_file(FIL *fp);
+static void host_sd_set_file(FIL *fp, FILE *file);
+static void host_sd_fill_info(FILINFO *fno, const char *name, bool is_dir, uint64_t size, time_t mtime);
+static bool host_sd_path(const TCHAR *path, char *out);
+
+/*************** F U N C T I O N   I M P L E M E N T A T I O N ****************/
+
+/*============================================================================*/
+/*
+ * Creates all missing directories of a host path
+ */
+/*============================================================================*/
+static bool host_sd_mkdirs(const char *path)
+{
+	char tmp[PATH_MAX];
+	char *p;
+
+	snprintf(tmp, sizeof(tmp), "%s", path);
+	for ( p = tmp + 1; *p; p++ )
+	{
+		if ( *p=='/' )
+		{
+			*p = '\0';
+			mkdir(tmp, 0755);
+			*p = '/';
+		}
+	} // for ( p = tmp + 1; *p; p++ )
+	if ( mkdir(tmp, 0755)!=0 && errno!=EEXIST )
+		return false;
+
+	return true;
+} // static bool host_sd_mkdirs(const char *path)
+
+
+
+bool m1_host_sd_set_root(const char *path)
+{
+	size_t len;
+
+	snprintf(host_sd_root, sizeof(host_sd_root), "%s", path);
+	len = strlen(host_sd_root);
+	while ( len > 1 && host_sd_root[len - 1]=='/' )
+		host_sd_root[--len] = '\0';
+
+	return host_sd_mkdirs(host_sd_root);
+} // bool m1_host_sd_set_root(const char *path)
+
+
+
+const char *m1_host_sd_get_root(void)
+{
+	const char *env;
+
+	if ( host_sd_root[0]=='\0' )
+	{
+		env = getenv(M1_HOST_SD_ROOT_ENV);
+		m1_host_sd_set_root((env!=NULL && env[0]!='\0') ? env : M1_HOST_SD_ROOT_DEFAULT);
+	}
+
+	return host_sd_root;
+} // const char *m1_host_sd_get_root(void)
+
+
+
+/*============================================================================*/
+/*
+ * Drops the drive prefix ("0:") of a FatFs path and puts the rest below the
+ * root directory. Paths are always taken as absolute, like FF_FS_RPATH 0.
+ */
+/*============================================================================*/
+bool m1_host_sd_map_path(const char *path, char *out, uint32_t out_size)
+{
+	const char *colon;
+	int len;
+
+	colon = strchr(path, ':');
+	if ( colon!=NULL )
+		path = colon + 1;
+	while ( *path=='/' || *path=='\\' )
+		path++;
+
+	len = snprintf(out, out_size, "%s/%s", m1_host_sd_get_root(), path);
+	if ( len < 0 || (uint32_t)len >= out_size )
+		return false;
+
+	// Trailing separators would make stat() fail on files
+	while ( len > 1 && out[len - 1]=='/' )
+		out[--len] = '\0';
+
+	return true;
+} // bool m1_host_sd_map_path(const char *path, char *out, uint32_t out_size)
+
+
+
+static bool host_sd_path(const TCHAR *path, char *out)
+{
+	return m1_host_sd_map_path(path, out, PATH_MAX);
+} // static bool host_sd_path(const TCHAR *path, char *out)
+
+
+
+static FRESULT host_sd_errno_to_fresult(int err)
+{
+	switch ( err )
+	{
+		case ENOENT:
+			return FR_NO_FILE;
+		case ENOTDIR:
+			return FR_NO_PATH;
+		case EEXIST:
+			return FR_EXIST;
+		case EACCES:
+		case EPERM:
+		case ENOTEMPTY:
+		case EISDIR:
+			return FR_DENIED;
+		case ENAMETOOLONG:
+			return FR_INVALID_NAME;
+		case EROFS:
+			return FR_WRITE_PROTECTED;
+		case EMFILE:
+		case ENFILE:
+			return FR_TOO_MANY_OPEN_FILES;
+		default:
+			return FR_DISK_ERR;
+	} // switch ( err )
+} // static FRESULT host_sd_errno_to_fresult(int err)
+
+
+
+/*============================================================================*/
+/*
+ * The host FILE lives in the sector buffer of the FIL, which FatFs uses as
+ * file data window and the firmware never touches.
+ */
+/*============================================================================*/
+static FILE *host_sd_file(FIL *fp)
+{
+	FILE *file;
+
+	if ( fp==NULL || !(fp->flag & HOST_FIL_OPEN) )
+		return NULL;
+	memcpy(&file, fp->buf, sizeof(file));
+
+	return file;
+} // static FILE *host_sd_file(FIL *fp)
+
+
+
+static void host_sd_set_file(FIL *fp, FILE *file)
+{
+	memcpy(fp->buf, &file, sizeof(file));
+} // static void host_sd_set_file(FIL *fp, FILE *file)
+
+
+
+static void host_sd_fill_info(FILINFO *fno, const char *name, bool is_dir, uint64_t size, time_t mtime)
+{
+	struct tm tm;
+
+	memset(fno, 0, sizeof(FILINFO));
+	memcpy(fno->fname, name, strnlen(name, sizeof(fno->fname) - 1)); // Longer names are cut
+	fno->fsize = size;
+	fno->fattrib = is_dir ? AM_DIR : AM_ARC;
+	localtime_r(&mtime, &tm);
+	if ( tm.tm_year >= 80 )
+	{
+		fno->fdate = (WORD)(((tm.tm_year - 80) << 9) | ((tm.tm_mon + 1) << 5) | tm.tm_mday);
+		fno->ftime = (WORD)((tm.tm_hour << 11) | (tm.tm_min << 5) | (tm.tm_sec/2));
+	}
+} // static void host_sd_fill_info(...)
+
+
+
+DWORD get_fattime(void)
+{
+	time_t now = time(NULL);
+	struct tm tm;
+
+	localtime_r(&now, &tm);
+
+	return ((DWORD)(tm.tm_year - 80) << 25) | ((DWORD)(tm.tm_mon + 1) << 21) | ((DWORD)tm.tm_mday << 16)
+		| ((DWORD)tm.tm_hour << 11) | ((DWORD)tm.tm_min << 5) | ((DWORD)tm.tm_sec/2);
+} // DWORD get_fattime(void)
+
+
+
+FRESULT f_mount(FATFS *fs, const TCHAR *path, BYTE opt)
+{
+	(void)fs;
+	(void)path;
+	(void)opt;
+
+	return host_sd_mkdirs(m1_host_sd_get_root()) ? FR_OK : FR_NOT_READY;
+} // FRESULT f_mount(FATFS *fs, const TCHAR *path, BYTE opt)
+
+
+
+FRESULT f_open(FIL *fp, const TCHAR *path, BYTE mode)
+{
+	char hpath[PATH_MAX];
+	struct stat st;
+	const char *fmode;
+	bool exists;
+	FILE *file;
+
+	if ( fp==NULL )
+		return FR_INVALID_OBJECT;
+	memset(fp, 0, offsetof(FIL, buf));
+	if ( !host_sd_path(path, hpath) )
+		return FR_INVALID_NAME;
+
+	exists = (stat(hpath, &st)==0);
+	if ( exists && S_ISDIR(st.st_mode) )
+		return FR_NO_FILE;
+
+	if ( mode & FA_CREATE_ALWAYS )
+	{
+		fmode = "w+b";
+	}
+	else if ( mode & FA_CREATE_NEW )
+	{
+		if ( exists )
+			return FR_EXIST;
+		fmode = "w+b";
+	}
+	else if ( exists )
+	{
+		fmode = (mode & FA_WRITE) ? "r+b" : "rb";
+	}
+	else if ( mode & FA_OPEN_ALWAYS )
+	{
+		fmode = "w+b";
+	}
+	else
+	{
+		return FR_NO_FILE;
+	}
+
+	file = fopen(hpath, fmode);
+	if ( file==NULL )
+		return (errno==ENOENT) ? FR_NO_PATH : host_sd_errno_to_fresult(errno);
+
+	host_sd_set_file(fp, file);
+	fp->flag = (BYTE)((mode & (FA_READ | FA_WRITE)) | HOST_FIL_OPEN);
+	if ( mode & FA_WRITE )
+		host_sd_write_seq++;
+	fseeko(file, 0, SEEK_END);
+	fp->obj.objsize = (FSIZE_t)ftello(file);
+	if ( (mode & FA_OPEN_APPEND)==FA_OPEN_APPEND )
+	{
+		fp->fptr = fp->obj.objsize;
+	}
+	else
+	{
+		fseeko(file, 0, SEEK_SET);
+	}
+
+	return FR_OK;
+} // FRESULT f_open(FIL *fp, const TCHAR *path, BYTE mode)
+
+
+
+FRESULT f_close(FIL *fp)
+{
+	FILE *file = host_sd_file(fp);
+	int ret;
+
+	if ( file==NULL )
+		return FR_INVALID_OBJECT;
+	ret = fclose(file);
+	fp->flag = 0;
+
+	return (ret==0) ? FR_OK : FR_DISK_ERR;
+} // FRESULT f_close(FIL *fp)
+
+
+
+FRESULT f_read(FIL *fp, void *buff, UINT btr, UINT *br)
+{
+	FILE *file = host_sd_file(fp);
+	size_t n;
+
+	*br = 0;
+	if ( file==NULL )
+		return FR_INVALID_OBJECT;
+	if ( !(fp->flag & FA_READ) )
+		return FR_DENIED;
+
+	fseeko(file, (off_t)fp->fptr, SEEK_SET);
+	n = fread(buff, 1, btr, file);
+	if ( n < btr && ferror(file) )
+	{
+		clearerr(file);
+		return FR_DISK_ERR;
+	}
+	*br = (UINT)n;
+	fp->fptr += n;
+
+	return FR_OK;
+} // FRESULT f_read(FIL *fp, void *buff, UINT btr, UINT *br)
+
+
+
+FRESULT f_write(FIL *fp, const void *buff, UINT btw, UINT *bw)
+{
+	FILE *file = host_sd_file(fp);
+	size_t n;
+
+	*bw = 0;
+	if ( file==NULL )
+		return FR_INVALID_OBJECT;
+	if ( !(fp->flag & FA_WRITE) )
+		return FR_DENIED;
+
+	// Switching between reading and writing a stream needs a seek
+	fseeko(file, (off_t)fp->fptr, SEEK_SET);
+	n = fwrite(buff, 1, btw, file);
+	host_sd_write_seq++;
+	*bw = (UINT)n;
+	fp->fptr += n;
+	if ( fp->fptr > fp->obj.objsize )
+		fp->obj.objsize = fp->fptr;
+
+	return (n==btw) ? FR_OK : FR_DISK_ERR;
+} // FRESULT f_write(FIL *fp, const void *buff, UINT btw, UINT *bw)
+
+
+
+/*============================================================================*/
+/*
+ * Like FatFs, seeking past the end grows a file open for writing and stops
+ * at the end of a read-only file.
+ */
+/*============================================================================*/
+FRESULT f_lseek(FIL *fp, FSIZE_t ofs)
+{
+	FILE *file = host_sd_file(fp);
+
+	if ( file==NULL )
+		return FR_INVALID_OBJECT;
+
+	if ( ofs > fp->obj.objsize )
+	{
+		if ( fp->flag & FA_WRITE )
+		{
+			fflush(file);
+			if ( ftruncate(fileno(file), (off_t)ofs)!=0 )
+				return FR_DISK_ERR;
+			fp->obj.objsize = ofs;
+			host_sd_write_seq++;
+		}
+		else
+		{
+			ofs = fp->obj.objsize;
+		}
+	} // if ( ofs > fp->obj.objsize )
+
+	if ( fseeko(file, (off_t)ofs, SEEK_SET)!=0 )
+		return FR_DISK_ERR;
+	fp->fptr = ofs;
+
+	return FR_OK;
+} // FRESULT f_lseek(FIL *fp, FSIZE_t ofs)
+
+
+
+FRESULT f_truncate(FIL *fp)
+{
+	FILE *file = host_sd_file(fp);
+
+	if ( file==NULL )
+		return FR_INVALID_OBJECT;
+	if ( !(fp->flag & FA_WRITE) )
+		return FR_DENIED;
+
+	fflush(file);
+	if ( ftruncate(fileno(file), (off_t)fp->fptr)!=0 )
+		return FR_DISK_ERR;
+	fp->obj.objsize = fp->fptr;
+	host_sd_write_seq++;
+
+	return FR_OK;
+} // FRESULT f_truncate(FIL *fp)
+
+
+
+FRESULT f_sync(FIL *fp)
+{
+	FILE *file = host_sd_file(fp);
+
+	if ( file==NULL )
+		return FR_INVALID_OBJECT;
+
+	return (fflush(file)==0) ? FR_OK : FR_DISK_ERR;
+} // FRESULT f_sync(FIL *fp)
+
+
+
+/*============================================================================*/
+/*
+ * Same as FatFs with FF_USE_STRFUNC 1: the line is returned as stored,
+ * including the '\n' and any '\r'.
+ */
+/*============================================================================*/
+TCHAR *f_gets(TCHAR *buff, int len, FIL *fp)
+{
+	int n = 0;
+	UINT rc;
+	TCHAR c;
+
+	while ( n < len - 1 )
+	{
+		if ( f_read(fp, &c, 1, &rc)!=FR_OK || rc!=1 )
+			break;
+		buff[n++] = c;
+		if ( c=='\n' )
+			break;
+	} // while ( n < len - 1 )
+	buff[n] = '\0';
+
+	return n ? buff : NULL;
+} // TCHAR *f_gets(TCHAR *buff, int len, FIL *fp)
+
+
+
+int f_putc(TCHAR c, FIL *fp)
+{
+	UINT bw;
+
+	return (f_write(fp, &c, 1, &bw)==FR_OK && bw==1) ? 1 : -1;
+} // int f_putc(TCHAR c, FIL *fp)
+
+
+
+int f_puts(const TCHAR *str, FIL *fp)
+{
+	UINT len = (UINT)strlen(str);
+	UINT bw;
+
+	return (f_write(fp, str, len, &bw)==FR_OK && bw==len) ? (int)len : -1;
+} // int f_puts(const TCHAR *str, FIL *fp)
+
+
+
+int f_printf(FIL *fp, const TCHAR *str, ...)
+{
+	char buf[HOST_PRINTF_BUF_SIZE];
+	char *out = buf;
+	va_list args;
+	int len, ret;
+
+	va_start(args, str);
+	len = vsnprintf(buf, sizeof(buf), str, args);
+	va_end(args);
+	if ( len < 0 )
+		return -1;
+
+	if ( len >= (int)sizeof(buf) )
+	{
+		out = (char *)malloc((size_t)len + 1);
+		if ( out==NULL )
+			return -1;
+		va_start(args, str);
+		vsnprintf(out, (size_t)len + 1, str, args);
+		va_end(args);
+	}
+
+	ret = f_puts(out, fp);
+	if ( out!=buf )
+		free(out);
+
+	return ret;
+} // int f_printf(FIL *fp, const TCHAR *str, ...)
+
+
+
+FRESULT f_stat(const TCHAR *path, FILINFO *fno)
+{
+	char hpath[PATH_MAX];
+	struct stat st;
+	const char *name;
+
+	if ( !host_sd_path(path, hpath) )
+		return FR_INVALID_NAME;
+	if ( stat(hpath, &st)!=0 )
+		return host_sd_errno_to_fresult(errno);
+
+	if ( fno!=NULL )
+	{
+		name = strrchr(hpath, '/');
+		name = (name!=NULL) ? name + 1 : hpath;
+		host_sd_fill_info(fno, name, S_ISDIR(st.st_mode), S_ISDIR(st.st_mode) ? 0 : (uint64_t)st.st_size, st.st_mtime);
+	}
+
+	return FR_OK;
+} // FRESULT f_stat(const TCHAR *path, FILINFO *fno)
+
+
+
+FRESULT f_mkdir(const TCHAR *path)
+{
+	char hpath[PATH_MAX];
+
+	if ( !host_sd_path(path, hpath) )
+		return FR_INVALID_NAME;
+	if ( mkdir(hpath, 0755)!=0 )
+		return (errno==ENOENT) ? FR_NO_PATH : host_sd_errno_to_fresult(errno);
+	host_sd_write_seq++;
+
+	return FR_OK;
+} // FRESULT f_mkdir(const TCHAR *path)
+
+
+
+FRESULT f_unlink(const TCHAR *path)
+{
+	char hpath[PATH_MAX];
+	struct stat st;
+	int ret;
+
+	if ( !host_sd_path(path, hpath) )
+		return FR_INVALID_NAME;
+	if ( stat(hpath, &st)!=0 )
+		return host_sd_errno_to_fresult(errno);
+
+	ret = S_ISDIR(st.st_mode) ? rmdir(hpath) : unlink(hpath);
+	host_sd_write_seq++;
+
+	return (ret==0) ? FR_OK : host_sd_errno_to_fresult(errno);
+} // FRESULT f_unlink(const TCHAR *path)
+
+
+
+FRESULT f_rename(const TCHAR *path_old, const TCHAR *path_new)
+{
+	char hold[PATH_MAX], hnew[PATH_MAX];
+	struct stat st;
+
+	if ( !host_sd_path(path_old, hold) || !host_sd_path(path_new, hnew) )
+		return FR_INVALID_NAME;
+	if ( stat(hold, &st)!=0 )
+		return host_sd_errno_to_fresult(errno);
+	// FatFs never replaces an existing object
+	if ( stat(hnew, &st)==0 )
+		return FR_EXIST;
+	if ( rename(hold, hnew)!=0 )
+		return (errno==ENOENT) ? FR_NO_PATH : host_sd_errno_to_fresult(errno);
+	host_sd_write_seq++;
+
+	return FR_OK;
+} // FRESULT f_rename(const TCHAR *path_old, const TCHAR *path_new)
+
+
+
+/*============================================================================*/
+/*
+ * The host listing is kept in DIR.dir, which FatFs points into its window.
+ */
+/*============================================================================*/
+FRESULT f_opendir(DIR *dp, const TCHAR *path)
+{
+	char hpath[PATH_MAX];
+	struct stat st;
+	void *hdir;
+
+	if ( dp==NULL )
+		return FR_INVALID_OBJECT;
+	memset(dp, 0, sizeof(DIR));
+	if ( !host_sd_path(path, hpath) )
+		return FR_INVALID_NAME;
+	if ( stat(hpath, &st)!=0 || !S_ISDIR(st.st_mode) )
+		return FR_NO_PATH;
+
+	hdir = m1_host_dir_open(hpath);
+	if ( hdir==NULL )
+		return host_sd_errno_to_fresult(errno);
+	dp->dir = (BYTE *)hdir;
+
+	return FR_OK;
+} // FRESULT f_opendir(DIR *dp, const TCHAR *path)
+
+
+
+FRESULT f_closedir(DIR *dp)
+{
+	if ( dp==NULL || dp->dir==NULL )
+		return FR_INVALID_OBJECT;
+	m1_host_dir_close(dp->dir);
+	dp->dir = NULL;
+
+	return FR_OK;
+} // FRESULT f_closedir(DIR *dp)
+
+
+
+FRESULT f_readdir(DIR *dp, FILINFO *fno)
+{
+	S_Host_Dir_Entry entry;
+
+	if ( dp==NULL || dp->dir==NULL )
+		return FR_INVALID_OBJECT;
+
+	if ( fno==NULL )
+	{
+		m1_host_dir_rewind(dp->dir);
+		return FR_OK;
+	}
+
+	if ( m1_host_dir_read(dp->dir, &entry) )
+	{
+		host_sd_fill_info(fno, entry.name, entry.is_dir, entry.size, entry.mtime);
+	}
+	else
+	{
+		fno->fname[0] = '\0';
+	}
+
+	return FR_OK;
+} // FRESULT f_readdir(DIR *dp, FILINFO *fno)
+
+
+
+FRESULT f_findnext(DIR *dp, FILINFO *fno)
+{
+	FRESULT res;
+
+	for ( ;; )
+	{
+		res = f_readdir(dp, fno);
+		if ( res!=FR_OK || fno->fname[0]=='\0' )
+			return res;
+		if ( fnmatch(dp->pat, fno->fname, FNM_CASEFOLD)==0 )
+			return FR_OK;
+	} // for ( ;; )
+} // FRESULT f_findnext(DIR *dp, FILINFO *fno)
+
+
+
+FRESULT f_findfirst(DIR *dp, FILINFO *fno, const TCHAR *path, const TCHAR *pattern)
+{
+	FRESULT res;
+
+	res = f_opendir(dp, path);
+	if ( res!=FR_OK )
+		return res;
+	dp->pat = pattern;
+
+	return f_findnext(dp, fno);
+} // FRESULT f_findfirst(DIR *dp, FILINFO *fno, const TCHAR *path, const TCHAR *pattern)
+
+
+
+/*============================================================================*/
+/*
+ * Reports the free space of the host file system in 4 KB clusters.
+ */
+/*============================================================================*/
+FRESULT f_getfree(const TCHAR *path, DWORD *nclst, FATFS **fatfs)
+{
+	struct statvfs vfs;
+	uint64_t total, avail;
+
+	(void)path;
+	if ( statvfs(m1_host_sd_get_root(), &vfs)!=0 )
+		return FR_NOT_READY;
+
+	total = ((uint64_t)vfs.f_blocks*vfs.f_frsize)/HOST_SD_CLUSTER_SIZE;
+	avail = ((uint64_t)vfs.f_bavail*vfs.f_frsize)/HOST_SD_CLUSTER_SIZE;
+	if ( total > 0xFFFFFFF0UL )
+		total = 0xFFFFFFF0UL;
+	if ( avail > total )
+		avail = total;
+
+	host_sd_fs.fs_type = FS_EXFAT;
+	host_sd_fs.csize = HOST_SD_CLUSTER_SECTORS;
+	host_sd_fs.n_fatent = (DWORD)total + 2;
+	host_sd_fs.free_clst = (DWORD)avail;
+	*nclst = (DWORD)avail;
+	if ( fatfs!=NULL )
+		*fatfs = &host_sd_fs;
+
+	return FR_OK;
+} // FRESULT f_getfree(const TCHAR *path, DWORD *nclst, FATFS **fatfs)
+
+
+
+FRESULT f_getlabel(const TCHAR *path, TCHAR *label, DWORD *vsn)
+{
+	(void)path;
+	if ( label!=NULL )
+		strcpy(label, "M1HOST");
+	if ( vsn!=NULL )
+		*vsn = 0x4D31;
+
+	return FR_OK;
+} // FRESULT f_getlabel(const TCHAR *path, TCHAR *label, DWORD *vsn)
+
+
+
+/*============================================================================*/
+/*
+ * m1_sdcard status API: the card is always present and mounted.
+ */
+/*============================================================================*/
+S_M1_SDCard_Init_Status m1_sdcard_init_ex(void)
+{
+	return (f_mount(&host_sd_fs, SDCARD_DEFAULT_DRIVE_PATH, 1)==FR_OK) ? SD_RET_OK : SD_RET_ERROR;
+} // S_M1_SDCard_Init_Status m1_sdcard_init_ex(void)
+
+
+
+void m1_sdcard_mount(void)
+{
+	host_sd_write_seq++;
+	host_sd_status = (m1_sdcard_init_ex()==SD_RET_OK) ? SD_access_OK : SD_access_NotReady;
+} // void m1_sdcard_mount(void)
+
+
+
+void m1_sdcard_unmount(void)
+{
+	host_sd_write_seq++;
+	host_sd_status = SD_access_UnMounted;
+} // void m1_sdcard_unmount(void)
+
+
+
+void m1_sdcard_set_status(S_M1_SDCard_Access_Status stat)
+{
+	host_sd_status = stat;
+} // void m1_sdcard_set_status(S_M1_SDCard_Access_Status stat)
+
+
+
+S_M1_SDCard_Access_Status m1_sdcard_get_status(void)
+{
+	return host_sd_status;
+} // S_M1_SDCard_Access_Status m1_sdcard_get_status(void)
+
+
+
+uint8_t m1_sd_detected(void)
+{
+	return 1;
+} // uint8_t m1_sd_detected(void)
+
+
+
+FRESULT m1_sdcard_get_error_code(void)
+{
+	return FR_OK;
+} // FRESULT m1_sdcard_get_error_code(void)
+
+
+
+// Bumped where FatFs would write sectors on the card
+uint32_t m1_sdcard_get_write_seq(void)
+{
+	return host_sd_write_seq;
+} // uint32_t m1_sdcard_get_write_seq(void)
+
+
+
+char *m1_sd_error_msg(S_M1_SDCard_Access_Status ferr)
+{
+	return (ferr==SD_access_OK) ? "OK" : "Not OK";
+} // char *m1_sd_error_msg(S_M1_SDCard_Access_Status ferr)
+
+
+
+S_M1_SDCard_Info *m1_sdcard_get_info(void)
+{
+	DWORD free_clst;
+	FATFS *fs;
+
+	memset(&host_sd_info, 0, sizeof(host_sd_info));
+	if ( f_getfree(SDCARD_DEFAULT_DRIVE_PATH, &free_clst, &fs)==FR_OK )
+	{
+		host_sd_info.fs_type = FATSYS_EXT;
+		host_sd_info.cluster_size = HOST_SD_CLUSTER_SIZE;
+		host_sd_info.sector_size = HOST_SD_SECTOR_SIZE;
+		host_sd_info.total_cap_kb = (fs->n_fatent - 2)*(HOST_SD_CLUSTER_SIZE/1024);
+		host_sd_info.free_cap_kb = free_clst*(HOST_SD_CLUSTER_SIZE/1024);
+		host_sd_info.capacity = (uint64_t)host_sd_info.total_cap_kb*1024;
+		host_sd_info.block_size = HOST_SD_SECTOR_SIZE;
+		host_sd_info.loc_block_size = HOST_SD_SECTOR_SIZE;
+		host_sd_info.loc_block_count = (uint32_t)(host_sd_info.capacity/HOST_SD_SECTOR_SIZE);
+		strcpy(host_sd_info.vol_label, "M1HOST");
+	}
+
+	return &host_sd_info;
+} // S_M1_SDCard_Info *m1_sdcard_get_info(void)
+
+
+
+uint32_t m1_sdcard_get_total_capacity(void)
+{
+	return m1_sdcard_get_info()->total_cap_kb;
+} // uint32_t m1_sdcard_get_total_capacity(void)
+
+
+
+uint32_t m1_sdcard_get_free_capacity(void)
+{
+	return m1_sdcard_get_info()->free_cap_kb;
+} // uint32_t m1_sdcard_get_free_capacity(void)
@@ -0,0 +1,317 @@
+/* See COPYING.txt for license details. */
+
+/*
+*
+* m1_host_stubs.c
+*
+* Hardware and UI functions the core modules call but cannot use on the
+* host: display, keys, LEDs, buzzer, radios and transmitters. The display
+* draws nothing, dialogs are dismissed at once and transmitters complete
+* immediately.
+*
+* M1 Project
+*
+*/
+
+/*************************** I N C L U D E S **********************************/
+
+#include <string.h>
+#include "main.h"
+#include "FreeRTOS.h"
+#include "queue.h"
+#include "u8g2.h"
+#include "m1_lcd.h"
+#include "m1_display.h"
+#include "m1_system.h"
+#include "m1_tasks.h"
+#include "m1_lib.h"
+#include "m1_buzzer.h"
+#include "m1_led_indicator.h"
+#include "m1_virtual_kb.h"
+#include "m1_infrared.h"
+#include "m1_ir_raw.h"
+#include "irsnd.h"
+#include "m1_sub_ghz_api.h"
+#include "nfc_driver.h"
+#include "lfrfid.h"
+#include "lfrfid_hal.h"
+#include "t5577.h"
+
+/***************************** V A R I A B L E S ******************************/
+
+u8g2_t m1_u8g2;
+QueueHandle_t main_q_hdl;
+QueueHandle_t button_events_q_hdl;
+
+// Fonts and icons are only passed to the (empty) draw functions
+const uint8_t u8g2_font_spleen5x8_mf[1];
+const S_M1_menu_icon_data menu_fb_icon_prev;
+const S_M1_menu_icon_data menu_fb_icon_dir;
+const S_M1_menu_icon_data menu_fb_icon_text;
+const S_M1_menu_icon_data menu_fb_icon_data;
+const S_M1_menu_icon_data menu_fb_icon_other;
+
+volatile uint8_t ir_ota_data_tx_active;
+static S_IR_Raw_t host_ir_raw;
+
+EncodedTx_Data_t lfrfid_encoded_data;
+uint8_t rfid_rxtx_is_taking_this_irq;
+
+/*************** F U N C T I O N   I M P L E M E N T A T I O N ****************/
+
+/*
+ * Display
+ */
+void m1_u8g2_firstpage(void)
+{
+} // void m1_u8g2_firstpage(void)
+
+
+
+uint8_t m1_u8g2_nextpage(void)
+{
+	return 0;
+} // uint8_t m1_u8g2_nextpage(void)
+
+
+
+void u8g2_SetDrawColor(u8g2_t *u8g2, uint8_t color)
+{
+	(void)u8g2;
+	(void)color;
+} // void u8g2_SetDrawColor(u8g2_t *u8g2, uint8_t color)
+
+
+
+void u8g2_SetFont(u8g2_t *u8g2, const uint8_t *font)
+{
+	(void)u8g2;
+	(void)font;
+} // void u8g2_SetFont(u8g2_t *u8g2, const uint8_t *font)
+
+
+
+void u8g2_DrawXBMP(u8g2_t *u8g2, u8g2_uint_t x, u8g2_uint_t y, u8g2_uint_t w, u8g2_uint_t h, const uint8_t *bitmap)
+{
+	(void)u8g2; (void)x; (void)y; (void)w; (void)h; (void)bitmap;
+} // void u8g2_DrawXBMP(...)
+
+
+
+void u8g2_DrawBox(u8g2_t *u8g2, u8g2_uint_t x, u8g2_uint_t y, u8g2_uint_t w, u8g2_uint_t h)
+{
+	(void)u8g2; (void)x; (void)y; (void)w; (void)h;
+} // void u8g2_DrawBox(...)
+
+
+
+void u8g2_DrawFrame(u8g2_t *u8g2, u8g2_uint_t x, u8g2_uint_t y, u8g2_uint_t w, u8g2_uint_t h)
+{
+	(void)u8g2; (void)x; (void)y; (void)w; (void)h;
+} // void u8g2_DrawFrame(...)
+
+
+
+u8g2_uint_t u8g2_DrawStr(u8g2_t *u8g2, u8g2_uint_t x, u8g2_uint_t y, const char *str)
+{
+	(void)u8g2; (void)x; (void)y;
+
+	return (u8g2_uint_t)strlen(str);
+} // u8g2_uint_t u8g2_DrawStr(...)
+
+
+
+u8g2_uint_t m1_draw_str(u8g2_t *u8g2, u8g2_uint_t x, u8g2_uint_t y, const char *str)
+{
+	return u8g2_DrawStr(u8g2, x, y, str);
+} // u8g2_uint_t m1_draw_str(...)
+
+
+
+/*
+ * User interface
+ */
+uint8_t m1_message_box(u8g2_t *u8g2, const char *title1, const char *title2, const char *title3, const char *buttons)
+{
+	(void)u8g2; (void)title1; (void)title2; (void)title3; (void)buttons;
+
+	return 0;
+} // uint8_t m1_message_box(...)
+
+
+
+// Like the user backing out of the keyboard
+uint8_t m1_vkb_get_filename(char *description, char *default_name, char *new_name)
+{
+	(void)description;
+	(void)default_name;
+	new_name[0] = '\0';
+
+	return 0;
+} // uint8_t m1_vkb_get_filename(char *description, char *default_name, char *new_name)
+
+
+
+void m1_app_send_q_message(QueueHandle_t Handle, S_M1_Q_Event_Type_t cmd)
+{
+	(void)Handle;
+	(void)cmd;
+} // void m1_app_send_q_message(QueueHandle_t Handle, S_M1_Q_Event_Type_t cmd)
+
+
+
+void m1_buzzer_notification(void)
+{
+} // void m1_buzzer_notification(void)
+
+
+
+void m1_led_fast_blink(uint8_t r_g_b, uint8_t pwm_rgb, uint8_t on_off_ms)
+{
+	(void)r_g_b; (void)pwm_rgb; (void)on_off_ms;
+} // void m1_led_fast_blink(uint8_t r_g_b, uint8_t pwm_rgb, uint8_t on_off_ms)
+
+
+
+/*
+ * GPIO
+ */
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState)
+{
+	(void)GPIOx; (void)GPIO_Pin; (void)PinState;
+} // void HAL_GPIO_WritePin(...)
+
+
+
+/*
+ * Infrared transmitter
+ */
+void infrared_encode_sys_init(void)
+{
+} // void infrared_encode_sys_init(void)
+
+
+
+void infrared_encode_sys_deinit(void)
+{
+} // void infrared_encode_sys_deinit(void)
+
+
+
+S_M1_IR_Tx_States infrared_transmit(uint8_t init)
+{
+	(void)init;
+	ir_ota_data_tx_active = 0;
+
+	return IR_TX_COMPLETED;
+} // S_M1_IR_Tx_States infrared_transmit(uint8_t init)
+
+
+
+void infrared_transmit_raw(const S_IR_Raw_t *raw)
+{
+	(void)raw;
+} // void infrared_transmit_raw(const S_IR_Raw_t *raw)
+
+
+
+S_IR_Raw_t *infrared_raw_buffer(void)
+{
+	return &host_ir_raw;
+} // S_IR_Raw_t *infrared_raw_buffer(void)
+
+
+
+uint8_t irsnd_generate_tx_data(IRMP_DATA irmp_data)
+{
+	(void)irmp_data;
+
+	return 1;
+} // uint8_t irsnd_generate_tx_data(IRMP_DATA irmp_data)
+
+
+
+uint8_t m1_ir_ota_frame_post_process(uint8_t ir_protocol)
+{
+	(void)ir_protocol;
+
+	return 0;
+} // uint8_t m1_ir_ota_frame_post_process(uint8_t ir_protocol)
+
+
+
+/*
+ * Sub-GHz radio
+ */
+void SI446x_Get_IntStatus(uint8_t PH_CLR_PEND, uint8_t MODEM_CLR_PEND, uint8_t CHIP_CLR_PEND)
+{
+	(void)PH_CLR_PEND; (void)MODEM_CLR_PEND; (void)CHIP_CLR_PEND;
+} // void SI446x_Get_IntStatus(...)
+
+
+
+struct si446x_reply_GET_MODEM_STATUS_map *SI446x_Get_ModemStatus(uint8_t MODEM_CLR_PEND)
+{
+	static struct si446x_reply_GET_MODEM_STATUS_map modem_status;
+
+	(void)MODEM_CLR_PEND;
+
+	return &modem_status;
+} // struct si446x_reply_GET_MODEM_STATUS_map *SI446x_Get_ModemStatus(uint8_t MODEM_CLR_PEND)
+
+
+
+/*
+ * NFC emulation
+ */
+void Emu_Clear(void)
+{
+} // void Emu_Clear(void)
+
+
+
+void Emu_SetNfcA(const uint8_t *uid, uint8_t uid_len, uint8_t atqa0, uint8_t atqa1, uint8_t sak)
+{
+	(void)uid; (void)uid_len; (void)atqa0; (void)atqa1; (void)sak;
+} // void Emu_SetNfcA(...)
+
+
+
+/*
+ * LF RFID front end
+ */
+void lfrfid_isr_init(void)
+{
+} // void lfrfid_isr_init(void)
+
+
+
+void lfrfid_read_hw_init(void)
+{
+} // void lfrfid_read_hw_init(void)
+
+
+
+void lfrfid_read_hw_deinit(void)
+{
+} // void lfrfid_read_hw_deinit(void)
+
+
+
+void lfrfid_emul_hw_init(void)
+{
+} // void lfrfid_emul_hw_init(void)
+
+
+
+void lfrfid_emul_hw_deinit(void)
+{
+} // void lfrfid_emul_hw_deinit(void)
+
+
+
+void t5577_execute_write(LFRFIDProgram *data, int block)
+{
+	(void)data;
+	(void)block;
+} // void t5577_execute_write(LFRFIDProgram *data, int block)
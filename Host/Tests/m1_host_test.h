@@ -0,0 +1,94 @@
+/* See COPYING.txt for license details. */
+
+/*
+*
+* m1_host_test.h
+*
+* Minimal test harness of the host unit tests. Each test program is one
+* source file with TEST_RUN() calls in main() and returns TEST_RESULT().
+*
+* M1 Project
+*
+*/
+
+#ifndef M1_HOST_TEST_H_
+#define M1_HOST_TEST_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+static unsigned test_passed;
+static unsigned test_failed;
+
+#define TEST_ASSERT(cond) \
+	do { \
+		if ( cond ) \
+			++test_passed; \
+		else { \
+			++test_failed; \
+			fprintf(stderr, "FAIL: %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+		} \
+	} while (0)
+
+#define TEST_ASSERT_EQ(a, b) \
+	do { \
+		long long _a = (long long)(a), _b = (long long)(b); \
+		if ( _a==_b ) \
+			++test_passed; \
+		else { \
+			++test_failed; \
+			fprintf(stderr, "FAIL: %s:%d: %s == %s (%lld <> %lld)\n", __FILE__, __LINE__, #a, #b, _a, _b); \
+		} \
+	} while (0)
+
+#define TEST_ASSERT_STR(a, b) \
+	do { \
+		const char *_a = (a), *_b = (b); \
+		if ( _a!=NULL && _b!=NULL && !strcmp(_a, _b) ) \
+			++test_passed; \
+		else { \
+			++test_failed; \
+			fprintf(stderr, "FAIL: %s:%d: %s == \"%s\" (\"%s\")\n", __FILE__, __LINE__, #a, _b ? _b : "(null)", _a ? _a : "(null)"); \
+		} \
+	} while (0)
+
+#define TEST_ASSERT_MEM(a, b, n) \
+	do { \
+		if ( memcmp((a), (b), (n))==0 ) \
+			++test_passed; \
+		else { \
+			++test_failed; \
+			fprintf(stderr, "FAIL: %s:%d: %s matches %s\n", __FILE__, __LINE__, #a, #b); \
+		} \
+	} while (0)
+
+#define TEST_RUN(fn) \
+	do { \
+		fprintf(stderr, "%s\n", #fn); \
+		fn(); \
+	} while (0)
+
+#ifdef FF_DEFINED
+// Writes a file to the fake SD card, returns false on any error
+static inline bool test_write_file(const char *path, const char *content)
+{
+	FIL f;
+	UINT bw;
+	bool ok;
+
+	if ( f_open(&f, path, FA_CREATE_ALWAYS | FA_WRITE)!=FR_OK )
+		return false;
+	ok = (f_write(&f, content, (UINT)strlen(content), &bw)==FR_OK) && bw==strlen(content);
+
+	return (f_close(&f)==FR_OK) && ok;
+} // static inline bool test_write_file(const char *path, const char *content)
+#endif // #ifdef FF_DEFINED
+
+// Prints the summary, the result is the exit code of the test program
+#define TEST_RESULT() \
+	(fprintf(stderr, "%u/%u passed, %u failed\n", test_passed, test_passed + test_failed, test_failed), \
+	 test_failed ? 1 : 0)
+
+#endif /* M1_HOST_TEST_H_ */
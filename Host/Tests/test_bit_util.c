@@ -0,0 +1,241 @@
+/* See COPYING.txt for license details. */
+
+/*
+*
+* test_bit_util.c
+*
+* Unit tests of bit_util.c: CRCs, bit reflection, whitening and UART
+* framing. Includes the checks of the _TEST main in bit_util.c.
+*
+* The table driven and hardware CRC paths are checked against plain bitwise
+* CRCs; crc_hw_calc() is replaced by a model of the STM32 CRC peripheral.
+*
+* M1 Project
+*
+*/
+
+#include "bit_util.h"
+#include "m1_host_test.h"
+
+#define CRC_LONG_BYTES		1000
+
+static const uint8_t check_msg[] = "123456789";
+static uint8_t long_msg[CRC_LONG_BYTES];
+
+static bool hw_enabled;
+static unsigned hw_calls;
+
+// Bitwise CRC of any width, poly and init reflected for lsb_first like crc16lsb()
+static uint32_t ref_crc(unsigned width, int lsb_first, uint32_t poly, uint32_t init, const uint8_t *msg, unsigned n)
+{
+	uint32_t top = 1u << (width - 1), mask = top | (top - 1), crc = init;
+	unsigned i, bit;
+
+	for ( i = 0; i < n; i++ )
+	{
+		if ( lsb_first )
+		{
+			crc ^= msg[i];
+			for ( bit = 0; bit < 8; bit++ )
+				crc = (crc & 1) ? (crc >> 1) ^ poly : (crc >> 1);
+		}
+		else
+		{
+			crc ^= (uint32_t)msg[i] << (width - 8);
+			for ( bit = 0; bit < 8; bit++ )
+				crc = ((crc & top) ? (crc << 1) ^ poly : (crc << 1)) & mask;
+		}
+	}
+
+	return crc;
+} // static uint32_t ref_crc(...)
+
+
+
+// Model of the CRC peripheral: MSB-first polynomial and init, bytes and
+// result bit reversed when lsb_first, odd polynomials only
+int crc_hw_calc(unsigned width, int lsb_first, uint32_t polynomial, uint32_t init,
+		uint8_t const message[], unsigned nBytes, uint32_t *crc)
+{
+	uint32_t top = 1u << (width - 1), mask = top | (top - 1), r = init;
+	unsigned i, bit;
+	uint8_t b;
+
+	if ( !hw_enabled || !(polynomial & 1) )
+		return 0;
+	hw_calls++;
+	for ( i = 0; i < nBytes; i++ )
+	{
+		b = lsb_first ? reverse8(message[i]) : message[i];
+		r ^= (uint32_t)b << (width - 8);
+		for ( bit = 0; bit < 8; bit++ )
+			r = ((r & top) ? (r << 1) ^ polynomial : (r << 1)) & mask;
+	}
+	*crc = lsb_first ? reverse32(r) >> (32 - width) : r;
+
+	return 1;
+} // int crc_hw_calc(...)
+
+static void test_crc(void)
+{
+	uint8_t msg[] = {0x08, 0x0a, 0xe8, 0x80};
+
+	// Parity as CRC
+	TEST_ASSERT_EQ(crc8(msg, 3, 0x80, 0x00), 0x80);
+	TEST_ASSERT_EQ(crc8(msg, 4, 0x80, 0x00), 0x00);
+
+	// Catalogue check values
+	TEST_ASSERT_EQ(crc8(check_msg, 9, 0x07, 0x00), 0xF4);		// CRC-8/SMBUS
+	TEST_ASSERT_EQ(crc8le(check_msg, 9, 0x07, 0xFF), 0xD0);		// CRC-8/ROHC
+	TEST_ASSERT_EQ(crc16(check_msg, 9, 0x1021, 0xFFFF), 0x29B1);	// CRC-16/CCITT-FALSE
+	TEST_ASSERT_EQ(crc16(check_msg, 9, 0x1021, 0x0000), 0x31C3);	// CRC-16/XMODEM
+	TEST_ASSERT_EQ(crc16lsb(check_msg, 9, 0x8408, 0x0000), 0x2189);	// CRC-16/KERMIT
+	TEST_ASSERT_EQ(crc4(check_msg, 9, 0x3, 0xF) ^ 0xF, 0xB);		// CRC-4/INTERLAKEN
+
+	TEST_ASSERT_EQ(crc32lsb(check_msg, 9, 0xEDB88320, 0xFFFFFFFF) ^ 0xFFFFFFFF, 0xCBF43926);	// CRC-32
+	TEST_ASSERT_EQ(crc32(check_msg, 9, 0x04C11DB7, 0xFFFFFFFF), 0x0376E6E7);	// CRC-32/MPEG-2
+	TEST_ASSERT_EQ(crc32(check_msg, 9, 0x814141AB, 0x00000000), 0x3010BF7F);	// CRC-32/AIXM
+
+	// An empty message leaves the init value
+	TEST_ASSERT_EQ(crc16(check_msg, 0, 0x1021, 0xFFFF), 0xFFFF);
+} // static void test_crc(void)
+
+
+
+// Every length around the table and hardware thresholds, more polynomials
+// than there are table slots
+static void check_crc_paths(void)
+{
+	static const uint16_t lengths[] = {0, 1, 3, 4, 5, 31, 32, 33, 63, 255, 256, 257, CRC_LONG_BYTES};
+	static const uint8_t poly8[] = {0x07, 0x31, 0x1D, 0x9B, 0x80};
+	static const uint16_t poly16[] = {0x1021, 0x8005, 0x3D65};
+	unsigned i, k, n;
+
+	for ( i = 0; i < sizeof(lengths)/sizeof(lengths[0]); i++ )
+	{
+		n = lengths[i];
+		for ( k = 0; k < sizeof(poly8); k++ )
+		{
+			TEST_ASSERT_EQ(crc8(long_msg, n, poly8[k], 0x5A), ref_crc(8, 0, poly8[k], 0x5A, long_msg, n));
+			TEST_ASSERT_EQ(crc8le(long_msg, n, poly8[k], 0x5A),
+				ref_crc(8, 1, reverse8(poly8[k]), reverse8(0x5A), long_msg, n));
+		}
+		for ( k = 0; k < sizeof(poly16)/sizeof(poly16[0]); k++ )
+		{
+			TEST_ASSERT_EQ(crc16(long_msg, n, poly16[k], 0x1D0F), ref_crc(16, 0, poly16[k], 0x1D0F, long_msg, n));
+			TEST_ASSERT_EQ(crc16lsb(long_msg, n, reverse32(poly16[k]) >> 16, 0xFFFF),
+				ref_crc(16, 1, reverse32(poly16[k]) >> 16, 0xFFFF, long_msg, n));
+		}
+		TEST_ASSERT_EQ(crc32(long_msg, n, 0x04C11DB7, 0xFFFFFFFF), ref_crc(32, 0, 0x04C11DB7, 0xFFFFFFFF, long_msg, n));
+		TEST_ASSERT_EQ(crc32lsb(long_msg, n, 0xEDB88320, 0xFFFFFFFF), ref_crc(32, 1, 0xEDB88320, 0xFFFFFFFF, long_msg, n));
+		TEST_ASSERT_EQ(crc32lsb(long_msg + 1, n ? n - 1 : 0, 0x82F63B78, 0x12345678),
+			ref_crc(32, 1, 0x82F63B78, 0x12345678, long_msg + 1, n ? n - 1 : 0));
+	}
+} // static void check_crc_paths(void)
+
+
+
+static void test_crc_fast(void)
+{
+	unsigned i;
+
+	for ( i = 0; i < sizeof(long_msg); i++ )
+		long_msg[i] = (uint8_t)(i*131 + (i >> 3));
+
+	// Tables, then the same with the hardware taking the long messages
+	hw_enabled = false;
+	check_crc_paths();
+	hw_enabled = true;
+	hw_calls = 0;
+	check_crc_paths();
+	TEST_ASSERT(hw_calls > 0);
+	hw_enabled = false;
+} // static void test_crc_fast(void)
+
+
+
+static void test_reflect(void)
+{
+	uint8_t bytes[] = {0x01, 0x80, 0x0F};
+	uint8_t nibbles[] = {0x12, 0x8C};
+
+	TEST_ASSERT_EQ(reverse8(0x01), 0x80);
+	TEST_ASSERT_EQ(reverse8(0xA0), 0x05);
+	TEST_ASSERT_EQ(reverse32(0x00000001), 0x80000000);
+	TEST_ASSERT_EQ(reflect4(0x12), 0x84);
+
+	reflect_bytes(bytes, sizeof(bytes));
+	TEST_ASSERT_EQ(bytes[0], 0x80);
+	TEST_ASSERT_EQ(bytes[1], 0x01);
+	TEST_ASSERT_EQ(bytes[2], 0xF0);
+
+	reflect_nibbles(nibbles, sizeof(nibbles));
+	TEST_ASSERT_EQ(nibbles[0], 0x84);
+	TEST_ASSERT_EQ(nibbles[1], 0x13);
+} // static void test_reflect(void)
+
+
+
+static void test_parity_sums(void)
+{
+	uint8_t msg[] = {0x01, 0x02, 0x04, 0xF0};
+
+	TEST_ASSERT_EQ(parity8(0x07), 1);
+	TEST_ASSERT_EQ(parity8(0x03), 0);
+	TEST_ASSERT_EQ(parity_bytes(msg, sizeof(msg)), 1);
+	TEST_ASSERT_EQ(xor_bytes(msg, sizeof(msg)), 0xF7);
+	TEST_ASSERT_EQ(add_bytes(msg, sizeof(msg)), 0xF7);
+	TEST_ASSERT_EQ(add_nibbles(msg, sizeof(msg)), 0x16);
+} // static void test_parity_sums(void)
+
+
+
+static void test_uart(void)
+{
+	// sync-word 0b0 0xff 0b1 0b0 0x33 0b1 (0x33 is 0xcc on the wire)
+	uint8_t uart[] = {0x7f, 0xd9, 0x90};
+	// y0 xff y1 y0 xcc y1 y0 x80 y1 y0 x40 y1 y0 xc0 y1
+	uint8_t uart123[] = {0x07, 0xfd, 0x99, 0x40, 0x48, 0x16, 0x04, 0x00};
+	uint8_t bytes[6] = {0};
+
+	TEST_ASSERT_EQ(extract_bytes_uart(uart, 0, 24, bytes), 2);
+	TEST_ASSERT_EQ(bytes[0], 0xff);
+	TEST_ASSERT_EQ(bytes[1], 0x33);
+
+	TEST_ASSERT_EQ(extract_bytes_uart(uart123, 4, 60, bytes), 5);
+	TEST_ASSERT_EQ(bytes[0], 0xff);
+	TEST_ASSERT_EQ(bytes[1], 0x33);
+	TEST_ASSERT_EQ(bytes[2], 0x01);
+	TEST_ASSERT_EQ(bytes[3], 0x02);
+	TEST_ASSERT_EQ(bytes[4], 0x03);
+} // static void test_uart(void)
+
+
+
+static void test_whitening(void)
+{
+	uint8_t buf1[16] = {0};
+	uint8_t chk1[16] = {0xff, 0x87, 0xb8, 0x59, 0xb7, 0xa1, 0xcc, 0x24, 0x57, 0x5e, 0x4b, 0x9c, 0x0e, 0xe9, 0xea, 0x50};
+	uint8_t buf2[16] = {0};
+	uint8_t chk2[16] = {0xff, 0xe1, 0x1d, 0x9a, 0xed, 0x85, 0x33, 0x24, 0xea, 0x7a, 0xd2, 0x39, 0x70, 0x97, 0x57, 0x0a};
+
+	ccitt_whitening(buf1, sizeof(buf1));
+	TEST_ASSERT_MEM(buf1, chk1, sizeof(buf1));
+
+	ibm_whitening(buf2, sizeof(buf2));
+	TEST_ASSERT_MEM(buf2, chk2, sizeof(buf2));
+} // static void test_whitening(void)
+
+
+
+int main(void)
+{
+	TEST_RUN(test_crc);
+	TEST_RUN(test_crc_fast);
+	TEST_RUN(test_reflect);
+	TEST_RUN(test_parity_sums);
+	TEST_RUN(test_uart);
+	TEST_RUN(test_whitening);
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,172 @@
+/* See COPYING.txt for license details. */
+
+/*
+*
+* test_ble_table.c
+*
+* Unit tests of m1_ble_table.c
+*
+* M1 Project
+*
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include "m1_ble_table.h"
+#include "m1_host_test.h"
+
+static S_M1_Ble_Table table;
+
+static const S_M1_Ble_Dev *feed(const char *line, uint32_t now_ms)
+{
+	S_M1_Ble_Report rep;
+
+	if ( !m1_ble_report_parse(line, &rep) )
+		return NULL;
+	return m1_ble_table_update(&table, &rep, now_ms);
+} // static const S_M1_Ble_Dev *feed(const char *line, uint32_t now_ms)
+
+
+
+static void test_parse(void)
+{
+	S_M1_Ble_Report rep;
+	const uint8_t addr[] = {0xe0, 0x74, 0x5f, 0x8b, 0xa7, 0x61};
+
+	TEST_ASSERT(m1_ble_report_parse("+BLESCAN:\"e0:74:5f:8b:a7:61\",-75,,"
+					"0909427564732050726f10ff750000d1744ef04e80656526000101,1,4", &rep));
+	TEST_ASSERT_MEM(rep.addr, addr, sizeof(addr));
+	TEST_ASSERT_EQ(rep.rssi, -75);
+	TEST_ASSERT_EQ(rep.adv_len, 0);
+	TEST_ASSERT_EQ(rep.rsp_len, 27);
+	TEST_ASSERT_EQ(rep.addr_type, 1);
+	TEST_ASSERT_EQ(rep.adv_type, M1_BLE_ADV_SCAN_RSP);
+
+	// No PDU type from older ESP-AT
+	TEST_ASSERT(m1_ble_report_parse("+BLESCAN:\"C0:F8:53:87:27:00\",-58,0201060303aafe,,0", &rep));
+	TEST_ASSERT_EQ(rep.adv_type, M1_BLE_ADV_IND);
+	TEST_ASSERT_EQ(rep.adv_len, 7);
+
+	TEST_ASSERT(!m1_ble_report_parse("+BLESCANDONE", &rep));
+	TEST_ASSERT(!m1_ble_report_parse("+BLESCAN:\"c0:f8:53:87:27\",-58,,,0,0", &rep));
+	TEST_ASSERT(!m1_ble_report_parse("+BLESCAN:\"c0:f8:53:87:27:00\",-58,02010,,0,0", &rep)); // Odd length
+	TEST_ASSERT(!m1_ble_report_parse("+BLESCAN:\"c0:f8:53:87:27:00\",-58,,,0,7", &rep));
+	TEST_ASSERT(!m1_ble_report_parse("+BLESCAN:\"c0:f8:53:87:27:00\",-58,,", &rep));
+} // static void test_parse(void)
+
+
+
+static void test_dedup_and_stats(void)
+{
+	const S_M1_Ble_Dev *pdev;
+
+	m1_ble_table_init(&table);
+
+	// Advertisement then scan response of the same device
+	pdev = feed("+BLESCAN:\"e0:74:5f:8b:a7:61\",-80,"
+				"0201181bff750042098102141503210149e217012d06bcb09700000000a300,,1,2", 1000);
+	TEST_ASSERT(pdev!=NULL);
+	TEST_ASSERT_EQ(pdev->adv_type, M1_BLE_ADV_SCAN_IND);
+	TEST_ASSERT_EQ(pdev->mfg_len, M1_BLE_MFG_DATA_MAX); // 26 bytes, truncated
+	TEST_ASSERT_EQ(pdev->mfg[0], 0x75); // Samsung, 0x0075 little endian
+	TEST_ASSERT_EQ(pdev->mfg[1], 0x00);
+	TEST_ASSERT_STR(pdev->name, "");
+	TEST_ASSERT(feed("+BLESCAN:\"e0:74:5f:8b:a7:61\",-74,,"
+				"0909427564732050726f10ff750000d1744ef04e80656526000101,1,4", 1500)==pdev);
+	TEST_ASSERT_STR(pdev->name, "Buds Pro");
+	TEST_ASSERT_EQ(pdev->adv_type, M1_BLE_ADV_SCAN_IND); // Kept from the advertisement
+	TEST_ASSERT(pdev->scan_rsp);
+	TEST_ASSERT_EQ(pdev->mfg_len, 15); // The scan response one
+	TEST_ASSERT(feed("+BLESCAN:\"e0:74:5f:8b:a7:61\",-83,,,1,2", 2000)==pdev);
+	TEST_ASSERT_STR(pdev->name, "Buds Pro"); // No AD data, nothing lost
+
+	TEST_ASSERT_EQ(table.count, 1);
+	TEST_ASSERT_EQ(pdev->seen, 3);
+	TEST_ASSERT_EQ(pdev->rssi, -83);
+	TEST_ASSERT_EQ(pdev->rssi_min, -83);
+	TEST_ASSERT_EQ(pdev->rssi_max, -74);
+	TEST_ASSERT_EQ(m1_ble_dev_rssi_avg(pdev), -79); // -237/3
+	TEST_ASSERT_EQ(pdev->first_ms, 1000);
+	TEST_ASSERT_EQ(pdev->last_ms, 2000);
+
+	feed("+BLESCAN:\"c0:f8:53:87:27:00\",-58,,,0,0", 2100);
+	feed("+BLESCAN:\"20:57:9e:2f:55:cf\",-58,,,0,0", 2200);
+	feed("+BLESCAN:\"56:6b:e2:a4:f4:a3\",-67,,,1,3", 2300);
+	TEST_ASSERT_EQ(table.count, 4);
+	TEST_ASSERT_EQ(table.reports, 6);
+} // static void test_dedup_and_stats(void)
+
+
+
+static void test_sort(void)
+{
+	uint8_t order[M1_BLE_TABLE_SIZE];
+
+	// From test_dedup_and_stats: -83, -58, -58, -67
+	TEST_ASSERT_EQ(m1_ble_table_sort_rssi(&table, order), 4);
+	TEST_ASSERT_EQ(table.dev[order[0]].addr[0], 0x20); // Equal RSSI: by address
+	TEST_ASSERT_EQ(table.dev[order[1]].addr[0], 0xc0);
+	TEST_ASSERT_EQ(table.dev[order[2]].addr[0], 0x56);
+	TEST_ASSERT_EQ(table.dev[order[3]].addr[0], 0xe0);
+} // static void test_sort(void)
+
+
+
+static void test_eviction(void)
+{
+	char line[64];
+	uint8_t addr[M1_BLE_ADDR_LEN] = {0x02, 0, 0, 0, 0, 0};
+	uint16_t i;
+
+	m1_ble_table_init(&table);
+	for (i=0; i<M1_BLE_TABLE_SIZE; i++)
+	{
+		sprintf(line, "+BLESCAN:\"02:00:00:00:00:%02x\",-%u,,,1,3", i, 40 + i%50);
+		TEST_ASSERT(feed(line, 100 + i)!=NULL);
+	}
+	TEST_ASSERT_EQ(table.count, M1_BLE_TABLE_SIZE);
+
+	// Device 0 heard again: device 1 is now the stalest
+	feed("+BLESCAN:\"02:00:00:00:00:00\",-40,,,1,3", 1000);
+	feed("+BLESCAN:\"02:00:00:00:01:00\",-40,,,1,3", 1001);
+	TEST_ASSERT_EQ(table.count, M1_BLE_TABLE_SIZE);
+	TEST_ASSERT_EQ(table.evictions, 1);
+	addr[5] = 1;
+	TEST_ASSERT(m1_ble_table_find(&table, addr)==NULL);
+
+	// Every other device, probe chains included, is still found
+	for (i=0; i<M1_BLE_TABLE_SIZE; i++)
+	{
+		addr[5] = (uint8_t)i;
+		TEST_ASSERT_EQ(m1_ble_table_find(&table, addr)!=NULL, i!=1);
+	}
+	addr[4] = 1;
+	addr[5] = 0;
+	TEST_ASSERT(m1_ble_table_find(&table, addr)!=NULL);
+
+	// Churn through many more devices than fit
+	for (i=0; i<1000; i++)
+	{
+		sprintf(line, "+BLESCAN:\"04:00:00:00:%02x:%02x\",-70,,,1,3", i >> 8, i & 0xFF);
+		feed(line, 2000 + i);
+	}
+	TEST_ASSERT_EQ(table.count, M1_BLE_TABLE_SIZE);
+	for (i=0; i<1000; i++)
+	{
+		uint8_t a[M1_BLE_ADDR_LEN] = {0x04, 0, 0, 0, (uint8_t)(i >> 8), (uint8_t)i};
+
+		TEST_ASSERT_EQ(m1_ble_table_find(&table, a)!=NULL, i >= 1000 - M1_BLE_TABLE_SIZE);
+	}
+} // static void test_eviction(void)
+
+
+
+int main(void)
+{
+	TEST_RUN(test_parse);
+	TEST_RUN(test_dedup_and_stats);
+	TEST_RUN(test_sort);
+	TEST_RUN(test_eviction);
+
+	return TEST_RESULT();
+} // int main(void)
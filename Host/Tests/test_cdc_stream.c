@@ -0,0 +1,244 @@
+/* See COPYING.txt for license details. */
+
+/*
+*
+* test_cdc_stream.c
+*
+* Unit tests of m1_cdc_stream.c
+*
+* M1 Project
+*
+*/
+
+#include "bit_util.h"
+#include "m1_cdc_stream.h"
+#include "m1_host_test.h"
+
+#define FAKE_TX_MAX			8
+
+// Fake USB: records the transfers, completes them when the test says so
+static uint8_t fake_tx_data[FAKE_TX_MAX][CDC_STREAM_BUF_SIZE];
+static uint16_t fake_tx_len[FAKE_TX_MAX];
+static uint8_t *fake_tx_buf[FAKE_TX_MAX];
+static unsigned fake_tx_count;
+static bool fake_tx_busy;
+
+static uint8_t fake_tx(uint8_t *buf, uint16_t len)
+{
+	if ( fake_tx_busy || fake_tx_count >= FAKE_TX_MAX )
+		return 1;
+
+	fake_tx_busy = true;
+	memcpy(fake_tx_data[fake_tx_count], buf, len);
+	fake_tx_len[fake_tx_count] = len;
+	fake_tx_buf[fake_tx_count] = buf;
+	fake_tx_count++;
+
+	return 0;
+} // static uint8_t fake_tx(uint8_t *buf, uint16_t len)
+
+
+
+static void fake_tx_complete(void)
+{
+	fake_tx_busy = false;
+	TEST_ASSERT(m1_cdc_stream_tx_done(fake_tx_buf[fake_tx_count - 1]));
+} // static void fake_tx_complete(void)
+
+
+
+static void stream_reset(S_M1_CdcStream_Source source)
+{
+	fake_tx_count = 0;
+	fake_tx_busy = false;
+	m1_cdc_stream_init(fake_tx);
+	m1_cdc_stream_start(source);
+} // static void stream_reset(S_M1_CdcStream_Source source)
+
+
+
+static uint16_t packet_sample(unsigned packet, unsigned i)
+{
+	const uint8_t *p = &fake_tx_data[packet][sizeof(S_M1_CdcStream_Header) + i*2];
+
+	return (uint16_t)(p[0] | (p[1] << 8));
+} // static uint16_t packet_sample(unsigned packet, unsigned i)
+
+
+
+static void test_packet_format(void)
+{
+	S_M1_CdcStream_Header header;
+	uint16_t crc, len;
+	const uint8_t *p;
+
+	stream_reset(CDC_STREAM_SRC_SUBGHZ);
+	m1_cdc_stream_set_info(433920000);
+	m1_cdc_stream_put(300, true);
+	m1_cdc_stream_put(600, false);
+	m1_cdc_stream_put(0, true); // Ignored
+	TEST_ASSERT_EQ(fake_tx_count, 0); // Held back until flushed
+	m1_cdc_stream_flush(false);
+	TEST_ASSERT_EQ(fake_tx_count, 0);
+	m1_cdc_stream_flush(true);
+	TEST_ASSERT_EQ(fake_tx_count, 1);
+
+	len = fake_tx_len[0];
+	TEST_ASSERT_EQ(len, sizeof(header) + 2*2 + CDC_STREAM_CRC_SIZE);
+	p = fake_tx_data[0];
+	TEST_ASSERT_EQ(p[0], 'M');
+	TEST_ASSERT_EQ(p[1], '1');
+	memcpy(&header, p, sizeof(header));
+	TEST_ASSERT_EQ(header.sync, CDC_STREAM_SYNC);
+	TEST_ASSERT_EQ(header.version, CDC_STREAM_VERSION);
+	TEST_ASSERT_EQ(header.source, CDC_STREAM_SRC_SUBGHZ);
+	TEST_ASSERT_EQ(header.seq, 0);
+	TEST_ASSERT_EQ(header.n_samples, 2);
+	TEST_ASSERT_EQ(header.dropped, 0);
+	TEST_ASSERT_EQ(header.info, 433920000);
+	TEST_ASSERT_EQ(packet_sample(0, 0), CDC_STREAM_LEVEL_BIT | 300);
+	TEST_ASSERT_EQ(packet_sample(0, 1), 600);
+
+	crc = crc16(p, len - CDC_STREAM_CRC_SIZE, 0x1021, 0xFFFF);
+	TEST_ASSERT_EQ(p[len - 2], crc & 0xFF);
+	TEST_ASSERT_EQ(p[len - 1], crc >> 8);
+	// CRC-16/CCITT-FALSE check value, so the host can use any implementation
+	TEST_ASSERT_EQ(crc16((const uint8_t *)"123456789", 9, 0x1021, 0xFFFF), 0x29B1);
+} // static void test_packet_format(void)
+
+
+
+static void test_long_durations(void)
+{
+	stream_reset(CDC_STREAM_SRC_IR);
+	m1_cdc_stream_put(100000, false);
+	m1_cdc_stream_put(CDC_STREAM_DURATION_MAX, true);
+	m1_cdc_stream_flush(true);
+	TEST_ASSERT_EQ(fake_tx_count, 1);
+	TEST_ASSERT_EQ(fake_tx_len[0], sizeof(S_M1_CdcStream_Header) + 5*2 + CDC_STREAM_CRC_SIZE);
+	// 100000 = 3*32767 + 1699, all at the same level
+	TEST_ASSERT_EQ(packet_sample(0, 0), CDC_STREAM_DURATION_MAX);
+	TEST_ASSERT_EQ(packet_sample(0, 1), CDC_STREAM_DURATION_MAX);
+	TEST_ASSERT_EQ(packet_sample(0, 2), CDC_STREAM_DURATION_MAX);
+	TEST_ASSERT_EQ(packet_sample(0, 3), 1699);
+	TEST_ASSERT_EQ(packet_sample(0, 4), CDC_STREAM_LEVEL_BIT | CDC_STREAM_DURATION_MAX);
+} // static void test_long_durations(void)
+
+
+
+static void test_pulses(void)
+{
+	const uint16_t pulses[] = {500, 250, 1000, 750, 125};
+	bool level;
+
+	stream_reset(CDC_STREAM_SRC_SUBGHZ);
+	level = m1_cdc_stream_put_pulses(pulses, 3, true);
+	TEST_ASSERT(!level);
+	level = m1_cdc_stream_put_pulses(&pulses[3], 2, level);
+	TEST_ASSERT(!level);
+	m1_cdc_stream_flush(true);
+	TEST_ASSERT_EQ(packet_sample(0, 0), CDC_STREAM_LEVEL_BIT | 500);
+	TEST_ASSERT_EQ(packet_sample(0, 1), 250);
+	TEST_ASSERT_EQ(packet_sample(0, 2), CDC_STREAM_LEVEL_BIT | 1000);
+	TEST_ASSERT_EQ(packet_sample(0, 3), 750);
+	TEST_ASSERT_EQ(packet_sample(0, 4), CDC_STREAM_LEVEL_BIT | 125);
+} // static void test_pulses(void)
+
+
+
+static void test_double_buffer(void)
+{
+	S_M1_CdcStream_Header header;
+	S_M1_CdcStream_Stats stats;
+	uint32_t i;
+
+	stream_reset(CDC_STREAM_SRC_LFRFID);
+
+	// A full buffer is sent at once, the next one fills meanwhile
+	for ( i = 0; i < CDC_STREAM_SAMPLES_MAX; i++ )
+		m1_cdc_stream_put(i + 1, true);
+	TEST_ASSERT_EQ(fake_tx_count, 1);
+	TEST_ASSERT_EQ(fake_tx_len[0], CDC_STREAM_BUF_SIZE);
+
+	// Both buffers busy: samples are dropped and counted
+	for ( i = 0; i < CDC_STREAM_SAMPLES_MAX + 10; i++ )
+		m1_cdc_stream_put(7, false);
+	TEST_ASSERT_EQ(fake_tx_count, 1);
+	m1_cdc_stream_get_stats(&stats);
+	TEST_ASSERT_EQ(stats.dropped, 10);
+
+	// Transfer done: the full buffer goes out with the next sample
+	fake_tx_complete();
+	m1_cdc_stream_put(9, true);
+	TEST_ASSERT_EQ(fake_tx_count, 2);
+	TEST_ASSERT(fake_tx_buf[1]!=fake_tx_buf[0]);
+	memcpy(&header, fake_tx_data[1], sizeof(header));
+	TEST_ASSERT_EQ(header.seq, 1);
+	TEST_ASSERT_EQ(header.n_samples, CDC_STREAM_SAMPLES_MAX);
+	TEST_ASSERT_EQ(header.dropped, 10);
+
+	fake_tx_complete();
+	m1_cdc_stream_flush(true);
+	TEST_ASSERT_EQ(fake_tx_count, 3);
+	TEST_ASSERT(fake_tx_buf[2]==fake_tx_buf[0]);
+	memcpy(&header, fake_tx_data[2], sizeof(header));
+	TEST_ASSERT_EQ(header.seq, 2);
+	TEST_ASSERT_EQ(header.n_samples, 1);
+
+	m1_cdc_stream_get_stats(&stats);
+	TEST_ASSERT_EQ(stats.packets, 3);
+	TEST_ASSERT_EQ(stats.samples, 2*CDC_STREAM_SAMPLES_MAX + 1);
+
+	// Foreign buffers, e.g. log output, are not taken
+	TEST_ASSERT(!m1_cdc_stream_tx_done(fake_tx_data[0]));
+} // static void test_double_buffer(void)
+
+
+
+static void test_usb_refused(void)
+{
+	S_M1_CdcStream_Stats stats;
+
+	stream_reset(CDC_STREAM_SRC_IR);
+	fake_tx_busy = true; // e.g. a log transfer still on the wire
+	m1_cdc_stream_put(100, true);
+	m1_cdc_stream_flush(true);
+	TEST_ASSERT_EQ(fake_tx_count, 0);
+	m1_cdc_stream_get_stats(&stats);
+	TEST_ASSERT_EQ(stats.tx_errors, 1);
+
+	// The samples were kept for the next try
+	fake_tx_busy = false;
+	m1_cdc_stream_flush(true);
+	TEST_ASSERT_EQ(fake_tx_count, 1);
+	TEST_ASSERT_EQ(packet_sample(0, 0), CDC_STREAM_LEVEL_BIT | 100);
+} // static void test_usb_refused(void)
+
+
+
+static void test_stop(void)
+{
+	stream_reset(CDC_STREAM_SRC_SUBGHZ);
+	TEST_ASSERT_EQ(m1_cdc_stream_source(), CDC_STREAM_SRC_SUBGHZ);
+	TEST_ASSERT_STR(m1_cdc_stream_source_name(CDC_STREAM_SRC_LFRFID), "lfrfid");
+
+	m1_cdc_stream_stop();
+	TEST_ASSERT_EQ(m1_cdc_stream_source(), CDC_STREAM_SRC_NONE);
+	m1_cdc_stream_put(100, true);
+	m1_cdc_stream_flush(true);
+	TEST_ASSERT_EQ(fake_tx_count, 0);
+} // static void test_stop(void)
+
+
+
+int main(void)
+{
+	TEST_RUN(test_packet_format);
+	TEST_RUN(test_long_durations);
+	TEST_RUN(test_pulses);
+	TEST_RUN(test_double_buffer);
+	TEST_RUN(test_usb_refused);
+	TEST_RUN(test_stop);
+
+	return TEST_RESULT();
+} // int main(void)
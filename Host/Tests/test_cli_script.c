@@ -0,0 +1,254 @@
+/* See COPYING.txt for license details. */
+
+/*
+*
+* test_cli_script.c
+*
+* Unit tests of m1_cli_script.c
+*
+* M1 Project
+*
+*/
+
+#include "m1_cli_script.h"
+#include "m1_host_test.h"
+
+// Fake CLI: records the commands, answers "count" with a rising number
+static char fake_cmds[1024];
+static char fake_output[2048];
+static unsigned fake_count;
+static uint32_t fake_slept;
+static unsigned fake_abort_after; // sleep() calls before an abort, 0: never
+static unsigned fake_sleeps;
+
+static void fake_exec(const char *cmd, char *out, size_t out_size)
+{
+	strcat(fake_cmds, cmd);
+	strcat(fake_cmds, ";");
+	if ( strcmp(cmd, "count")==0 )
+		snprintf(out, out_size, "count=%u\r\n", ++fake_count);
+	else if ( strncmp(cmd, "say ", 4)==0 )
+		snprintf(out, out_size, "%s\r\n", cmd + 4);
+	else
+		snprintf(out, out_size, "Command not recognised\r\n");
+} // static void fake_exec(const char *cmd, char *out, size_t out_size)
+
+
+
+static void fake_print(const char *text)
+{
+	TEST_ASSERT(strlen(fake_output) + strlen(text) < sizeof(fake_output));
+	strcat(fake_output, text);
+} // static void fake_print(const char *text)
+
+
+
+static bool fake_sleep(uint32_t ms)
+{
+	fake_slept += ms;
+	fake_sleeps++;
+	return fake_abort_after && fake_sleeps >= fake_abort_after;
+} // static bool fake_sleep(uint32_t ms)
+
+
+
+static uint32_t fake_tick(void)
+{
+	return 1234;
+} // static uint32_t fake_tick(void)
+
+
+
+static const S_M1_CliScript_Ops fake_ops = {fake_exec, fake_print, fake_sleep, fake_tick};
+
+
+
+// Runs a script from a string constant, the interpreter changes the text
+static S_M1_CliScript_Status run(const char *script, S_M1_CliScript_Result *presult)
+{
+	static char text[CLI_SCRIPT_MAX_SIZE + 1];
+
+	fake_cmds[0] = '\0';
+	fake_output[0] = '\0';
+	fake_count = 0;
+	fake_slept = 0;
+	fake_sleeps = 0;
+	strcpy(text, script);
+
+	return m1_cli_script_run(text, strlen(text), &fake_ops, presult);
+} // static S_M1_CliScript_Status run(const char *script, S_M1_CliScript_Result *presult)
+
+
+
+static void test_commands_and_vars(void)
+{
+	S_M1_CliScript_Result result;
+
+	TEST_ASSERT_EQ(run("# soak\r\n"
+					   "set DEV unit1\r\n"
+					   "  say $DEV-${DEV}  \r\n"
+					   "\r\n"
+					   "say $$5 at $TICK\n"
+					   "set N 7\n"
+					   "inc N\n"
+					   "inc N 10\n"
+					   "say $N", &result), CLI_SCRIPT_OK);
+	TEST_ASSERT_STR(fake_cmds, "say unit1-unit1;say $5 at 1234;say 18;");
+	TEST_ASSERT_EQ(result.commands, 3);
+	TEST_ASSERT(strstr(fake_output, "> say unit1-unit1\r\nunit1-unit1\r\n")!=NULL);
+
+	// An unknown variable stops the script at its line
+	TEST_ASSERT_EQ(run("count\nsay $NOPE\ncount\n", &result), CLI_SCRIPT_SYNTAX_ERROR);
+	TEST_ASSERT_EQ(result.line, 2);
+	TEST_ASSERT_STR(fake_cmds, "count;");
+} // static void test_commands_and_vars(void)
+
+
+
+static void test_repeat(void)
+{
+	S_M1_CliScript_Result result;
+
+	TEST_ASSERT_EQ(run("repeat 3 I\n"
+					   "  repeat 2\n"
+					   "    say $I\n"
+					   "  end\n"
+					   "end\n"
+					   "repeat 0\n"
+					   "  count\n"
+					   "end\n"
+					   "say done\n", &result), CLI_SCRIPT_OK);
+	TEST_ASSERT_STR(fake_cmds, "say 1;say 1;say 2;say 2;say 3;say 3;say done;");
+	TEST_ASSERT_EQ(result.commands, 7);
+
+	// Blocks must be closed, and closed only once
+	TEST_ASSERT_EQ(run("count\nrepeat 2\ncount\n", &result), CLI_SCRIPT_SYNTAX_ERROR);
+	TEST_ASSERT_EQ(result.line, 2);
+	TEST_ASSERT_STR(fake_cmds, "");
+	TEST_ASSERT_EQ(run("count\nend", &result), CLI_SCRIPT_SYNTAX_ERROR);
+	TEST_ASSERT_EQ(result.line, 2);
+	TEST_ASSERT_EQ(run("repeat 2\nelse\nend\n", &result), CLI_SCRIPT_SYNTAX_ERROR);
+	TEST_ASSERT_EQ(run("repeat\ncount\nend\n", &result), CLI_SCRIPT_SYNTAX_ERROR);
+	TEST_ASSERT_EQ(result.line, 1);
+} // static void test_repeat(void)
+
+
+
+static void test_checks(void)
+{
+	S_M1_CliScript_Result result;
+
+	TEST_ASSERT_EQ(run("count\n"
+					   "expect \"count=1\"\n"
+					   "reject Error\n"
+					   "echo passed $PASS\n", &result), CLI_SCRIPT_OK);
+	TEST_ASSERT_EQ(result.passed, 2);
+	TEST_ASSERT_EQ(result.failed, 0);
+	TEST_ASSERT(strstr(fake_output, "PASS expect \"count=1\"\r\n")!=NULL);
+	TEST_ASSERT(strstr(fake_output, "passed 2\r\n")!=NULL);
+
+	// A failed check stops the script by default
+	TEST_ASSERT_EQ(run("count\nexpect count=2\ncount\n", &result), CLI_SCRIPT_CHECK_FAILED);
+	TEST_ASSERT_EQ(result.line, 2);
+	TEST_ASSERT_EQ(result.failed, 1);
+	TEST_ASSERT_STR(fake_cmds, "count;");
+	TEST_ASSERT(strstr(fake_output, "FAIL line 2: expect \"count=2\"\r\n")!=NULL);
+
+	// or is counted and the script goes on
+	TEST_ASSERT_EQ(run("onfail continue\n"
+					   "repeat 3\n"
+					   "  count\n"
+					   "  reject count=2\n"
+					   "end\n", &result), CLI_SCRIPT_OK);
+	TEST_ASSERT_EQ(result.passed, 2);
+	TEST_ASSERT_EQ(result.failed, 1);
+	TEST_ASSERT_EQ(result.line, 4);
+} // static void test_checks(void)
+
+
+
+static void test_if_else(void)
+{
+	S_M1_CliScript_Result result;
+
+	TEST_ASSERT_EQ(run("repeat 3\n"
+					   "  count\n"
+					   "  if count=2\n"
+					   "    say two\n"
+					   "  else\n"
+					   "    ifnot count=3\n"
+					   "      say one\n"
+					   "    end\n"
+					   "  end\n"
+					   "end\n", &result), CLI_SCRIPT_OK);
+	TEST_ASSERT_STR(fake_cmds, "count;say one;count;say two;count;");
+
+	TEST_ASSERT_EQ(run("say a\nif a\nexit\nend\nsay b\n", &result), CLI_SCRIPT_OK);
+	TEST_ASSERT_STR(fake_cmds, "say a;");
+	TEST_ASSERT_EQ(run("if a\nelse\nelse\nend\n", &result), CLI_SCRIPT_SYNTAX_ERROR);
+	TEST_ASSERT_EQ(result.line, 3);
+} // static void test_if_else(void)
+
+
+
+static void test_sleep_and_abort(void)
+{
+	S_M1_CliScript_Result result;
+
+	fake_abort_after = 0;
+	TEST_ASSERT_EQ(run("sleep 250\nrepeat 2\nsleep 100\nend\n", &result), CLI_SCRIPT_OK);
+	TEST_ASSERT_EQ(fake_slept, 450);
+
+	// Commands poll for an abort too
+	fake_abort_after = 3;
+	TEST_ASSERT_EQ(run("repeat 10\ncount\nend\n", &result), CLI_SCRIPT_ABORTED);
+	TEST_ASSERT_EQ(result.commands, 3);
+	fake_abort_after = 0;
+} // static void test_sleep_and_abort(void)
+
+
+
+static void test_limits(void)
+{
+	static char text[CLI_SCRIPT_MAX_SIZE + 1];
+	S_M1_CliScript_Result result;
+	char line[CLI_SCRIPT_LINE_SIZE + 16];
+
+	memset(text, '\n', sizeof(text));
+	TEST_ASSERT_EQ(m1_cli_script_run(text, sizeof(text), &fake_ops, &result), CLI_SCRIPT_TOO_LARGE);
+	TEST_ASSERT_EQ(m1_cli_script_run(text, CLI_SCRIPT_MAX_LINES + 1, &fake_ops, &result), CLI_SCRIPT_TOO_LARGE);
+	TEST_ASSERT_EQ(m1_cli_script_run(text, CLI_SCRIPT_MAX_LINES, &fake_ops, &result), CLI_SCRIPT_OK);
+
+	// The line does not fit after the substitution
+	memset(line, 'x', sizeof(line));
+	memcpy(line, "say $L", 6);
+	line[CLI_SCRIPT_LINE_SIZE - 20] = '\0';
+	snprintf(text, sizeof(text), "set L 0123456789012345678901234567890123456789\n%s\n", line);
+	TEST_ASSERT_EQ(run(text, &result), CLI_SCRIPT_SYNTAX_ERROR);
+	TEST_ASSERT_EQ(result.line, 2);
+
+	// A full size script without a newline at the end: its last line ends at text[len]
+	memset(text, 'x', sizeof(text));
+	text[0] = '#';
+	memcpy(&text[CLI_SCRIPT_MAX_SIZE - 8], "\nsay end", 8);
+	fake_cmds[0] = '\0';
+	TEST_ASSERT_EQ(m1_cli_script_run(text, CLI_SCRIPT_MAX_SIZE, &fake_ops, &result), CLI_SCRIPT_OK);
+	TEST_ASSERT_STR(fake_cmds, "say end;");
+	TEST_ASSERT_EQ(text[CLI_SCRIPT_MAX_SIZE], '\0');
+
+	TEST_ASSERT_STR(m1_cli_script_status_text(CLI_SCRIPT_CHECK_FAILED), "check failed");
+} // static void test_limits(void)
+
+
+
+int main(void)
+{
+	TEST_RUN(test_commands_and_vars);
+	TEST_RUN(test_repeat);
+	TEST_RUN(test_checks);
+	TEST_RUN(test_if_else);
+	TEST_RUN(test_sleep_and_abort);
+	TEST_RUN(test_limits);
+
+	return TEST_RESULT();
+} // int main(void)
@@ -0,0 +1,111 @@
+/* See COPYING.txt for license details. */
+
+/*
+*
+* test_compositor.c
+*
+* Unit tests of m1_compositor.c
+*
+* M1 Project
+*
+*/
+
+#include "m1_compositor.h"
+#include "m1_host_test.h"
+
+#define FRAME_MS		50
+
+static void test_first_frame(void)
+{
+	S_M1_Compositor comp;
+	uint8_t param = 0;
+
+	m1_compositor_init(&comp, FRAME_MS);
+	TEST_ASSERT_EQ(m1_compositor_due_in(&comp, 1000), UINT32_MAX);
+	TEST_ASSERT(!m1_compositor_take(&comp, 1000, &param));
+
+	// Nothing drawn yet: the first frame goes at once
+	TEST_ASSERT(m1_compositor_invalidate(&comp, 3, 1000));
+	TEST_ASSERT(m1_compositor_take(&comp, 1000, &param));
+	TEST_ASSERT_EQ(param, 3);
+	TEST_ASSERT_EQ(m1_compositor_due_in(&comp, 1000), UINT32_MAX);
+	TEST_ASSERT(!m1_compositor_take(&comp, 1000, &param));
+} // static void test_first_frame(void)
+
+
+
+static void test_coalesce(void)
+{
+	S_M1_Compositor comp;
+	uint8_t param = 0;
+	uint32_t t;
+
+	m1_compositor_init(&comp, FRAME_MS);
+	m1_compositor_invalidate(&comp, 1, 0);
+	m1_compositor_take(&comp, 0, &param);
+
+	// A burst of data events, one every 2 ms: no frame until the interval is over
+	for ( t = 2; t < FRAME_MS; t += 2 )
+	{
+		TEST_ASSERT(!m1_compositor_invalidate(&comp, 1, t));
+		TEST_ASSERT_EQ(m1_compositor_due_in(&comp, t), FRAME_MS - t);
+		TEST_ASSERT(!m1_compositor_take(&comp, t, &param));
+	}
+	m1_compositor_invalidate(&comp, 2, FRAME_MS - 1); // The last one wins
+
+	TEST_ASSERT(m1_compositor_take(&comp, FRAME_MS, &param));
+	TEST_ASSERT_EQ(param, 2);
+	TEST_ASSERT_EQ(comp.requests, 26);
+	TEST_ASSERT_EQ(comp.frames, 2);
+
+	// Late timer: the frame is still due, the next interval starts from it
+	m1_compositor_invalidate(&comp, 1, FRAME_MS + 10);
+	TEST_ASSERT(m1_compositor_take(&comp, 3*FRAME_MS, &param));
+	TEST_ASSERT(!m1_compositor_invalidate(&comp, 1, 3*FRAME_MS + 1));
+	TEST_ASSERT(m1_compositor_invalidate(&comp, 1, 4*FRAME_MS));
+} // static void test_coalesce(void)
+
+
+
+static void test_direct_frames(void)
+{
+	S_M1_Compositor comp;
+	uint8_t param = 0;
+
+	m1_compositor_init(&comp, FRAME_MS);
+
+	// A key press draws the screen: the pending frame is dropped
+	m1_compositor_frame_done(&comp, 100);
+	TEST_ASSERT(!m1_compositor_invalidate(&comp, 1, 110));
+	m1_compositor_frame_done(&comp, 120);
+	TEST_ASSERT_EQ(m1_compositor_due_in(&comp, 130), UINT32_MAX);
+	TEST_ASSERT(!m1_compositor_take(&comp, 200, &param));
+
+	// And it starts a new interval
+	TEST_ASSERT(!m1_compositor_invalidate(&comp, 1, 130));
+	TEST_ASSERT_EQ(m1_compositor_due_in(&comp, 130), 40);
+
+	// A screen switch cancels
+	m1_compositor_cancel(&comp);
+	TEST_ASSERT(!m1_compositor_take(&comp, 500, &param));
+	TEST_ASSERT_EQ(comp.frames, 0);
+	TEST_ASSERT_EQ(comp.direct_frames, 2);
+
+	// Tick counter wrap
+	m1_compositor_frame_done(&comp, UINT32_MAX - 9);
+	TEST_ASSERT(!m1_compositor_invalidate(&comp, 4, 20));
+	TEST_ASSERT_EQ(m1_compositor_due_in(&comp, 20), 20);
+	TEST_ASSERT(m1_compositor_take(&comp, 40, &param));
+	TEST_ASSERT_EQ(param, 4);
+} // static void test_direct_frames(void)
+
+
+
+int main(void)
+{
+	TEST_RUN(test_first_frame);
+	TEST_RUN(test_coalesce);
+	TEST_RUN(test_direct_frames);
+
+	return TEST_RESULT();
+} // int main(void)
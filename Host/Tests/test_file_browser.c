@@ -0,0 +1,199 @@
+/* See COPYING.txt for license details. */
+
+/*
+*
+* test_file_browser.c
+*
+* Unit tests of the directory cache of m1_file_browser.c
+*
+* M1 Project
+*
+*/
+
+#include <limits.h>
+#include <stdio.h>
+#include "ff.h"
+#include "main.h"
+#include "m1_file_browser.h"
+#include "m1_host.h"
+#include "m1_sdcard.h"
+#include "m1_host_test.h"
+
+#define TEST_DIR		"0:/fb_test"
+
+// Empties the test directory left by an earlier run, sub-directories must be empty
+static void clear_test_dir(void)
+{
+	DIR dir;
+	FILINFO fno;
+	char path[FF_MAX_LFN + 16];
+
+	f_mkdir(TEST_DIR);
+	TEST_ASSERT_EQ(f_opendir(&dir, TEST_DIR), FR_OK);
+	while ( f_readdir(&dir, &fno)==FR_OK && fno.fname[0] )
+	{
+		snprintf(path, sizeof(path), "%s/%s", TEST_DIR, fno.fname);
+		TEST_ASSERT_EQ(f_unlink(path), FR_OK);
+	}
+	f_closedir(&dir);
+} // static void clear_test_dir(void)
+
+
+
+static void make_file(const char *name)
+{
+	FIL fil;
+	UINT bw;
+	char path[FF_MAX_LFN + 16];
+
+	snprintf(path, sizeof(path), "%s/%s", TEST_DIR, name);
+	TEST_ASSERT_EQ(f_open(&fil, path, FA_CREATE_ALWAYS | FA_WRITE), FR_OK);
+	TEST_ASSERT_EQ(f_write(&fil, "x", 1, &bw), FR_OK);
+	f_close(&fil);
+} // static void make_file(const char *name)
+
+
+
+static void make_dir(const char *name)
+{
+	char path[FF_MAX_LFN + 16];
+
+	snprintf(path, sizeof(path), "%s/%s", TEST_DIR, name);
+	TEST_ASSERT_EQ(f_mkdir(path), FR_OK);
+} // static void make_dir(const char *name)
+
+
+
+static void test_name_order(void)
+{
+	TEST_ASSERT(m1_fb_name_cmp("capture_9.sub", "capture_10.sub") < 0);
+	TEST_ASSERT(m1_fb_name_cmp("capture_10.sub", "capture_9.sub") > 0);
+	TEST_ASSERT(m1_fb_name_cmp("Remote", "remote_2") < 0);
+	TEST_ASSERT(m1_fb_name_cmp("ABC", "abd") < 0);
+	TEST_ASSERT(m1_fb_name_cmp("v1.10", "v1.9") > 0);
+	TEST_ASSERT(m1_fb_name_cmp("a", "a0") < 0);
+	TEST_ASSERT(m1_fb_name_cmp("99999999999999999999", "100000000000000000000") < 0);
+
+	// Names that only differ in zeros or case still have an order
+	TEST_ASSERT(m1_fb_name_cmp("x7", "x007") < 0);
+	TEST_ASSERT(m1_fb_name_cmp("x007", "x7") > 0);
+	TEST_ASSERT(m1_fb_name_cmp("Tv", "tv") < 0);
+	TEST_ASSERT_EQ(m1_fb_name_cmp("tv.ir", "tv.ir"), 0);
+} // static void test_name_order(void)
+
+
+
+static void test_sorted_listing(void)
+{
+	static const char *expected[] = {"alpha", "Zeta", "Cap_2.sub", "cap_9.sub", "cap_10.sub", "readme", "tag.nfc"};
+	BYTE attrib;
+	uint16_t i;
+
+	clear_test_dir();
+	make_file("cap_10.sub");
+	make_dir("Zeta");
+	make_file("readme");
+	make_file("cap_9.sub");
+	make_dir("alpha");
+	make_file("Cap_2.sub");
+	make_file("tag.nfc");
+	make_file("tag.nfb"); // Sidecar, not listed
+
+	TEST_ASSERT_EQ(m1_fb_dir_cache_load(TEST_DIR), FR_OK);
+	TEST_ASSERT_EQ(m1_fb_dir_cache_count(), 7);
+	TEST_ASSERT(!m1_fb_dir_cache_truncated());
+	for ( i = 0; i < 7; i++ )
+		TEST_ASSERT_STR(m1_fb_dir_cache_entry(i, NULL), expected[i]);
+	m1_fb_dir_cache_entry(1, &attrib);
+	TEST_ASSERT(attrib & AM_DIR);
+	m1_fb_dir_cache_entry(2, &attrib);
+	TEST_ASSERT(!(attrib & AM_DIR));
+	TEST_ASSERT(m1_fb_dir_cache_entry(7, &attrib)==NULL);
+
+	TEST_ASSERT(m1_fb_dir_cache_load("0:/fb_test_missing")!=FR_OK);
+	TEST_ASSERT_EQ(m1_fb_dir_cache_count(), 0);
+} // static void test_sorted_listing(void)
+
+
+
+static void test_invalidation(void)
+{
+	char path[PATH_MAX];
+	FILE *file;
+
+	clear_test_dir();
+	make_file("one");
+	TEST_ASSERT_EQ(m1_fb_dir_cache_load(TEST_DIR), FR_OK);
+	TEST_ASSERT_EQ(m1_fb_dir_cache_count(), 1);
+
+	// A file made behind FatFs is not seen while the cache is valid
+	TEST_ASSERT(m1_host_sd_map_path(TEST_DIR "/two", path, sizeof(path)));
+	file = fopen(path, "wb");
+	TEST_ASSERT(file!=NULL);
+	fclose(file);
+	TEST_ASSERT_EQ(m1_fb_dir_cache_load(TEST_DIR), FR_OK);
+	TEST_ASSERT_EQ(m1_fb_dir_cache_count(), 1);
+
+	m1_fb_dir_cache_invalidate();
+	TEST_ASSERT_EQ(m1_fb_dir_cache_load(TEST_DIR), FR_OK);
+	TEST_ASSERT_EQ(m1_fb_dir_cache_count(), 2);
+
+	// Writes anywhere on the card and remounts are seen
+	make_file("three");
+	TEST_ASSERT_EQ(m1_fb_dir_cache_load(TEST_DIR), FR_OK);
+	TEST_ASSERT_EQ(m1_fb_dir_cache_count(), 3);
+	TEST_ASSERT_EQ(f_unlink(TEST_DIR "/one"), FR_OK);
+	TEST_ASSERT_EQ(m1_fb_dir_cache_load(TEST_DIR), FR_OK);
+	TEST_ASSERT_EQ(m1_fb_dir_cache_count(), 2);
+	TEST_ASSERT_STR(m1_fb_dir_cache_entry(0, NULL), "three");
+
+	TEST_ASSERT(m1_host_sd_map_path(TEST_DIR "/four", path, sizeof(path)));
+	file = fopen(path, "wb");
+	fclose(file);
+	m1_sdcard_unmount();
+	m1_sdcard_mount();
+	TEST_ASSERT_EQ(m1_fb_dir_cache_load(TEST_DIR), FR_OK);
+	TEST_ASSERT_EQ(m1_fb_dir_cache_count(), 3);
+} // static void test_invalidation(void)
+
+
+
+static void test_truncated(void)
+{
+	char name[32];
+	const char *prev;
+	uint16_t i;
+
+	clear_test_dir();
+	for ( i = 0; i < 600; i++ )
+	{
+		snprintf(name, sizeof(name), "capture_%u.sub", 599 - i);
+		make_file(name);
+	}
+
+	TEST_ASSERT_EQ(m1_fb_dir_cache_load(TEST_DIR), FR_OK);
+	TEST_ASSERT(m1_fb_dir_cache_truncated());
+	TEST_ASSERT(m1_fb_dir_cache_count() > 96 && m1_fb_dir_cache_count() < 600);
+
+	// What fits is still in order
+	prev = m1_fb_dir_cache_entry(0, NULL);
+	for ( i = 1; i < m1_fb_dir_cache_count(); i++ )
+	{
+		TEST_ASSERT(m1_fb_name_cmp(prev, m1_fb_dir_cache_entry(i, NULL)) < 0);
+		prev = m1_fb_dir_cache_entry(i, NULL);
+	}
+
+	clear_test_dir();
+} // static void test_truncated(void)
+
+
+
+int main(void)
+{
+	TEST_RUN(test_name_order);
+	TEST_RUN(test_sorted_listing);
+	TEST_RUN(test_invalidation);
+	TEST_RUN(test_truncated);
+
+	return TEST_RESULT();
+} // int main(void)
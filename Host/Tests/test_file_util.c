@@ -0,0 +1,161 @@
+/* See COPYING.txt for license details. */
+
+/*
+*
+* test_file_util.c
+*
+* Unit tests of m1_file_util.c and of the fake SD card the host build
+* runs the file modules on
+*
+* M1 Project
+*
+*/
+
+#include <stdlib.h>
+#include "ff.h"
+#include "m1_file_util.h"
+#include "m1_host_test.h"
+
+static void test_path_helpers(void)
+{
+	char buf[64];
+
+	TEST_ASSERT_STR(fu_get_file_extension("0:/IR/tv.ir"), "ir");
+	TEST_ASSERT_STR(fu_get_file_extension("archive.tar.gz"), "gz");
+	TEST_ASSERT(fu_get_file_extension("no_extension")==NULL);
+	TEST_ASSERT(fu_get_file_extension(".hidden")==NULL);
+
+	TEST_ASSERT_STR(fu_get_filename("0:/RFID/12345678.rfid"), "12345678.rfid");
+	TEST_ASSERT_STR(fu_get_filename("C:\\folder\\test.txt"), "test.txt");
+	TEST_ASSERT_STR(fu_get_filename("plain"), "plain");
+
+	fu_get_filename_without_ext("0:/NFC/card.nfc", buf, sizeof(buf));
+	TEST_ASSERT_STR(buf, "card");
+	fu_get_filename_without_ext("no_extension", buf, sizeof(buf));
+	TEST_ASSERT_STR(buf, "no_extension");
+	fu_get_filename_without_ext("0:/a/long_name.txt", buf, 5);
+	TEST_ASSERT_STR(buf, "long");
+
+	fu_get_directory_path("0:/RFID/12345678.rfid", buf, sizeof(buf));
+	TEST_ASSERT_STR(buf, "0:/RFID");
+	fu_get_directory_path("plain", buf, sizeof(buf));
+	TEST_ASSERT_STR(buf, "");
+
+	fu_path_combine(buf, sizeof(buf), "0:/data", "test.txt");
+	TEST_ASSERT_STR(buf, "0:/data/test.txt");
+	fu_path_combine(buf, sizeof(buf), "0:/data/", "test.txt");
+	TEST_ASSERT_STR(buf, "0:/data/test.txt");
+	fu_path_combine(buf, sizeof(buf), "0:/data", "/logs/out.txt");
+	TEST_ASSERT_STR(buf, "/logs/out.txt");
+	fu_path_combine(buf, sizeof(buf), NULL, "readme.md");
+	TEST_ASSERT_STR(buf, "readme.md");
+	fu_path_combine(buf, sizeof(buf), "0:/bin", NULL);
+	TEST_ASSERT_STR(buf, "0:/bin");
+	fu_path_combine(buf, 10, "0:/data", "test.txt");
+	TEST_ASSERT_STR(buf, "0:/data/t");
+} // static void test_path_helpers(void)
+
+
+
+static void test_exists(void)
+{
+	f_unlink("0:/fu/file.txt");
+	f_unlink("0:/fu");
+
+	TEST_ASSERT_EQ(fs_directory_exists("0:/fu"), 0);
+	TEST_ASSERT_EQ(fs_directory_ensure("0:/fu"), FR_OK);
+	TEST_ASSERT_EQ(fs_directory_ensure("0:/fu"), FR_OK);
+	TEST_ASSERT_EQ(fs_directory_exists("0:/fu"), 1);
+	TEST_ASSERT_EQ(fs_file_exists("0:/fu"), -1);
+
+	TEST_ASSERT_EQ(fs_file_exists("0:/fu/file.txt"), 0);
+	TEST_ASSERT(test_write_file("0:/fu/file.txt", "hello"));
+	TEST_ASSERT_EQ(fs_file_exists("0:/fu/file.txt"), 1);
+	TEST_ASSERT_EQ(fs_directory_exists("0:/fu/file.txt"), -1);
+	TEST_ASSERT_EQ(fs_directory_ensure("0:/fu/file.txt"), FR_EXIST);
+} // static void test_exists(void)
+
+
+
+static void test_free_space(void)
+{
+	uint64_t free_bytes = 0;
+
+	TEST_ASSERT_EQ(fs_get_free_space(&free_bytes), FR_OK);
+	TEST_ASSERT(free_bytes > 0);
+} // static void test_free_space(void)
+
+
+
+static void test_sdcard_ops(void)
+{
+	FIL f;
+	FILINFO fno;
+	DIR dir;
+	UINT n;
+	char buf[32];
+	int found;
+
+	fs_directory_ensure("0:/fu");
+	TEST_ASSERT(test_write_file("0:/fu/a.txt", "0123456789"));
+
+	// Append and size
+	TEST_ASSERT_EQ(f_open(&f, "0:/fu/a.txt", FA_OPEN_APPEND | FA_WRITE), FR_OK);
+	TEST_ASSERT_EQ(f_tell(&f), 10);
+	TEST_ASSERT_EQ(f_puts("ab", &f), 2);
+	TEST_ASSERT_EQ(f_size(&f), 12);
+	TEST_ASSERT_EQ(f_close(&f), FR_OK);
+
+	// Seek and read back
+	TEST_ASSERT_EQ(f_open(&f, "0:/fu/a.txt", FA_READ), FR_OK);
+	TEST_ASSERT_EQ(f_lseek(&f, 8), FR_OK);
+	TEST_ASSERT_EQ(f_read(&f, buf, sizeof(buf), &n), FR_OK);
+	TEST_ASSERT_EQ(n, 4);
+	TEST_ASSERT_MEM(buf, "89ab", 4);
+	TEST_ASSERT(f_eof(&f));
+	TEST_ASSERT_EQ(f_close(&f), FR_OK);
+
+	// Rename refuses an existing target
+	TEST_ASSERT(test_write_file("0:/fu/b.txt", "b"));
+	TEST_ASSERT_EQ(f_rename("0:/fu/a.txt", "0:/fu/b.txt"), FR_EXIST);
+	TEST_ASSERT_EQ(f_unlink("0:/fu/b.txt"), FR_OK);
+	TEST_ASSERT_EQ(f_rename("0:/fu/a.txt", "0:/fu/b.txt"), FR_OK);
+	TEST_ASSERT_EQ(f_stat("0:/fu/b.txt", &fno), FR_OK);
+	TEST_ASSERT_EQ(fno.fsize, 12);
+	TEST_ASSERT_EQ(f_stat("0:/fu/a.txt", &fno), FR_NO_FILE);
+
+	// Pattern search is case insensitive like FatFs
+	TEST_ASSERT_EQ(f_findfirst(&dir, &fno, "0:/fu", "*.TXT"), FR_OK);
+	found = 0;
+	while ( fno.fname[0] )
+	{
+		found++;
+		TEST_ASSERT_EQ(f_findnext(&dir, &fno), FR_OK);
+	}
+	TEST_ASSERT_EQ(found, 2);
+	f_closedir(&dir);
+
+	// Plain directory listing
+	TEST_ASSERT_EQ(f_opendir(&dir, "0:/fu"), FR_OK);
+	found = 0;
+	while ( f_readdir(&dir, &fno)==FR_OK && fno.fname[0] )
+		found++;
+	TEST_ASSERT_EQ(found, 2);
+	TEST_ASSERT_EQ(f_closedir(&dir), FR_OK);
+
+	TEST_ASSERT_EQ(f_unlink("0:/fu/b.txt"), FR_OK);
+	TEST_ASSERT_EQ(f_unlink("0:/fu/missing.txt"), FR_NO_FILE);
+	TEST_ASSERT_EQ(f_open(&f, "0:/fu/missing.txt", FA_READ), FR_NO_FILE);
+} // static void test_sdcard_ops(void)
+
+
+
+int main(void)
+{
+	TEST_RUN(test_path_helpers);
+	TEST_RUN(test_exists);
+	TEST_RUN(test_free_space);
+	TEST_RUN(test_sdcard_ops);
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,164 @@
+/* See COPYING.txt for license details. */
+
+/*
+*
+* test_freertos_port.c
+*
+* Tests of the POSIX FreeRTOS port: delays, queues between tasks,
+* preemption by a higher priority task and timers.
+*
+* M1 Project
+*
+*/
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "timers.h"
+#include "stream_buffer.h"
+#include "m1_host.h"
+#include "m1_host_test.h"
+
+#define PING_COUNT			100
+#define WORKER_STACK_SIZE	configMINIMAL_STACK_SIZE
+
+static QueueHandle_t ping_q, pong_q;
+static volatile uint32_t timer_hits;
+static volatile bool high_prio_ran;
+
+static void pong_task(void *param)
+{
+	uint32_t val;
+
+	(void)param;
+	for ( ;; )
+	{
+		xQueueReceive(ping_q, &val, portMAX_DELAY);
+		val++;
+		xQueueSend(pong_q, &val, portMAX_DELAY);
+	}
+} // static void pong_task(void *param)
+
+
+
+static void high_prio_task(void *param)
+{
+	(void)param;
+	high_prio_ran = true;
+	vTaskDelete(NULL);
+} // static void high_prio_task(void *param)
+
+
+
+static void timer_cb(TimerHandle_t timer)
+{
+	(void)timer;
+	timer_hits++;
+} // static void timer_cb(TimerHandle_t timer)
+
+
+
+static void test_delay(void)
+{
+	TickType_t start, elapsed;
+
+	start = xTaskGetTickCount();
+	vTaskDelay(pdMS_TO_TICKS(50));
+	elapsed = xTaskGetTickCount() - start;
+	TEST_ASSERT(elapsed >= pdMS_TO_TICKS(50));
+	TEST_ASSERT(elapsed < pdMS_TO_TICKS(500));
+} // static void test_delay(void)
+
+
+
+static void test_queue_ping_pong(void)
+{
+	TaskHandle_t pong_hdl;
+	uint32_t i, val;
+
+	ping_q = xQueueCreate(4, sizeof(uint32_t));
+	pong_q = xQueueCreate(4, sizeof(uint32_t));
+	TEST_ASSERT(xTaskCreate(pong_task, "pong", WORKER_STACK_SIZE, NULL, tskIDLE_PRIORITY + 1, &pong_hdl)==pdPASS);
+
+	for ( i = 0; i < PING_COUNT; i++ )
+	{
+		xQueueSend(ping_q, &i, portMAX_DELAY);
+		TEST_ASSERT(xQueueReceive(pong_q, &val, pdMS_TO_TICKS(1000))==pdTRUE);
+		if ( val!=i + 1 )
+		{
+			TEST_ASSERT_EQ(val, i + 1);
+			break;
+		}
+	} // for ( i = 0; i < PING_COUNT; i++ )
+
+	// Timeout on an empty queue
+	TEST_ASSERT(xQueueReceive(pong_q, &val, pdMS_TO_TICKS(20))==pdFALSE);
+
+	vTaskDelete(pong_hdl);
+	vQueueDelete(ping_q);
+	vQueueDelete(pong_q);
+} // static void test_queue_ping_pong(void)
+
+
+
+static void test_preemption(void)
+{
+	high_prio_ran = false;
+	// A higher priority task runs before xTaskCreate returns
+	xTaskCreate(high_prio_task, "high", WORKER_STACK_SIZE, NULL, uxTaskPriorityGet(NULL) + 1, NULL);
+	TEST_ASSERT(high_prio_ran);
+} // static void test_preemption(void)
+
+
+
+static void test_timer(void)
+{
+	TimerHandle_t timer;
+
+	timer_hits = 0;
+	timer = xTimerCreate("t", pdMS_TO_TICKS(10), pdTRUE, NULL, timer_cb);
+	xTimerStart(timer, 0);
+	vTaskDelay(pdMS_TO_TICKS(105));
+	xTimerStop(timer, 0);
+	TEST_ASSERT(timer_hits >= 5);
+	TEST_ASSERT(timer_hits <= 11);
+	xTimerDelete(timer, 0);
+} // static void test_timer(void)
+
+
+
+static void test_stream_buffer(void)
+{
+	StreamBufferHandle_t sb;
+	uint8_t in[32], out[32];
+	size_t i;
+
+	for ( i = 0; i < sizeof(in); i++ )
+		in[i] = (uint8_t)i;
+	sb = xStreamBufferCreate(64, 1);
+	TEST_ASSERT_EQ(xStreamBufferSend(sb, in, sizeof(in), 0), sizeof(in));
+	TEST_ASSERT_EQ(xStreamBufferReceive(sb, out, sizeof(out), 0), sizeof(out));
+	TEST_ASSERT_MEM(out, in, sizeof(in));
+	vStreamBufferDelete(sb);
+} // static void test_stream_buffer(void)
+
+
+
+static void run_tests(void *param)
+{
+	(void)param;
+	TEST_RUN(test_delay);
+	TEST_RUN(test_queue_ping_pong);
+	TEST_RUN(test_preemption);
+	TEST_RUN(test_timer);
+	TEST_RUN(test_stream_buffer);
+} // static void run_tests(void *param)
+
+
+
+int main(void)
+{
+	m1_host_run_task(run_tests, NULL, tskIDLE_PRIORITY + 2);
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,244 @@
+/* See COPYING.txt for license details. */
+
+/*
+*
+* test_i2c_queue.c
+*
+* Unit tests of m1_i2c_queue.c
+*
+* M1 Project
+*
+*/
+
+#include <string.h>
+#include "m1_i2c_queue.h"
+#include "m1_host_test.h"
+
+#define MAX_STARTED		16
+
+static uint16_t started[MAX_STARTED]; // reg_address of every transfer begun
+static uint8_t n_started;
+static HAL_StatusTypeDef start_result;
+static uint8_t n_finished;
+static S_M1_I2C_Batch *chained; // Submitted by done_chain
+
+static HAL_StatusTypeDef fake_start(S_M1_I2C_Trans_Inf *ptrans)
+{
+	TEST_ASSERT(n_started < MAX_STARTED);
+	started[n_started++] = ptrans->reg_address;
+
+	return start_result;
+} // static HAL_StatusTypeDef fake_start(S_M1_I2C_Trans_Inf *ptrans)
+
+
+
+static void fake_finished(S_M1_I2C_Batch *pbatch)
+{
+	TEST_ASSERT(!pbatch->busy);
+	n_finished++;
+} // static void fake_finished(S_M1_I2C_Batch *pbatch)
+
+
+
+static void done_chain(S_M1_I2C_Batch *pbatch)
+{
+	(void)pbatch;
+	TEST_ASSERT_EQ(m1_i2c_queue_submit(chained), HAL_OK);
+} // static void done_chain(S_M1_I2C_Batch *pbatch)
+
+
+
+static void setup(S_M1_I2C_Batch *pbatch, S_M1_I2C_Trans_Inf *ptrans, uint8_t count, uint16_t first_reg)
+{
+	uint8_t i;
+
+	memset(pbatch, 0, sizeof(*pbatch));
+	memset(ptrans, 0, count*sizeof(*ptrans));
+	for ( i = 0; i < count; i++ )
+		ptrans[i].reg_address = first_reg + i;
+	pbatch->trans = ptrans;
+	pbatch->count = count;
+} // static void setup(S_M1_I2C_Batch *pbatch, S_M1_I2C_Trans_Inf *ptrans, uint8_t count, uint16_t first_reg)
+
+
+
+static void reset(void)
+{
+	m1_i2c_queue_init(fake_start, fake_finished);
+	n_started = 0;
+	n_finished = 0;
+	start_result = HAL_OK;
+	chained = NULL;
+} // static void reset(void)
+
+
+
+static void test_order(void)
+{
+	S_M1_I2C_Batch a, b;
+	S_M1_I2C_Trans_Inf ta[3], tb[2];
+
+	reset();
+	setup(&a, ta, 3, 0x10);
+	setup(&b, tb, 2, 0x20);
+
+	// Only the first transfer starts, the second batch waits its turn
+	TEST_ASSERT_EQ(m1_i2c_queue_submit(&a), HAL_OK);
+	TEST_ASSERT_EQ(m1_i2c_queue_submit(&b), HAL_OK);
+	TEST_ASSERT_EQ(n_started, 1);
+	TEST_ASSERT(m1_i2c_queue_active()==&a);
+	TEST_ASSERT_EQ(m1_i2c_queue_submit(&a), HAL_BUSY);
+
+	m1_i2c_queue_complete(HAL_OK);
+	m1_i2c_queue_complete(HAL_OK);
+	TEST_ASSERT(a.busy);
+	TEST_ASSERT_EQ(a.n_done, 2);
+	m1_i2c_queue_complete(HAL_OK);
+	TEST_ASSERT(!a.busy);
+	TEST_ASSERT_EQ(a.status, HAL_OK);
+	TEST_ASSERT_EQ(n_finished, 1);
+	TEST_ASSERT(m1_i2c_queue_active()==&b);
+
+	m1_i2c_queue_complete(HAL_OK);
+	m1_i2c_queue_complete(HAL_OK);
+	TEST_ASSERT(!b.busy);
+	TEST_ASSERT_EQ(n_finished, 2);
+	TEST_ASSERT(m1_i2c_queue_active()==NULL);
+
+	{
+		const uint16_t expect[] = {0x10, 0x11, 0x12, 0x20, 0x21};
+		TEST_ASSERT_EQ(n_started, 5);
+		TEST_ASSERT_MEM(started, expect, sizeof(expect));
+	}
+
+	// A stray completion with nothing in flight is ignored
+	m1_i2c_queue_complete(HAL_OK);
+	TEST_ASSERT_EQ(n_finished, 2);
+} // static void test_order(void)
+
+
+
+static void test_errors(void)
+{
+	S_M1_I2C_Batch a, b, c;
+	S_M1_I2C_Trans_Inf ta[3], tb[2], tc[1];
+
+	reset();
+	setup(&a, ta, 3, 0x10);
+	setup(&b, tb, 2, 0x20);
+	setup(&c, tc, 1, 0x30);
+
+	// A failed transfer ends its batch, the next batch still runs
+	m1_i2c_queue_submit(&a);
+	m1_i2c_queue_submit(&b);
+	m1_i2c_queue_complete(HAL_OK);
+	m1_i2c_queue_complete(HAL_ERROR);
+	TEST_ASSERT(!a.busy);
+	TEST_ASSERT_EQ(a.status, HAL_ERROR);
+	TEST_ASSERT_EQ(a.n_done, 2);
+	TEST_ASSERT(m1_i2c_queue_active()==&b);
+	TEST_ASSERT_EQ(started[n_started - 1], 0x20);
+
+	// A transfer that cannot start fails its batch and moves on
+	start_result = HAL_BUSY;
+	m1_i2c_queue_complete(HAL_OK);
+	TEST_ASSERT(!b.busy);
+	TEST_ASSERT_EQ(b.status, HAL_BUSY);
+	TEST_ASSERT(m1_i2c_queue_active()==NULL);
+
+	m1_i2c_queue_submit(&c);
+	TEST_ASSERT(!c.busy);
+	TEST_ASSERT_EQ(c.status, HAL_BUSY);
+	TEST_ASSERT_EQ(n_finished, 3);
+} // static void test_errors(void)
+
+
+
+static void test_cancel(void)
+{
+	S_M1_I2C_Batch a, b, c;
+	S_M1_I2C_Trans_Inf ta[2], tb[2], tc[2];
+
+	reset();
+	setup(&a, ta, 2, 0x10);
+	setup(&b, tb, 2, 0x20);
+	setup(&c, tc, 2, 0x30);
+	m1_i2c_queue_submit(&a);
+	m1_i2c_queue_submit(&b);
+	m1_i2c_queue_submit(&c);
+
+	// A waiting batch leaves the queue without touching the bus
+	TEST_ASSERT(!m1_i2c_queue_cancel(&b, HAL_TIMEOUT));
+	TEST_ASSERT(!b.busy);
+	TEST_ASSERT_EQ(b.status, HAL_TIMEOUT);
+	TEST_ASSERT_EQ(n_started, 1);
+	TEST_ASSERT(!m1_i2c_queue_cancel(&b, HAL_TIMEOUT));
+
+	// The active batch reports its transfer was in flight, the last one starts
+	TEST_ASSERT(m1_i2c_queue_cancel(&a, HAL_TIMEOUT));
+	TEST_ASSERT_EQ(a.status, HAL_TIMEOUT);
+	TEST_ASSERT(m1_i2c_queue_active()==&c);
+	TEST_ASSERT_EQ(started[n_started - 1], 0x30);
+
+	// The completion of the cancelled transfer must not count for c
+	m1_i2c_queue_complete(HAL_OK);
+	m1_i2c_queue_complete(HAL_OK);
+	TEST_ASSERT(!c.busy);
+	TEST_ASSERT_EQ(c.status, HAL_OK);
+	TEST_ASSERT_EQ(n_finished, 3);
+
+	// The tail can be cancelled and the queue still appends after it
+	m1_i2c_queue_submit(&a);
+	m1_i2c_queue_submit(&b);
+	m1_i2c_queue_cancel(&b, HAL_ERROR);
+	m1_i2c_queue_submit(&c);
+	m1_i2c_queue_complete(HAL_OK);
+	m1_i2c_queue_complete(HAL_OK);
+	TEST_ASSERT(m1_i2c_queue_active()==&c);
+} // static void test_cancel(void)
+
+
+
+static void test_chain_and_empty(void)
+{
+	S_M1_I2C_Batch a, b, empty;
+	S_M1_I2C_Trans_Inf ta[1], tb[2];
+
+	reset();
+	setup(&a, ta, 1, 0x10);
+	setup(&b, tb, 2, 0x20);
+	setup(&empty, NULL, 0, 0);
+
+	// An empty batch finishes at once
+	TEST_ASSERT_EQ(m1_i2c_queue_submit(&empty), HAL_OK);
+	TEST_ASSERT(!empty.busy);
+	TEST_ASSERT_EQ(empty.status, HAL_OK);
+	TEST_ASSERT_EQ(n_started, 0);
+
+	// A done callback may queue the next batch, which starts right away
+	a.done = done_chain;
+	chained = &b;
+	m1_i2c_queue_submit(&a);
+	m1_i2c_queue_complete(HAL_OK);
+	TEST_ASSERT(!a.busy);
+	TEST_ASSERT(b.busy);
+	TEST_ASSERT_EQ(n_started, 2);
+	TEST_ASSERT_EQ(started[1], 0x20);
+	m1_i2c_queue_complete(HAL_OK);
+	m1_i2c_queue_complete(HAL_OK);
+	TEST_ASSERT(!b.busy);
+	TEST_ASSERT_EQ(n_started, 3);
+	TEST_ASSERT_EQ(n_finished, 3);
+} // static void test_chain_and_empty(void)
+
+
+
+int main(void)
+{
+	TEST_RUN(test_order);
+	TEST_RUN(test_errors);
+	TEST_RUN(test_cancel);
+	TEST_RUN(test_chain_and_empty);
+
+	return TEST_RESULT();
+} // int main(void)
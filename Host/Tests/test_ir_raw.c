@@ -0,0 +1,156 @@
+/* See COPYING.txt for license details. */
+
+/*
+*
+* test_ir_raw.c
+*
+* Unit tests of m1_ir_raw.c: capture buffer and .ir raw file save/load on
+* the fake SD card
+*
+* M1 Project
+*
+*/
+
+#include "ff.h"
+#include "m1_ir_raw.h"
+#include "m1_infrared.h"
+#include "m1_host_test.h"
+
+#define TEST_IR_DIR			"0:/IR"
+#define TEST_IR_FILE		TEST_IR_DIR "/raw_test.ir"
+
+static S_IR_Raw_t raw, loaded;
+
+// Offset of the value of the "data:" key
+static uint32_t find_data_offset(const char *path)
+{
+	char line[64];
+	uint32_t offset = 0, pos;
+	FIL f;
+
+	if ( f_open(&f, path, FA_OPEN_EXISTING | FA_READ)!=FR_OK )
+		return 0;
+	pos = (uint32_t)f_tell(&f);
+	while ( f_gets(line, sizeof(line), &f)!=NULL )
+	{
+		if ( !strncmp(line, "data:", 5) )
+		{
+			offset = pos + 5;
+			break;
+		}
+		pos = (uint32_t)f_tell(&f);
+	}
+	f_close(&f);
+
+	return offset;
+} // static uint32_t find_data_offset(const char *path)
+
+static void test_capture(void)
+{
+	ir_raw_reset(&raw);
+	TEST_ASSERT_EQ(raw.frequency, IR_RAW_FREQ_DEFAULT);
+
+	// Leading space is dropped, equal levels are merged
+	TEST_ASSERT(ir_raw_add(&raw, 500, false));
+	TEST_ASSERT_EQ(raw.count, 0);
+	ir_raw_add(&raw, 9000, true);
+	ir_raw_add(&raw, 4500, false);
+	ir_raw_add(&raw, 560, true);
+	ir_raw_add(&raw, 60, true);
+	TEST_ASSERT_EQ(raw.count, 3);
+	TEST_ASSERT_EQ(raw.ota[2] & IR_OTA_SPACE_BIT_MASK, 620);
+	TEST_ASSERT(raw.ota[2] & IR_OTA_PULSE_BIT_MASK);
+
+	// Too short to be a signal
+	TEST_ASSERT(!ir_raw_finish(&raw));
+
+	ir_raw_add(&raw, 560, false);
+	ir_raw_add(&raw, 560, true);
+	ir_raw_add(&raw, 1690, false);
+	ir_raw_add(&raw, 560, true);
+	ir_raw_add(&raw, 100000, false); // end gap, split over two OTA entries
+	TEST_ASSERT_EQ(raw.count, 9);
+	TEST_ASSERT(ir_raw_finish(&raw));
+	TEST_ASSERT_EQ(raw.count, 7);
+	TEST_ASSERT_EQ(ir_raw_edge_count(&raw), 7);
+	TEST_ASSERT_EQ(raw.ota[raw.count], 0);
+} // static void test_capture(void)
+
+
+
+static void test_long_period(void)
+{
+	ir_raw_reset(&raw);
+	ir_raw_add(&raw, 200000, true);
+	// 200 ms do not fit into one 16-bit entry
+	TEST_ASSERT_EQ(raw.count, 4);
+	TEST_ASSERT_EQ(ir_raw_edge_count(&raw), 1);
+} // static void test_long_period(void)
+
+
+
+static void test_truncate(void)
+{
+	uint32_t i;
+
+	ir_raw_reset(&raw);
+	for ( i = 0; i < IR_RAW_EDGES_MAX; i++ )
+		TEST_ASSERT(ir_raw_add(&raw, 500, (i & 1)==0));
+	TEST_ASSERT(!ir_raw_add(&raw, 500, true));
+	TEST_ASSERT(raw.truncated);
+	TEST_ASSERT_EQ(raw.count, IR_RAW_EDGES_MAX);
+} // static void test_truncate(void)
+
+
+
+static void test_save_load(void)
+{
+	static const uint32_t periods[] = {9000, 4500, 560, 560, 560, 1690, 560, 70000, 560};
+	FILINFO fno;
+	uint32_t i, offset;
+
+	ir_raw_reset(&raw);
+	raw.frequency = 36000;
+	raw.duty_pct = 25;
+	for ( i = 0; i < sizeof(periods)/sizeof(periods[0]); i++ )
+		ir_raw_add(&raw, periods[i], (i & 1)==0);
+	TEST_ASSERT(ir_raw_finish(&raw));
+
+	f_mkdir(TEST_IR_DIR);
+	TEST_ASSERT(ir_raw_save(TEST_IR_FILE, "Power", &raw));
+	TEST_ASSERT(f_stat(TEST_IR_FILE, &fno)==FR_OK);
+
+	offset = find_data_offset(TEST_IR_FILE);
+	TEST_ASSERT(offset > 0);
+	TEST_ASSERT(ir_raw_load(TEST_IR_FILE, offset, 36000, 25, &loaded));
+	TEST_ASSERT_EQ(loaded.frequency, 36000);
+	TEST_ASSERT_EQ(loaded.duty_pct, 25);
+	TEST_ASSERT_EQ(loaded.count, raw.count);
+	TEST_ASSERT_MEM(loaded.ota, raw.ota, raw.count*sizeof(raw.ota[0]));
+
+	TEST_ASSERT(!ir_raw_load("0:/IR/missing.ir", 0, 0, 0, &loaded));
+} // static void test_save_load(void)
+
+
+
+static void test_parse_duty(void)
+{
+	TEST_ASSERT_EQ(ir_raw_parse_duty("0.330000"), 33);
+	TEST_ASSERT_EQ(ir_raw_parse_duty(" 0.5"), 50);
+	TEST_ASSERT_EQ(ir_raw_parse_duty("0.25"), 25);
+	TEST_ASSERT_EQ(ir_raw_parse_duty("1"), IR_RAW_DUTY_DEFAULT);
+	TEST_ASSERT_EQ(ir_raw_parse_duty("x"), IR_RAW_DUTY_DEFAULT);
+} // static void test_parse_duty(void)
+
+
+
+int main(void)
+{
+	TEST_RUN(test_capture);
+	TEST_RUN(test_long_period);
+	TEST_RUN(test_truncate);
+	TEST_RUN(test_save_load);
+	TEST_RUN(test_parse_duty);
+
+	return TEST_RESULT();
+}
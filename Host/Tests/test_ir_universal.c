@@ -0,0 +1,144 @@
+/* See COPYING.txt for license details. */
+
+/*
+*
+* test_ir_universal.c
+*
+* Unit tests of the .ir file parser of m1_ir_universal.c
+*
+* M1 Project
+*
+*/
+
+#include <stdlib.h>
+#include "ff.h"
+#include "m1_ir_universal.h"
+#include "m1_infrared.h"
+#include "m1_ir_raw.h"
+#include "m1_host_test.h"
+
+#define TEST_IR_DIR			"0:/IR"
+#define TEST_IR_FILE		TEST_IR_DIR "/tv.ir"
+
+// Raw "data:" line longer than the parser's line buffer
+#define TEST_RAW_PAIRS		40
+
+static S_IR_Device_t device;
+static S_IR_Raw_t raw;
+
+static void make_ir_file(void)
+{
+	static char content[2048];
+	int len, i;
+
+	len = snprintf(content, sizeof(content),
+		"Filetype: IR signals file\n"
+		"Version: 1\n"
+		"# \n"
+		"name: Power\n"
+		"type: parsed\n"
+		"protocol: NEC\n"
+		"address: 07 00 00 00\n"
+		"command: 02 00 00 00\n"
+		"# \n"
+		"name: Vol_up\r\n"
+		"type: parsed\r\n"
+		"protocol: Samsung32\r\n"
+		"address: 07 07 00 00\r\n"
+		"command: 07 00 00 00\r\n"
+		"# \n"
+		"name: Unsupported\n"
+		"type: parsed\n"
+		"protocol: NoSuchProtocol\n"
+		"address: 01 00 00 00\n"
+		"command: 01 00 00 00\n"
+		"# \n"
+		"name: Input\n"
+		"type: raw\n"
+		"frequency: 40000\n"
+		"duty_cycle: 0.500000\n"
+		"data:");
+	for ( i = 0; i < TEST_RAW_PAIRS; i++ )
+		len += snprintf(&content[len], sizeof(content) - len, " %d %d", 500 + i, 1500 + i);
+	snprintf(&content[len], sizeof(content) - len,
+		"\n"
+		"# \n"
+		"name: Mute\n"
+		"type: parsed\n"
+		"protocol: RC5\n"
+		"address: 00 00 00 00\n"
+		"command: 0D 00 00 00\n");
+
+	f_mkdir(TEST_IR_DIR);
+	TEST_ASSERT(test_write_file(TEST_IR_FILE, content));
+} // static void make_ir_file(void)
+
+
+
+static void test_proto_to_id(void)
+{
+	TEST_ASSERT_EQ(ir_universal_proto_to_id("NEC"), IRMP_NEC_PROTOCOL);
+	TEST_ASSERT_EQ(ir_universal_proto_to_id("Samsung32"), IRMP_SAMSUNG32_PROTOCOL);
+	TEST_ASSERT_EQ(ir_universal_proto_to_id("RC5"), IRMP_RC5_PROTOCOL);
+	TEST_ASSERT_EQ(ir_universal_proto_to_id("nec"), IRMP_UNKNOWN_PROTOCOL);
+} // static void test_proto_to_id(void)
+
+
+
+static void test_parse(void)
+{
+	make_ir_file();
+
+	TEST_ASSERT_EQ(ir_universal_parse_file(TEST_IR_FILE, &device), 4);
+	TEST_ASSERT_EQ(device.count, 4);
+
+	TEST_ASSERT_STR(device.cmds[0].name, "Power");
+	TEST_ASSERT_EQ(device.cmds[0].irmp.protocol, IRMP_NEC_PROTOCOL);
+	TEST_ASSERT_EQ(device.cmds[0].irmp.address, 0x0007);
+	TEST_ASSERT_EQ(device.cmds[0].irmp.command, 0x0002);
+
+	// CRLF line endings
+	TEST_ASSERT_STR(device.cmds[1].name, "Vol_up");
+	TEST_ASSERT_EQ(device.cmds[1].irmp.protocol, IRMP_SAMSUNG32_PROTOCOL);
+	TEST_ASSERT_EQ(device.cmds[1].irmp.address, 0x0707);
+
+	TEST_ASSERT_STR(device.cmds[2].name, "Input");
+	TEST_ASSERT(device.cmds[2].is_raw);
+	TEST_ASSERT_EQ(device.cmds[2].raw_freq, 40000);
+	TEST_ASSERT_EQ(device.cmds[2].raw_duty, 50);
+
+	// The block after the long raw line is still found
+	TEST_ASSERT_STR(device.cmds[3].name, "Mute");
+	TEST_ASSERT_EQ(device.cmds[3].irmp.protocol, IRMP_RC5_PROTOCOL);
+	TEST_ASSERT_EQ(device.cmds[3].irmp.command, 0x000D);
+
+	TEST_ASSERT_EQ(ir_universal_parse_file("0:/IR/missing.ir", &device), 0);
+} // static void test_parse(void)
+
+
+
+static void test_raw_offset(void)
+{
+	const S_IR_Cmd_t *cmd;
+
+	make_ir_file();
+	TEST_ASSERT_EQ(ir_universal_parse_file(TEST_IR_FILE, &device), 4);
+	cmd = &device.cmds[2];
+
+	TEST_ASSERT(ir_raw_load(TEST_IR_FILE, cmd->raw_offset, cmd->raw_freq, cmd->raw_duty, &raw));
+	TEST_ASSERT_EQ(raw.frequency, 40000);
+	TEST_ASSERT_EQ(ir_raw_edge_count(&raw), TEST_RAW_PAIRS*2 - 1); // trailing space dropped
+	TEST_ASSERT_EQ(raw.ota[0] & IR_OTA_SPACE_BIT_MASK, 500);
+	TEST_ASSERT_EQ(raw.ota[1] & IR_OTA_SPACE_BIT_MASK, 1500);
+} // static void test_raw_offset(void)
+
+
+
+int main(void)
+{
+	TEST_RUN(test_proto_to_id);
+	TEST_RUN(test_parse);
+	TEST_RUN(test_raw_offset);
+
+	return TEST_RESULT();
+}
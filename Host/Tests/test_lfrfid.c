@@ -0,0 +1,187 @@
+/* See COPYING.txt for license details. */
+
+/*
+*
+* test_lfrfid.c
+*
+* Unit tests of the EM4100 frame builder and decoders, fed with the edge
+* stream the capture timer would deliver for a synthesised tag
+*
+* M1 Project
+*
+*/
+
+#include <stdlib.h>
+#include "main.h"
+#include "lfrfid.h"
+#include "m1_host_test.h"
+
+// Edges per lfrfid_decoder_execute() call; the decoder doubles full
+// periods, so this must stay well below FRAME_CHUNK_SIZE/2
+#define TEST_CHUNK_EDGES	20
+#define TEST_EDGES_MAX		(FRAME_BITS*2*3)
+
+static const uint8_t test_uid[EM4100_DECODED_DATA_SIZE] = {0x12, 0x34, 0x56, 0x78, 0x9A};
+
+static lfrfid_evt_t edges[TEST_EDGES_MAX];
+
+/*
+ * Manchester encodes repeats x frame as the reader sees it: one event per
+ * level change, t_us is the time the level was held, edge the level after
+ * it. jitter_pct alternately stretches and shrinks each period.
+ */
+static uint16_t make_edges(const uint8_t frame[8], uint16_t half_us, uint8_t repeats, uint8_t jitter_pct)
+{
+	uint16_t n = 0, run = 0, bit, i;
+	uint8_t level = 2, half, v;
+	int32_t t;
+
+	for ( i = 0; i < repeats; i++ )
+	{
+		for ( bit = 0; bit < FRAME_BITS; bit++ )
+		{
+			v = (frame[bit >> 3] >> (7 - (bit & 7))) & 1;
+			for ( half = 0; half < 2; half++ )
+			{
+				uint8_t l = half ? !v : v; // 1 = [HIGH, LOW]
+				if ( l!=level && run )
+				{
+					t = (int32_t)run*half_us;
+					t += ((n & 1) ? -1 : 1)*t*jitter_pct/100;
+					edges[n].t_us = (uint16_t)t;
+					edges[n].edge = !level;
+					n++;
+					run = 0;
+				}
+				level = l;
+				run++;
+			}
+		}
+	}
+
+	return n;
+} // static uint16_t make_edges(const uint8_t frame[8], uint16_t half_us, uint8_t repeats, uint8_t jitter_pct)
+
+
+
+static bool feed(uint16_t protocol, uint16_t count)
+{
+	uint16_t i, chunk;
+
+	for ( i = 0; i < count; i += chunk )
+	{
+		chunk = (count - i > TEST_CHUNK_EDGES) ? TEST_CHUNK_EDGES : count - i;
+		if ( lfrfid_decoder_execute(protocol, &edges[i], (uint8_t)chunk) )
+			return true;
+	}
+
+	return false;
+} // static bool feed(uint16_t protocol, uint16_t count)
+
+
+
+static void test_build_frame(void)
+{
+	uint8_t frame[8], nibs[10];
+
+	em4100_uid_bytes_to_nibbles(test_uid, sizeof(test_uid), nibs);
+	TEST_ASSERT_EQ(nibs[0], 0x1);
+	TEST_ASSERT_EQ(nibs[9], 0xA);
+
+	// Short UIDs are right aligned
+	em4100_uid_bytes_to_nibbles(&test_uid[3], 2, nibs);
+	TEST_ASSERT_EQ(nibs[5], 0x0);
+	TEST_ASSERT_EQ(nibs[6], 0x7);
+	TEST_ASSERT_EQ(nibs[9], 0xA);
+
+	em4100_build_frame8_from_uid(frame, test_uid, sizeof(test_uid));
+	// 9 bit preamble, nibble 1 with even parity 1
+	TEST_ASSERT_EQ(frame[0], 0xFF);
+	TEST_ASSERT_EQ(frame[1] >> 2, 0x23);
+	// stop bit
+	TEST_ASSERT_EQ(frame[7] & 1, 0);
+} // static void test_build_frame(void)
+
+
+
+static void test_decode(uint16_t protocol, uint16_t half_us, uint8_t jitter_pct)
+{
+	uint8_t frame[8];
+	uint16_t n;
+
+	em4100_build_frame8_from_uid(frame, test_uid, sizeof(test_uid));
+	n = make_edges(frame, half_us, 3, jitter_pct);
+
+	memset(lfrfid_tag_info.uid, 0, sizeof(lfrfid_tag_info.uid));
+	lfrfid_decoder_begin();
+	TEST_ASSERT(feed(protocol, n));
+	TEST_ASSERT_MEM(lfrfid_tag_info.uid, test_uid, sizeof(test_uid));
+	TEST_ASSERT_EQ(lfrfid_tag_info.bitrate, half_us/4);
+} // static void test_decode(uint16_t protocol, uint16_t half_us, uint8_t jitter_pct)
+
+
+
+static void test_decode_rates(void)
+{
+	test_decode(LFRFIDProtocolEM4100, T_256_US, 0);
+	test_decode(LFRFIDProtocolEM4100, T_256_US, 10);
+	test_decode(LFRFIDProtocolEM4100_32, T_128_US, 0);
+	test_decode(LFRFIDProtocolEM4100_16, T_64_US, 5);
+} // static void test_decode_rates(void)
+
+
+
+static void test_reject(void)
+{
+	uint8_t frame[8];
+	uint16_t n;
+
+	// Column parity broken
+	em4100_build_frame8_from_uid(frame, test_uid, sizeof(test_uid));
+	frame[7] ^= 0x02;
+	n = make_edges(frame, T_256_US, 3, 0);
+	lfrfid_decoder_begin();
+	TEST_ASSERT(!feed(LFRFIDProtocolEM4100, n));
+
+	// Wrong data rate
+	em4100_build_frame8_from_uid(frame, test_uid, sizeof(test_uid));
+	n = make_edges(frame, T_64_US, 3, 0);
+	lfrfid_decoder_begin();
+	TEST_ASSERT(!feed(LFRFIDProtocolEM4100, n));
+
+	TEST_ASSERT(!lfrfid_decoder_execute(LFRFIDProtocolMax, edges, 1));
+} // static void test_reject(void)
+
+
+
+static void test_protocol_info(void)
+{
+	LFRFID_TAG_INFO a, b;
+
+	TEST_ASSERT_STR(protocol_get_name(LFRFIDProtocolEM4100), "EM4100");
+	TEST_ASSERT_STR(protocol_get_name(LFRFIDProtocolH10301), "H10301");
+	TEST_ASSERT_EQ(protocol_get_data_size(LFRFIDProtocolEM4100), EM4100_DECODED_DATA_SIZE);
+
+	memset(&a, 0, sizeof(a));
+	a.protocol = LFRFIDProtocolEM4100;
+	memcpy(a.uid, test_uid, sizeof(test_uid));
+	b = a;
+	TEST_ASSERT(lfrfid_write_verify(&a, &b));
+	b.uid[4] ^= 1;
+	TEST_ASSERT(!lfrfid_write_verify(&a, &b));
+	b = a;
+	b.protocol = LFRFIDProtocolEM4100_32;
+	TEST_ASSERT(!lfrfid_write_verify(&a, &b));
+} // static void test_protocol_info(void)
+
+
+
+int main(void)
+{
+	TEST_RUN(test_build_frame);
+	TEST_RUN(test_decode_rates);
+	TEST_RUN(test_reject);
+	TEST_RUN(test_protocol_info);
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,90 @@
+/* See COPYING.txt for license details. */
+
+/*
+*
+* test_mem_pool.c
+*
+* Unit tests of m1_mem_pool.c
+*
+* M1 Project
+*
+*/
+
+#include "m1_mem_pool.h"
+#include "m1_host_test.h"
+
+#define POOL_BLOCK_SIZE		20
+#define POOL_BLOCKS			4
+
+M1_MEM_POOL_STORAGE(pool_storage, POOL_BLOCK_SIZE, POOL_BLOCKS);
+
+static void test_alloc_free(void)
+{
+	S_M1_MemPool pool;
+	void *blocks[POOL_BLOCKS];
+	uint16_t i;
+
+	m1_mem_pool_init(&pool, pool_storage, POOL_BLOCK_SIZE, POOL_BLOCKS);
+	TEST_ASSERT_EQ(pool.block_size, M1_MEM_POOL_BLOCK_SIZE(POOL_BLOCK_SIZE));
+	TEST_ASSERT_EQ(pool.n_free, POOL_BLOCKS);
+
+	for ( i = 0; i < POOL_BLOCKS; i++ )
+	{
+		blocks[i] = m1_mem_pool_alloc(&pool);
+		TEST_ASSERT(blocks[i]!=NULL);
+		TEST_ASSERT(m1_mem_pool_owns(&pool, blocks[i]));
+		TEST_ASSERT_EQ((uintptr_t)blocks[i] % M1_MEM_POOL_ALIGN, 0);
+		memset(blocks[i], 0xA5, POOL_BLOCK_SIZE);
+	}
+	TEST_ASSERT_EQ(pool.n_free, 0);
+	TEST_ASSERT_EQ(pool.min_free, 0);
+
+	// Exhausted pool
+	TEST_ASSERT(m1_mem_pool_alloc(&pool)==NULL);
+	TEST_ASSERT_EQ(pool.alloc_fails, 1);
+
+	m1_mem_pool_free(&pool, blocks[2]);
+	TEST_ASSERT_EQ(pool.n_free, 1);
+	TEST_ASSERT(m1_mem_pool_alloc(&pool)==blocks[2]);
+
+	for ( i = 0; i < POOL_BLOCKS; i++ )
+		m1_mem_pool_free(&pool, blocks[i]);
+	TEST_ASSERT_EQ(pool.n_free, POOL_BLOCKS);
+	TEST_ASSERT_EQ(pool.min_free, 0);
+
+	// NULL is ignored like free(NULL)
+	m1_mem_pool_free(&pool, NULL);
+	TEST_ASSERT_EQ(pool.n_free, POOL_BLOCKS);
+} // static void test_alloc_free(void)
+
+
+
+static void test_calloc_owns(void)
+{
+	S_M1_MemPool pool;
+	static const uint8_t zero[POOL_BLOCK_SIZE];
+	uint8_t *block, other;
+
+	m1_mem_pool_init(&pool, pool_storage, POOL_BLOCK_SIZE, POOL_BLOCKS);
+	block = m1_mem_pool_alloc(&pool);
+	memset(block, 0xFF, POOL_BLOCK_SIZE);
+	m1_mem_pool_free(&pool, block);
+
+	block = m1_mem_pool_calloc(&pool);
+	TEST_ASSERT(block!=NULL);
+	TEST_ASSERT_MEM(block, zero, POOL_BLOCK_SIZE);
+
+	TEST_ASSERT(!m1_mem_pool_owns(&pool, &other));
+	TEST_ASSERT(!m1_mem_pool_owns(&pool, block + 1));
+	TEST_ASSERT(!m1_mem_pool_owns(&pool, pool_storage + sizeof(pool_storage)));
+} // static void test_calloc_owns(void)
+
+
+
+int main(void)
+{
+	TEST_RUN(test_alloc_free);
+	TEST_RUN(test_calloc_owns);
+
+	return TEST_RESULT();
+}
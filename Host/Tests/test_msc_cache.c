@@ -0,0 +1,267 @@
+/* See COPYING.txt for license details. */
+
+/*
+*
+* test_msc_cache.c
+*
+* Unit tests of m1_msc_cache.c
+*
+* M1 Project
+*
+*/
+
+#include "m1_msc_cache.h"
+#include "m1_host_test.h"
+
+#define FAKE_CARD_BLOCKS		200
+
+// Fake SD card: counts the transfers, fails them when the test says so
+static uint8_t fake_card[FAKE_CARD_BLOCKS][MSC_CACHE_BLOCK_SIZE];
+static unsigned fake_reads, fake_writes;
+static uint16_t fake_last_len;
+static bool fake_fail;
+
+static int8_t fake_read(uint8_t *buf, uint32_t blk_addr, uint16_t blk_len)
+{
+	TEST_ASSERT(blk_addr + blk_len <= FAKE_CARD_BLOCKS);
+	fake_reads++;
+	fake_last_len = blk_len;
+	if ( fake_fail )
+		return -1;
+	memcpy(buf, fake_card[blk_addr], (size_t)blk_len*MSC_CACHE_BLOCK_SIZE);
+	return 0;
+} // static int8_t fake_read(uint8_t *buf, uint32_t blk_addr, uint16_t blk_len)
+
+
+
+static int8_t fake_write(uint8_t *buf, uint32_t blk_addr, uint16_t blk_len)
+{
+	TEST_ASSERT(blk_addr + blk_len <= FAKE_CARD_BLOCKS);
+	fake_writes++;
+	fake_last_len = blk_len;
+	if ( fake_fail )
+		return -1;
+	memcpy(fake_card[blk_addr], buf, (size_t)blk_len*MSC_CACHE_BLOCK_SIZE);
+	return 0;
+} // static int8_t fake_write(uint8_t *buf, uint32_t blk_addr, uint16_t blk_len)
+
+
+
+static void cache_reset(void)
+{
+	uint32_t i;
+
+	for ( i = 0; i < FAKE_CARD_BLOCKS; i++ )
+		memset(fake_card[i], (uint8_t)i, MSC_CACHE_BLOCK_SIZE);
+	fake_reads = 0;
+	fake_writes = 0;
+	fake_fail = false;
+	m1_msc_cache_init(fake_read, fake_write);
+	m1_msc_cache_set_capacity(FAKE_CARD_BLOCKS);
+} // static void cache_reset(void)
+
+
+
+static void test_read_ahead(void)
+{
+	uint8_t block[MSC_CACHE_BLOCK_SIZE];
+	S_M1_MscCache_Stats stats;
+	uint32_t i;
+
+	cache_reset();
+
+	// A transfer starts with a short read-ahead, then whole windows
+	for ( i = 0; i < 8 + MSC_CACHE_RA_BLOCKS; i++ )
+	{
+		TEST_ASSERT_EQ(m1_msc_cache_read(block, 10 + i, 1), 0);
+		TEST_ASSERT_EQ(block[0], (uint8_t)(10 + i));
+		TEST_ASSERT_EQ(block[MSC_CACHE_BLOCK_SIZE - 1], (uint8_t)(10 + i));
+	}
+	TEST_ASSERT_EQ(fake_reads, 2);
+	TEST_ASSERT_EQ(fake_last_len, MSC_CACHE_RA_BLOCKS);
+
+	m1_msc_cache_get_stats(&stats);
+	TEST_ASSERT_EQ(stats.reads, 8 + MSC_CACHE_RA_BLOCKS);
+	TEST_ASSERT_EQ(stats.read_hits, 8 + MSC_CACHE_RA_BLOCKS - 2);
+	TEST_ASSERT_EQ(stats.sd_reads, 2);
+
+	// A scattered read only fetches the short window
+	TEST_ASSERT_EQ(m1_msc_cache_read(block, 150, 1), 0);
+	TEST_ASSERT_EQ(fake_last_len, MSC_CACHE_RA_MIN_BLOCKS);
+} // static void test_read_ahead(void)
+
+
+
+static void test_read_end_of_card(void)
+{
+	uint8_t block[MSC_CACHE_BLOCK_SIZE];
+
+	cache_reset();
+	TEST_ASSERT_EQ(m1_msc_cache_read(block, FAKE_CARD_BLOCKS - 3, 1), 0);
+	TEST_ASSERT_EQ(fake_last_len, 3);
+	TEST_ASSERT_EQ(m1_msc_cache_read(block, FAKE_CARD_BLOCKS - 1, 1), 0);
+	TEST_ASSERT_EQ(fake_reads, 1);
+	TEST_ASSERT_EQ(block[0], FAKE_CARD_BLOCKS - 1);
+} // static void test_read_end_of_card(void)
+
+
+
+static void test_write_back(void)
+{
+	uint8_t block[MSC_CACHE_BLOCK_SIZE];
+	S_M1_MscCache_Stats stats;
+	uint32_t i;
+
+	cache_reset();
+
+	// Consecutive blocks go out in one write when the run is full
+	for ( i = 0; i < MSC_CACHE_WB_BLOCKS; i++ )
+	{
+		memset(block, 0xA0 + (i & 0xF), sizeof(block));
+		TEST_ASSERT_EQ(m1_msc_cache_write(block, 20 + i, 1), 0);
+	}
+	TEST_ASSERT_EQ(fake_writes, 1);
+	TEST_ASSERT_EQ(fake_last_len, MSC_CACHE_WB_BLOCKS);
+	TEST_ASSERT_EQ(fake_card[20][0], 0xA0);
+	TEST_ASSERT_EQ(fake_card[20 + MSC_CACHE_WB_BLOCKS - 1][0], 0xA0 + ((MSC_CACHE_WB_BLOCKS - 1) & 0xF));
+	TEST_ASSERT(!m1_msc_cache_dirty());
+
+	// A partial run waits for the flush
+	memset(block, 0x55, sizeof(block));
+	TEST_ASSERT_EQ(m1_msc_cache_write(block, 100, 1), 0);
+	TEST_ASSERT_EQ(m1_msc_cache_write(block, 101, 1), 0);
+	TEST_ASSERT(m1_msc_cache_dirty());
+	TEST_ASSERT_EQ(fake_card[100][0], 100);
+	TEST_ASSERT_EQ(m1_msc_cache_flush(), 0);
+	TEST_ASSERT_EQ(fake_writes, 2);
+	TEST_ASSERT_EQ(fake_last_len, 2);
+	TEST_ASSERT_EQ(fake_card[101][0], 0x55);
+	TEST_ASSERT_EQ(m1_msc_cache_flush(), 0);
+	TEST_ASSERT_EQ(fake_writes, 2);
+
+	m1_msc_cache_get_stats(&stats);
+	TEST_ASSERT_EQ(stats.writes, MSC_CACHE_WB_BLOCKS + 2);
+	TEST_ASSERT_EQ(stats.sd_writes, 2);
+} // static void test_write_back(void)
+
+
+
+static void test_rewrite_and_jump(void)
+{
+	uint8_t block[MSC_CACHE_BLOCK_SIZE];
+
+	cache_reset();
+
+	memset(block, 1, sizeof(block));
+	m1_msc_cache_write(block, 50, 1);
+	m1_msc_cache_write(block, 51, 1);
+	// Rewriting a block of the run stays in the cache
+	memset(block, 2, sizeof(block));
+	TEST_ASSERT_EQ(m1_msc_cache_write(block, 50, 1), 0);
+	TEST_ASSERT_EQ(fake_writes, 0);
+
+	// A write elsewhere sends the run first
+	TEST_ASSERT_EQ(m1_msc_cache_write(block, 5, 1), 0);
+	TEST_ASSERT_EQ(fake_writes, 1);
+	TEST_ASSERT_EQ(fake_card[50][0], 2);
+	TEST_ASSERT_EQ(fake_card[51][0], 1);
+	TEST_ASSERT_EQ(fake_card[5][0], 5);
+	m1_msc_cache_flush();
+	TEST_ASSERT_EQ(fake_card[5][0], 2);
+} // static void test_rewrite_and_jump(void)
+
+
+
+static void test_coherency(void)
+{
+	uint8_t block[MSC_CACHE_BLOCK_SIZE];
+
+	cache_reset();
+
+	// The read-ahead window does not return blocks written after it was read
+	TEST_ASSERT_EQ(m1_msc_cache_read(block, 30, 1), 0);
+	memset(block, 0xEE, sizeof(block));
+	TEST_ASSERT_EQ(m1_msc_cache_write(block, 32, 1), 0);
+	TEST_ASSERT_EQ(m1_msc_cache_read(block, 32, 1), 0);
+	TEST_ASSERT_EQ(block[0], 0xEE);
+	// Reading the run back wrote it first
+	TEST_ASSERT_EQ(fake_writes, 1);
+	TEST_ASSERT_EQ(fake_card[32][0], 0xEE);
+
+	// The read-ahead stops before blocks still waiting to be written
+	memset(block, 0x77, sizeof(block));
+	TEST_ASSERT_EQ(m1_msc_cache_write(block, 64, 1), 0);
+	TEST_ASSERT_EQ(m1_msc_cache_read(block, 60, 1), 0);
+	TEST_ASSERT_EQ(fake_last_len, 4);
+	TEST_ASSERT(m1_msc_cache_dirty());
+	TEST_ASSERT_EQ(m1_msc_cache_read(block, 64, 1), 0);
+	TEST_ASSERT_EQ(block[0], 0x77);
+} // static void test_coherency(void)
+
+
+
+static void test_large_transfers(void)
+{
+	static uint8_t buf[MSC_CACHE_RA_BLOCKS*MSC_CACHE_BLOCK_SIZE];
+
+	cache_reset();
+
+	// Transfers as large as the buffers go straight to the card
+	TEST_ASSERT_EQ(m1_msc_cache_read(buf, 40, MSC_CACHE_RA_BLOCKS), 0);
+	TEST_ASSERT_EQ(fake_reads, 1);
+	TEST_ASSERT_EQ(buf[MSC_CACHE_BLOCK_SIZE], 41);
+	memset(buf, 0x33, sizeof(buf));
+	TEST_ASSERT_EQ(m1_msc_cache_write(buf, 40, MSC_CACHE_WB_BLOCKS), 0);
+	TEST_ASSERT_EQ(fake_writes, 1);
+	TEST_ASSERT(!m1_msc_cache_dirty());
+	TEST_ASSERT_EQ(fake_card[40][0], 0x33);
+} // static void test_large_transfers(void)
+
+
+
+static void test_errors(void)
+{
+	uint8_t block[MSC_CACHE_BLOCK_SIZE];
+	S_M1_MscCache_Stats stats;
+
+	cache_reset();
+
+	fake_fail = true;
+	TEST_ASSERT(m1_msc_cache_read(block, 0, 1)!=0);
+
+	// A failed flush keeps the run for the next try
+	fake_fail = false;
+	memset(block, 0x99, sizeof(block));
+	TEST_ASSERT_EQ(m1_msc_cache_write(block, 70, 1), 0);
+	fake_fail = true;
+	TEST_ASSERT(m1_msc_cache_flush()!=0);
+	TEST_ASSERT(m1_msc_cache_dirty());
+	fake_fail = false;
+	TEST_ASSERT_EQ(m1_msc_cache_flush(), 0);
+	TEST_ASSERT_EQ(fake_card[70][0], 0x99);
+
+	m1_msc_cache_get_stats(&stats);
+	TEST_ASSERT(stats.errors >= 2);
+
+	// Invalidate drops the run, e.g. after the card was removed
+	TEST_ASSERT_EQ(m1_msc_cache_write(block, 80, 1), 0);
+	m1_msc_cache_invalidate();
+	TEST_ASSERT(!m1_msc_cache_dirty());
+	TEST_ASSERT_EQ(m1_msc_cache_flush(), 0);
+	TEST_ASSERT_EQ(fake_card[80][0], 80);
+} // static void test_errors(void)
+
+
+
+int main(void)
+{
+	TEST_RUN(test_read_ahead);
+	TEST_RUN(test_read_end_of_card);
+	TEST_RUN(test_write_back);
+	TEST_RUN(test_rewrite_and_jump);
+	TEST_RUN(test_coherency);
+	TEST_RUN(test_large_transfers);
+	TEST_RUN(test_errors);
+
+	return TEST_RESULT();
+} // int main(void)
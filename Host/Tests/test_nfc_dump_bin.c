@@ -0,0 +1,335 @@
+/* See COPYING.txt for license details. */
+
+/*
+*
+* test_nfc_dump_bin.c
+*
+* Unit tests of the binary NFC dump container (.nfb): full save, load,
+* incremental sync, corruption checks and the .nfc round trip
+*
+* M1 Project
+*
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include "ff.h"
+#include "nfc_ctx.h"
+#include "nfc_dump_bin.h"
+#include "nfc_file.h"
+#include "m1_host_test.h"
+
+#define TEST_NFC_DIR		"0:/NFC"
+#define TEST_NFB_FILE		TEST_NFC_DIR "/tag.nfb"
+#define TEST_NFC_FILE		TEST_NFC_DIR "/tag.nfc"
+#define TEST_NFB_COPY		TEST_NFC_DIR "/copy.nfb"
+#define TEST_MFC_FILE		TEST_NFC_DIR "/mfc.nfc"
+
+#define TEST_PAGES			45		// NTAG213
+#define TEST_PAGE_SIZE		4
+
+static const uint8_t test_uid[7] = {0x04, 0xA1, 0xB2, 0xC3, 0xD4, 0xE5, 0x80};
+static uint8_t load_buf[NFC_DUMP_BUF_SIZE];
+static uint8_t load_valid[NFC_VALID_BITS_SIZE];
+
+// Builds an NTAG213 dump in the global context
+static void make_tag(void)
+{
+	nfc_run_ctx_t *c = nfc_ctx_get();
+	uint8_t sig[NFC_T2T_SIG_LEN];
+	uint32_t i;
+
+	nfc_ctx_begin_live();
+	memset(&c->head, 0, sizeof(c->head));
+	c->head.tech = M1NFC_TECH_A;
+	c->head.family = M1NFC_FAM_ULTRALIGHT;
+	c->head.uid_len = sizeof(test_uid);
+	memcpy(c->head.uid, test_uid, sizeof(test_uid));
+	c->head.a.atqa[0] = 0x44;
+	c->head.a.has_atqa = true;
+	c->head.a.sak = 0x00;
+	c->head.a.has_sak = true;
+
+	for ( i = 0; i < sizeof(sig); i++ )
+		sig[i] = (uint8_t)(0xA0 + i);
+	nfc_ctx_clear_t2t_extras();
+	nfc_ctx_set_t2t_signature(sig, sizeof(sig));
+	nfc_ctx_set_t2t_counter(2, 0x123456);
+
+	memset(g_nfc_dump_buf, 0, sizeof(g_nfc_dump_buf));
+	memset(g_nfc_valid_bits, 0, sizeof(g_nfc_valid_bits));
+	for ( i = 0; i < TEST_PAGES*TEST_PAGE_SIZE; i++ )
+		g_nfc_dump_buf[i] = (uint8_t)(i*7 + 1);
+	for ( i = 0; i < TEST_PAGES; i++ )
+		g_nfc_valid_bits[i >> 3] |= (uint8_t)(1u << (i & 7));
+	nfc_ctx_set_dump(TEST_PAGE_SIZE, TEST_PAGES, 0, g_nfc_dump_buf, g_nfc_valid_bits, TEST_PAGES - 1, true);
+	nfc_dump_bin_clear_dirty();
+} // static void make_tag(void)
+
+
+
+static void test_sidecar_path(void)
+{
+	char out[32];
+
+	TEST_ASSERT(nfc_dump_bin_sidecar_path("0:/NFC/a.nfc", out, sizeof(out)));
+	TEST_ASSERT_STR(out, "0:/NFC/a.nfb");
+	TEST_ASSERT(nfc_dump_bin_sidecar_path("0:/NFC.d/card", out, sizeof(out)));
+	TEST_ASSERT_STR(out, "0:/NFC.d/card.nfb");
+	TEST_ASSERT(!nfc_dump_bin_sidecar_path("0:/NFC/long_name.nfc", out, 12));
+} // static void test_sidecar_path(void)
+
+
+
+static void test_save_load(void)
+{
+	const nfc_run_ctx_t *c;
+	const nfc_t2t_info_t *t2t;
+	uint8_t expect[TEST_PAGES*TEST_PAGE_SIZE];
+
+	f_mkdir(TEST_NFC_DIR);
+	make_tag();
+	memcpy(expect, g_nfc_dump_buf, sizeof(expect));
+	TEST_ASSERT(nfc_dump_bin_save(TEST_NFB_FILE, nfc_ctx_get(), NULL));
+
+	// Clobber the context, then load into a separate workspace
+	nfc_ctx_begin_live();
+	memset(&nfc_ctx_get()->head, 0, sizeof(nfc_ctx_get()->head));
+	TEST_ASSERT_EQ(nfc_dump_bin_load(TEST_NFB_FILE, load_buf, sizeof(load_buf), load_valid, sizeof(load_valid)), NFC_STORAGE_OK);
+
+	c = nfc_ctx_get();
+	TEST_ASSERT_EQ(c->head.family, M1NFC_FAM_ULTRALIGHT);
+	TEST_ASSERT_EQ(c->head.uid_len, sizeof(test_uid));
+	TEST_ASSERT_MEM(c->head.uid, test_uid, sizeof(test_uid));
+	TEST_ASSERT(c->head.a.has_atqa);
+	TEST_ASSERT_EQ(c->head.a.atqa[0], 0x44);
+	TEST_ASSERT(c->head.a.has_sak);
+	TEST_ASSERT_EQ(c->dump.unit_size, TEST_PAGE_SIZE);
+	TEST_ASSERT_EQ(c->dump.max_seen_unit, TEST_PAGES - 1);
+	TEST_ASSERT(c->dump.data==load_buf);
+	TEST_ASSERT_MEM(load_buf, expect, sizeof(expect));
+	TEST_ASSERT_EQ(load_buf[sizeof(expect)], 0);
+	TEST_ASSERT_EQ(load_valid[0], 0xFF);
+	TEST_ASSERT_EQ(load_valid[TEST_PAGES >> 3], (1u << (TEST_PAGES & 7)) - 1);
+
+	t2t = nfc_ctx_get_t2t_info();
+	TEST_ASSERT(t2t->has_signature);
+	TEST_ASSERT_EQ(t2t->signature[31], 0xA0 + 31);
+	TEST_ASSERT_EQ(t2t->counter_mask, 0x04);
+	TEST_ASSERT_EQ(t2t->counter[2], 0x123456);
+
+	// Too small a workspace
+	TEST_ASSERT_EQ(nfc_dump_bin_load(TEST_NFB_FILE, load_buf, 16, NULL, 0), NFC_STORAGE_ERR_NO_BUFFER);
+	TEST_ASSERT_EQ(nfc_dump_bin_load(TEST_NFC_DIR "/missing.nfb", load_buf, sizeof(load_buf), NULL, 0), NFC_STORAGE_ERR_IO);
+} // static void test_save_load(void)
+
+
+
+static void test_sync(void)
+{
+	nfc_run_ctx_t *c;
+	FILINFO before, after;
+
+	make_tag();
+	TEST_ASSERT(nfc_dump_bin_save(TEST_NFB_FILE, nfc_ctx_get(), NULL));
+	TEST_ASSERT_EQ(f_stat(TEST_NFB_FILE, &before), FR_OK);
+
+	// One page changed: rewritten in place
+	c = nfc_ctx_get();
+	memset(&c->dump.data[10*TEST_PAGE_SIZE], 0x5A, TEST_PAGE_SIZE);
+	nfc_dump_bin_mark_dirty(10);
+	TEST_ASSERT(nfc_dump_bin_sync(TEST_NFB_FILE, c, NULL));
+	TEST_ASSERT_EQ(f_stat(TEST_NFB_FILE, &after), FR_OK);
+	TEST_ASSERT_EQ(after.fsize, before.fsize);
+
+	TEST_ASSERT_EQ(nfc_dump_bin_load(TEST_NFB_FILE, load_buf, sizeof(load_buf), load_valid, sizeof(load_valid)), NFC_STORAGE_OK);
+	TEST_ASSERT_EQ(load_buf[10*TEST_PAGE_SIZE], 0x5A);
+	TEST_ASSERT_EQ(load_buf[11*TEST_PAGE_SIZE], (uint8_t)(11*TEST_PAGE_SIZE*7 + 1));
+
+	// A stale container the dirty units are not relative to: full rewrite
+	make_tag();
+	c = nfc_ctx_get();
+	memset(&c->dump.data[3*TEST_PAGE_SIZE], 0x11, TEST_PAGE_SIZE);
+	TEST_ASSERT(nfc_dump_bin_save(TEST_NFB_COPY, c, NULL));
+	make_tag();
+	TEST_ASSERT(nfc_dump_bin_save(TEST_NFB_FILE, c, NULL));
+	memset(&c->dump.data[10*TEST_PAGE_SIZE], 0x5A, TEST_PAGE_SIZE);
+	nfc_dump_bin_mark_dirty(10);
+	TEST_ASSERT(nfc_dump_bin_sync(TEST_NFB_COPY, c, NULL));
+	TEST_ASSERT_EQ(nfc_dump_bin_load(TEST_NFB_COPY, load_buf, sizeof(load_buf), load_valid, sizeof(load_valid)), NFC_STORAGE_OK);
+	TEST_ASSERT_EQ(load_buf[3*TEST_PAGE_SIZE], (uint8_t)(3*TEST_PAGE_SIZE*7 + 1));
+	TEST_ASSERT_EQ(load_buf[10*TEST_PAGE_SIZE], 0x5A);
+
+	// Geometry change: full rewrite
+	make_tag();
+	c = nfc_ctx_get();
+	nfc_ctx_set_dump(TEST_PAGE_SIZE, TEST_PAGES + 90, 0, g_nfc_dump_buf, g_nfc_valid_bits, TEST_PAGES + 89, true);
+	TEST_ASSERT(nfc_dump_bin_sync(TEST_NFB_FILE, c, NULL));
+	TEST_ASSERT_EQ(f_stat(TEST_NFB_FILE, &after), FR_OK);
+	TEST_ASSERT(after.fsize > before.fsize);
+} // static void test_sync(void)
+
+
+
+static void test_corruption(void)
+{
+	FIL f;
+	UINT n;
+	uint8_t b;
+
+	make_tag();
+	TEST_ASSERT(nfc_dump_bin_save(TEST_NFB_FILE, nfc_ctx_get(), NULL));
+
+	// Flip one data byte: data CRC mismatch
+	TEST_ASSERT_EQ(f_open(&f, TEST_NFB_FILE, FA_READ | FA_WRITE), FR_OK);
+	f_lseek(&f, NFC_BIN_DATA_ALIGN + 5);
+	f_read(&f, &b, 1, &n);
+	b ^= 0x01;
+	f_lseek(&f, NFC_BIN_DATA_ALIGN + 5);
+	f_write(&f, &b, 1, &n);
+	f_close(&f);
+	TEST_ASSERT_EQ(nfc_dump_bin_load(TEST_NFB_FILE, load_buf, sizeof(load_buf), NULL, 0), NFC_STORAGE_ERR_FORMAT);
+
+	// Flip one header byte: header CRC mismatch
+	TEST_ASSERT(nfc_dump_bin_save(TEST_NFB_FILE, nfc_ctx_get(), NULL));
+	TEST_ASSERT_EQ(f_open(&f, TEST_NFB_FILE, FA_READ | FA_WRITE), FR_OK);
+	f_lseek(&f, 12);
+	b = 0xEE;
+	f_write(&f, &b, 1, &n);
+	f_close(&f);
+	TEST_ASSERT_EQ(nfc_dump_bin_load(TEST_NFB_FILE, load_buf, sizeof(load_buf), NULL, 0), NFC_STORAGE_ERR_FORMAT);
+
+	TEST_ASSERT(test_write_file(TEST_NFB_COPY, "not a container"));
+	TEST_ASSERT_EQ(nfc_dump_bin_load(TEST_NFB_COPY, load_buf, sizeof(load_buf), NULL, 0), NFC_STORAGE_ERR_FORMAT);
+} // static void test_corruption(void)
+
+
+
+static void test_text_round_trip(void)
+{
+	FILINFO src;
+	uint8_t expect[TEST_PAGES*TEST_PAGE_SIZE];
+
+	make_tag();
+	memcpy(expect, g_nfc_dump_buf, sizeof(expect));
+	TEST_ASSERT(nfc_dump_bin_save(TEST_NFB_FILE, nfc_ctx_get(), NULL));
+
+	TEST_ASSERT(nfc_dump_bin_to_text(TEST_NFB_FILE, TEST_NFC_FILE));
+	TEST_ASSERT_EQ(nfc_storage_load_file(TEST_NFC_FILE, g_nfc_dump_buf, sizeof(g_nfc_dump_buf),
+										 g_nfc_valid_bits, sizeof(g_nfc_valid_bits)), NFC_STORAGE_OK);
+	TEST_ASSERT_EQ(f_stat(TEST_NFC_FILE, &src), FR_OK);
+	TEST_ASSERT(nfc_dump_bin_save(TEST_NFB_COPY, nfc_ctx_get(), &src));
+
+	TEST_ASSERT(nfc_dump_bin_is_current(TEST_NFB_COPY, &src));
+	TEST_ASSERT(nfc_dump_bin_is_current(TEST_NFB_FILE, &src)); // sidecar refreshed by the .nfc save
+	src.fsize++;
+	TEST_ASSERT(!nfc_dump_bin_is_current(TEST_NFB_COPY, &src));
+
+	TEST_ASSERT_EQ(nfc_dump_bin_load(TEST_NFB_COPY, load_buf, sizeof(load_buf), load_valid, sizeof(load_valid)), NFC_STORAGE_OK);
+	TEST_ASSERT_MEM(nfc_ctx_get()->head.uid, test_uid, sizeof(test_uid));
+	TEST_ASSERT_MEM(load_buf, expect, sizeof(expect));
+} // static void test_text_round_trip(void)
+
+
+// Saves a Classic dump of the first blocks only, returns the type line
+static const char *classic_type_saved(uint8_t sak, bool has_sak, uint8_t atqa0, uint32_t blocks)
+{
+	static char text[2048];
+	nfc_run_ctx_t *c = nfc_ctx_get();
+	FIL f;
+	UINT n;
+	uint32_t i;
+	char *line;
+
+	nfc_ctx_begin_live();
+	memset(&c->head, 0, sizeof(c->head));
+	c->head.tech = M1NFC_TECH_A;
+	c->head.family = M1NFC_FAM_CLASSIC;
+	c->head.uid_len = 4;
+	memcpy(c->head.uid, test_uid, 4);
+	c->head.a.atqa[0] = atqa0;
+	c->head.a.has_atqa = true;
+	c->head.a.sak = sak;
+	c->head.a.has_sak = has_sak;
+
+	memset(g_nfc_dump_buf, 0x11, blocks*16);
+	memset(g_nfc_valid_bits, 0, sizeof(g_nfc_valid_bits));
+	for ( i = 0; i < blocks; i++ )
+		g_nfc_valid_bits[i >> 3] |= (uint8_t)(1u << (i & 7));
+	nfc_ctx_set_dump(16, 256, 0, g_nfc_dump_buf, g_nfc_valid_bits, blocks - 1, true);
+	if ( !nfc_profile_save(TEST_MFC_FILE, c) )
+		return "";
+
+	memset(text, 0, sizeof(text));
+	if ( f_open(&f, TEST_MFC_FILE, FA_READ)!=FR_OK )
+		return "";
+	f_read(&f, text, sizeof(text) - 1, &n);
+	f_close(&f);
+	line = strstr(text, "Mifare Classic type: ");
+	if ( !line )
+		return "";
+	line += strlen("Mifare Classic type: ");
+	line[strcspn(line, "\r\n")] = '\0';
+
+	return line;
+} // static const char *classic_type_saved(uint8_t sak, bool has_sak, uint8_t atqa0, uint32_t blocks)
+
+
+
+static void test_classic_type(void)
+{
+	// A partial dump keeps the size the card answered with
+	TEST_ASSERT_STR(classic_type_saved(0x08, true, 0x04, 8), "1K");
+	TEST_ASSERT_STR(classic_type_saved(0x18, true, 0x02, 12), "4K");
+	TEST_ASSERT_STR(classic_type_saved(0x09, true, 0x04, 20), "MINI");
+	TEST_ASSERT_STR(classic_type_saved(0x00, false, 0x02, 4), "4K");
+	// Nothing to go by but the blocks
+	TEST_ASSERT_STR(classic_type_saved(0x01, true, 0x00, 64), "1K");
+	f_unlink(TEST_MFC_FILE);
+	f_unlink(TEST_NFC_DIR "/mfc.nfb");
+} // static void test_classic_type(void)
+
+
+
+static void test_load_container(void)
+{
+	S_M1_file_info f;
+	FILINFO fno;
+
+	make_tag();
+	TEST_ASSERT(nfc_profile_save(TEST_NFC_FILE, nfc_ctx_get()));
+	TEST_ASSERT_EQ(f_stat(TEST_NFB_FILE, &fno), FR_OK);
+
+	// The container selected stands for its .nfc
+	f.dir_name = TEST_NFC_DIR;
+	f.file_name = "tag.nfb";
+	TEST_ASSERT(nfc_profile_load(&f, "nfc"));
+	TEST_ASSERT_STR(nfc_ctx_get()->file.path, TEST_NFC_FILE);
+	TEST_ASSERT_MEM(nfc_ctx_get()->head.uid, test_uid, sizeof(test_uid));
+
+	// Without its .nfc, the .nfc is restored from it
+	TEST_ASSERT_EQ(f_unlink(TEST_NFC_FILE), FR_OK);
+	TEST_ASSERT(nfc_profile_load(&f, "nfc"));
+	TEST_ASSERT_STR(nfc_ctx_get()->file.path, TEST_NFC_FILE);
+	TEST_ASSERT_EQ(f_stat(TEST_NFC_FILE, &fno), FR_OK);
+
+	f.file_name = "missing.nfb";
+	TEST_ASSERT(!nfc_profile_load(&f, "nfc"));
+} // static void test_load_container(void)
+
+
+
+int main(void)
+{
+	nfc_ctx_module_init();
+
+	TEST_RUN(test_sidecar_path);
+	TEST_RUN(test_save_load);
+	TEST_RUN(test_sync);
+	TEST_RUN(test_corruption);
+	TEST_RUN(test_text_round_trip);
+	TEST_RUN(test_classic_type);
+	TEST_RUN(test_load_container);
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,138 @@
+/* See COPYING.txt for license details. */
+
+/*
+*
+* test_power_profile.c
+*
+* Unit tests of m1_power_profile.c
+*
+* M1 Project
+*
+*/
+
+#include "m1_power_profile.h"
+#include "m1_host_test.h"
+
+#define TIME_BASE_HZ		100000 // 10 us, as TIM5 on the device
+
+static uint32_t now;
+
+// Runs for awake counts, then sleeps for asleep counts until irqn wakes up
+static void run_then_sleep(uint32_t awake, uint32_t asleep, uint32_t expected_ticks, int16_t irqn)
+{
+	now += awake;
+	m1_power_profile_sleep_enter(now, expected_ticks);
+	now += asleep;
+	m1_power_profile_sleep_exit(now, irqn);
+} // static void run_then_sleep(...)
+
+
+
+static void test_sleep_time(void)
+{
+	S_M1_PwrProf_Snapshot snap;
+	uint32_t i;
+
+	// Starts right before the time base wraps
+	now = UINT32_MAX - 500;
+	m1_power_profile_reset(TIME_BASE_HZ, now);
+	for ( i = 0; i < 100; i++ )
+		run_then_sleep(25, 75, 2, -1);
+	m1_power_profile_sleep_abort();
+
+	m1_power_profile_get(now, &snap);
+	TEST_ASSERT_EQ(snap.time_base_hz, TIME_BASE_HZ);
+	TEST_ASSERT_EQ(snap.total_time, 10000);
+	TEST_ASSERT_EQ(snap.sleep_time, 7500);
+	TEST_ASSERT_EQ(snap.sleeps, 100);
+	TEST_ASSERT_EQ(snap.aborts, 1);
+	TEST_ASSERT_EQ(snap.idle_windows[0], 100);
+} // static void test_sleep_time(void)
+
+
+
+static void test_wake_sources(void)
+{
+	S_M1_PwrProf_Snapshot prev, snap;
+	int16_t irqn;
+
+	now = 0;
+	m1_power_profile_reset(TIME_BASE_HZ, now);
+	run_then_sleep(10, 10, 9, -1);
+	run_then_sleep(10, 10, 10, 58);
+	run_then_sleep(10, 10, 999, -1);
+	run_then_sleep(10, 10, 5000, PWR_PROF_WAKE_UNKNOWN);
+	m1_power_profile_get(now, &prev);
+
+	TEST_ASSERT_EQ(prev.idle_windows[0], 1);
+	TEST_ASSERT_EQ(prev.idle_windows[1], 1);
+	TEST_ASSERT_EQ(prev.idle_windows[2], 1);
+	TEST_ASSERT_EQ(prev.idle_windows[3], 1);
+	TEST_ASSERT_EQ(prev.n_sources, 3);
+	TEST_ASSERT_EQ(prev.sources[0].irqn, -1);
+	TEST_ASSERT_EQ(prev.sources[0].count, 2);
+
+	// More sources than the table holds go to wake_other
+	for ( irqn = 0; irqn < PWR_PROF_MAX_SOURCES + 2; irqn++ )
+		run_then_sleep(10, 10, 2, irqn);
+	run_then_sleep(10, 10, 2, -1);
+	m1_power_profile_get(now, &snap);
+	TEST_ASSERT_EQ(snap.n_sources, PWR_PROF_MAX_SOURCES);
+	TEST_ASSERT_EQ(snap.wake_other, (PWR_PROF_MAX_SOURCES + 2) - (PWR_PROF_MAX_SOURCES - 3));
+
+	// Deltas between two snapshots, new sources count from 0
+	TEST_ASSERT_EQ(m1_power_profile_source_delta(&prev, &snap.sources[0]), 1);
+	TEST_ASSERT_EQ(m1_power_profile_source_delta(&prev, &snap.sources[1]), 0);
+	TEST_ASSERT_EQ(snap.sources[3].irqn, 0);
+	TEST_ASSERT_EQ(m1_power_profile_source_delta(&prev, &snap.sources[3]), 1);
+} // static void test_wake_sources(void)
+
+
+
+static void test_current_fit(void)
+{
+	S_M1_PwrProf_Snapshot snap;
+	uint32_t i;
+
+	now = 0;
+	m1_power_profile_reset(TIME_BASE_HZ, now);
+
+	// Charging readings are not used
+	run_then_sleep(100, 100, 2, -1);
+	m1_power_profile_add_current(now, 500);
+	m1_power_profile_get(now, &snap);
+	TEST_ASSERT_EQ(snap.current_samples, 0);
+
+	// The same sleep share every time gives no fit
+	for ( i = 0; i < 3; i++ )
+	{
+		run_then_sleep(500, 500, 2, -1);
+		m1_power_profile_add_current(now, -55);
+	}
+	m1_power_profile_get(now, &snap);
+	TEST_ASSERT_EQ(snap.current_samples, 3);
+	TEST_ASSERT_EQ(snap.last_current_mA, 55);
+	TEST_ASSERT_EQ(snap.last_sleep_permille, 500);
+	TEST_ASSERT(!snap.model_valid);
+
+	// 100 mA awake and 10 mA asleep: 25% asleep draws 77.5 mA, 90% asleep 19 mA
+	run_then_sleep(750, 250, 2, -1);
+	m1_power_profile_add_current(now, -78);
+	run_then_sleep(100, 900, 2, -1);
+	m1_power_profile_add_current(now, -19);
+	m1_power_profile_get(now, &snap);
+	TEST_ASSERT(snap.model_valid);
+	TEST_ASSERT(snap.awake_mA > 95 && snap.awake_mA < 105);
+	TEST_ASSERT(snap.sleep_mA > 5 && snap.sleep_mA < 15);
+} // static void test_current_fit(void)
+
+
+
+int main(void)
+{
+	TEST_RUN(test_sleep_time);
+	TEST_RUN(test_wake_sources);
+	TEST_RUN(test_current_fit);
+
+	return TEST_RESULT();
+} // int main(void)
@@ -0,0 +1,274 @@
+/* See COPYING.txt for license details. */
+
+/*
+*
+* test_ring_buffer.c
+*
+* Unit tests of m1_ring_buffer.c
+*
+* M1 Project
+*
+*/
+
+#include <stdint.h>
+#include <pthread.h>
+#include <sched.h>
+#include "m1_ring_buffer.h"
+#include "m1_host_test.h"
+
+#define RB_SLOTS		16
+
+#define SPSC_SLOTS		61		// not a power of two, wraps at odd offsets
+#define SPSC_ITEMS		1000000
+
+static uint8_t rb_storage[RB_SLOTS];
+
+static void test_empty(void)
+{
+	S_M1_RingBuffer rb;
+	uint8_t out[4];
+
+	m1_ringbuffer_init(&rb, rb_storage, RB_SLOTS, 1);
+	TEST_ASSERT(m1_ringbuffer_check_empty_state(&rb));
+	TEST_ASSERT_EQ(ringbuffer_get_data_slots(&rb), 0);
+	// One slot stays unused to tell a full buffer from an empty one
+	TEST_ASSERT_EQ(ringbuffer_get_empty_slots(&rb), RB_SLOTS - 1);
+	TEST_ASSERT_EQ(m1_ringbuffer_read(&rb, out, sizeof(out)), 0);
+	TEST_ASSERT_EQ(m1_ringbuffer_advance_read(&rb, 1), 0);
+} // static void test_empty(void)
+
+
+
+static void test_write_read(void)
+{
+	S_M1_RingBuffer rb;
+	uint8_t in[RB_SLOTS], out[RB_SLOTS];
+	uint16_t i;
+
+	for ( i = 0; i < RB_SLOTS; i++ )
+		in[i] = (uint8_t)(0xA0 + i);
+
+	m1_ringbuffer_init(&rb, rb_storage, RB_SLOTS, 1);
+	TEST_ASSERT_EQ(m1_ringbuffer_write(&rb, in, 10), 10);
+	TEST_ASSERT_EQ(ringbuffer_get_data_slots(&rb), 10);
+	TEST_ASSERT_EQ(m1_ringbuffer_read(&rb, out, 4), 4);
+	TEST_ASSERT_MEM(out, in, 4);
+
+	// Fill up: only the free slots are taken
+	TEST_ASSERT_EQ(m1_ringbuffer_write(&rb, in, RB_SLOTS), RB_SLOTS - 1 - 6);
+	TEST_ASSERT_EQ(ringbuffer_get_empty_slots(&rb), 0);
+	TEST_ASSERT_EQ(m1_ringbuffer_write(&rb, in, 1), 0);
+
+	// Read across the wrap
+	TEST_ASSERT_EQ(m1_ringbuffer_read(&rb, out, RB_SLOTS), RB_SLOTS - 1);
+	TEST_ASSERT_MEM(out, &in[4], 6);
+	TEST_ASSERT_MEM(&out[6], in, RB_SLOTS - 1 - 6);
+	TEST_ASSERT(m1_ringbuffer_check_empty_state(&rb));
+} // static void test_write_read(void)
+
+
+
+static void test_linear_read(void)
+{
+	S_M1_RingBuffer rb;
+	uint8_t in[12] = {0};
+
+	m1_ringbuffer_init(&rb, rb_storage, RB_SLOTS, 1);
+	m1_ringbuffer_write(&rb, in, 12);
+	m1_ringbuffer_advance_read(&rb, 12);
+	m1_ringbuffer_write(&rb, in, 8);
+
+	// 4 slots up to the end of the buffer, the rest from the start
+	TEST_ASSERT_EQ(m1_ringbuffer_get_read_len(&rb), 4);
+	TEST_ASSERT(m1_ringbuffer_get_read_address(&rb)==&rb_storage[12]);
+	TEST_ASSERT_EQ(m1_ringbuffer_advance_read(&rb, 4), 4);
+	TEST_ASSERT_EQ(m1_ringbuffer_get_read_len(&rb), 4);
+	TEST_ASSERT(m1_ringbuffer_get_read_address(&rb)==rb_storage);
+} // static void test_linear_read(void)
+
+
+
+static void test_insert_overwrites(void)
+{
+	S_M1_RingBuffer rb;
+	uint8_t val, out[RB_SLOTS];
+	uint16_t i;
+
+	m1_ringbuffer_init(&rb, rb_storage, RB_SLOTS, 1);
+	for ( i = 0; i < RB_SLOTS + 4; i++ )
+	{
+		val = (uint8_t)i;
+		m1_ringbuffer_insert(&rb, &val);
+	}
+
+	// The oldest items were dropped
+	TEST_ASSERT_EQ(m1_ringbuffer_read(&rb, out, RB_SLOTS), RB_SLOTS - 1);
+	TEST_ASSERT_EQ(out[0], 5);
+	TEST_ASSERT_EQ(out[RB_SLOTS - 2], RB_SLOTS + 3);
+} // static void test_insert_overwrites(void)
+
+
+
+static void test_multi_byte_slots(void)
+{
+	S_M1_RingBuffer rb;
+	uint16_t in[4] = {0x1111, 0x2222, 0x3333, 0x4444};
+	uint16_t out[4] = {0};
+
+	m1_ringbuffer_init(&rb, rb_storage, RB_SLOTS/2, sizeof(uint16_t));
+	TEST_ASSERT_EQ(m1_ringbuffer_write(&rb, (uint8_t *)in, 4), 4);
+	TEST_ASSERT_EQ(ringbuffer_get_data_slots(&rb), 4);
+	TEST_ASSERT_EQ(m1_ringbuffer_read(&rb, (uint8_t *)out, 4), 4);
+	TEST_ASSERT_MEM(out, in, sizeof(in));
+
+	m1_ringbuffer_reset(&rb);
+	TEST_ASSERT(m1_ringbuffer_check_empty_state(&rb));
+} // static void test_multi_byte_slots(void)
+
+
+
+static void test_multi_byte_wrap(void)
+{
+	S_M1_RingBuffer rb;
+	uint16_t in[RB_SLOTS/2], out[RB_SLOTS/2];
+	uint16_t i;
+
+	for ( i = 0; i < RB_SLOTS/2; i++ )
+		in[i] = (uint16_t)(0x1000*(i + 1) + i);
+
+	// 8 slots of 2 bytes, data wraps after 3 slots
+	m1_ringbuffer_init(&rb, rb_storage, RB_SLOTS/2, sizeof(uint16_t));
+	m1_ringbuffer_write(&rb, (uint8_t *)in, 5);
+	m1_ringbuffer_advance_read(&rb, 5);
+	TEST_ASSERT_EQ(m1_ringbuffer_write(&rb, (uint8_t *)in, 7), 7);
+	TEST_ASSERT_EQ(m1_ringbuffer_used_slots(&rb), 7);
+	TEST_ASSERT_EQ(m1_ringbuffer_free_slots(&rb), 0);
+
+	memset(out, 0, sizeof(out));
+	TEST_ASSERT_EQ(m1_ringbuffer_read(&rb, (uint8_t *)out, 7), 7);
+	TEST_ASSERT_MEM(out, in, 7*sizeof(uint16_t));
+	TEST_ASSERT_EQ(m1_ringbuffer_used_slots(&rb), 0);
+} // static void test_multi_byte_wrap(void)
+
+
+
+static void test_peek(void)
+{
+	S_M1_RingBuffer rb;
+	uint8_t in[RB_SLOTS], out[RB_SLOTS];
+	uint16_t i;
+
+	for ( i = 0; i < RB_SLOTS; i++ )
+		in[i] = (uint8_t)i;
+
+	m1_ringbuffer_init(&rb, rb_storage, RB_SLOTS, 1);
+	m1_ringbuffer_write(&rb, in, 12);
+	m1_ringbuffer_advance_read(&rb, 10);
+	m1_ringbuffer_write(&rb, in, 10);
+
+	// Peek across the wrap leaves the data in place
+	TEST_ASSERT_EQ(m1_ringbuffer_peek(&rb, out, 5), 5);
+	TEST_ASSERT_EQ(out[0], 10);
+	TEST_ASSERT_EQ(out[2], 0);
+	TEST_ASSERT_EQ(m1_ringbuffer_used_slots(&rb), 12);
+	TEST_ASSERT_EQ(m1_ringbuffer_peek(&rb, out, RB_SLOTS), 12);
+	TEST_ASSERT_EQ(m1_ringbuffer_read(&rb, out, RB_SLOTS), 12);
+	TEST_ASSERT_EQ(out[11], 9);
+	TEST_ASSERT_EQ(m1_ringbuffer_peek(&rb, out, 1), 0);
+} // static void test_peek(void)
+
+
+
+static void test_space_queries(void)
+{
+	S_M1_RingBuffer rb;
+	uint8_t in[RB_SLOTS] = {0};
+	uint16_t i, w;
+
+	// Used + free is constant through every wrap position
+	m1_ringbuffer_init(&rb, rb_storage, RB_SLOTS, 1);
+	for ( i = 0; i < 3*RB_SLOTS; i++ )
+	{
+		w = (uint16_t)(i % 5);
+		m1_ringbuffer_write(&rb, in, w);
+		TEST_ASSERT_EQ(m1_ringbuffer_used_slots(&rb) + m1_ringbuffer_free_slots(&rb), RB_SLOTS - 1);
+		TEST_ASSERT_EQ(ringbuffer_get_data_slots(&rb), m1_ringbuffer_used_slots(&rb));
+		TEST_ASSERT_EQ(ringbuffer_get_empty_slots(&rb), m1_ringbuffer_free_slots(&rb));
+		m1_ringbuffer_advance_read(&rb, (uint16_t)(i % 4));
+	}
+} // static void test_space_queries(void)
+
+
+
+static S_M1_RingBuffer spsc_rb;
+static uint32_t spsc_storage[SPSC_SLOTS];
+
+// Producer thread: random sized bulk writes of a counting sequence
+static void *spsc_producer(void *arg)
+{
+	uint32_t block[17], next = 0, n, k, seed = 1;
+
+	(void)arg;
+	while ( next < SPSC_ITEMS )
+	{
+		seed = seed*1103515245 + 12345;
+		n = 1 + (seed >> 16) % 17;
+		if ( n > SPSC_ITEMS - next )
+			n = SPSC_ITEMS - next;
+		for ( k = 0; k < n; k++ )
+			block[k] = next + k;
+		k = m1_ringbuffer_write(&spsc_rb, (uint8_t *)block, (uint16_t)n);
+		if ( !k )
+			sched_yield();	// let the consumer run on a single core
+		next += k;
+	}
+
+	return NULL;
+} // static void *spsc_producer(void *arg)
+
+
+
+static void test_spsc_threads(void)
+{
+	pthread_t producer;
+	uint32_t block[23], expect = 0, n, k, errors = 0;
+
+	m1_ringbuffer_init(&spsc_rb, (uint8_t *)spsc_storage, SPSC_SLOTS, sizeof(uint32_t));
+	TEST_ASSERT_EQ(pthread_create(&producer, NULL, spsc_producer, NULL), 0);
+
+	// Consumer: read and check the sequence is complete and in order
+	while ( expect < SPSC_ITEMS )
+	{
+		n = m1_ringbuffer_read(&spsc_rb, (uint8_t *)block, 1 + expect % 23);
+		for ( k = 0; k < n; k++ )
+		{
+			if ( block[k]!=expect + k )
+				errors++;
+		}
+		if ( !n )
+			sched_yield();
+		expect += n;
+	}
+
+	pthread_join(producer, NULL);
+	TEST_ASSERT_EQ(errors, 0);
+	TEST_ASSERT_EQ(expect, SPSC_ITEMS);
+	TEST_ASSERT(m1_ringbuffer_check_empty_state(&spsc_rb));
+} // static void test_spsc_threads(void)
+
+
+
+int main(void)
+{
+	TEST_RUN(test_empty);
+	TEST_RUN(test_write_read);
+	TEST_RUN(test_linear_read);
+	TEST_RUN(test_insert_overwrites);
+	TEST_RUN(test_multi_byte_slots);
+	TEST_RUN(test_multi_byte_wrap);
+	TEST_RUN(test_peek);
+	TEST_RUN(test_space_queries);
+	TEST_RUN(test_spsc_threads);
+
+	return TEST_RESULT();
+}
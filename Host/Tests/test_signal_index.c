@@ -0,0 +1,238 @@
+/* See COPYING.txt for license details. */
+
+/*
+*
+* test_signal_index.c
+*
+* Unit tests of m1_signal_index.c
+*
+* M1 Project
+*
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include "ff.h"
+#include "m1_file_util.h"
+#include "m1_signal_index.h"
+#include "m1_host_test.h"
+
+static void write_file(const char *path, const char *text)
+{
+	FIL fil;
+	UINT bw;
+
+	TEST_ASSERT_EQ(f_open(&fil, path, FA_CREATE_ALWAYS | FA_WRITE), FR_OK);
+	TEST_ASSERT_EQ(f_write(&fil, text, strlen(text), &bw), FR_OK);
+	f_close(&fil);
+} // static void write_file(const char *path, const char *text)
+
+
+
+// Path of the first hit, or "" if there is none
+static const char *first_hit(S_M1_SigIdx_Search *psearch, const char *query)
+{
+	static S_M1_SigIdx_Record rec;
+
+	TEST_ASSERT_EQ(m1_sig_idx_search(psearch, query), FR_OK);
+	if ( !psearch->n_hits )
+		return "";
+	TEST_ASSERT_EQ(m1_sig_idx_read(psearch->hits[0].record, &rec), FR_OK);
+
+	return rec.path;
+} // static const char *first_hit(S_M1_SigIdx_Search *psearch, const char *query)
+
+
+
+static void test_fuzzy_score(void)
+{
+	TEST_ASSERT_EQ(m1_sig_idx_fuzzy_score("", "garage"), 0);
+	TEST_ASSERT_EQ(m1_sig_idx_fuzzy_score("xyz", "garage"), -1);
+	TEST_ASSERT_EQ(m1_sig_idx_fuzzy_score("ega", "garage"), -1);
+	TEST_ASSERT(m1_sig_idx_fuzzy_score("GAR", "garage") > 0);
+
+	// One run beats scattered letters, the start of the text or a word beats the middle
+	TEST_ASSERT(m1_sig_idx_fuzzy_score("gar", "garage") > m1_sig_idx_fuzzy_score("gar", "my_garage"));
+	TEST_ASSERT(m1_sig_idx_fuzzy_score("gar", "my_garage") > m1_sig_idx_fuzzy_score("gar", "sugar"));
+	TEST_ASSERT(m1_sig_idx_fuzzy_score("gar", "sugar") > m1_sig_idx_fuzzy_score("gar", "g_a_r"));
+	TEST_ASSERT(m1_sig_idx_fuzzy_score("gdr", "garage_door") > m1_sig_idx_fuzzy_score("gdr", "gadgetry"));
+} // static void test_fuzzy_score(void)
+
+
+
+static void test_put_remove(void)
+{
+	S_M1_SigIdx_Search search;
+	S_M1_SigIdx_Record rec;
+	const uint8_t uid[] = {0x04, 0xA2, 0x1F};
+
+	f_unlink(SIG_IDX_FILE);
+	m1_sig_idx_search_reset(&search);
+	TEST_ASSERT_EQ(m1_sig_idx_records(), 0);
+	TEST_ASSERT_EQ(m1_sig_idx_search(&search, "x"), FR_OK);
+	TEST_ASSERT_EQ(search.n_hits, 0);
+	TEST_ASSERT(search.complete);
+
+	m1_sig_idx_add(SIG_IDX_NFC, "/NFC/badge.nfc", "Classic", 0, uid, sizeof(uid));
+	TEST_ASSERT_EQ(m1_sig_idx_records(), 1);
+	TEST_ASSERT_EQ(m1_sig_idx_read(0, &rec), FR_OK);
+	TEST_ASSERT_STR(rec.path, "0:/NFC/badge.nfc");
+	TEST_ASSERT_STR(rec.protocol, "Classic");
+	TEST_ASSERT_STR(rec.uid, "04A21F");
+
+	// Saving the same file again replaces its record
+	m1_sig_idx_add(SIG_IDX_NFC, "0:/NFC/Badge.nfc", "Ultralight/NTAG", 0, uid, 2);
+	TEST_ASSERT_EQ(m1_sig_idx_records(), 1);
+	TEST_ASSERT_EQ(m1_sig_idx_read(0, &rec), FR_OK);
+	TEST_ASSERT_STR(rec.protocol, "Ultralight/NTAG");
+	TEST_ASSERT_STR(rec.uid, "04A2");
+
+	m1_sig_idx_add(SIG_IDX_SUBGHZ, "/SUBGHZ/gate.sgh", "RAW", 433920000, NULL, 0);
+	TEST_ASSERT_EQ(m1_sig_idx_records(), 2);
+	TEST_ASSERT_STR(first_hit(&search, "04a2"), "0:/NFC/Badge.nfc");
+	TEST_ASSERT_STR(first_hit(&search, "433.92"), "0:/SUBGHZ/gate.sgh");
+
+	// A removed record is not found and its slot is reused
+	TEST_ASSERT_EQ(m1_sig_idx_remove("0:/NFC/badge.nfc"), FR_OK);
+	m1_sig_idx_search_reset(&search);
+	TEST_ASSERT_STR(first_hit(&search, "badge"), "");
+	m1_sig_idx_add(SIG_IDX_RFID, "/RFID/fob.rfid", "EM4100", 0, uid, 1);
+	TEST_ASSERT_EQ(m1_sig_idx_records(), 2);
+	TEST_ASSERT_EQ(m1_sig_idx_read(0, &rec), FR_OK);
+	TEST_ASSERT_STR(rec.path, "0:/RFID/fob.rfid");
+
+	// A renamed file keeps its record under the new path
+	TEST_ASSERT_EQ(m1_sig_idx_rename("0:/SUBGHZ/gate.sgh", "0:/SUBGHZ/garage.sgh"), FR_OK);
+	m1_sig_idx_search_reset(&search);
+	TEST_ASSERT_STR(first_hit(&search, "gate"), "");
+	TEST_ASSERT_STR(first_hit(&search, "garage"), "0:/SUBGHZ/garage.sgh");
+	TEST_ASSERT_EQ(m1_sig_idx_read(search.hits[0].record, &rec), FR_OK);
+	TEST_ASSERT_EQ(rec.freq_hz, 433920000);
+	TEST_ASSERT_EQ(m1_sig_idx_rename("0:/SUBGHZ/none.sgh", "0:/SUBGHZ/other.sgh"), FR_OK);
+	TEST_ASSERT_EQ(m1_sig_idx_records(), 2);
+
+	// Removing a folder drops the records below it only
+	m1_sig_idx_add(SIG_IDX_IR, "/IR/TV/power.ir", "NEC", 38000, NULL, 0);
+	m1_sig_idx_add(SIG_IDX_IR, "/IR/TV/mute.ir", "NEC", 38000, NULL, 0);
+	m1_sig_idx_add(SIG_IDX_IR, "/IR/TV_box.ir", "NEC", 38000, NULL, 0);
+	TEST_ASSERT_EQ(m1_sig_idx_remove("0:/IR/tv"), FR_OK);
+	m1_sig_idx_search_reset(&search);
+	TEST_ASSERT_EQ(m1_sig_idx_search(&search, "tv"), FR_OK);
+	TEST_ASSERT_EQ(search.n_hits, 1);
+	TEST_ASSERT_STR(first_hit(&search, "tv"), "0:/IR/TV_box.ir");
+
+	// Without an index, removing and renaming do not create one
+	f_unlink(SIG_IDX_FILE);
+	TEST_ASSERT_EQ(m1_sig_idx_remove("0:/RFID/fob.rfid"), FR_OK);
+	TEST_ASSERT_EQ(m1_sig_idx_rename("0:/RFID/fob.rfid", "0:/RFID/key.rfid"), FR_OK);
+	TEST_ASSERT(fs_file_exists(SIG_IDX_FILE)!=1);
+} // static void test_put_remove(void)
+
+
+
+static void test_rebuild(void)
+{
+	S_M1_SigIdx_Search search;
+	S_M1_SigIdx_Record rec;
+	char freq[16];
+	uint16_t count;
+
+	TEST_ASSERT_EQ(fs_directory_ensure("0:/SUBGHZ"), FR_OK);
+	TEST_ASSERT_EQ(fs_directory_ensure("0:/IR"), FR_OK);
+	TEST_ASSERT_EQ(fs_directory_ensure("0:/IR/Learned"), FR_OK);
+	TEST_ASSERT_EQ(fs_directory_ensure("0:/NFC"), FR_OK);
+	TEST_ASSERT_EQ(fs_directory_ensure("0:/RFID"), FR_OK);
+	write_file("0:/SUBGHZ/garage.sgh", "Filetype: M1 SubGHz NOISE\r\nVersion: 0.8\r\nFrequency: 315000000\r\n"
+		"Modulation: OOK\r\nData: +350 -700\r\n");
+	write_file("0:/SUBGHZ/doorbell.sub", "Filetype: Flipper SubGhz Key File\nFrequency: 433920000\nProtocol: Princeton\n");
+	write_file("0:/IR/Learned/tv.ir", "Filetype: IR signals file\nVersion: 1\n#\nname: power\ntype: raw\nfrequency: 38000\n"
+		"duty_cycle: 0.330000\ndata: 9000 4500\n");
+	write_file("0:/NFC/card.nfc", "Filetype: M1 NFC device\r\nVersion: 4\r\nDevice type: Classic\r\nUID: 04 A2 1F 9C\r\n");
+	write_file("0:/RFID/tag.rfid", "Filetype: M1 RFID key\nVersion: 1\nPackettype: EM4100\nHData: 01 02 03 04 05\n");
+	write_file("0:/NFC/notes.txt", "UID: 11 22\n");
+
+	TEST_ASSERT(m1_sig_idx_parse_file("0:/SUBGHZ/garage.sgh", SIG_IDX_SUBGHZ, &rec));
+	TEST_ASSERT_EQ(rec.freq_hz, 315000000);
+	TEST_ASSERT_STR(rec.protocol, "RAW");
+	m1_sig_idx_format_freq(&rec, freq, sizeof(freq));
+	TEST_ASSERT_STR(freq, "315.000");
+	TEST_ASSERT(m1_sig_idx_parse_file("0:/IR/Learned/tv.ir", SIG_IDX_IR, &rec));
+	m1_sig_idx_format_freq(&rec, freq, sizeof(freq));
+	TEST_ASSERT_STR(freq, "38kHz");
+	TEST_ASSERT(!m1_sig_idx_parse_file("0:/NFC/missing.nfc", SIG_IDX_NFC, &rec));
+
+	TEST_ASSERT_EQ(m1_sig_idx_rebuild(&count), FR_OK);
+	TEST_ASSERT_EQ(count, 5);
+	TEST_ASSERT_EQ(m1_sig_idx_records(), 5);
+
+	m1_sig_idx_search_reset(&search);
+	TEST_ASSERT_STR(first_hit(&search, "315"), "0:/SUBGHZ/garage.sgh");
+	TEST_ASSERT_STR(first_hit(&search, "princ"), "0:/SUBGHZ/doorbell.sub");
+	TEST_ASSERT_STR(first_hit(&search, "em41"), "0:/RFID/tag.rfid");
+	TEST_ASSERT_STR(first_hit(&search, "04a21f"), "0:/NFC/card.nfc");
+	TEST_ASSERT_STR(first_hit(&search, "38k"), "0:/IR/Learned/tv.ir");
+	TEST_ASSERT_STR(first_hit(&search, "zzz"), "");
+
+	// Everything for an empty query, the notes are not a signal
+	TEST_ASSERT_EQ(m1_sig_idx_search(&search, ""), FR_OK);
+	TEST_ASSERT_EQ(search.n_hits, 5);
+} // static void test_rebuild(void)
+
+
+
+static void test_incremental(void)
+{
+	S_M1_SigIdx_Search search, full;
+	char path[40];
+	uint16_t i;
+
+	f_unlink(SIG_IDX_FILE);
+	for ( i = 0; i < 70; i++ )
+	{
+		snprintf(path, sizeof(path), "/SUBGHZ/sig_%u.sgh", i);
+		m1_sig_idx_add(SIG_IDX_SUBGHZ, path, "RAW", 433920000, NULL, 0);
+	}
+	m1_sig_idx_add(SIG_IDX_IR, "/IR/fan.ir", "NEC", 38000, NULL, 0);
+	TEST_ASSERT_EQ(m1_sig_idx_records(), 71);
+
+	// More matches than hits: the next query reads the whole index again
+	m1_sig_idx_search_reset(&search);
+	TEST_ASSERT_EQ(m1_sig_idx_search(&search, "sig"), FR_OK);
+	TEST_ASSERT_EQ(search.n_hits, SIG_IDX_MAX_HITS);
+	TEST_ASSERT(!search.complete);
+	TEST_ASSERT_EQ(m1_sig_idx_search(&search, "Sig_6"), FR_OK);
+	TEST_ASSERT_EQ(search.n_hits, 16); // sig_6, sig_60 to sig_69 and sig_16 to sig_56
+	TEST_ASSERT(search.hits[10].score > search.hits[11].score);
+	TEST_ASSERT(search.complete);
+	TEST_ASSERT_STR(search.query, "sig_6");
+
+	// Extending a complete query only narrows, and matches a fresh search
+	TEST_ASSERT_EQ(m1_sig_idx_search(&search, "sig_65"), FR_OK);
+	m1_sig_idx_search_reset(&full);
+	TEST_ASSERT_EQ(m1_sig_idx_search(&full, "sig_65"), FR_OK);
+	TEST_ASSERT_EQ(search.n_hits, 1);
+	TEST_ASSERT_EQ(full.n_hits, 1);
+	TEST_ASSERT_EQ(search.hits[0].record, full.hits[0].record);
+	TEST_ASSERT_EQ(search.hits[0].score, full.hits[0].score);
+
+	// Any other query starts over
+	TEST_ASSERT_STR(first_hit(&search, "fan"), "0:/IR/fan.ir");
+	TEST_ASSERT_EQ(search.n_hits, 1);
+
+	// A record saved since is found by the same query
+	m1_sig_idx_add(SIG_IDX_IR, "/IR/fan_2.ir", "NEC", 38000, NULL, 0);
+	TEST_ASSERT_EQ(m1_sig_idx_search(&search, "fan"), FR_OK);
+	TEST_ASSERT_EQ(search.n_hits, 2);
+} // static void test_incremental(void)
+
+
+
+int main(void)
+{
+	TEST_RUN(test_fuzzy_score);
+	TEST_RUN(test_put_remove);
+	TEST_RUN(test_rebuild);
+	TEST_RUN(test_incremental);
+
+	return TEST_RESULT();
+} // int main(void)
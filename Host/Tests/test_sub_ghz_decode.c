@@ -0,0 +1,133 @@
+/* See COPYING.txt for license details. */
+
+/*
+*
+* test_sub_ghz_decode.c
+*
+* Unit tests of the Sub-GHz pulse handler and the Princeton decoder, fed
+* with the pulse durations the radio's capture timer would deliver
+*
+* M1 Project
+*
+*/
+
+#include <stdlib.h>
+#include "m1_sub_ghz_decenc.h"
+#include "m1_sub_ghz_api.h"
+#include "m1_host_test.h"
+
+#define TEST_TE_SHORT		370
+#define TEST_TE_LONG		1110
+#define TEST_GAP			12000
+
+static uint8_t last_stat;
+
+static void feed_pulse(uint16_t duration)
+{
+	last_stat = subghz_decenc_ctl.subghz_pulse_handler(duration);
+} // static void feed_pulse(uint16_t duration)
+
+
+
+// One Princeton packet: bit 1 |^^^|_, bit 0 |^|___, then the gap
+static void feed_princeton(uint32_t code, uint8_t bits, uint16_t te, int8_t jitter_pct)
+{
+	uint16_t s = te, l = te*3;
+	int8_t b;
+
+	s += s*jitter_pct/100;
+	l -= l*jitter_pct/100;
+	for ( b = bits - 1; b >= 0; b-- )
+	{
+		if ( (code >> b) & 1 )
+		{
+			feed_pulse(l);
+			feed_pulse(s);
+		}
+		else
+		{
+			feed_pulse(s);
+			feed_pulse(l);
+		}
+	}
+	feed_pulse(TEST_GAP);
+} // static void feed_princeton(uint32_t code, uint8_t bits, uint16_t te, int8_t jitter_pct)
+
+
+
+static void test_get_diff(void)
+{
+	TEST_ASSERT_EQ(get_diff(100, 40), 60);
+	TEST_ASSERT_EQ(get_diff(40, 100), 60);
+	TEST_ASSERT_EQ(get_diff(7, 7), 0);
+} // static void test_get_diff(void)
+
+
+
+static void test_princeton(void)
+{
+	SubGHz_Dec_Info_t info;
+
+	subghz_decenc_init();
+	feed_pulse(TEST_GAP); // receiver starts in the gap
+	feed_princeton(0xA5C33C, 24, TEST_TE_SHORT, 0);
+	TEST_ASSERT_EQ(last_stat, PULSE_DET_EOP);
+
+	memset(&info, 0, sizeof(info));
+	TEST_ASSERT(subghz_decenc_read(&info, false));
+	TEST_ASSERT_EQ(info.key, 0xA5C33C);
+	TEST_ASSERT_EQ(info.protocol, PRINCETON);
+	TEST_ASSERT_EQ(info.bit_len, 24);
+	TEST_ASSERT_STR(protocol_text[info.protocol], "Princeton");
+
+	// Read clears the result
+	TEST_ASSERT(!subghz_decenc_read(&info, false));
+
+	// Timing error within the protocol tolerance, other TE
+	feed_princeton(0x000F01, 24, 300, 8);
+	TEST_ASSERT(subghz_decenc_read(&info, false));
+	TEST_ASSERT_EQ(info.key, 0x000F01);
+} // static void test_princeton(void)
+
+
+
+static void test_reject(void)
+{
+	SubGHz_Dec_Info_t info;
+	uint8_t i;
+
+	subghz_decenc_init();
+	feed_pulse(TEST_GAP);
+
+	// Too short a packet is not decoded
+	feed_princeton(0x5A5, 12, TEST_TE_SHORT, 0);
+	TEST_ASSERT(!subghz_decenc_read(&info, false));
+
+	// Long/short ratio far from 3
+	feed_princeton(0xA5C33C, 24, TEST_TE_SHORT, 40);
+	TEST_ASSERT(!subghz_decenc_read(&info, false));
+
+	// Glitches below PACKET_PULSE_TIME_MIN restart the packet
+	for ( i = 0; i < 20; i++ )
+		feed_pulse(TEST_TE_SHORT);
+	feed_pulse(PACKET_PULSE_TIME_MIN - 1);
+	TEST_ASSERT_EQ(subghz_decenc_ctl.npulsecount, 0);
+	TEST_ASSERT_EQ(last_stat, PULSE_DET_NORMAL);
+
+	// Overflow of the pulse buffer
+	for ( i = 0; i <= PACKET_PULSE_COUNT_MAX; i++ )
+		feed_pulse(TEST_TE_SHORT);
+	TEST_ASSERT_EQ(last_stat, PULSE_DET_IDLE);
+	TEST_ASSERT_EQ(subghz_decenc_ctl.npulsecount, 0);
+} // static void test_reject(void)
+
+
+
+int main(void)
+{
+	TEST_RUN(test_get_diff);
+	TEST_RUN(test_princeton);
+	TEST_RUN(test_reject);
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,197 @@
+/* See COPYING.txt for license details. */
+
+/*
+*
+* test_text_cache.c
+*
+* Unit tests of m1_text_cache.c
+*
+* M1 Project
+*
+*/
+
+#include <string.h>
+#include "m1_text_cache.h"
+#include "m1_host_test.h"
+
+#define BUF_W		128
+#define BUF_H		64
+
+static const uint8_t font_a[1];
+static const uint8_t font_b[1];
+static uint32_t render_calls;
+
+// Every character is a 4x10 glyph box with a 2 pixel wide stem, one column in
+static bool fake_render(const void *font, const char *str, S_M1_Text_Run *prun)
+{
+	uint8_t len = (uint8_t)strlen(str), i;
+
+	(void)font;
+	render_calls++;
+	if ( len*4 >= M1_TEXT_CACHE_RUN_W_MAX ) // No room left for a margin
+		return false;
+
+	prun->x_off = 0;
+	prun->y_off = -8; // 8 rows above the baseline, 2 below
+	prun->w = len*4;
+	prun->h = 10;
+	prun->advance = len*4;
+	for (i=0; i<prun->w; i++)
+	{
+		prun->box[0][i] = 0xFF;
+		prun->box[1][i] = 0xFF; // Past h, trimmed by the cache
+		if ( i%4==1 || i%4==2 )
+		{
+			prun->ink[0][i] = 0xFF;
+			prun->ink[1][i] = 0x03;
+		}
+	}
+
+	return true;
+} // static bool fake_render(const void *font, const char *str, S_M1_Text_Run *prun)
+
+
+
+static bool pixel(const uint8_t *pbuf, int x, int y)
+{
+	return (pbuf[(y/8)*BUF_W + x] >> (y%8)) & 1;
+} // static bool pixel(const uint8_t *pbuf, int x, int y)
+
+
+
+static void test_hits_and_eviction(void)
+{
+	S_M1_Text_Cache cache;
+	const S_M1_Text_Run *prun;
+	char str[8];
+	uint8_t i;
+
+	m1_text_cache_init(&cache, fake_render);
+	render_calls = 0;
+
+	prun = m1_text_cache_get(&cache, font_a, "Sub-GHz");
+	TEST_ASSERT(prun!=NULL);
+	TEST_ASSERT_EQ(prun->advance, 28);
+	TEST_ASSERT_EQ(prun->box[1][0], 0x03); // Rows past h trimmed
+	TEST_ASSERT(m1_text_cache_get(&cache, font_a, "Sub-GHz")==prun);
+	TEST_ASSERT(m1_text_cache_get(&cache, font_b, "Sub-GHz")!=prun); // Keyed by font too
+	TEST_ASSERT_EQ(cache.hits, 1);
+	TEST_ASSERT_EQ(cache.misses, 2);
+	TEST_ASSERT_EQ(render_calls, 2);
+
+	// Fill the cache, keeping "Sub-GHz" in use: the others are evicted first
+	for (i=0; i<M1_TEXT_CACHE_SLOTS + 4; i++)
+	{
+		str[0] = 'a' + i;
+		str[1] = '\0';
+		TEST_ASSERT(m1_text_cache_get(&cache, font_a, str)!=NULL);
+		TEST_ASSERT(m1_text_cache_get(&cache, font_a, "Sub-GHz")!=NULL);
+	}
+	render_calls = 0;
+	m1_text_cache_get(&cache, font_a, "Sub-GHz");
+	TEST_ASSERT_EQ(render_calls, 0);
+	m1_text_cache_get(&cache, font_a, "a");
+	TEST_ASSERT_EQ(render_calls, 1);
+
+	m1_text_cache_flush(&cache);
+	m1_text_cache_get(&cache, font_a, "Sub-GHz");
+	TEST_ASSERT_EQ(render_calls, 2);
+} // static void test_hits_and_eviction(void)
+
+
+
+static void test_bypass(void)
+{
+	S_M1_Text_Cache cache;
+	char long_str[M1_TEXT_CACHE_STR_MAX + 2];
+
+	m1_text_cache_init(&cache, fake_render);
+	render_calls = 0;
+
+	memset(long_str, 'x', sizeof(long_str) - 1);
+	long_str[sizeof(long_str) - 1] = '\0';
+	TEST_ASSERT(m1_text_cache_get(&cache, font_a, long_str)==NULL);
+	TEST_ASSERT_EQ(render_calls, 0);
+
+	// Fits the key, too wide for a run
+	long_str[M1_TEXT_CACHE_STR_MAX] = '\0';
+	TEST_ASSERT(m1_text_cache_get(&cache, font_a, long_str)==NULL);
+	TEST_ASSERT(m1_text_cache_get(&cache, font_a, long_str)==NULL);
+	TEST_ASSERT_EQ(render_calls, 2);
+	TEST_ASSERT_EQ(cache.bypasses, 3);
+
+	TEST_ASSERT(m1_text_cache_get(&cache, font_a, "")==NULL);
+} // static void test_bypass(void)
+
+
+
+static void test_blit(void)
+{
+	S_M1_Text_Cache cache;
+	const S_M1_Text_Run *prun;
+	uint8_t buf[BUF_W*BUF_H/8];
+	int y;
+
+	m1_text_cache_init(&cache, fake_render);
+	prun = m1_text_cache_get(&cache, font_a, "ab");
+
+	// Transparent, baseline off the page grid: rows 13..22, stems in columns 11, 12, 15, 16
+	memset(buf, 0, sizeof(buf));
+	m1_text_run_blit(prun, buf, BUF_W, BUF_H, 10, 21, M1_TEXT_COLOR_SET, false, false);
+	for (y=0; y<BUF_H; y++)
+	{
+		TEST_ASSERT_EQ(pixel(buf, 11, y), y>=13 && y<=22);
+		TEST_ASSERT_EQ(pixel(buf, 16, y), y>=13 && y<=22);
+		TEST_ASSERT(!pixel(buf, 10, y));
+		TEST_ASSERT(!pixel(buf, 13, y));
+	}
+
+	// The same into a buffer turned by 180 degrees
+	memset(buf, 0, sizeof(buf));
+	m1_text_run_blit(prun, buf, BUF_W, BUF_H, 10, 21, M1_TEXT_COLOR_SET, false, true);
+	for (y=0; y<BUF_H; y++)
+	{
+		TEST_ASSERT_EQ(pixel(buf, BUF_W - 1 - 11, BUF_H - 1 - y), y>=13 && y<=22);
+		TEST_ASSERT_EQ(pixel(buf, BUF_W - 1 - 16, BUF_H - 1 - y), y>=13 && y<=22);
+		TEST_ASSERT(!pixel(buf, BUF_W - 1 - 10, BUF_H - 1 - y));
+		TEST_ASSERT(!pixel(buf, 11, y));
+	}
+
+	// Solid in the background color, as the selected menu row: the box is set, the stems cleared
+	memset(buf, 0, sizeof(buf));
+	m1_text_run_blit(prun, buf, BUF_W, BUF_H, 10, 21, M1_TEXT_COLOR_CLEAR, true, false);
+	TEST_ASSERT(pixel(buf, 10, 13));
+	TEST_ASSERT(pixel(buf, 17, 22));
+	TEST_ASSERT(!pixel(buf, 11, 13));
+	TEST_ASSERT(!pixel(buf, 16, 22));
+	TEST_ASSERT(!pixel(buf, 10, 23));
+	TEST_ASSERT(!pixel(buf, 18, 13));
+
+	// XOR twice restores the buffer
+	memset(buf, 0x5A, sizeof(buf));
+	m1_text_run_blit(prun, buf, BUF_W, BUF_H, 3, 40, M1_TEXT_COLOR_XOR, false, false);
+	TEST_ASSERT(!pixel(buf, 4, 33)); // 0x5A has row 1 of each page set
+	m1_text_run_blit(prun, buf, BUF_W, BUF_H, 3, 40, M1_TEXT_COLOR_XOR, false, false);
+	TEST_ASSERT_EQ(buf[4*BUF_W + 4], 0x5A);
+
+	// Clipped on every edge
+	memset(buf, 0, sizeof(buf));
+	m1_text_run_blit(prun, buf, BUF_W, BUF_H, -2, 3, M1_TEXT_COLOR_SET, false, false);
+	TEST_ASSERT(pixel(buf, 0, 0));
+	TEST_ASSERT(pixel(buf, 0, 4));
+	TEST_ASSERT(!pixel(buf, 0, 5));
+	m1_text_run_blit(prun, buf, BUF_W, BUF_H, BUF_W - 4, BUF_H + 7, M1_TEXT_COLOR_SET, false, false);
+	TEST_ASSERT(pixel(buf, BUF_W - 3, BUF_H - 1));
+	TEST_ASSERT(!pixel(buf, BUF_W - 3, BUF_H - 2));
+} // static void test_blit(void)
+
+
+
+int main(void)
+{
+	TEST_RUN(test_hits_and_eviction);
+	TEST_RUN(test_bypass);
+	TEST_RUN(test_blit);
+
+	return TEST_RESULT();
+} // int main(void)
@@ -0,0 +1,247 @@
+/* See COPYING.txt for license details. */
+
+/*
+*
+* test_text_draw.c
+*
+* Unit tests of m1_text_draw.c, against the real u8g2 in the rotation the
+* M1 display uses (U8G2_R2)
+*
+* M1 Project
+*
+*/
+
+#include <string.h>
+#include "u8g2.h"
+#include "m1_text_draw.h"
+#include "m1_host_test.h"
+
+#define BUF_W			128
+#define BUF_H			64
+
+// Font of a few glyphs, encoded by font_build(): one bit per run, a run per pixel
+#define FONT_BITS_W		4
+#define FONT_BITS_H		4
+#define FONT_BITS_X		3
+#define FONT_BITS_Y		3
+#define FONT_BITS_DX	4
+#define FONT_HEADER		23
+
+typedef struct
+{
+	char enc;
+	int8_t x; // Left of the box from the origin
+	int8_t y; // Bottom of the box from the baseline
+	int8_t dx;
+	const char *rows[10]; // Top down, '#' is ink
+} S_Test_Glyph;
+
+static const S_Test_Glyph test_glyphs[] =
+{
+	{' ', 0, 0, 3, {NULL}},
+	{'H', 0, 0, 6, {"#...#", "#...#", "#...#", "#####", "#...#", "#...#", "#...#", NULL}},
+	{'g', 0, -2, 5, {".###", "#..#", "#..#", ".###", "...#", "#..#", ".##.", NULL}},
+	{'i', 0, 0, 2, {"#", ".", "#", "#", "#", "#", "#", NULL}},
+	{'j', -1, -2, 3, {"..#", "...", "..#", "..#", "..#", "..#", "..#", "#.#", ".#.", NULL}},
+};
+
+static uint8_t test_font[512];
+static uint8_t frame_buf[BUF_W*BUF_H/8];
+static uint8_t expected[BUF_W*BUF_H/8];
+static u8g2_t disp;
+
+static uint8_t *bits_ptr;
+static uint8_t bits_pos;
+
+static void bits_put(uint32_t val, uint8_t cnt)
+{
+	while ( cnt-- )
+	{
+		if ( val & 1 )
+			*bits_ptr |= (uint8_t)(1 << bits_pos);
+		val >>= 1;
+		if ( ++bits_pos==8 )
+		{
+			bits_pos = 0;
+			bits_ptr++;
+		}
+	}
+} // static void bits_put(uint32_t val, uint8_t cnt)
+
+
+
+// u8g2 font format: 23 byte header, then encoding, size, bit stream per glyph
+static void font_build(void)
+{
+	uint8_t *pglyph;
+	uint8_t i, w, h, row, col;
+
+	memset(test_font, 0, sizeof(test_font));
+	test_font[0] = sizeof(test_glyphs)/sizeof(test_glyphs[0]);
+	test_font[2] = 1; // bits_per_0
+	test_font[3] = 1; // bits_per_1
+	test_font[4] = FONT_BITS_W;
+	test_font[5] = FONT_BITS_H;
+	test_font[6] = FONT_BITS_X;
+	test_font[7] = FONT_BITS_Y;
+	test_font[8] = FONT_BITS_DX;
+	test_font[9] = 5; // max_char_width
+	test_font[10] = 9; // max_char_height
+	test_font[11] = (uint8_t)-1; // x_offset
+	test_font[12] = (uint8_t)-2; // y_offset
+	test_font[13] = 7; // ascent 'A'
+	test_font[14] = (uint8_t)-2; // descent 'g'
+	test_font[15] = 7;
+	test_font[16] = (uint8_t)-2;
+	// 'A' and 'a' start the search at the first glyph
+
+	pglyph = &test_font[FONT_HEADER];
+	for (i=0; i<sizeof(test_glyphs)/sizeof(test_glyphs[0]); i++)
+	{
+		const S_Test_Glyph *pg = &test_glyphs[i];
+
+		for (h=0; pg->rows[h]; h++)
+			;
+		w = h ? (uint8_t)strlen(pg->rows[0]) : 0;
+
+		pglyph[0] = (uint8_t)pg->enc;
+		bits_ptr = &pglyph[2];
+		bits_pos = 0;
+		bits_put(w, FONT_BITS_W);
+		bits_put(h, FONT_BITS_H);
+		bits_put((uint32_t)(pg->x + (1 << (FONT_BITS_X - 1))), FONT_BITS_X);
+		bits_put((uint32_t)(pg->y + (1 << (FONT_BITS_Y - 1))), FONT_BITS_Y);
+		bits_put((uint32_t)(pg->dx + (1 << (FONT_BITS_DX - 1))), FONT_BITS_DX);
+		for (row=0; row<h; row++)
+		{
+			for (col=0; col<w; col++)
+			{
+				// Run of 0 or 1 background pixels, then of 1 or 0 ink pixels, no repeat
+				bits_put(pg->rows[row][col]=='#' ? 0 : 1, 1);
+				bits_put(pg->rows[row][col]=='#' ? 1 : 0, 1);
+				bits_put(0, 1);
+			}
+		}
+		if ( bits_pos )
+			bits_ptr++;
+		pglyph[1] = (uint8_t)(bits_ptr - pglyph);
+		pglyph = bits_ptr;
+	} // for (i=0; ...)
+
+	// Two zero bytes end the list; the unicode table is never reached
+	test_font[21] = (uint8_t)((pglyph - &test_font[FONT_HEADER]) >> 8);
+	test_font[22] = (uint8_t)(pglyph - &test_font[FONT_HEADER]);
+} // static void font_build(void)
+
+
+
+static void disp_setup(const u8g2_cb_t *rotation)
+{
+	u8g2_SetupDisplay(&disp, u8x8_d_st7567_enh_dg128064i, u8x8_cad_001, u8x8_byte_empty, u8x8_dummy_cb);
+	u8g2_SetupBuffer(&disp, frame_buf, BUF_H/8, u8g2_ll_hvline_vertical_top_lsb, rotation);
+	u8g2_SetFont(&disp, test_font);
+	m1_text_draw_init(&disp);
+} // static void disp_setup(const u8g2_cb_t *rotation)
+
+
+
+// Draws str both ways over the same background, returns true if the frames match
+static bool draw_matches(u8g2_uint_t x, u8g2_uint_t y, const char *str, uint8_t color, uint8_t transparent)
+{
+	u8g2_uint_t w_ref, w;
+	uint16_t i;
+
+	u8g2_SetDrawColor(&disp, color);
+	u8g2_SetFontMode(&disp, transparent);
+
+	for (i=0; i<sizeof(frame_buf); i++)
+		frame_buf[i] = (uint8_t)(i*37 + 11); // Some of everything under the text
+	w_ref = u8g2_DrawStr(&disp, x, y, str);
+	memcpy(expected, frame_buf, sizeof(expected));
+
+	for (i=0; i<sizeof(frame_buf); i++)
+		frame_buf[i] = (uint8_t)(i*37 + 11);
+	w = m1_draw_str(&disp, x, y, str);
+
+	return w==w_ref && !memcmp(frame_buf, expected, sizeof(expected));
+} // static bool draw_matches(u8g2_uint_t x, u8g2_uint_t y, const char *str, uint8_t color, uint8_t transparent)
+
+
+
+static void test_rotated_display(void)
+{
+	static const char *strs[] = {"High", "jig Hi", "H"};
+	static const u8g2_uint_t pos[][2] = {{4, 20}, {0, 9}, {37, 35}, {120, 63}, {100, 61}};
+	uint8_t s, p, color, transparent;
+	uint32_t hits;
+
+	font_build();
+	disp_setup(U8G2_R2);
+
+	// Every string, position, color and font mode; each draw after the first one is a hit
+	for (s=0; s<sizeof(strs)/sizeof(strs[0]); s++)
+		for (p=0; p<sizeof(pos)/sizeof(pos[0]); p++)
+			for (color=0; color<=2; color++)
+				for (transparent=0; transparent<=1; transparent++)
+					TEST_ASSERT(draw_matches(pos[p][0], pos[p][1], strs[s], color, transparent));
+
+	hits = m1_text_draw_cache()->hits;
+	TEST_ASSERT_EQ(m1_text_draw_cache()->misses, sizeof(strs)/sizeof(strs[0]));
+	TEST_ASSERT_EQ(hits, sizeof(strs)/sizeof(strs[0])*(sizeof(pos)/sizeof(pos[0])*3*2 - 1));
+
+	// The ink really lands in the opposite corner of the buffer: "H" at the top left
+	memset(frame_buf, 0, sizeof(frame_buf));
+	u8g2_SetDrawColor(&disp, 1);
+	m1_draw_str(&disp, 0, 7, "H");
+	TEST_ASSERT_EQ(frame_buf[(BUF_H/8 - 1)*BUF_W + BUF_W - 1], 0xFE); // Rows 0..6 of column 0
+	TEST_ASSERT_EQ(frame_buf[0], 0x00);
+} // static void test_rotated_display(void)
+
+
+
+static void test_other_setups(void)
+{
+	uint32_t hits;
+
+	// Unrotated display
+	disp_setup(U8G2_R0);
+	TEST_ASSERT(draw_matches(4, 20, "jig Hi", 1, 0));
+	TEST_ASSERT(draw_matches(4, 20, "jig Hi", 0, 0));
+	TEST_ASSERT_EQ(m1_text_draw_cache()->hits, 1);
+
+	// Quarter turns and clip windows are left to u8g2
+	disp_setup(U8G2_R1);
+	TEST_ASSERT(draw_matches(4, 20, "High", 1, 1));
+	TEST_ASSERT(draw_matches(4, 20, "High", 1, 1));
+	TEST_ASSERT_EQ(m1_text_draw_cache()->hits + m1_text_draw_cache()->misses, 0);
+
+	disp_setup(U8G2_R2);
+	u8g2_SetClipWindow(&disp, 0, 0, 64, 64);
+	TEST_ASSERT(draw_matches(50, 20, "High", 1, 1));
+	TEST_ASSERT_EQ(m1_text_draw_cache()->hits + m1_text_draw_cache()->misses, 0);
+	u8g2_SetMaxClipWindow(&disp);
+	TEST_ASSERT(draw_matches(50, 20, "High", 1, 1));
+	TEST_ASSERT(draw_matches(50, 20, "High", 1, 1));
+	hits = m1_text_draw_cache()->hits;
+	TEST_ASSERT_EQ(hits, 1);
+
+	// Too wide for a run
+	TEST_ASSERT(draw_matches(0, 30, "ggggggggggggggggggggggggggggg", 1, 0));
+	TEST_ASSERT_EQ(m1_text_draw_cache()->bypasses, 1);
+
+	// Another display is not cached
+	disp_setup(U8G2_R2);
+	m1_text_draw_init(NULL);
+	TEST_ASSERT(draw_matches(4, 20, "High", 1, 0));
+	TEST_ASSERT_EQ(m1_text_draw_cache()->misses, 0);
+} // static void test_other_setups(void)
+
+
+
+int main(void)
+{
+	TEST_RUN(test_rotated_display);
+	TEST_RUN(test_other_setups);
+
+	return TEST_RESULT();
+} // int main(void)
@@ -0,0 +1,395 @@
+/* See COPYING.txt for license details. */
+
+/*
+*
+* test_usb_pd.c
+*
+* Unit tests of m1_usb_pd.c, driven by message traces of real chargers
+*
+* M1 Project
+*
+*/
+
+#include <string.h>
+#include "m1_usb_pd.h"
+#include "m1_host_test.h"
+
+#define MAX_SENT		16
+
+// Source_Capabilities of a PD 3.0 45 W charger: 5V 3A, 9V 3A, 15V 3A, 20V 2.25A, PPS 3.3-11V
+static const uint8_t trace_pd30_caps[] =
+{
+	0xA1, 0x51,
+	0x2C, 0x91, 0x01, 0x0A,
+	0x2C, 0xD1, 0x02, 0x00,
+	0x2C, 0xB1, 0x04, 0x00,
+	0xE1, 0x40, 0x06, 0x00,
+	0x3C, 0x21, 0xDC, 0xC0
+};
+
+// Source_Capabilities of a PD 2.0 18 W charger: 5V 2A, 9V 1.67A, 12V 1.5A
+static const uint8_t trace_pd20_caps[] =
+{
+	0x41, 0x31,
+	0xC8, 0x90, 0x01, 0x00,
+	0xA7, 0xD0, 0x02, 0x00,
+	0x96, 0xC0, 0x03, 0x00
+};
+
+static S_M1_UsbPd_Msg sent[MAX_SENT];
+static uint8_t n_sent;
+static bool transmit_ok;
+static uint8_t n_hard_resets;
+static uint8_t n_contracts;
+static uint16_t last_mv, last_ma;
+
+static bool fake_transmit(void *ctx, const S_M1_UsbPd_Msg *pmsg)
+{
+	(void)ctx;
+	TEST_ASSERT(n_sent < MAX_SENT);
+	sent[n_sent++] = *pmsg;
+
+	return transmit_ok;
+} // static bool fake_transmit(void *ctx, const S_M1_UsbPd_Msg *pmsg)
+
+
+
+static void fake_hard_reset(void *ctx)
+{
+	(void)ctx;
+	n_hard_resets++;
+} // static void fake_hard_reset(void *ctx)
+
+
+
+static void fake_contract(void *ctx, uint16_t mv, uint16_t ma)
+{
+	(void)ctx;
+	n_contracts++;
+	last_mv = mv;
+	last_ma = ma;
+} // static void fake_contract(void *ctx, uint16_t mv, uint16_t ma)
+
+
+
+static S_M1_UsbPd_Sink_Config cfg =
+{
+	.max_mv = 12000,
+	.max_ma = 3000,
+	.spec_rev = USB_PD_REV30,
+	.transmit = fake_transmit,
+	.hard_reset = fake_hard_reset,
+	.contract = fake_contract,
+	.ctx = NULL
+};
+
+
+
+static void reset(S_M1_UsbPd_Sink *pe)
+{
+	n_sent = 0;
+	transmit_ok = true;
+	n_hard_resets = 0;
+	n_contracts = 0;
+	last_mv = 0;
+	last_ma = 0;
+	m1_usb_pd_sink_init(pe, &cfg);
+	m1_usb_pd_sink_attach(pe, 0);
+} // static void reset(S_M1_UsbPd_Sink *pe)
+
+
+
+// Feeds a captured message to the sink
+static void rx_trace(S_M1_UsbPd_Sink *pe, const uint8_t *buf, uint8_t len, uint32_t now_ms)
+{
+	S_M1_UsbPd_Msg msg;
+
+	TEST_ASSERT(m1_usb_pd_msg_decode(buf, len, &msg));
+	m1_usb_pd_sink_rx(pe, &msg, now_ms);
+} // static void rx_trace(S_M1_UsbPd_Sink *pe, const uint8_t *buf, uint8_t len, uint32_t now_ms)
+
+
+
+// A message from a PD 3.0 source
+static void rx_msg(S_M1_UsbPd_Sink *pe, uint8_t type, uint8_t n_obj, uint8_t id, const uint32_t *pobj, uint32_t now_ms)
+{
+	S_M1_UsbPd_Msg msg;
+
+	memset(&msg, 0, sizeof(msg));
+	msg.header = m1_usb_pd_header(type, n_obj, id, USB_PD_REV30) | 0x0120; // Source, DFP
+	if ( n_obj )
+		memcpy(msg.obj, pobj, n_obj*sizeof(uint32_t));
+	m1_usb_pd_sink_rx(pe, &msg, now_ms);
+} // static void rx_msg(S_M1_UsbPd_Sink *pe, uint8_t type, uint8_t n_obj, uint8_t id, const uint32_t *pobj, uint32_t now_ms)
+
+
+
+static void test_codec(void)
+{
+	S_M1_UsbPd_Msg msg;
+	uint8_t buf[USB_PD_MAX_MSG_LEN];
+	const uint8_t request[] = {0x82, 0x10, 0x2C, 0xB1, 0x04, 0x23};
+
+	TEST_ASSERT(m1_usb_pd_msg_decode(trace_pd30_caps, sizeof(trace_pd30_caps), &msg));
+	TEST_ASSERT_EQ(USB_PD_HDR_TYPE(msg.header), USB_PD_DATA_SOURCE_CAP);
+	TEST_ASSERT_EQ(USB_PD_HDR_REV(msg.header), USB_PD_REV30);
+	TEST_ASSERT_EQ(USB_PD_HDR_NUM_OBJ(msg.header), 5);
+	TEST_ASSERT_EQ(msg.obj[0], 0x0A01912C);
+	TEST_ASSERT_EQ(USB_PD_PDO_FIXED_MV(msg.obj[1]), 9000);
+	TEST_ASSERT_EQ(USB_PD_PDO_FIXED_MA(msg.obj[3]), 2250);
+	TEST_ASSERT_EQ(USB_PD_PDO_TYPE(msg.obj[4]), USB_PD_PDO_AUGMENTED);
+
+	// Round trip
+	TEST_ASSERT_EQ(m1_usb_pd_msg_encode(&msg, buf), sizeof(trace_pd30_caps));
+	TEST_ASSERT_MEM(buf, trace_pd30_caps, sizeof(trace_pd30_caps));
+
+	// Request of the 9V supply, as sent by a PD 3.0 sink
+	memset(&msg, 0, sizeof(msg));
+	msg.header = m1_usb_pd_header(USB_PD_DATA_REQUEST, 1, 0, USB_PD_REV30);
+	msg.obj[0] = m1_usb_pd_rdo_fixed(2, 3000, 3000);
+	TEST_ASSERT_EQ(msg.header, 0x1082);
+	TEST_ASSERT_EQ(msg.obj[0], 0x2304B12C);
+	TEST_ASSERT_EQ(m1_usb_pd_msg_encode(&msg, buf), sizeof(request));
+	TEST_ASSERT_MEM(buf, request, sizeof(request));
+
+	// Truncated messages are refused
+	TEST_ASSERT(!m1_usb_pd_msg_decode(trace_pd30_caps, 1, &msg));
+	TEST_ASSERT(!m1_usb_pd_msg_decode(trace_pd30_caps, sizeof(trace_pd30_caps) - 1, &msg));
+	TEST_ASSERT(!m1_usb_pd_msg_decode(request, 2, &msg));
+} // static void test_codec(void)
+
+
+
+static void test_select(void)
+{
+	S_M1_UsbPd_Msg msg;
+	uint16_t mv = 0, ma = 0;
+
+	m1_usb_pd_msg_decode(trace_pd30_caps, sizeof(trace_pd30_caps), &msg);
+	TEST_ASSERT_EQ(m1_usb_pd_select_pdo(msg.obj, 5, 12000, 3000, &mv, &ma), 2);
+	TEST_ASSERT_EQ(mv, 9000);
+	TEST_ASSERT_EQ(ma, 3000);
+	TEST_ASSERT_EQ(m1_usb_pd_select_pdo(msg.obj, 5, 20000, 3000, &mv, &ma), 3);
+	TEST_ASSERT_EQ(mv, 15000);
+
+	// Same power at 5V and 9V when the current is capped: the lower voltage
+	TEST_ASSERT_EQ(m1_usb_pd_select_pdo(msg.obj, 5, 5000, 1500, &mv, &ma), 1);
+	TEST_ASSERT_EQ(ma, 1500);
+	TEST_ASSERT_EQ(m1_usb_pd_select_pdo(msg.obj, 5, 4000, 1500, &mv, &ma), 0);
+
+	// The PPS supply alone is not vSafe5V
+	TEST_ASSERT_EQ(m1_usb_pd_select_pdo(&msg.obj[4], 1, 12000, 3000, &mv, &ma), 0);
+
+	m1_usb_pd_msg_decode(trace_pd20_caps, sizeof(trace_pd20_caps), &msg);
+	TEST_ASSERT_EQ(m1_usb_pd_select_pdo(msg.obj, 3, 12000, 3000, &mv, &ma), 3);
+	TEST_ASSERT_EQ(mv, 12000);
+	TEST_ASSERT_EQ(ma, 1500);
+} // static void test_select(void)
+
+
+
+static void test_negotiate_pd30(void)
+{
+	S_M1_UsbPd_Sink pe;
+
+	reset(&pe);
+	TEST_ASSERT_EQ(pe.state, USB_PD_SNK_WAIT_CAPS);
+
+	rx_trace(&pe, trace_pd30_caps, sizeof(trace_pd30_caps), 100);
+	TEST_ASSERT_EQ(pe.state, USB_PD_SNK_SELECT_CAP);
+	TEST_ASSERT_EQ(n_sent, 1);
+	TEST_ASSERT_EQ(sent[0].header, 0x1082);
+	TEST_ASSERT_EQ(sent[0].obj[0], 0x2304B12C);
+	TEST_ASSERT_EQ(m1_usb_pd_sink_timeout(&pe, 100), USB_PD_T_SENDER_RESPONSE);
+
+	rx_msg(&pe, USB_PD_CTRL_ACCEPT, 0, 1, NULL, 105);
+	TEST_ASSERT_EQ(pe.state, USB_PD_SNK_TRANSITION);
+	TEST_ASSERT_EQ(n_contracts, 0);
+
+	// The supply is still settling, the timer keeps running
+	m1_usb_pd_sink_tick(&pe, 300);
+	TEST_ASSERT_EQ(pe.state, USB_PD_SNK_TRANSITION);
+
+	rx_msg(&pe, USB_PD_CTRL_PS_RDY, 0, 2, NULL, 400);
+	TEST_ASSERT_EQ(pe.state, USB_PD_SNK_READY);
+	TEST_ASSERT(pe.explicit_contract);
+	TEST_ASSERT_EQ(n_contracts, 1);
+	TEST_ASSERT_EQ(last_mv, 9000);
+	TEST_ASSERT_EQ(last_ma, 3000);
+	TEST_ASSERT_EQ(m1_usb_pd_sink_timeout(&pe, 400), UINT32_MAX);
+
+	// A retry of PS_RDY is dropped
+	rx_msg(&pe, USB_PD_CTRL_PS_RDY, 0, 2, NULL, 410);
+	TEST_ASSERT_EQ(pe.state, USB_PD_SNK_READY);
+	TEST_ASSERT_EQ(n_sent, 1);
+
+	// A source that sends its capabilities again gets a new request, ID 1
+	rx_msg(&pe, USB_PD_DATA_SOURCE_CAP, 5, 3, pe.pdos, 5000);
+	TEST_ASSERT_EQ(pe.state, USB_PD_SNK_SELECT_CAP);
+	TEST_ASSERT_EQ(n_sent, 2);
+	TEST_ASSERT_EQ(USB_PD_HDR_ID(sent[1].header), 1);
+
+	// Rejected: the contract in place holds
+	rx_msg(&pe, USB_PD_CTRL_REJECT, 0, 4, NULL, 5010);
+	TEST_ASSERT_EQ(pe.state, USB_PD_SNK_READY);
+	TEST_ASSERT_EQ(n_contracts, 1);
+
+	m1_usb_pd_sink_detach(&pe);
+	TEST_ASSERT_EQ(pe.state, USB_PD_SNK_DETACHED);
+	TEST_ASSERT_EQ(n_contracts, 2);
+	TEST_ASSERT_EQ(last_mv, USB_PD_VSAFE5V_MV);
+	TEST_ASSERT_EQ(last_ma, USB_PD_DEFAULT_MA);
+
+	// Nothing is answered while detached
+	rx_trace(&pe, trace_pd30_caps, sizeof(trace_pd30_caps), 6000);
+	TEST_ASSERT_EQ(n_sent, 2);
+} // static void test_negotiate_pd30(void)
+
+
+
+static void test_negotiate_pd20(void)
+{
+	S_M1_UsbPd_Sink pe;
+
+	reset(&pe);
+	rx_trace(&pe, trace_pd20_caps, sizeof(trace_pd20_caps), 50);
+	TEST_ASSERT_EQ(pe.spec_rev, USB_PD_REV20);
+	TEST_ASSERT_EQ(sent[0].header, 0x1042);
+	TEST_ASSERT_EQ(sent[0].obj[0], 0x33025896);
+	TEST_ASSERT_EQ(USB_PD_RDO_POSITION(sent[0].obj[0]), 3);
+
+	rx_msg(&pe, USB_PD_CTRL_ACCEPT, 0, 1, NULL, 60);
+	rx_msg(&pe, USB_PD_CTRL_PS_RDY, 0, 2, NULL, 200);
+	TEST_ASSERT_EQ(last_mv, 12000);
+	TEST_ASSERT_EQ(last_ma, 1500);
+
+	// PD 2.0 has no Not_Supported: swaps are rejected
+	rx_msg(&pe, USB_PD_CTRL_DR_SWAP, 0, 3, NULL, 300);
+	TEST_ASSERT_EQ(pe.state, USB_PD_SNK_READY);
+	TEST_ASSERT_EQ(USB_PD_HDR_TYPE(sent[1].header), USB_PD_CTRL_REJECT);
+	TEST_ASSERT_EQ(USB_PD_HDR_REV(sent[1].header), USB_PD_REV20);
+
+	// Sink capabilities: vSafe5V and 12V, both at 3A
+	rx_msg(&pe, USB_PD_CTRL_GET_SINK_CAP, 0, 4, NULL, 400);
+	TEST_ASSERT_EQ(USB_PD_HDR_TYPE(sent[2].header), USB_PD_DATA_SINK_CAP);
+	TEST_ASSERT_EQ(USB_PD_HDR_NUM_OBJ(sent[2].header), 2);
+	TEST_ASSERT_EQ(sent[2].obj[0], 0x1401912C);
+	TEST_ASSERT_EQ(sent[2].obj[1], 0x0003C12C);
+
+	// Ping and vendor messages need no answer
+	rx_msg(&pe, USB_PD_CTRL_PING, 0, 5, NULL, 500);
+	TEST_ASSERT_EQ(n_sent, 3);
+} // static void test_negotiate_pd20(void)
+
+
+
+static void test_no_pd(void)
+{
+	S_M1_UsbPd_Sink pe;
+
+	// A Type-C only source never sends capabilities: two hard resets, then it is left alone
+	reset(&pe);
+	m1_usb_pd_sink_tick(&pe, USB_PD_T_SINK_WAIT_CAP - 1);
+	TEST_ASSERT_EQ(n_hard_resets, 0);
+	m1_usb_pd_sink_tick(&pe, USB_PD_T_SINK_WAIT_CAP);
+	TEST_ASSERT_EQ(n_hard_resets, 1);
+	TEST_ASSERT_EQ(pe.state, USB_PD_SNK_WAIT_CAPS);
+	TEST_ASSERT_EQ(m1_usb_pd_sink_timeout(&pe, USB_PD_T_SINK_WAIT_CAP), USB_PD_T_HARD_RESET_RECOVER);
+
+	m1_usb_pd_sink_tick(&pe, 10000);
+	TEST_ASSERT_EQ(n_hard_resets, 2);
+	m1_usb_pd_sink_tick(&pe, 20000);
+	TEST_ASSERT_EQ(n_hard_resets, 2);
+	TEST_ASSERT_EQ(pe.state, USB_PD_SNK_DISABLED);
+	TEST_ASSERT_EQ(m1_usb_pd_sink_timeout(&pe, 20000), UINT32_MAX);
+	TEST_ASSERT_EQ(n_sent, 0);
+	TEST_ASSERT_EQ(n_contracts, 0);
+
+	// A source that starts talking late is still served
+	rx_trace(&pe, trace_pd20_caps, sizeof(trace_pd20_caps), 30000);
+	TEST_ASSERT_EQ(pe.state, USB_PD_SNK_SELECT_CAP);
+} // static void test_no_pd(void)
+
+
+
+static void test_errors(void)
+{
+	S_M1_UsbPd_Sink pe;
+
+	// No answer to the request
+	reset(&pe);
+	rx_trace(&pe, trace_pd30_caps, sizeof(trace_pd30_caps), 100);
+	m1_usb_pd_sink_tick(&pe, 100 + USB_PD_T_SENDER_RESPONSE);
+	TEST_ASSERT_EQ(n_hard_resets, 1);
+	TEST_ASSERT_EQ(pe.state, USB_PD_SNK_WAIT_CAPS);
+	TEST_ASSERT_EQ(pe.tx_id, 0);
+
+	// Wait without a contract: back to waiting for capabilities
+	rx_trace(&pe, trace_pd30_caps, sizeof(trace_pd30_caps), 1000);
+	rx_msg(&pe, USB_PD_CTRL_WAIT, 0, 1, NULL, 1010);
+	TEST_ASSERT_EQ(pe.state, USB_PD_SNK_WAIT_CAPS);
+	TEST_ASSERT_EQ(n_contracts, 0);
+
+	// PS_RDY that never comes
+	rx_msg(&pe, USB_PD_DATA_SOURCE_CAP, 5, 2, pe.pdos, 1100);
+	rx_msg(&pe, USB_PD_CTRL_ACCEPT, 0, 3, NULL, 1110);
+	m1_usb_pd_sink_tick(&pe, 1110 + USB_PD_T_PS_TRANSITION);
+	TEST_ASSERT_EQ(n_hard_resets, 2);
+
+	// A contract, then Hard Reset from the source
+	reset(&pe);
+	rx_trace(&pe, trace_pd30_caps, sizeof(trace_pd30_caps), 0);
+	rx_msg(&pe, USB_PD_CTRL_ACCEPT, 0, 1, NULL, 10);
+	rx_msg(&pe, USB_PD_CTRL_PS_RDY, 0, 2, NULL, 20);
+	m1_usb_pd_sink_hard_reset_rx(&pe, 30);
+	TEST_ASSERT_EQ(pe.state, USB_PD_SNK_WAIT_CAPS);
+	TEST_ASSERT(!pe.explicit_contract);
+	TEST_ASSERT_EQ(last_mv, USB_PD_VSAFE5V_MV);
+	TEST_ASSERT_EQ(last_ma, USB_PD_DEFAULT_MA);
+	TEST_ASSERT_EQ(n_hard_resets, 0);
+
+	// Soft_Reset from the source, even with a MessageID already seen
+	reset(&pe);
+	rx_trace(&pe, trace_pd30_caps, sizeof(trace_pd30_caps), 0);
+	rx_msg(&pe, USB_PD_CTRL_SOFT_RESET, 0, 0, NULL, 10);
+	TEST_ASSERT_EQ(pe.state, USB_PD_SNK_WAIT_CAPS);
+	TEST_ASSERT_EQ(USB_PD_HDR_TYPE(sent[1].header), USB_PD_CTRL_ACCEPT);
+	TEST_ASSERT_EQ(USB_PD_HDR_ID(sent[1].header), 0);
+
+	// An unexpected message during the request: Soft_Reset, then accepted
+	reset(&pe);
+	rx_trace(&pe, trace_pd30_caps, sizeof(trace_pd30_caps), 0);
+	rx_msg(&pe, USB_PD_CTRL_PS_RDY, 0, 1, NULL, 10);
+	TEST_ASSERT_EQ(pe.state, USB_PD_SNK_SOFT_RESET);
+	TEST_ASSERT_EQ(USB_PD_HDR_TYPE(sent[1].header), USB_PD_CTRL_SOFT_RESET);
+	rx_msg(&pe, USB_PD_CTRL_ACCEPT, 0, 0, NULL, 15);
+	TEST_ASSERT_EQ(pe.state, USB_PD_SNK_WAIT_CAPS);
+
+	// Not_Supported on PD 3.0
+	rx_msg(&pe, USB_PD_DATA_SOURCE_CAP, 5, 1, pe.pdos, 100);
+	rx_msg(&pe, USB_PD_CTRL_ACCEPT, 0, 2, NULL, 110);
+	rx_msg(&pe, USB_PD_CTRL_PS_RDY, 0, 3, NULL, 120);
+	rx_msg(&pe, USB_PD_CTRL_GET_SOURCE_CAP, 0, 4, NULL, 130);
+	TEST_ASSERT_EQ(USB_PD_HDR_TYPE(sent[n_sent - 1].header), USB_PD_CTRL_NOT_SUPPORTED);
+
+	// The request gets no GoodCRC
+	reset(&pe);
+	transmit_ok = false;
+	rx_trace(&pe, trace_pd30_caps, sizeof(trace_pd30_caps), 0);
+	TEST_ASSERT_EQ(n_hard_resets, 1);
+	TEST_ASSERT_EQ(pe.state, USB_PD_SNK_WAIT_CAPS);
+} // static void test_errors(void)
+
+
+
+int main(void)
+{
+	TEST_RUN(test_codec);
+	TEST_RUN(test_select);
+	TEST_RUN(test_negotiate_pd30);
+	TEST_RUN(test_negotiate_pd20);
+	TEST_RUN(test_no_pd);
+	TEST_RUN(test_errors);
+
+	return TEST_RESULT();
+} // int main(void)
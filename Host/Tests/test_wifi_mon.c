@@ -0,0 +1,138 @@
+/* See COPYING.txt for license details. */
+
+/*
+*
+* test_wifi_mon.c
+*
+* Unit tests of m1_wifi_mon.c
+*
+* M1 Project
+*
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include "ff.h"
+#include "m1_wifi_mon.h"
+#include "m1_host_test.h"
+
+#define TEST_LOG_FILE		"0:/wifi_mon_test/monitor.csv"
+
+static S_M1_Wifi_Mon mon;
+
+static void test_hist_bin(void)
+{
+	TEST_ASSERT_EQ(m1_wifi_mon_hist_bin(-100), 0);
+	TEST_ASSERT_EQ(m1_wifi_mon_hist_bin(-91), 0);
+	TEST_ASSERT_EQ(m1_wifi_mon_hist_bin(-90), 1);
+	TEST_ASSERT_EQ(m1_wifi_mon_hist_bin(-81), 1);
+	TEST_ASSERT_EQ(m1_wifi_mon_hist_bin(-80), 2);
+	TEST_ASSERT_EQ(m1_wifi_mon_hist_bin(-31), 6);
+	TEST_ASSERT_EQ(m1_wifi_mon_hist_bin(-30), 7);
+	TEST_ASSERT_EQ(m1_wifi_mon_hist_bin(-5), 7);
+} // static void test_hist_bin(void)
+
+
+
+static void test_sweeps(void)
+{
+	m1_wifi_mon_init(&mon);
+	TEST_ASSERT_EQ(mon.ch[0].rssi_best, M1_WIFI_MON_RSSI_NONE);
+
+	m1_wifi_mon_sweep_begin(&mon);
+	TEST_ASSERT(m1_wifi_mon_ap(&mon, -45, 6));
+	TEST_ASSERT(m1_wifi_mon_ap(&mon, -82, 6));
+	TEST_ASSERT(m1_wifi_mon_ap(&mon, -60, 1));
+	TEST_ASSERT(!m1_wifi_mon_ap(&mon, -50, 0));
+	TEST_ASSERT(!m1_wifi_mon_ap(&mon, -50, 36)); // 5 GHz
+	// Nothing shows before the sweep ends
+	TEST_ASSERT_EQ(mon.ch[5].aps, 0);
+	m1_wifi_mon_sweep_end(&mon);
+
+	TEST_ASSERT_EQ(mon.sweeps, 1);
+	TEST_ASSERT_EQ(mon.aps, 3);
+	TEST_ASSERT_EQ(mon.ch[5].aps, 2);
+	TEST_ASSERT_EQ(mon.ch[5].rssi_best, -45);
+	TEST_ASSERT_EQ(mon.ch[0].rssi_best, -60);
+	TEST_ASSERT_EQ(mon.ch[12].rssi_best, M1_WIFI_MON_RSSI_NONE);
+	TEST_ASSERT_EQ(mon.ch[5].hist[5], 1); // -45
+	TEST_ASSERT_EQ(mon.ch[5].hist[1], 1); // -82
+
+	// -45: 25, -82: 13; channels 1 and 6 are apart enough not to overlap
+	TEST_ASSERT_EQ(mon.ch[5].load, 38);
+	TEST_ASSERT_EQ(mon.ch[4].load, 20 + 10 + 5); // 25*4/5 + 13*4/5 + 25*1/5
+	TEST_ASSERT_EQ(mon.ch[0].load, 25);
+	TEST_ASSERT_EQ(mon.ch[9].load, 5 + 2);
+	TEST_ASSERT_EQ(mon.ch[10].load, 0);
+	TEST_ASSERT_EQ(m1_wifi_mon_busiest(&mon), 6);
+
+	// A crowded channel saturates, the peaks stay
+	m1_wifi_mon_sweep_begin(&mon);
+	for (uint8_t i=0; i<6; i++)
+		m1_wifi_mon_ap(&mon, -40, 11);
+	m1_wifi_mon_ap(&mon, -40, 13);
+	m1_wifi_mon_sweep_end(&mon);
+	TEST_ASSERT_EQ(mon.sweeps, 2);
+	TEST_ASSERT_EQ(mon.ch[10].load, 100);
+	TEST_ASSERT_EQ(mon.ch[9].load, 100); // 6*20 + 25*2/5, busiest on a tie: the lower
+	TEST_ASSERT_EQ(mon.ch[5].aps, 0);
+	TEST_ASSERT_EQ(mon.ch[5].aps_max, 2);
+	TEST_ASSERT_EQ(mon.ch[5].load_max, 38);
+	TEST_ASSERT_EQ(mon.ch[5].rssi_best, M1_WIFI_MON_RSSI_NONE);
+	TEST_ASSERT_EQ(mon.ch[5].sightings, 2);
+	TEST_ASSERT_EQ(mon.ch[10].sightings, 6);
+	TEST_ASSERT_EQ(m1_wifi_mon_busiest(&mon), 10);
+
+	// An empty sweep
+	m1_wifi_mon_sweep_begin(&mon);
+	m1_wifi_mon_sweep_end(&mon);
+	TEST_ASSERT_EQ(mon.aps, 0);
+	TEST_ASSERT_EQ(m1_wifi_mon_busiest(&mon), 1);
+} // static void test_sweeps(void)
+
+
+
+static void test_log(void)
+{
+	char text[4096];
+	char *row;
+	FIL fil;
+	UINT br;
+	uint16_t rows = 0;
+
+	f_unlink(TEST_LOG_FILE);
+	m1_wifi_mon_init(&mon);
+	m1_wifi_mon_ap(&mon, -45, 6);
+	m1_wifi_mon_sweep_end(&mon);
+	TEST_ASSERT_EQ(m1_wifi_mon_log(&mon, TEST_LOG_FILE, 1500), FR_OK);
+	m1_wifi_mon_sweep_end(&mon);
+	TEST_ASSERT_EQ(m1_wifi_mon_log(&mon, TEST_LOG_FILE, 5200), FR_OK);
+
+	TEST_ASSERT_EQ(f_open(&fil, TEST_LOG_FILE, FA_READ), FR_OK);
+	TEST_ASSERT_EQ(f_read(&fil, text, sizeof(text) - 1, &br), FR_OK);
+	f_close(&fil);
+	text[br] = '\0';
+
+	TEST_ASSERT(!strncmp(text, "time_ms,sweep,channel,", strlen("time_ms,sweep,channel,")));
+	TEST_ASSERT(strstr(text, "\n1500,1,6,1,-45,25,1,0,0,0,0,0,1,0,0\n")!=NULL);
+	TEST_ASSERT(strstr(text, "\n1500,1,1,0,,0,0,0,0,0,0,0,0,0,0\n")!=NULL);
+	TEST_ASSERT(strstr(text, "\n5200,2,6,0,,0,1,0,0,0,0,0,1,0,0\n")!=NULL);
+	TEST_ASSERT(strstr(text + 1, "time_ms")==NULL); // One header
+
+	for (row=text; (row=strchr(row, '\n'))!=NULL; row++)
+		rows++;
+	TEST_ASSERT_EQ(rows, 1 + 2*M1_WIFI_MON_CHANNELS);
+
+	f_unlink(TEST_LOG_FILE);
+} // static void test_log(void)
+
+
+
+int main(void)
+{
+	TEST_RUN(test_hist_bin);
+	TEST_RUN(test_sweeps);
+	TEST_RUN(test_log);
+
+	return TEST_RESULT();
+} // int main(void)
@@ -0,0 +1,417 @@
+/* See COPYING.txt for license details. */
+
+/*
+*
+* test_wifi_sta.c
+*
+* Unit tests of m1_wifi_sta.c against a scripted ESP-AT responder
+*
+* M1 Project
+*
+*/
+
+#include <string.h>
+#include "m1_wifi_sta.h"
+#include "m1_host_test.h"
+
+#define SCRIPT_MAX		16
+
+// What the ESP32 answers to a command, lines separated by '\n'
+typedef struct
+{
+	const char *cmd; // Expected command, without CR LF
+	const char *reply; // NULL: no reply, the command times out
+} S_At_Step;
+
+typedef struct
+{
+	S_At_Step step[SCRIPT_MAX];
+	uint8_t n_steps;
+	uint8_t next; // Step the next command must match
+	bool mismatch;
+	char last_cmd[M1_WIFI_STA_CMD_LEN];
+	const char *pending; // Reply of the last command, delivered by responder_run()
+	bool link_down; // The send callback fails
+	uint32_t changes;
+} S_At_Responder;
+
+static S_At_Responder at;
+
+static bool responder_send(void *ctx, const char *cmd)
+{
+	size_t len = strlen(cmd);
+
+	(void)ctx;
+	if ( at.link_down )
+		return false;
+	TEST_ASSERT(len >= 2 && !strcmp(&cmd[len - 2], "\r\n"));
+	memcpy(at.last_cmd, cmd, len - 2);
+	at.last_cmd[len - 2] = '\0';
+
+	if ( at.next >= at.n_steps || strcmp(at.last_cmd, at.step[at.next].cmd) )
+	{
+		at.mismatch = true;
+		return true;
+	}
+	at.pending = at.step[at.next++].reply;
+
+	return true;
+} // static bool responder_send(void *ctx, const char *cmd)
+
+
+
+static void responder_changed(void *ctx)
+{
+	(void)ctx;
+	at.changes++;
+} // static void responder_changed(void *ctx)
+
+
+
+static void responder_script(const S_At_Step *psteps, uint8_t n)
+{
+	memset(&at, 0, sizeof(at));
+	memcpy(at.step, psteps, n*sizeof(S_At_Step));
+	at.n_steps = n;
+} // static void responder_script(const S_At_Step *psteps, uint8_t n)
+
+
+
+// Feeds the replies line by line, as the SPI-AT glue does, until the script is quiet
+static void responder_run(S_M1_Wifi_Sta *ps, uint32_t now_ms)
+{
+	char line[128];
+
+	while ( at.pending )
+	{
+		const char *reply = at.pending;
+
+		at.pending = NULL;
+		while ( *reply )
+		{
+			size_t len = strcspn(reply, "\n");
+
+			memcpy(line, reply, len);
+			line[len] = '\0';
+			m1_wifi_sta_rx_line(ps, line, now_ms);
+			reply += len;
+			if ( *reply=='\n' )
+				reply++;
+		}
+		m1_wifi_sta_tick(ps, now_ms);
+	} // while ( at.pending )
+} // static void responder_run(S_M1_Wifi_Sta *ps, uint32_t now_ms)
+
+
+
+static void sta_setup(S_M1_Wifi_Sta *ps)
+{
+	S_M1_Wifi_Sta_Config cfg = { responder_send, responder_changed, NULL };
+
+	m1_wifi_sta_init(ps, &cfg);
+} // static void sta_setup(S_M1_Wifi_Sta *ps)
+
+
+
+static const S_At_Step join_ok[] =
+{
+	{ "AT+CWMODE=1", "AT+CWMODE=1\n\nOK" },
+	{ "AT+CWRECONNCFG=0,0", "OK" },
+	{ "AT+CWJAP=\"Home\\, \\\"Lab\\\"\",\"pa\\\\ss\"", "WIFI CONNECTED\nWIFI GOT IP\n\nOK" },
+	{ "AT+CWJAP?", "+CWJAP:\"Home, \"Lab\"\",\"1a:2b:3c:4d:5e:6f\",6,-58,0,1,3,0,1\n\nOK" },
+	{ "AT+CIPSTA?", "+CIPSTA:ip:\"192.168.1.42\"\n+CIPSTA:gateway:\"192.168.1.1\"\n+CIPSTA:netmask:\"255.255.255.0\"\n\nOK" },
+	{ "AT+CWJAP?", "+CWJAP:\"Home, \"Lab\"\",\"1a:2b:3c:4d:5e:6f\",6,-71\n\nOK" },
+	{ "AT+CIPSTA?", "+CIPSTA:ip:\"192.168.1.42\"\n\nOK" },
+};
+
+static void test_join_and_status(void)
+{
+	S_M1_Wifi_Sta sta;
+
+	responder_script(join_ok, sizeof(join_ok)/sizeof(join_ok[0]));
+	sta_setup(&sta);
+
+	// Separators in the SSID and the password are escaped
+	m1_wifi_sta_connect(&sta, "Home, \"Lab\"", "pa\\ss", 1000);
+	TEST_ASSERT_EQ(sta.state, M1_WIFI_STA_JOINING);
+	responder_run(&sta, 1100);
+	TEST_ASSERT(!at.mismatch);
+	TEST_ASSERT_EQ(sta.state, M1_WIFI_STA_CONNECTED);
+	TEST_ASSERT_EQ(sta.connects, 1);
+	TEST_ASSERT_STR(sta.bssid, "1a:2b:3c:4d:5e:6f");
+	TEST_ASSERT_EQ(sta.channel, 6);
+	TEST_ASSERT_EQ(sta.rssi, -58);
+	TEST_ASSERT_STR(sta.ip, "192.168.1.42");
+	TEST_ASSERT(at.changes >= 3);
+
+	// Nothing until the next poll, then the RSSI is refreshed
+	m1_wifi_sta_tick(&sta, 1100 + M1_WIFI_STA_POLL_MS - 1);
+	TEST_ASSERT_EQ(at.next, 5);
+	m1_wifi_sta_tick(&sta, 1100 + M1_WIFI_STA_POLL_MS);
+	responder_run(&sta, 1100 + M1_WIFI_STA_POLL_MS);
+	TEST_ASSERT_EQ(at.next, 7);
+	TEST_ASSERT_EQ(sta.rssi, -71);
+	TEST_ASSERT(!at.mismatch);
+} // static void test_join_and_status(void)
+
+
+
+static const S_At_Step drop_and_backoff[] =
+{
+	{ "AT+CWMODE=1", "OK" },
+	{ "AT+CWRECONNCFG=0,0", "ERROR" }, // Older ESP-AT: the join goes on
+	{ "AT+CWJAP=\"Office\",\"secret12\"", "WIFI CONNECTED\nWIFI GOT IP\nOK" },
+	{ "AT+CWJAP?", "+CWJAP:\"Office\",\"aa:bb:cc:dd:ee:ff\",11,-40\nOK" },
+	{ "AT+CIPSTA?", "+CIPSTA:ip:\"10.0.0.7\"\nOK" },
+	// Link lost: rejoin after 2 s, the AP is gone for two tries
+	{ "AT+CWMODE=1", "OK" },
+	{ "AT+CWRECONNCFG=0,0", "OK" },
+	{ "AT+CWJAP=\"Office\",\"secret12\"", "WIFI DISCONNECT\n+CWJAP:3\n\nFAIL" },
+	{ "AT+CWMODE=1", "OK" },
+	{ "AT+CWRECONNCFG=0,0", "OK" },
+	{ "AT+CWJAP=\"Office\",\"secret12\"", "+CWJAP:1\nFAIL" },
+	{ "AT+CWMODE=1", "OK" },
+	{ "AT+CWRECONNCFG=0,0", "OK" },
+	{ "AT+CWJAP=\"Office\",\"secret12\"", "WIFI CONNECTED\nWIFI GOT IP\nOK" },
+	{ "AT+CWJAP?", "No AP\nOK" }, // Drop event missed
+};
+
+static void test_drop_and_backoff(void)
+{
+	S_M1_Wifi_Sta sta;
+	uint32_t t = 5000;
+
+	responder_script(drop_and_backoff, sizeof(drop_and_backoff)/sizeof(drop_and_backoff[0]));
+	sta_setup(&sta);
+
+	m1_wifi_sta_connect(&sta, "Office", "secret12", t);
+	responder_run(&sta, t);
+	TEST_ASSERT_EQ(sta.state, M1_WIFI_STA_CONNECTED);
+	TEST_ASSERT_STR(sta.ip, "10.0.0.7");
+
+	t += 30000;
+	m1_wifi_sta_rx_line(&sta, "WIFI DISCONNECT", t);
+	TEST_ASSERT_EQ(sta.state, M1_WIFI_STA_BACKOFF);
+	TEST_ASSERT_EQ(sta.drops, 1);
+	TEST_ASSERT_STR(sta.ip, "");
+
+	m1_wifi_sta_tick(&sta, t + M1_WIFI_STA_BACKOFF_MIN_MS - 1);
+	TEST_ASSERT_EQ(at.next, 5);
+	t += M1_WIFI_STA_BACKOFF_MIN_MS;
+	m1_wifi_sta_tick(&sta, t);
+	responder_run(&sta, t);
+	TEST_ASSERT_EQ(sta.state, M1_WIFI_STA_BACKOFF);
+	TEST_ASSERT_EQ(sta.join_error, M1_WIFI_STA_JOIN_ERR_NO_AP);
+	TEST_ASSERT_EQ(sta.attempts, 1);
+
+	// The wait doubles
+	m1_wifi_sta_tick(&sta, t + 2*M1_WIFI_STA_BACKOFF_MIN_MS - 1);
+	TEST_ASSERT_EQ(at.next, 8);
+	t += 2*M1_WIFI_STA_BACKOFF_MIN_MS;
+	m1_wifi_sta_tick(&sta, t);
+	responder_run(&sta, t);
+	TEST_ASSERT_EQ(sta.attempts, 2);
+	TEST_ASSERT_EQ(sta.join_error, M1_WIFI_STA_JOIN_ERR_TIMEOUT);
+
+	m1_wifi_sta_tick(&sta, t + 4*M1_WIFI_STA_BACKOFF_MIN_MS - 1);
+	TEST_ASSERT_EQ(at.next, 11);
+	t += 4*M1_WIFI_STA_BACKOFF_MIN_MS;
+	m1_wifi_sta_tick(&sta, t);
+	responder_run(&sta, t);
+	TEST_ASSERT_EQ(sta.state, M1_WIFI_STA_BACKOFF); // "No AP" on the first status poll
+	TEST_ASSERT_EQ(sta.connects, 2);
+	TEST_ASSERT_EQ(sta.drops, 2);
+	TEST_ASSERT_EQ(sta.attempts, 0);
+	TEST_ASSERT_EQ(sta.retry_ms, t + M1_WIFI_STA_BACKOFF_MIN_MS);
+	TEST_ASSERT(!at.mismatch);
+} // static void test_drop_and_backoff(void)
+
+
+
+static const S_At_Step wrong_password[] =
+{
+	{ "AT+CWMODE=1", "OK" },
+	{ "AT+CWRECONNCFG=0,0", "OK" },
+	{ "AT+CWJAP=\"Cafe\",\"guess\"", "WIFI DISCONNECT\n+CWJAP:2\nFAIL" },
+};
+
+static void test_wrong_password(void)
+{
+	S_M1_Wifi_Sta sta;
+
+	responder_script(wrong_password, sizeof(wrong_password)/sizeof(wrong_password[0]));
+	sta_setup(&sta);
+
+	m1_wifi_sta_connect(&sta, "Cafe", "guess", 0);
+	responder_run(&sta, 0);
+	TEST_ASSERT_EQ(sta.state, M1_WIFI_STA_FAILED);
+	TEST_ASSERT_EQ(sta.join_error, M1_WIFI_STA_JOIN_ERR_PASSWORD);
+
+	// No retries
+	m1_wifi_sta_tick(&sta, M1_WIFI_STA_BACKOFF_MAX_MS*2);
+	TEST_ASSERT_EQ(at.next, 3);
+	TEST_ASSERT(!at.mismatch);
+} // static void test_wrong_password(void)
+
+
+
+static const S_At_Step timeouts[] =
+{
+	{ "AT+CWMODE=1", NULL }, // The ESP32 does not answer
+	{ "AT+CWMODE=1", "OK" },
+	{ "AT+CWRECONNCFG=0,0", "OK" },
+	{ "AT+CWJAP=\"Open\"", NULL },
+	{ "AT+CWMODE=1", "OK" },
+	{ "AT+CWRECONNCFG=0,0", "OK" },
+	{ "AT+CWJAP=\"Open\"", "OK" },
+	{ "AT+CWJAP?", "+CWJAP:\"Open\",\"01:02:03:04:05:06\",1,-80\nOK" },
+	{ "AT+CIPSTA?", "+CIPSTA:ip:\"172.16.0.2\"\nOK" },
+	{ "AT+CWQAP", "OK\nWIFI DISCONNECT" },
+};
+
+static void test_timeouts_and_disconnect(void)
+{
+	S_M1_Wifi_Sta sta;
+	uint32_t t = UINT32_MAX - 1000; // Across the tick counter wrap
+
+	responder_script(timeouts, sizeof(timeouts)/sizeof(timeouts[0]));
+	sta_setup(&sta);
+
+	m1_wifi_sta_connect(&sta, "Open", "", t);
+	responder_run(&sta, t);
+	m1_wifi_sta_tick(&sta, t + M1_WIFI_STA_CMD_TIMEOUT_MS - 1);
+	TEST_ASSERT_EQ(sta.state, M1_WIFI_STA_JOINING);
+	t += M1_WIFI_STA_CMD_TIMEOUT_MS;
+	m1_wifi_sta_tick(&sta, t);
+	TEST_ASSERT_EQ(sta.state, M1_WIFI_STA_BACKOFF);
+
+	t += M1_WIFI_STA_BACKOFF_MIN_MS;
+	m1_wifi_sta_tick(&sta, t);
+	responder_run(&sta, t);
+	TEST_ASSERT_EQ(at.next, 4); // Open network: no password parameter
+	t += M1_WIFI_STA_JOIN_TIMEOUT_MS;
+	m1_wifi_sta_tick(&sta, t);
+	TEST_ASSERT_EQ(sta.attempts, 2);
+
+	// Send failures time out like a silent ESP32
+	at.link_down = true;
+	t += 2*M1_WIFI_STA_BACKOFF_MIN_MS;
+	m1_wifi_sta_tick(&sta, t);
+	TEST_ASSERT_EQ(sta.state, M1_WIFI_STA_JOINING);
+	m1_wifi_sta_tick(&sta, t);
+	TEST_ASSERT_EQ(sta.state, M1_WIFI_STA_BACKOFF);
+	TEST_ASSERT_EQ(sta.attempts, 3);
+	at.link_down = false;
+
+	t += 4*M1_WIFI_STA_BACKOFF_MIN_MS;
+	m1_wifi_sta_tick(&sta, t);
+	responder_run(&sta, t);
+	TEST_ASSERT_EQ(sta.state, M1_WIFI_STA_CONNECTED);
+	TEST_ASSERT_STR(sta.ip, "172.16.0.2");
+
+	// Leaving: the disconnect event that follows is ours, no rejoin
+	m1_wifi_sta_disconnect(&sta, t);
+	responder_run(&sta, t);
+	TEST_ASSERT_EQ(sta.state, M1_WIFI_STA_IDLE);
+	TEST_ASSERT_EQ(sta.drops, 0);
+	TEST_ASSERT_STR(sta.ssid, "");
+	m1_wifi_sta_tick(&sta, t + M1_WIFI_STA_BACKOFF_MAX_MS);
+	TEST_ASSERT_EQ(at.next, 10);
+	TEST_ASSERT(!at.mismatch);
+} // static void test_timeouts_and_disconnect(void)
+
+
+
+static const S_At_Step reset[] =
+{
+	{ "AT+CWMODE=1", "OK" },
+	{ "AT+CWRECONNCFG=0,0", "OK" },
+	{ "AT+CWJAP=\"Lab\",\"secret\"", "WIFI CONNECTED\nWIFI GOT IP\n\nOK" },
+	{ "AT+CWJAP?", "+CWJAP:\"Lab\",\"1a:2b:3c:4d:5e:6f\",11,-60\n\nOK" },
+	{ "AT+CIPSTA?", "+CIPSTA:ip:\"10.0.0.7\"\n\nOK" },
+	{ "AT+CWJAP?", NULL }, // Lost in the restart
+	{ "AT+CWMODE=1", NULL }, // Restarted again while joining
+	{ "AT+CWMODE=1", "OK" },
+	{ "AT+CWRECONNCFG=0,0", "OK" },
+	{ "AT+CWJAP=\"Lab\",\"secret\"", "WIFI CONNECTED\nWIFI GOT IP\n\nOK" },
+	{ "AT+CWJAP?", "+CWJAP:\"Lab\",\"1a:2b:3c:4d:5e:6f\",11,-62\n\nOK" },
+	{ "AT+CIPSTA?", "+CIPSTA:ip:\"10.0.0.7\"\n\nOK" },
+	{ "AT+CWJAP?", NULL },
+};
+
+static void test_reset(void)
+{
+	S_M1_Wifi_Sta sta;
+	uint32_t t = 500;
+
+	responder_script(reset, sizeof(reset)/sizeof(reset[0]));
+	sta_setup(&sta);
+
+	m1_wifi_sta_connect(&sta, "Lab", "secret", t);
+	responder_run(&sta, t);
+	TEST_ASSERT_EQ(sta.state, M1_WIFI_STA_CONNECTED);
+
+	// Restarted with a poll in flight: a drop, the poll is not waited for
+	t += M1_WIFI_STA_POLL_MS;
+	m1_wifi_sta_tick(&sta, t);
+	TEST_ASSERT_EQ(at.next, 6);
+	m1_wifi_sta_reset(&sta, t);
+	TEST_ASSERT_EQ(sta.state, M1_WIFI_STA_BACKOFF);
+	TEST_ASSERT_EQ(sta.cmd, M1_WIFI_STA_CMD_NONE);
+	TEST_ASSERT_EQ(sta.drops, 1);
+	TEST_ASSERT_STR(sta.ip, "");
+
+	// Restarted while joining: retried, not a failed attempt
+	t += M1_WIFI_STA_BACKOFF_MIN_MS;
+	m1_wifi_sta_tick(&sta, t);
+	TEST_ASSERT_EQ(sta.state, M1_WIFI_STA_JOINING);
+	m1_wifi_sta_reset(&sta, t);
+	TEST_ASSERT_EQ(sta.state, M1_WIFI_STA_BACKOFF);
+	TEST_ASSERT_EQ(sta.attempts, 0);
+	TEST_ASSERT_EQ(sta.drops, 1);
+
+	t += 2*M1_WIFI_STA_BACKOFF_MIN_MS;
+	m1_wifi_sta_tick(&sta, t);
+	responder_run(&sta, t);
+	TEST_ASSERT_EQ(sta.state, M1_WIFI_STA_CONNECTED);
+	TEST_ASSERT_EQ(sta.connects, 2);
+	TEST_ASSERT_EQ(at.next, 12);
+
+	// Left behind a poll, then restarted: nothing to leave anymore
+	t += M1_WIFI_STA_POLL_MS;
+	m1_wifi_sta_tick(&sta, t);
+	m1_wifi_sta_disconnect(&sta, t);
+	TEST_ASSERT(sta.quit_pending);
+	m1_wifi_sta_reset(&sta, t);
+	TEST_ASSERT_EQ(sta.state, M1_WIFI_STA_IDLE);
+	m1_wifi_sta_tick(&sta, t + M1_WIFI_STA_CMD_TIMEOUT_MS);
+	TEST_ASSERT_EQ(at.next, 13);
+	TEST_ASSERT(!at.mismatch);
+} // static void test_reset(void)
+
+
+
+static void test_at_quote(void)
+{
+	char buf[8];
+
+	TEST_ASSERT_EQ(m1_wifi_sta_at_quote(buf, sizeof(buf), "a,b"), 4);
+	TEST_ASSERT_STR(buf, "a\\,b");
+	// Cut before an escape that does not fit
+	TEST_ASSERT_EQ(m1_wifi_sta_at_quote(buf, sizeof(buf), "abcdef\"g"), 6);
+	TEST_ASSERT_STR(buf, "abcdef");
+} // static void test_at_quote(void)
+
+
+
+int main(void)
+{
+	TEST_RUN(test_join_and_status);
+	TEST_RUN(test_drop_and_backoff);
+	TEST_RUN(test_wrong_password);
+	TEST_RUN(test_timeouts_and_disconnect);
+	TEST_RUN(test_reset);
+	TEST_RUN(test_at_quote);
+
+	return TEST_RESULT();
+} // int main(void)
@@ -0,0 +1,433 @@
+/* See COPYING.txt for license details. */
+
+/*
+*
+* port.c
+*
+* FreeRTOS port for the host build, see portmacro.h
+*
+* M1 Project
+*
+*/
+
+/*************************** I N C L U D E S **********************************/
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "FreeRTOS.h"
+#include "task.h"
+
+/*************************** D E F I N E S ************************************/
+
+#define NSEC_PER_SEC		1000000000L
+
+//************************** C O N S T A N T **********************************/
+
+//************************** S T R U C T U R E S *******************************
+
+typedef struct
+{
+	pthread_t thread;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	bool run; // Set by the thread handing over the CPU
+	bool exit; // Set when the kernel has freed the task
+	TaskFunction_t code;
+	void *params;
+} S_Port_Thread;
+
+/***************************** V A R I A B L E S ******************************/
+
+// Interrupt mask: held by whoever is in a critical section or "ISR"
+static pthread_mutex_t irq_lock = PTHREAD_MUTEX_INITIALIZER;
+static __thread uint32_t irq_depth = 0;
+
+// Thread of the task running on this POSIX thread (NULL for non-task threads)
+static __thread S_Port_Thread *this_thread = NULL;
+
+static volatile bool scheduler_running = false;
+static volatile bool switch_pending = false;
+
+static pthread_t tick_thread;
+static pthread_mutex_t end_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t end_cond = PTHREAD_COND_INITIALIZER;
+static bool scheduler_ended = false;
+
+/********************* F U N C T I O N   P R O T O T Y P E S ******************/
+
+static S_Port_Thread *port_get_thread(void *task);
+static void port_resume(S_Port_Thread *pthread_hdl);
+static void port_suspend(S_Port_Thread *pthread_hdl);
+static void port_switch_context(void);
+static void *port_thread_entry(void *param);
+static void *port_tick_thread(void *param);
+
+/*************** F U N C T I O N   I M P L E M E N T A T I O N ****************/
+
+/*============================================================================*/
+/*
+ * The first member of a TCB is pxTopOfStack, which points to the slot where
+ * pxPortInitialiseStack() stored the thread of the task.
+ */
+/*============================================================================*/
+static S_Port_Thread *port_get_thread(void *task)
+{
+	StackType_t *top_of_stack = *(StackType_t **)task;
+
+	return (S_Port_Thread *)*top_of_stack;
+} // static S_Port_Thread *port_get_thread(void *task)
+
+
+
+/*============================================================================*/
+/*
+ * Lets the thread of a task run.
+ */
+/*============================================================================*/
+static void port_resume(S_Port_Thread *pthread_hdl)
+{
+	pthread_mutex_lock(&pthread_hdl->lock);
+	pthread_hdl->run = true;
+	pthread_cond_signal(&pthread_hdl->cond);
+	pthread_mutex_unlock(&pthread_hdl->lock);
+} // static void port_resume(S_Port_Thread *pthread_hdl)
+
+
+
+/*============================================================================*/
+/*
+ * Blocks the calling task thread until the scheduler selects it again.
+ * The thread ends here once its task has been deleted.
+ */
+/*============================================================================*/
+static void port_suspend(S_Port_Thread *pthread_hdl)
+{
+	bool exit;
+
+	pthread_mutex_lock(&pthread_hdl->lock);
+	while ( !pthread_hdl->run && !pthread_hdl->exit )
+		pthread_cond_wait(&pthread_hdl->cond, &pthread_hdl->lock);
+	pthread_hdl->run = false;
+	exit = pthread_hdl->exit;
+	pthread_mutex_unlock(&pthread_hdl->lock);
+
+	if ( exit )
+	{
+		pthread_mutex_destroy(&pthread_hdl->lock);
+		pthread_cond_destroy(&pthread_hdl->cond);
+		free(pthread_hdl);
+		pthread_exit(NULL);
+	}
+} // static void port_suspend(S_Port_Thread *pthread_hdl)
+
+
+
+/*============================================================================*/
+/*
+ * Selects the next task and hands the CPU over to it. Must be called by the
+ * running task thread outside of any critical section.
+ */
+/*============================================================================*/
+static void port_switch_context(void)
+{
+	S_Port_Thread *self = this_thread;
+	S_Port_Thread *next;
+
+	pthread_mutex_lock(&irq_lock);
+	switch_pending = false;
+	vTaskSwitchContext();
+	next = port_get_thread(xTaskGetCurrentTaskHandle());
+	pthread_mutex_unlock(&irq_lock);
+
+	if ( next != self )
+	{
+		port_resume(next);
+		port_suspend(self);
+	}
+} // static void port_switch_context(void)
+
+
+
+/*============================================================================*/
+/*
+ * Entry of every task thread: wait for the first switch to the task, then run
+ * it. A task function returning is treated as deleting itself.
+ */
+/*============================================================================*/
+static void *port_thread_entry(void *param)
+{
+	S_Port_Thread *pthread_hdl = (S_Port_Thread *)param;
+
+	this_thread = pthread_hdl;
+	port_suspend(pthread_hdl);
+
+	pthread_hdl->code(pthread_hdl->params);
+	vTaskDelete(NULL);
+
+	return NULL;
+} // static void *port_thread_entry(void *param)
+
+
+
+/*============================================================================*/
+/*
+ * SysTick replacement: increments the tick every 1/configTICK_RATE_HZ seconds
+ * with interrupts masked, like the tick interrupt does.
+ */
+/*============================================================================*/
+static void *port_tick_thread(void *param)
+{
+	struct timespec next;
+
+	(void)param;
+	clock_gettime(CLOCK_MONOTONIC, &next);
+	while ( scheduler_running )
+	{
+		next.tv_nsec += NSEC_PER_SEC/configTICK_RATE_HZ;
+		if ( next.tv_nsec >= NSEC_PER_SEC )
+		{
+			next.tv_nsec -= NSEC_PER_SEC;
+			next.tv_sec++;
+		}
+		while ( clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL)==EINTR )
+			;
+
+		pthread_mutex_lock(&irq_lock);
+		if ( scheduler_running && xTaskIncrementTick()!=pdFALSE )
+			switch_pending = true;
+		pthread_mutex_unlock(&irq_lock);
+	} // while ( scheduler_running )
+
+	return NULL;
+} // static void *port_tick_thread(void *param)
+
+
+
+/*============================================================================*/
+/*
+ * Creates the thread of a new task. The thread is stored at the top of the
+ * task stack, the stack itself is not used since the thread has its own.
+ */
+/*============================================================================*/
+StackType_t *pxPortInitialiseStack(StackType_t *pxTopOfStack, TaskFunction_t pxCode, void *pvParameters)
+{
+	S_Port_Thread *pthread_hdl;
+	pthread_attr_t attr;
+
+	pthread_hdl = (S_Port_Thread *)calloc(1, sizeof(S_Port_Thread));
+	configASSERT(pthread_hdl != NULL);
+	pthread_mutex_init(&pthread_hdl->lock, NULL);
+	pthread_cond_init(&pthread_hdl->cond, NULL);
+	pthread_hdl->code = pxCode;
+	pthread_hdl->params = pvParameters;
+
+	pthread_attr_init(&attr);
+	pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+	if ( pthread_create(&pthread_hdl->thread, &attr, port_thread_entry, pthread_hdl)!=0 )
+	{
+		configASSERT(0);
+	}
+	pthread_attr_destroy(&attr);
+
+	*pxTopOfStack = (StackType_t)pthread_hdl;
+
+	return pxTopOfStack;
+} // StackType_t *pxPortInitialiseStack(StackType_t *pxTopOfStack, TaskFunction_t pxCode, void *pvParameters)
+
+
+
+/*============================================================================*/
+/*
+ * Runs the first task and blocks the calling (main) thread until
+ * vTaskEndScheduler() is called.
+ */
+/*============================================================================*/
+BaseType_t xPortStartScheduler(void)
+{
+	// vTaskStartScheduler() masks interrupts before it gets here
+	if ( irq_depth )
+	{
+		irq_depth = 0;
+		pthread_mutex_unlock(&irq_lock);
+	}
+
+	scheduler_running = true;
+	pthread_create(&tick_thread, NULL, port_tick_thread, NULL);
+
+	port_resume(port_get_thread(xTaskGetCurrentTaskHandle()));
+
+	pthread_mutex_lock(&end_lock);
+	while ( !scheduler_ended )
+		pthread_cond_wait(&end_cond, &end_lock);
+	pthread_mutex_unlock(&end_lock);
+
+	pthread_join(tick_thread, NULL);
+
+	return pdFALSE;
+} // BaseType_t xPortStartScheduler(void)
+
+
+
+/*============================================================================*/
+/*
+ * Returns to the caller of vTaskStartScheduler(). The thread of the task that
+ * ends the scheduler stops here, the other task threads stay blocked.
+ */
+/*============================================================================*/
+void vPortEndScheduler(void)
+{
+	scheduler_running = false;
+	if ( irq_depth )
+	{
+		irq_depth = 0;
+		pthread_mutex_unlock(&irq_lock);
+	}
+
+	pthread_mutex_lock(&end_lock);
+	scheduler_ended = true;
+	pthread_cond_signal(&end_cond);
+	pthread_mutex_unlock(&end_lock);
+
+	if ( this_thread != NULL )
+		pthread_exit(NULL);
+} // void vPortEndScheduler(void)
+
+
+
+/*============================================================================*/
+/*
+ * Task level yield. Inside a critical section, or on a thread that is not a
+ * task, the switch is deferred like a pended PendSV.
+ */
+/*============================================================================*/
+void vPortYield(void)
+{
+	if ( !scheduler_running || this_thread==NULL || irq_depth )
+	{
+		switch_pending = true;
+		return;
+	}
+
+	port_switch_context();
+} // void vPortYield(void)
+
+
+
+void vPortYieldFromISR(BaseType_t xSwitchRequired)
+{
+	if ( xSwitchRequired!=pdFALSE )
+		vPortYield();
+} // void vPortYieldFromISR(BaseType_t xSwitchRequired)
+
+
+
+/*============================================================================*/
+/*
+ * Interrupt masking. The depth is per thread, so each task keeps its own
+ * critical nesting count like the context of a real port does.
+ */
+/*============================================================================*/
+uint32_t ulPortSetInterruptMask(void)
+{
+	if ( irq_depth++==0 )
+		pthread_mutex_lock(&irq_lock);
+
+	return 0;
+} // uint32_t ulPortSetInterruptMask(void)
+
+
+
+void vPortClearInterruptMask(uint32_t ulMask)
+{
+	(void)ulMask;
+
+	if ( irq_depth==0 )
+		return;
+
+	if ( --irq_depth==0 )
+	{
+		pthread_mutex_unlock(&irq_lock);
+		// Take the switch requested while interrupts were masked
+		if ( switch_pending && scheduler_running && this_thread!=NULL )
+			port_switch_context();
+	} // if ( --irq_depth==0 )
+} // void vPortClearInterruptMask(uint32_t ulMask)
+
+
+
+void vPortEnterCritical(void)
+{
+	(void)ulPortSetInterruptMask();
+} // void vPortEnterCritical(void)
+
+
+
+void vPortExitCritical(void)
+{
+	vPortClearInterruptMask(0);
+} // void vPortExitCritical(void)
+
+
+
+void vPortDisableInterrupts(void)
+{
+	if ( irq_depth==0 )
+		(void)ulPortSetInterruptMask();
+} // void vPortDisableInterrupts(void)
+
+
+
+void vPortEnableInterrupts(void)
+{
+	if ( irq_depth )
+	{
+		irq_depth = 1;
+		vPortClearInterruptMask(0);
+	}
+} // void vPortEnableInterrupts(void)
+
+
+
+BaseType_t xPortIsInsideInterrupt(void)
+{
+	return (this_thread==NULL) ? pdTRUE : pdFALSE;
+} // BaseType_t xPortIsInsideInterrupt(void)
+
+
+
+/*============================================================================*/
+/*
+ * Called by the kernel when it frees a task: let its thread end.
+ */
+/*============================================================================*/
+void vPortCleanUpTCB(void *pxTCB)
+{
+	S_Port_Thread *pthread_hdl = port_get_thread(pxTCB);
+
+	pthread_mutex_lock(&pthread_hdl->lock);
+	pthread_hdl->exit = true;
+	pthread_cond_signal(&pthread_hdl->cond);
+	pthread_mutex_unlock(&pthread_hdl->lock);
+} // void vPortCleanUpTCB(void *pxTCB)
+
+
+
+/*============================================================================*/
+/*
+ * The idle task never calls the kernel on its own, so this is where it takes
+ * the switches requested by the tick thread.
+ */
+/*============================================================================*/
+void vPortIdleYield(void)
+{
+	struct timespec pause = {0, NSEC_PER_SEC/(configTICK_RATE_HZ*10)};
+
+	if ( !switch_pending )
+		nanosleep(&pause, NULL);
+	if ( switch_pending )
+		vPortYield();
+} // void vPortIdleYield(void)
@@ -0,0 +1,101 @@
+/* See COPYING.txt for license details. */
+
+/*
+*
+* portmacro.h
+*
+* FreeRTOS port for the host build: every task runs on its own POSIX thread
+* and only the thread of the task selected by the scheduler is allowed to run.
+*
+* Interrupt masking is a process wide mutex, the tick comes from a separate
+* thread that behaves like the SysTick interrupt. A context switch requested
+* by the tick (or by an "ISR" running on a non-task thread) is taken the next
+* time the running task leaves a critical section or calls the kernel, so
+* tasks that spin without ever calling the kernel are not preempted.
+*
+* M1 Project
+*
+*/
+
+#ifndef PORTMACRO_H
+#define PORTMACRO_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Type definitions */
+#define portCHAR				char
+#define portFLOAT				float
+#define portDOUBLE				double
+#define portLONG				long
+#define portSHORT				short
+#define portSTACK_TYPE			uintptr_t
+#define portBASE_TYPE			long
+
+typedef portSTACK_TYPE	StackType_t;
+typedef long			BaseType_t;
+typedef unsigned long	UBaseType_t;
+
+#if ( configUSE_16_BIT_TICKS == 1 )
+	#error The host port uses 32-bit ticks
+#endif
+typedef uint32_t		TickType_t;
+#define portMAX_DELAY				( TickType_t ) 0xffffffffUL
+#define portTICK_TYPE_IS_ATOMIC		1
+
+/* 64-bit hosts: the kernel stores pointers in this type */
+#define portPOINTER_SIZE_TYPE		uintptr_t
+
+/* Architecture specifics */
+#define portARCH_NAME				"POSIX threads"
+#define portSTACK_GROWTH			( -1 )
+#define portTICK_PERIOD_MS			( ( TickType_t ) 1000 / configTICK_RATE_HZ )
+#define portBYTE_ALIGNMENT			8
+#define portNOP()
+#define portINLINE					__inline
+#define portFORCE_INLINE			inline __attribute__( ( always_inline ) )
+#define portDONT_DISCARD			__attribute__( ( used ) )
+
+/* Scheduler utilities */
+extern void vPortYield( void );
+extern void vPortYieldFromISR( BaseType_t xSwitchRequired );
+
+#define portYIELD()							vPortYield()
+#define portEND_SWITCHING_ISR( xSwitchRequired )	vPortYieldFromISR( xSwitchRequired )
+#define portYIELD_FROM_ISR( x )				portEND_SWITCHING_ISR( x )
+
+/* Critical sections */
+extern void vPortEnterCritical( void );
+extern void vPortExitCritical( void );
+extern uint32_t ulPortSetInterruptMask( void );
+extern void vPortClearInterruptMask( uint32_t ulMask );
+extern void vPortDisableInterrupts( void );
+extern void vPortEnableInterrupts( void );
+extern BaseType_t xPortIsInsideInterrupt( void );
+
+#define portSET_INTERRUPT_MASK_FROM_ISR()		ulPortSetInterruptMask()
+#define portCLEAR_INTERRUPT_MASK_FROM_ISR( x )	vPortClearInterruptMask( x )
+#define portDISABLE_INTERRUPTS()				vPortDisableInterrupts()
+#define portENABLE_INTERRUPTS()					vPortEnableInterrupts()
+#define portENTER_CRITICAL()					vPortEnterCritical()
+#define portEXIT_CRITICAL()						vPortExitCritical()
+
+/* Task function macros */
+#define portTASK_FUNCTION_PROTO( vFunction, pvParameters )	void vFunction( void * pvParameters )
+#define portTASK_FUNCTION( vFunction, pvParameters )		void vFunction( void * pvParameters )
+
+/* The thread of a deleted task is released when the kernel frees the TCB */
+extern void vPortCleanUpTCB( void * pxTCB );
+#define portCLEAN_UP_TCB( pxTCB )	vPortCleanUpTCB( pxTCB )
+
+#define portASSERT_IF_INTERRUPT_PRIORITY_INVALID()
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PORTMACRO_H */
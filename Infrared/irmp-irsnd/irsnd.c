@@ -452,6 +452,59 @@ static void irsnd_set_freq(IRSND_FREQ_TYPE freq)
 
 
 
+/*============================================================================*/
+/*
+ * This function sets an arbitrary carrier for raw signals.
+ * Unlike irsnd_set_freq() the timer runs undivided, so the period is exact to
+ * one timer clock and the duty cycle has 1% resolution.
+*/
+/*============================================================================*/
+void irsnd_set_carrier(uint32_t freq, uint8_t duty_pct)
+{
+	TIM_MasterConfigTypeDef sMasterConfig;
+	TIM_OC_InitTypeDef sConfigOC = {0};
+	uint32_t period;
+
+	if ( !freq )
+		freq = IRSND_FREQ_38_KHZ;
+	if ( !duty_pct || duty_pct >= 100 )
+		duty_pct = 33;
+
+	period = (HAL_RCC_GetPCLK2Freq() + freq/2) / freq; // Timer clocks per carrier period, rounded
+	if ( period > 0x10000 ) // 16-bit counter
+		period = 0x10000;
+
+	pir_timhdl_carrier->Init.Prescaler = 0;
+	pir_timhdl_carrier->Init.CounterMode = TIM_COUNTERMODE_UP;
+	pir_timhdl_carrier->Init.Period = period - 1;
+	pir_timhdl_carrier->Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
+	pir_timhdl_carrier->Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
+
+	if (HAL_TIM_PWM_Init(pir_timhdl_carrier) != HAL_OK)
+	{
+		Error_Handler();
+	}
+
+	sMasterConfig.MasterOutputTrigger = TIM_TRGO_RESET;
+	sMasterConfig.MasterSlaveMode = TIM_MASTERSLAVEMODE_DISABLE;
+	if (HAL_TIMEx_MasterConfigSynchronization(pir_timhdl_carrier, &sMasterConfig) != HAL_OK)
+	{
+		Error_Handler();
+	}
+
+	sConfigOC.OCMode = TIM_OCMODE_PWM1;
+	sConfigOC.Pulse = (period * duty_pct) / 100;
+	sConfigOC.OCNPolarity = TIM_OCPOLARITY_HIGH;
+	sConfigOC.OCFastMode = TIM_OCFAST_DISABLE;
+	sConfigOC.OCNIdleState = TIM_OCNIDLESTATE_RESET;
+	if (HAL_TIM_PWM_ConfigChannel(pir_timhdl_carrier, &sConfigOC, ir_carrier_pwm_channel) != HAL_OK)
+	{
+		Error_Handler();
+	}
+} // void irsnd_set_carrier(uint32_t freq, uint8_t duty_pct)
+
+
+
 /*============================================================================*/
 /*
  * Switch PWM on for Carrier
@@ -151,6 +151,7 @@ uint8_t m1_check_ir_ota_frame_status(void);
 uint8_t m1_ir_ota_frame_post_process(uint8_t ir_protocol);
 void irsnd_on(void);
 void irsnd_off(void);
+void irsnd_set_carrier(uint32_t freq, uint8_t duty_pct);
 
 #endif
 extern void                                     irsnd_stop (void);
@@ -169,6 +169,13 @@ void vPortDefineHeapRegions( const HeapRegion_t * const pxHeapRegions ) PRIVILEG
  */
 void vPortGetHeapStats( HeapStats_t * pxHeapStats );
 
+/*
+ * Counts the free heap blocks by size: bin n holds blocks smaller than
+ * 64 * 4^n bytes, the last bin holds all larger blocks.
+ */
+void vPortGetHeapFreeBlockHistogram( size_t * pxBins,
+                                     size_t xNumberOfBins );
+
 /*
  * Map to the memory management routines required for the port.
  */
@@ -58,6 +58,9 @@
 /* Block sizes must not get too small. */
 #define heapMINIMUM_BLOCK_SIZE    ( ( size_t ) ( xHeapStructSize << 1 ) )
 
+/* Upper limit of the first vPortGetHeapFreeBlockHistogram() bin, in bytes. */
+#define heapHISTOGRAM_FIRST_LIMIT    ( ( size_t ) 64 )
+
 /* Assumes 8bit bytes! */
 #define heapBITS_PER_BYTE         ( ( size_t ) 8 )
 
@@ -535,3 +538,46 @@ void vPortGetHeapStats( HeapStats_t * pxHeapStats )
     taskEXIT_CRITICAL();
 }
 /*-----------------------------------------------------------*/
+
+void vPortGetHeapFreeBlockHistogram( size_t * pxBins,
+                                     size_t xNumberOfBins )
+{
+    BlockLink_t * pxBlock;
+    size_t xBin, xLimit;
+
+    for( xBin = 0; xBin < xNumberOfBins; xBin++ )
+    {
+        pxBins[ xBin ] = 0;
+    }
+
+    if( xNumberOfBins == 0 )
+    {
+        return;
+    }
+
+    vTaskSuspendAll();
+    {
+        pxBlock = xStart.pxNextFreeBlock;
+
+        if( pxBlock != NULL )
+        {
+            while( pxBlock != pxEnd )
+            {
+                /* Bin n holds blocks smaller than 64 * 4^n bytes, the last bin
+                 * holds everything larger. */
+                for( xBin = 0, xLimit = heapHISTOGRAM_FIRST_LIMIT; xBin < ( xNumberOfBins - 1 ); xBin++, xLimit <<= 2 )
+                {
+                    if( pxBlock->xBlockSize < xLimit )
+                    {
+                        break;
+                    }
+                }
+
+                pxBins[ xBin ]++;
+                pxBlock = pxBlock->pxNextFreeBlock;
+            }
+        }
+    }
+    ( void ) xTaskResumeAll();
+}
+/*-----------------------------------------------------------*/
@@ -9,6 +9,7 @@
 #include <string.h>
 #include <stdio.h>  
 #include "nfc_ctx.h"
+#include "nfc_dump_bin.h"
 #include "rfal_nfc.h"
 #include "legacy/nfc_driver.h"   // Use Emu_SetNfcA, Emu_Clear
 
@@ -280,6 +281,8 @@ void nfc_ctx_clear_dump(void)
     g_nfc_ctx.dump.max_seen_unit = 0;
     g_nfc_ctx.dump.has_dump      = false;
     nfc_ctx_unlock();
+
+    nfc_dump_bin_forget();  /* A new dump is not relative to any container */
 }
 
 /*============================================================================*/
@@ -392,9 +395,25 @@ uint8_t FillNfcContextFromDevice(const rfalNfcDevice* dev)
             break;
         }
 
+        case RFAL_NFC_LISTEN_TYPE_NFCV:
+        {
+            /* RFAL keeps the NFC-V UID LSB first; store it MSB first (E0 ..) as printed on the tag */
+            uint8_t len = (uint8_t)dev->nfcidLen;
+            if (len > sizeof(c->head.uid)) len = sizeof(c->head.uid);
+            c->head.tech    = M1NFC_TECH_V;
+            c->head.family  = M1NFC_FAM_15693;
+            c->head.uid_len = len;
+            for (uint8_t i = 0; i < len; i++) {
+                c->head.uid[i] = dev->nfcid[len - 1U - i];
+            }
+
+            c->head.v.has_dsfid = true;
+            c->head.v.dsfid     = dev->dev.nfcv.InvRes.DSFID;
+            break;
+        }
+
         case RFAL_NFC_LISTEN_TYPE_NFCB:
         case RFAL_NFC_LISTEN_TYPE_NFCF:
-        case RFAL_NFC_LISTEN_TYPE_NFCV:
         default:
             return 2;
     }
@@ -422,8 +441,8 @@ void nfc_ctx_sync_emu(void)
     nfc_run_ctx_t* c = nfc_ctx_get();
     if (!c) return;
 
-    /* If no UID, emulation impossible → clear */
-    if (c->head.uid_len == 0) {
+    /* If no UID, emulation impossible → clear. Only NFC-A can be emulated by the ST25R3916 */
+    if (c->head.uid_len == 0 || c->head.tech != M1NFC_TECH_A) {
         Emu_Clear();
         return;
     }
@@ -861,6 +880,60 @@ uint8_t nfc_ctx_get_t2t_version(uint8_t out[8])
     return s_t2t_version_len;
 }
 
+/*============================================================================*/
+/**
+ * @brief nfc_ctx_set_t2t_signature - Set T2T originality signature
+ * 
+ * Stores the 32-byte READ_SIG response so it can be saved and replayed
+ * during emulation.
+ * 
+ * @param[in] sig Signature bytes (NULL to clear)
+ * @param[in] len Length of signature (must be NFC_T2T_SIG_LEN)
+ * @retval None
+ */
+/*============================================================================*/
+void nfc_ctx_set_t2t_signature(const uint8_t *sig, uint8_t len)
+{
+    if (!sig || len != NFC_T2T_SIG_LEN) {
+        g_nfc_ctx.t2t.has_signature = false;
+        return;
+    }
+    memcpy(g_nfc_ctx.t2t.signature, sig, NFC_T2T_SIG_LEN);
+    g_nfc_ctx.t2t.has_signature = true;
+}
+
+/*============================================================================*/
+/**
+ * @brief nfc_ctx_set_t2t_counter - Set one T2T one-way counter value
+ * 
+ * @param[in] idx Counter index (0..NFC_T2T_CNT_MAX-1)
+ * @param[in] value 24-bit counter value
+ * @retval None
+ */
+/*============================================================================*/
+void nfc_ctx_set_t2t_counter(uint8_t idx, uint32_t value)
+{
+    if (idx >= NFC_T2T_CNT_MAX) {
+        return;
+    }
+    g_nfc_ctx.t2t.counter[idx]  = value & 0x00FFFFFFUL;
+    g_nfc_ctx.t2t.counter_mask |= (uint8_t)(1u << idx);
+}
+
+/*============================================================================*/
+/**
+ * @brief nfc_ctx_clear_t2t_extras - Clear T2T signature and counters
+ * 
+ * @retval None
+ */
+/*============================================================================*/
+void nfc_ctx_clear_t2t_extras(void)
+{
+    g_nfc_ctx.t2t.has_signature = false;
+    g_nfc_ctx.t2t.counter_mask  = 0;
+    memset(g_nfc_ctx.t2t.counter, 0, sizeof(g_nfc_ctx.t2t.counter));
+}
+
 /*============================================================================*/
 /**
  * @brief nfc_ctx_set_t2t_page - Set T2T page data
@@ -910,6 +983,7 @@ void nfc_ctx_set_t2t_page(uint16_t page, const uint8_t data[4])
     uint8_t *page_ptr = &dump_buf[idx * d->unit_size];
 
     memcpy(page_ptr, data, 4);
+    nfc_dump_bin_mark_dirty(idx);   /* Picked up by the next incremental .nfb save */
 
     /* If valid_bits exists, mark this page as valid */
     if (d->valid_bits != NULL) {
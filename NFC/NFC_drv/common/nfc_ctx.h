@@ -41,6 +41,7 @@
 #define M1NFC_FAM_CLASSIC        0
 #define M1NFC_FAM_ULTRALIGHT     1
 #define M1NFC_FAM_DESFIRE        2
+#define M1NFC_FAM_15693          3
 
 #define M1NFC_TECH_A    0
 #define M1NFC_TECH_B    1
@@ -48,6 +49,8 @@
 #define M1NFC_TECH_V    3
 
 #define NFC_T2T_NDEF_MAX_LEN   240   // Adjust later if needed
+#define NFC_T2T_SIG_LEN        32    // READ_SIG (0x3C) originality signature
+#define NFC_T2T_CNT_MAX        3     // READ_CNT (0x39) counters 0..2 (Ultralight EV1)
 
 
 /* NFC dump workspace (size can be adjusted as needed) */
@@ -86,6 +89,15 @@ typedef struct {
         uint8_t   ats[32];  // default
         uint8_t   ats_len;  /* Can be 0 */
     } a;
+
+    /* Tech V additional information (ISO15693 GET SYSTEM INFORMATION) */
+    struct {
+        uint8_t   dsfid;    bool has_dsfid;
+        uint8_t   afi;      bool has_afi;
+        uint8_t   ic_ref;   bool has_ic_ref;
+        uint8_t   block_size;   /* Bytes per block, 0 = unknown */
+        uint16_t  block_count;  /* Blocks reported by the tag, 0 = unknown */
+    } v;
 } nfc_header_t;
 
 /* ======================= 3) Dump Metadata ======================= */
@@ -124,6 +136,11 @@ typedef struct {
     uint8_t  ndef[NFC_T2T_NDEF_MAX_LEN];
     uint16_t ndef_len;
     bool     valid;                  // Flag indicating if NDEF is actually filled
+
+    uint8_t  signature[NFC_T2T_SIG_LEN];
+    bool     has_signature;
+    uint32_t counter[NFC_T2T_CNT_MAX];   // 24-bit one-way counters
+    uint8_t  counter_mask;               // bit n set = counter[n] valid
 } nfc_t2t_info_t;
 
 /* ======================= Top-level Runtime Context ======================= */
@@ -314,6 +331,31 @@ void nfc_ctx_set_t2t_version(const uint8_t *ver, uint8_t len);
  */
 uint8_t nfc_ctx_get_t2t_version(uint8_t out[8]);
 
+/**
+ * @brief nfc_ctx_set_t2t_signature - Set T2T originality signature
+ * 
+ * @param[in] sig Signature bytes (NULL to clear)
+ * @param[in] len Length of signature (must be NFC_T2T_SIG_LEN)
+ * @retval None
+ */
+void nfc_ctx_set_t2t_signature(const uint8_t *sig, uint8_t len);
+
+/**
+ * @brief nfc_ctx_set_t2t_counter - Set one T2T one-way counter value
+ * 
+ * @param[in] idx Counter index (0..NFC_T2T_CNT_MAX-1)
+ * @param[in] value 24-bit counter value
+ * @retval None
+ */
+void nfc_ctx_set_t2t_counter(uint8_t idx, uint32_t value);
+
+/**
+ * @brief nfc_ctx_clear_t2t_extras - Clear T2T signature and counters
+ * 
+ * @retval None
+ */
+void nfc_ctx_clear_t2t_extras(void);
+
 /**
  * @brief nfc_ctx_set_t2t_page - Set T2T page data
  * 
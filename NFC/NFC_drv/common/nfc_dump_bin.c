@@ -0,0 +1,666 @@
+/* See COPYING.txt for license details. */
+
+/*
+ * nfc_dump_bin.c
+ *
+ * Binary NFC dump container (.nfb): load, full save, incremental save and
+ * lossless conversion back to the .nfc text format (the text loader writes
+ * the container, see nfc_profile_load).
+ */
+
+#include <string.h>
+#include <stdio.h>
+
+#include "nfc_dump_bin.h"
+#include "nfc_file.h"
+#include "bit_util.h"   /* crc16 */
+#include "logger.h"
+
+#define NFC_BIN_CRC_POLY        0x1021U
+#define NFC_BIN_CRC_INIT        0xFFFFU
+
+#define MFC_BLOCK_SIZE          16U
+
+_Static_assert(sizeof(nfc_bin_header_t) <= NFC_BIN_DATA_ALIGN, "nfc_bin_header_t exceeds data alignment");
+_Static_assert(sizeof(nfc_bin_sector_t) == 20U, "nfc_bin_sector_t layout changed");
+_Static_assert(NFC_T2T_SIG_LEN == 32U && NFC_T2T_CNT_MAX == 3U, "nfc_bin_header_t T2T fields out of step with nfc_ctx");
+
+/* Units written since the last save (same granularity as g_nfc_valid_bits) */
+static uint8_t s_dirty_bits[NFC_VALID_BITS_SIZE];
+static bool    s_dirty_any = false;
+
+/* Data CRC of the container the dump was last loaded from or written to, the
+ * dirty units are relative to it */
+static uint16_t s_base_crc;
+static bool     s_base_valid = false;
+
+/* Sector table workspace (Classic 4K worst case) */
+static nfc_bin_sector_t s_sectors[NFC_BIN_MFC_MAX_SECTORS];
+
+
+/*============================================================================*/
+/**
+ * @brief Number of units actually in use in the context dump
+ * @param d Dump metadata
+ * @return Unit count to store (0 if no dump)
+ */
+/*============================================================================*/
+static uint32_t nfc_bin_used_units(const nfc_dump_meta_t *d)
+{
+    if (!d->has_dump || d->data == NULL || d->unit_size == 0 || d->unit_count == 0)
+        return 0;
+
+    uint32_t used = d->max_seen_unit + 1U;
+    if (used > d->unit_count)
+        used = d->unit_count;
+    return used;
+}
+
+/*============================================================================*/
+/**
+ * @brief Mifare Classic block layout helpers
+ */
+/*============================================================================*/
+static uint16_t mfc_sector_first_block(uint16_t sector)
+{
+    return (sector < 32U) ? (uint16_t)(sector * 4U) : (uint16_t)(128U + (sector - 32U) * 16U);
+}
+
+static uint16_t mfc_sector_block_count(uint16_t sector)
+{
+    return (sector < 32U) ? 4U : 16U;
+}
+
+static uint16_t mfc_sector_count_for_blocks(uint32_t blocks)
+{
+    uint16_t sectors = 0;
+    while (sectors < NFC_BIN_MFC_MAX_SECTORS &&
+           mfc_sector_first_block(sectors) < blocks) {
+        sectors++;
+    }
+    return sectors;
+}
+
+/*============================================================================*/
+/**
+ * @brief Test a bit in a unit bitmap (NULL bitmap means "all set")
+ */
+/*============================================================================*/
+static bool nfc_bin_bit_get(const uint8_t *bits, uint32_t idx)
+{
+    if (bits == NULL)
+        return true;
+    return (bits[idx >> 3] & (uint8_t)(1u << (idx & 7U))) != 0;
+}
+
+/*============================================================================*/
+/**
+ * @brief Build the Classic sector table from the trailer blocks in the dump
+ * @param ctx NFC context
+ * @param units Units stored in the container
+ * @return Number of sectors filled into s_sectors
+ */
+/*============================================================================*/
+static uint16_t nfc_bin_build_sectors(const nfc_run_ctx_t *ctx, uint32_t units)
+{
+    const nfc_dump_meta_t *d = &ctx->dump;
+
+    if (ctx->head.family != M1NFC_FAM_CLASSIC || d->unit_size != MFC_BLOCK_SIZE || units == 0)
+        return 0;
+
+    uint16_t sectors = mfc_sector_count_for_blocks(units);
+    memset(s_sectors, 0, sizeof(s_sectors));
+
+    for (uint16_t s = 0; s < sectors; s++) {
+        uint32_t trailer = (uint32_t)mfc_sector_first_block(s) + mfc_sector_block_count(s) - 1U;
+        if (trailer >= units || !nfc_bin_bit_get(d->valid_bits, trailer))
+            continue;
+
+        const uint8_t *blk = &d->data[trailer * MFC_BLOCK_SIZE];
+        memcpy(s_sectors[s].key_a,  &blk[0],  6);
+        memcpy(s_sectors[s].access, &blk[6],  4);
+        memcpy(s_sectors[s].key_b,  &blk[10], 6);
+        s_sectors[s].key_mask = NFC_BIN_KEY_A_KNOWN | NFC_BIN_KEY_B_KNOWN;
+    }
+
+    return sectors;
+}
+
+/*============================================================================*/
+/**
+ * @brief Fill a container header from the context
+ * @param h Header to fill
+ * @param ctx NFC context
+ * @param src Stamp of the sibling .nfc (NULL if none)
+ */
+/*============================================================================*/
+static void nfc_bin_fill_header(nfc_bin_header_t *h, const nfc_run_ctx_t *ctx, const FILINFO *src)
+{
+    const nfc_dump_meta_t *d = &ctx->dump;
+    uint32_t units = nfc_bin_used_units(d);
+
+    memset(h, 0, sizeof(*h));
+    h->magic       = NFC_BIN_MAGIC;
+    h->version     = NFC_BIN_VERSION;
+    h->header_size = (uint16_t)sizeof(*h);
+
+    h->tech    = ctx->head.tech;
+    h->family  = ctx->head.family;
+    h->uid_len = ctx->head.uid_len;
+    memcpy(h->uid, ctx->head.uid, sizeof(h->uid));
+    if (ctx->head.a.has_atqa) {
+        h->flags |= NFC_BIN_F_HAS_ATQA;
+        memcpy(h->atqa, ctx->head.a.atqa, sizeof(h->atqa));
+    }
+    if (ctx->head.a.has_sak) {
+        h->flags |= NFC_BIN_F_HAS_SAK;
+        h->sak = ctx->head.a.sak;
+    }
+    h->ats_len = ctx->head.a.ats_len;
+    memcpy(h->ats, ctx->head.a.ats, sizeof(h->ats));
+    if (nfc_ctx_get_t2t_version(h->t2t_version) == sizeof(h->t2t_version)) {
+        h->flags |= NFC_BIN_F_HAS_T2T_VERSION;
+    }
+    if (ctx->t2t.has_signature) {
+        h->flags |= NFC_BIN_F_HAS_T2T_SIG;
+        memcpy(h->t2t_signature, ctx->t2t.signature, sizeof(h->t2t_signature));
+    }
+    h->t2t_counter_mask = ctx->t2t.counter_mask;
+    memcpy(h->t2t_counter, ctx->t2t.counter, sizeof(h->t2t_counter));
+    if (ctx->head.v.has_dsfid) {
+        h->flags |= NFC_BIN_F_HAS_V_DSFID;
+        h->v_dsfid = ctx->head.v.dsfid;
+    }
+    if (ctx->head.v.has_afi) {
+        h->flags |= NFC_BIN_F_HAS_V_AFI;
+        h->v_afi = ctx->head.v.afi;
+    }
+    if (ctx->head.v.has_ic_ref) {
+        h->flags |= NFC_BIN_F_HAS_V_IC_REF;
+        h->v_ic_ref = ctx->head.v.ic_ref;
+    }
+    h->v_block_size  = ctx->head.v.block_size;
+    h->v_block_count = ctx->head.v.block_count;
+
+    h->unit_size     = units ? d->unit_size : 0;
+    h->unit_count    = units;
+    h->origin        = units ? d->origin : 0;
+    h->max_seen_unit = units ? d->max_seen_unit : 0;
+    h->sector_count  = nfc_bin_build_sectors(ctx, units);
+
+    h->data_offset   = NFC_BIN_DATA_ALIGN;
+    h->valid_offset  = h->data_offset + units * h->unit_size;
+    h->sector_offset = h->valid_offset + (units + 7U) / 8U;
+
+    if (src) {
+        h->flags    |= NFC_BIN_F_HAS_SRC_STAMP;
+        h->src_size  = (uint32_t)src->fsize;
+        h->src_fdate = src->fdate;
+        h->src_ftime = src->ftime;
+    }
+
+    h->data_crc   = units ? crc16(d->data, units * h->unit_size, NFC_BIN_CRC_POLY, NFC_BIN_CRC_INIT)
+                          : NFC_BIN_CRC_INIT;
+    h->header_crc = crc16((const uint8_t *)h, offsetof(nfc_bin_header_t, header_crc),
+                          NFC_BIN_CRC_POLY, NFC_BIN_CRC_INIT);
+}
+
+/*============================================================================*/
+/**
+ * @brief Validate a header read from disk
+ * @param h Header to check
+ * @return true if magic, version, size and CRC are consistent
+ */
+/*============================================================================*/
+static bool nfc_bin_header_valid(const nfc_bin_header_t *h)
+{
+    if (h->magic != NFC_BIN_MAGIC || h->version != NFC_BIN_VERSION ||
+        h->header_size != sizeof(*h)) {
+        return false;
+    }
+    if (h->header_crc != crc16((const uint8_t *)h, offsetof(nfc_bin_header_t, header_crc),
+                               NFC_BIN_CRC_POLY, NFC_BIN_CRC_INIT)) {
+        return false;
+    }
+    if (h->uid_len > sizeof(h->uid) || h->ats_len > sizeof(h->ats) ||
+        h->sector_count > NFC_BIN_MFC_MAX_SECTORS) {
+        return false;
+    }
+    if (h->unit_count && (h->unit_size == 0 || h->data_offset < sizeof(*h))) {
+        return false;
+    }
+    return true;
+}
+
+/*============================================================================*/
+/**
+ * @brief Write len bytes at an absolute file offset
+ */
+/*============================================================================*/
+static bool nfc_bin_write_at(FIL *fp, uint32_t ofs, const void *buf, uint32_t len)
+{
+    UINT bw = 0;
+
+    if (len == 0)
+        return true;
+    if (f_lseek(fp, ofs) != FR_OK)
+        return false;
+    return (f_write(fp, buf, len, &bw) == FR_OK) && (bw == len);
+}
+
+/*============================================================================*/
+/**
+ * @brief Write the valid bitmap and sector table sections
+ */
+/*============================================================================*/
+static bool nfc_bin_write_tail(FIL *fp, const nfc_bin_header_t *h, const nfc_run_ctx_t *ctx)
+{
+    uint32_t vbytes = (h->unit_count + 7U) / 8U;
+
+    if (ctx->dump.valid_bits) {
+        if (!nfc_bin_write_at(fp, h->valid_offset, ctx->dump.valid_bits, vbytes))
+            return false;
+    } else {
+        /* No bitmap in the context means every unit is valid */
+        static const uint8_t all_valid[32] = {
+            0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+            0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF
+        };
+        uint32_t ofs = h->valid_offset;
+        while (vbytes) {
+            uint32_t n = (vbytes > sizeof(all_valid)) ? sizeof(all_valid) : vbytes;
+            if (!nfc_bin_write_at(fp, ofs, all_valid, n))
+                return false;
+            ofs += n;
+            vbytes -= n;
+        }
+    }
+
+    return nfc_bin_write_at(fp, h->sector_offset, s_sectors,
+                            (uint32_t)h->sector_count * sizeof(nfc_bin_sector_t));
+}
+
+/*============================================================================*/
+/**
+ * @brief Read and validate the header of an existing container
+ */
+/*============================================================================*/
+static bool nfc_bin_read_header(FIL *fp, nfc_bin_header_t *h)
+{
+    UINT br = 0;
+
+    if (f_read(fp, h, sizeof(*h), &br) != FR_OK || br != sizeof(*h))
+        return false;
+    return nfc_bin_header_valid(h);
+}
+
+
+/*============================================================================*/
+/**
+ * @brief Load a .nfb container into nfc_ctx
+ *
+ * The data section starts on a 512-byte boundary, so FatFs transfers it
+ * straight from the card into dump_buf with multi-sector reads.
+ *
+ * @param path Full path on SD card
+ * @param dump_buf Workspace to receive dump data
+ * @param dump_buf_bytes Size of dump_buf
+ * @param valid_bits Unit validity bitmap (optional, NULL allowed)
+ * @param valid_bits_bytes Size of valid_bits buffer
+ * @return NFC_STORAGE_OK on success, error code on failure
+ */
+/*============================================================================*/
+nfc_storage_result_t nfc_dump_bin_load(const char *path,
+                                       uint8_t *dump_buf, uint32_t dump_buf_bytes,
+                                       uint8_t *valid_bits, uint32_t valid_bits_bytes)
+{
+    FIL fp;
+    UINT br = 0;
+    nfc_bin_header_t h;
+    nfc_storage_result_t ret = NFC_STORAGE_OK;
+
+    if (!path || !dump_buf || dump_buf_bytes == 0)
+        return NFC_STORAGE_ERR_NO_BUFFER;
+
+    nfc_run_ctx_t *c = nfc_ctx_get();
+
+    nfc_ctx_begin_file(path);
+    memset(&c->head, 0, sizeof(c->head));
+    nfc_ctx_clear_dump();
+    nfc_dump_bin_clear_dirty();
+
+    if (f_open(&fp, path, FA_READ) != FR_OK) {
+        c->file.sys_error = 1;
+        return NFC_STORAGE_ERR_IO;
+    }
+
+    do {
+        if (!nfc_bin_read_header(&fp, &h)) {
+            platformLog("[NFC Bin] invalid header: %s\r\n", path);
+            ret = NFC_STORAGE_ERR_FORMAT;
+            break;
+        }
+
+        uint32_t data_bytes = h.unit_count * h.unit_size;
+        uint32_t vbytes     = (h.unit_count + 7U) / 8U;
+        if (data_bytes > dump_buf_bytes || (valid_bits && vbytes > valid_bits_bytes)) {
+            ret = NFC_STORAGE_ERR_NO_BUFFER;
+            break;
+        }
+
+        if (data_bytes) {
+            if (f_lseek(&fp, h.data_offset) != FR_OK ||
+                f_read(&fp, dump_buf, data_bytes, &br) != FR_OK || br != data_bytes) {
+                ret = NFC_STORAGE_ERR_IO;
+                break;
+            }
+            if (crc16(dump_buf, data_bytes, NFC_BIN_CRC_POLY, NFC_BIN_CRC_INIT) != h.data_crc) {
+                platformLog("[NFC Bin] data CRC mismatch: %s\r\n", path);
+                ret = NFC_STORAGE_ERR_FORMAT;
+                break;
+            }
+        }
+        memset(dump_buf + data_bytes, 0, dump_buf_bytes - data_bytes);
+
+        if (valid_bits && valid_bits_bytes) {
+            memset(valid_bits, 0, valid_bits_bytes);
+            if (vbytes && (f_lseek(&fp, h.valid_offset) != FR_OK ||
+                           f_read(&fp, valid_bits, vbytes, &br) != FR_OK || br != vbytes)) {
+                ret = NFC_STORAGE_ERR_IO;
+                break;
+            }
+        }
+    } while (0);
+
+    f_close(&fp);
+
+    if (ret != NFC_STORAGE_OK) {
+        c->file.sys_error = 1;
+        return ret;
+    }
+
+    /* Header → context */
+    c->head.tech    = h.tech;
+    c->head.family  = h.family;
+    c->head.uid_len = h.uid_len;
+    memcpy(c->head.uid, h.uid, sizeof(c->head.uid));
+    if (h.flags & NFC_BIN_F_HAS_ATQA) {
+        memcpy(c->head.a.atqa, h.atqa, sizeof(c->head.a.atqa));
+        c->head.a.has_atqa = true;
+    }
+    if (h.flags & NFC_BIN_F_HAS_SAK) {
+        c->head.a.sak     = h.sak;
+        c->head.a.has_sak = true;
+    }
+    c->head.a.ats_len = h.ats_len;
+    memcpy(c->head.a.ats, h.ats, sizeof(c->head.a.ats));
+
+    nfc_ctx_set_t2t_version(h.t2t_version, (h.flags & NFC_BIN_F_HAS_T2T_VERSION) ? sizeof(h.t2t_version) : 0);
+    nfc_ctx_clear_t2t_extras();
+    if (h.flags & NFC_BIN_F_HAS_T2T_SIG)
+        nfc_ctx_set_t2t_signature(h.t2t_signature, sizeof(h.t2t_signature));
+    for (uint8_t i = 0; i < NFC_T2T_CNT_MAX; i++) {
+        if (h.t2t_counter_mask & (1u << i))
+            nfc_ctx_set_t2t_counter(i, h.t2t_counter[i]);
+    }
+
+    c->head.v.has_dsfid   = (h.flags & NFC_BIN_F_HAS_V_DSFID) != 0;
+    c->head.v.dsfid       = h.v_dsfid;
+    c->head.v.has_afi     = (h.flags & NFC_BIN_F_HAS_V_AFI) != 0;
+    c->head.v.afi         = h.v_afi;
+    c->head.v.has_ic_ref  = (h.flags & NFC_BIN_F_HAS_V_IC_REF) != 0;
+    c->head.v.ic_ref      = h.v_ic_ref;
+    c->head.v.block_size  = h.v_block_size;
+    c->head.v.block_count = h.v_block_count;
+
+    /* Capacity is the whole workspace, like the text loader, so emulated writes past the
+     * stored range still land in the dump */
+    if (h.unit_count) {
+        nfc_ctx_set_dump(h.unit_size, dump_buf_bytes / h.unit_size, h.origin,
+                         dump_buf, valid_bits, h.max_seen_unit, true);
+    }
+
+    nfc_ctx_refresh_ui();
+    c->file.sys_error = 0;
+    s_base_crc   = h.data_crc;
+    s_base_valid = true;
+
+    return NFC_STORAGE_OK;
+}
+
+/*============================================================================*/
+/**
+ * @brief Write a complete .nfb container from nfc_ctx
+ *
+ * @param path Full path of the container to create (overwritten)
+ * @param ctx NFC context holding header and dump
+ * @param src Stamp of the sibling .nfc file (NULL if none)
+ * @return true on success, false on failure
+ */
+/*============================================================================*/
+bool nfc_dump_bin_save(const char *path, const nfc_run_ctx_t *ctx, const FILINFO *src)
+{
+    static const uint8_t zero_pad[64] = {0};
+    FIL fp;
+    nfc_bin_header_t h;
+    bool ok;
+
+    if (!path || !ctx)
+        return false;
+
+    nfc_bin_fill_header(&h, ctx, src);
+
+    if (f_open(&fp, path, FA_CREATE_ALWAYS | FA_WRITE) != FR_OK) {
+        platformLog("[NFC Bin] create failed: %s\r\n", path);
+        return false;
+    }
+
+    ok = nfc_bin_write_at(&fp, 0, &h, sizeof(h));
+    for (uint32_t ofs = sizeof(h); ok && ofs < h.data_offset; ofs += sizeof(zero_pad)) {
+        uint32_t n = h.data_offset - ofs;
+        ok = nfc_bin_write_at(&fp, ofs, zero_pad, (n > sizeof(zero_pad)) ? sizeof(zero_pad) : n);
+    }
+    ok = ok && nfc_bin_write_at(&fp, h.data_offset, ctx->dump.data, h.unit_count * h.unit_size);
+    ok = ok && nfc_bin_write_tail(&fp, &h, ctx);
+
+    if (f_close(&fp) != FR_OK)
+        ok = false;
+
+    if (ok) {
+        nfc_dump_bin_clear_dirty();
+        s_base_crc   = h.data_crc;
+        s_base_valid = true;
+    } else {
+        platformLog("[NFC Bin] write failed: %s\r\n", path);
+    }
+
+    return ok;
+}
+
+/*============================================================================*/
+/**
+ * @brief Bring an existing .nfb container up to date with nfc_ctx
+ *
+ * @param path Full path of the container
+ * @param ctx NFC context holding header and dump
+ * @param src Stamp of the sibling .nfc file (NULL if none)
+ * @return true on success, false on failure
+ */
+/*============================================================================*/
+bool nfc_dump_bin_sync(const char *path, const nfc_run_ctx_t *ctx, const FILINFO *src)
+{
+    FIL fp;
+    nfc_bin_header_t old_h, h;
+    bool ok = true;
+
+    if (!path || !ctx)
+        return false;
+
+    if (f_open(&fp, path, FA_READ | FA_WRITE) != FR_OK)
+        return nfc_dump_bin_save(path, ctx, src);
+
+    nfc_bin_fill_header(&h, ctx, src);
+
+    /* Geometry change, unreadable file or a container the dirty units are not
+     * relative to (stale or another card) → rewrite everything */
+    if (!nfc_bin_read_header(&fp, &old_h) ||
+        !s_base_valid                     ||
+        old_h.data_crc     != s_base_crc     ||
+        old_h.uid_len      != h.uid_len      ||
+        memcmp(old_h.uid, h.uid, sizeof(h.uid)) != 0 ||
+        old_h.unit_size    != h.unit_size    ||
+        old_h.unit_count   != h.unit_count   ||
+        old_h.sector_count != h.sector_count ||
+        old_h.data_offset  != h.data_offset) {
+        f_close(&fp);
+        return nfc_dump_bin_save(path, ctx, src);
+    }
+
+    if (s_dirty_any) {
+        for (uint32_t i = 0; ok && i < h.unit_count; i++) {
+            if (!nfc_bin_bit_get(s_dirty_bits, i))
+                continue;
+            ok = nfc_bin_write_at(&fp, h.data_offset + i * h.unit_size,
+                                  &ctx->dump.data[i * h.unit_size], h.unit_size);
+        }
+        ok = ok && nfc_bin_write_tail(&fp, &h, ctx);
+    }
+
+    /* Header last: a torn update leaves a data CRC mismatch, never a silently wrong dump */
+    ok = ok && nfc_bin_write_at(&fp, 0, &h, sizeof(h));
+
+    if (f_close(&fp) != FR_OK)
+        ok = false;
+
+    if (ok) {
+        nfc_dump_bin_clear_dirty();
+        s_base_crc   = h.data_crc;
+        s_base_valid = true;
+    }
+
+    return ok;
+}
+
+/*============================================================================*/
+/**
+ * @brief Check whether a .nfb container was generated from the given .nfc
+ *
+ * @param path Full path of the container
+ * @param src Stamp of the .nfc file (from f_stat)
+ * @return true if the container exists, is valid and matches the stamp
+ */
+/*============================================================================*/
+bool nfc_dump_bin_is_current(const char *path, const FILINFO *src)
+{
+    FIL fp;
+    nfc_bin_header_t h;
+    bool ok;
+
+    if (!path || !src)
+        return false;
+    if (f_open(&fp, path, FA_READ) != FR_OK)
+        return false;
+
+    ok = nfc_bin_read_header(&fp, &h) &&
+         (h.flags & NFC_BIN_F_HAS_SRC_STAMP) &&
+         h.src_size  == (uint32_t)src->fsize &&
+         h.src_fdate == src->fdate &&
+         h.src_ftime == src->ftime;
+
+    f_close(&fp);
+    return ok;
+}
+
+/*============================================================================*/
+/**
+ * @brief Mark a dump unit as modified since the last save
+ * @param idx Unit index (relative to dump origin)
+ */
+/*============================================================================*/
+void nfc_dump_bin_mark_dirty(uint32_t idx)
+{
+    if ((idx >> 3) >= sizeof(s_dirty_bits))
+        return;
+    s_dirty_bits[idx >> 3] |= (uint8_t)(1u << (idx & 7U));
+    s_dirty_any = true;
+}
+
+/*============================================================================*/
+/**
+ * @brief Forget all pending dirty units
+ */
+/*============================================================================*/
+void nfc_dump_bin_clear_dirty(void)
+{
+    memset(s_dirty_bits, 0, sizeof(s_dirty_bits));
+    s_dirty_any = false;
+}
+
+/*============================================================================*/
+/**
+ * @brief Forget the container the dump was loaded from or written to
+ */
+/*============================================================================*/
+void nfc_dump_bin_forget(void)
+{
+    nfc_dump_bin_clear_dirty();
+    s_base_valid = false;
+}
+
+/* Replaces the extension of path (or appends ext if it has none) */
+static bool nfc_dump_bin_swap_ext(const char *path, const char *ext, char *out, size_t outsz)
+{
+    if (!path || !out || outsz == 0)
+        return false;
+
+    const char *dot   = strrchr(path, '.');
+    const char *slash = strrchr(path, '/');
+    size_t stem = (dot && (!slash || dot > slash)) ? (size_t)(dot - path) : strlen(path);
+
+    int n = snprintf(out, outsz, "%.*s%s", (int)stem, path, ext);
+    return (n > 0) && ((size_t)n < outsz);
+}
+
+/*============================================================================*/
+/**
+ * @brief Build the sidecar container path for a .nfc path
+ * @param text_path Path of the .nfc file
+ * @param out Output buffer
+ * @param outsz Size of output buffer
+ * @return true on success, false if the path does not fit
+ */
+/*============================================================================*/
+bool nfc_dump_bin_sidecar_path(const char *text_path, char *out, size_t outsz)
+{
+    return nfc_dump_bin_swap_ext(text_path, NFC_BIN_FILE_EXTENSION, out, outsz);
+}
+
+/*============================================================================*/
+/**
+ * @brief Build the .nfc path a sidecar container belongs to
+ * @param bin_path Path of the .nfb container
+ * @param out Output buffer
+ * @param outsz Size of output buffer
+ * @return true on success, false if the path does not fit
+ */
+/*============================================================================*/
+bool nfc_dump_bin_text_path(const char *bin_path, char *out, size_t outsz)
+{
+    return nfc_dump_bin_swap_ext(bin_path, NFC_BIN_TEXT_FILE_EXTENSION, out, outsz);
+}
+
+/*============================================================================*/
+/**
+ * @brief Convert a .nfb container back into a .nfc text file
+ * @return true on success, false on failure
+ */
+/*============================================================================*/
+bool nfc_dump_bin_to_text(const char *bin_path, const char *text_path)
+{
+    if (nfc_dump_bin_load(bin_path, g_nfc_dump_buf, sizeof(g_nfc_dump_buf),
+                          g_nfc_valid_bits, sizeof(g_nfc_valid_bits)) != NFC_STORAGE_OK) {
+        return false;
+    }
+
+    return nfc_profile_save(text_path, nfc_ctx_get());
+}
@@ -0,0 +1,212 @@
+/* See COPYING.txt for license details. */
+
+/*
+ * nfc_dump_bin.h
+ *
+ * Compact binary NFC dump container (.nfb)
+ *
+ * The text format (.nfc, see nfc_file_form.txt) stays the interchange format.
+ * The binary container keeps the same information in a fixed layout so a
+ * dump can be read straight into g_nfc_dump_buf without line parsing, and so
+ * single units can be rewritten in place (incremental save).
+ *
+ *  Offset            Content
+ *  ----------------  ---------------------------------------------------
+ *  0                 nfc_bin_header_t (padded to NFC_BIN_DATA_ALIGN)
+ *  data_offset       unit_count * unit_size bytes of page/block data
+ *  valid_offset      (unit_count + 7) / 8 bytes of unit valid bitmap
+ *  sector_offset     sector_count * nfc_bin_sector_t (Mifare Classic only)
+ *
+ * All multi-byte fields are little-endian (native on STM32H5).
+ */
+
+#ifndef NFC_DRV_NFC_DUMP_BIN_H_
+#define NFC_DRV_NFC_DUMP_BIN_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "ff.h"
+#include "nfc_ctx.h"
+#include "nfc_storage.h"
+
+#define NFC_BIN_FILE_EXTENSION      ".nfb"
+#define NFC_BIN_FILE_EXTENSION_TMP  "nfb"   /* For IsValidFileSpec (without dot) */
+#define NFC_BIN_TEXT_FILE_EXTENSION ".nfc"  /* The file a container is the sidecar of */
+
+#define NFC_BIN_MAGIC               0x42464E4DUL    /* "MNFB" */
+#define NFC_BIN_VERSION             3U
+#define NFC_BIN_DATA_ALIGN          512U            /* Data starts on a sector boundary */
+
+/* nfc_bin_header_t.flags */
+#define NFC_BIN_F_HAS_ATQA          0x01U
+#define NFC_BIN_F_HAS_SAK           0x02U
+#define NFC_BIN_F_HAS_T2T_VERSION   0x04U
+#define NFC_BIN_F_HAS_SRC_STAMP     0x08U   /* src_* fields describe the sibling .nfc */
+#define NFC_BIN_F_HAS_T2T_SIG       0x10U   /* t2t_signature holds a READ_SIG response */
+#define NFC_BIN_F_HAS_V_DSFID       0x20U
+#define NFC_BIN_F_HAS_V_AFI         0x40U
+#define NFC_BIN_F_HAS_V_IC_REF      0x80U
+
+/* nfc_bin_sector_t.key_mask */
+#define NFC_BIN_KEY_A_KNOWN         0x01U
+#define NFC_BIN_KEY_B_KNOWN         0x02U
+
+#define NFC_BIN_MFC_MAX_SECTORS     40U     /* Mifare Classic 4K */
+
+typedef struct __attribute__((packed)) {
+    uint32_t magic;             /* NFC_BIN_MAGIC */
+    uint16_t version;           /* NFC_BIN_VERSION */
+    uint16_t header_size;       /* sizeof(nfc_bin_header_t) */
+
+    /* Card identity (mirrors nfc_header_t) */
+    uint8_t  tech;              /* M1NFC_TECH_* */
+    uint8_t  family;            /* M1NFC_FAM_* */
+    uint8_t  uid_len;
+    uint8_t  flags;             /* NFC_BIN_F_* */
+    uint8_t  uid[10];
+    uint8_t  atqa[2];
+    uint8_t  sak;
+    uint8_t  ats_len;
+    uint8_t  ats[32];
+    uint8_t  t2t_version[8];    /* GET_VERSION response (Ultralight/NTAG) */
+    uint8_t  t2t_signature[32]; /* READ_SIG response (Ultralight EV1/NTAG21x) */
+    uint32_t t2t_counter[3];    /* READ_CNT values */
+    uint8_t  t2t_counter_mask;  /* bit n = t2t_counter[n] valid */
+    uint8_t  v_dsfid;           /* ISO15693 system information */
+    uint8_t  v_afi;
+    uint8_t  v_ic_ref;
+    uint8_t  v_block_size;      /* Block size reported by the tag (0 = unknown) */
+    uint16_t v_block_count;     /* Block count reported by the tag (0 = unknown) */
+
+    /* Dump geometry (mirrors nfc_dump_meta_t) */
+    uint16_t unit_size;
+    uint16_t sector_count;
+    uint32_t unit_count;        /* Units stored in the data section */
+    uint32_t origin;
+    uint32_t max_seen_unit;
+    uint32_t data_offset;
+    uint32_t valid_offset;
+    uint32_t sector_offset;
+
+    /* Stamp of the .nfc this container was generated from */
+    uint32_t src_size;
+    uint16_t src_fdate;
+    uint16_t src_ftime;
+
+    uint16_t data_crc;          /* CRC-16/CCITT over the data section */
+    uint16_t header_crc;        /* CRC-16/CCITT over all preceding header bytes */
+} nfc_bin_header_t;
+
+/* Mifare Classic sector keys and access bits, taken from the sector trailer */
+typedef struct __attribute__((packed)) {
+    uint8_t  key_a[6];
+    uint8_t  access[4];         /* Access bits (3 bytes) + general purpose byte */
+    uint8_t  key_b[6];
+    uint8_t  key_mask;          /* NFC_BIN_KEY_*_KNOWN */
+    uint8_t  reserved[3];
+} nfc_bin_sector_t;
+
+
+/*============================================================================*/
+/**
+ * @brief Load a .nfb container into nfc_ctx
+ *
+ * Validates the header, then reads the data and valid bitmap sections
+ * directly into the caller's buffers (no text parsing, no temporary copy).
+ *
+ * @param path Full path on SD card
+ * @param dump_buf Workspace to receive dump data
+ * @param dump_buf_bytes Size of dump_buf
+ * @param valid_bits Unit validity bitmap (optional, NULL allowed)
+ * @param valid_bits_bytes Size of valid_bits buffer
+ *
+ * @return NFC_STORAGE_OK on success, error code on failure
+ */
+/*============================================================================*/
+nfc_storage_result_t nfc_dump_bin_load(const char *path,
+                                       uint8_t *dump_buf, uint32_t dump_buf_bytes,
+                                       uint8_t *valid_bits, uint32_t valid_bits_bytes);
+
+/*============================================================================*/
+/**
+ * @brief Write a complete .nfb container from nfc_ctx
+ *
+ * @param path Full path of the container to create (overwritten)
+ * @param ctx NFC context holding header and dump
+ * @param src Stamp of the sibling .nfc file (NULL if none)
+ * @return true on success, false on failure
+ */
+/*============================================================================*/
+bool nfc_dump_bin_save(const char *path, const nfc_run_ctx_t *ctx, const FILINFO *src);
+
+/*============================================================================*/
+/**
+ * @brief Bring an existing .nfb container up to date with nfc_ctx
+ *
+ * If the container is the one the dump was last loaded from or written to
+ * (same card, same data CRC) and has the same geometry, only the header and
+ * the units marked dirty since then are rewritten in place. Otherwise a full
+ * save is performed.
+ *
+ * @param path Full path of the container
+ * @param ctx NFC context holding header and dump
+ * @param src Stamp of the sibling .nfc file (NULL if none)
+ * @return true on success, false on failure
+ */
+/*============================================================================*/
+bool nfc_dump_bin_sync(const char *path, const nfc_run_ctx_t *ctx, const FILINFO *src);
+
+/*============================================================================*/
+/**
+ * @brief Check whether a .nfb container was generated from the given .nfc
+ *
+ * @param path Full path of the container
+ * @param src Stamp of the .nfc file (from f_stat)
+ * @return true if the container exists, is valid and matches the stamp
+ */
+/*============================================================================*/
+bool nfc_dump_bin_is_current(const char *path, const FILINFO *src);
+
+/**
+ * @brief Mark a dump unit as modified since the last save
+ * @param idx Unit index (relative to dump origin)
+ */
+void nfc_dump_bin_mark_dirty(uint32_t idx);
+
+/**
+ * @brief Forget all pending dirty units
+ */
+void nfc_dump_bin_clear_dirty(void);
+
+/**
+ * @brief Forget the dirty units and the container the dump was loaded from or
+ *        written to, so the next sync writes a full container
+ */
+void nfc_dump_bin_forget(void);
+
+/**
+ * @brief Build the sidecar container path for a .nfc path ("a/b.nfc" -> "a/b.nfb")
+ * @param text_path Path of the .nfc file
+ * @param out Output buffer
+ * @param outsz Size of output buffer
+ * @return true on success, false if the path does not fit
+ */
+bool nfc_dump_bin_sidecar_path(const char *text_path, char *out, size_t outsz);
+
+/**
+ * @brief Build the .nfc path a sidecar container belongs to ("a/b.nfb" -> "a/b.nfc")
+ * @param bin_path Path of the .nfb container
+ * @param out Output buffer
+ * @param outsz Size of output buffer
+ * @return true on success, false if the path does not fit
+ */
+bool nfc_dump_bin_text_path(const char *bin_path, char *out, size_t outsz);
+
+/**
+ * @brief Convert a .nfb container back into a .nfc text file
+ * @return true on success, false on failure
+ */
+bool nfc_dump_bin_to_text(const char *bin_path, const char *text_path);
+
+#endif /* NFC_DRV_NFC_DUMP_BIN_H_ */
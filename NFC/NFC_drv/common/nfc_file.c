@@ -11,10 +11,12 @@
 #include "m1_sdcard_man.h"
 #include "m1_file_browser.h"
 #include "m1_file_util.h"
+#include "m1_signal_index.h"
 #include "m1_virtual_kb.h"
 #include "m1_storage.h"
 #include "nfc_file.h"
 #include "nfc_storage.h"
+#include "nfc_dump_bin.h"
 #include "nfc_ctx.h"
 #include "uiView.h"
 #include "privateprofilestring.h"
@@ -33,12 +35,77 @@
 extern uint8_t g_nfc_dump_buf[];
 extern uint8_t g_nfc_valid_bits[];
 
+/*============================================================================*/
+/**
+ * @brief Write one "Key: AA BB .." header line
+ *
+ * @param fp Open file
+ * @param key Field name
+ * @param data Bytes to print
+ * @param len Number of bytes
+ */
+/*============================================================================*/
+static void nfc_write_hex_field(FIL *fp, const char *key, const uint8_t *data, uint8_t len)
+{
+	char line[128];
+	int pos = snprintf(line, sizeof(line), "%s:", key);
+
+	for (uint8_t i = 0; i < len && pos < (int)sizeof(line) - 6; i++)
+	{
+		pos += snprintf(line + pos, sizeof(line) - pos, " %02X", data[i]);
+	}
+	snprintf(line + pos, sizeof(line) - pos, "\r\n");
+	m1_fb_write_to_file(fp, line, strlen(line));
+}
+
+/*============================================================================*/
+/**
+ * @brief Mifare Classic size for the "Mifare Classic type" line
+ *
+ * Taken from the SAK, or the ATQA, the card answered with: a partial dump
+ * does not tell the size. The block count is the last resort.
+ *
+ * @param ctx NFC context
+ * @param unit_cnt Blocks in the dump
+ * @return "MINI", "1K" or "4K"
+ */
+/*============================================================================*/
+static const char *nfc_classic_type(PCNFC_RUN_CTX ctx, uint32_t unit_cnt)
+{
+	if (ctx->head.a.has_sak)
+	{
+		switch (ctx->head.a.sak)
+		{
+		case 0x09:
+			return "MINI";
+		case 0x08: case 0x28: case 0x88:
+			return "1K";
+		case 0x18: case 0x38: case 0x98:
+			return "4K";
+		default:
+			break;
+		}
+	}
+	if (ctx->head.a.has_atqa)
+	{
+		if ((ctx->head.a.atqa[0] & 0x0F) == 0x02)
+			return "4K";
+		if ((ctx->head.a.atqa[0] & 0x0F) == 0x04)
+			return "1K";
+	}
+
+	return (unit_cnt > 64) ? "4K" : (unit_cnt > 20) ? "1K" : "MINI";
+}
+
 /*============================================================================*/
 /**
  * @brief Load NFC profile from file
  * 
  * Validates file extension and loads NFC card data from file.
  * Uses nfc_storage_load_file() internally to parse the file.
+ * A .nfb container stands for its .nfc: that file is loaded (restored from
+ * the container first if it is missing) and kept as the context path, so
+ * Save, Rename and Delete never act on the container itself.
  * 
  * @param f File info structure from storage_browse()
  * @param ext File extension to validate (e.g., "nfc")
@@ -48,16 +115,54 @@ extern uint8_t g_nfc_valid_bits[];
 bool nfc_profile_load(const S_M1_file_info *f, const char* ext)
 {
 	char file_path[128];
-	nfc_storage_result_t nfc_ret;
+	char bin_path[128];
+	FILINFO fno;
+	nfc_storage_result_t nfc_ret = NFC_STORAGE_ERR_FORMAT;
+	bool text_file;
 	//BaseType_t ret;
 
-	if(IsValidFileSpec(f, ext))
+	text_file = IsValidFileSpec(f, ext);
+	if(text_file || IsValidFileSpec(f, NFC_BIN_FILE_EXTENSION_TMP))
 	{
-		fu_path_combine(file_path, sizeof(file_path), f->dir_name, f->file_name);
+		if (text_file)
+		{
+			fu_path_combine(file_path, sizeof(file_path), f->dir_name, f->file_name);
+		}
+		else
+		{
+			// Binary container selected directly
+			fu_path_combine(bin_path, sizeof(bin_path), f->dir_name, f->file_name);
+			if (!nfc_dump_bin_text_path(bin_path, file_path, sizeof(file_path)))
+				return false;
+			if (f_stat(file_path, &fno) != FR_OK && !nfc_dump_bin_to_text(bin_path, file_path))
+			{
+				platformLog("nfc_profile_load: '%s' has no .nfc\r\n", bin_path);
+				return false;
+			}
+		}
+
+		// Prefer the binary sidecar when it was generated from this exact .nfc
+		bool have_stamp = (f_stat(file_path, &fno) == FR_OK) &&
+						  nfc_dump_bin_sidecar_path(file_path, bin_path, sizeof(bin_path));
 
-		// Load file using nfc_storage_load_file
-		nfc_ret = nfc_storage_load_file(file_path, g_nfc_dump_buf, sizeof(g_nfc_dump_buf),
+		if (have_stamp && nfc_dump_bin_is_current(bin_path, &fno))
+		{
+			nfc_ret = nfc_dump_bin_load(bin_path, g_nfc_dump_buf, sizeof(g_nfc_dump_buf),
 										g_nfc_valid_bits, sizeof(g_nfc_valid_bits));
+		}
+
+		if (nfc_ret != NFC_STORAGE_OK)
+		{
+			// Load file using nfc_storage_load_file
+			nfc_ret = nfc_storage_load_file(file_path, g_nfc_dump_buf, sizeof(g_nfc_dump_buf),
+											g_nfc_valid_bits, sizeof(g_nfc_valid_bits));
+
+			// Refresh the sidecar so the next load skips text parsing (best effort)
+			if (nfc_ret == NFC_STORAGE_OK && have_stamp)
+			{
+				nfc_dump_bin_save(bin_path, nfc_ctx_get(), &fno);
+			}
+		}
 
 		if (nfc_ret == NFC_STORAGE_OK)
 		{
@@ -148,22 +253,92 @@ bool nfc_profile_save(const char *fp, PCNFC_RUN_CTX ctx)
 
 		snprintf(line, sizeof(line), "SAK: %02X\r\n", ctx->head.a.sak);
 		m1_fb_write_to_file(&nfc_file, line, strlen(line));
+
+		if (ctx->head.a.ats_len > 0 && ctx->head.a.ats_len <= sizeof(ctx->head.a.ats))
+		{
+			nfc_write_hex_field(&nfc_file, "ATS", ctx->head.a.ats, ctx->head.a.ats_len);
+		}
 	}
 
-	// Save Ultralight (NTAG) page dumps if available
-	if ((ctx->head.tech == NFC_TX_A) && (ctx->head.family == M1NFC_FAM_ULTRALIGHT) &&
-		ctx->dump.has_dump && ctx->dump.data != NULL &&
-		ctx->dump.unit_size == 4 && ctx->dump.unit_count > 0)
+	// ISO15693 system information
+	if (ctx->head.tech == NFC_TX_V)
 	{
-		uint32_t page_cnt  = ctx->dump.unit_count;
-		uint32_t page_base = ctx->dump.origin;
+		if (ctx->head.v.has_dsfid)
+		{
+			snprintf(line, sizeof(line), "DSFID: %02X\r\n", ctx->head.v.dsfid);
+			m1_fb_write_to_file(&nfc_file, line, strlen(line));
+		}
+		if (ctx->head.v.has_afi)
+		{
+			snprintf(line, sizeof(line), "AFI: %02X\r\n", ctx->head.v.afi);
+			m1_fb_write_to_file(&nfc_file, line, strlen(line));
+		}
+		if (ctx->head.v.has_ic_ref)
+		{
+			snprintf(line, sizeof(line), "IC Reference: %02X\r\n", ctx->head.v.ic_ref);
+			m1_fb_write_to_file(&nfc_file, line, strlen(line));
+		}
+	}
+
+	// Ultralight/NTAG GET_VERSION response
+	if ((ctx->head.tech == NFC_TX_A) && (ctx->head.family == M1NFC_FAM_ULTRALIGHT))
+	{
+		uint8_t ver[8];
+		if (nfc_ctx_get_t2t_version(ver) == sizeof(ver))
+		{
+			nfc_write_hex_field(&nfc_file, "Mifare version", ver, sizeof(ver));
+		}
+
+		// READ_SIG / READ_CNT results (Ultralight EV1, NTAG21x)
+		if (ctx->t2t.has_signature)
+		{
+			nfc_write_hex_field(&nfc_file, "Signature", ctx->t2t.signature, NFC_T2T_SIG_LEN);
+		}
+		for (uint8_t i = 0; i < NFC_T2T_CNT_MAX; i++)
+		{
+			if (ctx->t2t.counter_mask & (1u << i))
+			{
+				snprintf(line, sizeof(line), "Counter %u: %lu\r\n", i, (unsigned long)ctx->t2t.counter[i]);
+				m1_fb_write_to_file(&nfc_file, line, strlen(line));
+			}
+		}
+	}
+
+	// Save Ultralight (NTAG) page / Classic block / ISO15693 block dumps if available
+	if (ctx->dump.has_dump && ctx->dump.data != NULL && ctx->dump.unit_count > 0 &&
+		(((ctx->head.tech == NFC_TX_A) &&
+		  (((ctx->head.family == M1NFC_FAM_ULTRALIGHT) && (ctx->dump.unit_size == 4)) ||
+		   ((ctx->head.family == M1NFC_FAM_CLASSIC) && (ctx->dump.unit_size == 16)))) ||
+		 ((ctx->head.tech == NFC_TX_V) && (ctx->dump.unit_size >= 1) &&
+		  (ctx->dump.unit_size <= 32))))
+	{
+		bool is_classic = (ctx->head.family == M1NFC_FAM_CLASSIC);
+		bool is_t5t     = (ctx->head.tech == NFC_TX_V);
+		uint32_t unit_cnt  = ctx->dump.max_seen_unit + 1;
+		uint32_t unit_base = ctx->dump.origin;
 		const uint8_t *dump = ctx->dump.data;
 		const uint8_t *valid = ctx->dump.valid_bits;
 
-		snprintf(line, sizeof(line), "Pages: %lu\r\n", (unsigned long)page_cnt);
+		if (unit_cnt > ctx->dump.unit_count)
+			unit_cnt = ctx->dump.unit_count;
+
+		if (is_t5t)
+		{
+			snprintf(line, sizeof(line), "Block Size: %u\r\n", (unsigned)ctx->dump.unit_size);
+			m1_fb_write_to_file(&nfc_file, line, strlen(line));
+			snprintf(line, sizeof(line), "Block Count: %lu\r\n", (unsigned long)unit_cnt);
+		}
+		else if (is_classic)
+		{
+			snprintf(line, sizeof(line), "Mifare Classic type: %s\r\n", nfc_classic_type(ctx, unit_cnt));
+		}
+		else
+		{
+			snprintf(line, sizeof(line), "Pages: %lu\r\n", (unsigned long)unit_cnt);
+		}
 		m1_fb_write_to_file(&nfc_file, line, strlen(line));
 
-		for (uint32_t i = 0; i < page_cnt; i++)
+		for (uint32_t i = 0; i < unit_cnt; i++)
 		{
 			uint8_t is_valid = 1;
 			if (valid != NULL)
@@ -181,18 +356,42 @@ bool nfc_profile_save(const char *fp, PCNFC_RUN_CTX ctx)
 				continue;
 			}
 
-			const uint8_t *page = &dump[i * ctx->dump.unit_size];
-			uint32_t page_no = page_base + i;
+			const uint8_t *unit = &dump[i * ctx->dump.unit_size];
+			uint32_t unit_no = unit_base + i;
+			int pos;
+
+			if (is_classic || is_t5t)
+				pos = snprintf(line, sizeof(line), "Block %lu:", (unsigned long)unit_no);
+			else
+				pos = snprintf(line, sizeof(line), "Page %03lu:", (unsigned long)unit_no);
 
-			snprintf(line, sizeof(line),
-					"Page %03lu: %02X %02X %02X %02X\r\n",
-					(unsigned long)page_no,
-					page[0], page[1], page[2], page[3]);
+			for (uint16_t b = 0; b < ctx->dump.unit_size; b++)
+			{
+				pos += snprintf(line + pos, sizeof(line) - pos, " %02X", unit[b]);
+			}
+			snprintf(line + pos, sizeof(line) - pos, "\r\n");
 			m1_fb_write_to_file(&nfc_file, line, strlen(line));
 		}
 	}
 
 	m1_fb_close_file(&nfc_file);
+
+	// Keep the binary sidecar in step with the text file (only dirty units are rewritten)
+	{
+		char bin_path[128];
+		FILINFO fno;
+		if (f_stat(fp, &fno) == FR_OK &&
+			nfc_dump_bin_sidecar_path(fp, bin_path, sizeof(bin_path)))
+		{
+			if (!nfc_dump_bin_sync(bin_path, ctx, &fno))
+			{
+				platformLog("nfc_profile_save: sidecar update failed '%s'\r\n", bin_path);
+			}
+		}
+	}
+
+	m1_sig_idx_add(SIG_IDX_NFC, fp, devtype, 0, ctx->head.uid, ctx->head.uid_len);
+
 	return true;
 }
 
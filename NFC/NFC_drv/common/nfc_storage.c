@@ -5,6 +5,7 @@
 #include "m1_nfc.h" /* M1NFC_FAM_*, M1NFC_TECH_* */
 #include "m1_sdcard.h"
 #include "nfc_ctx.h"
+#include "nfc_dump_bin.h" /* nfc_dump_bin_clear_dirty */
 #include "nfc_fileio.h"
 #include "privateprofilestring.h" /* INI style parsing for header */
 #include <ctype.h>
@@ -346,6 +347,78 @@ nfc_storage_parse_header_ini(nfc_run_ctx_t *c, nfc_family_info_t *faminfo,
     }
   }
 
+  /* 7) Parse Mifare version (optional, Ultralight/NTAG GET_VERSION) */
+  nfc_ctx_set_t2t_version(NULL, 0);
+  if (faminfo->family == M1NFC_FAM_ULTRALIGHT) {
+    uint8_t tmp_ver[8];
+    data.buf = tmp_ver;
+    data.max_len = sizeof(tmp_ver);
+    data.type = VALUE_TYPE_HEX_ARRAY;
+    if (GetPrivateProfileHex(&data, "Mifare version", file_path) &&
+        data.v.hex.out_len == sizeof(tmp_ver)) {
+      nfc_ctx_set_t2t_version(tmp_ver, sizeof(tmp_ver));
+    }
+  }
+
+  /* 8) Parse Signature / Counter N (optional, Ultralight EV1 / NTAG21x) */
+  nfc_ctx_clear_t2t_extras();
+  if (faminfo->family == M1NFC_FAM_ULTRALIGHT) {
+    uint8_t tmp_sig[NFC_T2T_SIG_LEN];
+    data.buf = tmp_sig;
+    data.max_len = sizeof(tmp_sig);
+    data.type = VALUE_TYPE_HEX_ARRAY;
+    if (GetPrivateProfileHex(&data, "Signature", file_path) &&
+        data.v.hex.out_len == sizeof(tmp_sig)) {
+      nfc_ctx_set_t2t_signature(tmp_sig, sizeof(tmp_sig));
+    }
+
+    for (uint8_t i = 0; i < NFC_T2T_CNT_MAX; i++) {
+      char key[12];
+      snprintf(key, sizeof(key), "Counter %u", i);
+      data.buf = NULL;
+      data.max_len = 0;
+      if (GetPrivateProfileUint(&data, key, file_path)) {
+        nfc_ctx_set_t2t_counter(i, data.v.u32);
+      }
+    }
+  }
+
+  /* 9) Parse ISO15693 system information (optional, Tech V only) */
+  if (faminfo->tech == M1NFC_TECH_V) {
+    uint8_t tmp_v[1];
+    data.buf = tmp_v;
+    data.max_len = 1;
+    data.type = VALUE_TYPE_HEX_ARRAY;
+    if (GetPrivateProfileHex(&data, "DSFID", file_path) &&
+        data.v.hex.out_len == 1) {
+      c->head.v.dsfid = tmp_v[0];
+      c->head.v.has_dsfid = true;
+    }
+    if (GetPrivateProfileHex(&data, "AFI", file_path) &&
+        data.v.hex.out_len == 1) {
+      c->head.v.afi = tmp_v[0];
+      c->head.v.has_afi = true;
+    }
+    if (GetPrivateProfileHex(&data, "IC Reference", file_path) &&
+        data.v.hex.out_len == 1) {
+      c->head.v.ic_ref = tmp_v[0];
+      c->head.v.has_ic_ref = true;
+    }
+
+    /* Block size decides how "Block N:" lines are laid out in the dump */
+    data.buf = NULL;
+    data.max_len = 0;
+    if (GetPrivateProfileUint(&data, "Block Size", file_path) &&
+        data.v.u32 >= 1 && data.v.u32 <= 32) {
+      faminfo->unit_size = (uint16_t)data.v.u32;
+    }
+    c->head.v.block_size = (uint8_t)faminfo->unit_size;
+    if (GetPrivateProfileUint(&data, "Block Count", file_path) &&
+        data.v.u32 <= 0xFFFFU) {
+      c->head.v.block_count = (uint16_t)data.v.u32;
+    }
+  }
+
   if (!saw_filetype || !saw_devtype) {
     return NFC_STORAGE_ERR_FORMAT;
   }
@@ -403,7 +476,7 @@ static void nfc_storage_store_unit(uint8_t *dump_buf, uint16_t unit_size,
 
 /*============================================================================*/
 /**
- * @brief Parse body section: "Page N:" for Type2, "Block N:" for Classic
+ * @brief Parse body section: "Page N:" for Type2, "Block N:" for Classic/ISO15693
  * @param c Pointer to NFC context
  * @param faminfo Pointer to family info structure
  * @param dump_buf Dump buffer to store parsed data
@@ -449,7 +522,7 @@ nfc_storage_parse_body(nfc_run_ctx_t *c, const nfc_family_info_t *faminfo,
     if (line[0] == '#')
       continue;
 
-    /* Classic: "Block N:" */
+    /* Classic / ISO15693: "Block N:" */
     if (strncmp(line, "Block ", 6) == 0) {
       unsigned long idx = 0;
       char *colon = strchr(line, ':');
@@ -497,7 +570,7 @@ nfc_storage_parse_body(nfc_run_ctx_t *c, const nfc_family_info_t *faminfo,
       continue;
     }
 
-    /* Felica/ISO15693, etc. can add separate processing here */
+    /* ISO15693 uses "Block N:" above; Felica, etc. can add separate processing here */
   }
 
   /* Parsing complete → set nfc_ctx.dump metadata */
@@ -543,6 +616,7 @@ nfc_storage_result_t nfc_storage_load_file(const char *path, uint8_t *dump_buf,
   /* Initialize header/dump */
   memset(&c->head, 0, sizeof(c->head));
   nfc_ctx_clear_dump();
+  nfc_dump_bin_clear_dirty();
   c->parser.parse_error = 0;
 
   /* ---------- Phase 1: Parse header using INI style ---------- */
@@ -338,6 +338,7 @@ static ReturnCode CeBuildT2TReadResp(const uint8_t *rx, uint16_t rxBits)
  * - 0x30 (READ): Read 4 pages
  * - 0x3A (FAST_READ): Read multiple pages
  * - 0x60 (GET_VERSION): Send version info
+ * - 0x3C (READ_SIG) / 0x39 (READ_CNT): Replay captured signature/counters
  * - 0xA2 (WRITE): Write one page
  * - Others: Simple ACK responses
  * 
@@ -493,7 +494,8 @@ static bool CeHandleT2TCmdRx(const uint8_t *rx, uint16_t rxBits)
         
         case 0xC2:
         case 0x1B:
-        case 0x39:
+        case T2T_CMD_READ_CNT:
+        case T2T_CMD_READ_SIG:
         case 0x53:
         case 0x57:
         case 0xE0: {
@@ -505,10 +507,13 @@ static bool CeHandleT2TCmdRx(const uint8_t *rx, uint16_t rxBits)
                 /* READ_CNT: 3-byte counter */
                 g_ceTxBuf[0] = g_ceTxBuf[1] = g_ceTxBuf[2] = 0x00;
                 respLen = 3;
-            } else if (cmd == 0x39) {
-                /* READ_SIG: 32-byte signature */
-                memset(g_ceTxBuf, 0x00, 32);
-                respLen = 32;
+            } else if (cmd == T2T_CMD_READ_CNT || cmd == T2T_CMD_READ_SIG) {
+                /* Counter / signature captured by the reader, zeros if none */
+                respLen = (uint8_t)ceT2T_FromDump(rx, rxBytes, g_ceTxBuf, sizeof(g_ceTxBuf));
+                if (respLen == 0) {
+                    respLen = (cmd == T2T_CMD_READ_CNT) ? 3U : NFC_T2T_SIG_LEN;
+                    memset(g_ceTxBuf, 0x00, respLen);
+                }
             } else if (cmd == 0x53) {
                 /* PWD_AUTH: PACK response */
                 g_ceTxBuf[0] = 0x80;
@@ -1216,6 +1221,31 @@ static uint16_t ceT2T_FromDump(const uint8_t *rx, uint16_t rxLenB, uint8_t *tx,
             return (uint16_t)sizeof(ver);
         }
 
+        /* 0x3C: READ_SIG → originality signature captured by the reader */
+        case T2T_CMD_READ_SIG:
+        {
+            const nfc_t2t_info_t *t2t = nfc_ctx_get_t2t_info();
+            if (!t2t || !t2t->has_signature || txSize < NFC_T2T_SIG_LEN) {
+                return 0;
+            }
+            memcpy(tx, t2t->signature, NFC_T2T_SIG_LEN);
+            return NFC_T2T_SIG_LEN;
+        }
+
+        /* 0x39: READ_CNT → 24-bit counter, LSB first (NTAG21x address 2 maps to counter 0) */
+        case T2T_CMD_READ_CNT:
+        {
+            const nfc_t2t_info_t *t2t = nfc_ctx_get_t2t_info();
+            uint8_t idx = (addr == 2U && t2t && !(t2t->counter_mask & 0x06U)) ? 0U : addr;
+            if (!t2t || idx >= NFC_T2T_CNT_MAX || !(t2t->counter_mask & (1u << idx))) {
+                return 0;
+            }
+            tx[0] = (uint8_t)(t2t->counter[idx]);
+            tx[1] = (uint8_t)(t2t->counter[idx] >> 8);
+            tx[2] = (uint8_t)(t2t->counter[idx] >> 16);
+            return 3;
+        }
+
         /* 0xA2: WRITE one page (4 bytes) → Update dump so it's reflected when read again later */
         case 0xA2:
         {
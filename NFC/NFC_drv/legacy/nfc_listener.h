@@ -13,6 +13,8 @@
 #define T2T_CMD_WRITE       0xA2  /* 4 bytes */
 #define T2T_CMD_SECTOR_SEL  0xC2
 #define T2T_CMD_GET_VERSION 0x60
+#define T2T_CMD_READ_CNT    0x39  /* NTAG21x / Ultralight EV1 */
+#define T2T_CMD_READ_SIG    0x3C  /* NTAG21x / Ultralight EV1 */
 #define T2T_CMD_COMPAT_WRITE 0xA0 /* optional / legacy */
 
 
@@ -12,6 +12,13 @@
  * 
  * [State Machine]
  * NOTINIT → START_DISCOVERY → DISCOVERY
+ *
+ * [Multi-tag]
+ * - NFC-A/B/F/V (and ST25TB) are detected in one discovery round (RFAL's
+ *   default, no techs2Bail), then each technology runs its anticollision for
+ *   up to NFC_POLL_MAX_TAGS cards in total (devLimit).
+ * - The first resolved card is activated and read in full (nfc_ctx); all
+ *   resolved cards are listed via nfc_poller_get_tags().
  * 
  * [Key Flow]
  * 1. ReadIni(): Initialize RFAL in poller mode
@@ -30,9 +37,10 @@
  *      * Type 4 Tag (T4T): ISO-DEP APDU exchange
  * 
  * 4. T2T Reading (m1_t2t_read_ntag()):
- *    - GET_VERSION (0x60): Get NTAG version info
- *    - READ (0x30): Read pages sequentially (0~135)
- *    - FAST_READ (0x3A): Read multiple pages at once
+ *    - GET_VERSION (0x60): Identify exact variant (UL EV1, NTAG21x)
+ *    - FAST_READ (0x3A): Read up to 64 pages per command
+ *    - READ (0x30): 4-page fallback for tags without FAST_READ
+ *    - READ_SIG (0x3C) / READ_CNT (0x39): Signature and counters
  *    - Save data to nfc_ctx and SD card (.nfc file)
  * 
  * [Card Type Detection]
@@ -55,6 +63,7 @@
 #include "rfal_rf.h"
 #include "uiView.h"
 #include "nfc_driver.h"
+#include "nfc_listener.h"   /* T2T_CMD_* */
 #include "nfc_poller.h"
 #include "common/nfc_ctx.h"
 #include "common/nfc_storage.h"
@@ -104,6 +113,43 @@ static uint16_t mfc_sector_to_first_block(uint16_t sector);
 extern uint8_t g_nfc_dump_buf[NFC_DUMP_BUF_SIZE];
 extern uint8_t g_nfc_valid_bits[NFC_VALID_BITS_SIZE];
 
+/*
+ ******************************************************************************
+ * NTAG / Ultralight EV1 helpers
+ ******************************************************************************
+ */
+
+#define NFC_T2T_FAST_READ_PAGES     64U     /* 256 B per FAST_READ, well inside the ST25R3916 FIFO */
+#define T2T_FAST_READ_FWT_MS        5U
+
+/* ISO15693 (NFC-V / Type 5) */
+#define NFC_T5T_RMB_MAX_BYTES       256U    /* Payload per READ MULTIPLE BLOCKS response */
+#define NFC_T5T_DEFAULT_BLOCKS      64U     /* Probe span when GET SYSTEM INFORMATION is not supported */
+#define NFC_T5T_MAX_BLOCKS          256U    /* 8-bit block address (extended commands not used) */
+
+/* Variant table keyed by GET_VERSION (vendor 0x04 = NXP) */
+typedef struct {
+    uint8_t     prod;       /* version[2]: 0x03 Ultralight, 0x04 NTAG */
+    uint8_t     sub;        /* version[3]: 0 = any */
+    uint8_t     size;       /* version[6] */
+    const char *name;
+    uint16_t    pages;      /* Total pages incl. config */
+    uint8_t     cnt_first;  /* First READ_CNT address */
+    uint8_t     cnt_num;    /* Number of READ_CNT counters (0 = none) */
+    bool        fast_read;
+    bool        has_sig;
+} t2t_variant_t;
+
+static const t2t_variant_t s_t2t_variants[] = {
+    { 0x03, 0x00, 0x0B, "Ultralight EV1 MF0UL11", 20U,  0U, 3U, true, true },
+    { 0x03, 0x00, 0x0E, "Ultralight EV1 MF0UL21", 41U,  0U, 3U, true, true },
+    { 0x04, 0x01, 0x0B, "NTAG210",                20U,  0U, 0U, true, true },
+    { 0x04, 0x01, 0x0E, "NTAG212",                41U,  0U, 0U, true, true },
+    { 0x04, 0x02, 0x0F, "NTAG213 [144B user]",    45U,  2U, 1U, true, true },
+    { 0x04, 0x02, 0x11, "NTAG215 [504B user]",    135U, 2U, 1U, true, true },
+    { 0x04, 0x02, 0x13, "NTAG216 [888B user]",    231U, 2U, 1U, true, true },
+};
+
 /*
  ******************************************************************************
  * LOCAL VARIABLES
@@ -114,6 +160,12 @@ static rfalNfcDiscoverParam discParam;
 static uint8_t              state = NOTINIT;
 static bool                 multiSel;
 
+static nfc_poll_tag_t       s_tags[NFC_POLL_MAX_TAGS];  /* Cards resolved in the last round */
+static uint8_t              s_tag_count;
+
+/* rfalNfcDiscover() rejects a devLimit above RFAL_NFC_MAX_DEVICES (5, private to rfal_nfc.c) */
+_Static_assert(NFC_POLL_MAX_TAGS >= 1U && NFC_POLL_MAX_TAGS <= 5U, "NFC_POLL_MAX_TAGS out of RFAL's devLimit range");
+
 
 /* NFC-A CE config */
 /* 4-byte UIDs with first byte 0x08 would need random number for the subsequent 3 bytes.
@@ -122,9 +174,12 @@ static bool                 multiSel;
 
 /*------------------------------------------------------------------------------------------*/
 static void PollerNotif( rfalNfcState st );
+static void nfc_poller_snapshot_tags(void);
 static void m1_t2t_read_ntag(const rfalNfcDevice *dev);
+static void m1_t5t_read(const rfalNfcDevice *dev);
 static ReturnCode GetVersion_Ntag(uint8_t *rxBuf, uint16_t rxBufLen, uint16_t *rcvLen);
 static uint16_t LogParsedNtagVersion(const uint8_t *version, uint16_t len);
+static const t2t_variant_t *t2t_find_variant(const uint8_t *version);
 
 /*------------------------------------------------------------------------------------------*/
 #define SET_FAMILY(fmt, ...)  do { snprintf(NFC_Family, sizeof(NFC_Family), fmt, ##__VA_ARGS__); } while(0)
@@ -278,6 +333,9 @@ void ReadCycle(void)
 
             rfalNfcGetActiveDevice(&nfcDevice); /* Get active device */
 
+            /* Record every card resolved in this round before the active one is read */
+            nfc_poller_snapshot_tags();
+
             uint8_t ctx_err = FillNfcContextFromDevice(nfcDevice);
             if (ctx_err != 0) {
                 platformLog("FillNfcContextFromDevice err=%d (type=%d)\r\n",
@@ -387,7 +445,22 @@ void ReadCycle(void)
                     platformLog("ISO15693/NFC-V TAG found. UID=%s\r\n",
                                 hex2Str(devUID, RFAL_NFCV_UID_LEN));
                     strcpy(NFC_Type, "ISO15693/NFC-V");
+                    isNFCCardFound = true;
                     nfc_tx_type = NFC_TX_V;
+
+                    /* devUID[1] = IC manufacturer, devUID[2] = manufacturer's IC type */
+                    if (devUID[1] == 0x04U && devUID[2] == 0x01U)
+                        SET_FAMILY("ICODE SLIX");
+                    else if (devUID[1] == 0x04U)
+                        SET_FAMILY("NXP ICODE");
+                    else if (devUID[1] == 0x02U)
+                        SET_FAMILY("ST25DV/LRi");
+                    else if (devUID[1] == 0x07U)
+                        SET_FAMILY("TI Tag-it HF-I");
+                    else
+                        SET_FAMILY("ISO15693");
+
+                    m1_t5t_read(nfcDevice);
                     notifyRead  = true;
                 }
                 break;
@@ -489,7 +562,7 @@ bool ReadIni(void)
     /* 2) Discovery parameters: Explicitly set for Poller-only mode */
     rfalNfcDefaultDiscParams(&discParam);
 
-    discParam.devLimit       = 1U;
+    discParam.devLimit       = NFC_POLL_MAX_TAGS;          /* Resolve several cards per round */
     discParam.totalDuration  = 1000U;                      /* Discovery window (adjust if needed) */
     discParam.notifyCb       = PollerNotif;                  /* Keep if in use */
 #if defined(RFAL_COMPLIANCE_MODE_NFC)
@@ -533,6 +606,7 @@ bool ReadIni(void)
     }
 
     /* 4) Enter state machine starting point */
+    s_tag_count = 0;
     state = START_DISCOVERY;
 
     //platformLog("ReadIni() OK, state=%d\r\n", state);
@@ -574,7 +648,7 @@ static void PollerNotif( rfalNfcState st )
         if( (!multiSel) )
         {
             multiSel = true;
-            /* Multiple devices were found, activate first of them */
+            /* Multiple devices were found, activate first of them (all are reported in ReadCycle) */
             rfalNfcGetDevicesFound( &dev, &devCnt );
             rfalNfcSelect( 0 );
 
@@ -593,6 +667,111 @@ static void PollerNotif( rfalNfcState st )
 }
 
 
+/*============================================================================*/
+/**
+ * @brief nfc_poller_snapshot_tags - Copy the RFAL device list into s_tags
+ * 
+ * Called once the selected card is active. The device list still holds every
+ * card resolved by anticollision in this discovery round (A, B, F, V order).
+ * 
+ * @retval None
+ */
+/*============================================================================*/
+static void nfc_poller_snapshot_tags(void)
+{
+    rfalNfcDevice *list = NULL;
+    uint8_t        cnt  = 0;
+
+    s_tag_count = 0;
+    if ((rfalNfcGetDevicesFound(&list, &cnt) != RFAL_ERR_NONE) || (list == NULL)) {
+        return;
+    }
+
+    for (uint8_t i = 0; (i < cnt) && (s_tag_count < NFC_POLL_MAX_TAGS); i++)
+    {
+        const rfalNfcDevice *d = &list[i];
+        nfc_poll_tag_t *t = &s_tags[s_tag_count];
+
+        memset(t, 0, sizeof(*t));
+        t->rfal_type = (uint8_t)d->type;
+
+        switch (d->type)
+        {
+            case RFAL_NFC_LISTEN_TYPE_NFCA:
+                t->tech    = M1NFC_TECH_A;
+                t->atqa[0] = d->dev.nfca.sensRes.anticollisionInfo;
+                t->atqa[1] = d->dev.nfca.sensRes.platformInfo;
+                t->sak     = d->dev.nfca.selRes.sak;
+                break;
+            case RFAL_NFC_LISTEN_TYPE_NFCB:
+            case RFAL_NFC_LISTEN_TYPE_ST25TB:
+                t->tech = M1NFC_TECH_B;
+                break;
+            case RFAL_NFC_LISTEN_TYPE_NFCF:
+                t->tech = M1NFC_TECH_F;
+                break;
+            case RFAL_NFC_LISTEN_TYPE_NFCV:
+                t->tech = M1NFC_TECH_V;
+                break;
+            default:
+                continue;   /* CE/P2P peers are not inventoried */
+        }
+
+        t->uid_len = (d->nfcidLen > sizeof(t->uid)) ? (uint8_t)sizeof(t->uid) : d->nfcidLen;
+        ST_MEMCPY(t->uid, d->nfcid, t->uid_len);
+        if (d->type == RFAL_NFC_LISTEN_TYPE_NFCV) {
+            REVERSE_BYTES(t->uid, t->uid_len);  /* Reverse for display */
+        }
+        s_tag_count++;
+    }
+
+    platformLog("[NFC] %u tag(s) in field\r\n", s_tag_count);
+    for (uint8_t i = 0; i < s_tag_count; i++) {
+        platformLog("  #%u %s UID=%s\r\n", i, nfc_poller_tech_name(&s_tags[i]),
+                    hex2Str(s_tags[i].uid, s_tags[i].uid_len));
+    }
+}
+
+/*============================================================================*/
+/**
+ * @brief nfc_poller_get_tags - Cards seen in the field by the last read
+ * 
+ * @param[out] list Pointer to internal table (valid until next read)
+ * @retval Number of entries in the table
+ */
+/*============================================================================*/
+uint8_t nfc_poller_get_tags(const nfc_poll_tag_t **list)
+{
+    if (list) {
+        *list = s_tags;
+    }
+    return s_tag_count;
+}
+
+/*============================================================================*/
+/**
+ * @brief nfc_poller_tech_name - Short technology label for a tag entry
+ * 
+ * @param[in] tag Tag entry
+ * @retval Technology label
+ */
+/*============================================================================*/
+const char *nfc_poller_tech_name(const nfc_poll_tag_t *tag)
+{
+    if (tag == NULL) return "?";
+    if (tag->rfal_type == RFAL_NFC_LISTEN_TYPE_ST25TB) return "ST25TB";
+
+    switch (tag->tech)
+    {
+        case M1NFC_TECH_A: return "NFC-A";
+        case M1NFC_TECH_B: return "NFC-B";
+        case M1NFC_TECH_F: return "NFC-F";
+        case M1NFC_TECH_V: return "NFC-V";
+        default:           return "?";
+    }
+}
+
+
 /*============================================================================*/
 /**
  * @brief GetVersion_Ntag - Send GET_VERSION command to NTAG
@@ -623,16 +802,38 @@ static ReturnCode GetVersion_Ntag(uint8_t *rxBuf, uint16_t rxBufLen, uint16_t *r
 }
 
 
+/*============================================================================*/
+/**
+ * @brief t2t_find_variant - Look up Ultralight/NTAG variant from GET_VERSION
+ * 
+ * @param[in] version 8-byte GET_VERSION response
+ * @retval Pointer to variant entry, or NULL if unknown
+ */
+/*============================================================================*/
+static const t2t_variant_t *t2t_find_variant(const uint8_t *version)
+{
+    if (version == NULL || version[1] != 0x04U) {   /* NXP only */
+        return NULL;
+    }
+
+    for (uint8_t i = 0; i < (uint8_t)(sizeof(s_t2t_variants) / sizeof(s_t2t_variants[0])); i++) {
+        const t2t_variant_t *v = &s_t2t_variants[i];
+        if (v->prod == version[2] && v->size == version[6] &&
+            (v->sub == 0U || v->sub == version[3])) {
+            return v;
+        }
+    }
+    return NULL;
+}
+
 /*============================================================================*/
 /**
  * @brief LogParsedNtagVersion - Parse and log NTAG version information
  * 
  * Parses NTAG GET_VERSION response (8 bytes) and logs detailed version information
  * including vendor, product, sub-type, version number, size, and protocol.
- * Determines total page count based on size code:
- * - 0x0F: NTAG213 (45 pages, 144B user)
- * - 0x11: NTAG215 (135 pages, 504B user)
- * - 0x13: NTAG216 (231 pages, 888B user)
+ * The exact variant (and its total page count) comes from s_t2t_variants:
+ * Ultralight EV1 MF0UL11/21, NTAG210/212/213/215/216.
  * 
  * @param[in] version Pointer to 8-byte version data from GET_VERSION response
  * @param[in] len Length of version data (should be 8)
@@ -659,21 +860,14 @@ static uint16_t LogParsedNtagVersion(const uint8_t *version, uint16_t len)
     const uint8_t proto   = version[7];
 
     const char *vendorStr __attribute__((unused)) = (vendor == 0x04) ? "NXP" : "Unknown";
-    const char *prodStr   __attribute__((unused)) = (prod == 0x04) ? "NTAG" : "Unknown";
-    const char *subStr    __attribute__((unused)) = (sub == 0x02) ? "Standard" : "Unknown";
+    const char *prodStr   __attribute__((unused)) = (prod == 0x04) ? "NTAG" : (prod == 0x03) ? "Ultralight" : "Unknown";
+    const char *subStr    __attribute__((unused)) = (sub == 0x02) ? "Standard" : (sub == 0x01) ? "17pF" : "Unknown";
 
     const char *sizeStr __attribute__((unused)) = "Unknown";
-    if (size == 0x0F) {
-        sizeStr    = "NTAG213 [144B user]";
-        totalPages = 45U;
-    }
-    else if (size == 0x11) {
-        sizeStr    = "NTAG215 [504B user]";
-        totalPages = 135U;
-    }
-    else if (size == 0x13) {
-        sizeStr    = "NTAG216 [888B user]";
-        totalPages = 231U;
+    const t2t_variant_t *v = t2t_find_variant(version);
+    if (v != NULL) {
+        sizeStr    = v->name;
+        totalPages = v->pages;
     }
 
     const char *protoStr __attribute__((unused)) = (proto == 0x03) ? "ISO14443-3" : "Unknown";
@@ -690,13 +884,314 @@ static uint16_t LogParsedNtagVersion(const uint8_t *version, uint16_t len)
     return totalPages;
 }
 
+/*============================================================================*/
+/**
+ * @brief t2t_fast_read - FAST_READ (0x3A) a page range straight into the dump
+ * 
+ * @param[in] start First page
+ * @param[in] end Last page (inclusive)
+ * @param[out] out Destination, (end - start + 1) * 4 bytes
+ * @retval RFAL_ERR_NONE Success (all bytes received)
+ * @retval Other RFAL error codes
+ */
+/*============================================================================*/
+static ReturnCode t2t_fast_read(uint8_t start, uint8_t end, uint8_t *out)
+{
+    uint8_t  cmd[3] = { T2T_CMD_FAST_READ, start, end };
+    uint16_t want   = (uint16_t)((end - start + 1U) * 4U);
+    uint16_t rcvLen = 0;
+    ReturnCode err;
+
+    err = rfalTransceiveBlockingTxRx(cmd, sizeof(cmd), out, want, &rcvLen,
+                                     RFAL_TXRX_FLAGS_DEFAULT, rfalConvMsTo1fc(T2T_FAST_READ_FWT_MS));
+    if (err == RFAL_ERR_NONE && rcvLen != want) {
+        err = RFAL_ERR_PROTO;
+    }
+    return err;
+}
+
+/*============================================================================*/
+/**
+ * @brief t2t_read_4pages - READ (0x30) four pages with retries
+ * 
+ * Fallback for tags without FAST_READ (Ultralight, Ultralight C, unknown).
+ * 
+ * @param[in] blk First page
+ * @param[out] buf 16-byte response buffer
+ * @retval RFAL_ERR_NONE Success
+ * @retval Other RFAL error codes (last attempt)
+ */
+/*============================================================================*/
+static ReturnCode t2t_read_4pages(uint8_t blk, uint8_t buf[16])
+{
+    uint16_t   rcvLen = 0;
+    ReturnCode err    = RFAL_ERR_NONE;
+
+    /* Retry each READ command (max 3 times, to handle timing issues) */
+    for (uint8_t retry = 0; retry < 3; retry++) {
+        /* Wait before retry (allow time for CE to respond) */
+        if (retry > 0) {
+            osDelay(10);  // Increase retry wait time (10ms)
+        }
+
+        /* Initialize buffer (prevent previous data residue) */
+        memset(buf, 0x00, 16);
+        rcvLen = 0;
+
+        err = rfalT2TPollerRead(blk, buf, 16, &rcvLen);
+        if (err == RFAL_ERR_NONE && rcvLen >= 16) {  // T2T READ returns 16 bytes (4 blocks)
+            return RFAL_ERR_NONE;
+        }
+        if (err == RFAL_ERR_NONE) {
+            err = RFAL_ERR_PROTO;
+        }
+        /* Log only critical blocks on failure */
+        if ((blk == 0 || blk == 4) && retry == 0) {
+            platformLog("READ blk%u fail: err=%d rcv=%u\r\n", blk, err, rcvLen);
+        }
+        /* If field loss, don't retry anymore */
+        if (err == RFAL_ERR_LINK_LOSS) {
+            break;
+        }
+    }
+    return err;
+}
+
+/*============================================================================*/
+/**
+ * @brief t2t_read_sig_and_counters - READ_SIG (0x3C) and READ_CNT (0x39)
+ * 
+ * Runs after the page dump so a NAK (which drops NTAG21x into IDLE when the
+ * NFC counter is disabled) cannot cost any page data.
+ * 
+ * @param[in] v Detected variant
+ * @retval None
+ */
+/*============================================================================*/
+static void t2t_read_sig_and_counters(const t2t_variant_t *v)
+{
+    uint8_t    cmd[2];
+    uint8_t    rx[NFC_T2T_SIG_LEN];
+    uint16_t   rcvLen = 0;
+    ReturnCode err;
+
+    if (v->has_sig) {
+        cmd[0] = T2T_CMD_READ_SIG;
+        cmd[1] = 0x00;
+        err = rfalTransceiveBlockingTxRx(cmd, sizeof(cmd), rx, sizeof(rx), &rcvLen,
+                                         RFAL_TXRX_FLAGS_DEFAULT, rfalConvMsTo1fc(5U));
+        if (err == RFAL_ERR_NONE && rcvLen == NFC_T2T_SIG_LEN) {
+            nfc_ctx_set_t2t_signature(rx, NFC_T2T_SIG_LEN);
+            platformLog("READ_SIG: %s\r\n", hex2Str(rx, 8));
+        } else {
+            platformLog("READ_SIG fail: err=%d rcv=%u\r\n", err, rcvLen);
+        }
+    }
+
+    for (uint8_t i = 0; i < v->cnt_num; i++) {
+        uint8_t idx = (uint8_t)(v->cnt_first + i);
+
+        cmd[0] = T2T_CMD_READ_CNT;
+        cmd[1] = idx;
+        rcvLen = 0;
+        err = rfalTransceiveBlockingTxRx(cmd, sizeof(cmd), rx, 3U, &rcvLen,
+                                         RFAL_TXRX_FLAGS_DEFAULT, rfalConvMsTo1fc(5U));
+        if (err != RFAL_ERR_NONE || rcvLen != 3U) {
+            platformLog("READ_CNT %u fail: err=%d rcv=%u\r\n", idx, err, rcvLen);
+            break;  /* NAK → tag is IDLE now, nothing more to ask */
+        }
+
+        uint32_t cnt = (uint32_t)rx[0] | ((uint32_t)rx[1] << 8) | ((uint32_t)rx[2] << 16);
+        /* NTAG21x has one counter at address 2; store it as counter 0 like UL EV1 counter 0 */
+        nfc_ctx_set_t2t_counter((v->cnt_num == 1U) ? 0U : idx, cnt);
+        platformLog("READ_CNT %u: %lu\r\n", idx, (unsigned long)cnt);
+    }
+}
+
+/*============================================================================*/
+/**
+ * @brief t5t_get_system_info - GET SYSTEM INFORMATION (0x2B), addressed
+ * 
+ * Fills nfc_ctx.head.v with DSFID/AFI/memory size/IC reference when the tag
+ * reports them. Tags without the command keep block_size/block_count at 0.
+ * 
+ * @param[in] uid Tag UID as kept by RFAL (LSB first)
+ * @retval None
+ */
+/*============================================================================*/
+static void t5t_get_system_info(const uint8_t *uid)
+{
+    nfc_run_ctx_t *c = nfc_ctx_get();
+    uint8_t    rx[32];
+    uint16_t   rcvLen = 0;
+    ReturnCode err;
+
+    err = rfalNfcvPollerGetSystemInformation(RFAL_NFCV_REQ_FLAG_DEFAULT, uid, rx, sizeof(rx), &rcvLen);
+    /* flags(1) + info flags(1) + UID(8) at least */
+    if (err != RFAL_ERR_NONE || rcvLen < (2U + RFAL_NFCV_UID_LEN)) {
+        platformLog("T5T SYSINFO fail: err=%d rcv=%u\r\n", err, rcvLen);
+        return;
+    }
+
+    uint8_t  info = rx[1];
+    uint16_t pos  = 2U + RFAL_NFCV_UID_LEN;
+
+    if ((info & RFAL_NFCV_SYSINFO_DFSID) && pos < rcvLen) {
+        c->head.v.dsfid     = rx[pos++];
+        c->head.v.has_dsfid = true;
+    }
+    if ((info & RFAL_NFCV_SYSINFO_AFI) && pos < rcvLen) {
+        c->head.v.afi     = rx[pos++];
+        c->head.v.has_afi = true;
+    }
+    if ((info & RFAL_NFCV_SYSINFO_MEMSIZE) && (pos + 1U) < rcvLen) {
+        c->head.v.block_count = (uint16_t)(rx[pos] + 1U);
+        c->head.v.block_size  = (uint8_t)((rx[pos + 1U] & 0x1FU) + 1U);
+        pos += 2U;
+    }
+    if ((info & RFAL_NFCV_SYSINFO_ICREF) && pos < rcvLen) {
+        c->head.v.ic_ref     = rx[pos++];
+        c->head.v.has_ic_ref = true;
+    }
+
+    platformLog("T5T SYSINFO: info=%02X DSFID=%02X AFI=%02X blocks=%u x %u B IC=%02X\r\n",
+                info, c->head.v.dsfid, c->head.v.afi,
+                c->head.v.block_count, c->head.v.block_size, c->head.v.ic_ref);
+}
+
+/*============================================================================*/
+/**
+ * @brief m1_t5t_read - Read ISO15693 (Type 5) tag memory
+ * 
+ * Gets the memory layout with GET SYSTEM INFORMATION, then dumps the blocks
+ * with READ MULTIPLE BLOCKS (0x23) in NFC_T5T_RMB_MAX_BYTES chunks received
+ * straight into g_nfc_dump_buf. A chunk the tag refuses (block locked,
+ * command unsupported) is retried block by block with READ SINGLE BLOCK, and
+ * only blocks actually read are marked valid.
+ * 
+ * @param[in] dev Pointer to NFC device (addressed mode, UID from RFAL)
+ * @retval None
+ */
+/*============================================================================*/
+static void m1_t5t_read(const rfalNfcDevice *dev)
+{
+    /* Response flags byte + one chunk of block data */
+    static uint8_t rx[1U + NFC_T5T_RMB_MAX_BYTES];
+    nfc_run_ctx_t *c = nfc_ctx_get();
+    const uint8_t *uid = dev->nfcid;
+    uint16_t   rcvLen  = 0;
+    uint16_t   num_blocks = 0;
+    uint16_t   read_blocks = 0;
+    ReturnCode err = RFAL_ERR_NONE;
+
+    nfc_ctx_clear_dump();
+    t5t_get_system_info(uid);
+
+    uint8_t  bsize   = c->head.v.block_size ? c->head.v.block_size : 4U;
+    uint16_t nblocks = c->head.v.block_count ? c->head.v.block_count : NFC_T5T_DEFAULT_BLOCKS;
+    bool     probing = (c->head.v.block_count == 0U);
+
+    if (bsize > RFAL_NFCV_MAX_BLOCK_LEN) {
+        bsize = RFAL_NFCV_MAX_BLOCK_LEN;
+    }
+    if (nblocks > NFC_T5T_MAX_BLOCKS) {
+        nblocks = NFC_T5T_MAX_BLOCKS;
+    }
+    if ((uint32_t)nblocks * bsize > NFC_DUMP_BUF_SIZE) {
+        nblocks = (uint16_t)(NFC_DUMP_BUF_SIZE / bsize);
+    }
+
+    memset(g_nfc_valid_bits, 0x00, NFC_VALID_BITS_SIZE);
+
+    uint16_t chunk_max = (uint16_t)(NFC_T5T_RMB_MAX_BYTES / bsize);
+    bool     use_rmb   = true;
+    uint32_t t_start   = HAL_GetTick();
+
+    for (uint16_t blk = 0; blk < nblocks; ) {
+        m1_wdt_reset();
+
+        uint16_t chunk = use_rmb ? chunk_max : 1U;
+        if (blk + chunk > nblocks) {
+            chunk = nblocks - blk;
+        }
+
+        rcvLen = 0;
+        if (chunk > 1U) {
+            err = rfalNfcvPollerReadMultipleBlocks(RFAL_NFCV_REQ_FLAG_DEFAULT, uid, (uint8_t)blk,
+                                                   (uint8_t)(chunk - 1U), rx, sizeof(rx), &rcvLen);
+        } else {
+            err = rfalNfcvPollerReadSingleBlock(RFAL_NFCV_REQ_FLAG_DEFAULT, uid, (uint8_t)blk,
+                                                rx, sizeof(rx), &rcvLen);
+        }
+
+        if (err == RFAL_ERR_NONE && rcvLen == (uint16_t)(1U + chunk * bsize)) {
+            memcpy(&g_nfc_dump_buf[blk * bsize], &rx[1], (size_t)chunk * bsize);
+            for (uint16_t i = blk; i < blk + chunk; i++) {
+                g_nfc_valid_bits[i >> 3] |= (uint8_t)(1U << (i & 0x7U));
+            }
+            read_blocks += chunk;
+            num_blocks   = blk + chunk;
+        } else if (err == RFAL_ERR_LINK_LOSS || err == RFAL_ERR_TIMEOUT) {
+            if (chunk > 1U) {
+                /* Some tags stay silent on 0x23 instead of answering with an error */
+                platformLog("T5T RMB b%u fail: err=%d, falling back to single block\r\n", blk, err);
+                use_rmb = false;
+                continue;
+            }
+            if (probing) {
+                break;      /* Past the end of an unknown-size tag */
+            }
+            platformLog("T5T read b%u fail: err=%d\r\n", blk, err);
+            break;
+        } else {
+            if (chunk > 1U) {
+                /* Error response for the whole range (e.g. one locked block) → go block by block */
+                use_rmb = false;
+                continue;
+            }
+            if (probing) {
+                break;
+            }
+            memset(&g_nfc_dump_buf[blk * bsize], 0x00, bsize);
+            num_blocks = blk + 1U;
+        }
+
+        blk += chunk;
+        /* Re-enable multi-block reads once the offending chunk has been passed */
+        if (!use_rmb && (blk % chunk_max) == 0U) {
+            use_rmb = true;
+        }
+    }
+
+    platformLog("T5T dump: %u/%u blocks x %u B in %lu ms\r\n", read_blocks, num_blocks, bsize,
+                (unsigned long)(HAL_GetTick() - t_start));
+
+    if (num_blocks == 0U) {
+        platformLog("T5T: no blocks dumped\r\n");
+        return;
+    }
+
+    c->head.v.block_size  = bsize;
+    c->head.v.block_count = num_blocks;
+
+    nfc_ctx_set_dump(bsize,             // unit_size: tag block size
+                     num_blocks,        // unit_count
+                     0,                 // origin
+                     g_nfc_dump_buf,    // data pointer
+                     g_nfc_valid_bits,  // valid bits (locked/unreadable blocks cleared)
+                     num_blocks - 1U,   // max_seen_unit
+                     true);             // has_dump = true
+}
+
 /*============================================================================*/
 /**
  * @brief m1_t2t_read_ntag - Read Type 2 Tag (NTAG/Ultralight) memory
  * 
- * Reads Type 2 Tag memory pages using T2T READ commands.
- * Performs GET_VERSION to determine page count, then reads all pages
- * sequentially. Parses NDEF TLV if present.
+ * Performs GET_VERSION to identify the exact variant and page count, then
+ * dumps the memory with FAST_READ in NFC_T2T_FAST_READ_PAGES chunks received
+ * straight into g_nfc_dump_buf (4-page READ as fallback or for tags without
+ * GET_VERSION). Signature and counters are read in the same session. Parses
+ * NDEF TLV if present.
  * 
  * @param[in] dev Pointer to NFC device (unused, kept for compatibility)
  * @retval None
@@ -709,13 +1204,15 @@ static void m1_t2t_read_ntag(const rfalNfcDevice *dev)
     uint8_t  buf[16];               // T2T READ response buffer
     uint8_t* dump     = g_nfc_dump_buf;
     uint16_t dumpSize = NFC_DUMP_BUF_SIZE;
-    uint16_t offset   = 0;
     uint16_t rcvLen   = 0;
     uint16_t max_page = 45U;        // Default to NTAG213 span when size is unknown
-    ReturnCode err;
+    uint16_t num_pages = 0;         // Pages covered by the dump (read or zero-filled)
+    ReturnCode err = RFAL_ERR_NONE;
+    const t2t_variant_t *variant = NULL;
 
     // Clear previous NDEF / dump (optional)
     nfc_ctx_clear_t2t_ndef();
+    nfc_ctx_clear_t2t_extras();
     nfc_ctx_clear_dump();
 
     uint8_t version[8] = {0};
@@ -742,7 +1239,11 @@ static void m1_t2t_read_ntag(const rfalNfcDevice *dev)
     }
 
     if (ver_ok) {
-        max_page = LogParsedNtagVersion(version, rcvLen);
+        uint16_t ver_pages = LogParsedNtagVersion(version, rcvLen);
+        if (ver_pages > 0U) {
+            max_page = ver_pages;
+        }
+        variant = t2t_find_variant(version);
         nfc_ctx_set_t2t_version(version, (uint8_t)rcvLen);
         platformLog("GET_VER OK: %u pages\r\n", max_page);
     } else {
@@ -756,95 +1257,80 @@ static void m1_t2t_read_ntag(const rfalNfcDevice *dev)
         }
     }
 
+    if (max_page > dumpSize / 4U) {
+        max_page = dumpSize / 4U;
+    }
+    if (max_page > 256U) {
+        max_page = 256U;    // Page address is one byte (no sector select here)
+    }
 
+    bool use_fast = (variant != NULL) && variant->fast_read;
+    uint32_t t_start = HAL_GetTick();
+
+    // Read pages 0 ~ N: FAST_READ chunks, or 4 pages per READ
+    for (uint16_t blk = 0; blk < max_page; ) {
+        uint16_t chunk = use_fast ? NFC_T2T_FAST_READ_PAGES : 4U;
+        if (blk + chunk > max_page) {
+            chunk = max_page - blk;
+        }
 
-    // Read blocks 0 ~ N (T2T READ reads 4 blocks at a time, so increment by 4)
-    for (uint8_t blk = 0; blk < max_page; blk += 4) {  // Read 4 blocks at a time
-        rcvLen = 0;
         bool read_ok = false;
-        
-        /* Retry each READ command (max 3 times, to handle timing issues) */
-        for (uint8_t retry = 0; retry < 3 && !read_ok; retry++) {
-            /* Wait before retry (allow time for CE to respond) */
-            if (retry > 0) {
-                osDelay(10);  // Increase retry wait time (10ms)
+
+        if (use_fast) {
+            for (uint8_t retry = 0; retry < 2 && !read_ok; retry++) {
+                err = t2t_fast_read((uint8_t)blk, (uint8_t)(blk + chunk - 1U), &dump[blk * 4U]);
+                read_ok = (err == RFAL_ERR_NONE);
+                if (err == RFAL_ERR_LINK_LOSS) break;
+            }
+            if (!read_ok && err != RFAL_ERR_LINK_LOSS) {
+                /* Tag did not like FAST_READ → finish with plain READ */
+                platformLog("FAST_READ p%u fail: err=%d, falling back to READ\r\n", blk, err);
+                use_fast = false;
+                continue;
             }
-            
-            /* Initialize buffer (prevent previous data residue) */
-            memset(buf, 0x00, sizeof(buf));
-            rcvLen = 0;
-            
-            err = rfalT2TPollerRead(blk, buf, sizeof(buf), &rcvLen);
-            
-            if (err == RFAL_ERR_NONE && rcvLen >= 16) {  // T2T READ returns 16 bytes (4 blocks)
-                read_ok = true;
+        } else {
+            err = t2t_read_4pages((uint8_t)blk, buf);
+            read_ok = (err == RFAL_ERR_NONE);
+            if (read_ok) {
+                /* Store received data at corresponding page position */
+                memcpy(&dump[blk * 4U], buf, chunk * 4U);
                 /* Log only critical blocks */
                 if (blk == 0 || blk == 4) {
                     platformLog("READ blk%u: %s\r\n", blk, hex2Str(buf, 8));
                 }
-            } else {
-                /* Log only critical blocks on failure */
-                if ((blk == 0 || blk == 4) && retry == 0) {
-                    platformLog("READ blk%u fail: err=%d rcv=%u\r\n", blk, err, rcvLen);
-                }
-                /* If field loss, don't retry anymore */
-                if (err == RFAL_ERR_LINK_LOSS) {
-                    break;
-                }
             }
         }
-        
-        /* Calculate number of pages to save */
-        uint8_t pages_to_save = 4;
-        if (blk + pages_to_save > max_page) {
-            pages_to_save = max_page - blk;
-        }
-        
+
         if (!read_ok) {
             /* Stop if field loss */
             if (err == RFAL_ERR_LINK_LOSS) {
                 break;
             }
-            /* Fill failed blocks with 0 at corresponding position (prevent data shift) */
-            for (uint8_t i = 0; i < pages_to_save; i++) {
-                uint16_t page_idx = blk + i;
-                if (page_idx >= max_page) break;
-                
-                uint16_t save_offset = page_idx * 4;
-                if (save_offset + 4 <= dumpSize) {
-                    memset(&dump[save_offset], 0x00, 4);
-                }
-            }
-        } else {
-            /* On success: Store received data at corresponding block position */
-            for (uint8_t i = 0; i < pages_to_save; i++) {
-                uint16_t page_idx = blk + i;
-                if (page_idx >= max_page) break;
-                
-                uint16_t save_offset = page_idx * 4;
-                if (save_offset + 4 <= dumpSize) {
-                    /* Copy page data from buf */
-                    uint8_t *src = &buf[i * 4];
-                    uint8_t *dst = &dump[save_offset];
-                    memcpy(dst, src, 4);
-                }
-            }
+            /* Fill failed pages with 0 at corresponding position (prevent data shift) */
+            memset(&dump[blk * 4U], 0x00, chunk * 4U);
         }
-        
-        /* Update offset to next block position (regardless of success/failure) */
-        offset = (blk + 4) * 4;
-        
-        /* Log progress (every 16 blocks) */
-        if ((blk + 4) % 16 == 0 || (blk + 4) >= max_page) {
-            platformLog("T2T read progress: %u/%u pages\r\n", (unsigned)((blk + 4 > max_page) ? max_page : blk + 4), (unsigned)max_page);
+
+        blk += chunk;
+        num_pages = blk;
+
+        /* Log progress (every 16 pages) */
+        if ((blk % 16U) < chunk || blk >= max_page) {
+            platformLog("T2T read progress: %u/%u pages\r\n", (unsigned)blk, (unsigned)max_page);
         }
     }
 
+    platformLog("T2T dump: %u pages in %lu ms (%s)\r\n", num_pages,
+                (unsigned long)(HAL_GetTick() - t_start), use_fast ? "FAST_READ" : "READ");
+
+    /* Signature/counters last: READ_CNT may NAK and drop the tag to IDLE */
+    if (variant != NULL && err != RFAL_ERR_LINK_LOSS) {
+        t2t_read_sig_and_counters(variant);
+    }
+
     osDelay(5);
 
     // Actual dump length and page count
-    uint16_t dump_len  = offset;
-    uint16_t num_pages = dump_len / 4;
+    uint16_t dump_len  = num_pages * 4U;
 
     if (num_pages == 0) {
         platformLog("T2T: no pages dumped\r\n");
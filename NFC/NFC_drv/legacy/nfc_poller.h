@@ -1,6 +1,22 @@
 /* See COPYING.txt for license details. */
 
+#ifndef NFC_DRV_NFC_POLLER_H_
+#define NFC_DRV_NFC_POLLER_H_
+
 #include <stdbool.h>
+#include <stdint.h>
+
+#define NFC_POLL_MAX_TAGS   5U      /* devLimit of the discovery, at most RFAL_NFC_MAX_DEVICES */
+
+/* One card resolved by anticollision during the last discovery round */
+typedef struct {
+    uint8_t tech;           /* M1NFC_TECH_A/B/F/V */
+    uint8_t rfal_type;      /* rfalNfcDevType */
+    uint8_t uid[10];        /* Display order (NFC-V reversed like the log) */
+    uint8_t uid_len;
+    uint8_t atqa[2];        /* NFC-A only */
+    uint8_t sak;            /* NFC-A only */
+} nfc_poll_tag_t;
 
 /**
  * @brief ReadIni - Initialize NFC poller (READ-ONLY mode)
@@ -15,4 +31,24 @@ bool ReadIni(void);
  * 
  * @retval None
  */
-void ReadCycle(void);
\ No newline at end of file
+void ReadCycle(void);
+/**
+ * @brief nfc_poller_get_tags - Cards seen in the field by the last read
+ *
+ * Entry 0 is the card that was activated and read in full; the others were
+ * resolved by anticollision and are reported with identity only.
+ *
+ * @param[out] list Pointer to internal table (valid until next read)
+ * @retval Number of entries in the table
+ */
+uint8_t nfc_poller_get_tags(const nfc_poll_tag_t **list);
+
+/**
+ * @brief nfc_poller_tech_name - Short technology label for a tag entry
+ *
+ * @param[in] tag Tag entry
+ * @retval "NFC-A", "NFC-B", "NFC-F", "NFC-V" or "ST25TB"
+ */
+const char *nfc_poller_tech_name(const nfc_poll_tag_t *tag);
+
+#endif /* NFC_DRV_NFC_POLLER_H_ */
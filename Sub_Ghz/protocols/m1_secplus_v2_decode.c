@@ -13,6 +13,7 @@
 
 /*************************** I N C L U D E S **********************************/
 #include <string.h>
+#include <inttypes.h>
 #include <stdlib.h>
 #include "stm32h5xx_hal.h"
 #include "bit_util.h"
@@ -227,8 +228,8 @@ uint8_t subghz_decode_security_plus_20(uint16_t p, uint16_t pulsecount)
     			{
     				memset(&half_codes[0], 0, 10);
     				memset(&half_codes[1], 0, 10);
-    				M1_LOG_D(M1_LOGDB_TAG, "Packet 1 0x%lX%lX\r\n", (uint32_t)(prev_code>>32), (uint32_t)prev_code);
-    				M1_LOG_D(M1_LOGDB_TAG, "Packet 2 0x%lX%lX\r\n", (uint32_t)(code>>32), (uint32_t)code);
+    				M1_LOG_D(M1_LOGDB_TAG, "Packet 1 0x%" PRIX32 "%" PRIX32 "\r\n", (uint32_t)(prev_code>>32), (uint32_t)prev_code);
+    				M1_LOG_D(M1_LOGDB_TAG, "Packet 2 0x%" PRIX32 "%" PRIX32 "\r\n", (uint32_t)(code>>32), (uint32_t)code);
     				ret = m1_secplus_v2_decode_half(prev_code, (uint8_t *)&half_codes[0], &fixed[0]);
     				if ( ret )
     					break;
@@ -255,9 +256,9 @@ uint8_t subghz_decode_security_plus_20(uint16_t p, uint16_t pulsecount)
             subghz_decenc_ctl.ndecodedprotocol = p;
             // Packet 1 = prev_code
             // Packet 2 = code
-    	    M1_LOG_I(M1_LOGDB_TAG, "Decoded 0x%lX%lX\r\n", (uint32_t)(code>>32), (uint32_t)code);
+    	    M1_LOG_I(M1_LOGDB_TAG, "Decoded 0x%" PRIX32 "%" PRIX32 "\r\n", (uint32_t)(code>>32), (uint32_t)code);
     		M1_LOG_D(M1_LOGDB_TAG, "Button 0x%X\r\n", (uint8_t)(fixed[0] >> 12));
-    		M1_LOG_D(M1_LOGDB_TAG, "Serial 0x%lX\r\n", (fixed[0] << 20) | fixed[1]);
+    		M1_LOG_D(M1_LOGDB_TAG, "Serial 0x%" PRIX32 "\r\n", (fixed[0] << 20) | fixed[1]);
     	} // if ( rx_packets==0x03 )
     } // while (ret)
 
@@ -44,8 +44,6 @@
  * @{
  */
 
-static uint8_t usbRxBuffer[USB_RX_BUF_SIZE];
-static uint16_t usbRxBufIndex = 0;
 static volatile uint32_t usb_cli_rx_dropped_bytes = 0;
 static volatile uint32_t usb_cli_rx_high_watermark = 0;
 /**
@@ -162,9 +160,9 @@ static int8_t CDC_Control_FS(uint8_t cmd, uint8_t *pbuf, uint16_t length) {
     linecoding.paritytype = pbuf[5];
     linecoding.datatype = pbuf[6];
 
-    /* Add your code here */
+    /* Applied by vUsb2SerTask, USART1 must not be set up in the ISR */
     if (m1_usbcdc_mode == CDC_MODE_VCP) {
-      m1_usb_cdc_comconfig();
+      m1_usb_cdc_comconfig_from_isr();
     }
     break;
 
@@ -213,87 +211,33 @@ static int8_t CDC_Control_FS(uint8_t cmd, uint8_t *pbuf, uint16_t length) {
  * USBD_FAIL
  */
 
-uint32_t DEBUG_ovf_cnt = 0;
-uint32_t DEBUG_max_usbRxBufIndex = 0;
-uint32_t DEBUG_paused_cnt = 0;
-uint32_t DEBUG_prev_data[4];
-uint32_t DEBUG_ovrl_cnt = 0;
 static int8_t CDC_Receive_FS(uint8_t *Buf, uint32_t *Len) {
   BaseType_t xHigherPriorityTaskWoken = pdFALSE;
   size_t sentBytes;
   size_t freeSpace;
-  size_t SendBytesbf;
 
   if (m1_usbcdc_mode == CDC_MODE_VCP) {
     if (h_usb_rx_streambuf == NULL || *Len == 0) {
+      USBD_CDC_ReceivePacket(&hUsbDeviceFS);
       return USBD_OK;
     }
 
-    if (strncmp((char *)DEBUG_prev_data, Buf, 4) != 0) {
-      DEBUG_ovrl_cnt++;
-    }
-    memcpy(DEBUG_prev_data, Buf, 4);
-
-    /* Input 64 bytes of data into usbRxBuffer */
-    if (usbRxBufIndex + *Len <= USB_RX_BUF_SIZE) {
-      memcpy(&usbRxBuffer[usbRxBufIndex], Buf, *Len);
-      usbRxBufIndex += *Len;
-
-      if (usbRxBufIndex > DEBUG_max_usbRxBufIndex)
-        DEBUG_max_usbRxBufIndex = usbRxBufIndex;
-
-    } else {
-      /* Handle usbRxBuffer overflow */
-      // printf("Overflow - CDC RX Buffer!\r\n");
-
-      DEBUG_ovf_cnt++;
-    }
-
-    /* Check for empty space in the stream buffer */
-    freeSpace = xStreamBufferSpacesAvailable(h_usb_rx_streambuf);
-
-    if (freeSpace > 0 && usbRxBufIndex > 0) {
-      /* Transfer usbRxBuffer data to the empty space in the Stream Buffer. */
-      SendBytesbf = (usbRxBufIndex < freeSpace) ? usbRxBufIndex : freeSpace;
-
-      sentBytes =
-          xStreamBufferSendFromISR(h_usb_rx_streambuf, (void *)usbRxBuffer,
-                                   SendBytesbf, &xHigherPriorityTaskWoken);
-      if (sentBytes > 0) {
-        /* Move/remove intermediate buffer data as much as transferred to Stream
-         * Buffer. */
-        if (sentBytes < usbRxBufIndex) {
-          /* Move forward if there is remaining data*/
-          memmove(usbRxBuffer, usbRxBuffer + sentBytes,
-                  usbRxBufIndex - sentBytes);
-        }
-        usbRxBufIndex -= sentBytes;
-
-        /* Notify Task */
-        if (usb2ser_task_hdl != NULL) {
-          vTaskNotifyGiveFromISR(usb2ser_task_hdl, &xHigherPriorityTaskWoken);
-        }
-      }
-    }
+    /* The packet always fits: the next one is only requested while the
+     * stream buffer has room for a full packet. Sending wakes vUsb2SerTask. */
+    xStreamBufferSendFromISR(h_usb_rx_streambuf, (void *)Buf, *Len,
+                             &xHigherPriorityTaskWoken);
 
-    if (freeSpace == 0) {
+    if (xStreamBufferSpacesAvailable(h_usb_rx_streambuf) <
+        CDC_DATA_FS_MAX_PACKET_SIZE) {
+      /* USART1 is behind: NAK the host until vUsb2SerTask makes room */
       usbcdc_rx_paused = 1;
-    }
-
-    if (usbcdc_rx_paused == 0) {
-      //      USBD_CDC_SetRxBuffer(&hUsbDeviceFS, &Buf[0]);
-      //      Buf[*Len] = 0;
-      USBD_CDC_ReceivePacket(&hUsbDeviceFS);
-
-      // DEBUG_paused_cnt = 0;
+      m1_usb_bridge_count_pause();
     } else {
-      DEBUG_paused_cnt++;
+      USBD_CDC_ReceivePacket(&hUsbDeviceFS);
     }
 
-    if (xHigherPriorityTaskWoken == pdTRUE) {
-      portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
-    }
-  } else { // == CDC_MODE_LOG_CLI
+    portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+  } else { // CDC_MODE_LOG_CLI or CDC_MODE_STREAM, commands go to the CLI
     if ((h_usb_cli_rx_streambuf == NULL) || (*Len == 0U)) {
       USBD_CDC_ReceivePacket(&hUsbDeviceFS);
       return (USBD_OK);
@@ -340,7 +284,10 @@ static int8_t CDC_TransmitCplt_FS(uint8_t *Buf, uint32_t *Len, uint8_t epnum) {
   QueueHandle_t q_item;
   portBASE_TYPE xHigherPriorityTaskWoken = pdFALSE;
 
-  if (m1_usbcdc_mode == CDC_MODE_VCP) {
+  if (m1_cdc_stream_tx_done(Buf)) {
+    // Capture stream packet, checked first as the mode may have changed
+    // since the transfer started
+  } else if (m1_usbcdc_mode == CDC_MODE_VCP) {
     // After the USB transfer is complete, signal the task to start the next
     // transfer.
     CDC_Signal_Next_Tx();
@@ -92,6 +92,8 @@ static int8_t SCSI_Write12(USBD_HandleTypeDef *pdev, uint8_t lun, uint8_t *param
 static int8_t SCSI_Read10(USBD_HandleTypeDef *pdev, uint8_t lun, uint8_t *params);
 static int8_t SCSI_Read12(USBD_HandleTypeDef *pdev, uint8_t lun, uint8_t *params);
 static int8_t SCSI_Verify10(USBD_HandleTypeDef *pdev, uint8_t lun, uint8_t *params);
+static int8_t SCSI_SynchronizeCache10(USBD_HandleTypeDef *pdev, uint8_t lun, uint8_t *params);
+static int8_t SCSI_FlushMedium(USBD_HandleTypeDef *pdev, uint8_t lun);
 static int8_t SCSI_CheckAddressRange(USBD_HandleTypeDef *pdev, uint8_t lun,
                                      uint32_t blk_offset, uint32_t blk_nbr);
 
@@ -190,6 +192,10 @@ int8_t SCSI_ProcessCmd(USBD_HandleTypeDef *pdev, uint8_t lun, uint8_t *cmd)
       ret = SCSI_Verify10(pdev, lun, cmd);
       break;
 
+    case SCSI_SYNCHRONIZE_CACHE10:
+      ret = SCSI_SynchronizeCache10(pdev, lun, cmd);
+      break;
+
     default:
       SCSI_SenseCode(pdev, lun, ILLEGAL_REQUEST, INVALID_CDB);
       hmsc->bot_status = USBD_BOT_STATUS_ERROR;
@@ -240,6 +246,14 @@ static int8_t SCSI_TestUnitReady(USBD_HandleTypeDef *pdev, uint8_t lun, uint8_t
 
     return -1;
   }
+
+  /* Hosts poll this while idle: cached blocks reach the medium even if the
+     device is unplugged without eject */
+  if (SCSI_FlushMedium(pdev, lun) < 0)
+  {
+    hmsc->bot_state = USBD_BOT_NO_DATA;
+    return -1;
+  }
   hmsc->bot_data_length = 0U;
 
   return 0;
@@ -634,6 +648,10 @@ static int8_t SCSI_StartStopUnit(USBD_HandleTypeDef *pdev, uint8_t lun, uint8_t
   }
   else if ((params[4] & 0x3U) == 0x2U) /* START=0 and LOEJ Load Eject=1 */
   {
+    if (SCSI_FlushMedium(pdev, lun) < 0)
+    {
+      return -1;
+    }
     hmsc->scsi_medium_state = SCSI_MEDIUM_EJECTED;
   }
   else if ((params[4] & 0x3U) == 0x3U) /* START=1 and LOEJ Load Eject=1 */
@@ -669,6 +687,11 @@ static int8_t SCSI_AllowPreventRemovable(USBD_HandleTypeDef *pdev, uint8_t lun,
 
   if (params[4] == 0U)
   {
+    /* The host may let the medium go now */
+    if (SCSI_FlushMedium(pdev, lun) < 0)
+    {
+      return -1;
+    }
     hmsc->scsi_medium_state = SCSI_MEDIUM_UNLOCKED;
   }
   else
@@ -1031,6 +1054,53 @@ static int8_t SCSI_Verify10(USBD_HandleTypeDef *pdev, uint8_t lun, uint8_t *para
   return 0;
 }
 
+/**
+  * @brief  SCSI_SynchronizeCache10
+  *         Process Synchronize Cache (10) command
+  * @param  lun: Logical unit number
+  * @param  params: Command parameters
+  * @retval status
+  */
+static int8_t SCSI_SynchronizeCache10(USBD_HandleTypeDef *pdev, uint8_t lun, uint8_t *params)
+{
+  UNUSED(params);
+  USBD_MSC_BOT_HandleTypeDef *hmsc = (USBD_MSC_BOT_HandleTypeDef *)pdev->pClassDataCmsit[pdev->classId];
+
+  if (hmsc == NULL)
+  {
+    return -1;
+  }
+
+  /* The whole cache is written, whatever range was asked for */
+  if (SCSI_FlushMedium(pdev, lun) < 0)
+  {
+    return -1;
+  }
+
+  hmsc->bot_data_length = 0U;
+
+  return 0;
+}
+
+/**
+  * @brief  SCSI_FlushMedium
+  *         Write the blocks the storage layer still caches
+  * @param  lun: Logical unit number
+  * @retval status
+  */
+static int8_t SCSI_FlushMedium(USBD_HandleTypeDef *pdev, uint8_t lun)
+{
+  USBD_StorageTypeDef *storage = (USBD_StorageTypeDef *)pdev->pUserData[pdev->classId];
+
+  if ((storage->Flush != NULL) && (storage->Flush(lun) != 0))
+  {
+    SCSI_SenseCode(pdev, lun, MEDIUM_ERROR, WRITE_FAULT);
+    return -1;
+  }
+
+  return 0;
+}
+
 /**
   * @brief  SCSI_CheckAddressRange
   *         Check address range
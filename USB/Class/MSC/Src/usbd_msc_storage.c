@@ -26,6 +26,7 @@ EndBSPDependencies */
 #include <usbd_msc_storage.h>
 #include "m1_sdcard.h"
 #include "m1_usb_cdc_msc.h"
+#include "m1_msc_cache.h"
 
 /* Private typedef -----------------------------------------------------------*/
 #define M1_LOGDB_TAG  "USB-MSC"
@@ -59,6 +60,9 @@ int8_t STORAGE_Read(uint8_t lun, uint8_t *buf, uint32_t blk_addr,
 int8_t STORAGE_Write(uint8_t lun, uint8_t *buf, uint32_t blk_addr,
                      uint16_t blk_len);
 int8_t STORAGE_GetMaxLun(void);
+int8_t STORAGE_Flush(uint8_t lun);
+static int8_t msc_sd_read(uint8_t *buf, uint32_t blk_addr, uint16_t blk_len);
+static int8_t msc_sd_write(uint8_t *buf, uint32_t blk_addr, uint16_t blk_len);
 
 /* USB Mass storage Standard Inquiry Data */
 int8_t  STORAGE_Inquirydata[] =  /* 36 */
@@ -87,6 +91,7 @@ USBD_StorageTypeDef USBD_MSC_Interface_fops =
   STORAGE_Read,
   STORAGE_Write,
   STORAGE_GetMaxLun,
+  STORAGE_Flush,
   STORAGE_Inquirydata,
 };
 
@@ -99,6 +104,9 @@ int8_t STORAGE_Init(uint8_t lun)
 {
   UNUSED(lun);
   //m1_sdcard_unmount();
+  // Blocks of a previous session are written before the cache starts over
+  m1_msc_cache_flush();
+  m1_msc_cache_init(msc_sd_read, msc_sd_write);
   return (0);
 }
 
@@ -123,6 +131,7 @@ int8_t STORAGE_GetCapacity(uint8_t lun, uint32_t *block_num, uint16_t *block_siz
 
     *block_num  = cardinfo.BlockNbr;
     *block_size = cardinfo.BlockSize ;
+    m1_msc_cache_set_capacity(cardinfo.BlockNbr);
 
     res = 0;
   }
@@ -148,7 +157,9 @@ int8_t  STORAGE_IsReady(uint8_t lun)
   }
   else
   {
+    // Card removed or mounted by the firmware, the cached blocks are stale
     m1_USB_MSC_ready = -1;
+    m1_msc_cache_invalidate();
   }
 
   return (m1_USB_MSC_ready);  // 0=MSC ready, -1=MSC not ready
@@ -180,6 +191,48 @@ uint8_t *DBG_sd_buf;
   */
 int8_t STORAGE_Read(uint8_t lun, uint8_t *buf,
                     uint32_t blk_addr, uint16_t blk_len)
+{
+  UNUSED(lun);
+
+  return m1_msc_cache_read(buf, blk_addr, blk_len);
+}
+
+/**
+  * @brief  Writes data into the medium.
+  * @param  lun: Logical unit number
+  * @param  buf: data buffer
+  * @param  blk_addr: Logical block address
+  * @param  blk_len: Blocks number
+  * @retval Status (0 : OK / -1 : Error)
+  */
+int8_t STORAGE_Write(uint8_t lun, uint8_t *buf,
+                     uint32_t blk_addr, uint16_t blk_len)
+{
+  UNUSED(lun);
+
+  return m1_msc_cache_write(buf, blk_addr, blk_len);
+}
+
+/**
+  * @brief  Writes the cached blocks to the medium.
+  * @param  lun: Logical unit number
+  * @retval Status (0 : OK / -1 : Error)
+  */
+int8_t STORAGE_Flush(uint8_t lun)
+{
+  UNUSED(lun);
+
+  return m1_msc_cache_flush();
+}
+
+/**
+  * @brief  Reads blocks from the SD card with one multi-block transfer.
+  * @param  buf: data buffer
+  * @param  blk_addr: Logical block address
+  * @param  blk_len: Blocks number
+  * @retval Status (0: OK / -1: Error)
+  */
+static int8_t msc_sd_read(uint8_t *buf, uint32_t blk_addr, uint16_t blk_len)
 {
   BaseType_t xHigherPriorityTaskWoken = pdFALSE;
   int8_t res = -1;
@@ -187,8 +240,6 @@ int8_t STORAGE_Read(uint8_t lun, uint8_t *buf,
   uint16_t event = 0;
   BaseType_t status;
 
-  UNUSED(lun);
-
   DBG_sd_buf = buf;
 
   if ((sdcard_ctl.status == SD_access_UnMounted) &&
@@ -230,15 +281,13 @@ int8_t STORAGE_Read(uint8_t lun, uint8_t *buf,
 }
 
 /**
-  * @brief  Writes data into the medium.
-  * @param  lun: Logical unit number
+  * @brief  Writes blocks to the SD card with one multi-block transfer.
   * @param  buf: data buffer
   * @param  blk_addr: Logical block address
   * @param  blk_len: Blocks number
   * @retval Status (0 : OK / -1 : Error)
   */
-int8_t STORAGE_Write(uint8_t lun, uint8_t *buf,
-                     uint32_t blk_addr, uint16_t blk_len)
+static int8_t msc_sd_write(uint8_t *buf, uint32_t blk_addr, uint16_t blk_len)
 {
   BaseType_t xHigherPriorityTaskWoken = pdFALSE;
   int8_t res = -1;
@@ -246,8 +295,6 @@ int8_t STORAGE_Write(uint8_t lun, uint8_t *buf,
   uint16_t event = 0;
   BaseType_t status;
 
-  UNUSED(lun);
-
   if ((sdcard_ctl.status == SD_access_UnMounted) &&
       (m1_sd_detected()))
   {
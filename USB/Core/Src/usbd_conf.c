@@ -23,6 +23,7 @@
 #include "usbd_core.h"
 #include "usbd_cdc.h" 				/* Include class header file */
 #include "usbd_msc.h"         /* Include class header file */
+#include "m1_msc_cache.h"
 
 /* Private typedef -----------------------------------------------------------*/
 /* Private define ------------------------------------------------------------*/
@@ -86,6 +87,8 @@ void HAL_PCD_SuspendCallback(PCD_HandleTypeDef *hpcd)
 {
   m1_USB_CDC_ready = -1;
   m1_USB_MSC_ready = -1;
+  /* Cable pulled or host asleep: write what the MSC sector cache holds */
+  m1_msc_cache_flush();
 }
 
 /**
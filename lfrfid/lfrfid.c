@@ -25,6 +25,7 @@
 #include "uiView.h"
 
 #include "lfrfid.h"
+#include "m1_cdc_stream.h"
 
 #define M1_LOGDB_TAG	"RFID"
 
@@ -415,6 +416,14 @@ void lfrfid_rxThread(void *param)
         uint8_t CHUNK_SIZE = FRAME_CHUNK_SIZE>>1;
         lfrfid_evt_t* p = (lfrfid_evt_t*)batch_buf;
 
+        if (m1_cdc_stream_source() == CDC_STREAM_SRC_LFRFID)
+        {
+            // edge is the input level after the edge, t_us the time before it
+            for (int i = 0; i < total_events; i++)
+                m1_cdc_stream_put(p[i].t_us, !p[i].edge);
+            m1_cdc_stream_flush(false);
+        }
+
         for (int i = 0; i < total_events; i += CHUNK_SIZE)
         {
             uint16_t events_to_process = (total_events - i < CHUNK_SIZE) ? (total_events - i) : CHUNK_SIZE;
@@ -15,6 +15,7 @@
 #include "m1_sdcard_man.h"
 #include "m1_file_browser.h"
 #include "m1_file_util.h"
+#include "m1_signal_index.h"
 #include "m1_virtual_kb.h"
 #include "lfrfid.h"
 #include "uiView.h"
@@ -158,6 +159,8 @@ bool lfrfid_profile_save(const char *fp, const PLFRFID_TAG_INFO data)
     if (write_private_profile_string(RFID_DATAFILE_DATA_KEYWORD, szString, fp) == 0)
         return false;
 
+    m1_sig_idx_add(SIG_IDX_RFID, fp, protocol, 0, data->uid, uid_size);
+
     return true;
 }
 
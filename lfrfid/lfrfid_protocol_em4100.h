@@ -62,6 +62,8 @@ typedef struct {
 //void setEm4100_bitrate(int bitrate);
 void EM4100_Decoder_Init_Full(EM4100_Decoder_t* dec);
 void EM4100_Decoder_Init_Partial(EM4100_Decoder_t* dec);
+void em4100_uid_bytes_to_nibbles(const uint8_t *uid_bytes, uint8_t uid_len, uint8_t out_nibs[10]);
+void em4100_build_frame8_from_uid(uint8_t frame8[8], const uint8_t *uid_bytes, uint8_t uid_len);
 #if 0
 /* EM4100 계열 판별기
  *
@@ -187,6 +187,157 @@ unsigned extract_bits_symbols(uint8_t const *message, unsigned offset_bits, unsi
     return dst_len;
 }
 
+// Table driven CRCs (slice-by-4) and the hardware hook used by crc8(),
+// crc8le(), crc16(), crc16lsb(), crc32() and crc32lsb().
+//
+// MSB-first tables hold the polynomial left aligned to bit 31, LSB-first
+// tables the reflected polynomial in the low bits, so one table serves any
+// width. A table is built the first time a polynomial is used on at least
+// CRC_TABLE_MIN_BYTES, short messages only use a table that already exists.
+// Tables are never evicted: once all slots are taken, further polynomials
+// stay on the bitwise loops.
+#define CRC_TABLE_SLOTS     4
+#define CRC_TABLE_MIN_BYTES 32
+#define CRC_HW_MIN_BYTES    256
+
+enum crc_table_state {
+    CRC_TABLE_FREE,
+    CRC_TABLE_BUILDING,
+    CRC_TABLE_READY,
+};
+
+struct crc_table {
+    uint32_t poly;
+    uint8_t lsb_first;
+    uint8_t state;
+    uint32_t t[4][256]; // t[k][v]: CRC of byte v followed by k zero bytes
+};
+
+static struct crc_table crc_tables[CRC_TABLE_SLOTS];
+
+__attribute__((weak)) int crc_hw_calc(unsigned width, int lsb_first, uint32_t polynomial, uint32_t init,
+        uint8_t const message[], unsigned nBytes, uint32_t *crc)
+{
+    (void)width; (void)lsb_first; (void)polynomial; (void)init;
+    (void)message; (void)nBytes; (void)crc;
+    return 0; // no CRC hardware
+}
+
+static void crc_table_fill(struct crc_table *tab)
+{
+    uint32_t crc;
+    unsigned i, k;
+
+    for (i = 0; i < 256; ++i) {
+        if (tab->lsb_first) {
+            crc = i;
+            for (k = 0; k < 8; ++k)
+                crc = (crc & 1) ? (crc >> 1) ^ tab->poly : (crc >> 1);
+        }
+        else {
+            crc = (uint32_t)i << 24;
+            for (k = 0; k < 8; ++k)
+                crc = (crc & 0x80000000u) ? (crc << 1) ^ tab->poly : (crc << 1);
+        }
+        tab->t[0][i] = crc;
+    }
+    for (k = 1; k < 4; ++k) {
+        for (i = 0; i < 256; ++i) {
+            crc = tab->t[k - 1][i];
+            if (tab->lsb_first)
+                tab->t[k][i] = (crc >> 8) ^ tab->t[0][crc & 0xff];
+            else
+                tab->t[k][i] = (crc << 8) ^ tab->t[0][crc >> 24];
+        }
+    }
+}
+
+// Finds the table of a polynomial, builds it into a free slot for long messages.
+// Safe to call from several tasks: a slot is claimed before it is built and
+// only matched once it is complete.
+static struct crc_table const *crc_table_get(int lsb_first, uint32_t poly, unsigned nBytes)
+{
+    struct crc_table *tab;
+    uint8_t expected;
+    unsigned i;
+
+    for (i = 0; i < CRC_TABLE_SLOTS; ++i) {
+        tab = &crc_tables[i];
+        if (__atomic_load_n(&tab->state, __ATOMIC_ACQUIRE) == CRC_TABLE_READY
+                && tab->poly == poly && tab->lsb_first == lsb_first)
+            return tab;
+    }
+    if (nBytes < CRC_TABLE_MIN_BYTES)
+        return NULL;
+
+    for (i = 0; i < CRC_TABLE_SLOTS; ++i) {
+        tab = &crc_tables[i];
+        expected = CRC_TABLE_FREE;
+        if (__atomic_compare_exchange_n(&tab->state, &expected, CRC_TABLE_BUILDING, 0,
+                    __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            tab->poly = poly;
+            tab->lsb_first = (uint8_t)lsb_first;
+            crc_table_fill(tab);
+            __atomic_store_n(&tab->state, CRC_TABLE_READY, __ATOMIC_RELEASE);
+            return tab;
+        }
+    }
+    return NULL;
+}
+
+static uint32_t crc_table_update(struct crc_table const *tab, uint32_t crc, uint8_t const *message, unsigned nBytes)
+{
+    uint32_t const (*t)[256] = tab->t;
+
+    if (tab->lsb_first) {
+        for (; nBytes >= 4; nBytes -= 4, message += 4) {
+            crc ^= message[0] | (uint32_t)message[1] << 8 | (uint32_t)message[2] << 16 | (uint32_t)message[3] << 24;
+            crc = t[3][crc & 0xff] ^ t[2][(crc >> 8) & 0xff] ^ t[1][(crc >> 16) & 0xff] ^ t[0][crc >> 24];
+        }
+        while (nBytes--)
+            crc = (crc >> 8) ^ t[0][(crc ^ *message++) & 0xff];
+    }
+    else {
+        for (; nBytes >= 4; nBytes -= 4, message += 4) {
+            crc ^= (uint32_t)message[0] << 24 | (uint32_t)message[1] << 16 | (uint32_t)message[2] << 8 | message[3];
+            crc = t[3][crc >> 24] ^ t[2][(crc >> 16) & 0xff] ^ t[1][(crc >> 8) & 0xff] ^ t[0][crc & 0xff];
+        }
+        while (nBytes--)
+            crc = (crc << 8) ^ t[0][(crc >> 24) ^ *message++];
+    }
+    return crc;
+}
+
+// CRC on the hardware or a table, polynomial and init as the caller passes
+// them (reflected for LSB-first). Returns 0 if the bitwise loop has to run.
+static int crc_fast(unsigned width, int lsb_first, uint32_t polynomial, uint32_t init,
+        uint8_t const message[], unsigned nBytes, uint32_t *crc)
+{
+    struct crc_table const *tab;
+    unsigned align = 32 - width;
+
+    if (nBytes >= CRC_HW_MIN_BYTES) {
+        // The hardware takes the polynomial and init in MSB-first order
+        if (lsb_first ? crc_hw_calc(width, 1, reverse32(polynomial) >> align, reverse32(init) >> align, message, nBytes, crc)
+                      : crc_hw_calc(width, 0, polynomial, init, message, nBytes, crc))
+            return 1;
+    }
+
+    if (lsb_first) {
+        tab = crc_table_get(1, polynomial, nBytes);
+        if (!tab)
+            return 0;
+        *crc = crc_table_update(tab, init, message, nBytes);
+    }
+    else {
+        tab = crc_table_get(0, polynomial << align, nBytes);
+        if (!tab)
+            return 0;
+        *crc = crc_table_update(tab, init << align, message, nBytes) >> align;
+    }
+    return 1;
+}
+
 uint8_t crc4(uint8_t const message[], unsigned nBytes, uint8_t polynomial, uint8_t init)
 {
     unsigned remainder = init << 4; // LSBs are unused
@@ -229,6 +380,10 @@ uint8_t crc8(uint8_t const message[], unsigned nBytes, uint8_t polynomial, uint8
 {
     uint8_t remainder = init;
     unsigned byte, bit;
+    uint32_t crc;
+
+    if (crc_fast(8, 0, polynomial, init, message, nBytes, &crc))
+        return (uint8_t)crc;
 
     for (byte = 0; byte < nBytes; ++byte) {
         remainder ^= message[byte];
@@ -247,8 +402,12 @@ uint8_t crc8le(uint8_t const message[], unsigned nBytes, uint8_t polynomial, uin
 {
     uint8_t remainder = reverse8(init);
     unsigned byte, bit;
+    uint32_t crc;
     polynomial = reverse8(polynomial);
 
+    if (crc_fast(8, 1, polynomial, remainder, message, nBytes, &crc))
+        return (uint8_t)crc;
+
     for (byte = 0; byte < nBytes; ++byte) {
         remainder ^= message[byte];
         for (bit = 0; bit < 8; ++bit) {
@@ -266,6 +425,10 @@ uint16_t crc16lsb(uint8_t const message[], unsigned nBytes, uint16_t polynomial,
 {
     uint16_t remainder = init;
     unsigned byte, bit;
+    uint32_t crc;
+
+    if (crc_fast(16, 1, polynomial, init, message, nBytes, &crc))
+        return (uint16_t)crc;
 
     for (byte = 0; byte < nBytes; ++byte) {
         remainder ^= message[byte];
@@ -285,6 +448,10 @@ uint16_t crc16(uint8_t const message[], unsigned nBytes, uint16_t polynomial, ui
 {
     uint16_t remainder = init;
     unsigned byte, bit;
+    uint32_t crc;
+
+    if (crc_fast(16, 0, polynomial, init, message, nBytes, &crc))
+        return (uint16_t)crc;
 
     for (byte = 0; byte < nBytes; ++byte) {
         remainder ^= message[byte] << 8;
@@ -300,6 +467,50 @@ uint16_t crc16(uint8_t const message[], unsigned nBytes, uint16_t polynomial, ui
     return remainder;
 }
 
+uint32_t crc32lsb(uint8_t const message[], unsigned nBytes, uint32_t polynomial, uint32_t init)
+{
+    uint32_t remainder = init;
+    unsigned byte, bit;
+
+    if (crc_fast(32, 1, polynomial, init, message, nBytes, &remainder))
+        return remainder;
+
+    for (byte = 0; byte < nBytes; ++byte) {
+        remainder ^= message[byte];
+        for (bit = 0; bit < 8; ++bit) {
+            if (remainder & 1) {
+                remainder = (remainder >> 1) ^ polynomial;
+            }
+            else {
+                remainder = (remainder >> 1);
+            }
+        }
+    }
+    return remainder;
+}
+
+uint32_t crc32(uint8_t const message[], unsigned nBytes, uint32_t polynomial, uint32_t init)
+{
+    uint32_t remainder = init;
+    unsigned byte, bit;
+
+    if (crc_fast(32, 0, polynomial, init, message, nBytes, &remainder))
+        return remainder;
+
+    for (byte = 0; byte < nBytes; ++byte) {
+        remainder ^= (uint32_t)message[byte] << 24;
+        for (bit = 0; bit < 8; ++bit) {
+            if (remainder & 0x80000000u) {
+                remainder = (remainder << 1) ^ polynomial;
+            }
+            else {
+                remainder = (remainder << 1);
+            }
+        }
+    }
+    return remainder;
+}
+
 uint8_t lfsr_digest8(uint8_t const message[], unsigned bytes, uint8_t gen, uint8_t key)
 {
     uint8_t sum = 0;
@@ -561,6 +772,21 @@ int main(void) {
     fprintf(stderr, "util::crc8(): even parity\n");
     ASSERT_EQUALS(crc8(msg, 4, 0x80, 0x00), 0x00);
 
+    fprintf(stderr, "util::crc32(): check values\n");
+    uint8_t check[] = "123456789";
+    ASSERT_EQUALS(crc32lsb(check, 9, 0xEDB88320, 0xFFFFFFFF) ^ 0xFFFFFFFF, 0xCBF43926); // CRC-32
+    ASSERT_EQUALS(crc32(check, 9, 0x04C11DB7, 0xFFFFFFFF), 0x0376E6E7); // CRC-32/MPEG-2
+
+    // Chained short calls run bitwise, the long call builds and uses a table
+    fprintf(stderr, "util::crc16(): table matches bitwise\n");
+    uint8_t long_msg[100];
+    for (unsigned i = 0; i < sizeof(long_msg); i++)
+        long_msg[i] = (uint8_t)(i * 37 + 11);
+    uint16_t chained = 0xFFFF;
+    for (unsigned i = 0; i < sizeof(long_msg); i += 20)
+        chained = crc16(&long_msg[i], 20, 0x1021, chained);
+    ASSERT_EQUALS(crc16(long_msg, sizeof(long_msg), 0x1021, 0xFFFF), chained);
+
     // sync-word 0b0 0xff 0b1 0b0 0x33 0b1 (i.e. 0x7fd99, note that 0x33 is 0xcc "on the wire")
     uint8_t uart[]   = {0x7f, 0xd9, 0x90};
     uint8_t bytes[6] = {0};
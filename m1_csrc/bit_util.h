@@ -144,6 +144,45 @@ uint16_t crc16lsb(uint8_t const message[], unsigned nBytes, uint16_t polynomial,
 /// @return CRC value
 uint16_t crc16(uint8_t const message[], unsigned nBytes, uint16_t polynomial, uint16_t init);
 
+/// CRC-32 LSB.
+/// Input and output are reflected, i.e. least significant bit is shifted in first.
+/// Note that poly and init already need to be reflected.
+///
+/// Example: CRC-32 (zlib) is crc32lsb(message, nBytes, 0xEDB88320, 0xFFFFFFFF) ^ 0xFFFFFFFF
+///
+/// @param message array of bytes to check
+/// @param nBytes number of bytes in message
+/// @param polynomial CRC polynomial
+/// @param init starting crc value
+/// @return CRC value
+uint32_t crc32lsb(uint8_t const message[], unsigned nBytes, uint32_t polynomial, uint32_t init);
+
+/// CRC-32.
+///
+/// @param message array of bytes to check
+/// @param nBytes number of bytes in message
+/// @param polynomial CRC polynomial
+/// @param init starting crc value
+/// @return CRC value
+uint32_t crc32(uint8_t const message[], unsigned nBytes, uint32_t polynomial, uint32_t init);
+
+/// Hardware CRC hook for long messages of crc8() to crc32lsb().
+///
+/// Messages of a few hundred bytes and more are offered to this function
+/// before the table driven CRC runs. The default does nothing and returns 0,
+/// a platform with a CRC engine overrides it.
+///
+/// @param width CRC width in bits: 8, 16 or 32
+/// @param lsb_first input and output are reflected
+/// @param polynomial CRC polynomial, not reflected
+/// @param init starting crc value, not reflected
+/// @param message array of bytes to check
+/// @param nBytes number of bytes in message
+/// @param[out] crc CRC value, reflected if lsb_first
+/// @return 1 if the CRC was calculated, 0 if the caller has to calculate it
+int crc_hw_calc(unsigned width, int lsb_first, uint32_t polynomial, uint32_t init,
+        uint8_t const message[], unsigned nBytes, uint32_t *crc);
+
 /// Digest-8 by "LFSR-based Toeplitz hash", bits MSB to LSB.
 ///
 /// @param message bytes of message data
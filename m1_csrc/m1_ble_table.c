@@ -0,0 +1,387 @@
+/* See COPYING.txt for license details. */
+
+/*
+*
+* m1_ble_table.c
+*
+* BLE scan device table
+*
+* M1 Project
+*
+*/
+
+/*************************** I N C L U D E S **********************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include "m1_ble_table.h"
+
+/*************************** D E F I N E S ************************************/
+
+#define BLE_SCAN_KEY			"+BLESCAN:"
+
+#define FNV_OFFSET_BASIS		0x811C9DC5u
+#define FNV_PRIME				0x01000193u
+
+#define HASH_MASK				(M1_BLE_TABLE_HASH_SIZE - 1)
+
+// AD types
+#define AD_NAME_SHORT			0x08
+#define AD_NAME_COMPLETE		0x09
+#define AD_MFG_DATA				0xFF
+
+//************************** C O N S T A N T **********************************/
+
+//************************** S T R U C T U R E S *******************************
+
+/***************************** V A R I A B L E S ******************************/
+
+/********************* F U N C T I O N   P R O T O T Y P E S ******************/
+
+void m1_ble_table_init(S_M1_Ble_Table *pt);
+bool m1_ble_report_parse(const char *line, S_M1_Ble_Report *prep);
+const S_M1_Ble_Dev *m1_ble_table_update(S_M1_Ble_Table *pt, const S_M1_Ble_Report *prep, uint32_t now_ms);
+const S_M1_Ble_Dev *m1_ble_table_find(const S_M1_Ble_Table *pt, const uint8_t *addr);
+uint8_t m1_ble_table_sort_rssi(const S_M1_Ble_Table *pt, uint8_t *order);
+int8_t m1_ble_dev_rssi_avg(const S_M1_Ble_Dev *pdev);
+static int8_t hex_nibble(char c);
+static const char *parse_hex(const char *p, uint8_t *pdata, uint8_t max, uint8_t *plen);
+static uint8_t addr_hash(const uint8_t *addr);
+static int16_t table_slot(const S_M1_Ble_Table *pt, const uint8_t *addr);
+static void table_unlink(S_M1_Ble_Table *pt, uint8_t slot);
+static void dev_ad_parse(S_M1_Ble_Dev *pdev, const uint8_t *pdata, uint8_t len);
+
+/*************** F U N C T I O N   I M P L E M E N T A T I O N ****************/
+
+void m1_ble_table_init(S_M1_Ble_Table *pt)
+{
+	memset(pt, 0, sizeof(*pt));
+} // void m1_ble_table_init(S_M1_Ble_Table *pt)
+
+
+
+static int8_t hex_nibble(char c)
+{
+	if ( c>='0' && c<='9' )
+		return c - '0';
+	if ( c>='a' && c<='f' )
+		return c - 'a' + 10;
+	if ( c>='A' && c<='F' )
+		return c - 'A' + 10;
+	return -1;
+} // static int8_t hex_nibble(char c)
+
+
+
+// Hex digits up to the next ',' or the end; NULL if malformed or longer than max
+static const char *parse_hex(const char *p, uint8_t *pdata, uint8_t max, uint8_t *plen)
+{
+	int8_t hi, lo;
+
+	*plen = 0;
+	while ( *p && *p!=',' )
+	{
+		hi = hex_nibble(p[0]);
+		lo = hex_nibble(p[1]);
+		if ( hi < 0 || lo < 0 || *plen==max )
+			return NULL;
+		pdata[(*plen)++] = (uint8_t)((hi << 4) | lo);
+		p += 2;
+	}
+
+	return p;
+} // static const char *parse_hex(const char *p, uint8_t *pdata, uint8_t max, uint8_t *plen)
+
+
+
+/*============================================================================*/
+/*
+ * This function parses one ESP-AT scan report line:
+ * +BLESCAN:"<addr>",<rssi>,<adv_data>,<scan_rsp_data>,<addr_type>[,<adv_type>]
+ * It returns false if the line is not a well formed report.
+ */
+/*============================================================================*/
+bool m1_ble_report_parse(const char *line, S_M1_Ble_Report *prep)
+{
+	const char *p;
+	char *end;
+	int8_t hi, lo;
+	uint8_t i;
+	long val;
+
+	if ( strncmp(line, BLE_SCAN_KEY, strlen(BLE_SCAN_KEY)) )
+		return false;
+	p = line + strlen(BLE_SCAN_KEY);
+	memset(prep, 0, sizeof(*prep));
+
+	if ( *p++!='"' )
+		return false;
+	for (i=0; i<M1_BLE_ADDR_LEN; i++)
+	{
+		hi = hex_nibble(p[0]);
+		lo = hex_nibble(p[1]);
+		if ( hi < 0 || lo < 0 || p[2]!=((i==M1_BLE_ADDR_LEN - 1) ? '"' : ':') )
+			return false;
+		prep->addr[i] = (uint8_t)((hi << 4) | lo);
+		p += 3;
+	} // for (i=0; ...)
+
+	if ( *p++!=',' )
+		return false;
+	val = strtol(p, &end, 10);
+	if ( end==p || *end!=',' || val < -128 || val > 0 )
+		return false;
+	prep->rssi = (int8_t)val;
+
+	p = parse_hex(end + 1, prep->adv, M1_BLE_ADV_DATA_MAX, &prep->adv_len);
+	if ( !p || *p++!=',' )
+		return false;
+	p = parse_hex(p, prep->rsp, M1_BLE_ADV_DATA_MAX, &prep->rsp_len);
+	if ( !p || *p++!=',' )
+		return false;
+
+	val = strtol(p, &end, 10);
+	if ( end==p || val < 0 || val > 1 )
+		return false;
+	prep->addr_type = (uint8_t)val;
+
+	// Older ESP-AT releases do not give the PDU type
+	prep->adv_type = prep->adv_len ? M1_BLE_ADV_IND : M1_BLE_ADV_SCAN_RSP;
+	if ( *end==',' )
+	{
+		p = end + 1;
+		val = strtol(p, &end, 10);
+		if ( end==p || val < 0 || val > M1_BLE_ADV_SCAN_RSP )
+			return false;
+		prep->adv_type = (uint8_t)val;
+	}
+
+	return true;
+} // bool m1_ble_report_parse(const char *line, S_M1_Ble_Report *prep)
+
+
+
+// FNV-1a of the address, folded to the hash index
+static uint8_t addr_hash(const uint8_t *addr)
+{
+	uint32_t hash = FNV_OFFSET_BASIS;
+	uint8_t i;
+
+	for (i=0; i<M1_BLE_ADDR_LEN; i++)
+	{
+		hash ^= addr[i];
+		hash *= FNV_PRIME;
+	}
+
+	return (uint8_t)((hash ^ (hash >> 16)) & HASH_MASK);
+} // static uint8_t addr_hash(const uint8_t *addr)
+
+
+
+// Hash slot of the address, -1 if it is not in the table
+static int16_t table_slot(const S_M1_Ble_Table *pt, const uint8_t *addr)
+{
+	uint8_t slot = addr_hash(addr);
+
+	while ( pt->hash[slot] )
+	{
+		if ( !memcmp(pt->dev[pt->hash[slot] - 1].addr, addr, M1_BLE_ADDR_LEN) )
+			return slot;
+		slot = (slot + 1) & HASH_MASK;
+	}
+
+	return -1;
+} // static int16_t table_slot(const S_M1_Ble_Table *pt, const uint8_t *addr)
+
+
+
+/*============================================================================*/
+/*
+ * This function empties a hash slot and moves the entries probed past it
+ * back, so that every lookup still finds its entry without tombstones.
+ */
+/*============================================================================*/
+static void table_unlink(S_M1_Ble_Table *pt, uint8_t slot)
+{
+	uint8_t next = slot, home;
+
+	pt->hash[slot] = 0;
+	for (;;)
+	{
+		next = (next + 1) & HASH_MASK;
+		if ( !pt->hash[next] )
+			break;
+		home = addr_hash(pt->dev[pt->hash[next] - 1].addr);
+		// The entry stays if its home slot is cyclically in (slot, next]
+		if ( ((next - home) & HASH_MASK) < ((next - slot) & HASH_MASK) )
+			continue;
+		pt->hash[slot] = pt->hash[next];
+		pt->hash[next] = 0;
+		slot = next;
+	} // for (;;)
+} // static void table_unlink(S_M1_Ble_Table *pt, uint8_t slot)
+
+
+
+// Name and manufacturer data out of the AD structures, kept if absent
+static void dev_ad_parse(S_M1_Ble_Dev *pdev, const uint8_t *pdata, uint8_t len)
+{
+	uint8_t pos = 0, ad_len, ad_type, n, i;
+
+	while ( pos + 1 < len )
+	{
+		ad_len = pdata[pos];
+		if ( !ad_len || pos + 1 + ad_len > len )
+			break;
+		ad_type = pdata[pos + 1];
+		n = ad_len - 1;
+
+		if ( ad_type==AD_NAME_COMPLETE || (ad_type==AD_NAME_SHORT && !pdev->name[0]) )
+		{
+			if ( n > M1_BLE_NAME_MAX )
+				n = M1_BLE_NAME_MAX;
+			for (i=0; i<n; i++)
+			{
+				char c = (char)pdata[pos + 2 + i];
+
+				pdev->name[i] = (c>=' ' && c<='~') ? c : '?';
+			}
+			pdev->name[n] = '\0';
+		}
+		else if ( ad_type==AD_MFG_DATA )
+		{
+			if ( n > M1_BLE_MFG_DATA_MAX )
+				n = M1_BLE_MFG_DATA_MAX;
+			memcpy(pdev->mfg, &pdata[pos + 2], n);
+			pdev->mfg_len = n;
+		}
+		pos += 1 + ad_len;
+	} // while ( pos + 1 < len )
+} // static void dev_ad_parse(S_M1_Ble_Dev *pdev, const uint8_t *pdata, uint8_t len)
+
+
+
+/*============================================================================*/
+/*
+ * This function adds one report to the device of its address, adding the
+ * device if it is new. It returns the device.
+ */
+/*============================================================================*/
+const S_M1_Ble_Dev *m1_ble_table_update(S_M1_Ble_Table *pt, const S_M1_Ble_Report *prep, uint32_t now_ms)
+{
+	S_M1_Ble_Dev *pdev;
+	int16_t slot;
+	uint8_t idx, i;
+
+	pt->reports++;
+	slot = table_slot(pt, prep->addr);
+	if ( slot >= 0 )
+	{
+		pdev = &pt->dev[pt->hash[slot] - 1];
+	}
+	else
+	{
+		if ( pt->count < M1_BLE_TABLE_SIZE )
+		{
+			idx = pt->count++;
+		}
+		else
+		{
+			// Full: the device heard least recently goes
+			idx = 0;
+			for (i=1; i<M1_BLE_TABLE_SIZE; i++)
+			{
+				if ( (int32_t)(pt->dev[i].last_ms - pt->dev[idx].last_ms) < 0 )
+					idx = i;
+			}
+			table_unlink(pt, (uint8_t)table_slot(pt, pt->dev[idx].addr));
+			pt->evictions++;
+		}
+
+		pdev = &pt->dev[idx];
+		memset(pdev, 0, sizeof(*pdev));
+		memcpy(pdev->addr, prep->addr, M1_BLE_ADDR_LEN);
+		pdev->adv_type = prep->adv_type;
+		pdev->rssi_min = prep->rssi;
+		pdev->rssi_max = prep->rssi;
+		pdev->first_ms = now_ms;
+
+		slot = addr_hash(prep->addr);
+		while ( pt->hash[slot] )
+			slot = (slot + 1) & HASH_MASK;
+		pt->hash[slot] = idx + 1;
+	} // else
+
+	pdev->addr_type = prep->addr_type;
+	if ( prep->adv_type==M1_BLE_ADV_SCAN_RSP )
+		pdev->scan_rsp = true;
+	else
+		pdev->adv_type = prep->adv_type;
+	pdev->rssi = prep->rssi;
+	if ( prep->rssi < pdev->rssi_min )
+		pdev->rssi_min = prep->rssi;
+	if ( prep->rssi > pdev->rssi_max )
+		pdev->rssi_max = prep->rssi;
+	pdev->rssi_sum += prep->rssi;
+	pdev->seen++;
+	pdev->last_ms = now_ms;
+	dev_ad_parse(pdev, prep->adv, prep->adv_len);
+	dev_ad_parse(pdev, prep->rsp, prep->rsp_len);
+
+	return pdev;
+} // const S_M1_Ble_Dev *m1_ble_table_update(S_M1_Ble_Table *pt, const S_M1_Ble_Report *prep, uint32_t now_ms)
+
+
+
+const S_M1_Ble_Dev *m1_ble_table_find(const S_M1_Ble_Table *pt, const uint8_t *addr)
+{
+	int16_t slot = table_slot(pt, addr);
+
+	return (slot < 0) ? NULL : &pt->dev[pt->hash[slot] - 1];
+} // const S_M1_Ble_Dev *m1_ble_table_find(const S_M1_Ble_Table *pt, const uint8_t *addr)
+
+
+
+/*============================================================================*/
+/*
+ * This function fills order with the device indexes, strongest last RSSI
+ * first and by address among equals so the list does not shuffle. It
+ * returns the number of devices.
+ */
+/*============================================================================*/
+uint8_t m1_ble_table_sort_rssi(const S_M1_Ble_Table *pt, uint8_t *order)
+{
+	const S_M1_Ble_Dev *pdev;
+	uint8_t i, j, idx;
+
+	for (i=0; i<pt->count; i++)
+	{
+		idx = i;
+		pdev = &pt->dev[idx];
+		for (j=i; j>0; j--)
+		{
+			const S_M1_Ble_Dev *pprev = &pt->dev[order[j - 1]];
+
+			if ( pprev->rssi > pdev->rssi
+					|| (pprev->rssi==pdev->rssi && memcmp(pprev->addr, pdev->addr, M1_BLE_ADDR_LEN) < 0) )
+				break;
+			order[j] = order[j - 1];
+		}
+		order[j] = idx;
+	} // for (i=0; ...)
+
+	return pt->count;
+} // uint8_t m1_ble_table_sort_rssi(const S_M1_Ble_Table *pt, uint8_t *order)
+
+
+
+// Rounded to the nearest dBm
+int8_t m1_ble_dev_rssi_avg(const S_M1_Ble_Dev *pdev)
+{
+	int32_t n = (int32_t)pdev->seen;
+
+	if ( !n )
+		return 0;
+
+	return (int8_t)((pdev->rssi_sum - n/2)/n); // The sum is never positive
+} // int8_t m1_ble_dev_rssi_avg(const S_M1_Ble_Dev *pdev)
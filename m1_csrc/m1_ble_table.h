@@ -0,0 +1,87 @@
+/* See COPYING.txt for license details. */
+
+/*
+*
+* m1_ble_table.h
+*
+* Header for the BLE scan device table
+*
+* A continuous scan reports the same devices over and over. The table keeps
+* one entry per address, found through a hash index, with the RSSI range,
+* when the device was last heard, its advertising type, name and
+* manufacturer data. When it is full, the device heard least recently makes
+* room for a new one.
+*
+* Reports come from ESP-AT +BLESCAN lines; times are in ms.
+*
+* M1 Project
+*
+*/
+
+#ifndef M1_BLE_TABLE_H_
+#define M1_BLE_TABLE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define M1_BLE_TABLE_SIZE			64
+#define M1_BLE_TABLE_HASH_SIZE		128 // Power of 2, twice the size keeps the probes short
+#define M1_BLE_ADDR_LEN				6
+#define M1_BLE_ADV_DATA_MAX			31 // Legacy advertising payload
+#define M1_BLE_NAME_MAX				20
+#define M1_BLE_MFG_DATA_MAX			24 // Company ID included
+
+// Advertising PDU types of +BLESCAN
+#define M1_BLE_ADV_IND				0
+#define M1_BLE_ADV_DIRECT_IND		1
+#define M1_BLE_ADV_SCAN_IND			2
+#define M1_BLE_ADV_NONCONN_IND		3
+#define M1_BLE_ADV_SCAN_RSP			4
+
+typedef struct
+{
+	uint8_t addr[M1_BLE_ADDR_LEN]; // As printed, most significant byte first
+	uint8_t addr_type; // 0 public, 1 random
+	uint8_t adv_type; // M1_BLE_ADV_x
+	int8_t rssi;
+	uint8_t adv_len;
+	uint8_t adv[M1_BLE_ADV_DATA_MAX];
+	uint8_t rsp_len;
+	uint8_t rsp[M1_BLE_ADV_DATA_MAX]; // Scan response
+} S_M1_Ble_Report;
+
+typedef struct
+{
+	uint8_t addr[M1_BLE_ADDR_LEN];
+	uint8_t addr_type;
+	uint8_t adv_type; // Of the last advertisement, scan responses do not tell it
+	bool scan_rsp; // Answered a scan request
+	int8_t rssi; // Last
+	int8_t rssi_min;
+	int8_t rssi_max;
+	int32_t rssi_sum; // Average: rssi_sum/seen
+	uint32_t seen; // Reports
+	uint32_t first_ms;
+	uint32_t last_ms;
+	char name[M1_BLE_NAME_MAX + 1]; // Complete or shortened local name, "" if none
+	uint8_t mfg_len; // Manufacturer specific data, 0 if none
+	uint8_t mfg[M1_BLE_MFG_DATA_MAX];
+} S_M1_Ble_Dev;
+
+typedef struct
+{
+	S_M1_Ble_Dev dev[M1_BLE_TABLE_SIZE];
+	uint8_t hash[M1_BLE_TABLE_HASH_SIZE]; // Linear probing, dev index + 1, 0 if empty
+	uint8_t count;
+	uint32_t reports;
+	uint32_t evictions;
+} S_M1_Ble_Table;
+
+void m1_ble_table_init(S_M1_Ble_Table *pt);
+bool m1_ble_report_parse(const char *line, S_M1_Ble_Report *prep);
+const S_M1_Ble_Dev *m1_ble_table_update(S_M1_Ble_Table *pt, const S_M1_Ble_Report *prep, uint32_t now_ms);
+const S_M1_Ble_Dev *m1_ble_table_find(const S_M1_Ble_Table *pt, const uint8_t *addr);
+uint8_t m1_ble_table_sort_rssi(const S_M1_Ble_Table *pt, uint8_t *order);
+int8_t m1_ble_dev_rssi_avg(const S_M1_Ble_Dev *pdev);
+
+#endif /* M1_BLE_TABLE_H_ */
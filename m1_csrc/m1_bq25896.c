@@ -222,6 +222,23 @@ uint8_t bq_stopADC(void)
 } // uint8_t bq_stopADC(void)
 
 
+/*============================================================================*/
+/*
+ * Description: Starts one ADC conversion, same as bq_startADC() with
+ * bq_oneShotADC() but with one register write
+ *
+ */
+/*============================================================================*/
+uint8_t bq_startOneShotADC(void)
+{
+	uint8_t reg = bq_readRegister(REG02_ADDR);
+	bq_setBit(&reg, REG02_CONV_START);
+	bq_unsetBit(&reg, REG02_CONV_RATE);
+
+	return bq_setRegister(REG02_ADDR, reg);
+} // uint8_t bq_startOneShotADC(void)
+
+
 /*============================================================================*/
 /*
  * Description: Force Input Detection
@@ -1128,6 +1145,28 @@ int bq_readRegister(uint8_t reg)
 } // int bq_readRegister(uint8_t reg)
 
 
+/*============================================================================*/
+/*
+ * Description: Reads count registers from reg on in one transaction
+ *
+ */
+/*============================================================================*/
+int bq_readRegisters(uint8_t reg, uint8_t *pdata, uint8_t count)
+{
+	S_M1_I2C_Trans_Inf i2c_inf;
+
+	i2c_inf.dev_id = I2C_DEVICE_BQ25896;
+	i2c_inf.timeout = I2C_READ_TIMEOUT;
+	i2c_inf.trans_type = I2C_TRANS_READ_REGISTER_MULTIPLE;
+	i2c_inf.reg_address = reg;
+	i2c_inf.pdata = pdata;
+	i2c_inf.data_len = count;
+	uint8_t stat = m1_i2c_hal_trans_req(&i2c_inf);
+
+	return (stat==HAL_OK);
+} // int bq_readRegisters(uint8_t reg, uint8_t *pdata, uint8_t count)
+
+
 /*============================================================================*/
 /*
  * Description:
@@ -168,6 +168,7 @@ uint8_t bq_startADC(void);
 uint8_t bq_oneShotADC(void);
 uint8_t bq_oneSecADC(void);
 uint8_t bq_stopADC(void);
+uint8_t bq_startOneShotADC(void);
 uint8_t bq_setFORCE_DPDM(void);
 uint8_t bq_unsetFORCE_DPDM(void);
 uint8_t bq_enableAUTO_DPDM(void);
@@ -226,6 +227,7 @@ int bq_getIDPM_LIM(void);
 int bq_reset(void);
 int bq_setRegister(uint8_t reg, uint8_t value);
 int bq_readRegister(uint8_t reg);
+int bq_readRegisters(uint8_t reg, uint8_t *pdata, uint8_t count);
 void bq_setBit(uint8_t *reg, uint8_t mask);
 void bq_unsetBit(uint8_t *reg, uint8_t mask);
 void bq_25896_init(void);
@@ -13,8 +13,11 @@
 
 /*************************** I N C L U D E S **********************************/
 #include <string.h>
+#include "FreeRTOS.h"
+#include "task.h"
 #include "m1_bq27421.h"
 #include "m1_i2c.h"
+#include "m1_low_power.h"
 
 /*************************** D E F I N E S ************************************/
 
@@ -46,6 +49,8 @@ static uint8_t Blockdata[32];
 /********************* F U N C T I O N   P R O T O T Y P E S ******************/
 
 static bool bq27421_i2c_command_read1( uint8_t command, uint8_t *data );
+static void bq27421_bus_free_delay(void);
+static uint16_t bq27421_block_word(const uint8_t *block, uint8_t command);
 
 static uint16_t bq27421_flags(void);
 static uint16_t bq27421_status(void);
@@ -105,7 +110,7 @@ HAL_StatusTypeDef bq27421_i2c_read(uint16_t NumberOfBytes, uint16_t RegAddress ,
 	i2c_inf.pdata = RxBuffer;
 	i2c_inf.data_len = NumberOfBytes;
 	stat = m1_i2c_hal_trans_req(&i2c_inf);
-	HAL_Delay( BQ27421_DELAY );
+	bq27421_bus_free_delay();
 
 	return stat;
 }
@@ -131,7 +136,7 @@ HAL_StatusTypeDef bq27421_i2c_write(uint16_t NumberOfBytes, uint16_t RegAddress
 	i2c_inf.data_len = NumberOfBytes;
 	stat = m1_i2c_hal_trans_req(&i2c_inf);
 
-	HAL_Delay( BQ27421_DELAY );
+	bq27421_bus_free_delay();
 
 	return stat;
 }
@@ -240,7 +245,7 @@ bool bq27421_i2c_control_read( uint16_t subcommand, uint16_t *data )
     	i2c_inf.data_len = 2;
 
     	stat = m1_i2c_hal_trans_req(&i2c_inf);
-    	HAL_Delay( BQ27421_DELAY );
+    	bq27421_bus_free_delay();
 
     	if(stat == HAL_OK )
         {
@@ -360,7 +365,7 @@ bool bq27421_init( uint16_t designCapacity_mAh, uint16_t terminateVoltage_mV, ui
     // Enable Block Data Memory Control
     bq27421_i2c_command_write( BQ27421_BLOCK_DATA_CONTROL, 0x00 );
 
-    HAL_Delay( BQ27421_DELAY );
+    bq27421_bus_free_delay();
 
     // Access State subclass
     bq27421_i2c_command_write( BQ27421_DATA_CLASS, 0x52 );
@@ -416,7 +421,7 @@ bool bq27421_init( uint16_t designCapacity_mAh, uint16_t terminateVoltage_mV, ui
     // Enable Block Data Memory Control
     bq27421_i2c_command_write( BQ27421_BLOCK_DATA_CONTROL, 0x00 );
 
-    HAL_Delay( BQ27421_DELAY );
+    bq27421_bus_free_delay();
 
     // Access State subclass
     bq27421_i2c_command_write( BQ27421_DATA_CLASS, 0x52 );
@@ -451,7 +456,7 @@ bool bq27421_init( uint16_t designCapacity_mAh, uint16_t terminateVoltage_mV, ui
     // Enable Block Data Memory Control
     bq27421_i2c_command_write( BQ27421_BLOCK_DATA_CONTROL, 0x00 );
 
-    HAL_Delay( BQ27421_DELAY );
+    bq27421_bus_free_delay();
 
     // Access Registers subclass
     bq27421_i2c_command_write( BQ27421_DATA_CLASS, 0x40 );
@@ -496,7 +501,7 @@ bool bq27421_init( uint16_t designCapacity_mAh, uint16_t terminateVoltage_mV, ui
     // Enable Block Data Memory Control
     bq27421_i2c_command_write( BQ27421_BLOCK_DATA_CONTROL, 0x00 );
 
-    HAL_Delay( BQ27421_DELAY );
+    bq27421_bus_free_delay();
 
     // Access Registers subclass
     bq27421_i2c_command_write( BQ27421_DATA_CLASS, 0x40 );
@@ -559,62 +564,37 @@ bool bq27421_init( uint16_t designCapacity_mAh, uint16_t terminateVoltage_mV, ui
 /*============================================================================*/
 bool bq27421_update( bq27421_info *battery )
 {
+    static uint16_t designCapacity_mAh; // Fixed, read once
+    uint8_t block[BQ27421_STANDARD_BURST_LEN];
     uint16_t temp;
 
-    if( !bq27421_readVoltage_mV( &(battery->voltage_mV) ) )
+    // One read of Temperature() to StateOfHealth() instead of one per command
+    if( bq27421_i2c_read( sizeof(block), BQ27421_TEMP_LOW, block )!=HAL_OK )
     {
         return false;
     }
-    if( !bq27421_readAvgCurrent_mA( &(battery->current_mA) ) )
-    {
-        return false;
-    }
-    if( !bq27421_readTemp_degK( &temp ) )
-    {
-        return false;
-    }
-    battery->temp_degC = ( (double)temp / 10 ) - 273.15;
 
-#if 0
-    if( !bq27421_readStateofCharge_percent( &(battery->soc_percent) ) )
-    {
-        return false;
-    }
-#endif
+    battery->voltage_mV = bq27421_block_word( block, BQ27421_VOLTAGE_LOW );
+    battery->current_mA = (int16_t)bq27421_block_word( block, BQ27421_AVG_CURRENT_LOW );
+    // Pairs the current with the time spent asleep since the last update
+    m1_low_power_add_current( battery->current_mA );
+    temp = bq27421_block_word( block, BQ27421_TEMP_LOW );
+    battery->temp_degC = ( (double)temp / 10 ) - 273.15;
 
-    battery->soc_percent = bq27421_soc(FILTERED);
-    battery->soh_state = bq27421_soh(SOH_STAT);
-    battery->soh_percent = bq27421_soh(PERCENT);
-#if 0
-    if(battery->soh_state)
-    {
-    	battery->soc_percent = bq27421_soc(FILTERED);
+    battery->soc_percent = bq27421_block_word( block, BQ27421_STATE_OF_CHARGE_LOW );
+    temp = bq27421_block_word( block, BQ27421_STATE_OF_HEALTH_LOW );
+    battery->soh_state = temp >> 8;
+    battery->soh_percent = temp & 0x00FF;
+    battery->remainingCapacity_mAh = bq27421_block_word( block, BQ27421_REMAINING_CAP_LOW );
+    battery->fullChargeCapacity_mAh = bq27421_block_word( block, BQ27421_FULL_CHARGE_CAP_LOW );
 
-    	if(battery->soh_state == 3)
-    		battery->soh_percent = bq27421_soh(PERCENT);
-    }
-#endif
-    //if( !bq27421_readStateofHealth_percent( &(battery->soh_percent) ) )
-    //{
-    //    return false;
-    //}
-    if( !bq27421_readDesignCapacity_mAh( &(battery->designCapacity_mAh) ) )
-    {
-        return false;
-    }
-    if( !bq27421_readRemainingCapacity_mAh( &(battery->remainingCapacity_mAh) ) )
-    {
-        return false;
-    }
-    if( !bq27421_readFullChargeCapacity_mAh( &(battery->fullChargeCapacity_mAh) ) )
-    {
-        return false;
-    }
-    if( !bq27421_readFlagsReg( &temp ) )
+    if( !designCapacity_mAh && !bq27421_readDesignCapacity_mAh( &designCapacity_mAh ) )
     {
         return false;
     }
+    battery->designCapacity_mAh = designCapacity_mAh;
 
+    temp = bq27421_block_word( block, BQ27421_FLAGS_LOW );
     battery->flags = temp;
     bq27421_readControlReg(&battery->status);
 
@@ -1601,3 +1581,34 @@ bool bq27421_writeExtendedData(uint8_t classID, uint8_t offset, uint8_t * data,
 	return true;
 }
 #endif
+
+
+
+/*============================================================================*/
+/**
+  * @brief  Waits the bus free time the gauge needs between transactions.
+  *         The calling task sleeps instead of spinning once the scheduler runs.
+  */
+/*============================================================================*/
+static void bq27421_bus_free_delay(void)
+{
+	if ( xTaskGetSchedulerState()==taskSCHEDULER_RUNNING )
+		vTaskDelay(pdMS_TO_TICKS(BQ27421_DELAY) + 1); // At least one full tick
+	else
+		HAL_Delay( BQ27421_DELAY );
+} // static void bq27421_bus_free_delay(void)
+
+
+
+/*============================================================================*/
+/**
+  * @brief  Returns a standard command value from a burst read that starts at
+  *         BQ27421_TEMP_LOW, the values are little endian
+  */
+/*============================================================================*/
+static uint16_t bq27421_block_word(const uint8_t *block, uint8_t command)
+{
+	command -= BQ27421_TEMP_LOW;
+
+	return ( block[command + 1] << 8 ) | block[command];
+} // static uint16_t bq27421_block_word(const uint8_t *block, uint8_t command)
@@ -57,6 +57,8 @@
 #define BQ27421_INT_TEMP_HIGH               0x1F
 #define BQ27421_STATE_OF_HEALTH_LOW         0x20
 #define BQ27421_STATE_OF_HEALTH_HIGH        0x21
+// Temperature() to StateOfHealth() in one read, the gauge increments the command
+#define BQ27421_STANDARD_BURST_LEN          (BQ27421_STATE_OF_HEALTH_HIGH - BQ27421_TEMP_LOW + 1)
 #define BQ27421_REMAINING_CAP_UNFILT_LOW    0x28
 #define BQ27421_REMAINING_CAP_UNFILT_HIGH   0x29
 #define BQ27421_REMAINING_CAP_FILT_LOW      0x2A
@@ -26,7 +26,10 @@
 #include "stm32h5xx_hal.h"
 #include "main.h"
 #include "m1_bt.h"
+#include "m1_ble_table.h"
+#include "m1_compositor.h"
 #include "m1_esp32_hal.h"
+#include "m1_wifi.h"
 #include "spi_master.h"
 #include "esp_app_main.h"
 #include "esp_at_list.h"
@@ -39,11 +42,36 @@
 
 #define M1_BLE_SCANNING_TIME		10 // seconds
 
+#define M1_BLE_SCAN_WINDOW_S		3 // The scan restarts after each window
+#define M1_BLE_SCAN_RESTART_MS		(M1_BLE_SCAN_WINDOW_S*1000 + 2000) // +BLESCANDONE lost
+#define M1_BLE_CMD_TIMEOUT_MS		2000
+#define M1_BLE_PUMP_MS				100
+#define M1_BLE_FRAME_MS				250 // Live list refresh
+#define M1_BLE_RX_BUF_SIZE			512
+#define M1_BLE_LINE_SIZE			192 // A report with both payloads is about 160 characters
+#define M1_BLE_LIST_ROWS			4
+#define M1_BLE_LIST_LABEL_LEN		16
+
 
 //************************** S T R U C T U R E S *******************************
 
+typedef struct
+{
+	uint8_t sel_addr[M1_BLE_ADDR_LEN]; // Selection follows the device as the list reorders
+	bool sel_valid;
+	uint8_t top; // First row shown
+	bool detail; // Selected device on its own
+	uint32_t scan_start_ms;
+	bool ok_seen; // Final response of the last command
+	bool error_seen;
+} S_M1_Ble_Scan_View;
+
 /***************************** V A R I A B L E S ******************************/
 
+// Static: the table does not fit the stack of the calling task
+static S_M1_Ble_Table ble_table;
+static uint8_t ble_order[M1_BLE_TABLE_SIZE];
+static char ble_rx_buf[M1_BLE_RX_BUF_SIZE];
 
 /********************* F U N C T I O N   P R O T O T Y P E S ******************/
 
@@ -51,8 +79,12 @@ void menu_bluetooth_init(void);
 void bluetooth_config(void);
 void bluetooth_scan(void);
 void bluetooth_advertise(void);
-static uint8_t ble_scan_list_validation(ctrl_cmd_t *app_resp);
-static uint16_t ble_scan_list_print(ctrl_cmd_t *app_resp, bool up_dir);
+static bool ble_scan_rx_line(S_M1_Ble_Scan_View *pview, const char *line, uint32_t now_ms);
+static bool ble_scan_pump(S_M1_Ble_Scan_View *pview, uint32_t wait_ms);
+static bool ble_scan_command(S_M1_Ble_Scan_View *pview, const char *cmd);
+static void ble_scan_start(S_M1_Ble_Scan_View *pview);
+static void ble_scan_list_print(S_M1_Ble_Scan_View *pview, int8_t move);
+static void ble_scan_dev_print(const S_M1_Ble_Dev *pdev);
 //extern void ble_app_main(void);
 extern void  esp32_main_init(void);
 
@@ -72,7 +104,9 @@ void menu_bluetooth_init(void)
 
 /*============================================================================*/
 /*
- * This function scans for devices.
+ * This function scans for devices until the user leaves: the reports go into
+ * a table of the devices heard, shown live by RSSI. OK shows the selected
+ * device.
  */
 /*============================================================================*/
 void bluetooth_scan(void)
@@ -80,8 +114,10 @@ void bluetooth_scan(void)
 	S_M1_Buttons_Status this_button_status;
 	S_M1_Main_Q_t q_item;
 	BaseType_t ret;
-	ctrl_cmd_t app_req = CTRL_CMD_DEFAULT_REQ();
-	uint16_t list_count;
+	S_M1_Ble_Scan_View view;
+	S_M1_Compositor comp;
+	uint8_t frame_param;
+	bool scanning = false;
 
     /* Graphic work starts here */
 	u8g2_SetFont(&m1_u8g2, M1_DISP_MAIN_MENU_FONT_N);
@@ -96,7 +132,9 @@ void bluetooth_scan(void)
 		m1_u8g2_nextpage();
 	}
 
-	list_count = 0;
+	memset(&view, 0, sizeof(view));
+	m1_ble_table_init(&ble_table);
+	m1_compositor_init(&comp, M1_BLE_FRAME_MS);
 
 	m1_u8g2_firstpage();
 	if ( get_esp32_main_init_status() )
@@ -105,15 +143,13 @@ void bluetooth_scan(void)
 		u8g2_DrawXBMP(&m1_u8g2, M1_LCD_DISPLAY_WIDTH/2 - 18/2, M1_LCD_DISPLAY_HEIGHT/2 - 2, 18, 32, hourglass_18x32);
 		m1_u8g2_nextpage();
 
-		// implemented synchronous
-		app_req.cmd_timeout_sec = M1_BLE_SCANNING_TIME; //DEFAULT_CTRL_RESP_TIMEOUT //30 sec
-		app_req.msg_id = CTRL_RESP_GET_BLE_SCAN_LIST;
-		ret = ble_scan_list(&app_req);
-		ret = ble_scan_list_validation(&app_req);
-		if ( ret )
+		// The scanner owns the AT link until it exits, a joined Wi-Fi network rides it out
+		wifi_at_lock();
+		scanning = ble_scan_command(&view, CONCAT_CMD_PARAM(ESP32C6_AT_REQ_BLE_MODE, ESP32C6_BLE_MODE_CLI));
+		if ( scanning )
 		{
-			list_count = ble_scan_list_print(&app_req, true);
-		} // if ( ret )
+			ble_scan_start(&view);
+		} // if ( scanning )
 		else
 		{
 			u8g2_SetDrawColor(&m1_u8g2, M1_DISP_DRAW_COLOR_BG);
@@ -128,6 +164,8 @@ void bluetooth_scan(void)
 			esp32_enable();
 			/* stop spi transactions short time to avoid slave sync issues */
 			m1_hard_delay(200);
+			wifi_sta_link_reset();
+			wifi_at_unlock();
 		}
 	} // if ( get_esp32_main_init_status() )
 	else
@@ -135,12 +173,21 @@ void bluetooth_scan(void)
 		u8g2_DrawStr(&m1_u8g2, 6, 15 + M1_GUI_ROW_SPACING + M1_GUI_FONT_HEIGHT, "ESP32 not ready!");
 		m1_u8g2_nextpage();
 	}
-	// mode declared in control.c should be set to MODE_STATION after M1 has been connected to a Wifi network
-	//mode |= MODE_STATION;
 
 	while (1 ) // Main loop of this task
 	{
-		ret = xQueueReceive(main_q_hdl, &q_item, portMAX_DELAY);
+		if ( scanning )
+		{
+			// Reports in, the list redrawn at most once per frame interval
+			if ( ble_scan_pump(&view, M1_BLE_PUMP_MS) )
+				m1_compositor_invalidate(&comp, 0, HAL_GetTick());
+			if ( (uint32_t)(HAL_GetTick() - view.scan_start_ms) >= M1_BLE_SCAN_RESTART_MS )
+				ble_scan_start(&view);
+			if ( m1_compositor_take(&comp, HAL_GetTick(), &frame_param) )
+				ble_scan_list_print(&view, 0);
+		} // if ( scanning )
+
+		ret = xQueueReceive(main_q_hdl, &q_item, scanning ? 0 : portMAX_DELAY);
 		if (ret==pdTRUE)
 		{
 			if ( q_item.q_evt_type==Q_EVENT_KEYPAD )
@@ -150,30 +197,43 @@ void bluetooth_scan(void)
 				ret = xQueueReceive(button_events_q_hdl, &this_button_status, 0);
 				if ( this_button_status.event[BUTTON_BACK_KP_ID]==BUTTON_EVENT_CLICK ) // user wants to exit?
 				{
-					; // Do extra tasks here if needed
-					if (app_req.u.wifi_ap_scan.out_list != NULL)
+					if ( view.detail )
 					{
-						free(app_req.u.wifi_ap_scan.out_list);
+						view.detail = false;
+						ble_scan_list_print(&view, 0);
+						m1_compositor_frame_done(&comp, HAL_GetTick());
+						continue;
+					}
+					if ( scanning )
+					{
+						ble_scan_command(&view, CONCAT_CMD_PARAM("AT+BLESCAN=", "0"));
+						wifi_at_unlock();
 					}
-					ble_scan_list_print(NULL, false);
 
 					xQueueReset(main_q_hdl); // Reset main q before return
-					m1_esp32_deinit();
+					if ( !wifi_sta_active() )
+						m1_esp32_deinit();
 					break; // Exit and return to the calling task (subfunc_handler_task)
 				} // if ( m1_buttons_status[BUTTON_BACK_KP_ID]==BUTTON_EVENT_CLICK )
+				else if ( !scanning )
+				{
+					; // Nothing to browse
+				}
 				else if ( this_button_status.event[BUTTON_UP_KP_ID]==BUTTON_EVENT_CLICK ) // go up?
 				{
-					if ( list_count )
-						ble_scan_list_print(&app_req, true);
+					ble_scan_list_print(&view, -1);
+					m1_compositor_frame_done(&comp, HAL_GetTick());
 				}
 				else if ( this_button_status.event[BUTTON_DOWN_KP_ID]==BUTTON_EVENT_CLICK ) // go down?
 				{
-					if ( list_count )
-						ble_scan_list_print(&app_req, false);
+					ble_scan_list_print(&view, 1);
+					m1_compositor_frame_done(&comp, HAL_GetTick());
 				}
 				else if ( this_button_status.event[BUTTON_OK_KP_ID]==BUTTON_EVENT_CLICK ) // Select?
 				{
-					; // Do other things for this task, if needed
+					view.detail = view.sel_valid;
+					ble_scan_list_print(&view, 0);
+					m1_compositor_frame_done(&comp, HAL_GetTick());
 				}
 			} // if ( q_item.q_evt_type==Q_EVENT_KEYPAD )
 			else
@@ -222,9 +282,12 @@ void bluetooth_advertise(void)
 		m1_u8g2_nextpage();
 
 		// implemented synchronous
+		// The restart drops a joined Wi-Fi network, the station manager rejoins after it
+		wifi_at_lock();
 		app_req.cmd_timeout_sec = M1_BLE_SCANNING_TIME; //DEFAULT_CTRL_RESP_TIMEOUT //30 sec
 		app_req.msg_id = CTRL_RESP_SET_BLE_RESET;
 		ret = esp_dev_reset(&app_req);
+		wifi_sta_link_reset();
 		app_req.msg_id = CTRL_RESP_SET_BLE_ADVERTISE;
 		ret = ble_advertise(&app_req);
 
@@ -274,7 +337,9 @@ void bluetooth_advertise(void)
 			esp32_enable();
 			/* stop spi transactions short time to avoid slave sync issues */
 			m1_hard_delay(200);
+			wifi_sta_link_reset();
 		}
+		wifi_at_unlock();
 	} // if ( get_esp32_main_init_status() )
 	else
 	{
@@ -300,12 +365,16 @@ void bluetooth_advertise(void)
 					u8g2_DrawXBMP(&m1_u8g2, M1_LCD_DISPLAY_WIDTH - 18*2, M1_LCD_DISPLAY_HEIGHT/2 - 2, 18, 32, hourglass_18x32);
 					m1_u8g2_nextpage();
 
+					wifi_at_lock();
 					app_req.cmd_timeout_sec = M1_BLE_SCANNING_TIME; //DEFAULT_CTRL_RESP_TIMEOUT //30 sec
 					app_req.msg_id = CTRL_RESP_SET_BLE_RESET;
 					ret = esp_dev_reset(&app_req);
+					wifi_sta_link_reset();
+					wifi_at_unlock();
 
 					xQueueReset(main_q_hdl); // Reset main q before return
-					m1_esp32_deinit();
+					if ( !wifi_sta_active() )
+						m1_esp32_deinit();
 					break; // Exit and return to the calling task (subfunc_handler_task)
 				} // if ( m1_buttons_status[BUTTON_BACK_KP_ID]==BUTTON_EVENT_CLICK )
 			} // if ( q_item.q_evt_type==Q_EVENT_KEYPAD )
@@ -373,134 +442,212 @@ void bluetooth_config(void)
 
 
 
+// Returns true if the line changed the device table
+static bool ble_scan_rx_line(S_M1_Ble_Scan_View *pview, const char *line, uint32_t now_ms)
+{
+	S_M1_Ble_Report rep;
+
+	if ( m1_ble_report_parse(line, &rep) )
+	{
+		m1_ble_table_update(&ble_table, &rep, now_ms);
+		return true;
+	}
+	if ( !strncmp(line, "+BLESCANDONE", strlen("+BLESCANDONE")) )
+		ble_scan_start(pview); // Next window
+	else if ( !strcmp(line, ESP32C6_AT_RES_OK) )
+		pview->ok_seen = true;
+	else if ( !strcmp(line, "ERROR") )
+		pview->error_seen = true;
+
+	return false;
+} // static bool ble_scan_rx_line(S_M1_Ble_Scan_View *pview, const char *line, uint32_t now_ms)
+
+
+
 /*============================================================================*/
 /*
- * This function validates the scan list.
+ * This function reads what the ESP32 sent within wait_ms and splits it into
+ * lines; a line may span two reads. It returns true if the table changed.
  */
 /*============================================================================*/
-static uint8_t ble_scan_list_validation(ctrl_cmd_t *app_resp)
+static bool ble_scan_pump(S_M1_Ble_Scan_View *pview, uint32_t wait_ms)
 {
-	if (!app_resp || (app_resp->msg_type != CTRL_RESP))
-	{
-		if (app_resp)
-			M1_LOG_D(M1_LOGDB_TAG, "Msg type is not response[%u]\n\r", app_resp->msg_type);
-		return false;
-	}
-	if (app_resp->resp_event_status != SUCCESS)
-	{
-		//process_failed_responses(app_resp);
+	static char line[M1_BLE_LINE_SIZE];
+	static uint16_t len = 0;
+	bool changed = false;
+	char *p;
+
+	if ( !esp_at_read_response(ble_rx_buf, sizeof(ble_rx_buf), wait_ms) )
 		return false;
-	}
-	if (app_resp->msg_id != CTRL_RESP_GET_BLE_SCAN_LIST)
+
+	for (p=ble_rx_buf; *p; p++)
 	{
-		M1_LOG_D(M1_LOGDB_TAG, "Invalid Response[%u] to parse\n\r", app_resp->msg_id);
+		if ( *p=='\n' )
+		{
+			line[len] = '\0';
+			changed |= ble_scan_rx_line(pview, line, HAL_GetTick());
+			len = 0;
+		}
+		else if ( *p!='\r' && len < sizeof(line) - 1 )
+		{
+			line[len++] = *p;
+		}
+	} // for (p=ble_rx_buf; *p; p++)
+
+	return changed;
+} // static bool ble_scan_pump(S_M1_Ble_Scan_View *pview, uint32_t wait_ms)
+
+
+
+// Sends a command and waits for its OK, the reports that come meanwhile are kept
+static bool ble_scan_command(S_M1_Ble_Scan_View *pview, const char *cmd)
+{
+	uint32_t t0 = HAL_GetTick();
+
+	pview->ok_seen = false;
+	pview->error_seen = false;
+	if ( esp_at_send_line(cmd)!=SUCCESS )
 		return false;
-	}
+	while ( !pview->ok_seen && !pview->error_seen && HAL_GetTick() - t0 < M1_BLE_CMD_TIMEOUT_MS )
+		ble_scan_pump(pview, M1_BLE_PUMP_MS);
 
-	return true;
-} // static uint8_t ble_scan_list_validation(ctrl_cmd_t *app_resp)
+	return pview->ok_seen;
+} // static bool ble_scan_command(S_M1_Ble_Scan_View *pview, const char *cmd)
 
 
 
+// Starts a scan window, its OK is not waited for
+static void ble_scan_start(S_M1_Ble_Scan_View *pview)
+{
+	char cmd[24];
+
+	sprintf(cmd, "%s%u%s", ESP32C6_AT_REQ_BLE_SCAN, M1_BLE_SCAN_WINDOW_S, ESP32C6_AT_REQ_CRLF);
+	pview->scan_start_ms = HAL_GetTick();
+	(void)esp_at_send_line(cmd);
+} // static void ble_scan_start(S_M1_Ble_Scan_View *pview)
+
+
 
 /*============================================================================*/
 /*
- * This function displays all scanned device list.
- * Return: number of devices found
+ * This function draws the devices heard, strongest first, with the selection
+ * moved by move rows. The selection stays on its device as the order
+ * changes.
  */
 /*============================================================================*/
-static uint16_t ble_scan_list_print(ctrl_cmd_t *app_resp, bool up_dir)
+static void ble_scan_list_print(S_M1_Ble_Scan_View *pview, int8_t move)
 {
-	static uint16_t i;
-	static wifi_ap_scan_list_t *w_scan_p;
-	static wifi_scanlist_t *list;
-	static bool init_done = false;
+	const S_M1_Ble_Dev *pdev;
 	char prn_msg[25];
-	uint8_t y_offset;
+	uint8_t count, pos, row, i, y_offset;
 
-	if ( !app_resp && !up_dir ) // reset condition?
-	{
-		init_done = false;
-		return 0;
-	} // if ( !app_resp && !up_dir )
+	count = m1_ble_table_sort_rssi(&ble_table, ble_order);
 
-	if ( !init_done )
+	pos = 0;
+	for (i=0; i<count && pview->sel_valid; i++)
 	{
-		init_done = true;
-		w_scan_p = &app_resp->u.wifi_ap_scan;
-		list = w_scan_p->out_list;
-
-		if (!w_scan_p->count)
+		if ( !memcmp(ble_table.dev[ble_order[i]].addr, pview->sel_addr, M1_BLE_ADDR_LEN) )
 		{
-			strcpy(prn_msg, "No device found!");
-			M1_LOG_D(M1_LOGDB_TAG, "No device found\n\r");
-			init_done = false;
+			pos = i;
+			break;
 		}
-		else if (!list)
-		{
-			strcpy(prn_msg, "Try again!");
-			M1_LOG_D(M1_LOGDB_TAG, "Failed to get scanned device list\n\r");
-			init_done = false;
-		}
-		else
-		{
-			M1_LOG_D(M1_LOGDB_TAG, "Number of available devices is %d\n\r", w_scan_p->count);
-		}
-
-		if ( !init_done )
-		{
-			u8g2_DrawStr(&m1_u8g2, 6, 25 + M1_GUI_ROW_SPACING + M1_GUI_FONT_HEIGHT, prn_msg);
-			m1_u8g2_nextpage(); // Update display RAM
-			return 0;
-		}
-		// Display first AP in the list
-		i = 1;
-		up_dir = true; // Overwrite the up_dir for the AP to be displayed for the first time
-	} // if ( !init_done )
-
-	if ( up_dir )
-	{
-		if ( i )
-			i--;
-		else
-			i = w_scan_p->count-1; // roll over
 	}
-	else
+	if ( count )
 	{
-		i++;
-		if ( i >= w_scan_p->count )
-			i = 0; // roll over
+		if ( move < 0 )
+			pos = pos ? pos - 1 : count - 1; // roll over
+		else if ( move > 0 )
+			pos = (pos + 1 < count) ? pos + 1 : 0; // roll over
+		memcpy(pview->sel_addr, ble_table.dev[ble_order[pos]].addr, M1_BLE_ADDR_LEN);
+		pview->sel_valid = true;
 	}
 
 	m1_u8g2_firstpage();
-	u8g2_DrawXBMP(&m1_u8g2, 0, 0, 128, 14, m1_frame_128_14);
-	u8g2_DrawStr(&m1_u8g2, 2, M1_GUI_ROW_SPACING + M1_GUI_FONT_HEIGHT, "Total Dev:");
-
-	sprintf(prn_msg, "%d", w_scan_p->count);
-	u8g2_DrawStr(&m1_u8g2, 2 + strlen("Total Dev: ")*M1_GUI_FONT_WIDTH + 2, M1_GUI_ROW_SPACING + M1_GUI_FONT_HEIGHT, prn_msg);
+	if ( pview->detail && count )
+	{
+		ble_scan_dev_print(&ble_table.dev[ble_order[pos]]);
+		m1_u8g2_nextpage(); // Update display RAM
+		return;
+	}
 
-	sprintf(prn_msg, "%d/%d", i + 1, w_scan_p->count); // Current AP
+	u8g2_DrawXBMP(&m1_u8g2, 0, 0, 128, 14, m1_frame_128_14);
+	sprintf(prn_msg, "Total Dev: %u", count);
+	u8g2_DrawStr(&m1_u8g2, 2, M1_GUI_ROW_SPACING + M1_GUI_FONT_HEIGHT, prn_msg);
+	if ( !count )
+	{
+		u8g2_DrawStr(&m1_u8g2, 6, 25 + M1_GUI_ROW_SPACING + M1_GUI_FONT_HEIGHT, "No device found!");
+		m1_u8g2_nextpage(); // Update display RAM
+		return;
+	}
+	sprintf(prn_msg, "%u/%u", pos + 1, count); // Current device
 	u8g2_DrawStr(&m1_u8g2, M1_LCD_DISPLAY_WIDTH - 6*M1_GUI_FONT_WIDTH, M1_GUI_ROW_SPACING + M1_GUI_FONT_HEIGHT, prn_msg);
 
+	// Keep the selection in the window
+	if ( pview->top > pos )
+		pview->top = pos;
+	else if ( pos >= pview->top + M1_BLE_LIST_ROWS )
+		pview->top = pos - M1_BLE_LIST_ROWS + 1;
+	if ( pview->top + M1_BLE_LIST_ROWS > count )
+		pview->top = (count > M1_BLE_LIST_ROWS) ? count - M1_BLE_LIST_ROWS : 0;
+
 	y_offset = 14 + M1_GUI_FONT_HEIGHT - 1;
-	// Format BSSID to hex string (XX:XX:XX:XX:XX:XX)
-    char bssid_str[18];
-    snprintf(bssid_str, sizeof(bssid_str), "%02X:%02X:%02X:%02X:%02X:%02X",
-            list[i].bssid[0], list[i].bssid[1], list[i].bssid[2],
-            list[i].bssid[3], list[i].bssid[4], list[i].bssid[5]);
-	// Draw text
-	u8g2_DrawStr(&m1_u8g2, 2, y_offset, bssid_str);
-	y_offset += M1_GUI_FONT_HEIGHT + M1_GUI_ROW_SPACING;
-	sprintf(prn_msg, "RSSI: %ddBm", list[i].rssi);
-	u8g2_DrawStr(&m1_u8g2, 2, y_offset, prn_msg);
-	y_offset += M1_GUI_FONT_HEIGHT;
-	sprintf(prn_msg, "Address type: %d", list[i].encryption_mode);
-	u8g2_DrawStr(&m1_u8g2, 2, y_offset, prn_msg);
+	for (row=0; row<M1_BLE_LIST_ROWS && pview->top + row < count; row++)
+	{
+		pdev = &ble_table.dev[ble_order[pview->top + row]];
+		if ( pdev->name[0] )
+			snprintf(prn_msg, M1_BLE_LIST_LABEL_LEN + 1, "%s", pdev->name);
+		else
+			sprintf(prn_msg, "%02X:%02X:%02X:%02X:%02X", pdev->addr[1], pdev->addr[2],
+					pdev->addr[3], pdev->addr[4], pdev->addr[5]);
+		if ( pview->top + row==pos )
+		{
+			u8g2_DrawBox(&m1_u8g2, 0, y_offset - M1_GUI_FONT_HEIGHT + 2, M1_LCD_DISPLAY_WIDTH, M1_GUI_FONT_HEIGHT);
+			u8g2_SetDrawColor(&m1_u8g2, M1_DISP_DRAW_COLOR_BG);
+		}
+		u8g2_DrawStr(&m1_u8g2, 2, y_offset, prn_msg);
+		sprintf(prn_msg, "%d", pdev->rssi);
+		u8g2_DrawStr(&m1_u8g2, M1_LCD_DISPLAY_WIDTH - 4*M1_GUI_FONT_WIDTH, y_offset, prn_msg);
+		u8g2_SetDrawColor(&m1_u8g2, M1_DISP_DRAW_COLOR_TXT);
+		y_offset += M1_GUI_FONT_HEIGHT + M1_GUI_ROW_SPACING;
+	} // for (row=0; ...)
 
 	m1_u8g2_nextpage(); // Update display RAM
+} // static void ble_scan_list_print(S_M1_Ble_Scan_View *pview, int8_t move)
+
 
-	M1_LOG_D(M1_LOGDB_TAG, "%d) bssid \"%s\" rssi \"%d\" address type \"%d\" \n\r",\
-						i, list[i].bssid, list[i].rssi, list[i].encryption_mode);
 
-	return w_scan_p->count;
-} // static uint16_t ble_scan_list_print(ctrl_cmd_t *app_resp, bool up_dir)
+// One device: address, RSSI range and average, when it was heard, what it sends
+static void ble_scan_dev_print(const S_M1_Ble_Dev *pdev)
+{
+	static const char * const adv_type_str[] = {"Conn", "Direct", "Scannable", "Non-conn", "Scan rsp"};
+	char prn_msg[25];
+	uint8_t y_offset, i, n;
+
+	u8g2_DrawXBMP(&m1_u8g2, 0, 0, 128, 14, m1_frame_128_14);
+	u8g2_DrawStr(&m1_u8g2, 2, M1_GUI_ROW_SPACING + M1_GUI_FONT_HEIGHT, pdev->name[0] ? pdev->name : "(no name)");
+
+	y_offset = 14 + M1_GUI_FONT_HEIGHT - 1;
+	sprintf(prn_msg, "%02X:%02X:%02X:%02X:%02X:%02X %c", pdev->addr[0], pdev->addr[1], pdev->addr[2],
+			pdev->addr[3], pdev->addr[4], pdev->addr[5], pdev->addr_type ? 'R' : 'P');
+	u8g2_DrawStr(&m1_u8g2, 2, y_offset, prn_msg);
+	y_offset += M1_GUI_FONT_HEIGHT;
+	sprintf(prn_msg, "%d avg%d %d..%d", pdev->rssi, m1_ble_dev_rssi_avg(pdev), pdev->rssi_min, pdev->rssi_max);
+	u8g2_DrawStr(&m1_u8g2, 2, y_offset, prn_msg);
+	y_offset += M1_GUI_FONT_HEIGHT;
+	sprintf(prn_msg, "%s x%lu %lus", adv_type_str[pdev->adv_type], (unsigned long)pdev->seen,
+			(unsigned long)((HAL_GetTick() - pdev->last_ms)/1000));
+	u8g2_DrawStr(&m1_u8g2, 2, y_offset, prn_msg);
+	y_offset += M1_GUI_FONT_HEIGHT;
+	if ( pdev->mfg_len >= 2 )
+	{
+		// Company ID first, little endian, then as much data as fits
+		n = sprintf(prn_msg, "Mfg %04X ", pdev->mfg[0] | (pdev->mfg[1] << 8));
+		for (i=2; i<pdev->mfg_len && n + 2 < 21; i++)
+			n += sprintf(&prn_msg[n], "%02X", pdev->mfg[i]);
+	}
+	else
+	{
+		strcpy(prn_msg, "No mfg data");
+	}
+	u8g2_DrawStr(&m1_u8g2, 2, y_offset, prn_msg);
+} // static void ble_scan_dev_print(const S_M1_Ble_Dev *pdev)
@@ -0,0 +1,312 @@
+/* See COPYING.txt for license details. */
+
+/*
+*
+* m1_cdc_stream.c
+*
+* Binary edge timing stream over USB CDC
+*
+* M1 Project
+*
+*/
+
+/*************************** I N C L U D E S **********************************/
+
+#include <stdint.h>
+#include <string.h>
+#include "stm32h5xx_hal.h"
+#include "main.h"
+#include "bit_util.h"
+#include "m1_cdc_stream.h"
+
+/*************************** D E F I N E S ************************************/
+
+#define CDC_STREAM_CRC_POLY			0x1021
+#define CDC_STREAM_CRC_INIT			0xFFFF
+
+//************************** C O N S T A N T **********************************/
+
+static const char *const cdc_stream_source_names[CDC_STREAM_SRC_EOL] = {
+	"off", "subghz", "lfrfid", "ir"
+};
+
+//************************** S T R U C T U R E S *******************************
+
+/***************************** V A R I A B L E S ******************************/
+
+// 32-byte aligned for the USB DMA and the D-cache
+static uint8_t cdc_stream_buf[2][CDC_STREAM_BUF_SIZE] __attribute__((aligned(32)));
+static uint8_t cdc_stream_fill_idx; // Buffer being filled, the other one may be on the wire
+static uint16_t cdc_stream_fill_samples;
+static uint32_t cdc_stream_fill_tick; // Tick of the first sample in the fill buffer
+static volatile uint8_t cdc_stream_src = CDC_STREAM_SRC_NONE;
+static volatile bool cdc_stream_tx_busy;
+static uint16_t cdc_stream_seq;
+static uint32_t cdc_stream_info;
+static S_M1_CdcStream_Stats cdc_stream_stats;
+static m1_cdc_stream_tx_fn cdc_stream_tx;
+
+/********************* F U N C T I O N   P R O T O T Y P E S ******************/
+
+void m1_cdc_stream_init(m1_cdc_stream_tx_fn tx);
+void m1_cdc_stream_start(S_M1_CdcStream_Source source);
+void m1_cdc_stream_stop(void);
+S_M1_CdcStream_Source m1_cdc_stream_source(void);
+void m1_cdc_stream_set_info(uint32_t info);
+void m1_cdc_stream_put(uint32_t duration_us, bool level);
+bool m1_cdc_stream_put_pulses(const uint16_t *pulses, uint16_t n_pulses, bool level);
+void m1_cdc_stream_flush(bool force);
+bool m1_cdc_stream_tx_done(const uint8_t *buf);
+void m1_cdc_stream_get_stats(S_M1_CdcStream_Stats *pstats);
+const char *m1_cdc_stream_source_name(S_M1_CdcStream_Source source);
+static bool cdc_stream_send(void);
+static void cdc_stream_add_sample(uint16_t sample);
+
+/*************** F U N C T I O N   I M P L E M E N T A T I O N ****************/
+
+/*============================================================================*/
+/*
+ * This function sets the function that starts the USB transfers.
+ */
+/*============================================================================*/
+void m1_cdc_stream_init(m1_cdc_stream_tx_fn tx)
+{
+	cdc_stream_tx = tx;
+} // void m1_cdc_stream_init(m1_cdc_stream_tx_fn tx)
+
+
+
+/*============================================================================*/
+/*
+ * This function starts a new stream of the given source. Samples still
+ * waiting from a previous stream are discarded.
+ */
+/*============================================================================*/
+void m1_cdc_stream_start(S_M1_CdcStream_Source source)
+{
+	if ( source >= CDC_STREAM_SRC_EOL )
+		source = CDC_STREAM_SRC_NONE;
+
+	cdc_stream_src = CDC_STREAM_SRC_NONE;
+	cdc_stream_fill_samples = 0;
+	cdc_stream_seq = 0;
+	cdc_stream_info = 0;
+	// A transfer lost to a USB reset never completes, the driver refuses new
+	// ones while it is really busy
+	cdc_stream_tx_busy = false;
+	memset(&cdc_stream_stats, 0, sizeof(cdc_stream_stats));
+	cdc_stream_src = source;
+} // void m1_cdc_stream_start(S_M1_CdcStream_Source source)
+
+
+
+/*============================================================================*/
+/*
+ * This function ends the stream, samples not sent yet are discarded.
+ */
+/*============================================================================*/
+void m1_cdc_stream_stop(void)
+{
+	cdc_stream_src = CDC_STREAM_SRC_NONE;
+} // void m1_cdc_stream_stop(void)
+
+
+
+/*============================================================================*/
+/*
+ * This function returns the source being streamed, CDC_STREAM_SRC_NONE if
+ * the stream is off.
+ */
+/*============================================================================*/
+S_M1_CdcStream_Source m1_cdc_stream_source(void)
+{
+	return (S_M1_CdcStream_Source)cdc_stream_src;
+} // S_M1_CdcStream_Source m1_cdc_stream_source(void)
+
+
+
+/*============================================================================*/
+/*
+ * This function sets the info field of the following packets.
+ */
+/*============================================================================*/
+void m1_cdc_stream_set_info(uint32_t info)
+{
+	cdc_stream_info = info;
+} // void m1_cdc_stream_set_info(uint32_t info)
+
+
+
+/*============================================================================*/
+/*
+ * This function adds the time the line stayed at the given level.
+ */
+/*============================================================================*/
+void m1_cdc_stream_put(uint32_t duration_us, bool level)
+{
+	uint16_t level_bit;
+
+	if ( cdc_stream_src==CDC_STREAM_SRC_NONE || duration_us==0 )
+		return;
+
+	level_bit = level ? CDC_STREAM_LEVEL_BIT : 0;
+	while ( duration_us > CDC_STREAM_DURATION_MAX )
+	{
+		cdc_stream_add_sample(level_bit | CDC_STREAM_DURATION_MAX);
+		duration_us -= CDC_STREAM_DURATION_MAX;
+	}
+	cdc_stream_add_sample(level_bit | (uint16_t)duration_us);
+} // void m1_cdc_stream_put(uint32_t duration_us, bool level)
+
+
+
+/*============================================================================*/
+/*
+ * This function adds pulses of alternating levels, the first one at the
+ * given level. It returns the level of the pulse that would follow.
+ */
+/*============================================================================*/
+bool m1_cdc_stream_put_pulses(const uint16_t *pulses, uint16_t n_pulses, bool level)
+{
+	uint16_t i;
+
+	for (i=0; i<n_pulses; i++)
+	{
+		m1_cdc_stream_put(pulses[i], level);
+		level = !level;
+	}
+
+	return level;
+} // bool m1_cdc_stream_put_pulses(const uint16_t *pulses, uint16_t n_pulses, bool level)
+
+
+
+/*============================================================================*/
+/*
+ * This function sends the samples collected so far if they have waited for
+ * CDC_STREAM_FLUSH_MS, or at once if force is set. Capture tasks call it
+ * when their input goes quiet so the last samples are not held back.
+ */
+/*============================================================================*/
+void m1_cdc_stream_flush(bool force)
+{
+	if ( cdc_stream_src==CDC_STREAM_SRC_NONE || cdc_stream_fill_samples==0 )
+		return;
+
+	if ( force || (HAL_GetTick() - cdc_stream_fill_tick) >= CDC_STREAM_FLUSH_MS )
+		cdc_stream_send();
+} // void m1_cdc_stream_flush(bool force)
+
+
+
+/*============================================================================*/
+/*
+ * This function is called from the USB transfer complete callback.
+ * It returns true if buf is one of the stream buffers.
+ */
+/*============================================================================*/
+bool m1_cdc_stream_tx_done(const uint8_t *buf)
+{
+	if ( buf!=cdc_stream_buf[0] && buf!=cdc_stream_buf[1] )
+		return false;
+
+	cdc_stream_tx_busy = false;
+
+	return true;
+} // bool m1_cdc_stream_tx_done(const uint8_t *buf)
+
+
+
+void m1_cdc_stream_get_stats(S_M1_CdcStream_Stats *pstats)
+{
+	*pstats = cdc_stream_stats;
+} // void m1_cdc_stream_get_stats(S_M1_CdcStream_Stats *pstats)
+
+
+
+const char *m1_cdc_stream_source_name(S_M1_CdcStream_Source source)
+{
+	return (source < CDC_STREAM_SRC_EOL) ? cdc_stream_source_names[source] : "?";
+} // const char *m1_cdc_stream_source_name(S_M1_CdcStream_Source source)
+
+
+
+/*============================================================================*/
+/*
+ * This function adds one sample to the fill buffer. A full buffer is sent
+ * first, if that is not possible yet the sample is dropped.
+ */
+/*============================================================================*/
+static void cdc_stream_add_sample(uint16_t sample)
+{
+	uint8_t *pdata;
+
+	if ( cdc_stream_fill_samples >= CDC_STREAM_SAMPLES_MAX && !cdc_stream_send() )
+	{
+		cdc_stream_stats.dropped++;
+		return;
+	}
+
+	if ( cdc_stream_fill_samples==0 )
+		cdc_stream_fill_tick = HAL_GetTick();
+
+	pdata = &cdc_stream_buf[cdc_stream_fill_idx][sizeof(S_M1_CdcStream_Header) + cdc_stream_fill_samples*sizeof(uint16_t)];
+	pdata[0] = (uint8_t)sample;
+	pdata[1] = (uint8_t)(sample >> 8);
+	cdc_stream_fill_samples++;
+
+	if ( cdc_stream_fill_samples >= CDC_STREAM_SAMPLES_MAX )
+		cdc_stream_send(); // Send right away, this frees the buffer earliest
+} // static void cdc_stream_add_sample(uint16_t sample)
+
+
+
+/*============================================================================*/
+/*
+ * This function completes the packet in the fill buffer and hands it to USB.
+ * It returns false if the other buffer is still on the wire or USB refused
+ * the transfer, the samples then stay in the fill buffer.
+ */
+/*============================================================================*/
+static bool cdc_stream_send(void)
+{
+	S_M1_CdcStream_Header header;
+	uint8_t *pbuf;
+	uint16_t len, crc;
+
+	if ( cdc_stream_tx_busy || cdc_stream_tx==NULL )
+		return false;
+
+	pbuf = cdc_stream_buf[cdc_stream_fill_idx];
+	header.sync = CDC_STREAM_SYNC;
+	header.version = CDC_STREAM_VERSION;
+	header.source = cdc_stream_src;
+	header.seq = cdc_stream_seq;
+	header.n_samples = cdc_stream_fill_samples;
+	header.dropped = cdc_stream_stats.dropped;
+	header.time_ms = cdc_stream_fill_tick;
+	header.info = cdc_stream_info;
+	memcpy(pbuf, &header, sizeof(header)); // The target is little endian like the wire format
+
+	len = sizeof(header) + cdc_stream_fill_samples*sizeof(uint16_t);
+	crc = crc16(pbuf, len, CDC_STREAM_CRC_POLY, CDC_STREAM_CRC_INIT);
+	pbuf[len++] = (uint8_t)crc;
+	pbuf[len++] = (uint8_t)(crc >> 8);
+
+	// Set before the transfer starts, it may complete before the call returns
+	cdc_stream_tx_busy = true;
+	if ( cdc_stream_tx(pbuf, len)!=0 )
+	{
+		cdc_stream_tx_busy = false;
+		cdc_stream_stats.tx_errors++;
+		return false;
+	}
+
+	cdc_stream_stats.packets++;
+	cdc_stream_stats.samples += cdc_stream_fill_samples;
+	cdc_stream_seq++;
+	cdc_stream_fill_idx ^= 1;
+	cdc_stream_fill_samples = 0;
+
+	return true;
+} // static bool cdc_stream_send(void)
@@ -0,0 +1,92 @@
+/* See COPYING.txt for license details. */
+
+/*
+*
+* m1_cdc_stream.h
+*
+* Header for the binary edge timing stream over USB CDC
+*
+* Live Sub-GHz, LF RFID or IR captures are sent to the host as framed
+* packets of edge durations instead of text. Samples are collected in one of
+* two packet buffers while the other one is on the wire, a packet goes out
+* when its buffer is full, when it has waited CDC_STREAM_FLUSH_MS or on a
+* forced flush. tools/cdc_stream_rx.py receives the packets on the host and
+* writes them to capture files.
+*
+* Packet, all fields little endian:
+*   S_M1_CdcStream_Header
+*   n_samples x uint16_t, bit 15 the line level, bits 14..0 the duration in us
+*   uint16_t CRC-16/CCITT-FALSE (0x1021, init 0xFFFF) of header and samples
+*
+* Durations longer than CDC_STREAM_DURATION_MAX are sent as several samples
+* of the same level.
+*
+* M1 Project
+*
+*/
+
+#ifndef M1_CDC_STREAM_H_
+#define M1_CDC_STREAM_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define CDC_STREAM_SYNC				0x314D	// "M1" on the wire
+#define CDC_STREAM_VERSION			1
+#define CDC_STREAM_BUF_SIZE			4096	// Bytes per packet buffer, one packet per USB transfer
+#define CDC_STREAM_FLUSH_MS			50		// Longest time a sample waits for its packet to be sent
+#define CDC_STREAM_LEVEL_BIT		0x8000
+#define CDC_STREAM_DURATION_MAX		0x7FFF
+#define CDC_STREAM_CRC_SIZE			2
+#define CDC_STREAM_SAMPLES_MAX		((CDC_STREAM_BUF_SIZE - sizeof(S_M1_CdcStream_Header) - CDC_STREAM_CRC_SIZE)/sizeof(uint16_t))
+
+typedef enum
+{
+	CDC_STREAM_SRC_NONE = 0,
+	CDC_STREAM_SRC_SUBGHZ,
+	CDC_STREAM_SRC_LFRFID,
+	CDC_STREAM_SRC_IR,
+	CDC_STREAM_SRC_EOL
+} S_M1_CdcStream_Source;
+
+typedef struct __attribute__((packed))
+{
+	uint16_t sync; // CDC_STREAM_SYNC
+	uint8_t version; // CDC_STREAM_VERSION
+	uint8_t source; // S_M1_CdcStream_Source
+	uint16_t seq; // Packet counter, gaps show lost packets
+	uint16_t n_samples; // Samples following the header
+	uint32_t dropped; // Samples lost on the device since the stream started
+	uint32_t time_ms; // Tick of the first sample
+	uint32_t info; // Source parameter, e.g. the Sub-GHz frequency in Hz, 0 if unknown
+} S_M1_CdcStream_Header;
+
+typedef struct
+{
+	uint32_t packets; // Packets handed to USB
+	uint32_t samples; // Samples in those packets
+	uint32_t dropped; // Samples lost because both buffers were busy
+	uint32_t tx_errors; // Transfers USB refused, the packet was sent later
+} S_M1_CdcStream_Stats;
+
+// Starts a transfer of len bytes from buf, returns 0 if it was started
+typedef uint8_t (*m1_cdc_stream_tx_fn)(uint8_t *buf, uint16_t len);
+
+/*
+ * m1_cdc_stream_put(), m1_cdc_stream_put_pulses() and m1_cdc_stream_flush()
+ * are called by the one task that captures the current source.
+ * m1_cdc_stream_tx_done() is called from the USB transfer complete callback.
+ */
+void m1_cdc_stream_init(m1_cdc_stream_tx_fn tx);
+void m1_cdc_stream_start(S_M1_CdcStream_Source source);
+void m1_cdc_stream_stop(void);
+S_M1_CdcStream_Source m1_cdc_stream_source(void);
+void m1_cdc_stream_set_info(uint32_t info);
+void m1_cdc_stream_put(uint32_t duration_us, bool level);
+bool m1_cdc_stream_put_pulses(const uint16_t *pulses, uint16_t n_pulses, bool level);
+void m1_cdc_stream_flush(bool force);
+bool m1_cdc_stream_tx_done(const uint8_t *buf);
+void m1_cdc_stream_get_stats(S_M1_CdcStream_Stats *pstats);
+const char *m1_cdc_stream_source_name(S_M1_CdcStream_Source source);
+
+#endif /* M1_CDC_STREAM_H_ */
@@ -27,6 +27,7 @@
 #include "m1_sdcard.h"
 #include "m1_sub_ghz_api.h"
 #include "m1_virtual_kb.h"
+#include "m1_wifi.h"
 #include "main.h"
 #include "stdbool.h"
 #include "stdio.h"
@@ -37,6 +38,7 @@
 // #include "app_main.h"
 #include "battery.h"
 #include "ctrl_api.h"
+#include "esp_app_main.h"
 #include "m1_bq25896.h"
 #include "m1_bq27421.h"
 #include "m1_fusb302.h"
@@ -55,6 +57,9 @@
 
 #define INPUT_PARAMS_MAX 5
 
+#define CLI_ESP_AT_RESP_TIMEOUT_MS 5000
+#define CLI_ESP_AT_RESP_SIZE 256
+
 //************************** C O N S T A N T **********************************/
 
 const osThreadAttr_t cmdLineTask_attributes = {
@@ -89,6 +94,7 @@ void cmd_m1_mtest_subghz(char *pconsole, char *input_params[], uint8_t n_params,
                          uint8_t cmd_type);
 void cmd_m1_mtest_esp32(char *pconsole, char *input_params[], uint8_t n_params,
                         uint8_t cmd_type);
+static void cli_esp_at_passthrough(const char *at_cmd);
 void cmd_m1_mtest_gpio(char *pconsole, char *input_params[], uint8_t n_params,
                        uint8_t cmd_type);
 void cmd_m1_mtest_nfc(char *pconsole, char *input_params[], uint8_t n_params,
@@ -962,6 +968,36 @@ void cmd_m1_mtest_subghz(char *pconsole, char *input_params[], uint8_t n_params,
 } // void cmd_m1_mtest_subghz(char *pconsole, char *input_params[], uint8_t
   // n_params, uint8_t cmd_type)
 
+/*============================================================================*/
+/*
+ * This function sends an AT command line and logs the response blocks until
+ * the final OK or ERROR. The AT link is held meanwhile, so the Wi-Fi station
+ * manager does not take the response, and is told about a restart.
+ */
+/*============================================================================*/
+static void cli_esp_at_passthrough(const char *at_cmd) {
+  static char resp[CLI_ESP_AT_RESP_SIZE];
+  uint32_t t0;
+
+  wifi_at_lock();
+  if (esp_at_send_line(at_cmd) == SUCCESS) {
+    t0 = HAL_GetTick();
+    while (HAL_GetTick() - t0 < CLI_ESP_AT_RESP_TIMEOUT_MS) {
+      if (!esp_at_read_response(resp, sizeof(resp), 100))
+        continue;
+      M1_LOG_N(M1_LOGDB_TAG, "%s", resp);
+      if (strstr(resp, "OK") || strstr(resp, "ERROR"))
+        break;
+    }
+  } else {
+    M1_LOG_N(M1_LOGDB_TAG, "Send failed!\r\n");
+  }
+  // AT+RST and AT+RESTORE restart the ESP32, a joined network is gone
+  if (!strncmp(at_cmd, "AT+RST", 6) || !strncmp(at_cmd, "AT+RESTORE", 10))
+    wifi_sta_link_reset();
+  wifi_at_unlock();
+} // static void cli_esp_at_passthrough(const char *at_cmd)
+
 /*============================================================================*/
 /*
  * This command runs tests for ESP32
@@ -972,8 +1008,6 @@ void cmd_m1_mtest_esp32(char *pconsole, char *input_params[], uint8_t n_params,
 #if 0 /* Unused: stub for future work. May need removal later. */
 	uint32_t input1_val;
 #endif
-  ctrl_cmd_t app_req = CTRL_CMD_DEFAULT_REQ();
-
   switch (cmd_type) {
   case 70:
     M1_LOG_N(M1_LOGDB_TAG, "CLI mtest: ESP32 - init esp32 module\r\n");
@@ -1017,9 +1051,7 @@ void cmd_m1_mtest_esp32(char *pconsole, char *input_params[], uint8_t n_params,
       if (!get_esp32_main_init_status())
         esp32_main_init();
       strcat(input_params[1], "\r\n");
-      app_req.at_cmd = input_params[1];
-      app_req.cmd_len = strlen(input_params[1]);
-      spi_AT_app_send_command(&app_req);
+      cli_esp_at_passthrough(input_params[1]);
     } // if ( get_esp32_ready_status() )
     else {
       strcpy(pconsole, "ESP32 not ready!\r\n");
@@ -1032,9 +1064,12 @@ void cmd_m1_mtest_esp32(char *pconsole, char *input_params[], uint8_t n_params,
       strcpy(pconsole, "Error: missing parameter(s)!\r\n");
       break;
     }
+    wifi_at_lock();
     esp32_disable();
     HAL_Delay(100);
     esp32_enable();
+    wifi_sta_link_reset();
+    wifi_at_unlock();
     break;
 
   case 79:
@@ -1043,6 +1078,10 @@ void cmd_m1_mtest_esp32(char *pconsole, char *input_params[], uint8_t n_params,
       strcpy(pconsole, "Error: missing parameter(s)!\r\n");
       break;
     }
+    if (wifi_sta_active()) {
+      strcpy(pconsole, "Disconnect Wi-Fi first!\r\n");
+      break;
+    }
     m1_esp32_deinit();
     esp32_enable();
     break;
@@ -0,0 +1,605 @@
+/* See COPYING.txt for license details. */
+
+/*
+*
+* m1_cli_script.c
+*
+* CLI script interpreter
+*
+* M1 Project
+*
+*/
+
+/*************************** I N C L U D E S **********************************/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "m1_cli_script.h"
+
+/*************************** D E F I N E S ************************************/
+
+#define CLI_SCRIPT_NO_JUMP			0xFFFF
+
+//************************** C O N S T A N T **********************************/
+
+static const char *const cli_script_status_texts[] = {
+	"OK", "check failed", "syntax error", "aborted", "script too large"
+};
+
+//************************** S T R U C T U R E S *******************************
+
+typedef struct
+{
+	uint16_t start; // Line of the repeat statement
+	uint32_t count;
+	uint32_t pass; // From 1
+	int8_t var; // Pass counter variable, -1 for none
+} S_M1_CliScript_Loop;
+
+/***************************** V A R I A B L E S ******************************/
+
+static char *cli_script_lines[CLI_SCRIPT_MAX_LINES];
+// repeat/if/ifnot: line of the matching else or end, else: line of the end,
+// end: line of the statement it closes
+static uint16_t cli_script_jump[CLI_SCRIPT_MAX_LINES];
+static uint16_t cli_script_n_lines;
+static char cli_script_var_names[CLI_SCRIPT_MAX_VARS][CLI_SCRIPT_VAR_NAME_SIZE];
+static char cli_script_var_values[CLI_SCRIPT_MAX_VARS][CLI_SCRIPT_VAR_VALUE_SIZE];
+static uint8_t cli_script_n_vars;
+static char cli_script_line[CLI_SCRIPT_LINE_SIZE];
+static char cli_script_output[CLI_SCRIPT_OUTPUT_SIZE];
+static char cli_script_msg[CLI_SCRIPT_LINE_SIZE + 32];
+
+/********************* F U N C T I O N   P R O T O T Y P E S ******************/
+
+S_M1_CliScript_Status m1_cli_script_run(char *text, size_t len, const S_M1_CliScript_Ops *ops,
+										S_M1_CliScript_Result *presult);
+const char *m1_cli_script_status_text(S_M1_CliScript_Status status);
+static bool cli_script_split(char *text, size_t len, S_M1_CliScript_Result *presult);
+static bool cli_script_keyword(const char *line, const char *keyword, const char **parg);
+static bool cli_script_is_keyword(const char *line, const char *keyword);
+static bool cli_script_is_statement(const char *line);
+static const char *cli_script_text_arg(const char *arg);
+static int8_t cli_script_find_var(const char *name, size_t name_len);
+static bool cli_script_set_var(const char *name, size_t name_len, const char *value);
+static bool cli_script_substitute(const char *raw, const S_M1_CliScript_Result *presult, const S_M1_CliScript_Ops *ops);
+static bool cli_script_check(bool found, bool expected, const char *text, const S_M1_CliScript_Ops *ops,
+							S_M1_CliScript_Result *presult, uint16_t line);
+
+/*************** F U N C T I O N   I M P L E M E N T A T I O N ****************/
+
+/*============================================================================*/
+/*
+ * This function runs a script, see m1_cli_script.h for the statements.
+ */
+/*============================================================================*/
+S_M1_CliScript_Status m1_cli_script_run(char *text, size_t len, const S_M1_CliScript_Ops *ops,
+										S_M1_CliScript_Result *presult)
+{
+	S_M1_CliScript_Loop loops[CLI_SCRIPT_MAX_DEPTH];
+	uint8_t depth = 0;
+	bool stop_on_fail = true;
+	uint16_t pc = 0;
+	const char *arg;
+	char *end;
+	long value;
+	S_M1_CliScript_Loop *loop;
+
+	memset(presult, 0, sizeof(*presult));
+	cli_script_n_vars = 0;
+	cli_script_output[0] = '\0';
+
+	if ( len > CLI_SCRIPT_MAX_SIZE )
+	{
+		presult->status = CLI_SCRIPT_TOO_LARGE;
+		return presult->status;
+	}
+	if ( !cli_script_split(text, len, presult) )
+		return presult->status;
+
+	while ( pc < cli_script_n_lines )
+	{
+		if ( cli_script_lines[pc][0]=='\0' || cli_script_lines[pc][0]=='#' )
+		{
+			pc++;
+			continue;
+		}
+		if ( !cli_script_substitute(cli_script_lines[pc], presult, ops) )
+		{
+			presult->line = pc + 1;
+			presult->status = CLI_SCRIPT_SYNTAX_ERROR;
+			return presult->status;
+		}
+
+		if ( cli_script_keyword(cli_script_line, "set", &arg) )
+		{
+			end = strchr(arg, ' ');
+			if ( end==NULL || !cli_script_set_var(arg, (size_t)(end - arg), cli_script_text_arg(end + 1)) )
+				break;
+		}
+		else if ( cli_script_keyword(cli_script_line, "inc", &arg) )
+		{
+			int8_t var;
+
+			end = strchr(arg, ' ');
+			var = cli_script_find_var(arg, end ? (size_t)(end - arg) : strlen(arg));
+			if ( var < 0 )
+				break;
+			value = strtol(cli_script_var_values[var], NULL, 0) + (end ? strtol(end + 1, NULL, 0) : 1);
+			snprintf(cli_script_var_values[var], CLI_SCRIPT_VAR_VALUE_SIZE, "%ld", value);
+		}
+		else if ( cli_script_keyword(cli_script_line, "repeat", &arg) )
+		{
+			value = strtol(arg, &end, 0);
+			if ( end==arg || value < 0 )
+				break;
+			if ( value==0 )
+			{
+				pc = cli_script_jump[pc] + 1;
+				continue;
+			}
+			if ( depth >= CLI_SCRIPT_MAX_DEPTH )
+				break;
+			loop = &loops[depth++];
+			loop->start = pc;
+			loop->count = (uint32_t)value;
+			loop->pass = 1;
+			loop->var = -1;
+			while ( *end==' ' )
+				end++;
+			if ( *end )
+			{
+				if ( !cli_script_set_var(end, strlen(end), "1") )
+					break;
+				loop->var = cli_script_find_var(end, strlen(end));
+			}
+		}
+		else if ( cli_script_is_keyword(cli_script_line, "end") )
+		{
+			// The end of an if block has nothing to do
+			if ( cli_script_is_keyword(cli_script_lines[cli_script_jump[pc]], "repeat") )
+			{
+				loop = &loops[depth - 1];
+				if ( loop->pass < loop->count )
+				{
+					loop->pass++;
+					if ( loop->var >= 0 )
+						snprintf(cli_script_var_values[loop->var], CLI_SCRIPT_VAR_VALUE_SIZE, "%lu", (unsigned long)loop->pass);
+					pc = loop->start + 1;
+					continue;
+				}
+				depth--;
+			}
+		}
+		else if ( cli_script_keyword(cli_script_line, "if", &arg) || cli_script_keyword(cli_script_line, "ifnot", &arg) )
+		{
+			bool found = strstr(cli_script_output, cli_script_text_arg(arg))!=NULL;
+
+			if ( found!=(cli_script_line[2]==' ') )
+			{
+				// Skip to the else branch or past the end
+				pc = cli_script_jump[pc] + 1;
+				continue;
+			}
+		}
+		else if ( cli_script_is_keyword(cli_script_line, "else") )
+		{
+			// End of the taken branch
+			pc = cli_script_jump[pc] + 1;
+			continue;
+		}
+		else if ( cli_script_keyword(cli_script_line, "expect", &arg) || cli_script_keyword(cli_script_line, "reject", &arg) )
+		{
+			bool expected = cli_script_line[0]=='e';
+
+			arg = cli_script_text_arg(arg);
+			if ( !cli_script_check(strstr(cli_script_output, arg)!=NULL, expected, arg, ops, presult, pc + 1)
+				&& stop_on_fail )
+			{
+				presult->status = CLI_SCRIPT_CHECK_FAILED;
+				return presult->status;
+			}
+		}
+		else if ( cli_script_keyword(cli_script_line, "onfail", &arg) )
+		{
+			if ( strcmp(arg, "stop")==0 )
+				stop_on_fail = true;
+			else if ( strcmp(arg, "continue")==0 )
+				stop_on_fail = false;
+			else
+				break;
+		}
+		else if ( cli_script_keyword(cli_script_line, "sleep", &arg) )
+		{
+			value = strtol(arg, &end, 0);
+			if ( end==arg || value < 0 )
+				break;
+			if ( ops->sleep((uint32_t)value) )
+			{
+				presult->line = pc + 1;
+				presult->status = CLI_SCRIPT_ABORTED;
+				return presult->status;
+			}
+		}
+		else if ( cli_script_keyword(cli_script_line, "echo", &arg) || cli_script_is_keyword(cli_script_line, "echo") )
+		{
+			snprintf(cli_script_msg, sizeof(cli_script_msg), "%s\r\n", cli_script_line[4] ? cli_script_text_arg(arg) : "");
+			ops->output(cli_script_msg);
+		}
+		else if ( cli_script_is_keyword(cli_script_line, "exit") )
+		{
+			break;
+		}
+		else if ( cli_script_is_statement(cli_script_line) )
+		{
+			break; // Statement without its argument
+		}
+		else
+		{
+			snprintf(cli_script_msg, sizeof(cli_script_msg), "> %s\r\n", cli_script_line);
+			ops->output(cli_script_msg);
+			cli_script_output[0] = '\0';
+			ops->exec(cli_script_line, cli_script_output, sizeof(cli_script_output));
+			cli_script_output[sizeof(cli_script_output) - 1] = '\0';
+			ops->output(cli_script_output);
+			presult->commands++;
+			// Lets a long script without sleeps be aborted
+			if ( ops->sleep(0) )
+			{
+				presult->line = pc + 1;
+				presult->status = CLI_SCRIPT_ABORTED;
+				return presult->status;
+			}
+		}
+		pc++;
+	} // while ( pc < cli_script_n_lines )
+
+	// Left the loop early on a bad statement, or on exit
+	if ( pc < cli_script_n_lines && !cli_script_is_keyword(cli_script_line, "exit") )
+	{
+		presult->line = pc + 1;
+		presult->status = CLI_SCRIPT_SYNTAX_ERROR;
+	}
+
+	return presult->status;
+} // S_M1_CliScript_Status m1_cli_script_run(...)
+
+
+
+const char *m1_cli_script_status_text(S_M1_CliScript_Status status)
+{
+	if ( status > CLI_SCRIPT_TOO_LARGE )
+		return "?";
+
+	return cli_script_status_texts[status];
+} // const char *m1_cli_script_status_text(S_M1_CliScript_Status status)
+
+
+
+/*============================================================================*/
+/*
+ * This function splits the text into trimmed lines and matches the block
+ * statements. It returns false on a syntax error.
+ */
+/*============================================================================*/
+static bool cli_script_split(char *text, size_t len, S_M1_CliScript_Result *presult)
+{
+	uint16_t stack[CLI_SCRIPT_MAX_DEPTH];
+	uint8_t depth = 0;
+	uint16_t open, i_if;
+	size_t i = 0, start, trim;
+	char *line;
+	bool ok = true;
+
+	cli_script_n_lines = 0;
+	while ( i < len )
+	{
+		start = i;
+		while ( i < len && text[i]!='\n' && text[i]!='\0' )
+			i++;
+		trim = i;
+		while ( trim > start && isspace((unsigned char)text[trim - 1]) )
+			trim--;
+		if ( i < len )
+			i++;
+		text[trim] = '\0';
+		while ( start < trim && isspace((unsigned char)text[start]) )
+			start++;
+
+		if ( cli_script_n_lines >= CLI_SCRIPT_MAX_LINES )
+		{
+			presult->status = CLI_SCRIPT_TOO_LARGE;
+			return false;
+		}
+		line = &text[start];
+		presult->line = cli_script_n_lines + 1;
+		cli_script_lines[cli_script_n_lines] = line;
+		cli_script_jump[cli_script_n_lines] = CLI_SCRIPT_NO_JUMP;
+
+		if ( cli_script_is_keyword(line, "repeat") || cli_script_is_keyword(line, "if") || cli_script_is_keyword(line, "ifnot") )
+		{
+			if ( depth >= CLI_SCRIPT_MAX_DEPTH )
+				ok = false;
+			else
+				stack[depth++] = cli_script_n_lines;
+		}
+		else if ( cli_script_is_keyword(line, "else") )
+		{
+			if ( depth==0 || cli_script_is_keyword(cli_script_lines[stack[depth - 1]], "repeat") ||
+				cli_script_is_keyword(cli_script_lines[stack[depth - 1]], "else") )
+				ok = false;
+			else
+			{
+				// The if jumps past the else, the else is closed by the end
+				cli_script_jump[stack[depth - 1]] = cli_script_n_lines;
+				stack[depth - 1] = cli_script_n_lines;
+			}
+		}
+		else if ( cli_script_is_keyword(line, "end") )
+		{
+			if ( depth==0 )
+				ok = false;
+			else
+			{
+				open = stack[--depth];
+				cli_script_jump[open] = cli_script_n_lines;
+				// The end of an if-else block points back to the if
+				if ( cli_script_is_keyword(cli_script_lines[open], "else") )
+				{
+					for ( i_if = 0; cli_script_jump[i_if]!=open; i_if++ )
+						;
+					open = i_if;
+				}
+				cli_script_jump[cli_script_n_lines] = open;
+			}
+		}
+		if ( !ok )
+			break;
+		cli_script_n_lines++;
+	} // while ( i < len )
+
+	if ( ok && depth )
+	{
+		ok = false;
+		presult->line = stack[depth - 1] + 1; // Block without end
+	}
+	if ( !ok )
+		presult->status = CLI_SCRIPT_SYNTAX_ERROR;
+
+	return ok;
+} // static bool cli_script_split(char *text, size_t len, S_M1_CliScript_Result *presult)
+
+
+
+/*============================================================================*/
+/*
+ * This function returns true if the line starts with the keyword followed by
+ * a space and an argument, which is returned in parg.
+ */
+/*============================================================================*/
+static bool cli_script_keyword(const char *line, const char *keyword, const char **parg)
+{
+	size_t n = strlen(keyword);
+
+	if ( strncmp(line, keyword, n)!=0 || line[n]!=' ' )
+		return false;
+
+	line += n;
+	while ( *line==' ' )
+		line++;
+	*parg = line;
+
+	return *line!='\0';
+} // static bool cli_script_keyword(const char *line, const char *keyword, const char **parg)
+
+
+
+/*============================================================================*/
+/*
+ * This function returns true if the first word of the line is the keyword.
+ */
+/*============================================================================*/
+static bool cli_script_is_keyword(const char *line, const char *keyword)
+{
+	size_t n = strlen(keyword);
+
+	return strncmp(line, keyword, n)==0 && (line[n]=='\0' || line[n]==' ');
+} // static bool cli_script_is_keyword(const char *line, const char *keyword)
+
+
+
+/*============================================================================*/
+/*
+ * This function returns true if the first word of the line is a statement
+ * that takes an argument.
+ */
+/*============================================================================*/
+static bool cli_script_is_statement(const char *line)
+{
+	static const char *const statements[] = {
+		"set", "inc", "repeat", "if", "ifnot", "expect", "reject", "onfail", "sleep"
+	};
+	uint8_t i;
+
+	for ( i = 0; i < sizeof(statements)/sizeof(statements[0]); i++ )
+	{
+		if ( cli_script_is_keyword(line, statements[i]) )
+			return true;
+	}
+
+	return false;
+} // static bool cli_script_is_statement(const char *line)
+
+
+
+/*============================================================================*/
+/*
+ * This function removes the quotes around a text argument, in place.
+ */
+/*============================================================================*/
+static const char *cli_script_text_arg(const char *arg)
+{
+	size_t n = strlen(arg);
+
+	if ( n >= 2 && arg[0]=='"' && arg[n - 1]=='"' )
+	{
+		((char *)arg)[n - 1] = '\0';
+		arg++;
+	}
+
+	return arg;
+} // static const char *cli_script_text_arg(const char *arg)
+
+
+
+static int8_t cli_script_find_var(const char *name, size_t name_len)
+{
+	uint8_t i;
+
+	for ( i = 0; i < cli_script_n_vars; i++ )
+	{
+		if ( strlen(cli_script_var_names[i])==name_len && strncmp(cli_script_var_names[i], name, name_len)==0 )
+			return (int8_t)i;
+	}
+
+	return -1;
+} // static int8_t cli_script_find_var(const char *name, size_t name_len)
+
+
+
+/*============================================================================*/
+/*
+ * This function sets a variable, new ones are added. It returns false if
+ * the name is invalid or there is no room for it.
+ */
+/*============================================================================*/
+static bool cli_script_set_var(const char *name, size_t name_len, const char *value)
+{
+	int8_t var;
+	size_t i;
+
+	if ( name_len==0 || name_len >= CLI_SCRIPT_VAR_NAME_SIZE )
+		return false;
+	for ( i = 0; i < name_len; i++ )
+	{
+		if ( !isalnum((unsigned char)name[i]) && name[i]!='_' )
+			return false;
+	}
+
+	var = cli_script_find_var(name, name_len);
+	if ( var < 0 )
+	{
+		if ( cli_script_n_vars >= CLI_SCRIPT_MAX_VARS )
+			return false;
+		var = (int8_t)cli_script_n_vars++;
+		memcpy(cli_script_var_names[var], name, name_len);
+		cli_script_var_names[var][name_len] = '\0';
+	}
+	strncpy(cli_script_var_values[var], value, CLI_SCRIPT_VAR_VALUE_SIZE - 1);
+	cli_script_var_values[var][CLI_SCRIPT_VAR_VALUE_SIZE - 1] = '\0';
+
+	return true;
+} // static bool cli_script_set_var(const char *name, size_t name_len, const char *value)
+
+
+
+/*============================================================================*/
+/*
+ * This function copies the line to cli_script_line with the variables
+ * replaced. It returns false for an unknown variable or a line too long.
+ */
+/*============================================================================*/
+static bool cli_script_substitute(const char *raw, const S_M1_CliScript_Result *presult, const S_M1_CliScript_Ops *ops)
+{
+	char builtin[12];
+	const char *name, *value;
+	size_t name_len, n, out = 0;
+	bool braces;
+	int8_t var;
+
+	while ( *raw )
+	{
+		value = NULL;
+		if ( raw[0]=='$' && raw[1]=='$' )
+		{
+			value = "$";
+			raw += 2;
+		}
+		else if ( raw[0]=='$' )
+		{
+			braces = raw[1]=='{';
+			name = raw + (braces ? 2 : 1);
+			for ( name_len = 0; isalnum((unsigned char)name[name_len]) || name[name_len]=='_'; name_len++ )
+				;
+			if ( name_len==0 || (braces && name[name_len]!='}') )
+				return false;
+			raw = name + name_len + (braces ? 1 : 0);
+
+			var = cli_script_find_var(name, name_len);
+			if ( var >= 0 )
+				value = cli_script_var_values[var];
+			else
+			{
+				value = builtin;
+				if ( name_len==4 && strncmp(name, "TICK", 4)==0 )
+					snprintf(builtin, sizeof(builtin), "%lu", (unsigned long)ops->tick());
+				else if ( name_len==4 && strncmp(name, "PASS", 4)==0 )
+					snprintf(builtin, sizeof(builtin), "%lu", (unsigned long)presult->passed);
+				else if ( name_len==4 && strncmp(name, "FAIL", 4)==0 )
+					snprintf(builtin, sizeof(builtin), "%lu", (unsigned long)presult->failed);
+				else
+					return false;
+			}
+		}
+
+		if ( value )
+		{
+			n = strlen(value);
+			if ( out + n >= CLI_SCRIPT_LINE_SIZE )
+				return false;
+			memcpy(&cli_script_line[out], value, n);
+			out += n;
+		}
+		else
+		{
+			if ( out + 1 >= CLI_SCRIPT_LINE_SIZE )
+				return false;
+			cli_script_line[out++] = *raw++;
+		}
+	} // while ( *raw )
+	cli_script_line[out] = '\0';
+
+	return true;
+} // static bool cli_script_substitute(...)
+
+
+
+/*============================================================================*/
+/*
+ * This function counts and reports the result of a check. It returns true
+ * if the check passed.
+ */
+/*============================================================================*/
+static bool cli_script_check(bool found, bool expected, const char *text, const S_M1_CliScript_Ops *ops,
+							S_M1_CliScript_Result *presult, uint16_t line)
+{
+	const char *what = expected ? "expect" : "reject";
+
+	if ( found==expected )
+	{
+		presult->passed++;
+		snprintf(cli_script_msg, sizeof(cli_script_msg), "PASS %s \"%s\"\r\n", what, text);
+		ops->output(cli_script_msg);
+		return true;
+	}
+
+	presult->failed++;
+	presult->line = line;
+	snprintf(cli_script_msg, sizeof(cli_script_msg), "FAIL line %u: %s \"%s\"\r\n", line, what, text);
+	ops->output(cli_script_msg);
+
+	return false;
+} // static bool cli_script_check(...)
@@ -0,0 +1,87 @@
+/* See COPYING.txt for license details. */
+
+/*
+*
+* m1_cli_script.h
+*
+* Header for the CLI script interpreter
+*
+* A script is a text file of CLI commands, one per line, mixed with these
+* statements:
+*   # text                  comment
+*   set NAME value          sets a variable, $NAME or ${NAME} is replaced in
+*                           every following line, $$ is a literal $
+*   inc NAME [n]            adds n (default 1) to a numeric variable
+*   repeat N [NAME]         runs the lines up to the matching "end" N times,
+*                           NAME counts the passes from 1
+*   if TEXT / ifnot TEXT    runs the lines up to "else" or "end" if the
+*   else / end              output of the last command contains (or does not
+*                           contain) TEXT
+*   expect TEXT             a check: the last output must contain TEXT
+*   reject TEXT             a check: the last output must not contain TEXT
+*   onfail stop|continue    what a failed check does, stop is the default
+*   sleep MS                waits, the script can be aborted meanwhile
+*   echo TEXT               writes TEXT to the output
+*   exit                    ends the script
+* Built-in variables: $TICK (ms since boot), $PASS and $FAIL (checks so far).
+* Any other line is run as a CLI command.
+*
+* M1 Project
+*
+*/
+
+#ifndef M1_CLI_SCRIPT_H_
+#define M1_CLI_SCRIPT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define CLI_SCRIPT_MAX_SIZE			4096	// Bytes of script text
+#define CLI_SCRIPT_MAX_LINES		256
+#define CLI_SCRIPT_LINE_SIZE		128		// After variable substitution
+#define CLI_SCRIPT_OUTPUT_SIZE		1024	// Output of one command kept for the checks
+#define CLI_SCRIPT_MAX_VARS			16
+#define CLI_SCRIPT_VAR_NAME_SIZE	16
+#define CLI_SCRIPT_VAR_VALUE_SIZE	48
+#define CLI_SCRIPT_MAX_DEPTH		8		// Nested repeat/if blocks
+
+typedef enum
+{
+	CLI_SCRIPT_OK = 0,
+	CLI_SCRIPT_CHECK_FAILED, // A check failed with "onfail stop"
+	CLI_SCRIPT_SYNTAX_ERROR,
+	CLI_SCRIPT_ABORTED,
+	CLI_SCRIPT_TOO_LARGE
+} S_M1_CliScript_Status;
+
+typedef struct
+{
+	// Runs a CLI command, writes its text output (zero terminated) to out
+	void (*exec)(const char *cmd, char *out, size_t out_size);
+	// Writes script output: commands, their output, echo and check results
+	void (*output)(const char *text);
+	// Waits ms milliseconds, returns true if the script is to be aborted
+	bool (*sleep)(uint32_t ms);
+	uint32_t (*tick)(void);
+} S_M1_CliScript_Ops;
+
+typedef struct
+{
+	S_M1_CliScript_Status status;
+	uint16_t line; // Line of the error or last failed check, from 1, 0: none
+	uint32_t commands; // CLI commands run
+	uint32_t passed; // Checks passed
+	uint32_t failed; // Checks failed
+} S_M1_CliScript_Result;
+
+/*
+ * Runs the script text of len bytes. The text is changed: lines are zero
+ * terminated in place, the last one at text[len], so the buffer holds
+ * len + 1 bytes.
+ */
+S_M1_CliScript_Status m1_cli_script_run(char *text, size_t len, const S_M1_CliScript_Ops *ops,
+										S_M1_CliScript_Result *presult);
+const char *m1_cli_script_status_text(S_M1_CliScript_Status status);
+
+#endif /* M1_CLI_SCRIPT_H_ */
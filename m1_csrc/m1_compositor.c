@@ -0,0 +1,119 @@
+/* See COPYING.txt for license details. */
+
+/*
+*
+* m1_compositor.c
+*
+* UI compositor: paces and coalesces the redraws of the screens
+*
+* M1 Project
+*
+*/
+
+/*************************** I N C L U D E S **********************************/
+
+#include <string.h>
+#include "m1_compositor.h"
+
+/*************************** D E F I N E S ************************************/
+
+//************************** C O N S T A N T **********************************/
+
+//************************** S T R U C T U R E S *******************************
+
+/***************************** V A R I A B L E S ******************************/
+
+/********************* F U N C T I O N   P R O T O T Y P E S ******************/
+
+void m1_compositor_init(S_M1_Compositor *pc, uint32_t frame_ms);
+bool m1_compositor_invalidate(S_M1_Compositor *pc, uint8_t param, uint32_t now_ms);
+uint32_t m1_compositor_due_in(const S_M1_Compositor *pc, uint32_t now_ms);
+bool m1_compositor_take(S_M1_Compositor *pc, uint32_t now_ms, uint8_t *pparam);
+void m1_compositor_frame_done(S_M1_Compositor *pc, uint32_t now_ms);
+void m1_compositor_cancel(S_M1_Compositor *pc);
+
+/*************** F U N C T I O N   I M P L E M E N T A T I O N ****************/
+
+void m1_compositor_init(S_M1_Compositor *pc, uint32_t frame_ms)
+{
+	memset(pc, 0, sizeof(*pc));
+	pc->frame_ms = frame_ms;
+} // void m1_compositor_init(S_M1_Compositor *pc, uint32_t frame_ms)
+
+
+
+/*============================================================================*/
+/*
+ * This function asks for a frame drawn with param, replacing the one pending.
+ * It returns true if the frame is due now, else m1_compositor_due_in() tells
+ * when.
+ */
+/*============================================================================*/
+bool m1_compositor_invalidate(S_M1_Compositor *pc, uint8_t param, uint32_t now_ms)
+{
+	pc->requests++;
+	pc->pending = true;
+	pc->param = param;
+
+	return (m1_compositor_due_in(pc, now_ms)==0);
+} // bool m1_compositor_invalidate(S_M1_Compositor *pc, uint8_t param, uint32_t now_ms)
+
+
+
+// Time left until the pending frame may be drawn, UINT32_MAX if none pending
+uint32_t m1_compositor_due_in(const S_M1_Compositor *pc, uint32_t now_ms)
+{
+	uint32_t elapsed;
+
+	if ( !pc->pending )
+		return UINT32_MAX;
+	if ( !pc->framed )
+		return 0;
+
+	elapsed = now_ms - pc->last_frame_ms;
+	if ( elapsed >= pc->frame_ms )
+		return 0;
+
+	return pc->frame_ms - elapsed;
+} // uint32_t m1_compositor_due_in(const S_M1_Compositor *pc, uint32_t now_ms)
+
+
+
+/*============================================================================*/
+/*
+ * This function hands out the pending frame if it is due. The caller draws it
+ * with *pparam; the frame interval starts now.
+ */
+/*============================================================================*/
+bool m1_compositor_take(S_M1_Compositor *pc, uint32_t now_ms, uint8_t *pparam)
+{
+	if ( m1_compositor_due_in(pc, now_ms)!=0 )
+		return false;
+
+	*pparam = pc->param;
+	pc->pending = false;
+	pc->framed = true;
+	pc->last_frame_ms = now_ms;
+	pc->frames++;
+
+	return true;
+} // bool m1_compositor_take(S_M1_Compositor *pc, uint32_t now_ms, uint8_t *pparam)
+
+
+
+// A screen was drawn directly, it shows newer data than the pending frame
+void m1_compositor_frame_done(S_M1_Compositor *pc, uint32_t now_ms)
+{
+	pc->pending = false;
+	pc->framed = true;
+	pc->last_frame_ms = now_ms;
+	pc->direct_frames++;
+} // void m1_compositor_frame_done(S_M1_Compositor *pc, uint32_t now_ms)
+
+
+
+// The screen is gone, its pending frame with it
+void m1_compositor_cancel(S_M1_Compositor *pc)
+{
+	pc->pending = false;
+} // void m1_compositor_cancel(S_M1_Compositor *pc)
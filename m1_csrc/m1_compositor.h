@@ -0,0 +1,50 @@
+/* See COPYING.txt for license details. */
+
+/*
+*
+* m1_compositor.h
+*
+* Header for the UI compositor
+*
+* Screens redrawn from data events (captures, readers) invalidate instead of
+* drawing. The compositor keeps the last parameter asked for and lets one
+* frame through per frame interval: a burst of invalidations costs one redraw
+* at the end of the interval, with the latest data. A screen drawn outside
+* the compositor (key press, screen switch) counts as a frame and drops the
+* pending one.
+*
+* Times are in ms, the caller passes them in and runs the frames in the task
+* that owns the display.
+*
+* M1 Project
+*
+*/
+
+#ifndef M1_COMPOSITOR_H_
+#define M1_COMPOSITOR_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define M1_COMPOSITOR_FRAME_MS		50 // 20 frames per second
+
+typedef struct
+{
+	uint32_t frame_ms;
+	uint32_t last_frame_ms;
+	bool framed; // A frame has been drawn, last_frame_ms is valid
+	bool pending;
+	uint8_t param; // Of the pending frame
+	uint32_t requests; // Invalidations
+	uint32_t frames; // Frames drawn for invalidations
+	uint32_t direct_frames; // Frames drawn outside the compositor
+} S_M1_Compositor;
+
+void m1_compositor_init(S_M1_Compositor *pc, uint32_t frame_ms);
+bool m1_compositor_invalidate(S_M1_Compositor *pc, uint8_t param, uint32_t now_ms);
+uint32_t m1_compositor_due_in(const S_M1_Compositor *pc, uint32_t now_ms);
+bool m1_compositor_take(S_M1_Compositor *pc, uint32_t now_ms, uint8_t *pparam);
+void m1_compositor_frame_done(S_M1_Compositor *pc, uint32_t now_ms);
+void m1_compositor_cancel(S_M1_Compositor *pc);
+
+#endif /* M1_COMPOSITOR_H_ */
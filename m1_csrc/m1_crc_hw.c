@@ -0,0 +1,134 @@
+/* See COPYING.txt for license details. */
+
+/*
+*
+* m1_crc_hw.c
+*
+* CRC peripheral for the bit_util.c CRCs
+*
+* M1 Project
+*
+*/
+
+/*************************** I N C L U D E S **********************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "stm32h5xx_hal.h"
+#include "main.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "bit_util.h"
+#include "m1_crc_hw.h"
+
+/*************************** D E F I N E S ************************************/
+
+//************************** C O N S T A N T **********************************/
+
+//************************** S T R U C T U R E S *******************************
+
+/***************************** V A R I A B L E S ******************************/
+
+// Set while the firmware update accumulates an image CRC
+static volatile bool crc_hw_streaming = false;
+
+/********************* F U N C T I O N   P R O T O T Y P E S ******************/
+
+int crc_hw_calc(unsigned width, int lsb_first, uint32_t polynomial, uint32_t init,
+		uint8_t const message[], unsigned nBytes, uint32_t *crc);
+void m1_crc_hw_stream_begin(void);
+void m1_crc_hw_stream_end(void);
+
+/*************** F U N C T I O N   I M P L E M E N T A T I O N ****************/
+
+/*============================================================================*/
+/*
+ * This function calculates a CRC of bit_util.c on the CRC peripheral.
+ * It overrides the weak default of bit_util.c and returns 0 whenever the
+ * caller has to use its table instead: in interrupts, during a firmware
+ * update and for even polynomials, which the peripheral does not accept.
+ * The scheduler is suspended for the calculation, about one cycle per byte,
+ * so no other task can find the peripheral in use.
+ */
+/*============================================================================*/
+int crc_hw_calc(unsigned width, int lsb_first, uint32_t polynomial, uint32_t init,
+		uint8_t const message[], unsigned nBytes, uint32_t *crc)
+{
+	CRC_HandleTypeDef crchdl;
+	uint32_t mask;
+	int done = 0;
+
+	if ( xPortIsInsideInterrupt() || !(polynomial & 1) )
+		return 0;
+
+	switch ( width )
+	{
+		case 8:
+			crchdl.Init.CRCLength = CRC_POLYLENGTH_8B;
+			mask = 0xFFU;
+			break;
+
+		case 16:
+			crchdl.Init.CRCLength = CRC_POLYLENGTH_16B;
+			mask = 0xFFFFU;
+			break;
+
+		case 32:
+			crchdl.Init.CRCLength = CRC_POLYLENGTH_32B;
+			mask = 0xFFFFFFFFU;
+			break;
+
+		default:
+			return 0;
+	} // switch ( width )
+
+	vTaskSuspendAll();
+	if ( !crc_hw_streaming )
+	{
+		__HAL_RCC_CRC_CLK_ENABLE();
+		crchdl.Instance = CRC;
+		crchdl.State = HAL_CRC_STATE_RESET;
+		crchdl.Init.DefaultPolynomialUse = DEFAULT_POLYNOMIAL_DISABLE;
+		crchdl.Init.GeneratingPolynomial = polynomial;
+		crchdl.Init.DefaultInitValueUse = DEFAULT_INIT_VALUE_DISABLE;
+		crchdl.Init.InitValue = init;
+		crchdl.Init.InputDataInversionMode = lsb_first ? CRC_INPUTDATA_INVERSION_BYTE : CRC_INPUTDATA_INVERSION_NONE;
+		crchdl.Init.OutputDataInversionMode = lsb_first ? CRC_OUTPUTDATA_INVERSION_ENABLE : CRC_OUTPUTDATA_INVERSION_DISABLE;
+		crchdl.InputDataFormat = CRC_INPUTDATA_FORMAT_BYTES;
+		if ( HAL_CRC_Init(&crchdl)==HAL_OK )
+		{
+			*crc = HAL_CRC_Calculate(&crchdl, (uint32_t *)message, nBytes) & mask;
+			done = 1;
+			HAL_CRC_DeInit(&crchdl);
+		}
+	} // if ( !crc_hw_streaming )
+	xTaskResumeAll();
+
+	return done;
+} // int crc_hw_calc(...)
+
+
+
+/*============================================================================*/
+/*
+ * This function reserves the peripheral for a CRC accumulated over several
+ * calls. Called from a task, crc_hw_calc() is never half way through then.
+ */
+/*============================================================================*/
+void m1_crc_hw_stream_begin(void)
+{
+	crc_hw_streaming = true;
+} // void m1_crc_hw_stream_begin(void)
+
+
+
+/*============================================================================*/
+/*
+ * This function returns the peripheral to the bit_util.c CRCs
+ */
+/*============================================================================*/
+void m1_crc_hw_stream_end(void)
+{
+	crc_hw_streaming = false;
+} // void m1_crc_hw_stream_end(void)
@@ -0,0 +1,26 @@
+/* See COPYING.txt for license details. */
+
+/*
+*
+* m1_crc_hw.h
+*
+* Header for the CRC peripheral
+*
+* Long messages of the bit_util.c CRCs are calculated by the CRC peripheral.
+* The firmware update verification keeps the peripheral for a whole image
+* and marks that time with m1_crc_hw_stream_begin()/m1_crc_hw_stream_end(),
+* the bit_util.c CRCs fall back to their tables meanwhile.
+*
+* M1 Project
+*
+*/
+
+#ifndef M1_CRC_HW_H_
+#define M1_CRC_HW_H_
+
+#include <stdint.h>
+
+void m1_crc_hw_stream_begin(void);
+void m1_crc_hw_stream_end(void);
+
+#endif /* M1_CRC_HW_H_ */
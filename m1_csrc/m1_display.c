@@ -13,12 +13,14 @@
 /*************************** I N C L U D E S **********************************/
 
 #include <stdint.h>
+#include <string.h>
 //#include "stm32h5xx_hal.h"
 //#include "main.h"
 #include "m1_lp5814.h"
 #include "m1_io_defs.h"
 #include "m1_compile_cfg.h"
 #include "m1_display.h"
+#include "m1_text_draw.h"
 
 /*************************** D E F I N E S ************************************/
 
@@ -144,6 +146,7 @@ void m1_gui_init(void)
 {
 	m1_lcd_cleardisplay();
 	u8g2_SetBitmapMode(&m1_u8g2, 1);
+	m1_text_draw_init(&m1_u8g2);
 
 	// used for scrolling text
 	/*
@@ -428,13 +431,13 @@ uint8_t m1_gui_submenu_update(const char *phmenu[], uint8_t num_items, uint8_t s
 				u8g2_SetDrawColor(&m1_u8g2, M1_DISP_DRAW_COLOR_BG); // set the color to White
 			} // else
 			u8g2_SetFont(&m1_u8g2, menu_text_font_b[menu_level_id]);
-    		u8g2_DrawStr(&m1_u8g2, menu_text_left_pos_x[menu_level_id], menu_text_y, phmenu[run - 1]);
+    		m1_draw_str(&m1_u8g2, menu_text_left_pos_x[menu_level_id], menu_text_y, phmenu[run - 1]);
     		u8g2_SetDrawColor(&m1_u8g2, M1_DISP_DRAW_COLOR_TXT); // return the color to Black
     		u8g2_SetFont(&m1_u8g2, menu_text_font_n[menu_level_id]);
 		} // if ( run==active_item )
 		else
 		{
-			u8g2_DrawStr(&m1_u8g2, menu_text_left_pos_x[menu_level_id], menu_text_y, phmenu[run - 1]);
+			m1_draw_str(&m1_u8g2, menu_text_left_pos_x[menu_level_id], menu_text_y, phmenu[run - 1]);
 		} // else
 		if ( menu_level_id==0 )
 		{
@@ -578,7 +581,7 @@ void m1_info_box_display_draw(uint8_t box_row, const char *ptext)
 	yn = (box_row - INFO_BOX_ROW_1)*10;
 	yn += info_box_first_row;
 
-	u8g2_DrawStr(&m1_u8g2, 4, yn, ptext);
+	m1_draw_str(&m1_u8g2, 4, yn, ptext);
 } // void m1_info_box_display_draw(uint8_t box_row, const char *ptext)
 
 
@@ -15,6 +15,7 @@
 
 #include "m1_lcd.h"
 #include "m1_menu.h"
+#include "m1_text_draw.h"
 
 #define M1_DISP_DRAW_COLOR_BG		0
 #define M1_DISP_DRAW_COLOR_TXT		1
@@ -12,9 +12,13 @@
 
 /************************** *I N C L U D E S **********************************/
 
+#include "m1_display.h"
+#include "m1_mem_pool.h"
 #include "m1_sdcard.h"
+#include "m1_signal_index.h"
 #include "main.h"
 #include "stm32h5xx_hal.h"
+#include <ctype.h>
 #include <stdarg.h>
 #include <stdint.h>
 #include <stdlib.h>
@@ -28,9 +32,13 @@
   __ISB();
 #define ENABLE_IRQ __enable_irq();
 
-#define FILE_BROWSER_MAX_FILES 96
+#define FILE_BROWSER_MAX_FILES 512 // Entries of the directory cache
+#define FB_DIR_CACHE_NAMES_SIZE 12288 // Names of the cached entries, in bytes
 #define DIRECTORY_MAX_DEPTH_LEVEL 32
 
+#define FB_NAME_BLOCK_SIZE (FF_MAX_LFN + 1) // Directory path or file name
+#define FB_NAME_POOL_BLOCKS 2               // info.dir_name and info.file_name
+
 #define GUI_SCROLLBAR_WIDTH 4 // pixel
 
 #define FILENAME_LEN_ON_CLI_MAX 80 // Max filename length to display on console
@@ -40,17 +48,48 @@
 //************************* *C O N S T A N T **********************************/
 
 const char m1_fb_data_types[] = ".log.LOG.text.TEXT.txt.TXT";
+// Companion files an app keeps next to its own, never opened directly
+const char m1_fb_sidecar_types[] = ".nfb.NFB";
 
 //************************* *S T R U C T U R E S *******************************
 
+typedef struct {
+  uint16_t name; // Offset in names[]
+  BYTE attrib;
+} S_M1_fb_dir_entry;
+
+typedef struct {
+  char dir_name[FB_NAME_BLOCK_SIZE];
+  uint32_t write_seq; // m1_sdcard_get_write_seq() when it was read
+  bool valid;
+  bool truncated; // The directory has more entries than fit
+  uint16_t count;
+  uint16_t names_used;
+  S_M1_fb_dir_entry entries[FILE_BROWSER_MAX_FILES];
+  char names[FB_DIR_CACHE_NAMES_SIZE];
+} S_M1_fb_dir_cache;
+
 /**************************** *V A R I A B L E S ******************************/
 
 static S_M1_file_browser_hdl *pfb_hdl = NULL;
+
+/* The browser handle and its buffers are fixed size, so opening and closing
+ * the browser over and over does not fragment the heap */
+static S_M1_file_browser_hdl fb_hdl;
+static uint16_t fb_listing_index_buffer[DIRECTORY_MAX_DEPTH_LEVEL + 1];
+static uint16_t fb_row_index_buffer[DIRECTORY_MAX_DEPTH_LEVEL + 1];
+M1_MEM_POOL_STORAGE(fb_name_pool_storage, FB_NAME_BLOCK_SIZE,
+                    FB_NAME_POOL_BLOCKS);
+static S_M1_MemPool fb_name_pool;
 static u8g2_t *plcd_hdl;
 
 static bool fb_gui_check;
 FIL m1_log_file;
 
+/* Used by the browser in the GUI task only, the CLI listing reads the card
+ * itself */
+static S_M1_fb_dir_cache fb_dir_cache;
+
 /******************** *F U N C T I O N   P R O T O T Y P E S ******************/
 
 extern void m1_u8g2_firstpage(void);
@@ -68,6 +107,13 @@ uint8_t m1_fb_delete_file(const char *filename);
 uint16_t m1_fb_write_to_file(FIL *pfile, const char *buffer, uint16_t size);
 uint16_t m1_fb_read_from_file(FIL *pfile, char *buffer, uint16_t size);
 uint8_t m1_fb_check_low_freespace(void);
+FRESULT m1_fb_dir_cache_load(const char *dir_name);
+void m1_fb_dir_cache_invalidate(void);
+uint16_t m1_fb_dir_cache_count(void);
+bool m1_fb_dir_cache_truncated(void);
+const char *m1_fb_dir_cache_entry(uint16_t index, BYTE *attrib);
+int m1_fb_name_cmp(const char *name1, const char *name2);
+static int m1_fb_dir_entry_cmp(const void *entry1, const void *entry2);
 
 /************** *F U N C T I O N   I M P L E M E N T A T I O N ****************/
 
@@ -78,13 +124,18 @@ uint8_t m1_fb_check_low_freespace(void);
  */
 /******************************************************************************/
 S_M1_file_browser_hdl *m1_fb_init(u8g2_t *lcd_hdl) {
-  pfb_hdl = (S_M1_file_browser_hdl *)calloc(1, sizeof(S_M1_file_browser_hdl));
+  m1_fb_deinit(); // Only one browser at a time
 
-  pfb_hdl->listing_index_buffer = (uint16_t *)calloc(1, sizeof(uint16_t));
-  pfb_hdl->row_index_buffer = (uint16_t *)calloc(1, sizeof(uint16_t));
+  m1_mem_pool_init(&fb_name_pool, fb_name_pool_storage, FB_NAME_BLOCK_SIZE,
+                   FB_NAME_POOL_BLOCKS);
+  memset(&fb_hdl, 0, sizeof(fb_hdl));
+  pfb_hdl = &fb_hdl;
+
+  pfb_hdl->listing_index_buffer = fb_listing_index_buffer;
+  pfb_hdl->row_index_buffer = fb_row_index_buffer;
   *pfb_hdl->listing_index_buffer = 0;
   *pfb_hdl->row_index_buffer = 0;
-  pfb_hdl->info.dir_name = malloc(strlen(SDCARD_DEFAULT_DRIVE_PATH) + 1);
+  pfb_hdl->info.dir_name = m1_mem_pool_alloc(&fb_name_pool);
   assert(pfb_hdl->info.dir_name != NULL);
   strcpy(pfb_hdl->info.dir_name, SDCARD_DEFAULT_DRIVE_PATH);
   pfb_hdl->info.file_name = NULL;
@@ -353,7 +404,7 @@ uint8_t m1_fb_close_log_file(void) {
 
 /******************************************************************************/
 /**
- * @brief  Delete a file or folder
+ * @brief  Delete a file or folder, and its signal index record
  * @param  filename: name of the file or folder
  * @retval 1 for error, else 0
  */
@@ -364,6 +415,8 @@ uint8_t m1_fb_delete_file(const char *filename) {
     return 1;
 
   ret = f_unlink(filename);
+  if (ret == FR_OK) // A folder drops the records of the files it held
+    m1_sig_idx_remove(filename);
 
   return ret;
 } // uint8_t m1_fb_delete_file(const char *filename)
@@ -412,6 +465,189 @@ uint8_t m1_fb_check_low_freespace(void) {
   return 1;
 } // uint8_t m1_fb_check_low_freespace(void)
 
+/******************************************************************************/
+/*
+ *	This function compares two file names the way people sort them: case is
+ *	ignored and runs of digits are compared as numbers, so "capture_9" comes
+ *	before "capture_10".
+ *
+ */
+/******************************************************************************/
+int m1_fb_name_cmp(const char *name1, const char *name2) {
+  const char *p1, *p2, *d1, *d2;
+  size_t n1, n2;
+  int c1, c2, zeros;
+
+  p1 = name1;
+  p2 = name2;
+  zeros = 0;
+  while (*p1 && *p2) {
+    if (isdigit((unsigned char)*p1) && isdigit((unsigned char)*p2)) {
+      // Without the leading zeros the longer run is the larger number
+      d1 = p1;
+      while (*d1 == '0')
+        d1++;
+      d2 = p2;
+      while (*d2 == '0')
+        d2++;
+      for (n1 = 0; isdigit((unsigned char)d1[n1]); n1++)
+        ;
+      for (n2 = 0; isdigit((unsigned char)d2[n2]); n2++)
+        ;
+      if (n1 != n2)
+        return (n1 < n2) ? -1 : 1;
+      c1 = memcmp(d1, d2, n1);
+      if (c1)
+        return c1;
+      if (!zeros) // "7" before "07" if nothing else differs
+        zeros = (int)(d1 - p1) - (int)(d2 - p2);
+      p1 = d1 + n1;
+      p2 = d2 + n2;
+      continue;
+    } // if (isdigit((unsigned char)*p1) && isdigit((unsigned char)*p2))
+
+    c1 = tolower((unsigned char)*p1);
+    c2 = tolower((unsigned char)*p2);
+    if (c1 != c2)
+      return c1 - c2;
+    p1++;
+    p2++;
+  } // while (*p1 && *p2)
+
+  if (*p1 || *p2)
+    return *p1 ? 1 : -1;
+  if (zeros)
+    return zeros;
+
+  return strcmp(name1, name2); // Only the case differs
+} // int m1_fb_name_cmp(const char *name1, const char *name2)
+
+/******************************************************************************/
+/*
+ *	This function orders the directory cache: directories first, then by name
+ *
+ */
+/******************************************************************************/
+static int m1_fb_dir_entry_cmp(const void *entry1, const void *entry2) {
+  const S_M1_fb_dir_entry *pe1 = entry1;
+  const S_M1_fb_dir_entry *pe2 = entry2;
+
+  if ((pe1->attrib ^ pe2->attrib) & AM_DIR)
+    return (pe1->attrib & AM_DIR) ? -1 : 1;
+
+  return m1_fb_name_cmp(&fb_dir_cache.names[pe1->name],
+                        &fb_dir_cache.names[pe2->name]);
+} // static int m1_fb_dir_entry_cmp(const void *entry1, const void *entry2)
+
+/******************************************************************************/
+/*
+ *	This function reads a directory into the cache and sorts it. Hidden and
+ *	system entries, and sidecar files (.nfb), are left out. Nothing is read if the cache already holds
+ *	the directory and the SD card has not been written since.
+ *
+ */
+/******************************************************************************/
+FRESULT m1_fb_dir_cache_load(const char *dir_name) {
+  DIR directory;
+  FILINFO file_info;
+  uint32_t write_seq;
+  uint16_t len;
+  FRESULT res;
+
+  // Read before the directory, so a write while reading is seen next time
+  write_seq = m1_sdcard_get_write_seq();
+  if (fb_dir_cache.valid && fb_dir_cache.write_seq == write_seq &&
+      !strcmp(fb_dir_cache.dir_name, dir_name))
+    return FR_OK;
+
+  fb_dir_cache.valid = FALSE;
+  fb_dir_cache.truncated = FALSE;
+  fb_dir_cache.count = 0;
+  fb_dir_cache.names_used = 0;
+  if (strlen(dir_name) >= sizeof(fb_dir_cache.dir_name))
+    return FR_INVALID_NAME;
+
+  res = f_opendir(&directory, dir_name);
+  if (res != FR_OK)
+    return res;
+
+  while (1) {
+    res = f_readdir(&directory, &file_info);
+    if (res != FR_OK || !file_info.fname[0])
+      break;
+    if (file_info.fattrib & (AM_HID | AM_SYS)) // Hidden or system file?
+      continue;
+    if (!(file_info.fattrib & AM_DIR) &&
+        m1_fb_find_ext(file_info.fname, m1_fb_sidecar_types))
+      continue;
+
+    len = strlen(file_info.fname) + 1;
+    if (fb_dir_cache.count >= FILE_BROWSER_MAX_FILES ||
+        fb_dir_cache.names_used + len > FB_DIR_CACHE_NAMES_SIZE) {
+      fb_dir_cache.truncated = TRUE;
+      break;
+    }
+    fb_dir_cache.entries[fb_dir_cache.count].name = fb_dir_cache.names_used;
+    fb_dir_cache.entries[fb_dir_cache.count].attrib = file_info.fattrib;
+    memcpy(&fb_dir_cache.names[fb_dir_cache.names_used], file_info.fname,
+           len);
+    fb_dir_cache.names_used += len;
+    fb_dir_cache.count++;
+  } // while (1)
+  f_closedir(&directory);
+
+  if (res != FR_OK) {
+    fb_dir_cache.count = 0;
+    fb_dir_cache.names_used = 0;
+    return res;
+  }
+  if (fb_dir_cache.truncated)
+    M1_LOG_W(M1_LOGDB_TAG, "%s: only %d entries listed\r\n", dir_name,
+             fb_dir_cache.count);
+
+  qsort(fb_dir_cache.entries, fb_dir_cache.count, sizeof(S_M1_fb_dir_entry),
+        m1_fb_dir_entry_cmp);
+  strcpy(fb_dir_cache.dir_name, dir_name);
+  fb_dir_cache.write_seq = write_seq;
+  fb_dir_cache.valid = TRUE;
+
+  return FR_OK;
+} // FRESULT m1_fb_dir_cache_load(const char *dir_name)
+
+/******************************************************************************/
+/*
+ *	This function forces the next load to read the directory again
+ *
+ */
+/******************************************************************************/
+void m1_fb_dir_cache_invalidate(void) {
+  fb_dir_cache.valid = FALSE;
+} // void m1_fb_dir_cache_invalidate(void)
+
+uint16_t m1_fb_dir_cache_count(void) {
+  return fb_dir_cache.count;
+} // uint16_t m1_fb_dir_cache_count(void)
+
+bool m1_fb_dir_cache_truncated(void) {
+  return fb_dir_cache.truncated;
+} // bool m1_fb_dir_cache_truncated(void)
+
+/******************************************************************************/
+/*
+ *	This function returns the name of an entry in sorted order, and its FatFs
+ *	attributes if attrib is not NULL
+ *
+ */
+/******************************************************************************/
+const char *m1_fb_dir_cache_entry(uint16_t index, BYTE *attrib) {
+  if (index >= fb_dir_cache.count)
+    return NULL;
+  if (attrib)
+    *attrib = fb_dir_cache.entries[index].attrib;
+
+  return &fb_dir_cache.names[fb_dir_cache.entries[index].name];
+} // const char *m1_fb_dir_cache_entry(uint16_t index, BYTE *attrib)
+
 /******************************************************************************/
 /*
  *	This function displays files and folders on the LCD
@@ -421,16 +657,15 @@ uint8_t m1_fb_check_low_freespace(void) {
 S_M1_file_info *m1_fb_display(S_M1_Buttons_Status *button_status) {
   char name[FF_MAX_LFN + 1];
   FRESULT res;
-  static DIR directory;
-  FILINFO file_info = {0};
-  static FILINFO this_file = {0};
+  const char *fname;
+  BYTE fattrib;
   const S_M1_menu_icon_data *fb_icon;
   S_M1_file_browser_ext f_ext;
   static uint16_t num_of_files;
   static uint16_t gui_max_column, gui_max_row;
   static uint16_t gui_width, gui_height;
   static uint16_t scroll_h;
-  uint16_t scroll_y, count, len;
+  uint16_t scroll_y, count, first, len;
   uint8_t y_offset, disp_max_column, ext_len;
   static uint8_t spacing;
   static bool scroll_ok;
@@ -457,7 +692,9 @@ S_M1_file_info *m1_fb_display(S_M1_Buttons_Status *button_status) {
   while (1) // Not an endless loop
   {
     if (button_status == NULL) {
-      res = f_opendir(&directory, pfb_hdl->info.dir_name);
+      // Key presses only move in the listing read here, the card is read
+      // again when a directory is entered or the browser is opened
+      res = m1_fb_dir_cache_load(pfb_hdl->info.dir_name);
 
       if (res != FR_OK) {
         pfb_hdl->info.status = FB_ERR_SDCARD;
@@ -469,15 +706,13 @@ S_M1_file_info *m1_fb_display(S_M1_Buttons_Status *button_status) {
         pfb_hdl->row_index = pfb_hdl->row_index_buffer[pfb_hdl->dir_level];
       }
 
-      num_of_files = 1;
-      while (num_of_files < FILE_BROWSER_MAX_FILES) {
-        res = f_readdir(&directory, &file_info);
-        if (res || !file_info.fname[0])
-          break;
-        if (!(file_info.fattrib &
-              (AM_HID | AM_SYS))) // Not a system or hidden file?
-          num_of_files++;
-      } // while (num_of_files < FILE_BROWSER_MAX_FILES)
+      num_of_files = m1_fb_dir_cache_count() + 1; // And the .. directory
+
+      // Entries may have been deleted since the position was saved
+      if (pfb_hdl->listing_index >= num_of_files)
+        pfb_hdl->listing_index = num_of_files - 1;
+      if (pfb_hdl->row_index > pfb_hdl->listing_index)
+        pfb_hdl->row_index = pfb_hdl->listing_index;
 
       scroll_h = gui_height / num_of_files;
 
@@ -524,14 +759,6 @@ S_M1_file_info *m1_fb_display(S_M1_Buttons_Status *button_status) {
               pfb_hdl->info.dir_name[l] = 0;
               l--;
             } // while (l >= 0 && !k)
-            pfb_hdl->info.dir_name =
-                (char *)realloc(pfb_hdl->info.dir_name, l + 2);
-            pfb_hdl->listing_index_buffer =
-                (uint16_t *)realloc(pfb_hdl->listing_index_buffer,
-                                    pfb_hdl->dir_level * sizeof(uint16_t));
-            pfb_hdl->row_index_buffer =
-                (uint16_t *)realloc(pfb_hdl->row_index_buffer,
-                                    pfb_hdl->dir_level * sizeof(uint16_t));
             pfb_hdl->dir_level--;
           } else // Being at root directory
           {
@@ -541,166 +768,139 @@ S_M1_file_info *m1_fb_display(S_M1_Buttons_Status *button_status) {
           }
           pfb_hdl->info.file_is_selected = FALSE;
 
-          f_closedir(&directory);
           button_status = NULL; // Reset so that the conditional loop will be
                                 // executed one more time
           continue;
         } // if (!pfb_hdl->listing_index)
 
-        if (this_file.fattrib & AM_DIR) {
+        fname = m1_fb_dir_cache_entry(pfb_hdl->listing_index - 1, &fattrib);
+        if (fname == NULL)
+          break;
+
+        if (fattrib & AM_DIR) {
           if (pfb_hdl->dir_level >= DIRECTORY_MAX_DEPTH_LEVEL)
             break; // Do nothing if it goes too deep
-          pfb_hdl->info.dir_name = (TCHAR *)realloc(
-              pfb_hdl->info.dir_name,
-              strlen(pfb_hdl->info.dir_name) + 1 + 1 + strlen(this_file.fname));
+          if (strlen(pfb_hdl->info.dir_name) + 1 + strlen(fname) >=
+              FB_NAME_BLOCK_SIZE)
+            break; // Do nothing if the path gets too long
           strcat(pfb_hdl->info.dir_name, "/");
-          strcat(pfb_hdl->info.dir_name, this_file.fname);
+          strcat(pfb_hdl->info.dir_name, fname);
           pfb_hdl->listing_index_buffer[pfb_hdl->dir_level] =
               pfb_hdl->listing_index;
           pfb_hdl->row_index_buffer[pfb_hdl->dir_level] = pfb_hdl->row_index;
           pfb_hdl->dir_level++;
-          pfb_hdl->listing_index_buffer =
-              (uint16_t *)realloc(pfb_hdl->listing_index_buffer,
-                                  (pfb_hdl->dir_level + 1) * sizeof(uint16_t));
-          pfb_hdl->row_index_buffer =
-              (uint16_t *)realloc(pfb_hdl->row_index_buffer,
-                                  (pfb_hdl->dir_level + 1) * sizeof(uint16_t));
           pfb_hdl->listing_index_buffer[pfb_hdl->dir_level] = 0;
           pfb_hdl->row_index_buffer[pfb_hdl->dir_level] = 0;
           pfb_hdl->info.file_is_selected = FALSE;
 
-          f_closedir(&directory);
           button_status = NULL; // Reset so that the conditional loop will be
                                 // executed one more time
           continue;
-        } // if (this_file.fattrib & AM_DIR)
+        } // if (fattrib & AM_DIR)
 
         else {
-          if (pfb_hdl->info.file_name)
-            free(pfb_hdl->info.file_name);
-          pfb_hdl->info.file_name =
-              (char *)calloc(strlen(this_file.fname) + 1, 1);
+          if (pfb_hdl->info.file_name == NULL)
+            pfb_hdl->info.file_name = m1_mem_pool_alloc(&fb_name_pool);
           assert_param(pfb_hdl->info.file_name != NULL);
           if (pfb_hdl->info.file_name) {
-            strcpy(pfb_hdl->info.file_name, this_file.fname);
+            strcpy(pfb_hdl->info.file_name, fname);
             pfb_hdl->info.status = FB_OK;
             pfb_hdl->info.file_is_selected = TRUE;
           } // if ( pfb_hdl->info.file_name )
 
-          f_closedir(&directory);
           break;
         }
       } // else if ( button_status->event[BUTTON_OK_KP_ID]==BUTTON_EVENT_CLICK )
     } // else
     // if (button_status==NULL)
 
-    res = f_readdir(&directory, 0);
-    if (res != FR_OK) {
-      pfb_hdl->info.status = FB_ERR_SDCARD;
-      break;
-    } // if ( res != FR_OK)
-
     // Clear GUI
     m1_u8g2_firstpage();
     // m1_lcd_cleardisplay();
 
-    count = 0;
+    // Only the visible page is drawn
+    first = pfb_hdl->listing_index - pfb_hdl->row_index;
     y_offset = 0;
-    while (count < num_of_files) {
+    for (count = first; count < num_of_files && count < first + gui_max_row;
+         count++) {
       name[0] = 0;
-      if (count) {
-        res = f_readdir(&directory, &file_info);
-        if (res || !file_info.fname[0])
+      if (!count) {
+        strcpy(name, "..");
+        fb_icon = &menu_fb_icon_prev;
+      } else {
+        fname = m1_fb_dir_cache_entry(count - 1, &fattrib);
+        if (fname == NULL)
           break;
-
-        if ((file_info.fattrib & (AM_HID | AM_SYS))) // Hidden and System file?
-          continue;
-      }
-
-      if ((count >= pfb_hdl->listing_index - pfb_hdl->row_index) &&
-          (count < pfb_hdl->listing_index - pfb_hdl->row_index + gui_max_row)) {
-        if (!count) {
-          strcpy(name, "..");
-          fb_icon = &menu_fb_icon_prev;
+        len = strlen(fname);
+        disp_max_column = gui_max_column - 1 - scroll_ok;
+        if (len <= disp_max_column) {
+          strcpy(name, fname);
         } else {
-          len = strlen(file_info.fname);
-          disp_max_column = gui_max_column - 1 - scroll_ok;
-          if (len <= disp_max_column) {
-            strcpy(name, file_info.fname);
+          if (fattrib & AM_DIR) {
+            strncpy(name, fname, disp_max_column - 2);
+            name[disp_max_column - 2] = 0;
+            strcat(name, "..");
           } else {
-            if (file_info.fattrib & AM_DIR) {
-              strncpy(name, file_info.fname, disp_max_column - 2);
+            flag = FALSE;
+            while (len) {
+              if (fname[len - 1] == '.') {
+                flag = TRUE;
+                break;
+              }
+              len--;
+            }
+            if (!flag) // filename without extension
+            {
+              strncpy(name, fname, disp_max_column - 2);
               name[disp_max_column - 2] = 0;
               strcat(name, "..");
             } else {
-              flag = FALSE;
-              while (len) {
-                if (file_info.fname[len - 1] == '.') {
-                  flag = TRUE;
-                  break;
-                }
-                len--;
+              const char *dot = strrchr(fname, '.');
+              if (dot) {
+                ext_len = strlen(dot);
+                if (ext_len > 4)
+                  ext_len = 4;
+              } else {
+                ext_len = 0;
               }
-              if (!flag) // filename without extension
-              {
-                strncpy(name, file_info.fname, disp_max_column - 2);
-                name[disp_max_column - 2] = 0;
+
+              if (len > disp_max_column) {
+                strncpy(name, fname, disp_max_column - 2 - ext_len);
+                name[disp_max_column - 2 - ext_len] = 0;
                 strcat(name, "..");
+                if (dot)
+                  strncat(name, dot, 4);
               } else {
-                const char *dot = strrchr(file_info.fname, '.');
-                if (dot) {
-                  ext_len = strlen(dot);
-                  if (ext_len > 4)
-                    ext_len = 4;
-                } else {
-                  ext_len = 0;
-                }
-
-                if (len > disp_max_column) {
-                  strncpy(name, file_info.fname, disp_max_column - 2 - ext_len);
-                  name[disp_max_column - 2 - ext_len] = 0;
-                  strcat(name, "..");
-                  if (dot)
-                    strncat(name, dot, 4);
-                } else {
-                  strncpy(name, file_info.fname, disp_max_column);
-                  name[disp_max_column] = 0;
-                }
-              } // else
+                strncpy(name, fname, disp_max_column);
+                name[disp_max_column] = 0;
+              }
             } // else
           } // else
+        } // else
 
-          if (file_info.fattrib & AM_DIR) {
-            fb_icon = &menu_fb_icon_dir;
-          } else {
-            f_ext = m1_fb_get_file_type(file_info.fname);
-            if (f_ext == F_EXT_DATA)
-              fb_icon = &menu_fb_icon_data;
-            else
-              fb_icon = &menu_fb_icon_other;
-          }
+        if (fattrib & AM_DIR) {
+          fb_icon = &menu_fb_icon_dir;
+        } else {
+          f_ext = m1_fb_get_file_type((char *)fname);
+          if (f_ext == F_EXT_DATA)
+            fb_icon = &menu_fb_icon_data;
+          else
+            fb_icon = &menu_fb_icon_other;
+        }
+      } // else
+        // if (!count)
 
-          if (count == pfb_hdl->listing_index) {
-            memcpy(&this_file, &file_info, sizeof(FILINFO));
-          }
-        } // else
-          // if (!count)
-
-        y_offset += spacing;
-        // Draw icon of folder or file
-        u8g2_DrawXBMP(plcd_hdl, pfb_hdl->x,
-                      pfb_hdl->y + y_offset +
-                          (pfb_hdl->font_h - fb_icon->icon_h),
-                      fb_icon->icon_w, fb_icon->icon_h, fb_icon->pdata);
-
-        y_offset += pfb_hdl->font_h;
-        // Draw text of file name or folder name
-        u8g2_DrawStr(plcd_hdl, pfb_hdl->x + fb_icon->icon_w + 2,
-                     pfb_hdl->y + y_offset, name);
-      } // if ((count >= pfb_hdl->listing_index - pfb_hdl->row_index) &&
-        // (count < pfb_hdl->listing_index - pfb_hdl->row_index + gui_max_row))
-      count++;
-    } // while (count < num_of_files)
+      y_offset += spacing;
+      // Draw icon of folder or file
+      u8g2_DrawXBMP(plcd_hdl, pfb_hdl->x,
+                    pfb_hdl->y + y_offset + (pfb_hdl->font_h - fb_icon->icon_h),
+                    fb_icon->icon_w, fb_icon->icon_h, fb_icon->pdata);
+
+      y_offset += pfb_hdl->font_h;
+      // Draw text of file name or folder name
+      m1_draw_str(plcd_hdl, pfb_hdl->x + fb_icon->icon_w + 2,
+                  pfb_hdl->y + y_offset, name);
+    } // for (count = first; ...)
 
     // Draw a frame around the selected file/sub-directory
     u8g2_DrawFrame(plcd_hdl, pfb_hdl->x,
@@ -739,7 +939,9 @@ S_M1_file_info *m1_fb_display(S_M1_Buttons_Status *button_status) {
 
 /******************************************************************************/
 /*
- *	This function displays files and folders to the console for CLI
+ *	This function displays files and folders to the console for CLI. It runs
+ *	in the CLI task, so it streams the directory in one pass instead of using
+ *	the browser's cache.
  *
  */
 /******************************************************************************/
@@ -748,88 +950,57 @@ FRESULT m1_fb_listing(const char *dir_name) {
   FRESULT res;
   DIR directory;
   FILINFO file_info;
-#if 0 /* Unused: stub for future work. May need removal later. */
-    FILINFO this_file;
-#endif
-  uint16_t num_of_files;
-  uint16_t count, len;
+  uint16_t len;
   bool flag;
 
-  while (1) // Not an endless loop
-  {
-    res = f_opendir(&directory, dir_name);
-    if (res != FR_OK) {
-      break;
-    }
-    num_of_files = 1;
-    while (num_of_files < FILE_BROWSER_MAX_FILES) {
-      res = f_readdir(&directory, &file_info);
-      if (res || !file_info.fname[0])
-        break;
-      if (!(file_info.fattrib &
-            (AM_HID | AM_SYS))) // Not a system or hidden file?
-        num_of_files++;
-    } // while (num_of_files < FILE_BROWSER_MAX_FILES)
-
-    res = f_readdir(&directory, 0);
-    if (res != FR_OK) {
-      break;
-    } // if ( res != FR_OK)
+  res = f_opendir(&directory, dir_name);
+  if (res != FR_OK)
+    return res;
 
-    count = 0;
-    while (count < num_of_files) {
-      name[0] = 0;
-      if (count) {
-        res = f_readdir(&directory, &file_info);
-        if (res || !file_info.fname[0])
-          break;
+  M1_LOG_N(M1_LOGDB_TAG, "..\r\n");
+  while (1) {
+    res = f_readdir(&directory, &file_info);
+    if (res || !file_info.fname[0])
+      break;
 
-        if ((file_info.fattrib & (AM_HID | AM_SYS))) // Hidden and System file?
-          continue;
-      } // if (count)
+    if ((file_info.fattrib & (AM_HID | AM_SYS))) // Hidden and System file?
+      continue;
 
-      if (!count) {
-        strcpy(name, "..");
+    if (strlen(file_info.fname) <= FILENAME_LEN_ON_CLI_MAX) {
+      strcpy(name, file_info.fname);
+    } else {
+      if (file_info.fattrib & AM_DIR) {
+        strncpy(name, file_info.fname, FILENAME_LEN_ON_CLI_MAX);
+        name[FILENAME_LEN_ON_CLI_MAX] = 0;
+        strcat(name, "..");
       } else {
-        if (strlen(file_info.fname) <= FILENAME_LEN_ON_CLI_MAX) {
-          strcpy(name, file_info.fname);
+        len = strlen(file_info.fname);
+        flag = FALSE;
+        while (len) {
+          if (file_info.fname[len - 1] == '.') {
+            flag = TRUE;
+            break;
+          }
+          len--;
+        }
+        if (!flag || len == 1) {
+          strncpy(name, file_info.fname, FILENAME_LEN_ON_CLI_MAX);
+          name[FILENAME_LEN_ON_CLI_MAX] = 0;
+          strcat(name, "..");
         } else {
-          if (file_info.fattrib & AM_DIR) {
-            strncpy(name, file_info.fname, FILENAME_LEN_ON_CLI_MAX);
-            name[FILENAME_LEN_ON_CLI_MAX] = 0;
-            strcat(name, "..");
-          } else {
-            len = strlen(file_info.fname);
-            flag = FALSE;
-            while (len) {
-              if (file_info.fname[len - 1] == '.') {
-                flag = TRUE;
-                break;
-              }
-              len--;
-            }
-            if (!flag || len == 1) {
-              strncpy(name, file_info.fname, FILENAME_LEN_ON_CLI_MAX);
-              name[FILENAME_LEN_ON_CLI_MAX] = 0;
-              strcat(name, "..");
-            } else {
-              strncpy(name, file_info.fname,
-                      FILENAME_LEN_ON_CLI_MAX - strlen(file_info.fname + len));
-              strncat(name, "..",
-                      FILENAME_LEN_ON_CLI_MAX -
-                          (strlen(name) + strlen(file_info.fname + len)));
-              strncat(name, file_info.fname + len,
-                      FILENAME_LEN_ON_CLI_MAX - strlen(name));
-            }
-          } // else
-        } // else
+          strncpy(name, file_info.fname,
+                  FILENAME_LEN_ON_CLI_MAX - strlen(file_info.fname + len));
+          strncat(name, "..",
+                  FILENAME_LEN_ON_CLI_MAX -
+                      (strlen(name) + strlen(file_info.fname + len)));
+          strncat(name, file_info.fname + len,
+                  FILENAME_LEN_ON_CLI_MAX - strlen(name));
+        }
       } // else
-        // if (!count)
-      M1_LOG_N(M1_LOGDB_TAG, "%s\r\n", name);
-      count++;
-    } // while (count < num_of_files)
-    break; // End this loop
-  } // while (1) // Not an endless loop
+    } // else
+    M1_LOG_N(M1_LOGDB_TAG, "%s\r\n", name);
+  } // while (1)
+  f_closedir(&directory);
 
   return res;
 } // FRESULT m1_fb_listing(const char *dir_name)
@@ -842,19 +1013,8 @@ FRESULT m1_fb_listing(const char *dir_name) {
 /******************************************************************************/
 void m1_fb_deinit(void) {
   if (pfb_hdl) {
-    if (pfb_hdl->listing_index_buffer)
-      free(pfb_hdl->listing_index_buffer);
-
-    if (pfb_hdl->row_index_buffer)
-      free(pfb_hdl->row_index_buffer);
-
-    if (pfb_hdl->info.dir_name)
-      free(pfb_hdl->info.dir_name);
-
-    if (pfb_hdl->info.file_name)
-      free(pfb_hdl->info.file_name);
-
-    free(pfb_hdl);
+    m1_mem_pool_free(&fb_name_pool, pfb_hdl->info.dir_name);
+    m1_mem_pool_free(&fb_name_pool, pfb_hdl->info.file_name);
     pfb_hdl = NULL;
   } // if (pfb_hdl)
 } // void m1_fb_deinit(void)
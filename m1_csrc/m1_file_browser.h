@@ -41,6 +41,16 @@ typedef struct {
   uint8_t dir_level;
 } S_M1_file_browser_hdl;
 
+/* Directory listings are read once into a sorted index, directories first
+ * and then by name, with digit runs compared as numbers. The index is kept
+ * until another directory is loaded or the SD card is written. */
+FRESULT m1_fb_dir_cache_load(const char *dir_name);
+void m1_fb_dir_cache_invalidate(void);
+uint16_t m1_fb_dir_cache_count(void);
+bool m1_fb_dir_cache_truncated(void);
+const char *m1_fb_dir_cache_entry(uint16_t index, BYTE *attrib);
+int m1_fb_name_cmp(const char *name1, const char *name2);
+
 S_M1_file_browser_hdl *m1_fb_init(u8g2_t *lcd_hdl);
 void m1_fb_deinit(void);
 void m1_fb_popup(void);
@@ -6,29 +6,71 @@
 *
 * Driver for FUSB302
 *
+* Type-C attach detection and USB PD PHY of the m1_usb_pd.c sink. The task
+* wakes on INT_N or on the next timer of the policy engine, and passes the
+* negotiated input power to the charger.
+*
 * M1 Project
 *
-* Reference:
+* Reference: FUSB302B datasheet Rev. 5
 */
 
 /*************************** I N C L U D E S **********************************/
 
 #include <stdint.h>
+#include <string.h>
 #include "stm32h5xx_hal.h"
 #include "main.h"
+#include "semphr.h"
 #include "m1_i2c.h"
 #include "m1_power_ctl.h"
 #include "m1_bq25896.h"
 #include "m1_fusb302.h"
+#include "m1_usb_pd.h"
+#include "m1_log_debug.h"
+#include "battery.h"
 
 /*************************** D E F I N E S ************************************/
 
+#define M1_LOGDB_TAG	"USBPD"
+
+#define PD_SINK_MAX_MV			12000 // BQ25896 input is rated up to 14V
+#define PD_SINK_MAX_MA			3000
+#define PD_TASK_POLL_MS			500 // Wakes at least this often, INT_N is not latched by the EXTI
+#define PD_TX_TIMEOUT_MS		5 // Message with its retries
+#define PD_MEAS_SETTLE_MS		2 // BC_LVL after switching the measure block
+#define PD_RX_BUF_LEN			(1 + USB_PD_MAX_MSG_LEN + 4) // Token, message and CRC
+
 //************************** C O N S T A N T **********************************/
 
 //************************** S T R U C T U R E S *******************************
 
 /***************************** V A R I A B L E S ******************************/
 
+TaskHandle_t usb_pd_task_hdl;
+
+static SemaphoreHandle_t pd_int_sem;
+static StaticSemaphore_t pd_int_sem_ctrl;
+static bool pd_present;
+static uint8_t pd_cc; // REG02_MEAS_CC1 or REG02_MEAS_CC2, 0 if detached
+static uint8_t pd_pending_inta; // Hard Reset read while polling a transmission
+static S_M1_UsbPd_Sink pd_sink;
+
+static bool pd_transmit(void *ctx, const S_M1_UsbPd_Msg *pmsg);
+static void pd_send_hard_reset(void *ctx);
+static void pd_contract(void *ctx, uint16_t mv, uint16_t ma);
+
+static const S_M1_UsbPd_Sink_Config pd_sink_cfg =
+{
+	.max_mv = PD_SINK_MAX_MV,
+	.max_ma = PD_SINK_MAX_MA,
+	.spec_rev = USB_PD_REV20, // As answered by the AUTO_CRC GoodCRC
+	.transmit = pd_transmit,
+	.hard_reset = pd_send_hard_reset,
+	.contract = pd_contract,
+	.ctx = NULL
+};
+
 /********************* F U N C T I O N   P R O T O T Y P E S ******************/
 
 uint8_t pd_getID(void);
@@ -42,6 +84,16 @@ void pd_setBit(uint8_t *reg, uint8_t mask);
 void pd_unsetBit(uint8_t *reg, uint8_t mask);
 void pd_fusb302_init(void);
 void pd_cli_status(void);
+void pd_usbc_int_isr(void);
+void usb_pd_task(void *param);
+static bool pd_read(uint8_t reg, uint8_t *pdata, uint8_t count);
+static bool pd_write(uint8_t reg, uint8_t *pdata, uint8_t count);
+static void pd_phy_reset(void);
+static uint8_t pd_detect_cc(void);
+static void pd_attach(uint8_t cc);
+static void pd_detach(void);
+static void pd_rx_drain(void);
+static void pd_service(void);
 
 /*************** F U N C T I O N   I M P L E M E N T A T I O N ****************/
 
@@ -58,7 +110,7 @@ void pd_cli_status(void);
 /*============================================================================*/
 uint8_t pd_getID()
 {
-	uint8_t reg = bq_readRegister(REG01_ADDR);
+	uint8_t reg = pd_readRegister(REG01_ADDR);
 
 	return reg;
 }
@@ -200,26 +252,340 @@ void pd_unsetBit(uint8_t *reg, uint8_t mask)
 
 /*============================================================================*/
 /*
- * Description:
- *
+ * This function resets the FUSB302 to a sink with Rd on both CC pins and
+ * unmasks the interrupts the PD task runs on. The task does nothing if the
+ * chip does not answer.
  */
 /*============================================================================*/
 void pd_fusb302_init(void)
 {
-	uint8_t reg = pd_getID();
-    (void)reg; /* Unused: stub for future work. May need removal later. */
-	reg = pd_measure(0);
-	reg = pd_measure(1);
+	uint8_t id;
+
+	m1_usb_pd_sink_init(&pd_sink, &pd_sink_cfg);
+	if ( pd_int_sem==NULL )
+		pd_int_sem = xSemaphoreCreateBinaryStatic(&pd_int_sem_ctrl);
+
+	pd_present = false;
+	pd_cc = 0;
+	if ( !pd_setRegister(REG0C_ADDR, REG0C_RST_I2C) )
+		return;
+	if ( !pd_read(REG01_ADDR, &id, 1) || !(id & 0x80) ) // Version ID is 1xxx
+		return;
+
+	pd_setRegister(REG0B_ADDR, REG0B_PWR_ALL);
+	pd_setRegister(REG02_ADDR, REG02_PDWN);
+	pd_setRegister(REG09_ADDR, REG09_N_RETRIES_3 | REG09_AUTO_RETRY);
+	pd_setRegister(REG0A_ADDR, REG0A_M_ALL_BUT_VBUSOK);
+	pd_setRegister(REG0E_ADDR, REG0E_M_PD);
+	pd_setRegister(REG0F_ADDR, REG0F_M_NONE);
+	pd_setRegister(REG06_ADDR, REG06_HOST_CUR_USB); // INT_N enabled
+	pd_present = true;
+
+	M1_LOG_I(M1_LOGDB_TAG, "FUSB302 ID 0x%02X\r\n", id);
 } // void pd_fusb302_init(void)
 
 
+
 /*============================================================================*/
 /*
- * Description:
- *
+ * This function prints the state of the sink, the source capabilities and
+ * the contract.
  */
 /*============================================================================*/
 void pd_cli_status(void)
 {
+	uint8_t i;
+	uint32_t pdo;
+
+	if ( !pd_present )
+	{
+		M1_LOG_N("", "FUSB302 not found\r\n");
+		return;
+	}
+
+	M1_LOG_N("", "State: %s, CC%d\r\n", m1_usb_pd_sink_state_name(pd_sink.state),
+		(pd_cc==REG02_MEAS_CC1) ? 1 : (pd_cc==REG02_MEAS_CC2) ? 2 : 0);
+	for ( i = 0; i < pd_sink.n_pdos; i++ )
+	{
+		pdo = pd_sink.pdos[i];
+		if ( USB_PD_PDO_TYPE(pdo)==USB_PD_PDO_FIXED )
+			M1_LOG_N("", "PDO %d: %d mV %d mA%s\r\n", i + 1, USB_PD_PDO_FIXED_MV(pdo), USB_PD_PDO_FIXED_MA(pdo),
+				(i + 1==pd_sink.req_position) ? " *" : "");
+		else
+			M1_LOG_N("", "PDO %d: type %d (0x%08lX)\r\n", i + 1, USB_PD_PDO_TYPE(pdo), (unsigned long)pdo);
+	}
+	M1_LOG_N("", "Contract: %s %d mV %d mA, hard resets %d\r\n", pd_sink.explicit_contract ? "PD" : "Type-C",
+		pd_sink.contract_mv, pd_sink.contract_ma, pd_sink.hard_resets);
+} // void pd_cli_status(void)
+
+
+
+// INT_N fell, called from the EXTI interrupt
+void pd_usbc_int_isr(void)
+{
+	BaseType_t woken = pdFALSE;
 
-}
+	if ( pd_int_sem==NULL )
+		return;
+	xSemaphoreGiveFromISR(pd_int_sem, &woken);
+	portYIELD_FROM_ISR(woken);
+} // void pd_usbc_int_isr(void)
+
+
+
+/*============================================================================*/
+/*
+ * This task serves the FUSB302: attach and detach, received messages and
+ * the timers of the policy engine.
+ */
+/*============================================================================*/
+void usb_pd_task(void *param)
+{
+	uint32_t wait_ms;
+
+	(void)param;
+	for (;;)
+	{
+		if ( !pd_present )
+		{
+			vTaskSuspend(NULL);
+			continue;
+		}
+		wait_ms = m1_usb_pd_sink_timeout(&pd_sink, HAL_GetTick());
+		if ( wait_ms > PD_TASK_POLL_MS )
+			wait_ms = PD_TASK_POLL_MS;
+		xSemaphoreTake(pd_int_sem, pdMS_TO_TICKS(wait_ms));
+		pd_service();
+	} // for (;;)
+} // void usb_pd_task(void *param)
+
+
+
+static bool pd_read(uint8_t reg, uint8_t *pdata, uint8_t count)
+{
+	S_M1_I2C_Trans_Inf i2c_inf;
+
+	i2c_inf.dev_id = I2C_DEVICE_FUSB302;
+	i2c_inf.timeout = I2C_READ_TIMEOUT;
+	i2c_inf.trans_type = I2C_TRANS_READ_REGISTER_MULTIPLE;
+	i2c_inf.reg_address = reg;
+	i2c_inf.pdata = pdata;
+	i2c_inf.data_len = count;
+
+	return (m1_i2c_hal_trans_req(&i2c_inf)==HAL_OK);
+} // static bool pd_read(uint8_t reg, uint8_t *pdata, uint8_t count)
+
+
+
+static bool pd_write(uint8_t reg, uint8_t *pdata, uint8_t count)
+{
+	S_M1_I2C_Trans_Inf i2c_inf;
+
+	i2c_inf.dev_id = I2C_DEVICE_FUSB302;
+	i2c_inf.timeout = I2C_WRITE_TIMEOUT;
+	i2c_inf.trans_type = I2C_TRANS_WRITE_REGISTER_MULTIPLE;
+	i2c_inf.reg_address = reg;
+	i2c_inf.pdata = pdata;
+	i2c_inf.data_len = count;
+
+	return (m1_i2c_hal_trans_req(&i2c_inf)==HAL_OK);
+} // static bool pd_write(uint8_t reg, uint8_t *pdata, uint8_t count)
+
+
+
+// Empties both FIFOs and restarts the PD logic, MessageIDs included
+static void pd_phy_reset(void)
+{
+	pd_setRegister(REG06_ADDR, REG06_HOST_CUR_USB | REG06_TX_FLUSH);
+	pd_setRegister(REG07_ADDR, REG07_RX_FLUSH);
+	pd_setRegister(REG0C_ADDR, REG0C_RST_PD);
+} // static void pd_phy_reset(void)
+
+
+
+/*============================================================================*/
+/*
+ * This function finds the CC pin the source pulls up, by measuring one and
+ * then the other. It returns REG02_MEAS_CC1 or REG02_MEAS_CC2, 0 if none.
+ */
+/*============================================================================*/
+static uint8_t pd_detect_cc(void)
+{
+	const uint8_t cc[2] = {REG02_MEAS_CC1, REG02_MEAS_CC2};
+	uint8_t i, status0;
+
+	for ( i = 0; i < 2; i++ )
+	{
+		pd_setRegister(REG02_ADDR, REG02_PDWN | cc[i]);
+		vTaskDelay(pdMS_TO_TICKS(PD_MEAS_SETTLE_MS));
+		if ( pd_read(REG40_ADDR, &status0, 1) && (status0 & REG40_BC_LVL) )
+			return cc[i];
+	}
+	pd_setRegister(REG02_ADDR, REG02_PDWN);
+
+	return 0;
+} // static uint8_t pd_detect_cc(void)
+
+
+
+static void pd_attach(uint8_t cc)
+{
+	pd_cc = cc;
+	pd_setRegister(REG03_ADDR, REG03_SPECREV_20 | REG03_AUTO_CRC | ((cc==REG02_MEAS_CC1) ? REG03_TXCC1 : REG03_TXCC2));
+	pd_phy_reset();
+	pd_pending_inta = 0;
+	m1_usb_pd_sink_attach(&pd_sink, HAL_GetTick());
+	M1_LOG_I(M1_LOGDB_TAG, "Attached on CC%d\r\n", (cc==REG02_MEAS_CC1) ? 1 : 2);
+} // static void pd_attach(uint8_t cc)
+
+
+
+static void pd_detach(void)
+{
+	pd_cc = 0;
+	pd_setRegister(REG03_ADDR, REG03_SPECREV_20); // Transmitter off, no GoodCRC
+	pd_setRegister(REG02_ADDR, REG02_PDWN);
+	pd_phy_reset();
+	m1_usb_pd_sink_detach(&pd_sink);
+	M1_LOG_I(M1_LOGDB_TAG, "Detached\r\n");
+} // static void pd_detach(void)
+
+
+
+/*============================================================================*/
+/*
+ * This function passes the SOP messages of the RX FIFO to the policy engine.
+ * GoodCRC and cable plug messages are dropped.
+ */
+/*============================================================================*/
+static void pd_rx_drain(void)
+{
+	S_M1_UsbPd_Msg msg;
+	uint8_t buf[PD_RX_BUF_LEN];
+	uint8_t status1, n_obj;
+
+	while ( pd_read(REG41_ADDR, &status1, 1) && !(status1 & REG41_RX_EMPTY) )
+	{
+		// Token and header, then the data objects and the CRC
+		if ( !pd_read(REG43_ADDR, buf, 3) )
+			break;
+		n_obj = USB_PD_HDR_NUM_OBJ(buf[1] | ((uint16_t)buf[2] << 8));
+		if ( !pd_read(REG43_ADDR, &buf[3], 4*n_obj + 4) )
+			break;
+		if ( (buf[0] & FUSB302_RX_SOP_MASK)!=FUSB302_RX_SOP )
+			continue;
+		if ( !m1_usb_pd_msg_decode(&buf[1], 2 + 4*n_obj, &msg) )
+			continue;
+		if ( !n_obj && USB_PD_HDR_TYPE(msg.header)==USB_PD_CTRL_GOODCRC )
+			continue;
+		m1_usb_pd_sink_rx(&pd_sink, &msg, HAL_GetTick());
+	} // while ( pd_read(REG41_ADDR, &status1, 1) && !(status1 & REG41_RX_EMPTY) )
+} // static void pd_rx_drain(void)
+
+
+
+/*============================================================================*/
+/*
+ * This function reads and clears the interrupts with the status in one burst,
+ * then handles VBUS, Hard Reset from the source, messages and timers.
+ */
+/*============================================================================*/
+static void pd_service(void)
+{
+	uint8_t regs[REG42_ADDR - REG3E_ADDR + 1]; // Interrupta, Interruptb, Status0, Status1, Interrupt
+	uint8_t inta, status0, cc;
+
+	if ( !pd_read(REG3E_ADDR, regs, sizeof(regs)) )
+		return;
+	inta = regs[0] | pd_pending_inta;
+	pd_pending_inta = 0;
+	status0 = regs[REG40_ADDR - REG3E_ADDR];
+
+	if ( !(status0 & REG40_VBUSOK) )
+	{
+		if ( pd_sink.state!=USB_PD_SNK_DETACHED )
+			pd_detach();
+		return;
+	}
+	if ( pd_sink.state==USB_PD_SNK_DETACHED )
+	{
+		cc = pd_detect_cc();
+		if ( !cc )
+			return; // VBUS without a pull-up, a legacy cable
+		pd_attach(cc);
+		return; // Anything received before the attach was flushed
+	}
+
+	if ( inta & REG3E_I_HARDRST )
+	{
+		pd_phy_reset();
+		m1_usb_pd_sink_hard_reset_rx(&pd_sink, HAL_GetTick());
+	}
+	pd_rx_drain();
+	m1_usb_pd_sink_tick(&pd_sink, HAL_GetTick());
+} // static void pd_service(void)
+
+
+
+/*============================================================================*/
+/*
+ * This function sends a message through the TX FIFO and waits for its
+ * GoodCRC, with the retries of the FUSB302.
+ */
+/*============================================================================*/
+static bool pd_transmit(void *ctx, const S_M1_UsbPd_Msg *pmsg)
+{
+	uint8_t buf[5 + USB_PD_MAX_MSG_LEN + 4];
+	uint8_t inta, len, n = 0;
+	uint32_t start;
+
+	(void)ctx;
+	buf[n++] = FUSB302_TX_SOP1;
+	buf[n++] = FUSB302_TX_SOP1;
+	buf[n++] = FUSB302_TX_SOP1;
+	buf[n++] = FUSB302_TX_SOP2;
+	len = m1_usb_pd_msg_encode(pmsg, &buf[n + 1]);
+	buf[n++] = FUSB302_TX_PACKSYM | len;
+	n += len;
+	buf[n++] = FUSB302_TX_JAM_CRC;
+	buf[n++] = FUSB302_TX_EOP;
+	buf[n++] = FUSB302_TX_OFF;
+	buf[n++] = FUSB302_TX_ON;
+
+	pd_setRegister(REG06_ADDR, REG06_HOST_CUR_USB | REG06_TX_FLUSH);
+	if ( !pd_write(REG43_ADDR, buf, n) )
+		return false;
+
+	start = HAL_GetTick();
+	do
+	{
+		if ( !pd_read(REG3E_ADDR, &inta, 1) )
+			return false;
+		pd_pending_inta |= inta & REG3E_I_HARDRST;
+		if ( inta & REG3E_I_TXSENT )
+			return true;
+		if ( inta & REG3E_I_RETRYFAIL )
+			return false;
+	} while ( (HAL_GetTick() - start) < PD_TX_TIMEOUT_MS );
+
+	return false;
+} // static bool pd_transmit(void *ctx, const S_M1_UsbPd_Msg *pmsg)
+
+
+
+static void pd_send_hard_reset(void *ctx)
+{
+	(void)ctx;
+	pd_setRegister(REG09_ADDR, REG09_SEND_HARD_RESET | REG09_N_RETRIES_3 | REG09_AUTO_RETRY);
+	vTaskDelay(pdMS_TO_TICKS(PD_TX_TIMEOUT_MS));
+	pd_phy_reset();
+} // static void pd_send_hard_reset(void *ctx)
+
+
+
+// Implicit contracts keep the charger defaults
+static void pd_contract(void *ctx, uint16_t mv, uint16_t ma)
+{
+	(void)ctx;
+	battery_input_limit_set(mv, pd_sink.explicit_contract ? ma : 0);
+} // static void pd_contract(void *ctx, uint16_t mv, uint16_t ma)
@@ -16,6 +16,7 @@
 #include <stdint.h>
 #include "stm32h5xx_hal.h"
 #include <stdbool.h>
+#include "app_freertos.h"
 
 #define FUSB302_I2C_ADDR	0x44	//
 
@@ -24,7 +25,15 @@
 #define REG01_VER			0x0F
 
 #define REG02_ADDR 			0x02	// Switches0,	RW,	0x0000_0011
+#define REG02_PDWN			0x03	// Rd on CC1 and CC2, sink
+#define REG02_MEAS_CC1		0x04	// Measure block on CC1
+#define REG02_MEAS_CC2		0x08	// Measure block on CC2
+
 #define REG03_ADDR 			0x03	// Switches1,	RW,	0x0010_0000
+#define REG03_TXCC1			0x01	// BMC transmitter on CC1
+#define REG03_TXCC2			0x02	// BMC transmitter on CC2
+#define REG03_AUTO_CRC		0x04	// Answer GoodCRC in hardware
+#define REG03_SPECREV_20	0x20	// GoodCRC of PD Rev 2.0
 
 #define REG04_ADDR 			0x04	// Measure,		RW,	0x0011_0001
 #define REG04_MEAS_BIAS 	0x40	// Maesure BIAS
@@ -32,32 +41,67 @@
 
 #define REG05_ADDR 			0x05	// Slice,		RW,	0x0110_0000
 #define REG06_ADDR 			0x06	// Control0,	V,	0x0010_0100
+#define REG06_TX_FLUSH		0x40
+#define REG06_INT_MASK		0x20	// Masks the INT_N pin
+#define REG06_HOST_CUR_USB	0x04	// Default USB current, source only
+
 #define REG07_ADDR 			0x07	// Control1,	V,	0x0000_0000
+#define REG07_RX_FLUSH		0x04
 #define REG08_ADDR 			0x08	// Control2,	V,	0x0000_0010
 #define REG09_ADDR 			0x09	// Control3,	V,	0x0000_0110
+#define REG09_SEND_HARD_RESET	0x40
+#define REG09_N_RETRIES_3	0x06
+#define REG09_AUTO_RETRY	0x01
+
 #define REG0A_ADDR 			0x0A	// Mask,		RW,	0x0000_0000
+#define REG0A_M_ALL_BUT_VBUSOK	0x7F
+
 #define REG0B_ADDR 			0x0B	// Power,		RW,	0x0000_0001
+#define REG0B_PWR_ALL		0x0F	// Bandgap, receiver, measure block and oscillator
 
 #define REG0C_ADDR 			0x0C	// Reset,		WC,	0x0000_0000
 #define REG0C_RST_PD		0x02	// Reset PD Logic
-#define REG0C_RST_I2C		0x02	// Reset PD Logic
+#define REG0C_RST_I2C		0x01	// Reset all registers
 
 
 #define REG0D_ADDR 			0x0D	// OCPreg,		RW,	0x0000_1111
 #define REG0E_ADDR 			0x0E	// Maska,		RW,	0x0000_0000
+#define REG0E_M_PD			0xEA	// All but HARDRST, TXSENT and RETRYFAIL
+
 #define REG0F_ADDR 			0x0F	// Maskb,		RW,	0x0000_0000
+#define REG0F_M_NONE		0x00	// GCRCSENT: a message was received
 
 #define REG10_ADDR 			0x10	// Control4,	RW,	0x0000_0000
 
 #define REG3C_ADDR 			0x3C	// Status0a,	R,	0x0000_0000
 #define REG3D_ADDR 			0x3D	// Status1a,	R,	0x0000_0000
 #define REG3E_ADDR 			0x3E	// Interrupta,	R,	0x0000_0000
+#define REG3E_I_HARDRST		0x01
+#define REG3E_I_TXSENT		0x04
+#define REG3E_I_RETRYFAIL	0x10
 #define REG3F_ADDR 			0x3F	// Interruptb,	R,	0x0000_0000
 #define REG40_ADDR 			0x40	// Status0,		R,	0x0000_0000
+#define REG40_VBUSOK		0x80
+#define REG40_BC_LVL		0x03	// Voltage on the measured CC, 0 if open
+
 #define REG41_ADDR 			0x41	// Status1,		R,	0x0010_1000
+#define REG41_RX_EMPTY		0x20
 #define REG42_ADDR 			0x42	// Interrupt,	R,	0x0000_0000
 #define REG43_ADDR 			0x43	// FIFOs,		RW,	0x0000_0000
 
+// TX FIFO tokens
+#define FUSB302_TX_SOP1		0x12
+#define FUSB302_TX_SOP2		0x13
+#define FUSB302_TX_PACKSYM	0x80	// | number of bytes that follow
+#define FUSB302_TX_JAM_CRC	0xFF
+#define FUSB302_TX_EOP		0x14
+#define FUSB302_TX_OFF		0xFE
+#define FUSB302_TX_ON		0xA1
+
+// RX FIFO token, first byte of a received packet
+#define FUSB302_RX_SOP_MASK	0xE0
+#define FUSB302_RX_SOP		0xE0	// SOP, the others are for cable plugs
+
 
 uint8_t pd_getID(void);
 uint8_t pd_measure(int vbus);
@@ -72,5 +116,9 @@ void pd_unsetBit(uint8_t *reg, uint8_t mask);
 void pd_fusb302_init(void);
 
 void pd_cli_status(void);
+void pd_usbc_int_isr(void);
+void usb_pd_task(void *param);
+
+extern TaskHandle_t usb_pd_task_hdl;
 
 #endif /* M1_FUSB302_H_ */
@@ -298,6 +298,7 @@ void firmware_update_get_image_file(void) {
   uint8_t fw_payload[FW_IMAGE_CHUNK_SIZE];
   size_t count, sum;
   uint32_t crc32ret, image_size, fwver_old;
+  bool crc_done;
   S_M1_FW_CONFIG_t fwconfig;
 
   f_info = storage_browse();
@@ -396,6 +397,7 @@ void firmware_update_get_image_file(void) {
       // Call the function to initialize this transaction.
       // Do not take the return value in this case. Input data can be anything.
       bl_get_crc_chunk(&crc32ret, 0, true, false); // CRC init
+      crc_done = false;
       sum = image_size;
       while (sum) {
         count = m1_fb_read_from_file(&hfile_fw, (char *)fw_payload,
@@ -420,6 +422,7 @@ void firmware_update_get_image_file(void) {
             // anything.
             bl_get_crc_chunk(&crc32ret, 1, false, true); // complete
           }
+          crc_done = true;
           break; // exit
         } // if ( count < FW_IMAGE_CHUNK_SIZE )
         else {
@@ -429,7 +432,8 @@ void firmware_update_get_image_file(void) {
             crc32ret = bl_get_crc_chunk((uint32_t *)fw_payload,
                                         count / FW_IMAGE_CRC_SIZE, false,
                                         true); // complete
-            break;                             // exit
+            crc_done = true;
+            break; // exit
           } // if ( !sum )
           else
             crc32ret =
@@ -447,6 +451,9 @@ void firmware_update_get_image_file(void) {
         }
       } // if ( !sum )
       else {
+        // Read failed or the file ended early, return the CRC peripheral
+        if (!crc_done)
+          bl_get_crc_chunk(&crc32ret, 0, false, true);
         uret = M1_FW_IMAGE_FILE_ACCESS_ERROR;
         break;
       }
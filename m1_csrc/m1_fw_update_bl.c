@@ -14,6 +14,7 @@
 
 #include "m1_fw_update_bl.h"
 #include "m1_fw_update.h"
+#include "m1_crc_hw.h"
 #include "m1_sub_ghz.h"
 #include "m1_system.h"
 #include "m1_watchdog.h"
@@ -80,6 +81,7 @@ uint8_t bl_crc_check(uint32_t image_size) {
   CRC_HandleTypeDef crchdl;
   uint32_t result, crc32;
 
+  m1_crc_hw_stream_begin();
   __HAL_RCC_CRC_CLK_ENABLE();
   crchdl.Instance = CRC;
   crchdl.Init.DefaultPolynomialUse = DEFAULT_POLYNOMIAL_ENABLE;
@@ -88,6 +90,7 @@ uint8_t bl_crc_check(uint32_t image_size) {
   crchdl.Init.OutputDataInversionMode = CRC_OUTPUTDATA_INVERSION_DISABLE;
   crchdl.InputDataFormat = CRC_INPUTDATA_FORMAT_WORDS;
   if (HAL_CRC_Init(&crchdl) != HAL_OK) {
+    m1_crc_hw_stream_end();
     return BL_CODE_CHK_ERROR;
   }
 
@@ -98,6 +101,7 @@ uint8_t bl_crc_check(uint32_t image_size) {
 
   __HAL_RCC_CRC_FORCE_RESET();
   __HAL_RCC_CRC_RELEASE_RESET();
+  m1_crc_hw_stream_end();
 
   crc32 = *(uint32_t *)(FW_CRC_ADDRESS + M1_FLASH_BANK_SIZE);
 
@@ -126,6 +130,8 @@ uint32_t bl_get_crc_chunk(uint32_t *data_scr, uint32_t len, bool crc_init,
   uint32_t result;
 
   if (crc_init) {
+    // Until the last chunk, an aborted update ends it with an empty last chunk
+    m1_crc_hw_stream_begin();
     __HAL_RCC_CRC_CLK_ENABLE();
     crchdl.Instance = CRC;
     crchdl.Init.DefaultPolynomialUse = DEFAULT_POLYNOMIAL_ENABLE;
@@ -137,6 +143,7 @@ uint32_t bl_get_crc_chunk(uint32_t *data_scr, uint32_t len, bool crc_init,
         CRC_OUTPUTDATA_INVERSION_DISABLE; // CRC_OUTPUTDATA_INVERSION_ENABLE;
     crchdl.InputDataFormat = CRC_INPUTDATA_FORMAT_WORDS;
     if (HAL_CRC_Init(&crchdl) != HAL_OK) {
+      m1_crc_hw_stream_end();
       return BL_CODE_CHK_ERROR;
     }
     result = HAL_CRC_Calculate(&crchdl, data_scr, 0);
@@ -147,6 +154,7 @@ uint32_t bl_get_crc_chunk(uint32_t *data_scr, uint32_t len, bool crc_init,
       HAL_CRC_DeInit(&crchdl);
       __HAL_RCC_CRC_FORCE_RESET();
       __HAL_RCC_CRC_RELEASE_RESET();
+      m1_crc_hw_stream_end();
     } // if ( last_chunk )
   } // else
 
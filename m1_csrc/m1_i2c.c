@@ -25,6 +25,7 @@ LED Driver (LP5562TMX/NOPB)			1100000							0x60, 0x61
 #include "app_freertos.h"
 #include "semphr.h"
 #include "m1_i2c.h"
+#include "m1_i2c_queue.h"
 
 /*************************** D E F I N E S ************************************/
 
@@ -47,15 +48,25 @@ static const uint8_t m1_i2c_addr[I2C_NUM_OF_DEVICES_MAX] = {I2C_DEVICE_ADD_BQ274
 /***************************** V A R I A B L E S ******************************/
 
 static I2C_HandleTypeDef *pi2chdl;
-static SemaphoreHandle_t mutex_i2c_trans;
+static SemaphoreHandle_t mutex_i2c_trans; // One task waits at a time
+static SemaphoreHandle_t sem_i2c_batch_done; // Given when any batch finishes
 
 /********************* F U N C T I O N   P R O T O T Y P E S ******************/
 
 HAL_StatusTypeDef m1_i2c_hal_trans_req(S_M1_I2C_Trans_Inf *trans_inf);
+HAL_StatusTypeDef m1_i2c_hal_batch_submit(S_M1_I2C_Batch *pbatch);
+HAL_StatusTypeDef m1_i2c_hal_batch_wait(S_M1_I2C_Batch *pbatch);
+HAL_StatusTypeDef m1_i2c_hal_batch_run(S_M1_I2C_Batch *pbatch);
 uint32_t m1_i2c_hal_get_error(void);
 
 void m1_i2c_hal_init(I2C_HandleTypeDef *phi2c);
 void m1_i2c_hal_deinit(void);
+static HAL_StatusTypeDef i2c_trans_start(S_M1_I2C_Trans_Inf *trans_inf);
+static HAL_StatusTypeDef i2c_trans_blocking(S_M1_I2C_Trans_Inf *trans_inf);
+static void i2c_batch_finished(S_M1_I2C_Batch *pbatch);
+static void i2c_transfer_done(I2C_HandleTypeDef *hi2c, HAL_StatusTypeDef stat);
+static void i2c_bus_recover(S_M1_I2C_Batch *pbatch);
+static bool i2c_irq_usable(void);
 
 /*************** F U N C T I O N   I M P L E M E N T A T I O N ****************/
 
@@ -76,6 +87,15 @@ void m1_i2c_hal_init(I2C_HandleTypeDef *phi2c)
 	// https://community.st.com/t5/stm32-mcus-embedded-software/hal-tick-problem/td-p/598944
 	mutex_i2c_trans = xSemaphoreCreateMutex();
 	assert(mutex_i2c_trans!=NULL);
+	sem_i2c_batch_done = xSemaphoreCreateBinary();
+	assert(sem_i2c_batch_done!=NULL);
+
+	m1_i2c_queue_init(i2c_trans_start, i2c_batch_finished);
+
+	HAL_NVIC_SetPriority(I2C1_EV_IRQn, configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY, 0);
+	HAL_NVIC_EnableIRQ(I2C1_EV_IRQn);
+	HAL_NVIC_SetPriority(I2C1_ER_IRQn, configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY, 0);
+	HAL_NVIC_EnableIRQ(I2C1_ER_IRQn);
 } // void m1_i2c_hal_init(I2C_HandleTypeDef *phi2c)
 
 
@@ -98,70 +118,327 @@ void m1_i2c_hal_deinit(void)
     */
     HAL_GPIO_DeInit(I2C_SCL_GPIO_Port, I2C_SCL_Pin);
     HAL_GPIO_DeInit(I2C_SDA_GPIO_Port, I2C_SDA_Pin);
+    HAL_NVIC_DisableIRQ(I2C1_EV_IRQn);
     HAL_NVIC_DisableIRQ(I2C1_ER_IRQn);
 
     if ( mutex_i2c_trans != NULL )
     	vSemaphoreDelete(mutex_i2c_trans);
+    if ( sem_i2c_batch_done != NULL )
+    	vSemaphoreDelete(sem_i2c_batch_done);
 } // void m1_i2c_hal_deinit(void)
 
 
 
 /*============================================================================*/
 /**
-  * @brief  Make a transaction with the I2C in blocking mode.
+  * @brief  Make a transaction with the I2C and wait for it. The task sleeps
+  *         while the transfer runs from the I2C interrupt.
   * @param  trans_inf an I2C object
   * @retval HAL status
   */
 /*============================================================================*/
 HAL_StatusTypeDef m1_i2c_hal_trans_req(S_M1_I2C_Trans_Inf *trans_inf)
 {
-	HAL_StatusTypeDef stat = HAL_OK;
+	S_M1_I2C_Batch batch = {0};
 
 	assert(trans_inf!=NULL);
 
+	batch.trans = trans_inf;
+	batch.count = 1;
+
+	return m1_i2c_hal_batch_run(&batch);
+} // HAL_StatusTypeDef m1_i2c_hal_trans_req(S_M1_I2C_Trans_Inf trans_inf)
+
+
+
+/*============================================================================*/
+/**
+  * @brief  Queue a batch of transactions and return at once. Its done
+  *         callback, if any, is called from the I2C interrupt.
+  * @param  pbatch batch to run, not in the queue already
+  * @retval HAL_OK if queued, HAL_BUSY if the batch is still in the queue
+  */
+/*============================================================================*/
+HAL_StatusTypeDef m1_i2c_hal_batch_submit(S_M1_I2C_Batch *pbatch)
+{
+	HAL_StatusTypeDef stat;
+	uint8_t i;
+
+	assert(pbatch!=NULL);
+	for ( i = 0; i < pbatch->count; i++ )
+		assert(pbatch->trans[i].dev_id < I2C_NUM_OF_DEVICES_MAX);
+
+	taskENTER_CRITICAL(); // The I2C interrupt runs the queue too
+	stat = m1_i2c_queue_submit(pbatch);
+	taskEXIT_CRITICAL();
+
+	return stat;
+} // HAL_StatusTypeDef m1_i2c_hal_batch_submit(S_M1_I2C_Batch *pbatch)
+
+
+
+/*============================================================================*/
+/**
+  * @brief  Wait for a submitted batch. A bus that makes no progress for the
+  *         sum of the batch timeouts is reset and the batch fails.
+  * @param  pbatch batch to wait for
+  * @retval status of the batch
+  */
+/*============================================================================*/
+HAL_StatusTypeDef m1_i2c_hal_batch_wait(S_M1_I2C_Batch *pbatch)
+{
+	uint32_t timeout = 0;
+	uint8_t i;
+
+	if ( !pbatch->busy )
+		return pbatch->status;
+
+	for ( i = 0; i < pbatch->count; i++ )
+		timeout += pbatch->trans[i].timeout;
+
 	xSemaphoreTake(mutex_i2c_trans, portMAX_DELAY);
+	while ( pbatch->busy )
+	{
+		// Any batch that finishes gives the semaphore, so check again
+		if ( xSemaphoreTake(sem_i2c_batch_done, pdMS_TO_TICKS(timeout) + 1)!=pdTRUE )
+		{
+			M1_LOG_E(M1_LOGDB_TAG, "Bus timeout, error 0x%lX\r\n", (unsigned long)pi2chdl->ErrorCode);
+			i2c_bus_recover(pbatch);
+		}
+	} // while ( pbatch->busy )
+	xSemaphoreGive(mutex_i2c_trans);
+
+	return pbatch->status;
+} // HAL_StatusTypeDef m1_i2c_hal_batch_wait(S_M1_I2C_Batch *pbatch)
+
+
+
+/*============================================================================*/
+/**
+  * @brief  Queue a batch of transactions and wait for it
+  * @param  pbatch batch to run
+  * @retval status of the batch, the first error if any
+  */
+/*============================================================================*/
+HAL_StatusTypeDef m1_i2c_hal_batch_run(S_M1_I2C_Batch *pbatch)
+{
+	HAL_StatusTypeDef stat;
+
+	// No interrupt to wait for, poll the bus if no batch is using it
+	if ( !i2c_irq_usable() )
+	{
+		if ( pbatch->busy || m1_i2c_queue_active()!=NULL )
+			return HAL_BUSY;
+		pbatch->status = HAL_OK;
+		for ( pbatch->n_done = 0; pbatch->n_done < pbatch->count; pbatch->n_done++ )
+		{
+			assert(pbatch->trans[pbatch->n_done].dev_id < I2C_NUM_OF_DEVICES_MAX);
+			pbatch->status = i2c_trans_blocking(&pbatch->trans[pbatch->n_done]);
+			if ( pbatch->status!=HAL_OK )
+				break;
+		}
+		return pbatch->status;
+	} // if ( !i2c_irq_usable() )
+
+	stat = m1_i2c_hal_batch_submit(pbatch);
+	if ( stat!=HAL_OK )
+		return stat;
+
+	return m1_i2c_hal_batch_wait(pbatch);
+} // HAL_StatusTypeDef m1_i2c_hal_batch_run(S_M1_I2C_Batch *pbatch)
+
+
+
+/*============================================================================*/
+/**
+  * @brief  Start a transaction in interrupt mode, called by the queue
+  * @param  trans_inf an I2C object
+  * @retval HAL status
+  */
+/*============================================================================*/
+static HAL_StatusTypeDef i2c_trans_start(S_M1_I2C_Trans_Inf *trans_inf)
+{
+	uint16_t addr = m1_i2c_addr[trans_inf->dev_id];
+
+	switch (trans_inf->trans_type)
+	{
+		case I2C_TRANS_READ_REGISTER:
+			return HAL_I2C_Mem_Read_IT(pi2chdl, addr, trans_inf->reg_address, I2C_MEMADD_SIZE_8BIT, &trans_inf->reg_data, 1);
+
+		case I2C_TRANS_WRITE_REGISTER:
+			return HAL_I2C_Mem_Write_IT(pi2chdl, addr, trans_inf->reg_address, I2C_MEMADD_SIZE_8BIT, &trans_inf->reg_data, 1);
+
+		case I2C_TRANS_READ_DATA:
+			return HAL_I2C_Master_Receive_IT(pi2chdl, addr, trans_inf->pdata, trans_inf->data_len);
+
+		case I2C_TRANS_WRITE_DATA:
+			return HAL_I2C_Master_Transmit_IT(pi2chdl, addr, trans_inf->pdata, trans_inf->data_len);
+
+		case I2C_TRANS_READ_REGISTER_MULTIPLE:
+			return HAL_I2C_Mem_Read_IT(pi2chdl, addr, trans_inf->reg_address, I2C_MEMADD_SIZE_8BIT, trans_inf->pdata, trans_inf->data_len);
+
+		case I2C_TRANS_WRITE_REGISTER_MULTIPLE:
+			return HAL_I2C_Mem_Write_IT(pi2chdl, addr, trans_inf->reg_address, I2C_MEMADD_SIZE_8BIT, trans_inf->pdata, trans_inf->data_len);
+
+		default:
+			return HAL_ERROR;
+	} // switch (trans_inf->trans_type)
+} // static HAL_StatusTypeDef i2c_trans_start(S_M1_I2C_Trans_Inf *trans_inf)
+
+
+
+/*============================================================================*/
+/**
+  * @brief  Make a transaction with the I2C in blocking mode, for callers
+  *         that run with the I2C interrupt masked
+  * @param  trans_inf an I2C object
+  * @retval HAL status
+  */
+/*============================================================================*/
+static HAL_StatusTypeDef i2c_trans_blocking(S_M1_I2C_Trans_Inf *trans_inf)
+{
+	uint16_t addr = m1_i2c_addr[trans_inf->dev_id];
 
-	assert(trans_inf->dev_id < I2C_NUM_OF_DEVICES_MAX);
 	switch (trans_inf->trans_type)
 	{
 		case I2C_TRANS_READ_REGISTER:
-			stat = HAL_I2C_Mem_Read(pi2chdl, m1_i2c_addr[trans_inf->dev_id], trans_inf->reg_address, I2C_MEMADD_SIZE_8BIT, &trans_inf->reg_data, 1, trans_inf->timeout);
-			break;
+			return HAL_I2C_Mem_Read(pi2chdl, addr, trans_inf->reg_address, I2C_MEMADD_SIZE_8BIT, &trans_inf->reg_data, 1, trans_inf->timeout);
 
 		case I2C_TRANS_WRITE_REGISTER:
-			taskENTER_CRITICAL();
-			stat = HAL_I2C_Mem_Write(pi2chdl, m1_i2c_addr[trans_inf->dev_id], trans_inf->reg_address, I2C_MEMADD_SIZE_8BIT, &trans_inf->reg_data, 1, trans_inf->timeout);
-			taskEXIT_CRITICAL();
-			break;
+			return HAL_I2C_Mem_Write(pi2chdl, addr, trans_inf->reg_address, I2C_MEMADD_SIZE_8BIT, &trans_inf->reg_data, 1, trans_inf->timeout);
 
 		case I2C_TRANS_READ_DATA:
-			stat = HAL_I2C_Master_Receive(pi2chdl, m1_i2c_addr[trans_inf->dev_id], trans_inf->pdata, trans_inf->data_len, trans_inf->timeout);
-			break;
+			return HAL_I2C_Master_Receive(pi2chdl, addr, trans_inf->pdata, trans_inf->data_len, trans_inf->timeout);
 
 		case I2C_TRANS_WRITE_DATA:
-			taskENTER_CRITICAL();
-			stat = HAL_I2C_Master_Transmit(pi2chdl, m1_i2c_addr[trans_inf->dev_id], trans_inf->pdata, trans_inf->data_len, trans_inf->timeout);
-			taskEXIT_CRITICAL();
-			break;
+			return HAL_I2C_Master_Transmit(pi2chdl, addr, trans_inf->pdata, trans_inf->data_len, trans_inf->timeout);
 
 		case I2C_TRANS_READ_REGISTER_MULTIPLE:	// Added for STC3115 to read multiple registers, shb
-			stat = HAL_I2C_Mem_Read(pi2chdl, m1_i2c_addr[trans_inf->dev_id], trans_inf->reg_address, I2C_MEMADD_SIZE_8BIT, trans_inf->pdata, trans_inf->data_len, trans_inf->timeout);
-			break;
+			return HAL_I2C_Mem_Read(pi2chdl, addr, trans_inf->reg_address, I2C_MEMADD_SIZE_8BIT, trans_inf->pdata, trans_inf->data_len, trans_inf->timeout);
 
 		case I2C_TRANS_WRITE_REGISTER_MULTIPLE:	// Added for STC3115 to write multiple registers, shb
-			taskENTER_CRITICAL();
-			stat = HAL_I2C_Mem_Write(pi2chdl, m1_i2c_addr[trans_inf->dev_id], trans_inf->reg_address, I2C_MEMADD_SIZE_8BIT, trans_inf->pdata, trans_inf->data_len, trans_inf->timeout);
-			taskEXIT_CRITICAL();
-			break;
+			return HAL_I2C_Mem_Write(pi2chdl, addr, trans_inf->reg_address, I2C_MEMADD_SIZE_8BIT, trans_inf->pdata, trans_inf->data_len, trans_inf->timeout);
 
 		default:
-			break;
-	} // switch (trans_inf.trans_type)
+			return HAL_OK;
+	} // switch (trans_inf->trans_type)
+} // static HAL_StatusTypeDef i2c_trans_blocking(S_M1_I2C_Trans_Inf *trans_inf)
 
-	xSemaphoreGive(mutex_i2c_trans);
 
-	return stat;
-} // HAL_StatusTypeDef m1_i2c_hal_trans_req(S_M1_I2C_Trans_Inf trans_inf)
+
+/*============================================================================*/
+/**
+  * @brief  Wake up the waiting task, called by the queue for every batch
+  * @param  pbatch finished batch
+  * @retval None
+  */
+/*============================================================================*/
+static void i2c_batch_finished(S_M1_I2C_Batch *pbatch)
+{
+	BaseType_t woken = pdFALSE;
+
+	(void)pbatch;
+	if ( xPortIsInsideInterrupt() )
+	{
+		xSemaphoreGiveFromISR(sem_i2c_batch_done, &woken);
+		portYIELD_FROM_ISR(woken);
+	}
+	else
+	{
+		xSemaphoreGive(sem_i2c_batch_done);
+	}
+} // static void i2c_batch_finished(S_M1_I2C_Batch *pbatch)
+
+
+
+static void i2c_transfer_done(I2C_HandleTypeDef *hi2c, HAL_StatusTypeDef stat)
+{
+	if ( hi2c==pi2chdl )
+		m1_i2c_queue_complete(stat);
+} // static void i2c_transfer_done(I2C_HandleTypeDef *hi2c, HAL_StatusTypeDef stat)
+
+
+
+void HAL_I2C_MemTxCpltCallback(I2C_HandleTypeDef *hi2c)
+{
+	i2c_transfer_done(hi2c, HAL_OK);
+} // void HAL_I2C_MemTxCpltCallback(I2C_HandleTypeDef *hi2c)
+
+
+
+void HAL_I2C_MemRxCpltCallback(I2C_HandleTypeDef *hi2c)
+{
+	i2c_transfer_done(hi2c, HAL_OK);
+} // void HAL_I2C_MemRxCpltCallback(I2C_HandleTypeDef *hi2c)
+
+
+
+void HAL_I2C_MasterTxCpltCallback(I2C_HandleTypeDef *hi2c)
+{
+	i2c_transfer_done(hi2c, HAL_OK);
+} // void HAL_I2C_MasterTxCpltCallback(I2C_HandleTypeDef *hi2c)
+
+
+
+void HAL_I2C_MasterRxCpltCallback(I2C_HandleTypeDef *hi2c)
+{
+	i2c_transfer_done(hi2c, HAL_OK);
+} // void HAL_I2C_MasterRxCpltCallback(I2C_HandleTypeDef *hi2c)
+
+
+
+// NACK, bus error or arbitration loss, the HAL has released the bus
+void HAL_I2C_ErrorCallback(I2C_HandleTypeDef *hi2c)
+{
+	i2c_transfer_done(hi2c, HAL_ERROR);
+} // void HAL_I2C_ErrorCallback(I2C_HandleTypeDef *hi2c)
+
+
+
+/*============================================================================*/
+/**
+  * @brief  Reset a stuck peripheral and fail the batch that held the bus,
+  *         and pbatch if it is still queued behind it
+  * @param  pbatch batch being waited for
+  * @retval None
+  */
+/*============================================================================*/
+static void i2c_bus_recover(S_M1_I2C_Batch *pbatch)
+{
+	S_M1_I2C_Batch *pactive;
+
+	taskENTER_CRITICAL();
+	pactive = m1_i2c_queue_active();
+	if ( pactive!=NULL )
+	{
+		// Clearing PE resets the state machine, it must stay low for 3 APB cycles
+		__HAL_I2C_DISABLE_IT(pi2chdl, I2C_IT_ERRI | I2C_IT_TCI | I2C_IT_STOPI | I2C_IT_NACKI | I2C_IT_ADDRI | I2C_IT_RXI | I2C_IT_TXI);
+		__HAL_I2C_DISABLE(pi2chdl);
+		__DSB();
+		__NOP();
+		__NOP();
+		__HAL_I2C_ENABLE(pi2chdl);
+		pi2chdl->State = HAL_I2C_STATE_READY;
+		pi2chdl->Mode = HAL_I2C_MODE_NONE;
+		pi2chdl->ErrorCode = HAL_I2C_ERROR_TIMEOUT;
+		__HAL_UNLOCK(pi2chdl);
+		m1_i2c_queue_cancel(pactive, HAL_TIMEOUT);
+	} // if ( pactive!=NULL )
+	if ( pbatch->busy && pbatch!=m1_i2c_queue_active() )
+		m1_i2c_queue_cancel(pbatch, HAL_TIMEOUT);
+	taskEXIT_CRITICAL();
+} // static void i2c_bus_recover(S_M1_I2C_Batch *pbatch)
+
+
+
+// The transfer interrupt can only be waited for from a task with interrupts on
+static bool i2c_irq_usable(void)
+{
+	if ( xPortIsInsideInterrupt() || __get_PRIMASK() || __get_BASEPRI() )
+		return false;
+
+	return (xTaskGetSchedulerState()==taskSCHEDULER_RUNNING);
+} // static bool i2c_irq_usable(void)
 
 
 
@@ -11,6 +11,9 @@
 #ifndef M1_I2C_H_
 #define M1_I2C_H_
 
+#include <stdint.h>
+#include <stdbool.h>
+
 /**
 The MCU PB6/PB7 are configured as I2C1_SCL and I2C1_SDA respectively.
 The table below lists the peripheral addresses:
@@ -63,9 +66,29 @@ typedef struct
 	uint32_t timeout;
 } S_M1_I2C_Trans_Inf;
 
+/*
+ * Transactions run back to back from the I2C interrupt. The batch, its
+ * transactions and their buffers must stay valid until busy is cleared.
+ */
+typedef struct S_M1_I2C_Batch
+{
+	S_M1_I2C_Trans_Inf *trans; // Run in order, the first failure ends the batch
+	uint8_t count;
+	void (*done)(struct S_M1_I2C_Batch *pbatch); // Called from the I2C interrupt, may be NULL
+	void *ctx; // For done
+	// Set by the I2C service
+	volatile bool busy;
+	volatile uint8_t n_done; // Transactions completed
+	volatile HAL_StatusTypeDef status;
+	struct S_M1_I2C_Batch *next;
+} S_M1_I2C_Batch;
+
 
 void m1_i2c_hal_init(I2C_HandleTypeDef *phi2c);
 HAL_StatusTypeDef m1_i2c_hal_trans_req(S_M1_I2C_Trans_Inf *trans_inf);
+HAL_StatusTypeDef m1_i2c_hal_batch_submit(S_M1_I2C_Batch *pbatch);
+HAL_StatusTypeDef m1_i2c_hal_batch_wait(S_M1_I2C_Batch *pbatch);
+HAL_StatusTypeDef m1_i2c_hal_batch_run(S_M1_I2C_Batch *pbatch);
 uint32_t m1_i2c_hal_get_error(void);
 
 #endif /* M1_I2C_H_ */
@@ -0,0 +1,206 @@
+/* See COPYING.txt for license details. */
+
+/*
+*
+* m1_i2c_queue.c
+*
+* I2C transaction queue
+*
+* M1 Project
+*
+*/
+
+/*************************** I N C L U D E S **********************************/
+
+#include <stddef.h>
+#include "m1_i2c_queue.h"
+
+/*************************** D E F I N E S ************************************/
+
+//************************** S T R U C T U R E S *******************************
+
+/***************************** V A R I A B L E S ******************************/
+
+static m1_i2c_queue_start_fn queue_start;
+static m1_i2c_queue_finished_fn queue_finished;
+static S_M1_I2C_Batch *queue_head; // Active batch, the others follow
+static S_M1_I2C_Batch *queue_tail;
+static bool queue_in_flight; // A transfer of the head is under way
+
+/********************* F U N C T I O N   P R O T O T Y P E S ******************/
+
+void m1_i2c_queue_init(m1_i2c_queue_start_fn start, m1_i2c_queue_finished_fn finished);
+HAL_StatusTypeDef m1_i2c_queue_submit(S_M1_I2C_Batch *pbatch);
+void m1_i2c_queue_complete(HAL_StatusTypeDef stat);
+bool m1_i2c_queue_cancel(S_M1_I2C_Batch *pbatch, HAL_StatusTypeDef stat);
+S_M1_I2C_Batch *m1_i2c_queue_active(void);
+static void queue_run(void);
+static void queue_finish(S_M1_I2C_Batch *pbatch, HAL_StatusTypeDef stat);
+
+/*************** F U N C T I O N   I M P L E M E N T A T I O N ****************/
+
+void m1_i2c_queue_init(m1_i2c_queue_start_fn start, m1_i2c_queue_finished_fn finished)
+{
+	queue_start = start;
+	queue_finished = finished;
+	queue_head = NULL;
+	queue_tail = NULL;
+	queue_in_flight = false;
+} // void m1_i2c_queue_init(m1_i2c_queue_start_fn start, m1_i2c_queue_finished_fn finished)
+
+
+
+/*============================================================================*/
+/*
+ * This function adds a batch to the end of the queue and starts it if the
+ * bus is idle. A batch still in the queue cannot be submitted again.
+ */
+/*============================================================================*/
+HAL_StatusTypeDef m1_i2c_queue_submit(S_M1_I2C_Batch *pbatch)
+{
+	if ( pbatch->busy )
+		return HAL_BUSY;
+
+	pbatch->busy = true;
+	pbatch->n_done = 0;
+	pbatch->status = HAL_OK;
+	pbatch->next = NULL;
+	if ( queue_tail!=NULL )
+		queue_tail->next = pbatch;
+	else
+		queue_head = pbatch;
+	queue_tail = pbatch;
+
+	queue_run();
+
+	return HAL_OK;
+} // HAL_StatusTypeDef m1_i2c_queue_submit(S_M1_I2C_Batch *pbatch)
+
+
+
+/*============================================================================*/
+/*
+ * This function is told that the transfer under way is over, and starts the
+ * next one.
+ */
+/*============================================================================*/
+void m1_i2c_queue_complete(HAL_StatusTypeDef stat)
+{
+	S_M1_I2C_Batch *pbatch = queue_head;
+
+	if ( !queue_in_flight || pbatch==NULL )
+		return; // Cancelled meanwhile
+	queue_in_flight = false;
+
+	pbatch->n_done++;
+	if ( stat!=HAL_OK || pbatch->n_done >= pbatch->count )
+		queue_finish(pbatch, stat);
+
+	queue_run();
+} // void m1_i2c_queue_complete(HAL_StatusTypeDef stat)
+
+
+
+/*============================================================================*/
+/*
+ * This function ends a batch early with stat. It returns true if a transfer
+ * of the batch was under way, then the caller must have stopped the
+ * hardware first.
+ */
+/*============================================================================*/
+bool m1_i2c_queue_cancel(S_M1_I2C_Batch *pbatch, HAL_StatusTypeDef stat)
+{
+	S_M1_I2C_Batch *prev;
+	bool active;
+
+	if ( !pbatch->busy )
+		return false;
+
+	active = (pbatch==queue_head) && queue_in_flight;
+	if ( pbatch==queue_head )
+	{
+		queue_in_flight = false;
+		queue_finish(pbatch, stat);
+		queue_run();
+		return active;
+	} // if ( pbatch==queue_head )
+
+	for ( prev = queue_head; prev!=NULL && prev->next!=pbatch; prev = prev->next )
+		;
+	if ( prev!=NULL )
+	{
+		prev->next = pbatch->next;
+		if ( queue_tail==pbatch )
+			queue_tail = prev;
+		pbatch->next = NULL;
+		pbatch->status = stat;
+		pbatch->busy = false;
+		if ( pbatch->done!=NULL )
+			pbatch->done(pbatch);
+		if ( queue_finished!=NULL )
+			queue_finished(pbatch);
+	} // if ( prev!=NULL )
+
+	return false;
+} // bool m1_i2c_queue_cancel(S_M1_I2C_Batch *pbatch, HAL_StatusTypeDef stat)
+
+
+
+S_M1_I2C_Batch *m1_i2c_queue_active(void)
+{
+	return queue_head;
+} // S_M1_I2C_Batch *m1_i2c_queue_active(void)
+
+
+
+/*============================================================================*/
+/*
+ * This function starts the next transaction unless one is under way. A
+ * transaction that cannot be started fails its batch and the next batch is
+ * tried.
+ */
+/*============================================================================*/
+static void queue_run(void)
+{
+	S_M1_I2C_Batch *pbatch;
+	HAL_StatusTypeDef stat;
+
+	// A done callback may submit, and so get here, while a batch is finishing
+	while ( !queue_in_flight && queue_head!=NULL )
+	{
+		pbatch = queue_head;
+		if ( pbatch->n_done >= pbatch->count ) // Empty batch
+		{
+			queue_finish(pbatch, HAL_OK);
+			continue;
+		}
+		queue_in_flight = true;
+		stat = queue_start(&pbatch->trans[pbatch->n_done]);
+		if ( stat==HAL_OK )
+			break;
+		// Still the head unless start completed it already
+		if ( queue_in_flight && queue_head==pbatch )
+		{
+			queue_in_flight = false;
+			queue_finish(pbatch, stat);
+		}
+	} // while ( !queue_in_flight && queue_head!=NULL )
+} // static void queue_run(void)
+
+
+
+// Takes the head batch off the queue
+static void queue_finish(S_M1_I2C_Batch *pbatch, HAL_StatusTypeDef stat)
+{
+	queue_head = pbatch->next;
+	if ( queue_head==NULL )
+		queue_tail = NULL;
+	pbatch->next = NULL;
+	pbatch->status = stat;
+	pbatch->busy = false;
+
+	if ( pbatch->done!=NULL )
+		pbatch->done(pbatch);
+	if ( queue_finished!=NULL )
+		queue_finished(pbatch);
+} // static void queue_finish(S_M1_I2C_Batch *pbatch, HAL_StatusTypeDef stat)
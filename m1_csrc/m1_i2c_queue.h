@@ -0,0 +1,45 @@
+/* See COPYING.txt for license details. */
+
+/*
+*
+* m1_i2c_queue.h
+*
+* Header for the I2C transaction queue
+*
+* The gauge, charger, USB PD controller and LED driver share I2C1. Their
+* transactions are queued here in batches and run back to back from the
+* transfer complete interrupt, so a task waits for a whole batch instead of
+* polling the bus for every register. A batch ends at its first failed
+* transaction.
+*
+* The queue does not touch the hardware: it asks start to begin each
+* transfer, and is told by m1_i2c_queue_complete() when it is over.
+*
+* M1 Project
+*
+*/
+
+#ifndef M1_I2C_QUEUE_H_
+#define M1_I2C_QUEUE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "stm32h5xx_hal.h"
+#include "m1_i2c.h"
+
+// Begins a transfer, HAL_OK if it is under way
+typedef HAL_StatusTypeDef (*m1_i2c_queue_start_fn)(S_M1_I2C_Trans_Inf *ptrans);
+// Called once for every finished batch, after its own done callback
+typedef void (*m1_i2c_queue_finished_fn)(S_M1_I2C_Batch *pbatch);
+
+/*
+ * All functions are called from the I2C interrupt, or from a task with the
+ * I2C interrupt masked.
+ */
+void m1_i2c_queue_init(m1_i2c_queue_start_fn start, m1_i2c_queue_finished_fn finished);
+HAL_StatusTypeDef m1_i2c_queue_submit(S_M1_I2C_Batch *pbatch);
+void m1_i2c_queue_complete(HAL_StatusTypeDef stat);
+bool m1_i2c_queue_cancel(S_M1_I2C_Batch *pbatch, HAL_StatusTypeDef stat);
+S_M1_I2C_Batch *m1_i2c_queue_active(void);
+
+#endif /* M1_I2C_QUEUE_H_ */
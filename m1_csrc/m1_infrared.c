@@ -19,15 +19,30 @@
 #include "main.h"
 #include "m1_infrared.h"
 #include "m1_ir_universal.h"
+#include "m1_ir_raw.h"
+#include "m1_cdc_stream.h"
+#include "m1_virtual_kb.h"
+#include "m1_file_util.h"
+#include "Res_String.h"
+#include "ff.h"
 #include "irmp.h"
 #include "irsnd.h"
 
 
 /*************************** D E F I N E S ************************************/
 
+#define IR_LEARNED_DECODED		1	// new_remote_learned: irmp_loopback_data holds the frame
+#define IR_LEARNED_RAW			2	// new_remote_learned: ir_raw_signal holds the timings
 
 //************************** S T R U C T U R E S *******************************
 
+typedef enum
+{
+	IR_RAW_CAPTURE_IDLE = 0,	// No signal
+	IR_RAW_CAPTURE_ACTIVE,		// Edges are coming in
+	IR_RAW_CAPTURE_GAP			// Rx timeout, waiting up to IR_RAW_END_GAP_MS for more edges
+} S_M1_IR_Raw_Capture;
+
 /***************************** V A R I A B L E S ******************************/
 
 TIM_HandleTypeDef   Timerhdl_IrCarrier;
@@ -38,13 +53,16 @@ IRMP_DATA 			irmp_data;
 volatile S_M1_IR_Det IrRx_Edge_Det; // Flag for first falling edge detected
 
 volatile uint8_t ir_ota_data_tx_active;
-uint8_t ir_ota_data_tx_len;
-volatile uint8_t ir_ota_data_tx_counter;
+uint16_t ir_ota_data_tx_len;
+volatile uint16_t ir_ota_data_tx_counter;
 uint16_t *pir_ota_data_tx_buffer;
 static TimerHandle_t ir_tx_timer_hdl = NULL;
 
 static IRMP_DATA 			irmp_loopback_data;
 static uint8_t				new_remote_learned;
+static S_IR_Raw_t			ir_raw_signal;		// Raw capture / replay buffer, one signal at a time
+static const S_IR_Raw_t		*ir_tx_raw = NULL;	// Raw signal to send instead of the IRSND frames
+static uint8_t				ir_tx_raw_sent;
 
 /********************* F U N C T I O N   P R O T O T Y P E S ******************/
 
@@ -55,7 +73,12 @@ void infrared_universal_remotes(void);
 void infrared_learn_new_remote(void);
 void infrared_saved_remotes(void);
 S_M1_IR_Tx_States infrared_transmit(uint8_t init);
+void infrared_transmit_raw(const S_IR_Raw_t *raw);
+S_IR_Raw_t *infrared_raw_buffer(void);
 
+static void infrared_tx_start(uint16_t *ota_buffer, uint16_t ota_len);
+static uint8_t infrared_learn_save_raw(void);
+static void infrared_learn_show_raw(void);
 static void infrared_decode_sys_init(void);
 static void infrared_decode_sys_deinit(void);
 void infrared_encode_sys_init(void);
@@ -113,6 +136,21 @@ S_M1_IR_Tx_States infrared_transmit(uint8_t init)
 		switch ( ir_tx_state )
 		{
 			case IR_TX_INIT:
+				if ( ir_tx_raw!=NULL ) // Raw signal: one pass over the captured periods, no IRSND framing
+				{
+					if ( !ir_tx_raw_sent && ir_tx_raw->count )
+					{
+						ir_tx_raw_sent = TRUE;
+						infrared_tx_start((uint16_t *)ir_tx_raw->ota, ir_tx_raw->count);
+						ir_tx_state = IR_TX_ACTIVE;
+					}
+					else
+					{
+						ir_tx_raw = NULL;
+						ir_tx_state = IR_TX_COMPLETED;
+					}
+					break;
+				} // if ( ir_tx_raw!=NULL )
 				wtemp = m1_make_ir_ota_multiframes();
 				if ( wtemp )
 				{
@@ -120,26 +158,7 @@ S_M1_IR_Tx_States infrared_transmit(uint8_t init)
 					{
 						if ( m1_check_ir_ota_frame_status() )
 						{
-							ir_ota_data_tx_active = TRUE;
-							ir_ota_data_tx_counter = 0;
-							ir_ota_data_tx_len = m1_get_ir_ota_frame_len();
-							pir_ota_data_tx_buffer = m1_get_ir_ota_buffer_ptr();
-							__HAL_TIM_URS_ENABLE(&Timerhdl_IrTx); // Enable URS to temporarily disable the UIF when the UG bit is set
-							Timerhdl_IrTx.Instance->ARR = pir_ota_data_tx_buffer[0]; // Update Auto Reload Register ARR value
-							HAL_TIM_GenerateEvent(&Timerhdl_IrTx, TIM_EVENTSOURCE_UPDATE); // Generate Update Event (set UG bit) to reload the valid ARR and reset the counter
-							__HAL_TIM_URS_DISABLE(&Timerhdl_IrTx); // Disable URS to enable the UIF again
-							  /* Check if the update flag is set after the Update Generation, if so clear the UIF flag */
-							if (HAL_IS_BIT_SET(Timerhdl_IrTx.Instance->SR, TIM_FLAG_UPDATE))
-							{
-								/* Clear the update flag */
-								CLEAR_BIT(Timerhdl_IrTx.Instance->SR, TIM_FLAG_UPDATE);
-							}
-							if ( pir_ota_data_tx_buffer[0] & 0x0001 ) // First OTA bit is a Mark?
-								irsnd_on(); // Start the PWM of the carrier at the output
-							__HAL_TIM_ENABLE(&Timerhdl_IrTx); // Start the timer of the baseband to control the carrier
-							// Update reload value for the next bit (next period)
-							Timerhdl_IrTx.Instance->ARR = pir_ota_data_tx_buffer[++ir_ota_data_tx_counter]; // Save the ARR for the next bit
-							//__HAL_TIM_SET_COUNTER(&Timerhdl_IrTx, 0);
+							infrared_tx_start(m1_get_ir_ota_buffer_ptr(), m1_get_ir_ota_frame_len());
 							ir_tx_state = IR_TX_ACTIVE; // update state machine
 						} // if ( m1_check_ir_ota_frame_status() )
 						else // OTA frame buffer is not ready for some reason. Let finish.
@@ -179,7 +198,8 @@ S_M1_IR_Tx_States infrared_transmit(uint8_t init)
 				if ( !ir_ota_data_tx_active ) // Tx completed?
 				{
 					__HAL_TIM_DISABLE(&Timerhdl_IrTx); // Stop the timer of the baseband
-					m1_ir_ota_frame_post_process(irmp_data.protocol);
+					if ( ir_tx_raw==NULL )
+						m1_ir_ota_frame_post_process(irmp_data.protocol);
 					ir_tx_state = IR_TX_INIT; // reset to repeat the process
 					continue; // Repeat the process
 				} // if ( !ir_ota_data_tx_active )
@@ -200,6 +220,66 @@ S_M1_IR_Tx_States infrared_transmit(uint8_t init)
 
 
 
+/*============================================================================*/
+/*
+ * This function loads the first OTA period into the baseband timer and starts it.
+ * The rest of the buffer is played by HAL_TIM_PeriodElapsedCallback_IR().
+ */
+/*============================================================================*/
+static void infrared_tx_start(uint16_t *ota_buffer, uint16_t ota_len)
+{
+	ir_ota_data_tx_active = TRUE;
+	ir_ota_data_tx_counter = 0;
+	ir_ota_data_tx_len = ota_len;
+	pir_ota_data_tx_buffer = ota_buffer;
+	__HAL_TIM_URS_ENABLE(&Timerhdl_IrTx); // Enable URS to temporarily disable the UIF when the UG bit is set
+	Timerhdl_IrTx.Instance->ARR = pir_ota_data_tx_buffer[0]; // Update Auto Reload Register ARR value
+	HAL_TIM_GenerateEvent(&Timerhdl_IrTx, TIM_EVENTSOURCE_UPDATE); // Generate Update Event (set UG bit) to reload the valid ARR and reset the counter
+	__HAL_TIM_URS_DISABLE(&Timerhdl_IrTx); // Disable URS to enable the UIF again
+	  /* Check if the update flag is set after the Update Generation, if so clear the UIF flag */
+	if (HAL_IS_BIT_SET(Timerhdl_IrTx.Instance->SR, TIM_FLAG_UPDATE))
+	{
+		/* Clear the update flag */
+		CLEAR_BIT(Timerhdl_IrTx.Instance->SR, TIM_FLAG_UPDATE);
+	}
+	if ( pir_ota_data_tx_buffer[0] & IR_OTA_PULSE_BIT_MASK ) // First OTA bit is a Mark?
+		irsnd_on(); // Start the PWM of the carrier at the output
+	__HAL_TIM_ENABLE(&Timerhdl_IrTx); // Start the timer of the baseband to control the carrier
+	// Update reload value for the next bit (next period)
+	Timerhdl_IrTx.Instance->ARR = pir_ota_data_tx_buffer[++ir_ota_data_tx_counter]; // Save the ARR for the next bit
+} // static void infrared_tx_start(uint16_t *ota_buffer, uint16_t ota_len)
+
+
+
+/*============================================================================*/
+/*
+ * This function selects a raw signal for the next transmission and sets its carrier.
+ * infrared_encode_sys_init() must have been called. Drive it with infrared_transmit(0)
+ * like a decoded frame; the signal is sent once.
+ */
+/*============================================================================*/
+void infrared_transmit_raw(const S_IR_Raw_t *raw)
+{
+	irsnd_set_carrier(raw->frequency, raw->duty_pct);
+	ir_tx_raw = raw;
+	ir_tx_raw_sent = FALSE;
+	infrared_transmit(1); // initialize the tx
+} // void infrared_transmit_raw(const S_IR_Raw_t *raw)
+
+
+
+/*============================================================================*/
+/*
+ * This function returns the shared raw signal buffer (capture, file load and replay).
+ */
+/*============================================================================*/
+S_IR_Raw_t *infrared_raw_buffer(void)
+{
+	return &ir_raw_signal;
+} // S_IR_Raw_t *infrared_raw_buffer(void)
+
+
+
 /*============================================================================*/
 /**
   * @brief
@@ -229,9 +309,18 @@ void infrared_learn_new_remote(void)
 	S_M1_Main_Q_t q_item;
 	BaseType_t ret;
 	uint8_t ir_data[20];
+	S_M1_IR_Raw_Capture raw_state;
+	TickType_t gap_start, wait_ticks;
+	uint32_t edge_te, gap_ms;
+	uint8_t edge_dir, frame_decoded, raw_ready;
 
 	infrared_decode_sys_init();
 	irmp_init();
+	ir_raw_reset(&ir_raw_signal);
+	raw_state = IR_RAW_CAPTURE_IDLE;
+	gap_start = 0;
+	frame_decoded = FALSE;
+	raw_ready = FALSE;
 
 	m1_led_fast_blink(LED_BLINK_ON_RGB, LED_FASTBLINK_PWM_M, LED_FASTBLINK_ONTIME_M);
 
@@ -248,66 +337,191 @@ void infrared_learn_new_remote(void)
 		;
 		; // Do other parts of this task here
 		;
+		wait_ticks = portMAX_DELAY;
+		if ( raw_state==IR_RAW_CAPTURE_GAP ) // Waiting to see if the burst continues?
+		{
+			gap_ms = (xTaskGetTickCount() - gap_start)*portTICK_PERIOD_MS;
+			wait_ticks = (gap_ms < IR_RAW_END_GAP_MS) ? pdMS_TO_TICKS(IR_RAW_END_GAP_MS - gap_ms) : 0;
+		} // if ( raw_state==IR_RAW_CAPTURE_GAP )
 
 		// Wait for the notification from button_event_handler_task to subfunc_handler_task.
 		// This task is the sub-task of subfunc_handler_task.
 		// The notification is given in the form of an item in the main queue.
 		// So let read the main queue.
-		ret = xQueueReceive(main_q_hdl, &q_item, portMAX_DELAY);
-		if (ret==pdTRUE)
+		ret = xQueueReceive(main_q_hdl, &q_item, wait_ticks);
+		if ( ret!=pdTRUE ) // No edge for IR_RAW_END_GAP_MS, the signal is complete
+		{
+			raw_state = IR_RAW_CAPTURE_IDLE;
+			if ( m1_cdc_stream_source()==CDC_STREAM_SRC_IR )
+				m1_cdc_stream_flush(true); // Send the whole signal now
+			if ( !frame_decoded && ir_raw_finish(&ir_raw_signal) ) // Unknown protocol, keep the raw timings
+			{
+				infrared_learn_show_raw();
+				raw_ready = TRUE;
+				new_remote_learned = IR_LEARNED_RAW;
+			} // if ( !frame_decoded && ir_raw_finish(&ir_raw_signal) )
+			frame_decoded = FALSE;
+			continue;
+		} // if ( ret!=pdTRUE )
+
+		if ( q_item.q_evt_type==Q_EVENT_IRRED_RX )
 		{
-			if ( q_item.q_evt_type==Q_EVENT_IRRED_RX )
+			edge_te = q_item.q_data.ir_rx_data.ir_edge_te;
+			edge_dir = q_item.q_data.ir_rx_data.ir_edge_dir;
+			if ( edge_te > Timerhdl_IrRx.Init.Period ) // Rx timeout, the burst has paused or ended
 			{
-				irmp_data_sampler(q_item.q_data.ir_rx_data.ir_edge_te, q_item.q_data.ir_rx_data.ir_edge_dir);
-				/* Decode the Rx frame */
-				if (irmp_get_data(&irmp_data))
+				if ( raw_state==IR_RAW_CAPTURE_ACTIVE )
 				{
-					m1_buzzer_notification();
-					u8g2_SetDrawColor(&m1_u8g2, M1_DISP_DRAW_COLOR_BG);
-					u8g2_DrawBox(&m1_u8g2, 0, 30, 128, 34); // Clear old content
-					u8g2_SetDrawColor(&m1_u8g2, M1_DISP_DRAW_COLOR_TXT);
-					u8g2_DrawStr(&m1_u8g2, 15, 40, irmp_protocol_names[irmp_data.protocol]);
-					sprintf((char *)ir_data, "Address: 0x%04X", irmp_data.address);
-					u8g2_DrawStr(&m1_u8g2, 15, 50, (char *)ir_data);
-					sprintf((char *)ir_data, "Command: 0x%04X", irmp_data.command);
-					u8g2_DrawStr(&m1_u8g2, 15, 60, (char *)ir_data);
-					u8g2_NextPage(&m1_u8g2); // Update display RAM
-
-					memcpy(&irmp_loopback_data, &irmp_data, sizeof(IRMP_DATA));
-					new_remote_learned = 1;
-
-				} // if (irmp_get_data (&irmp_data))
-			} // if ( q_item.q_evt_type==Q_EVENT_IRRED_RX )
-			else if ( q_item.q_evt_type==Q_EVENT_KEYPAD )
+					raw_state = IR_RAW_CAPTURE_GAP;
+					gap_start = xTaskGetTickCount();
+				} // if ( raw_state==IR_RAW_CAPTURE_ACTIVE )
+			} // if ( edge_te > Timerhdl_IrRx.Init.Period )
+			else
 			{
-				// Notification is only sent to this task when there's any button activity,
-				// so it doesn't need to wait when reading the event from the queue
-				ret = xQueueReceive(button_events_q_hdl, &this_button_status, 0);
-				if ( this_button_status.event[BUTTON_BACK_KP_ID]==BUTTON_EVENT_CLICK ) // user wants to exit?
+				if ( raw_state==IR_RAW_CAPTURE_IDLE ) // First edge of a new signal
 				{
-					m1_led_fast_blink(LED_BLINK_ON_RGB, LED_FASTBLINK_PWM_OFF, LED_FASTBLINK_ONTIME_OFF); // Turn off
+					if ( m1_cdc_stream_source()==CDC_STREAM_SRC_IR ) // Separates the signals on the stream
+						m1_cdc_stream_put(IR_RAW_END_GAP_MS*1000, false);
+					ir_raw_reset(&ir_raw_signal);
+					raw_ready = FALSE;
+					if ( new_remote_learned==IR_LEARNED_RAW )
+						new_remote_learned = 0;
+				} // if ( raw_state==IR_RAW_CAPTURE_IDLE )
+				else if ( raw_state==IR_RAW_CAPTURE_GAP ) // Burst continues, the pause is part of the signal
+				{
+					gap_ms = (xTaskGetTickCount() - gap_start)*portTICK_PERIOD_MS;
+					ir_raw_add(&ir_raw_signal, Timerhdl_IrRx.Init.Period + 1 + gap_ms*1000, false);
+					if ( m1_cdc_stream_source()==CDC_STREAM_SRC_IR )
+						m1_cdc_stream_put(Timerhdl_IrRx.Init.Period + 1 + gap_ms*1000, false);
+				} // else if ( raw_state==IR_RAW_CAPTURE_GAP )
+				raw_state = IR_RAW_CAPTURE_ACTIVE;
+				// A rising edge ends a Mark (the receiver output is active low)
+				ir_raw_add(&ir_raw_signal, edge_te, (edge_dir==EDGE_DET_RISING));
+				if ( m1_cdc_stream_source()==CDC_STREAM_SRC_IR )
+					m1_cdc_stream_put(edge_te, (edge_dir==EDGE_DET_RISING));
+			} // else
+
+			if ( edge_dir!=EDGE_DET_IDLE ) // Raw-only timeout events are not meant for IRMP
+			{
+				irmp_data_sampler(edge_te, edge_dir);
+			}
+			/* Decode the Rx frame */
+			if (irmp_get_data(&irmp_data))
+			{
+				m1_buzzer_notification();
+				u8g2_SetDrawColor(&m1_u8g2, M1_DISP_DRAW_COLOR_BG);
+				u8g2_DrawBox(&m1_u8g2, 0, 30, 128, 34); // Clear old content
+				u8g2_SetDrawColor(&m1_u8g2, M1_DISP_DRAW_COLOR_TXT);
+				u8g2_DrawStr(&m1_u8g2, 15, 40, irmp_protocol_names[irmp_data.protocol]);
+				sprintf((char *)ir_data, "Address: 0x%04X", irmp_data.address);
+				u8g2_DrawStr(&m1_u8g2, 15, 50, (char *)ir_data);
+				sprintf((char *)ir_data, "Command: 0x%04X", irmp_data.command);
+				u8g2_DrawStr(&m1_u8g2, 15, 60, (char *)ir_data);
+				u8g2_NextPage(&m1_u8g2); // Update display RAM
+
+				memcpy(&irmp_loopback_data, &irmp_data, sizeof(IRMP_DATA));
+				new_remote_learned = IR_LEARNED_DECODED;
+				frame_decoded = TRUE; // The raw timings of this signal are not needed
+				raw_ready = FALSE;
+			} // if (irmp_get_data (&irmp_data))
+		} // if ( q_item.q_evt_type==Q_EVENT_IRRED_RX )
+		else if ( q_item.q_evt_type==Q_EVENT_KEYPAD )
+		{
+			// Notification is only sent to this task when there's any button activity,
+			// so it doesn't need to wait when reading the event from the queue
+			ret = xQueueReceive(button_events_q_hdl, &this_button_status, 0);
+			if ( this_button_status.event[BUTTON_BACK_KP_ID]==BUTTON_EVENT_CLICK ) // user wants to exit?
+			{
+				m1_led_fast_blink(LED_BLINK_ON_RGB, LED_FASTBLINK_PWM_OFF, LED_FASTBLINK_ONTIME_OFF); // Turn off
 
-					; // Do extra tasks here if needed
-					infrared_decode_sys_deinit();
+				; // Do extra tasks here if needed
+				infrared_decode_sys_deinit();
 
-					xQueueReset(main_q_hdl); // Reset main q before return
-					break; // Exit and return to the calling task (subfunc_handler_task)
-				} // if ( m1_buttons_status[BUTTON_BACK_KP_ID]==BUTTON_EVENT_CLICK )
+				xQueueReset(main_q_hdl); // Reset main q before return
+				break; // Exit and return to the calling task (subfunc_handler_task)
+			} // if ( m1_buttons_status[BUTTON_BACK_KP_ID]==BUTTON_EVENT_CLICK )
+			else if ( this_button_status.event[BUTTON_OK_KP_ID]==BUTTON_EVENT_CLICK && raw_ready )
+			{
+				u8g2_SetDrawColor(&m1_u8g2, M1_DISP_DRAW_COLOR_BG);
+				u8g2_DrawBox(&m1_u8g2, 0, 30, 128, 34); // Clear old content
+				u8g2_SetDrawColor(&m1_u8g2, M1_DISP_DRAW_COLOR_TXT);
+				if ( infrared_learn_save_raw() )
+				{
+					u8g2_DrawStr(&m1_u8g2, 15, 50, "Saved");
+					raw_ready = FALSE;
+				}
 				else
 				{
-					; // Do other things for this task, if needed
+					u8g2_DrawStr(&m1_u8g2, 15, 50, "Not saved");
 				}
-			} // else if ( q_item.q_evt_type==Q_EVENT_KEYPAD )
+				m1_u8g2_nextpage(); // Update display RAM
+			} // else if ( this_button_status.event[BUTTON_OK_KP_ID]==BUTTON_EVENT_CLICK && raw_ready )
 			else
 			{
-				; // Do other things for this task
+				; // Do other things for this task, if needed
 			}
-		} // if (ret==pdTRUE)
+		} // else if ( q_item.q_evt_type==Q_EVENT_KEYPAD )
+		else
+		{
+			; // Do other things for this task
+		}
 	} // while (1 ) // Main loop of this task
 } // void infrared_learn_new_remote(void)
 
 
 
+/*============================================================================*/
+/*
+ * This function shows the summary of a raw capture in the learn screen.
+ */
+/*============================================================================*/
+static void infrared_learn_show_raw(void)
+{
+	char ir_data[24];
+
+	m1_buzzer_notification();
+	u8g2_SetDrawColor(&m1_u8g2, M1_DISP_DRAW_COLOR_BG);
+	u8g2_DrawBox(&m1_u8g2, 0, 30, 128, 34); // Clear old content
+	u8g2_SetDrawColor(&m1_u8g2, M1_DISP_DRAW_COLOR_TXT);
+	u8g2_DrawStr(&m1_u8g2, 15, 40, "RAW");
+	sprintf(ir_data, "Edges: %u%s", ir_raw_edge_count(&ir_raw_signal), ir_raw_signal.truncated ? " (max)" : "");
+	u8g2_DrawStr(&m1_u8g2, 15, 50, ir_data);
+	u8g2_DrawStr(&m1_u8g2, 15, 60, "OK: Save");
+	m1_u8g2_nextpage(); // Update display RAM
+} // static void infrared_learn_show_raw(void)
+
+
+
+/*============================================================================*/
+/*
+ * This function asks for a name and saves the raw capture to IR_RAW_LEARNED_DIR.
+ * Return: TRUE if the file was written
+ */
+/*============================================================================*/
+static uint8_t infrared_learn_save_raw(void)
+{
+	char dname[24], fname[24];
+	char fpath[64];
+
+	if ( fs_directory_ensure(IR_UNIVERSAL_SD_ROOT)!=FR_OK || fs_directory_ensure(IR_RAW_LEARNED_DIR)!=FR_OK )
+		return FALSE;
+
+	sprintf(dname, "Raw_%05lu", (unsigned long)(HAL_GetTick() % 100000));
+	while (1)
+	{
+		if ( !m1_vkb_get_filename("Enter filename:", dname, fname) )
+			return FALSE; // user escapes
+		snprintf(fpath, sizeof(fpath), IR_RAW_LEARNED_DIR "/%s.ir", fname);
+		if ( fs_file_exists(fpath)!=1 )
+			break;
+		m1_message_box(&m1_u8g2, res_string(IDS_DUPLICATE_FILE), NULL, " ", res_string(IDS_BACK));
+	} // while (1)
+
+	return ir_raw_save(fpath, fname, &ir_raw_signal) ? TRUE : FALSE;
+} // static uint8_t infrared_learn_save_raw(void)
+
+
+
 /*============================================================================*/
 /**
   * @brief
@@ -332,7 +546,11 @@ void infrared_saved_remotes(void)
 	u8g2_DrawStr(&m1_u8g2, 60, 20, "Sending...");
 	m1_u8g2_nextpage(); // Update display RAM
 
-	if (new_remote_learned)
+	if ( new_remote_learned==IR_LEARNED_RAW )
+	{
+		; // Replay the raw timings, see below
+	}
+	else if (new_remote_learned)
 	{
     	memcpy(&irmp_data, &irmp_loopback_data, sizeof(IRMP_DATA));
     	irmp_data.flags    = 1;
@@ -349,17 +567,33 @@ void infrared_saved_remotes(void)
 	u8g2_SetDrawColor(&m1_u8g2, M1_DISP_DRAW_COLOR_BG);
 	u8g2_DrawBox(&m1_u8g2, 0, 30, 128, 34); // Clear old content
 	u8g2_SetDrawColor(&m1_u8g2, M1_DISP_DRAW_COLOR_TXT);
-	u8g2_DrawStr(&m1_u8g2, 15, 40, irmp_protocol_names[irmp_data.protocol]);
-	sprintf((char *)ir_data, "Address: 0x%04X", irmp_data.address);
-	u8g2_DrawStr(&m1_u8g2, 15, 50, (char *)ir_data);
-	sprintf((char *)ir_data, "Command: 0x%04X", irmp_data.command);
-	u8g2_DrawStr(&m1_u8g2, 15, 60, (char *)ir_data);
+	if ( new_remote_learned==IR_LEARNED_RAW )
+	{
+		u8g2_DrawStr(&m1_u8g2, 15, 40, "RAW");
+		sprintf((char *)ir_data, "Edges: %u", ir_raw_edge_count(&ir_raw_signal));
+		u8g2_DrawStr(&m1_u8g2, 15, 50, (char *)ir_data);
+	} // if ( new_remote_learned==IR_LEARNED_RAW )
+	else
+	{
+		u8g2_DrawStr(&m1_u8g2, 15, 40, irmp_protocol_names[irmp_data.protocol]);
+		sprintf((char *)ir_data, "Address: 0x%04X", irmp_data.address);
+		u8g2_DrawStr(&m1_u8g2, 15, 50, (char *)ir_data);
+		sprintf((char *)ir_data, "Command: 0x%04X", irmp_data.command);
+		u8g2_DrawStr(&m1_u8g2, 15, 60, (char *)ir_data);
+	}
 	u8g2_NextPage(&m1_u8g2); // Update display RAM
 
 	m1_led_fast_blink(LED_BLINK_ON_RGB, LED_FASTBLINK_PWM_M, LED_FASTBLINK_ONTIME_M);
     infrared_encode_sys_init();
-	irsnd_generate_tx_data(irmp_data); // make ota data
-	infrared_transmit(1); // initialize the tx
+	if ( new_remote_learned==IR_LEARNED_RAW )
+	{
+		infrared_transmit_raw(&ir_raw_signal);
+	}
+	else
+	{
+		irsnd_generate_tx_data(irmp_data); // make ota data
+		infrared_transmit(1); // initialize the tx
+	}
 	ir_tx_complete = 0;
 
 	while (1 ) // Main loop of this task
@@ -405,8 +639,15 @@ void infrared_saved_remotes(void)
 					m1_led_fast_blink(LED_BLINK_ON_RGB, LED_FASTBLINK_PWM_M, LED_FASTBLINK_ONTIME_M);
 					irsnd_init(&Timerhdl_IrCarrier, IR_ENCODE_TIMER_TX_CHANNEL);
 					vTaskDelay(20); // A delay here is necessary for the function to work properly!
-					irsnd_generate_tx_data(irmp_data); // make ota data
-					infrared_transmit(1); // initialize the tx
+					if ( new_remote_learned==IR_LEARNED_RAW )
+					{
+						infrared_transmit_raw(&ir_raw_signal);
+					}
+					else
+					{
+						irsnd_generate_tx_data(irmp_data); // make ota data
+						infrared_transmit(1); // initialize the tx
+					}
 					ir_tx_complete = 0;
 				}
 				else
@@ -729,6 +970,7 @@ void infrared_encode_sys_deinit(void)
 		assert_param(ret==pdPASS);
 		ir_tx_timer_hdl = NULL;
 	}
+	ir_tx_raw = NULL;
 
 	if ( main_q_hdl != NULL)
 		xQueueReset(main_q_hdl);
@@ -19,6 +19,7 @@
 #include "m1_compile_cfg.h"
 #include "queue.h"
 #include "irmp.h"
+#include "m1_ir_raw.h"
 
 #define IR_DECODE_TIMER                 TIM2        /*!< Timer used for IR decoding */
 /* TIM prescaler is computed to have 1 μs as time base. TIM frequency (in MHz) / (prescaler+1) */
@@ -96,6 +97,8 @@ void infrared_saved_remotes(void);
 void infrared_encode_sys_init(void);
 void infrared_encode_sys_deinit(void);
 S_M1_IR_Tx_States infrared_transmit(uint8_t init);
+void infrared_transmit_raw(const S_IR_Raw_t *raw);
+S_IR_Raw_t *infrared_raw_buffer(void);
 
 extern uint32_t TIM_GetCounterCLKValue(uint16_t prescaler);
 extern void HAL_TIM_PeriodElapsedCallback_IR(TIM_HandleTypeDef *htim);
@@ -107,8 +110,8 @@ extern TIM_HandleTypeDef    Timerhdl_IrTx;
 extern TIM_HandleTypeDef    Timerhdl_IrRx;
 
 extern volatile uint8_t ir_ota_data_tx_active;
-extern uint8_t ir_ota_data_tx_len;
-extern volatile uint8_t ir_ota_data_tx_counter;
+extern uint16_t ir_ota_data_tx_len;
+extern volatile uint16_t ir_ota_data_tx_counter;
 extern uint16_t *pir_ota_data_tx_buffer;
 
 #endif /* M1_INFRARED_H_ */
@@ -26,6 +26,8 @@
 #include "spi_master.h"
 #include "m1_rfid.h"
 #include "lfrfid.h"
+#include "battery.h"
+#include "m1_fusb302.h"
 
 /*************************** D E F I N E S ************************************/
 
@@ -78,6 +80,26 @@ void EXTI8_IRQHandler(void)
 
 
 
+/*============================================================================*/
+/*
+ * These functions handle the I2C1 event and error interrupts. The gauge,
+ * charger, USB-C PD and LED driver transfers run from them.
+ */
+/*============================================================================*/
+void I2C1_EV_IRQHandler(void)
+{
+	HAL_I2C_EV_IRQHandler(&hi2c1);
+} // void I2C1_EV_IRQHandler(void)
+
+
+
+void I2C1_ER_IRQHandler(void)
+{
+	HAL_I2C_ER_IRQHandler(&hi2c1);
+} // void I2C1_ER_IRQHandler(void)
+
+
+
 /*============================================================================*/
 /*
  * This function is the callback function of the External interrupt handlers
@@ -87,17 +109,17 @@ void HAL_GPIO_EXTI_Falling_Callback(uint16_t GPIO_Pin)
 {
     if (GPIO_Pin==I2C_INT_Pin) // Battery charger external interrupt - PB8
     {
-    	;
+    	battery_status_invalidate(); // Charge status or fault changed
     }
 
     if (GPIO_Pin==FG_INT_Pin) // Fuel gauge external interrupt - PE3
     {
-    	;
+    	battery_status_invalidate(); // State of charge changed
     }
 
     if (GPIO_Pin==USBC_INT_Pin) // USB-C Power delivery external interrupt - PC6
     {
-    	;
+    	pd_usbc_int_isr();
     }
 } // void HAL_GPIO_EXTI_Falling_Callback(uint16_t GPIO_Pin)
 
@@ -298,19 +320,39 @@ void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
   {
     //huart->gState = HAL_UART_STATE_READY; // State explicit reset
 
-#if 1
-    tx_cptl_usart1 = 0;
-#else
     if (usb2ser_tx_semaphore != NULL) {
-      // Release xUsartTxSemaphore to wake up UsartTxTask
+      // Release usb2ser_tx_semaphore to wake up vUsb2SerTask
       xSemaphoreGiveFromISR(usb2ser_tx_semaphore, &xHigherPriorityTaskWoken);
     }
-#endif
     portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
   }
 }
 
 
+/******************************************************************************/
+/*
+ * @brief UART error callback.
+ *        The HAL stops the RX DMA on framing and noise errors, the USB-UART
+ *        bridge receives again from the start of the circular buffer.
+ * @param huart UART handle.
+ * @retval None
+ */
+/******************************************************************************/
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
+{
+  if ((huart->Instance == USART1) && (m1_usbcdc_mode == CDC_MODE_VCP))
+  {
+    m1_usb_bridge_count_error();
+    if (huart->RxState == HAL_UART_STATE_READY)
+    {
+      head_usart1_dma = 0;
+      tail_usart1_dma = 0;
+      HAL_UART_Receive_DMA(huart, (uint8_t *)logdb_rx_buffer, M1_LOGDB_RX_BUFFER_SIZE);
+    }
+  }
+}
+
+
 /******************************************************************************/
 /*
  * @brief This function handles GPDMA1 Channel 0 global interrupt.
@@ -563,6 +605,7 @@ void HAL_TIM_PeriodElapsedCallback_IR(TIM_HandleTypeDef *htim)
 	uint32_t cap_val;
 	S_M1_Main_Q_t q_item;
 	portBASE_TYPE xHigherPriorityTaskWoken = pdFALSE;
+	S_M1_IR_Det last_edge_det;
 
 	if (htim == &Timerhdl_IrTx )
 	{
@@ -600,6 +643,7 @@ void HAL_TIM_PeriodElapsedCallback_IR(TIM_HandleTypeDef *htim)
 	{
 		cap_val = __HAL_TIM_GET_COUNTER(htim); // get the timeout counter
 		__HAL_TIM_SET_COUNTER(htim, 0); // reset counter after reading, htim->Instance->CNT = 0x00;
+		last_edge_det = IrRx_Edge_Det;
 		IrRx_Edge_Det = EDGE_DET_IDLE; // timeout case, let reset this flag
 		if ( irmp_start_bit_is_detected() )
 		{
@@ -611,6 +655,14 @@ void HAL_TIM_PeriodElapsedCallback_IR(TIM_HandleTypeDef *htim)
 			xQueueSendFromISR(main_q_hdl, &q_item, &xHigherPriorityTaskWoken); // Send sample to queue, return: pdPASS or errQUEUE_FULL
 			portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
 		} // if ( irmp_start_bit_is_detected() )
+		else if ( last_edge_det!=EDGE_DET_IDLE ) // End of a burst IRMP did not recognise, only the raw capture needs it
+		{
+			q_item.q_evt_type = Q_EVENT_IRRED_RX;
+			q_item.q_data.ir_rx_data.ir_edge_te = Timerhdl_IrRx.Init.Period + 1;
+			q_item.q_data.ir_rx_data.ir_edge_dir = EDGE_DET_IDLE; // Not an edge, must not be passed to the IRMP decoder
+			xQueueSendFromISR(main_q_hdl, &q_item, &xHigherPriorityTaskWoken);
+			portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+		} // else if ( last_edge_det!=EDGE_DET_IDLE )
 	}
 } // void HAL_TIM_PeriodElapsedCallback_IR(TIM_HandleTypeDef *htim)
 
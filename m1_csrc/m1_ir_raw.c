@@ -0,0 +1,234 @@
+/* See COPYING.txt for license details. */
+
+/*
+ * m1_ir_raw.c
+ *
+ * Raw-timing IR signals: capture buffer, Flipper .ir "type: raw" file
+ * load/save. Replay is done by infrared_transmit() (m1_infrared.c), which
+ * feeds the OTA entries straight to the IRSND baseband timer.
+ *
+ * M1 Project
+ */
+
+#include "m1_ir_raw.h"
+#include "m1_infrared.h"
+#include "m1_signal_index.h"
+#include <stdio.h>
+#include <string.h>
+
+/* -------------------------------------------------------------------------
+ * Internal constants
+ * ---------------------------------------------------------------------- */
+
+#define IR_RAW_IO_CHUNK 64 /* bytes per f_read/f_write while streaming */
+
+#define IR_RAW_IS_MARK(v) (((v) & IR_OTA_PULSE_BIT_MASK) != 0)
+#define IR_RAW_US(v) ((uint32_t)((v) & IR_OTA_SPACE_BIT_MASK))
+
+/* -------------------------------------------------------------------------
+ * Public: capture buffer
+ * ---------------------------------------------------------------------- */
+
+void ir_raw_reset(S_IR_Raw_t *raw) {
+  raw->count = 0;
+  raw->frequency = IR_RAW_FREQ_DEFAULT;
+  raw->duty_pct = IR_RAW_DUTY_DEFAULT;
+  raw->truncated = false;
+  raw->ota[0] = 0;
+}
+
+bool ir_raw_add(S_IR_Raw_t *raw, uint32_t duration_us, bool mark) {
+  uint16_t level = mark ? IR_OTA_PULSE_BIT_MASK : 0;
+
+  if (raw->truncated)
+    return false;
+
+  /* A signal always starts with a mark */
+  if (raw->count == 0 && !mark)
+    return true;
+
+  if (duration_us < IR_RAW_MIN_US)
+    duration_us = IR_RAW_MIN_US;
+
+  /* Merge with the previous entry of the same level while it has room */
+  if (raw->count > 0) {
+    uint16_t *last = &raw->ota[raw->count - 1];
+    if (IR_RAW_IS_MARK(*last) == mark) {
+      uint32_t sum = IR_RAW_US(*last) + duration_us;
+      if (sum <= IR_RAW_OTA_MAX_US) {
+        *last = (uint16_t)(sum & IR_OTA_SPACE_BIT_MASK) | level;
+        return true;
+      }
+      *last = IR_RAW_OTA_MAX_US | level;
+      duration_us = sum - IR_RAW_OTA_MAX_US;
+    }
+  }
+
+  while (duration_us > 0) {
+    uint32_t part =
+        (duration_us > IR_RAW_OTA_MAX_US) ? IR_RAW_OTA_MAX_US : duration_us;
+    if (part < IR_RAW_MIN_US)
+      part = IR_RAW_MIN_US;
+
+    if (raw->count >= IR_RAW_EDGES_MAX) {
+      raw->truncated = true;
+      return false;
+    }
+    raw->ota[raw->count++] = (uint16_t)(part & IR_OTA_SPACE_BIT_MASK) | level;
+    duration_us = (duration_us > part) ? duration_us - part : 0;
+  }
+
+  return true;
+}
+
+bool ir_raw_finish(S_IR_Raw_t *raw) {
+  /* Trailing silence is the end-of-signal gap, not part of the signal */
+  while (raw->count > 0 && !IR_RAW_IS_MARK(raw->ota[raw->count - 1]))
+    raw->count--;
+
+  /* End with a space entry for the ISR look-ahead (never played as data) */
+  raw->ota[raw->count] = 0;
+
+  return ir_raw_edge_count(raw) >= IR_RAW_MIN_EDGES;
+}
+
+uint16_t ir_raw_edge_count(const S_IR_Raw_t *raw) {
+  uint16_t i, n = 0;
+
+  for (i = 0; i < raw->count; i++) {
+    if (i == 0 ||
+        IR_RAW_IS_MARK(raw->ota[i]) != IR_RAW_IS_MARK(raw->ota[i - 1]))
+      n++;
+  }
+  return n;
+}
+
+/* -------------------------------------------------------------------------
+ * Public: file I/O
+ * ---------------------------------------------------------------------- */
+
+bool ir_raw_read_data(FIL *f, S_IR_Raw_t *raw) {
+  char chunk[IR_RAW_IO_CHUNK];
+  UINT got, i;
+  uint32_t value = 0;
+  bool in_number = false;
+  bool mark = true;
+  bool eol = false;
+
+  raw->count = 0;
+  raw->truncated = false;
+
+  while (!eol && f_read(f, chunk, sizeof(chunk), &got) == FR_OK && got > 0) {
+    for (i = 0; i < got; i++) {
+      char c = chunk[i];
+
+      if (c >= '0' && c <= '9') {
+        value = value * 10 + (uint32_t)(c - '0');
+        in_number = true;
+        continue;
+      }
+      if (in_number) {
+        ir_raw_add(raw, value, mark);
+        mark = !mark;
+        value = 0;
+        in_number = false;
+      }
+      if (c == '\n' || c == '\r') {
+        eol = true;
+        break;
+      }
+    }
+  }
+  if (in_number)
+    ir_raw_add(raw, value, mark);
+
+  return ir_raw_finish(raw);
+}
+
+bool ir_raw_load(const char *path, uint32_t data_offset, uint32_t frequency,
+                 uint8_t duty_pct, S_IR_Raw_t *raw) {
+  FIL f;
+  bool ok;
+
+  ir_raw_reset(raw);
+  if (frequency >= IR_RAW_FREQ_MIN && frequency <= IR_RAW_FREQ_MAX)
+    raw->frequency = frequency;
+  if (duty_pct > 0 && duty_pct < 100)
+    raw->duty_pct = duty_pct;
+
+  if (f_open(&f, path, FA_OPEN_EXISTING | FA_READ) != FR_OK)
+    return false;
+
+  ok = (f_lseek(&f, data_offset) == FR_OK) && ir_raw_read_data(&f, raw);
+  f_close(&f);
+  return ok;
+}
+
+bool ir_raw_save(const char *path, const char *name, const S_IR_Raw_t *raw) {
+  FIL f;
+  UINT written;
+  char buf[IR_RAW_IO_CHUNK + 8];
+  int len;
+  uint16_t i;
+  bool ok = true;
+
+  if (f_open(&f, path, FA_CREATE_ALWAYS | FA_WRITE) != FR_OK)
+    return false;
+
+  len = snprintf(buf, sizeof(buf),
+                 "Filetype: IR signals file\nVersion: 1\n#\nname: %s\n", name);
+  ok &= (f_write(&f, buf, (UINT)len, &written) == FR_OK);
+  len = snprintf(buf, sizeof(buf),
+                 "type: raw\nfrequency: %lu\nduty_cycle: 0.%02u0000\ndata:",
+                 (unsigned long)raw->frequency, (unsigned)raw->duty_pct);
+  ok &= (f_write(&f, buf, (UINT)len, &written) == FR_OK);
+
+  /* Write merged periods (split OTA entries are joined back) in chunks */
+  len = 0;
+  i = 0;
+  while (ok && i < raw->count) {
+    bool mark = IR_RAW_IS_MARK(raw->ota[i]);
+    uint32_t us = 0;
+
+    while (i < raw->count && IR_RAW_IS_MARK(raw->ota[i]) == mark)
+      us += IR_RAW_US(raw->ota[i++]);
+
+    len += snprintf(&buf[len], sizeof(buf) - (size_t)len, " %lu",
+                    (unsigned long)us);
+    if (len >= IR_RAW_IO_CHUNK) {
+      ok &= (f_write(&f, buf, (UINT)len, &written) == FR_OK);
+      len = 0;
+    }
+  }
+  buf[len++] = '\n';
+  ok &= (f_write(&f, buf, (UINT)len, &written) == FR_OK);
+
+  ok &= (f_close(&f) == FR_OK);
+  if (ok)
+    m1_sig_idx_add(SIG_IDX_IR, path, "RAW", raw->frequency, NULL, 0);
+  return ok;
+}
+
+uint8_t ir_raw_parse_duty(const char *s) {
+  uint32_t pct = 0;
+
+  /* "0.33" / "0.330000" / "1" -> 33 / 33 / 100, no float parsing needed */
+  while (*s == ' ')
+    s++;
+  while (*s >= '0' && *s <= '9')
+    pct = pct * 10 + (uint32_t)(*s++ - '0');
+  pct *= 100;
+  if (*s == '.') {
+    s++;
+    if (*s >= '0' && *s <= '9') {
+      pct += (uint32_t)(*s++ - '0') * 10;
+    }
+    if (*s >= '0' && *s <= '9') {
+      pct += (uint32_t)(*s - '0');
+    }
+  }
+
+  if (pct == 0 || pct >= 100)
+    return IR_RAW_DUTY_DEFAULT;
+  return (uint8_t)pct;
+}
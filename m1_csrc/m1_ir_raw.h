@@ -0,0 +1,103 @@
+/* See COPYING.txt for license details. */
+
+/*
+ * m1_ir_raw.h
+ *
+ * Raw-timing IR signals (Flipper Zero "type: raw" compatible).
+ *
+ * A raw signal is kept as the list of mark/space durations in the same
+ * 16-bit over-the-air (OTA) format the IRSND baseband timer consumes
+ * (microseconds, LSB = 1 for Mark, see IR_OTA_PULSE_BIT_MASK). Capture,
+ * file load and replay all work on one statically sized buffer, so a full
+ * 1024-edge signal needs no heap and the ISR plays it back without copying.
+ *
+ * M1 Project
+ */
+
+#ifndef M1_IR_RAW_H_
+#define M1_IR_RAW_H_
+
+#include "ff.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Same limit as Flipper Zero raw signals */
+#define IR_RAW_EDGES_MAX 1024
+
+#define IR_RAW_FREQ_DEFAULT 38000 /* Hz, used when the carrier is unknown  */
+#define IR_RAW_FREQ_MIN 10000
+#define IR_RAW_FREQ_MAX 56000
+#define IR_RAW_DUTY_DEFAULT 33    /* percent                                */
+
+#define IR_RAW_MIN_EDGES 6        /* shorter captures are treated as noise  */
+#define IR_RAW_MIN_US 10          /* shortest period the TX timer can play  */
+#define IR_RAW_OTA_MAX_US 0xFFFE  /* longest period per OTA entry           */
+#define IR_RAW_END_GAP_MS 150     /* silence that ends a raw capture        */
+
+#define IR_RAW_LEARNED_DIR "0:/IR/Learned"
+
+typedef struct {
+  /* OTA entries; one spare slot because the TX ISR preloads entry n+1 */
+  uint16_t ota[IR_RAW_EDGES_MAX + 1];
+  uint16_t count;     /* Used OTA entries                              */
+  uint32_t frequency; /* Carrier frequency, Hz                         */
+  uint8_t duty_pct;   /* Carrier duty cycle, percent                   */
+  bool truncated;     /* Capture did not fit into IR_RAW_EDGES_MAX     */
+} S_IR_Raw_t;
+
+/*
+ * ir_raw_reset() - Empty the signal and set the default carrier.
+ */
+void ir_raw_reset(S_IR_Raw_t *raw);
+
+/*
+ * ir_raw_add() - Append one mark or space period.
+ *
+ * Consecutive periods of the same level are merged; periods longer than
+ * IR_RAW_OTA_MAX_US take several OTA entries of that level.
+ *
+ * @return false once the buffer is full (raw->truncated is set)
+ */
+bool ir_raw_add(S_IR_Raw_t *raw, uint32_t duration_us, bool mark);
+
+/*
+ * ir_raw_finish() - Close a capture: drop a trailing space and check length.
+ *
+ * @return true if the signal holds at least IR_RAW_MIN_EDGES periods
+ */
+bool ir_raw_finish(S_IR_Raw_t *raw);
+
+/*
+ * ir_raw_edge_count() - Number of periods as written to a .ir "data:" line.
+ */
+uint16_t ir_raw_edge_count(const S_IR_Raw_t *raw);
+
+/*
+ * ir_raw_read_data() - Parse a "data:" value from the current file position.
+ *
+ * Reads space separated microsecond values (mark first) up to the end of
+ * the line, so lines far longer than a line buffer are fine.
+ */
+bool ir_raw_read_data(FIL *f, S_IR_Raw_t *raw);
+
+/*
+ * ir_raw_load() - Load the raw signal whose "data:" value starts at
+ * data_offset in a .ir file (offset recorded by ir_universal_parse_file()).
+ */
+bool ir_raw_load(const char *path, uint32_t data_offset, uint32_t frequency,
+                 uint8_t duty_pct, S_IR_Raw_t *raw);
+
+/*
+ * ir_raw_save() - Write a Flipper-compatible .ir file with one raw signal.
+ *
+ * @param path  Full FatFs path of the file (overwritten)
+ * @param name  Button name stored in the "name:" field
+ */
+bool ir_raw_save(const char *path, const char *name, const S_IR_Raw_t *raw);
+
+/*
+ * ir_raw_parse_duty() - Convert a "duty_cycle:" value ("0.330000") to percent.
+ */
+uint8_t ir_raw_parse_duty(const char *s);
+
+#endif /* M1_IR_RAW_H_ */
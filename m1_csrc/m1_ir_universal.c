@@ -18,6 +18,7 @@
 #include "m1_buzzer.h"
 #include "m1_display.h"
 #include "m1_infrared.h"
+#include "m1_ir_raw.h"
 #include "m1_led_indicator.h"
 #include "m1_sdcard.h"
 #include "m1_system.h"
@@ -30,6 +31,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 /* -------------------------------------------------------------------------
@@ -190,6 +192,7 @@ uint8_t ir_universal_parse_file(const char *path, S_IR_Device_t *out) {
   char *key_str, *val_str;
   uint8_t in_block;
   S_IR_Cmd_t cur;
+  FSIZE_t pos, line_pos;
 
   if (!out)
     return 0;
@@ -203,8 +206,11 @@ uint8_t ir_universal_parse_file(const char *path, S_IR_Device_t *out) {
   in_block = 0;
   memset(&cur, 0, sizeof(cur));
 
+  line_pos = f_tell(&f);
   while (f_gets(line, sizeof(line), &f)) {
     p = ir_trim(line);
+    pos = line_pos;
+    line_pos = f_tell(&f);
 
     /* Skip comments and empty lines */
     if (p[0] == '#' || p[0] == '\0')
@@ -233,9 +239,27 @@ uint8_t ir_universal_parse_file(const char *path, S_IR_Device_t *out) {
       continue;
 
     if (strcmp(key_str, "type") == 0) {
-      /* Only support parsed (not raw) signals */
-      if (strcmp(val_str, "parsed") != 0)
+      if (strcmp(val_str, "raw") == 0) {
+        cur.is_raw = true;
+        cur.raw_freq = IR_RAW_FREQ_DEFAULT;
+        cur.raw_duty = IR_RAW_DUTY_DEFAULT;
+      } else if (strcmp(val_str, "parsed") != 0) {
         in_block = 0; /* skip this block */
+      }
+      continue;
+    }
+
+    if (cur.is_raw) {
+      if (strcmp(key_str, "frequency") == 0) {
+        cur.raw_freq = strtoul(val_str, NULL, 10);
+      } else if (strcmp(key_str, "duty_cycle") == 0) {
+        cur.raw_duty = ir_raw_parse_duty(val_str);
+      } else if (strcmp(key_str, "data") == 0) {
+        /* Only remember where the timings are; a long "data:" line is split
+         * by f_gets() and the remaining chunks (no ':') are skipped above */
+        cur.raw_offset = pos + (uint32_t)(val_str - line);
+        cur.valid = true;
+      }
       continue;
     }
 
@@ -795,8 +819,24 @@ static bool ir_run_command_ui(const char *file_path, const char *device_name) {
       m1_led_fast_blink(LED_BLINK_ON_RGB, LED_FASTBLINK_PWM_M,
                         LED_FASTBLINK_ONTIME_M);
 
-      irsnd_generate_tx_data(dev->cmds[sel].irmp);
-      infrared_transmit(1);
+      if (dev->cmds[sel].is_raw) {
+        S_IR_Raw_t *raw = infrared_raw_buffer();
+
+        if (!ir_raw_load(file_path, dev->cmds[sel].raw_offset,
+                         dev->cmds[sel].raw_freq, dev->cmds[sel].raw_duty,
+                         raw)) {
+          m1_led_fast_blink(LED_BLINK_ON_RGB, LED_FASTBLINK_PWM_OFF,
+                            LED_FASTBLINK_ONTIME_OFF);
+          ir_ui_show_notice("IR Error:", "Bad raw data",
+                            IR_UI_FEEDBACK_MS_DEFAULT);
+          ir_ui_draw_list(dtitle, ptrs, dev->count, sel, row_offset);
+          continue;
+        }
+        infrared_transmit_raw(raw);
+      } else {
+        irsnd_generate_tx_data(dev->cmds[sel].irmp);
+        infrared_transmit(1);
+      }
       infrared_transmit(0); /* Start the first frame */
       tx_active = true;
       continue;
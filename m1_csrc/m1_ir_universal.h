@@ -44,12 +44,17 @@
 
 /*
  * One parsed IR command entry from a .ir file.
- * Corresponds to one "name/type/protocol/address/command" block.
+ * Corresponds to one "name/type/protocol/address/command" block, or to one
+ * "name/type/frequency/duty_cycle/data" block for raw signals.
  */
 typedef struct {
   char name[IR_UNIVERSAL_NAME_LEN_MAX]; /* Button label, e.g. "Power" */
   IRMP_DATA irmp; /* Protocol, address, command ready for IRSND */
   bool valid;     /* true if fully parsed */
+  bool is_raw;    /* "type: raw", timings are loaded from the file on send */
+  uint8_t raw_duty;    /* Carrier duty cycle, percent (raw only) */
+  uint32_t raw_freq;   /* Carrier frequency, Hz (raw only) */
+  uint32_t raw_offset; /* File offset of the "data:" value (raw only) */
 } S_IR_Cmd_t;
 
 /*
@@ -16,6 +16,8 @@
 #include "m1_log_debug.h"
 #include "app_freertos.h"
 #include "cli_app.h"
+#include "m1_compile_cfg.h"
+#include "m1_mem_pool.h"
 #include "m1_ring_buffer.h"
 #include "m1_usb_cdc_msc.h"
 #include "main.h"
@@ -37,6 +39,9 @@
 
 #define M1_LOGDB_LEVEL_DEFAULT LOG_DEBUG_LEVEL_INFO
 
+#define M1_LOGDB_MESSAGE_MAX_SIZE (2 * M1_LOGDB_MESSAGE_SIZE)
+#define M1_LOGDB_MSG_POOL_BLOCKS 4
+
 #define GET_MIN_NUM(m, n) ((m) < (n) ? (m) : (n))
 #define GET_MAX_NUM(m, n) ((m) > (n) ? (m) : (n))
 #define IS_BUFFER_VALID(pbuffer)                                               \
@@ -91,6 +96,11 @@ static uint8_t log_capture_buf[LOG_CAPTURE_BUF_SIZE];
 static S_M1_RingBuffer log_capture_rb;
 
 static SemaphoreHandle_t mutex_log_write_trans;
+
+/* Message buffers of m1_logdb_printf(), one per concurrent caller */
+M1_MEM_POOL_STORAGE(logdb_msg_pool_storage, M1_LOGDB_MESSAGE_MAX_SIZE,
+                    M1_LOGDB_MSG_POOL_BLOCKS);
+static S_M1_MemPool logdb_msg_pool;
 TaskHandle_t log_db_task_hdl;
 
 /********************* F U N C T I O N   P R O T O T Y P E S ******************/
@@ -107,8 +117,6 @@ void m1_logdb_deinit(void);
 void m1_logdb_printf(S_M1_LogDebugLevel_t level, const char *tag,
                      const char *format, ...);
 void m1_logdb_write(const char *data);
-static void m1_logdb_dyn_vsprintf(const char *format, va_list pargs,
-                                  char **pstring);
 
 static void m1_logdb_start_dma_tx(void);
 void m1_logdb_update_tx_buffer(void);
@@ -164,6 +172,13 @@ void m1_logdb_init(void) {
   huart_logdb.Init.ClockPrescaler = UART_PRESCALER_DIV1;
   huart_logdb.AdvancedInit.AdvFeatureInit = UART_ADVFEATURE_NO_INIT;
 
+  if (m1_usbcdc_mode == CDC_MODE_VCP) {
+    /* USB-UART bridge: an overrun must not stop the circular RX DMA */
+    huart_logdb.AdvancedInit.AdvFeatureInit =
+        UART_ADVFEATURE_RXOVERRUNDISABLE_INIT;
+    huart_logdb.AdvancedInit.OverrunDisable = UART_ADVFEATURE_OVERRUN_DISABLE;
+  }
+
   if (HAL_UART_Init(&huart_logdb) != HAL_OK) {
     Error_Handler();
   }
@@ -178,7 +193,12 @@ void m1_logdb_init(void) {
     Error_Handler();
   }
 
-  if (HAL_UARTEx_DisableFifoMode(&huart_logdb) != HAL_OK) {
+  if (m1_usbcdc_mode == CDC_MODE_VCP) {
+    // The FIFO absorbs the DMA request latency at high baud rates
+    if (HAL_UARTEx_EnableFifoMode(&huart_logdb) != HAL_OK) {
+      Error_Handler();
+    }
+  } else if (HAL_UARTEx_DisableFifoMode(&huart_logdb) != HAL_OK) {
     Error_Handler();
   }
 
@@ -320,10 +340,16 @@ void m1_logdb_init(void) {
   }
 #endif // #ifdef M1_DEBUG_CLI_ENABLE
 
+  static uint8_t log_q_storage[1];
+  static StaticQueue_t log_q_ctrl;
+
+  m1_mem_pool_init(&logdb_msg_pool, logdb_msg_pool_storage,
+                   M1_LOGDB_MESSAGE_MAX_SIZE, M1_LOGDB_MSG_POOL_BLOCKS);
+
   mutex_log_write_trans = xSemaphoreCreateMutex();
   assert(mutex_log_write_trans);
 
-  log_q_hdl = xQueueCreate(1, 1);
+  log_q_hdl = xQueueCreateStatic(1, 1, log_q_storage, &log_q_ctrl);
   assert(log_q_hdl != NULL);
 } // void m1_logdb_init(UART_HandleTypeDef *phuart)
 
@@ -512,7 +538,15 @@ void log_db_handler_task(void *param) {
   while (1) {
     ret = xQueueReceive(log_q_hdl, &q_item, portMAX_DELAY);
     if (ret == pdPASS) {
-      if ((hUsbDeviceFS.pClassData != NULL) && (m1_USB_CDC_ready == 0)) {
+      if (m1_usbcdc_mode == CDC_MODE_VCP) {
+        /* Both ports carry the bridge, the log is only kept for the CLI
+         * 'log' command */
+        m1_ringbuffer_advance_read(plogdb_tx_rb,
+                                   m1_ringbuffer_get_read_len(plogdb_tx_rb));
+      }
+      // The capture stream owns the USB IN endpoint while it runs
+      else if ((hUsbDeviceFS.pClassData != NULL) && (m1_USB_CDC_ready == 0) &&
+               (m1_usbcdc_mode != CDC_MODE_STREAM)) {
         m1_logdb_start_usbcdc_tx();
       } else {
         m1_logdb_start_dma_tx();
@@ -570,71 +604,30 @@ void m1_logdb_printf(S_M1_LogDebugLevel_t level, const char *tag,
     break;
   } // switch(level)
 
-  db_string = (char *)malloc(M1_LOGDB_MESSAGE_SIZE);
+  db_string = (char *)m1_mem_pool_alloc(&logdb_msg_pool);
   if (db_string == NULL) {
-    return; // Do nothing if memory allocation fails
+    return; // Do nothing if all message blocks are in use
   }
 
   if (*log_choice != 'R') {
-    sprintf(db_string, " %lu [%s][%s] ", HAL_GetTick(), log_choice, tag);
+    snprintf(db_string, M1_LOGDB_MESSAGE_MAX_SIZE, " %lu [%s][%s] ",
+             HAL_GetTick(), log_choice, tag);
     m1_logdb_write(db_string);
   }
 
+  // Longer messages are truncated to the block size
   va_start(pargs, format);
-  m1_logdb_dyn_vsprintf(format, pargs, &db_string);
+  vsnprintf(db_string, M1_LOGDB_MESSAGE_MAX_SIZE, format, pargs);
   va_end(pargs);
 
-  if (db_string != NULL) {
-    m1_logdb_write(db_string);
-    free(db_string);
-  } // if ( db_string!=NULL )
+  m1_logdb_write(db_string);
+  m1_mem_pool_free(&logdb_msg_pool, db_string);
 
   // m1_logdb_write("\r\n");
 
 } // void m1_logdb_printf(S_M1_LogDebugLevel_t level, const char* tag, const
   // char* format, ...)
 
-/*============================================================================*/
-/*
- * This function copy the log/debug message to the buffer.
- * The buffer size will be dynamically adjusted.
- * Its purpose is replace the standard function vsprintf().
- *
- */
-/*============================================================================*/
-static void m1_logdb_dyn_vsprintf(const char *format, va_list pargs,
-                                  char **pstring) {
-  int ret_n;
-  uint8_t mem_size;
-  va_list pargsc;
-
-  mem_size = M1_LOGDB_MESSAGE_SIZE; // Set the default size first
-  while (1) {
-    va_copy(pargsc, pargs); // Make a copy of the argument list
-    ret_n = vsnprintf(*pstring, mem_size, format, pargsc); // Try it
-    if (ret_n > -1)                                        // Good try?
-    {
-      if (ret_n < mem_size) // Good size?
-        break;              // Exit loop and return
-      else
-        mem_size = ret_n + 20; // Adjust the allocated space
-    } // if ( ret_n > -1 )
-    else
-      mem_size = UCHAR_MAX; // Exit condition
-
-    free(*pstring);  // Free allocated memory slot
-    *pstring = NULL; // Caller function may check NULL for error condition
-    if (mem_size > 2 * M1_LOGDB_MESSAGE_SIZE) // Memory size exceeds the maximum
-                                              // allowed size?
-      break;                                  // Exit
-    *pstring = (char *)malloc(mem_size);
-    if (*pstring == NULL) {
-      break; // Do nothing if memory allocation fails
-    }
-  } // while (1)
-} // static void m1_logdb_dyn_vsprintf(const char *format, va_list pargs, char
-  // **pstring)
-
 /*============================================================================*/
 /*
  * Read recent log messages from the capture buffer without consuming them.
@@ -47,7 +47,7 @@ void m1_logdb_printf(S_M1_LogDebugLevel_t, const char *tag, const char *format,
 
 #define M1_LOGDB_MESSAGE_SIZE 80
 #define M1_LOGDB_TX_BUFFER_SIZE 2048
-#define M1_LOGDB_RX_BUFFER_SIZE 256
+#define M1_LOGDB_RX_BUFFER_SIZE 1024
 #define M1_LOGDB_DMA_TX_LEN 64
 
 extern UART_HandleTypeDef huart_logdb;
@@ -17,22 +17,41 @@
 #include "FreeRTOS.h"
 #include "main.h"
 #include "cmsis_os.h"
+#include "task.h"
 #include "m1_low_power.h"
 
 /*************************** D E F I N E S ************************************/
 
 //#define SYSTICK_CURRENT_VALUE_REG		( * ( ( volatile uint32_t * ) 0xe000e018 ) )
 
+// Time base of the profile: TIM4, shared with the run-time stats (app_freertos.c)
+#define LOW_POWER_TIME_NOW()			getRunTimeCounterValue()
+
 
 //************************** C O N S T A N T **********************************/
 
+static const struct
+{
+	int16_t irqn;
+	const char *name;
+} low_power_irq_names[] = {
+	{SysTick_IRQn, "SysTick"},
+	{RTC_IRQn, "RTC"},
+	{TIM6_IRQn, "TIM6 (HAL tick)"},
+	{TIM4_IRQn, "TIM4 (run time)"},
+	{I2C1_EV_IRQn, "I2C1"},
+	{I2C2_EV_IRQn, "I2C2"},
+	{SPI1_IRQn, "SPI1"},
+	{USART1_IRQn, "USART1"},
+	{LPTIM1_IRQn, "LPTIM1"},
+	{USB_DRD_FS_IRQn, "USB"},
+	{SDMMC1_IRQn, "SDMMC1"}
+};
+
 //************************** S T R U C T U R E S *******************************
 
 /***************************** V A R I A B L E S ******************************/
 
-//static uint32_t tick_1, tick_2;
-static TickType_t systick_count_1, systick_count_2;
-
 /********************* F U N C T I O N   P R O T O T Y P E S ******************/
 
 /*
@@ -42,6 +61,12 @@ static TickType_t systick_count_1, systick_count_2;
  */
 void vPortSetupTimerInterrupt( void );
 
+void m1_low_power_init(void);
+void m1_low_power_add_current(int16_t avg_current_mA);
+void m1_low_power_get_profile(S_M1_PwrProf_Snapshot *psnap);
+const char *m1_low_power_irq_name(int16_t irqn);
+static int16_t low_power_wake_irqn(void);
+
 /*
  * Exception handlers.
  */
@@ -52,6 +77,20 @@ void vPortSetupTimerInterrupt( void );
 /*************** F U N C T I O N   I M P L E M E N T A T I O N ****************/
 
 
+/*============================================================================*/
+/*
+ * This function starts the power profile, before the scheduler runs. The
+ * time base is started here, the kernel leaves it running when it starts.
+ */
+/*============================================================================*/
+void m1_low_power_init(void)
+{
+	configureTimerForRunTimeStats();
+	m1_power_profile_reset(RUN_TIME_STATS_CLOCK_HZ, LOW_POWER_TIME_NOW());
+} // void m1_low_power_init(void)
+
+
+
 /*============================================================================*/
 /*
  * This function is called before the device is placed in sleep mode
@@ -60,11 +99,9 @@ void vPortSetupTimerInterrupt( void );
 /*============================================================================*/
 void PreSleepProcessing(uint32_t ulExpectedIdleTime)
 {
-    (void)ulExpectedIdleTime; /* Unused: stub for future work. May need removal later. */
-/* place for user code */
-	HAL_SuspendTick();
-	//tick_1 = SYSTICK_CURRENT_VALUE_REG;
-	systick_count_1 = xTaskGetTickCount();
+	// The HAL tick (TIM6) keeps running: the kernel tick is not suppressed,
+	// so the sleep lasts one tick at most, and HAL_GetTick() must not lose it
+	m1_power_profile_sleep_enter(LOW_POWER_TIME_NOW(), ulExpectedIdleTime);
 	//ulExpectedIdleTime = prvGetExpectedIdleTime();
 //	HAL_LPTIM_TimeOut_Start_IT(&hlptim1, 0xFFFF, ulExpectedIdleTime);
 	// Put the microcontroller into low-power mode
@@ -87,15 +124,83 @@ void PreSleepProcessing(uint32_t ulExpectedIdleTime)
 void PostSleepProcessing(uint32_t ulExpectedIdleTime)
 {
     (void)ulExpectedIdleTime; /* Unused: stub for future work. May need removal later. */
-/* place for user code */
 //	HAL_LPTIM_TimeOut_Stop_IT(&hlptim1);
-	//tick_2 = SYSTICK_CURRENT_VALUE_REG;
-	systick_count_2 = xTaskGetTickCount();
-	HAL_ResumeTick();
+	m1_power_profile_sleep_exit(LOW_POWER_TIME_NOW(), low_power_wake_irqn());
 } // void PostSleepProcessing(uint32_t ulExpectedIdleTime)
 
 
 
+/*============================================================================*/
+/*
+ * This function returns the interrupt that ended the sleep. Interrupts are
+ * still disabled, it is pending. SysTick is checked first, then the NVIC
+ * lines from the lowest number.
+ */
+/*============================================================================*/
+static int16_t low_power_wake_irqn(void)
+{
+	uint32_t pending;
+	uint8_t i;
+
+	if ( SCB->ICSR & SCB_ICSR_PENDSTSET_Msk )
+		return SysTick_IRQn;
+
+	for ( i = 0; i < (sizeof(NVIC->ISPR)/sizeof(NVIC->ISPR[0])); i++ )
+	{
+		pending = NVIC->ISPR[i] & NVIC->ISER[i];
+		if ( pending )
+			return (int16_t)(i*32 + __builtin_ctz(pending));
+	}
+
+	return PWR_PROF_WAKE_UNKNOWN;
+} // static int16_t low_power_wake_irqn(void)
+
+
+
+/*============================================================================*/
+/*
+ * This function adds a battery gauge reading to the power profile
+ */
+/*============================================================================*/
+void m1_low_power_add_current(int16_t avg_current_mA)
+{
+	taskENTER_CRITICAL();
+	m1_power_profile_add_current(LOW_POWER_TIME_NOW(), avg_current_mA);
+	taskEXIT_CRITICAL();
+} // void m1_low_power_add_current(int16_t avg_current_mA)
+
+
+
+void m1_low_power_get_profile(S_M1_PwrProf_Snapshot *psnap)
+{
+	taskENTER_CRITICAL();
+	m1_power_profile_get(LOW_POWER_TIME_NOW(), psnap);
+	taskEXIT_CRITICAL();
+} // void m1_low_power_get_profile(S_M1_PwrProf_Snapshot *psnap)
+
+
+
+/*============================================================================*/
+/*
+ * This function returns a name for the interrupts that usually wake the
+ * device, NULL for the others.
+ */
+/*============================================================================*/
+const char *m1_low_power_irq_name(int16_t irqn)
+{
+	uint8_t i;
+
+	for ( i = 0; i < (sizeof(low_power_irq_names)/sizeof(low_power_irq_names[0])); i++ )
+	{
+		if ( low_power_irq_names[i].irqn==irqn )
+			return low_power_irq_names[i].name;
+	}
+
+	return NULL;
+} // const char *m1_low_power_irq_name(int16_t irqn)
+
+
+
 #ifndef M1_MYTICKLESS_USE_RTC
 
 /*============================================================================*/
@@ -116,16 +221,41 @@ void vPortSuppressTicksAndSleep( TickType_t xExpectedIdleTime )
 /*============================================================================*/
 /*
  *  Generated when configUSE_TICKLESS_IDLE == 2.
- * 	Function called in tasks.c (in portTASK_FUNCTION).
- * 	TO BE COMPLETED or TO BE REPLACED by a user one, overriding that weak one.
+ * 	Function called in tasks.c (in portTASK_FUNCTION), with the scheduler
+ * 	suspended, when no task is ready for at least
+ * 	configEXPECTED_IDLE_TIME_BEFORE_SLEEP ticks.
+ * 	The core sleeps until the next interrupt. SysTick and the HAL tick keep
+ * 	running, so no tick has to be made up after the wake-up, but a sleep
+ * 	lasts one tick (1 ms) at most whatever xExpectedIdleTime is. The TIM4
+ * 	run-time stats overflow also wakes the core, about every 0.65 s.
+ * 	Sleeps across several ticks (SysTick stopped, RTC wake-up timer) are
+ * 	not done.
  */
 /*============================================================================*/
-/*
 void vPortSuppressTicksAndSleep( TickType_t xExpectedIdleTime )
 {
-
+	// Not taskENTER_CRITICAL(), it would mask the interrupts that end the sleep
+	__disable_irq();
+	__DSB();
+	__ISB();
+
+	if ( eTaskConfirmSleepModeStatus()==eAbortSleep )
+	{
+		m1_power_profile_sleep_abort();
+		__enable_irq();
+		return;
+	}
+
+	configPRE_SLEEP_PROCESSING(xExpectedIdleTime);
+	__DSB();
+	__WFI();
+	__ISB();
+	configPOST_SLEEP_PROCESSING(xExpectedIdleTime);
+
+	// The interrupt that ended the sleep runs now
+	__enable_irq();
 } // void vPortSuppressTicksAndSleep( TickType_t xExpectedIdleTime )
-*/
+
 #endif // #ifdef M1_MYTICKLESS_USE_RTC
 
 
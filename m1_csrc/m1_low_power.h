@@ -13,6 +13,9 @@
 #ifndef M1_LOW_POWER_H_
 #define M1_LOW_POWER_H_
 
+#include <stdint.h>
+#include "m1_power_profile.h"
+
 // Use RTC for applications that need to sleep for hours, instead of a few hundred/thousand milliseconds max using SysTick/LPTIM
 #define M1_MYTICKLESS_USE_RTC
 
@@ -42,6 +45,11 @@
 
 extern uint8_t ucRTC_flag_wutf;
 
+void m1_low_power_init(void);
+void m1_low_power_add_current(int16_t avg_current_mA);
+void m1_low_power_get_profile(S_M1_PwrProf_Snapshot *psnap);
+const char *m1_low_power_irq_name(int16_t irqn);
+
 
 
 #endif /* M1_LOW_POWER_H_ */
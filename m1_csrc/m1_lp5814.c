@@ -22,16 +22,22 @@
 
 /*************************** D E F I N E S ************************************/
 
+#define LP5814_BATCH_MAX		8	// Register writes sent in one I2C batch
+
 //************************** C O N S T A N T **********************************/
 
 //************************** S T R U C T U R E S *******************************
 
+typedef struct
+{
+	S_M1_I2C_Batch batch;
+	S_M1_I2C_Trans_Inf trans[LP5814_BATCH_MAX];
+} S_M1_lp5814_Batch;
+
 /***************************** V A R I A B L E S ******************************/
 
 S_M1_lp5814 m1_lp5814_ctl;
 
-static S_M1_I2C_Trans_Inf i2c_inf;
-
 void (*blink_timer_cb_func)(void) = NULL;
 
 /********************* F U N C T I O N   P R O T O T Y P E S ******************/
@@ -61,6 +67,8 @@ void lp5814_fastblink_on_RGB(uint8_t pwm_rgb, uint16_t on_off_ms);
 void lp5814_fastblink_on_R_G_B(uint8_t r_g_b, uint8_t pwm_rgb, uint16_t on_off_ms);
 void lp5814_set_blink_timer(uint8_t r_g_b, uint16_t on_off_ms, uint8_t mode, void (*callback_fn)());
 static void lp5814_stop_blink_timer(TimerHandle_t xTimer);
+static void lp5814_batch_write(S_M1_lp5814_Batch *pbatch, uint8_t reg, uint8_t value);
+static bool lp5814_batch_flush(S_M1_lp5814_Batch *pbatch);
 
 /*************** F U N C T I O N   I M P L E M E N T A T I O N ****************/
 
@@ -126,6 +134,8 @@ uint8_t	lp5814_set_time(float f)
 /*============================================================================*/
 uint8_t lp5814_readRegister(uint8_t reg)
 {
+	S_M1_I2C_Trans_Inf i2c_inf;
+
 	i2c_inf.dev_id = I2C_DEVICE_LP5814;
 	i2c_inf.timeout = I2C_READ_TIMEOUT;
 	i2c_inf.trans_type = I2C_TRANS_READ_REGISTER;
@@ -149,6 +159,7 @@ uint8_t lp5814_readRegister(uint8_t reg)
 /*============================================================================*/
 bool lp5814_writeRegister(uint8_t reg, uint8_t value)
 {
+	S_M1_I2C_Trans_Inf	i2c_inf;
 	HAL_StatusTypeDef	stat;
 
 	i2c_inf.dev_id = I2C_DEVICE_LP5814;
@@ -338,13 +349,16 @@ void lp5814_shutdown(void)
 /*============================================================================*/
 void lp5814_led_on(uint8_t port, uint8_t value)
 {
+	S_M1_lp5814_Batch batch = {0};
+
 	lp5814_writeRegister(LP5814_OUT_PWM(port), value);
 
 	uint8_t stat = lp5814_readRegister(LP5814_REG_DEV_CONFIG1);
 
 	stat |= LP5814_OUT_ENABLE(port);
-	lp5814_writeRegister(LP5814_REG_DEV_CONFIG1, stat);
-	lp5814_writeRegister(LP5814_UPDATE_CMD, LP5814_UPDATE);
+	lp5814_batch_write(&batch, LP5814_REG_DEV_CONFIG1, stat);
+	lp5814_batch_write(&batch, LP5814_UPDATE_CMD, LP5814_UPDATE);
+	lp5814_batch_flush(&batch);
 }
 
 
@@ -356,26 +370,28 @@ void lp5814_led_on(uint8_t port, uint8_t value)
 /*============================================================================*/
 void lp5814_led_on_rgb(uint8_t led_rgb, uint8_t value)
 {
+	S_M1_lp5814_Batch batch = {0};
 	uint8_t stat = lp5814_readRegister(LP5814_REG_DEV_CONFIG1);
 
 	if ( led_rgb & LED_BLINK_ON_RED )
 	{
-		lp5814_writeRegister(LP5814_OUT_PWM(LED_R), value);
+		lp5814_batch_write(&batch, LP5814_OUT_PWM(LED_R), value);
 		stat |= LP5814_OUT_ENABLE(LED_R);
 	}
 	if ( led_rgb & LED_BLINK_ON_GREEN )
 	{
-		lp5814_writeRegister(LP5814_OUT_PWM(LED_G), value);
+		lp5814_batch_write(&batch, LP5814_OUT_PWM(LED_G), value);
 		stat |= LP5814_OUT_ENABLE(LED_G);
 	}
 	if ( led_rgb & LED_BLINK_ON_BLUE )
 	{
-		lp5814_writeRegister(LP5814_OUT_PWM(LED_B), value);
+		lp5814_batch_write(&batch, LP5814_OUT_PWM(LED_B), value);
 		stat |= LP5814_OUT_ENABLE(LED_B);
 	}
 
-	lp5814_writeRegister(LP5814_REG_DEV_CONFIG1, stat);
-	lp5814_writeRegister(LP5814_UPDATE_CMD, LP5814_UPDATE);
+	lp5814_batch_write(&batch, LP5814_REG_DEV_CONFIG1, stat);
+	lp5814_batch_write(&batch, LP5814_UPDATE_CMD, LP5814_UPDATE);
+	lp5814_batch_flush(&batch);
 }
 
 
@@ -387,11 +403,13 @@ void lp5814_led_on_rgb(uint8_t led_rgb, uint8_t value)
 /*============================================================================*/
 void lp5814_led_off(uint8_t port)
 {
+	S_M1_lp5814_Batch batch = {0};
 	uint8_t stat = lp5814_readRegister(LP5814_REG_DEV_CONFIG1);
 
 	stat &= ~LP5814_OUT_ENABLE(port);
-	lp5814_writeRegister(LP5814_REG_DEV_CONFIG1, stat);
-	lp5814_writeRegister(LP5814_UPDATE_CMD, LP5814_UPDATE);
+	lp5814_batch_write(&batch, LP5814_REG_DEV_CONFIG1, stat);
+	lp5814_batch_write(&batch, LP5814_UPDATE_CMD, LP5814_UPDATE);
+	lp5814_batch_flush(&batch);
 }
 
 
@@ -492,32 +510,34 @@ void lp5814_fastblink_on_R_G_B(uint8_t r_g_b, uint8_t pwm_rgb, uint16_t on_off_m
 	 * 						SLOPER_T2=x PWM4=0
 	 */
 
+	S_M1_lp5814_Batch batch = {0};
 	uint8_t rgb_out_auto = 0;
 
 	if (on_off_ms == 0)
 	{
-		lp5814_writeRegister(LP5814_STOP_CMD, LP5814_STOP_ANI);
-		lp5814_writeRegister(LP5814_ENGINE_CONFIG4, 0x00); // Engine1_Order3-Order0 | Engine0_Order3-Order0 disable
-		lp5814_writeRegister(LP5814_REG_DEV_CONFIG3, 0x00); // animation disable
-		lp5814_writeRegister(LP5814_REG_DEV_CONFIG1, LP5814_OUT_ENABLE(LED_W));
-		lp5814_writeRegister(LP5814_UPDATE_CMD, LP5814_UPDATE);
+		lp5814_batch_write(&batch, LP5814_STOP_CMD, LP5814_STOP_ANI);
+		lp5814_batch_write(&batch, LP5814_ENGINE_CONFIG4, 0x00); // Engine1_Order3-Order0 | Engine0_Order3-Order0 disable
+		lp5814_batch_write(&batch, LP5814_REG_DEV_CONFIG3, 0x00); // animation disable
+		lp5814_batch_write(&batch, LP5814_REG_DEV_CONFIG1, LP5814_OUT_ENABLE(LED_W));
+		lp5814_batch_write(&batch, LP5814_UPDATE_CMD, LP5814_UPDATE);
+		lp5814_batch_flush(&batch);
 		return;
 	}
 
 	on_off_ms += (LED_ONTIME_MIN - 1);
 	on_off_ms /= LED_ONTIME_MIN;
 
-	lp5814_writeRegister(LP5814_PATTERN0_PAUSE, LP5814_PATTERNX_PAUSE_H_L(0, 0));	// PAUSE_T0(0 msec). PAUSE_T1(0 msec)
-	lp5814_writeRegister(LP5814_PATTERN_REPEAT_TIME, 0x0F);	// infinite
+	lp5814_batch_write(&batch, LP5814_PATTERN0_PAUSE, LP5814_PATTERNX_PAUSE_H_L(0, 0));	// PAUSE_T0(0 msec). PAUSE_T1(0 msec)
+	lp5814_batch_write(&batch, LP5814_PATTERN_REPEAT_TIME, 0x0F);	// infinite
 
-	lp5814_writeRegister(LP5814_PATTERN_PWM_0, pwm_rgb);	// H
-	lp5814_writeRegister(LP5814_PATTERN_PWM_1, pwm_rgb);	// H
-	lp5814_writeRegister(LP5814_PATTERN_PWM_2, 0x00);	// L
-	lp5814_writeRegister(LP5814_PATTERN_PWM_3, 0x00);	// L
-	lp5814_writeRegister(LP5814_PATTERN_PWM_4, 0x00);	// L
+	lp5814_batch_write(&batch, LP5814_PATTERN_PWM_0, pwm_rgb);	// H
+	lp5814_batch_write(&batch, LP5814_PATTERN_PWM_1, pwm_rgb);	// H
+	lp5814_batch_write(&batch, LP5814_PATTERN_PWM_2, 0x00);	// L
+	lp5814_batch_write(&batch, LP5814_PATTERN_PWM_3, 0x00);	// L
+	lp5814_batch_write(&batch, LP5814_PATTERN_PWM_4, 0x00);	// L
 
-	lp5814_writeRegister(LP5814_PATTERN_SLOPER_TIME1, LP5814_SLOPER_TIMEX_PATTERN_H_L(0, on_off_ms));	// T1(0 msec), T0(n*50 msec)
-	lp5814_writeRegister(LP5814_PATTERN_SLOPER_TIME2, LP5814_SLOPER_TIMEX_PATTERN_H_L(0, on_off_ms));	// T3(0 msec) , T2(n*50 msec)
+	lp5814_batch_write(&batch, LP5814_PATTERN_SLOPER_TIME1, LP5814_SLOPER_TIMEX_PATTERN_H_L(0, on_off_ms));	// T1(0 msec), T0(n*50 msec)
+	lp5814_batch_write(&batch, LP5814_PATTERN_SLOPER_TIME2, LP5814_SLOPER_TIMEX_PATTERN_H_L(0, on_off_ms));	// T3(0 msec) , T2(n*50 msec)
 
 	if ( r_g_b & LED_BLINK_ON_RED )
 		rgb_out_auto |= LP5814_OUT_ENABLE(LED_R);
@@ -526,13 +546,14 @@ void lp5814_fastblink_on_R_G_B(uint8_t r_g_b, uint8_t pwm_rgb, uint16_t on_off_m
 	if ( r_g_b & LED_BLINK_ON_BLUE )
 		rgb_out_auto |= LP5814_OUT_ENABLE(LED_B);
 
-	lp5814_writeRegister(LP5814_REG_DEV_CONFIG1, rgb_out_auto | LP5814_OUT_ENABLE(LED_W));
-	lp5814_writeRegister(LP5814_REG_DEV_CONFIG3, rgb_out_auto);
-	lp5814_writeRegister(LP5814_ENGINE_CONFIG4, 0x01); // Engine1_Order3-Order0 | Engine0_Order3-Order0 enable
+	lp5814_batch_write(&batch, LP5814_REG_DEV_CONFIG1, rgb_out_auto | LP5814_OUT_ENABLE(LED_W));
+	lp5814_batch_write(&batch, LP5814_REG_DEV_CONFIG3, rgb_out_auto);
+	lp5814_batch_write(&batch, LP5814_ENGINE_CONFIG4, 0x01); // Engine1_Order3-Order0 | Engine0_Order3-Order0 enable
 
-	lp5814_writeRegister(LP5814_UPDATE_CMD, LP5814_UPDATE);
+	lp5814_batch_write(&batch, LP5814_UPDATE_CMD, LP5814_UPDATE);
 
-	lp5814_writeRegister(LP5814_START_CMD, LP5814_START_ANI);
+	lp5814_batch_write(&batch, LP5814_START_CMD, LP5814_START_ANI);
+	lp5814_batch_flush(&batch);
 } // void lp5814_fastblink_on_R_G_B(uint8_t r_g_b, uint8_t pwm_rgb, uint16_t on_off_ms)
 
 
@@ -596,3 +617,46 @@ static void lp5814_stop_blink_timer(TimerHandle_t xTimer)
 		blink_timer_cb_func = NULL; // reset
 	} // if ( blink_timer_cb_func )
 } // static void lp5814_stop_blink_timer(TimerHandle_t xTimer)
+
+
+
+/*============================================================================*/
+/**
+ * @brief Add a register write to a batch, the batch is sent when full
+ */
+/*============================================================================*/
+static void lp5814_batch_write(S_M1_lp5814_Batch *pbatch, uint8_t reg, uint8_t value)
+{
+	S_M1_I2C_Trans_Inf *ptrans;
+
+	if ( pbatch->batch.count==LP5814_BATCH_MAX )
+		lp5814_batch_flush(pbatch);
+
+	ptrans = &pbatch->trans[pbatch->batch.count++];
+	ptrans->dev_id = I2C_DEVICE_LP5814;
+	ptrans->timeout = I2C_WRITE_TIMEOUT;
+	ptrans->trans_type = I2C_TRANS_WRITE_REGISTER;
+	ptrans->reg_address = reg;
+	ptrans->reg_data = value;
+} // static void lp5814_batch_write(S_M1_lp5814_Batch *pbatch, uint8_t reg, uint8_t value)
+
+
+
+/*============================================================================*/
+/**
+ * @brief Send the writes of a batch in one I2C batch and wait for them
+ */
+/*============================================================================*/
+static bool lp5814_batch_flush(S_M1_lp5814_Batch *pbatch)
+{
+	HAL_StatusTypeDef stat;
+
+	if ( !pbatch->batch.count )
+		return true;
+
+	pbatch->batch.trans = pbatch->trans;
+	stat = m1_i2c_hal_batch_run(&pbatch->batch);
+	pbatch->batch.count = 0;
+
+	return (stat==HAL_OK);
+} // static bool lp5814_batch_flush(S_M1_lp5814_Batch *pbatch)
@@ -0,0 +1,161 @@
+/* See COPYING.txt for license details. */
+
+/*
+*
+* m1_mem_pool.c
+*
+* Library for fixed-block memory pools
+*
+* M1 Project
+*
+*/
+
+/*************************** I N C L U D E S **********************************/
+
+#include <stdint.h>
+#include <string.h>
+#include "stm32h5xx_hal.h"
+#include "main.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "m1_mem_pool.h"
+
+/*************************** D E F I N E S ************************************/
+
+//************************** C O N S T A N T **********************************/
+
+//************************** S T R U C T U R E S *******************************
+
+/***************************** V A R I A B L E S ******************************/
+
+/********************* F U N C T I O N   P R O T O T Y P E S ******************/
+
+void m1_mem_pool_init(S_M1_MemPool *ppool, uint8_t *storage, uint16_t block_size, uint16_t n_blocks);
+void *m1_mem_pool_alloc(S_M1_MemPool *ppool);
+void *m1_mem_pool_calloc(S_M1_MemPool *ppool);
+void m1_mem_pool_free(S_M1_MemPool *ppool, void *pblock);
+bool m1_mem_pool_owns(const S_M1_MemPool *ppool, const void *pblock);
+
+/*************** F U N C T I O N   I M P L E M E N T A T I O N ****************/
+
+/******************************************************************************/
+/*
+ * This function initializes a pool on storage declared with M1_MEM_POOL_STORAGE()
+ * and links all blocks into the free list.
+ */
+/******************************************************************************/
+void m1_mem_pool_init(S_M1_MemPool *ppool, uint8_t *storage, uint16_t block_size, uint16_t n_blocks)
+{
+	uint16_t i;
+	uint8_t *pblock;
+
+	assert(ppool != NULL);
+	assert(storage != NULL);
+	assert(n_blocks != 0);
+	assert(((uintptr_t)storage % M1_MEM_POOL_ALIGN)==0);
+
+	ppool->pstorage = storage;
+	ppool->block_size = M1_MEM_POOL_BLOCK_SIZE(block_size);
+	ppool->n_blocks = n_blocks;
+	ppool->n_free = n_blocks;
+	ppool->min_free = n_blocks;
+	ppool->alloc_fails = 0;
+
+	pblock = storage;
+	for (i=0; i<n_blocks - 1; i++)
+	{
+		*(void **)pblock = pblock + ppool->block_size;
+		pblock += ppool->block_size;
+	}
+	*(void **)pblock = NULL;
+	ppool->free_list = storage;
+} // void m1_mem_pool_init(S_M1_MemPool *ppool, uint8_t *storage, uint16_t block_size, uint16_t n_blocks)
+
+
+
+/******************************************************************************/
+/*
+ * This function takes a block from the pool.
+ * It returns NULL if the pool is empty.
+ */
+/******************************************************************************/
+void *m1_mem_pool_alloc(S_M1_MemPool *ppool)
+{
+	void *pblock;
+	UBaseType_t int_status;
+
+	int_status = taskENTER_CRITICAL_FROM_ISR();
+	pblock = ppool->free_list;
+	if ( pblock != NULL )
+	{
+		ppool->free_list = *(void **)pblock;
+		ppool->n_free--;
+		if ( ppool->n_free < ppool->min_free )
+			ppool->min_free = ppool->n_free;
+	} // if ( pblock != NULL )
+	else
+	{
+		ppool->alloc_fails++;
+	}
+	taskEXIT_CRITICAL_FROM_ISR(int_status);
+
+	return pblock;
+} // void *m1_mem_pool_alloc(S_M1_MemPool *ppool)
+
+
+
+/******************************************************************************/
+/*
+ * This function takes a block from the pool and clears it.
+ */
+/******************************************************************************/
+void *m1_mem_pool_calloc(S_M1_MemPool *ppool)
+{
+	void *pblock;
+
+	pblock = m1_mem_pool_alloc(ppool);
+	if ( pblock != NULL )
+		memset(pblock, 0, ppool->block_size);
+
+	return pblock;
+} // void *m1_mem_pool_calloc(S_M1_MemPool *ppool)
+
+
+
+/******************************************************************************/
+/*
+ * This function returns a block to the pool. NULL is ignored, like free().
+ */
+/******************************************************************************/
+void m1_mem_pool_free(S_M1_MemPool *ppool, void *pblock)
+{
+	UBaseType_t int_status;
+
+	if ( pblock == NULL )
+		return;
+
+	assert(m1_mem_pool_owns(ppool, pblock));
+
+	int_status = taskENTER_CRITICAL_FROM_ISR();
+	*(void **)pblock = ppool->free_list;
+	ppool->free_list = pblock;
+	ppool->n_free++;
+	taskEXIT_CRITICAL_FROM_ISR(int_status);
+} // void m1_mem_pool_free(S_M1_MemPool *ppool, void *pblock)
+
+
+
+/******************************************************************************/
+/*
+ * This function checks whether a pointer is the start of a block of the pool.
+ */
+/******************************************************************************/
+bool m1_mem_pool_owns(const S_M1_MemPool *ppool, const void *pblock)
+{
+	const uint8_t *p = (const uint8_t *)pblock;
+
+	if ( p < ppool->pstorage || p >= ppool->pstorage + (uint32_t)ppool->block_size*ppool->n_blocks )
+		return false;
+
+	return ((uint32_t)(p - ppool->pstorage) % ppool->block_size)==0;
+} // bool m1_mem_pool_owns(const S_M1_MemPool *ppool, const void *pblock)
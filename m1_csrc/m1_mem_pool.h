@@ -0,0 +1,49 @@
+/* See COPYING.txt for license details. */
+
+/*
+*
+* m1_mem_pool.h
+*
+* Header for fixed-block memory pools
+*
+* A pool hands out blocks of one size from a statically allocated array, so
+* the memory used by frequent small allocations is fixed at link time and can
+* not fragment the heap. Alloc and free are O(1) and may be called from tasks
+* and from interrupts.
+*
+* M1 Project
+*
+*/
+
+#ifndef M1_MEM_POOL_H_
+#define M1_MEM_POOL_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#define M1_MEM_POOL_ALIGN					sizeof(void *)
+#define M1_MEM_POOL_BLOCK_SIZE(size)		((((size) + M1_MEM_POOL_ALIGN - 1)/M1_MEM_POOL_ALIGN)*M1_MEM_POOL_ALIGN)
+
+// Declares the storage of a pool of n_blocks blocks of block_size bytes
+#define M1_MEM_POOL_STORAGE(name, block_size, n_blocks) \
+	static uint8_t name[M1_MEM_POOL_BLOCK_SIZE(block_size)*(n_blocks)] __attribute__((aligned(sizeof(void *))))
+
+typedef struct
+{
+	uint8_t *pstorage; // Start of the block array
+	void *free_list; // First free block, each free block holds the address of the next one
+	uint16_t block_size; // Bytes per block, rounded up to M1_MEM_POOL_ALIGN
+	uint16_t n_blocks; // Number of blocks in the pool
+	uint16_t n_free; // Blocks currently free
+	uint16_t min_free; // Low water mark of n_free
+	uint32_t alloc_fails; // Allocations refused because the pool was empty
+} S_M1_MemPool;
+
+void m1_mem_pool_init(S_M1_MemPool *ppool, uint8_t *storage, uint16_t block_size, uint16_t n_blocks);
+void *m1_mem_pool_alloc(S_M1_MemPool *ppool);
+void *m1_mem_pool_calloc(S_M1_MemPool *ppool);
+void m1_mem_pool_free(S_M1_MemPool *ppool, void *pblock);
+bool m1_mem_pool_owns(const S_M1_MemPool *ppool, const void *pblock);
+
+#endif /* M1_MEM_POOL_H_ */
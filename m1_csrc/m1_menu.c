@@ -218,6 +218,9 @@ S_M1_Menu_t menu_Setting_Storage_Unmount = {
 S_M1_Menu_t menu_Setting_Storage_Format = {
     "Format SD Card", storage_format, NULL, NULL, 0, 0, NULL, NULL, {NULL}};
 
+S_M1_Menu_t menu_Setting_Storage_Search = {
+    "Search Signals", storage_search, NULL, NULL, 0, 0, NULL, NULL, {NULL}};
+
 /*------------------------- > Settings-Storage-End ---------------------------*/
 
 /*------------------------- > Settings-Power ---------------------------------*/
@@ -293,13 +296,13 @@ S_M1_Menu_t menu_Settings_Storage = {
     menu_setting_storage_init,
     NULL,
     NULL,
-    5,
+    6,
     0,
     NULL,
     NULL,
     {&menu_Setting_Storage_About, &menu_Setting_Storage_Explore,
-     &menu_Setting_Storage_Mount, &menu_Setting_Storage_Unmount,
-     &menu_Setting_Storage_Format}};
+     &menu_Setting_Storage_Search, &menu_Setting_Storage_Mount,
+     &menu_Setting_Storage_Unmount, &menu_Setting_Storage_Format}};
 
 S_M1_Menu_t menu_Settings_Power = {"Power",
                                    menu_setting_power_init,
@@ -366,15 +369,18 @@ S_M1_Menu_t menu_Wifi_Config = {"Config", wifi_config, NULL, NULL, 0,
 S_M1_Menu_t menu_Wifi_Scan_AP = {"Scan AP", wifi_scan_ap, NULL, NULL, 0,
                                  0,         menu_m1_icon_wifi,         NULL, {NULL}};
 
+S_M1_Menu_t menu_Wifi_Monitor = {"Monitor", wifi_monitor, NULL, NULL, 0,
+                                 0,         menu_m1_icon_wifi,         NULL, {NULL}};
+
 S_M1_Menu_t menu_Wifi = {"Wifi",
                          menu_wifi_init,
                          NULL,
                          NULL,
-                         2,
+                         3,
                          0,
                          menu_m1_icon_wifi,
                          NULL,
-                         {&menu_Wifi_Config, &menu_Wifi_Scan_AP}};
+                         {&menu_Wifi_Config, &menu_Wifi_Scan_AP, &menu_Wifi_Monitor}};
 
 /*--------------------------------- > Wifi -----------------------------------*/
 S_M1_Menu_t menu_Bluetooth_Config = {
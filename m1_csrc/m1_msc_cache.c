@@ -0,0 +1,293 @@
+/* See COPYING.txt for license details. */
+
+/*
+*
+* m1_msc_cache.c
+*
+* USB mass storage sector cache
+*
+* M1 Project
+*
+*/
+
+/*************************** I N C L U D E S **********************************/
+
+#include <stdint.h>
+#include <string.h>
+#include "m1_msc_cache.h"
+
+/*************************** D E F I N E S ************************************/
+
+//************************** C O N S T A N T **********************************/
+
+//************************** S T R U C T U R E S *******************************
+
+/***************************** V A R I A B L E S ******************************/
+
+// 32-byte aligned for the SDMMC internal DMA
+static uint8_t msc_cache_ra_buf[MSC_CACHE_RA_BLOCKS*MSC_CACHE_BLOCK_SIZE] __attribute__((aligned(32)));
+static uint8_t msc_cache_wb_buf[MSC_CACHE_WB_BLOCKS*MSC_CACHE_BLOCK_SIZE] __attribute__((aligned(32)));
+static uint32_t msc_cache_ra_start;
+static uint16_t msc_cache_ra_count; // 0: window empty
+static uint32_t msc_cache_wb_start;
+static uint16_t msc_cache_wb_count; // 0: nothing to write back
+static uint32_t msc_cache_next_read; // Block after the last host read
+static uint32_t msc_cache_capacity; // 0: unknown
+static m1_msc_cache_io_fn msc_cache_sd_read;
+static m1_msc_cache_io_fn msc_cache_sd_write;
+static S_M1_MscCache_Stats msc_cache_stats;
+
+/********************* F U N C T I O N   P R O T O T Y P E S ******************/
+
+void m1_msc_cache_init(m1_msc_cache_io_fn read, m1_msc_cache_io_fn write);
+void m1_msc_cache_set_capacity(uint32_t block_num);
+int8_t m1_msc_cache_read(uint8_t *buf, uint32_t blk_addr, uint16_t blk_len);
+int8_t m1_msc_cache_write(const uint8_t *buf, uint32_t blk_addr, uint16_t blk_len);
+int8_t m1_msc_cache_flush(void);
+void m1_msc_cache_invalidate(void);
+bool m1_msc_cache_dirty(void);
+void m1_msc_cache_get_stats(S_M1_MscCache_Stats *pstats);
+static bool msc_cache_overlaps(uint32_t start, uint16_t count, uint32_t blk_addr, uint16_t blk_len);
+static int8_t msc_cache_fill(uint32_t blk_addr, uint16_t blk_len);
+
+/*************** F U N C T I O N   I M P L E M E N T A T I O N ****************/
+
+/*============================================================================*/
+/*
+ * This function sets the card transfer functions and empties the cache.
+ */
+/*============================================================================*/
+void m1_msc_cache_init(m1_msc_cache_io_fn read, m1_msc_cache_io_fn write)
+{
+	msc_cache_sd_read = read;
+	msc_cache_sd_write = write;
+	msc_cache_capacity = 0;
+	memset(&msc_cache_stats, 0, sizeof(msc_cache_stats));
+	m1_msc_cache_invalidate();
+} // void m1_msc_cache_init(m1_msc_cache_io_fn read, m1_msc_cache_io_fn write)
+
+
+
+/*============================================================================*/
+/*
+ * This function sets the number of blocks of the card. The read-ahead stops
+ * at the last block. A different card empties the cache.
+ */
+/*============================================================================*/
+void m1_msc_cache_set_capacity(uint32_t block_num)
+{
+	if ( block_num!=msc_cache_capacity )
+	{
+		m1_msc_cache_invalidate();
+		msc_cache_capacity = block_num;
+	}
+} // void m1_msc_cache_set_capacity(uint32_t block_num)
+
+
+
+/*============================================================================*/
+/*
+ * This function reads blocks for the host. Blocks in the read-ahead window
+ * are copied, otherwise the window is filled starting at blk_addr. Transfers
+ * as large as the window bypass it.
+ */
+/*============================================================================*/
+int8_t m1_msc_cache_read(uint8_t *buf, uint32_t blk_addr, uint16_t blk_len)
+{
+	int8_t ret;
+
+	if ( blk_len==0 )
+		return 0;
+
+	msc_cache_stats.reads += blk_len;
+
+	// The card must hold what the host wrote before it is read back
+	if ( msc_cache_overlaps(msc_cache_wb_start, msc_cache_wb_count, blk_addr, blk_len) )
+	{
+		if ( m1_msc_cache_flush()!=0 )
+			return -1;
+	}
+
+	if ( msc_cache_ra_count && blk_addr>=msc_cache_ra_start &&
+		(blk_addr + blk_len)<=(msc_cache_ra_start + msc_cache_ra_count) )
+	{
+		memcpy(buf, &msc_cache_ra_buf[(blk_addr - msc_cache_ra_start)*MSC_CACHE_BLOCK_SIZE],
+				(uint32_t)blk_len*MSC_CACHE_BLOCK_SIZE);
+		msc_cache_stats.read_hits += blk_len;
+		msc_cache_next_read = blk_addr + blk_len;
+		return 0;
+	}
+
+	if ( blk_len < MSC_CACHE_RA_BLOCKS && msc_cache_fill(blk_addr, blk_len)==0 )
+	{
+		memcpy(buf, msc_cache_ra_buf, (uint32_t)blk_len*MSC_CACHE_BLOCK_SIZE);
+		msc_cache_next_read = blk_addr + blk_len;
+		return 0;
+	}
+
+	// Large transfer, or the read-ahead ran into a bad area
+	msc_cache_stats.sd_reads++;
+	ret = msc_cache_sd_read(buf, blk_addr, blk_len);
+	if ( ret!=0 )
+		msc_cache_stats.errors++;
+	msc_cache_next_read = blk_addr + blk_len;
+
+	return ret;
+} // int8_t m1_msc_cache_read(uint8_t *buf, uint32_t blk_addr, uint16_t blk_len)
+
+
+
+/*============================================================================*/
+/*
+ * This function takes blocks written by the host. Writes that continue the
+ * write-back run or fall inside it are collected, any other write sends the
+ * run to the card first. It returns -1 if a card transfer failed.
+ */
+/*============================================================================*/
+int8_t m1_msc_cache_write(const uint8_t *buf, uint32_t blk_addr, uint16_t blk_len)
+{
+	uint32_t run_end;
+	int8_t ret;
+
+	if ( blk_len==0 )
+		return 0;
+
+	msc_cache_stats.writes += blk_len;
+
+	// The window would return old data
+	if ( msc_cache_overlaps(msc_cache_ra_start, msc_cache_ra_count, blk_addr, blk_len) )
+		msc_cache_ra_count = 0;
+
+	run_end = msc_cache_wb_start + msc_cache_wb_count;
+	if ( msc_cache_wb_count && blk_addr>=msc_cache_wb_start && blk_addr<=run_end &&
+		(blk_addr + blk_len)<=(msc_cache_wb_start + MSC_CACHE_WB_BLOCKS) )
+	{
+		// Continues the run or rewrites part of it, e.g. a FAT sector
+		memcpy(&msc_cache_wb_buf[(blk_addr - msc_cache_wb_start)*MSC_CACHE_BLOCK_SIZE], buf,
+				(uint32_t)blk_len*MSC_CACHE_BLOCK_SIZE);
+		if ( (blk_addr + blk_len) > run_end )
+			msc_cache_wb_count = (uint16_t)(blk_addr + blk_len - msc_cache_wb_start);
+	}
+	else
+	{
+		if ( m1_msc_cache_flush()!=0 )
+			return -1;
+
+		if ( blk_len >= MSC_CACHE_WB_BLOCKS )
+		{
+			msc_cache_stats.sd_writes++;
+			ret = msc_cache_sd_write((uint8_t *)buf, blk_addr, blk_len);
+			if ( ret!=0 )
+				msc_cache_stats.errors++;
+			return ret;
+		}
+
+		memcpy(msc_cache_wb_buf, buf, (uint32_t)blk_len*MSC_CACHE_BLOCK_SIZE);
+		msc_cache_wb_start = blk_addr;
+		msc_cache_wb_count = blk_len;
+	}
+
+	if ( msc_cache_wb_count==MSC_CACHE_WB_BLOCKS )
+		return m1_msc_cache_flush();
+
+	return 0;
+} // int8_t m1_msc_cache_write(const uint8_t *buf, uint32_t blk_addr, uint16_t blk_len)
+
+
+
+/*============================================================================*/
+/*
+ * This function writes the write-back run to the card. The run is kept if
+ * the card refused it, it returns -1 then.
+ */
+/*============================================================================*/
+int8_t m1_msc_cache_flush(void)
+{
+	if ( msc_cache_wb_count==0 )
+		return 0;
+
+	msc_cache_stats.sd_writes++;
+	if ( msc_cache_sd_write(msc_cache_wb_buf, msc_cache_wb_start, msc_cache_wb_count)!=0 )
+	{
+		msc_cache_stats.errors++;
+		return -1;
+	}
+	msc_cache_wb_count = 0;
+
+	return 0;
+} // int8_t m1_msc_cache_flush(void)
+
+
+
+/*============================================================================*/
+/*
+ * This function empties the cache without writing anything, e.g. after the
+ * card was removed or changed by the firmware.
+ */
+/*============================================================================*/
+void m1_msc_cache_invalidate(void)
+{
+	msc_cache_ra_count = 0;
+	msc_cache_wb_count = 0;
+	msc_cache_next_read = UINT32_MAX;
+} // void m1_msc_cache_invalidate(void)
+
+
+
+bool m1_msc_cache_dirty(void)
+{
+	return msc_cache_wb_count!=0;
+} // bool m1_msc_cache_dirty(void)
+
+
+
+void m1_msc_cache_get_stats(S_M1_MscCache_Stats *pstats)
+{
+	*pstats = msc_cache_stats;
+} // void m1_msc_cache_get_stats(S_M1_MscCache_Stats *pstats)
+
+
+
+static bool msc_cache_overlaps(uint32_t start, uint16_t count, uint32_t blk_addr, uint16_t blk_len)
+{
+	return count && blk_addr < (start + count) && start < (blk_addr + blk_len);
+} // static bool msc_cache_overlaps(uint32_t start, uint16_t count, uint32_t blk_addr, uint16_t blk_len)
+
+
+
+/*============================================================================*/
+/*
+ * This function reads the read-ahead window starting at blk_addr. A read
+ * that continues the previous one fills the whole window, the first read of
+ * a transfer only MSC_CACHE_RA_MIN_BLOCKS, so scattered reads of directory
+ * and FAT sectors stay short.
+ */
+/*============================================================================*/
+static int8_t msc_cache_fill(uint32_t blk_addr, uint16_t blk_len)
+{
+	uint32_t count;
+
+	count = (blk_addr==msc_cache_next_read) ? MSC_CACHE_RA_BLOCKS : MSC_CACHE_RA_MIN_BLOCKS;
+	if ( count < blk_len )
+		count = blk_len;
+	if ( msc_cache_capacity && (blk_addr + count) > msc_cache_capacity )
+		count = (msc_cache_capacity > blk_addr) ? (msc_cache_capacity - blk_addr) : blk_len;
+	if ( count < blk_len )
+		count = blk_len;
+
+	// Blocks still waiting to be written must not be read from the card
+	if ( msc_cache_wb_count && msc_cache_wb_start >= blk_addr && msc_cache_wb_start < (blk_addr + count) )
+		count = msc_cache_wb_start - blk_addr;
+
+	msc_cache_ra_count = 0;
+	msc_cache_stats.sd_reads++;
+	if ( msc_cache_sd_read(msc_cache_ra_buf, blk_addr, (uint16_t)count)!=0 )
+	{
+		msc_cache_stats.errors++;
+		return -1;
+	}
+	msc_cache_ra_start = blk_addr;
+	msc_cache_ra_count = (uint16_t)count;
+
+	return 0;
+} // static int8_t msc_cache_fill(uint32_t blk_addr, uint16_t blk_len)
@@ -0,0 +1,63 @@
+/* See COPYING.txt for license details. */
+
+/*
+*
+* m1_msc_cache.h
+*
+* Header for the USB mass storage sector cache
+*
+* The MSC class hands the storage layer one MSC_MEDIA_PACKET (512 bytes) at a
+* time, so every host transfer would become single-block SD commands. The
+* cache sits between the storage callbacks and the SD card:
+* - reads fill a read-ahead window with one multi-block read, the following
+*   blocks of a sequential transfer are copied from it
+* - writes to consecutive blocks are collected in a write-back run and go to
+*   the card in one multi-block write when the run is full, when a write does
+*   not continue it, before a read of its blocks and on m1_msc_cache_flush()
+*
+* Written blocks reach the card late, m1_msc_cache_flush() must be called on
+* SYNCHRONIZE CACHE, eject, USB suspend and before the firmware mounts the
+* card again.
+*
+* M1 Project
+*
+*/
+
+#ifndef M1_MSC_CACHE_H_
+#define M1_MSC_CACHE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define MSC_CACHE_BLOCK_SIZE		512
+#define MSC_CACHE_RA_BLOCKS			32		// Read-ahead window, 16 KB
+#define MSC_CACHE_RA_MIN_BLOCKS		8		// Read-ahead of the first block of a transfer
+#define MSC_CACHE_WB_BLOCKS			32		// Write-back run, 16 KB
+
+typedef struct
+{
+	uint32_t reads; // Blocks read by the host
+	uint32_t read_hits; // of these, copied from the read-ahead window
+	uint32_t writes; // Blocks written by the host
+	uint32_t sd_reads; // Multi-block reads sent to the card
+	uint32_t sd_writes; // Multi-block writes sent to the card
+	uint32_t errors; // Failed card transfers
+} S_M1_MscCache_Stats;
+
+// Transfers blk_len blocks between buf and the card, returns 0 on success
+typedef int8_t (*m1_msc_cache_io_fn)(uint8_t *buf, uint32_t blk_addr, uint16_t blk_len);
+
+/*
+ * All functions except m1_msc_cache_get_stats() are called from the USB
+ * interrupt, or from a task with the USB interrupt disabled.
+ */
+void m1_msc_cache_init(m1_msc_cache_io_fn read, m1_msc_cache_io_fn write);
+void m1_msc_cache_set_capacity(uint32_t block_num);
+int8_t m1_msc_cache_read(uint8_t *buf, uint32_t blk_addr, uint16_t blk_len);
+int8_t m1_msc_cache_write(const uint8_t *buf, uint32_t blk_addr, uint16_t blk_len);
+int8_t m1_msc_cache_flush(void);
+void m1_msc_cache_invalidate(void);
+bool m1_msc_cache_dirty(void);
+void m1_msc_cache_get_stats(S_M1_MscCache_Stats *pstats);
+
+#endif /* M1_MSC_CACHE_H_ */
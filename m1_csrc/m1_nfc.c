@@ -19,8 +19,10 @@
 #include "legacy/nfc_poller.h"
 #include "common/nfc_storage.h"
 #include "common/nfc_ctx.h"
+#include "common/nfc_dump_bin.h"
 #include "m1_file_browser.h"
 #include "m1_file_util.h"
+#include "m1_signal_index.h"
 #include "privateprofilestring.h"
 #include "common/nfc_file.h"
 #include "Res_String.h"
@@ -104,7 +106,9 @@ typedef enum {
 static uint16_t s_page_scroll = 0;
 static uint16_t s_info_mode   = 0;
 static bool s_edit_uid_started = false;  // Edit UID 시작 플래그
+static bool s_emulate_started = false;   // Listener started by nfc_emulate_gui_create
 static uint8_t m1_nfc_uiview_gui_latest_param;
+static uint8_t s_tag_sel = 0;             // Card of the last discovery round shown on the read screen
 static S_M1_NFC_Record_t m1_nfc_record_stat;
 //static FIL nfc_file;
 //static DIR nfc_dir;
@@ -348,6 +352,7 @@ void m1_nfc_read(void)
  * - BACK: Exit to idle view
  * - LEFT: Retry reading (restart read process)
  * - RIGHT: Switch to submenu view
+ * - UP/DOWN: Step through the cards resolved in the same discovery round
  * 
  * @retval 0 Exit requested (BACK button)
  * @retval 1 Continue processing
@@ -386,6 +391,20 @@ static int m1_nfc_read_kp_handler(void)
 				m1_nfc_uiview_gui_latest_param = X_MENU_UPDATE_RESET; // Update latest param
 			} // if ( m1_nfc_uiview_gui_latest_param==NFC_READ_DISPLAY_PARAM_READING_COMPLETE )
 		} // else if(this_button_status.event[BUTTON_RIGHT_KP_ID]==BUTTON_EVENT_CLICK )
+		else if ( this_button_status.event[BUTTON_UP_KP_ID]==BUTTON_EVENT_CLICK
+				|| this_button_status.event[BUTTON_DOWN_KP_ID]==BUTTON_EVENT_CLICK )	// other cards
+		{
+			uint8_t tag_cnt = nfc_poller_get_tags(NULL);
+
+			if ( m1_nfc_uiview_gui_latest_param==NFC_READ_DISPLAY_PARAM_READING_COMPLETE && tag_cnt > 1 )
+			{
+				if ( this_button_status.event[BUTTON_UP_KP_ID]==BUTTON_EVENT_CLICK )
+					s_tag_sel = s_tag_sel ? s_tag_sel - 1 : tag_cnt - 1;
+				else
+					s_tag_sel = (s_tag_sel + 1 < tag_cnt) ? s_tag_sel + 1 : 0;
+				m1_uiView_display_update(NFC_READ_DISPLAY_PARAM_READING_COMPLETE);
+			} // if ( m1_nfc_uiview_gui_latest_param==NFC_READ_DISPLAY_PARAM_READING_COMPLETE && tag_cnt > 1 )
+		} // else if ( this_button_status.event[BUTTON_UP_KP_ID]==BUTTON_EVENT_CLICK ... )
 	}
 
 	return 1;
@@ -410,6 +429,7 @@ static void m1_nfc_read_gui_create(uint8_t param)
 	if( param==NFC_READ_DISPLAY_PARAM_READING_READY )
 	{
 		m1_nfc_record_stat = NFC_RECORD_IDLE;
+		s_tag_sel = 0;
 		m1_led_fast_blink(LED_BLINK_ON_RGB, LED_FASTBLINK_PWM_M, LED_FASTBLINK_ONTIME_M);
 		m1_app_send_q_message(nfc_worker_q_hdl, Q_EVENT_NFC_START_READ);
 		vTaskDelay(50);
@@ -480,6 +500,20 @@ static void m1_nfc_read_gui_update(uint8_t param)
 		u8g2_DrawStr(&m1_u8g2, 2, 32, "UID:");
 		u8g2_DrawStr(&m1_u8g2, 25, 32, NFC_UID);
 
+		// Every card resolved in the same discovery round, UP/DOWN steps through them
+		const nfc_poll_tag_t *tags;
+		uint8_t tag_cnt = nfc_poller_get_tags(&tags);
+		if ( tag_cnt > 1 )
+		{
+			char card[32];
+			if ( s_tag_sel >= tag_cnt )
+				s_tag_sel = 0;
+			// "n/N UID", the technology does not fit next to a 7 byte UID
+			snprintf(card, sizeof(card), "%u/%u %s", s_tag_sel + 1, tag_cnt,
+					hex2Str((unsigned char *)tags[s_tag_sel].uid, tags[s_tag_sel].uid_len > 7 ? 7 : tags[s_tag_sel].uid_len));
+			u8g2_DrawStr(&m1_u8g2, 2, 42, card);
+		}
+
 		u8g2_SetDrawColor(&m1_u8g2, M1_DISP_DRAW_COLOR_TXT);
 		u8g2_DrawBox(&m1_u8g2, 0, 52, 128, 12); // Draw an inverted bar at the bottom to display options
 		u8g2_SetDrawColor(&m1_u8g2, M1_DISP_DRAW_COLOR_BG); // Write text in inverted color
@@ -987,11 +1021,22 @@ static int nfc_emulate_kp_handler(void)
 /*============================================================================*/
 static void nfc_emulate_gui_create(uint8_t param)
 {
+	nfc_run_ctx_t* c = nfc_ctx_get();
+
+	/* The ST25R3916 listen mode covers NFC-A only: ISO15693 dumps can be read and saved, not emulated */
+	s_emulate_started = false;
+	if (c && c->head.tech != M1NFC_TECH_A)
+	{
+		m1_uiView_display_update(param);
+		return;
+	}
+
 	if(param==0)
 	{
         nfc_ctx_sync_emu();//Current nfc_ctx.head content reflected in emulator context (g_emuA)
         m1_led_fast_blink(LED_BLINK_ON_RGB, LED_FASTBLINK_PWM_M, LED_FASTBLINK_ONTIME_M);
 		m1_app_send_q_message(nfc_worker_q_hdl, Q_EVENT_NFC_START_EMULATE);
+		s_emulate_started = true;
 		osDelay(50);
 	}
 
@@ -1011,6 +1056,9 @@ static void nfc_emulate_gui_create(uint8_t param)
 static void nfc_emulate_gui_destroy(uint8_t param)
 {
     (void)param; /* Unused: stub for future work. May need removal later. */
+	if (!s_emulate_started)
+		return;
+	s_emulate_started = false;
 	m1_led_fast_blink(LED_BLINK_ON_RGB, LED_FASTBLINK_PWM_OFF, LED_FASTBLINK_ONTIME_OFF);
 	m1_app_send_q_message(nfc_worker_q_hdl, Q_EVENT_NFC_EMULATE_STOP);
 }
@@ -1035,6 +1083,20 @@ static void nfc_emulate_gui_update(uint8_t param)
     {
 		nfc_run_ctx_t* c = nfc_ctx_get();
 		const char* emu_text = "Emulate UID";  // 기본값: UID만 에뮬레이션
+
+		if (c && c->head.tech != M1NFC_TECH_A)
+		{
+			u8g2_FirstPage(&m1_u8g2);
+			u8g2_SetDrawColor(&m1_u8g2, M1_DISP_DRAW_COLOR_TXT);
+			u8g2_DrawXBMP(&m1_u8g2, 0, 0, 48, 48, nfc_emit_48x48);
+			u8g2_SetFont(&m1_u8g2, M1_DISP_RUN_MENU_FONT_B);
+			u8g2_DrawStr(&m1_u8g2, 50, 20, (c->head.tech == M1NFC_TECH_V) ? "ISO15693" : "Emulate");
+			u8g2_SetFont(&m1_u8g2, M1_DISP_FUNC_MENU_FONT_N);
+			u8g2_DrawStr(&m1_u8g2, 50, 30, "Emulation not");
+			u8g2_DrawStr(&m1_u8g2, 50, 40, "supported");
+			u8g2_NextPage(&m1_u8g2);
+			return;
+		}
 		
 		// T2T (Ultralight/NTAG) + Page dump 데이터가 있는 경우
 		if (c && 
@@ -2076,6 +2138,11 @@ static uint8_t m1_nfc_read_more_options_delete(void)
 						// Confirm delete
 						uint8_t delete_ret = m1_fb_delete_file(c->file.path);
 						if (delete_ret==0) {
+							// Drop the binary sidecar as well (may not exist)
+							char bin_path[NFC_PATH_MAX];
+							if (nfc_dump_bin_sidecar_path(c->file.path, bin_path, sizeof(bin_path)))
+								f_unlink(bin_path);
+
 							// Show success message
 							u8g2_FirstPage(&m1_u8g2);
 							u8g2_SetDrawColor(&m1_u8g2, M1_DISP_DRAW_COLOR_TXT);
@@ -2254,6 +2321,14 @@ static void nfc_rename_gui_update(uint8_t param)
 	FRESULT res = f_rename(old_file, new_file);
 	if (res==FR_OK) {
 		pBitmap = nfc_saved_63_63;
+		m1_sig_idx_rename(old_file, new_file);
+		// Move the binary sidecar along (FatFs keeps the timestamp, so it stays current)
+		char old_bin[128], new_bin[128];
+		if (nfc_dump_bin_sidecar_path(old_file, old_bin, sizeof(old_bin)) &&
+			nfc_dump_bin_sidecar_path(new_file, new_bin, sizeof(new_bin)))
+		{
+			f_rename(old_bin, new_bin);
+		}
 		// Update context with new path
 		strncpy(c->file.path, new_file, sizeof(c->file.path) - 1);
 		c->file.path[sizeof(c->file.path) - 1] = '\0';
@@ -0,0 +1,239 @@
+/* See COPYING.txt for license details. */
+
+/*
+*
+* m1_power_profile.c
+*
+* Idle sleep and power profiler
+*
+* M1 Project
+*
+*/
+
+/*************************** I N C L U D E S **********************************/
+
+#include <stdint.h>
+#include <string.h>
+#include "m1_power_profile.h"
+
+/*************************** D E F I N E S ************************************/
+
+//************************** C O N S T A N T **********************************/
+
+static const uint32_t pwr_prof_idle_limits[PWR_PROF_IDLE_BUCKETS - 1] = {10, 100, 1000};
+
+//************************** S T R U C T U R E S *******************************
+
+/***************************** V A R I A B L E S ******************************/
+
+static S_M1_PwrProf_Snapshot pwr_prof;
+static uint32_t pwr_prof_last_now;
+static uint32_t pwr_prof_sleep_start;
+// Totals at the previous gauge reading
+static uint64_t pwr_prof_sample_total;
+static uint64_t pwr_prof_sample_sleep;
+// Sums of the least squares fit of current over sleep share
+static double pwr_prof_sum_s, pwr_prof_sum_ss, pwr_prof_sum_i, pwr_prof_sum_si;
+
+/********************* F U N C T I O N   P R O T O T Y P E S ******************/
+
+void m1_power_profile_reset(uint32_t time_base_hz, uint32_t now);
+void m1_power_profile_sleep_enter(uint32_t now, uint32_t expected_idle_ticks);
+void m1_power_profile_sleep_exit(uint32_t now, int16_t wake_irqn);
+void m1_power_profile_sleep_abort(void);
+void m1_power_profile_add_current(uint32_t now, int16_t avg_current_mA);
+void m1_power_profile_get(uint32_t now, S_M1_PwrProf_Snapshot *psnap);
+uint32_t m1_power_profile_source_delta(const S_M1_PwrProf_Snapshot *pprev, const S_M1_PwrProf_Source *psource);
+static void pwr_prof_advance(uint32_t now);
+static void pwr_prof_count_source(int16_t irqn);
+static void pwr_prof_fit(void);
+
+/*************** F U N C T I O N   I M P L E M E N T A T I O N ****************/
+
+/*============================================================================*/
+/*
+ * This function clears the profile. now is a count of the time base.
+ */
+/*============================================================================*/
+void m1_power_profile_reset(uint32_t time_base_hz, uint32_t now)
+{
+	memset(&pwr_prof, 0, sizeof(pwr_prof));
+	pwr_prof.time_base_hz = time_base_hz;
+	pwr_prof_last_now = now;
+	pwr_prof_sleep_start = now;
+	pwr_prof_sample_total = 0;
+	pwr_prof_sample_sleep = 0;
+	pwr_prof_sum_s = 0;
+	pwr_prof_sum_ss = 0;
+	pwr_prof_sum_i = 0;
+	pwr_prof_sum_si = 0;
+} // void m1_power_profile_reset(uint32_t time_base_hz, uint32_t now)
+
+
+
+/*============================================================================*/
+/*
+ * This function is called right before the WFI with the idle time the kernel
+ * expects, in ticks.
+ */
+/*============================================================================*/
+void m1_power_profile_sleep_enter(uint32_t now, uint32_t expected_idle_ticks)
+{
+	uint8_t bucket = 0;
+
+	pwr_prof_advance(now);
+	pwr_prof_sleep_start = now;
+
+	while ( bucket < PWR_PROF_IDLE_BUCKETS - 1 && expected_idle_ticks >= pwr_prof_idle_limits[bucket] )
+		bucket++;
+	pwr_prof.idle_windows[bucket]++;
+} // void m1_power_profile_sleep_enter(uint32_t now, uint32_t expected_idle_ticks)
+
+
+
+/*============================================================================*/
+/*
+ * This function is called after the wake-up with the pending interrupt that
+ * ended the sleep.
+ */
+/*============================================================================*/
+void m1_power_profile_sleep_exit(uint32_t now, int16_t wake_irqn)
+{
+	pwr_prof.sleep_time += now - pwr_prof_sleep_start;
+	pwr_prof.sleeps++;
+	pwr_prof_advance(now);
+	pwr_prof_count_source(wake_irqn);
+} // void m1_power_profile_sleep_exit(uint32_t now, int16_t wake_irqn)
+
+
+
+void m1_power_profile_sleep_abort(void)
+{
+	pwr_prof.aborts++;
+} // void m1_power_profile_sleep_abort(void)
+
+
+
+/*============================================================================*/
+/*
+ * This function takes a gauge reading, negative while discharging. The
+ * current is paired with the share of time asleep since the previous
+ * reading. Readings while charging only start a new interval.
+ */
+/*============================================================================*/
+void m1_power_profile_add_current(uint32_t now, int16_t avg_current_mA)
+{
+	uint64_t total, sleep;
+	double s, i;
+
+	pwr_prof_advance(now);
+	total = pwr_prof.total_time - pwr_prof_sample_total;
+	sleep = pwr_prof.sleep_time - pwr_prof_sample_sleep;
+	pwr_prof_sample_total = pwr_prof.total_time;
+	pwr_prof_sample_sleep = pwr_prof.sleep_time;
+
+	if ( avg_current_mA >= 0 || total==0 )
+		return;
+
+	s = (double)sleep/(double)total;
+	i = -(double)avg_current_mA;
+	pwr_prof.current_samples++;
+	pwr_prof.last_current_mA = (int16_t)-avg_current_mA;
+	pwr_prof.last_sleep_permille = (uint16_t)(s*1000 + 0.5);
+	pwr_prof_sum_s += s;
+	pwr_prof_sum_ss += s*s;
+	pwr_prof_sum_i += i;
+	pwr_prof_sum_si += s*i;
+	pwr_prof_fit();
+} // void m1_power_profile_add_current(uint32_t now, int16_t avg_current_mA)
+
+
+
+void m1_power_profile_get(uint32_t now, S_M1_PwrProf_Snapshot *psnap)
+{
+	pwr_prof_advance(now);
+	*psnap = pwr_prof;
+} // void m1_power_profile_get(uint32_t now, S_M1_PwrProf_Snapshot *psnap)
+
+
+
+/*============================================================================*/
+/*
+ * This function returns the wake-ups of a source since the earlier snapshot.
+ */
+/*============================================================================*/
+uint32_t m1_power_profile_source_delta(const S_M1_PwrProf_Snapshot *pprev, const S_M1_PwrProf_Source *psource)
+{
+	uint8_t i;
+
+	for ( i = 0; i < pprev->n_sources; i++ )
+	{
+		if ( pprev->sources[i].irqn==psource->irqn )
+			return psource->count - pprev->sources[i].count;
+	}
+
+	return psource->count;
+} // uint32_t m1_power_profile_source_delta(...)
+
+
+
+// The time base is 32 bits and wraps, the totals are kept in 64 bits
+static void pwr_prof_advance(uint32_t now)
+{
+	pwr_prof.total_time += now - pwr_prof_last_now;
+	pwr_prof_last_now = now;
+} // static void pwr_prof_advance(uint32_t now)
+
+
+
+static void pwr_prof_count_source(int16_t irqn)
+{
+	uint8_t i;
+
+	for ( i = 0; i < pwr_prof.n_sources; i++ )
+	{
+		if ( pwr_prof.sources[i].irqn==irqn )
+		{
+			pwr_prof.sources[i].count++;
+			return;
+		}
+	}
+	if ( pwr_prof.n_sources < PWR_PROF_MAX_SOURCES )
+	{
+		pwr_prof.sources[pwr_prof.n_sources].irqn = irqn;
+		pwr_prof.sources[pwr_prof.n_sources].count = 1;
+		pwr_prof.n_sources++;
+	}
+	else
+	{
+		pwr_prof.wake_other++;
+	}
+} // static void pwr_prof_count_source(int16_t irqn)
+
+
+
+/*============================================================================*/
+/*
+ * This function fits current = awake + (sleep - awake) x sleep share. The
+ * readings need some spread of the sleep share, a unit that always sleeps
+ * the same has no usable fit.
+ */
+/*============================================================================*/
+static void pwr_prof_fit(void)
+{
+	double n = pwr_prof.current_samples;
+	double var, slope;
+
+	pwr_prof.model_valid = false;
+	if ( pwr_prof.current_samples < 2 )
+		return;
+
+	var = pwr_prof_sum_ss/n - (pwr_prof_sum_s/n)*(pwr_prof_sum_s/n);
+	if ( var < PWR_PROF_MIN_SLEEP_SPREAD )
+		return;
+
+	slope = (pwr_prof_sum_si/n - (pwr_prof_sum_s/n)*(pwr_prof_sum_i/n))/var;
+	pwr_prof.awake_mA = (float)(pwr_prof_sum_i/n - slope*pwr_prof_sum_s/n);
+	pwr_prof.sleep_mA = (float)(pwr_prof.awake_mA + slope);
+	pwr_prof.model_valid = true;
+} // static void pwr_prof_fit(void)
@@ -0,0 +1,67 @@
+/* See COPYING.txt for license details. */
+
+/*
+*
+* m1_power_profile.h
+*
+* Header for the idle sleep and power profiler
+*
+* The tickless idle hook reports every sleep: when it started and ended, how
+* long the kernel expected to stay idle and which interrupt woke the MCU.
+* The battery gauge reports its average current, each reading is paired with
+* the share of time asleep since the previous one. A least squares fit of
+* current over sleep share estimates the current drawn awake and asleep.
+*
+* Times are counts of a free-running time base, the caller passes them in
+* and does the locking: the sleep functions run in the idle task with
+* interrupts disabled.
+*
+* M1 Project
+*
+*/
+
+#ifndef M1_POWER_PROFILE_H_
+#define M1_POWER_PROFILE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define PWR_PROF_MAX_SOURCES		16		// Wake-up interrupts counted one by one
+#define PWR_PROF_IDLE_BUCKETS		4		// Expected idle time <10, <100, <1000, >=1000 ticks
+#define PWR_PROF_WAKE_UNKNOWN		INT16_MAX	// No interrupt pending after the wake-up
+#define PWR_PROF_MIN_SLEEP_SPREAD	0.0001	// Variance of the sleep share needed for the fit
+
+typedef struct
+{
+	int16_t irqn; // CMSIS IRQn, SysTick is -1
+	uint32_t count;
+} S_M1_PwrProf_Source;
+
+typedef struct
+{
+	uint32_t time_base_hz;
+	uint64_t total_time; // Since the reset, in time base counts
+	uint64_t sleep_time;
+	uint32_t sleeps;
+	uint32_t aborts; // Sleeps the kernel abandoned before the WFI
+	uint32_t idle_windows[PWR_PROF_IDLE_BUCKETS]; // Sleeps by expected idle time
+	S_M1_PwrProf_Source sources[PWR_PROF_MAX_SOURCES];
+	uint8_t n_sources;
+	uint32_t wake_other; // Wake-ups by interrupts not in sources
+	uint32_t current_samples; // Gauge readings while discharging
+	int16_t last_current_mA; // Last discharge current
+	uint16_t last_sleep_permille; // Time asleep before the last reading
+	bool model_valid;
+	float awake_mA; // Estimated current awake
+	float sleep_mA; // Estimated current asleep
+} S_M1_PwrProf_Snapshot;
+
+void m1_power_profile_reset(uint32_t time_base_hz, uint32_t now);
+void m1_power_profile_sleep_enter(uint32_t now, uint32_t expected_idle_ticks);
+void m1_power_profile_sleep_exit(uint32_t now, int16_t wake_irqn);
+void m1_power_profile_sleep_abort(void);
+void m1_power_profile_add_current(uint32_t now, int16_t avg_current_mA);
+void m1_power_profile_get(uint32_t now, S_M1_PwrProf_Snapshot *psnap);
+uint32_t m1_power_profile_source_delta(const S_M1_PwrProf_Snapshot *pprev, const S_M1_PwrProf_Source *psource);
+
+#endif /* M1_POWER_PROFILE_H_ */
@@ -30,6 +30,7 @@
 #include "lfrfid_file.h"
 #include "privateprofilestring.h"
 #include "m1_file_util.h"
+#include "m1_signal_index.h"
 
 /*************************** D E F I N E S ************************************/
 
@@ -513,9 +514,8 @@ static int lfrfid_read_message(void)
 		} // if ( q_item.q_evt_type==Q_EVENT_KEYPAD )
 		else if ( q_item.q_evt_type==Q_EVENT_LFRFID_TAG_DETECTED )
 		{
-			// Do other things for this task
-			osDelay(100);
-			m1_uiView_display_update(RFID_READ_DISPLAY_PARAM_READING_COMPLETE);
+			// Each decoder that locks on reports the tag, draw them once
+			m1_uiView_display_invalidate(RFID_READ_DISPLAY_PARAM_READING_COMPLETE);
 
 			record_stat = RFID_READ_DONE;
 
@@ -525,6 +525,10 @@ static int lfrfid_read_message(void)
 			//m1_app_send_q_message(lfrfid_q_hdl, Q_EVENT_UI_LFRFID_STOP);
 
 		} // else if ( q_item.q_evt_type==Q_EVENT_LFRFID_TAG_DETECTED )
+		else if ( q_item.q_evt_type==Q_EVENT_UI_REDRAW )
+		{
+			m1_uiView_display_redraw();
+		}
 	} // if (ret==pdTRUE)
 
 	return ret_val;
@@ -1080,13 +1084,17 @@ static int lfrfid_read_write_message(void)
 			// retry
 			memcpy(&lfrfid_tag_info, lfrfid_tag_info_back, sizeof(LFRFID_TAG_INFO));
 			m1_app_send_q_message(lfrfid_q_hdl, Q_EVENT_UI_LFRFID_WRITE);
-			m1_uiView_display_update(0);
+			m1_uiView_display_invalidate(0);
 		}
 		else if(q_item.q_evt_type==Q_EVENT_MENU_TIMEOUT )
 		{
 			//rfid_125khz_saved();
 			m1_uiView_display_switch(VIEW_MODE_LFRFID_READ_SUBMENU, X_MENU_UPDATE_REFRESH);
 		}
+		else if ( q_item.q_evt_type==Q_EVENT_UI_REDRAW )
+		{
+			m1_uiView_display_redraw();
+		}
 	} // if (ret==pdTRUE)
 
 	return ret_val;
@@ -1693,13 +1701,17 @@ static int lfrfid_saved_write_message(void)
 
 			memcpy(&lfrfid_tag_info, lfrfid_tag_info_back, sizeof(LFRFID_TAG_INFO));
 			m1_app_send_q_message(lfrfid_q_hdl, Q_EVENT_UI_LFRFID_WRITE);
-			m1_uiView_display_update(0);
+			m1_uiView_display_invalidate(0);
 		} // else if ( q_item.q_evt_type==Q_EVENT_UI_LFRFID_READ_TIMEOUT )
 		else if(q_item.q_evt_type==Q_EVENT_MENU_TIMEOUT )
 		{
 			//rfid_125khz_saved();
 			m1_uiView_display_switch(VIEW_MODE_LFRFID_SAVED_SUBMENU, X_MENU_UPDATE_REFRESH);
 		}
+		else if ( q_item.q_evt_type==Q_EVENT_UI_REDRAW )
+		{
+			m1_uiView_display_redraw();
+		}
 		
 	} // if (ret==pdTRUE)
 
@@ -1932,6 +1944,7 @@ static void lfrfid_saved_rename_update(uint8_t param)
 			if(f_rename(old_file,new_file)==FR_OK)
 			{
 				pBitmap = nfc_saved_63_63;
+				m1_sig_idx_rename(old_file, new_file);
 				fu_get_directory_path(new_file, lfrfid_tag_info.filepath, sizeof(lfrfid_tag_info.filepath));
 				const char *pbuff = fu_get_filename(new_file);
 				strncpy(lfrfid_tag_info.filename, pbuff, sizeof(lfrfid_tag_info.filename) - 1);
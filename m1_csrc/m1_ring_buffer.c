@@ -27,6 +27,12 @@
 #define GET_MAX_NUM(m, n)					((m) > (n) ? (m) : (n))
 #define IS_BUFFER_VALID(pbuffer)            ((pbuffer!=NULL) && (pbuffer->pdata!=NULL) && (pbuffer->len > 0))
 
+// Orders the data copy against the index update seen by the other side.
+// The writer only stores head and the reader only stores tail, each with a
+// single store after the copy, so one producer and one consumer (task or
+// ISR) need no lock.
+#define RB_INDEX_BARRIER()					__atomic_thread_fence(__ATOMIC_SEQ_CST)
+
 //************************** C O N S T A N T **********************************/
 
 //************************** S T R U C T U R E S *******************************
@@ -38,9 +44,12 @@
 
 void m1_ringbuffer_init(S_M1_RingBuffer *prb_handle, uint8_t *ring_buffer, uint16_t n_elements, uint8_t data_size);
 void m1_ringbuffer_reset(S_M1_RingBuffer *prb_handle);
-uint16_t m1_ringbuffer_write(S_M1_RingBuffer *prb_handle, uint8_t *indata, uint16_t n_slots);
+uint16_t m1_ringbuffer_write(S_M1_RingBuffer *prb_handle, const uint8_t *indata, uint16_t n_slots);
 uint16_t m1_ringbuffer_insert(S_M1_RingBuffer *prb_handle, uint8_t *indata);
 uint16_t m1_ringbuffer_read(S_M1_RingBuffer *prb_handle, uint8_t *outdata, uint16_t n_slots);
+uint16_t m1_ringbuffer_peek(S_M1_RingBuffer *prb_handle, uint8_t *outdata, uint16_t n_slots);
+static uint32_t ringbuffer_copy_in(S_M1_RingBuffer *prb_handle, uint32_t head, const uint8_t *indata, uint32_t n_bytes);
+static uint32_t ringbuffer_copy_out(const S_M1_RingBuffer *prb_handle, uint32_t tail, uint8_t *outdata, uint32_t n_bytes);
 uint8_t m1_ringbuffer_check_empty_state(S_M1_RingBuffer *prb_handle);
 uint32_t ringbuffer_get_empty_slots(S_M1_RingBuffer *prb_handle);
 uint32_t ringbuffer_get_data_slots(S_M1_RingBuffer *prb_handle);
@@ -95,21 +104,9 @@ void m1_ringbuffer_reset(S_M1_RingBuffer *prb_handle)
 /*============================================================================*/
 uint32_t ringbuffer_get_empty_slots(S_M1_RingBuffer *prb_handle)
 {
-    uint32_t n_free, head, tail;
-
-    head = prb_handle->head;
-    tail = prb_handle->tail;
-
-    n_free = prb_handle->end_index; // Default, the buffer is empty
-    if (head > tail)
-    	n_free -= (head - tail);
-    else if (tail > head) // Overflow with head index?
-        n_free = tail - head;
-
-    // Return the number of empty slots minus 1
-    // This is to avoid the case when head and tail have the same index if the buffer is full.
-    // In that case, it will make this function understand that the buffer is empty, instead of being full!
-    return (n_free/prb_handle->data_size - 1);
+	// One slot always stays unused, so that a full buffer does not look
+	// like an empty one (head==tail)
+	return m1_ringbuffer_free_slots(prb_handle);
 } // uint32_t ringbuffer_get_empty_slots(S_M1_RingBuffer *prb_handle)
 
 
@@ -122,40 +119,79 @@ uint32_t ringbuffer_get_empty_slots(S_M1_RingBuffer *prb_handle)
 /*============================================================================*/
 uint32_t ringbuffer_get_data_slots(S_M1_RingBuffer *prb_handle)
 {
-    uint32_t head, tail, n_slots;
-
     if ( !IS_BUFFER_VALID(prb_handle) )
     	return 0;
 
-    head = prb_handle->head;
-    tail = prb_handle->tail;
+    return m1_ringbuffer_used_slots(prb_handle);
+} // static uint32_t ringbuffer_get_data_slots(S_M1_RingBuffer *prb_handle)
 
-    n_slots = 0; // Default, the buffer is fully empty
-    if (head > tail)
-    {
-    	n_slots = head - tail;
-    }
-    else if (tail > head)
-    {
-        n_slots = prb_handle->end_index - (tail - head); // overflow case
-    }
 
-    return n_slots/prb_handle->data_size;
-} // static uint32_t ringbuffer_get_data_slots(S_M1_RingBuffer *prb_handle)
+
+/*============================================================================*/
+/*
+ * This function copies n_bytes to the buffer from the write index head, in at
+ * most two memcpy() calls, and returns the new write index.
+ * The caller has checked the free space.
+ *
+ */
+/*============================================================================*/
+static uint32_t ringbuffer_copy_in(S_M1_RingBuffer *prb_handle, uint32_t head, const uint8_t *indata, uint32_t n_bytes)
+{
+	uint32_t n_linear;
+
+	n_linear = prb_handle->end_index - head; // Bytes from the head index to the end of the buffer
+	if ( n_bytes < n_linear )
+	{
+		memcpy(&prb_handle->pdata[head], indata, n_bytes);
+		return head + n_bytes;
+	}
+
+	memcpy(&prb_handle->pdata[head], indata, n_linear);
+	memcpy(prb_handle->pdata, &indata[n_linear], n_bytes - n_linear); // Remainder to the start of the buffer
+
+	return n_bytes - n_linear;
+} // static uint32_t ringbuffer_copy_in(...)
+
+
+
+/*============================================================================*/
+/*
+ * This function copies n_bytes from the buffer from the read index tail, in
+ * at most two memcpy() calls, and returns the new read index.
+ * The caller has checked the available data.
+ *
+ */
+/*============================================================================*/
+static uint32_t ringbuffer_copy_out(const S_M1_RingBuffer *prb_handle, uint32_t tail, uint8_t *outdata, uint32_t n_bytes)
+{
+	uint32_t n_linear;
+
+	n_linear = prb_handle->end_index - tail; // Bytes from the tail index to the end of the buffer
+	if ( n_bytes < n_linear )
+	{
+		memcpy(outdata, &prb_handle->pdata[tail], n_bytes);
+		return tail + n_bytes;
+	}
+
+	memcpy(outdata, &prb_handle->pdata[tail], n_linear);
+	memcpy(&outdata[n_linear], prb_handle->pdata, n_bytes - n_linear); // Remainder from the start of the buffer
+
+	return n_bytes - n_linear;
+} // static uint32_t ringbuffer_copy_out(...)
 
 
 
 /*============================================================================*/
 /**
  *
- * This function copies data from input data buffer to ring buffer
+ * This function copies data from input data buffer to ring buffer.
+ * Only the free slots are written, the remainder is not taken.
  *
  */
 /*============================================================================*/
-uint16_t m1_ringbuffer_write(S_M1_RingBuffer *prb_handle, uint8_t *indata, uint16_t n_slots)
+uint16_t m1_ringbuffer_write(S_M1_RingBuffer *prb_handle, const uint8_t *indata, uint16_t n_slots)
 {
-    uint32_t n_copy, n_free;
-    uint8_t data_size;
+    uint32_t n_free, head;
 
     if ( !IS_BUFFER_VALID(prb_handle) )
     	return 0;
@@ -163,36 +199,18 @@ uint16_t m1_ringbuffer_write(S_M1_RingBuffer *prb_handle, uint8_t *indata, uint1
     if ( indata==NULL )
     	return 0;
 
-    if ( n_slots==0 )
-    	return 0;
-
-    n_free = ringbuffer_get_empty_slots(prb_handle);
-    if ( n_free==0 ) // No empty space in the buffer?
-    	return 0;
-
-    data_size = prb_handle->data_size;
-
+    n_free = m1_ringbuffer_free_slots(prb_handle);
     n_slots = GET_MIN_NUM(n_free, n_slots); // Update the maximum number of slots that can be written to the buffer
-    n_copy = prb_handle->end_index - prb_handle->head; // Get empty slots from current head index to the end of the buffer
-    n_copy /= data_size;
-    n_copy = GET_MIN_NUM(n_copy, n_slots); // Get maximum slots that can be written to the buffer from the head index
-    memcpy(&prb_handle->pdata[prb_handle->head], indata, n_copy*data_size); // Copy to the buffer
-
-    prb_handle->head += n_copy*data_size; // Update the head index
-    n_slots -= n_copy; // Update the remainder
-    if (prb_handle->head >= prb_handle->end_index) // Head index got an overflow?
-    {
-        prb_handle->head = 0;
-    }
+    if ( n_slots==0 ) // Nothing to write or no empty space in the buffer?
+    	return 0;
 
-    if (n_slots > 0) // Remainder needs to be copied?
-    {
-        memcpy(prb_handle->pdata, &indata[n_copy*data_size], n_slots*data_size); // Copy the remainder to the start of the buffer
-        prb_handle->head = n_slots*data_size; // Update the head index
-    }
+    RB_INDEX_BARRIER(); // The reader has released these slots
+    head = ringbuffer_copy_in(prb_handle, prb_handle->head, indata, (uint32_t)n_slots*prb_handle->data_size);
+    RB_INDEX_BARRIER(); // Data before the index
+    prb_handle->head = head;
 
-    return (n_copy + n_slots);
-} // uint16_t m1_ringbuffer_write(S_M1_RingBuffer *prb_handle, uint8_t *indata, uint16_t n_slots)
+    return n_slots;
+} // uint16_t m1_ringbuffer_write(S_M1_RingBuffer *prb_handle, const uint8_t *indata, uint16_t n_slots)
 
 
 
@@ -201,12 +219,13 @@ uint16_t m1_ringbuffer_write(S_M1_RingBuffer *prb_handle, uint8_t *indata, uint1
  *
  * This function copies one data item from input data buffer to ring buffer
  * If the buffer is full, it will remove the oldest item and add the new item.
+ * It moves the read index then, so it must not race with a reader.
  *
  */
 /*============================================================================*/
 uint16_t m1_ringbuffer_insert(S_M1_RingBuffer *prb_handle, uint8_t *indata)
 {
-    uint16_t n_free;
+    uint32_t head, tail;
 /*
     if ( !IS_BUFFER_VALID(prb_handle) )
     	return 0;
@@ -214,25 +233,29 @@ uint16_t m1_ringbuffer_insert(S_M1_RingBuffer *prb_handle, uint8_t *indata)
     if ( indata==NULL )
     	return 0;
 */
-    n_free = ringbuffer_get_empty_slots(prb_handle);
-    if ( n_free==0 ) // No empty space in the buffer?
+    if ( m1_ringbuffer_free_slots(prb_handle)==0 ) // No empty space in the buffer?
     {
-        prb_handle->tail += prb_handle->data_size; // Update the read index
-        if (prb_handle->tail >= prb_handle->end_index) // If overflow occurs, update the read index again
-        	prb_handle->tail = 0;
+        tail = prb_handle->tail + prb_handle->data_size; // Update the read index
+        if (tail >= prb_handle->end_index) // If overflow occurs, update the read index again
+        	tail = 0;
+        prb_handle->tail = tail;
     }
 
-    memcpy(&prb_handle->pdata[prb_handle->head], indata, prb_handle->data_size); // Copy to the buffer
-    prb_handle->head += prb_handle->data_size; // Update the head index
-    if (prb_handle->head >= prb_handle->end_index) // Head index got an overflow?
+    head = prb_handle->head;
+    memcpy(&prb_handle->pdata[head], indata, prb_handle->data_size); // Copy to the buffer
+    head += prb_handle->data_size; // Update the head index
+    if (head >= prb_handle->end_index) // Head index got an overflow?
     {
-        prb_handle->head = 0;
+        head = 0;
     }
+    RB_INDEX_BARRIER();
+    prb_handle->head = head;
 
     return 1;
 } // uint16_t m1_ringbuffer_insert(S_M1_RingBuffer *prb_handle, uint8_t *indata)
 
 
+
 /*============================================================================*/
 /**
  *
@@ -242,42 +265,59 @@ uint16_t m1_ringbuffer_insert(S_M1_RingBuffer *prb_handle, uint8_t *indata)
 /*============================================================================*/
 uint16_t m1_ringbuffer_read(S_M1_RingBuffer *prb_handle, uint8_t *outdata, uint16_t n_slots)
 {
-	uint32_t n_read, n_linear;
-	uint8_t *padd_r;
+	uint32_t n_read, tail;
 
 	if ( !IS_BUFFER_VALID(prb_handle) )
     	return 0;
 
 	assert(outdata != NULL);
 
-    do {
-        // Get the number of data slots available to read
-        n_read =  ringbuffer_get_data_slots(prb_handle);
-        n_read = GET_MIN_NUM(n_slots, n_read);
-
-        if ( !n_read )
-        	break;
-
-        n_linear = m1_ringbuffer_get_read_len(prb_handle);
-        padd_r = m1_ringbuffer_get_read_address(prb_handle); // Get read address
-        if ( n_linear >= n_read ) // Linear data block is more than enough to complete in one read?
-        {
-        	memcpy(outdata, padd_r, n_read*prb_handle->data_size);
-        	m1_ringbuffer_advance_read(prb_handle, n_read); // Update read index
-        	break;
-        } // if ( n_linear >= n_read )
-        memcpy(outdata, padd_r, n_linear*prb_handle->data_size); // Read first linear part
-        m1_ringbuffer_advance_read(prb_handle, n_linear); // Update read index
-        padd_r = m1_ringbuffer_get_read_address(prb_handle); // Get new read address
-        memcpy(&outdata[n_linear], padd_r, (n_read - n_linear)*prb_handle->data_size); // Read second linear part
-        m1_ringbuffer_advance_read(prb_handle, n_read - n_linear); // Update read index
-    } while(0);
+    // Get the number of data slots available to read
+    n_read = m1_ringbuffer_used_slots(prb_handle);
+    n_read = GET_MIN_NUM(n_slots, n_read);
+    if ( !n_read )
+    	return 0;
+
+    RB_INDEX_BARRIER(); // The writer has published these slots
+    tail = ringbuffer_copy_out(prb_handle, prb_handle->tail, outdata, n_read*prb_handle->data_size);
+    RB_INDEX_BARRIER(); // Copy done before the slots are released
+    prb_handle->tail = tail;
 
     return n_read;
 } // uint16_t m1_ringbuffer_read(S_M1_RingBuffer *prb_handle, uint8_t *outdata, uint16_t n_slots)
 
 
 
+/*============================================================================*/
+/**
+ *
+ * This function copies data from the ring buffer to the output buffer
+ * without removing it
+ *
+ */
+/*============================================================================*/
+uint16_t m1_ringbuffer_peek(S_M1_RingBuffer *prb_handle, uint8_t *outdata, uint16_t n_slots)
+{
+	uint32_t n_read;
+
+	if ( !IS_BUFFER_VALID(prb_handle) )
+    	return 0;
+
+	assert(outdata != NULL);
+
+    n_read = m1_ringbuffer_used_slots(prb_handle);
+    n_read = GET_MIN_NUM(n_slots, n_read);
+    if ( !n_read )
+    	return 0;
+
+    RB_INDEX_BARRIER();
+    ringbuffer_copy_out(prb_handle, prb_handle->tail, outdata, n_read*prb_handle->data_size);
+
+    return n_read;
+} // uint16_t m1_ringbuffer_peek(S_M1_RingBuffer *prb_handle, uint8_t *outdata, uint16_t n_slots)
+
+
+
 /*============================================================================*/
 /*
  *
@@ -287,7 +327,7 @@ uint16_t m1_ringbuffer_read(S_M1_RingBuffer *prb_handle, uint8_t *outdata, uint1
 /*============================================================================*/
 uint16_t m1_ringbuffer_advance_read(S_M1_RingBuffer *prb_handle, uint16_t n_slots)
 {
-    uint32_t n_avail;
+    uint32_t n_avail, tail;
 
     if ( !IS_BUFFER_VALID(prb_handle) )
     	return 0;
@@ -295,12 +335,14 @@ uint16_t m1_ringbuffer_advance_read(S_M1_RingBuffer *prb_handle, uint16_t n_slot
     if ( n_slots==0 )
     	return 0;
 
-    n_avail = ringbuffer_get_data_slots(prb_handle); // Get available data slots in the buffer
+    n_avail = m1_ringbuffer_used_slots(prb_handle); // Get available data slots in the buffer
     n_slots = GET_MIN_NUM(n_slots, n_avail); // Get the maximum number of slots that can be advanced for the read index
 
-    prb_handle->tail += n_slots*prb_handle->data_size; // Update the read index
-    if (prb_handle->tail >= prb_handle->end_index) // If overflow occurs, update the read index again
-    	prb_handle->tail -= prb_handle->end_index;
+    tail = prb_handle->tail + n_slots*prb_handle->data_size; // Update the read index
+    if (tail >= prb_handle->end_index) // If overflow occurs, update the read index again
+    	tail -= prb_handle->end_index;
+    RB_INDEX_BARRIER();
+    prb_handle->tail = tail;
 
     return n_slots;
 } // uint16_t m1_ringbuffer_advance_read(S_M1_RingBuffer *prb_handle, uint16_t n_slots)
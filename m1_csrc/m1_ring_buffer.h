@@ -13,6 +13,17 @@
 #ifndef M1_RING_BUFFER_H_
 #define M1_RING_BUFFER_H_
 
+#include <stdint.h>
+
+/*
+ * m1_ringbuffer_write(), m1_ringbuffer_read(), m1_ringbuffer_peek() and
+ * m1_ringbuffer_advance_read() are safe without a lock for one producer and
+ * one consumer, each in a task or an ISR: the writer only updates head, the
+ * reader only updates tail. m1_ringbuffer_insert() (overwrites the oldest
+ * item when full) and m1_ringbuffer_reset() move both indexes and need the
+ * other side to be idle.
+ */
+
 typedef struct
 {
     uint8_t *pdata; // Pointer to the buffer
@@ -29,12 +40,35 @@ void m1_ringbuffer_init(S_M1_RingBuffer *prb_handle, uint8_t *ring_buffer, uint1
 void m1_ringbuffer_reset(S_M1_RingBuffer *prb_handle);
 uint16_t m1_ringbuffer_get_read_len(S_M1_RingBuffer *prb_handle);
 uint8_t *m1_ringbuffer_get_read_address(S_M1_RingBuffer *prb_handle);
-uint16_t m1_ringbuffer_write(S_M1_RingBuffer *prb_handle, uint8_t *indata, uint16_t n_slots);
+uint16_t m1_ringbuffer_write(S_M1_RingBuffer *prb_handle, const uint8_t *indata, uint16_t n_slots);
 uint16_t m1_ringbuffer_insert(S_M1_RingBuffer *prb_handle, uint8_t *indata);
 uint16_t m1_ringbuffer_read(S_M1_RingBuffer *prb_handle, uint8_t *outdata, uint16_t bytes_n);
+uint16_t m1_ringbuffer_peek(S_M1_RingBuffer *prb_handle, uint8_t *outdata, uint16_t n_slots);
 uint16_t m1_ringbuffer_advance_read(S_M1_RingBuffer *prb_handle, uint16_t bytes_n);
 uint8_t m1_ringbuffer_check_empty_state(S_M1_RingBuffer *prb_handle);
 uint32_t ringbuffer_get_empty_slots(S_M1_RingBuffer *prb_handle);
 uint32_t ringbuffer_get_data_slots(S_M1_RingBuffer *prb_handle);
 
+/*
+ * Used and free slots from one snapshot of each index, without a lock.
+ * Seen from the producer the free space can only grow, seen from the
+ * consumer the used space can only grow.
+ */
+static inline uint32_t m1_ringbuffer_used_slots(const S_M1_RingBuffer *prb_handle)
+{
+	uint32_t head = prb_handle->head;
+	uint32_t tail = prb_handle->tail;
+
+	if ( head < tail ) // Data wraps around the end of the buffer?
+		head += prb_handle->end_index;
+
+	return (head - tail)/prb_handle->data_size;
+} // static inline uint32_t m1_ringbuffer_used_slots(const S_M1_RingBuffer *prb_handle)
+
+
+static inline uint32_t m1_ringbuffer_free_slots(const S_M1_RingBuffer *prb_handle)
+{
+	return prb_handle->len - 1 - m1_ringbuffer_used_slots(prb_handle);
+} // static inline uint32_t m1_ringbuffer_free_slots(const S_M1_RingBuffer *prb_handle)
+
 #endif /* M1_RING_BUFFER_H_ */
@@ -22,6 +22,7 @@
 #include "app_freertos.h"
 #include "cmsis_os.h"
 #include "m1_sdcard.h"
+#include "m1_usb_cdc_msc.h"
 
 /*************************** D E F I N E S ************************************/
 
@@ -76,6 +77,9 @@ EXTI_HandleTypeDef 	sdcard_exti_hdl;
 TaskHandle_t		sdcard_task_hdl;
 QueueHandle_t		sdcard_cb_q_hdl = NULL;
 uint8_t 			sdcard_status_changed = 0;
+// Bumped on every sector write and (un)mount, readers compare it to see if
+// what they read from the card may have changed
+static volatile uint32_t sdcard_write_seq = 0;
 
 static FATFS 		*sd_pfatfs; 		// Pointer to File system object for user logical drive
 static FRESULT 		sd_fres;  			// Return code for user
@@ -101,6 +105,7 @@ static void m1_sd_hardware_init(void);
 char *m1_sd_error_msg(S_M1_SDCard_Access_Status ferr);
 S_M1_SDCard_Info *m1_sdcard_get_info(void);
 FRESULT m1_sdcard_get_error_code(void);
+uint32_t m1_sdcard_get_write_seq(void);
 uint32_t m1_sdcard_get_total_capacity(void);
 uint32_t m1_sdcard_get_free_capacity(void);
 S_M1_SDCard_Access_Status m1_sdcard_get_status(void);
@@ -527,6 +532,22 @@ FRESULT m1_sdcard_get_error_code(void)
 
 
 
+/******************************************************************************/
+/**
+*
+* This function returns a counter that changes whenever the card may have
+* been written, remounted or swapped. Directory listings cached while it
+* stays the same are still valid.
+*
+*/
+/******************************************************************************/
+uint32_t m1_sdcard_get_write_seq(void)
+{
+	return sdcard_write_seq;
+} // uint32_t m1_sdcard_get_write_seq(void)
+
+
+
 /******************************************************************************/
 /**
 *
@@ -664,6 +685,9 @@ S_M1_SDCard_Access_Status m1_sdcard_get_status(void)
 /******************************************************************************/
 void m1_sdcard_mount(void)
 {
+	// Blocks written over USB mass storage must be on the card first
+	m1_usb_msc_flush();
+	sdcard_write_seq++;
 	// Mount a Logical Drive
 	sd_fres = f_mount(&sdcard_ctl.sdfs, sdcard_ctl.sdpath, 1);
 	if (sd_fres==FR_OK || sd_fres==FR_NO_FILESYSTEM)
@@ -701,6 +725,7 @@ void m1_sdcard_unmount(void)
 	// Unmount a Logical Drive
     f_mount(0, sdcard_ctl.sdpath, 0);
     sdcard_ctl.status = SD_access_UnMounted;
+	sdcard_write_seq++;
 	M1_LOG_I(M1_LOGDB_TAG, "Card unmounted.\r\n");
 } // void m1_sdcard_unmount(void)
 
@@ -1032,6 +1057,7 @@ DRESULT m1_sdcard_write(uint8_t param, const uint8_t *buff, DWORD sector, UINT c
 		return res;
 	}
 
+	sdcard_write_seq++; // Even a failed write may have changed the sectors
 	if ( HAL_SD_WriteBlocks_DMA(phsd, buff, (uint32_t)sector, count)==HAL_OK )
 	{
 		status = xQueueReceive(sdcard_cb_q_hdl, (void *)&event, SD_DATATIMEOUT);
@@ -0,0 +1,906 @@
+/* See COPYING.txt for license details. */
+
+/*
+*
+* m1_signal_index.c
+*
+* Index of saved signals
+*
+* M1 Project
+*
+*/
+
+/*************************** I N C L U D E S **********************************/
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "m1_signal_index.h"
+#include "m1_file_util.h"
+
+/*************************** D E F I N E S ************************************/
+
+#define SIG_IDX_MAGIC			0x58444953	// "SIDX"
+#define SIG_IDX_VERSION			1
+#define SIG_IDX_DIR				"0:/System"
+#define SIG_IDX_MAX_RECORDS		8192	// 1 MB of index
+#define SIG_IDX_WALK_DEPTH		3		// Sub-directories below a signal folder
+#define SIG_IDX_PARSE_LINES		40		// Header lines read from a signal file
+#define SIG_IDX_LINE_LEN		96
+
+//************************** S T R U C T U R E S *******************************
+
+typedef struct
+{
+	uint32_t magic;
+	uint16_t version;
+	uint16_t record_size;
+	uint32_t records; // Removed records included
+	uint32_t writes; // Bumped by every change, see S_M1_SigIdx_Search
+} S_M1_SigIdx_Header;
+
+typedef struct
+{
+	const char *dir;
+	S_M1_SigIdx_Type type;
+	const char *ext[2];
+} S_M1_SigIdx_Folder;
+
+//************************** C O N S T A N T **********************************/
+
+static const S_M1_SigIdx_Folder sig_idx_folders[] =
+{
+	{"0:/SUBGHZ",	SIG_IDX_SUBGHZ,	{".sgh", ".sub"}},
+	{"0:/IR",		SIG_IDX_IR,		{".ir", NULL}},
+	{"0:/NFC",		SIG_IDX_NFC,	{".nfc", NULL}},
+	{"0:/RFID",		SIG_IDX_RFID,	{".rfid", NULL}}
+};
+
+static const char *sig_idx_type_names[SIG_IDX_TYPES] = {"Sub-GHz", "IR", "NFC", "RFID"};
+
+/***************************** V A R I A B L E S ******************************/
+
+// Shared by every level of the walk, a name is used before going down
+static FILINFO sig_idx_fno;
+
+/********************* F U N C T I O N   P R O T O T Y P E S ******************/
+
+void m1_sig_idx_add(S_M1_SigIdx_Type type, const char *path, const char *protocol, uint32_t freq_hz, const uint8_t *uid, uint8_t uid_len);
+FRESULT m1_sig_idx_put(const S_M1_SigIdx_Record *prec);
+FRESULT m1_sig_idx_remove(const char *path);
+FRESULT m1_sig_idx_rename(const char *old_path, const char *new_path);
+FRESULT m1_sig_idx_read(uint16_t record, S_M1_SigIdx_Record *prec);
+uint16_t m1_sig_idx_records(void);
+FRESULT m1_sig_idx_rebuild(uint16_t *pcount);
+bool m1_sig_idx_parse_file(const char *path, S_M1_SigIdx_Type type, S_M1_SigIdx_Record *prec);
+void m1_sig_idx_search_reset(S_M1_SigIdx_Search *psearch);
+FRESULT m1_sig_idx_search(S_M1_SigIdx_Search *psearch, const char *query);
+int16_t m1_sig_idx_fuzzy_score(const char *query, const char *text);
+const char *m1_sig_idx_type_name(uint8_t type);
+void m1_sig_idx_format_freq(const S_M1_SigIdx_Record *prec, char *buf, uint8_t size);
+static FRESULT sig_idx_open(FIL *pfile, S_M1_SigIdx_Header *phdr, bool create);
+static FRESULT sig_idx_write_header(FIL *pfile, const S_M1_SigIdx_Header *phdr);
+static FRESULT sig_idx_read_at(FIL *pfile, uint32_t record, S_M1_SigIdx_Record *prec);
+static FRESULT sig_idx_write_at(FIL *pfile, uint32_t record, const S_M1_SigIdx_Record *prec);
+static FRESULT sig_idx_walk(FIL *pidx, S_M1_SigIdx_Header *phdr, char *path, const S_M1_SigIdx_Folder *pfolder, uint8_t depth);
+static bool sig_idx_set_path(char *dst, const char *path);
+static bool sig_idx_path_equal(const char *path1, const char *path2);
+static bool sig_idx_path_in(const char *path, const char *top);
+static bool sig_idx_has_ext(const char *path, const S_M1_SigIdx_Folder *pfolder);
+static const char *sig_idx_stristr(const char *text, const char *part);
+static void sig_idx_copy_hex(char *dst, const char *src);
+static int16_t sig_idx_score_record(const char *query, const S_M1_SigIdx_Record *prec);
+static void sig_idx_insert_hit(S_M1_SigIdx_Search *psearch, uint16_t record, int16_t score);
+
+/*************** F U N C T I O N   I M P L E M E N T A T I O N ****************/
+
+/*============================================================================*/
+/*
+ * This function records a file just saved. It is called by the save paths,
+ * a signal stays saved if its record cannot be written.
+ */
+/*============================================================================*/
+void m1_sig_idx_add(S_M1_SigIdx_Type type, const char *path, const char *protocol, uint32_t freq_hz, const uint8_t *uid, uint8_t uid_len)
+{
+	S_M1_SigIdx_Record rec;
+	uint8_t i;
+
+	memset(&rec, 0, sizeof(rec));
+	rec.type = type;
+	rec.freq_hz = freq_hz;
+	if ( !sig_idx_set_path(rec.path, path) )
+		return;
+	if ( protocol!=NULL )
+		snprintf(rec.protocol, sizeof(rec.protocol), "%s", protocol);
+	for ( i = 0; uid!=NULL && i < uid_len && 2*i + 2 < SIG_IDX_UID_LEN; i++ )
+		sprintf(&rec.uid[2*i], "%02X", uid[i]);
+
+	m1_sig_idx_put(&rec);
+} // void m1_sig_idx_add(...)
+
+
+
+/*============================================================================*/
+/*
+ * This function stores a record, over the one with the same path if any.
+ */
+/*============================================================================*/
+FRESULT m1_sig_idx_put(const S_M1_SigIdx_Record *prec)
+{
+	S_M1_SigIdx_Header hdr;
+	S_M1_SigIdx_Record rec;
+	uint32_t i, slot;
+	FIL file;
+	FRESULT res;
+
+	res = sig_idx_open(&file, &hdr, true);
+	if ( res!=FR_OK )
+		return res;
+
+	// The first removed record is reused unless the path is found later
+	slot = hdr.records;
+	for ( i = 0; i < hdr.records; i++ )
+	{
+		res = sig_idx_read_at(&file, i, &rec);
+		if ( res!=FR_OK )
+			break;
+		if ( rec.type==SIG_IDX_FREE )
+		{
+			if ( slot==hdr.records )
+				slot = i;
+		}
+		else if ( sig_idx_path_equal(rec.path, prec->path) )
+		{
+			slot = i;
+			break;
+		}
+	} // for ( i = 0; i < hdr.records; i++ )
+
+	if ( res==FR_OK && slot==hdr.records && hdr.records >= SIG_IDX_MAX_RECORDS )
+		res = FR_DENIED;
+	if ( res==FR_OK )
+		res = sig_idx_write_at(&file, slot, prec);
+	if ( res==FR_OK )
+	{
+		if ( slot==hdr.records )
+			hdr.records++;
+		hdr.writes++;
+		res = sig_idx_write_header(&file, &hdr);
+	}
+	if ( f_close(&file)!=FR_OK && res==FR_OK )
+		res = FR_DISK_ERR;
+
+	return res;
+} // FRESULT m1_sig_idx_put(const S_M1_SigIdx_Record *prec)
+
+
+
+/*============================================================================*/
+/*
+ * This function drops the record of a file, or the records of every file
+ * below a folder.
+ */
+/*============================================================================*/
+FRESULT m1_sig_idx_remove(const char *path)
+{
+	S_M1_SigIdx_Header hdr;
+	S_M1_SigIdx_Record rec;
+	bool removed = false;
+	uint32_t i;
+	FIL file;
+	FRESULT res;
+
+	if ( fs_file_exists(SIG_IDX_FILE)!=1 ) // No index, nothing to drop
+		return FR_OK;
+	res = sig_idx_open(&file, &hdr, true);
+	if ( res!=FR_OK )
+		return res;
+
+	for ( i = 0; res==FR_OK && i < hdr.records; i++ )
+	{
+		res = sig_idx_read_at(&file, i, &rec);
+		if ( res==FR_OK && rec.type!=SIG_IDX_FREE && sig_idx_path_in(rec.path, path) )
+		{
+			memset(&rec, 0, sizeof(rec));
+			rec.type = SIG_IDX_FREE;
+			res = sig_idx_write_at(&file, i, &rec);
+			removed = true;
+		}
+	} // for ( i = 0; ...
+	if ( removed )
+	{
+		hdr.writes++;
+		if ( sig_idx_write_header(&file, &hdr)!=FR_OK && res==FR_OK )
+			res = FR_DISK_ERR;
+	}
+	f_close(&file);
+
+	return res;
+} // FRESULT m1_sig_idx_remove(const char *path)
+
+
+
+/*============================================================================*/
+/*
+ * This function moves the record of a renamed file to its new path. A file
+ * that was not indexed stays out until the next rebuild, a new path too long
+ * for a record drops it.
+ */
+/*============================================================================*/
+FRESULT m1_sig_idx_rename(const char *old_path, const char *new_path)
+{
+	S_M1_SigIdx_Header hdr;
+	S_M1_SigIdx_Record rec;
+	bool found = false;
+	uint32_t i;
+	FIL file;
+	FRESULT res;
+
+	if ( fs_file_exists(SIG_IDX_FILE)!=1 )
+		return FR_OK;
+	res = sig_idx_open(&file, &hdr, false);
+	if ( res!=FR_OK )
+		return res;
+	for ( i = 0; i < hdr.records && !found; i++ )
+	{
+		res = sig_idx_read_at(&file, i, &rec);
+		if ( res!=FR_OK )
+			break;
+		found = (rec.type!=SIG_IDX_FREE && sig_idx_path_equal(rec.path, old_path));
+	}
+	f_close(&file);
+	if ( !found )
+		return res;
+
+	res = m1_sig_idx_remove(old_path);
+	if ( res==FR_OK && sig_idx_set_path(rec.path, new_path) )
+		res = m1_sig_idx_put(&rec);
+
+	return res;
+} // FRESULT m1_sig_idx_rename(const char *old_path, const char *new_path)
+
+
+
+FRESULT m1_sig_idx_read(uint16_t record, S_M1_SigIdx_Record *prec)
+{
+	S_M1_SigIdx_Header hdr;
+	FIL file;
+	FRESULT res;
+
+	res = sig_idx_open(&file, &hdr, false);
+	if ( res!=FR_OK )
+		return res;
+	res = (record < hdr.records) ? sig_idx_read_at(&file, record, prec) : FR_INVALID_PARAMETER;
+	f_close(&file);
+
+	return res;
+} // FRESULT m1_sig_idx_read(uint16_t record, S_M1_SigIdx_Record *prec)
+
+
+
+/*============================================================================*/
+/*
+ * This function returns the number of records, removed ones included. It is
+ * 0 if there is no index yet.
+ */
+/*============================================================================*/
+uint16_t m1_sig_idx_records(void)
+{
+	S_M1_SigIdx_Header hdr;
+	FIL file;
+
+	if ( sig_idx_open(&file, &hdr, false)!=FR_OK )
+		return 0;
+	f_close(&file);
+
+	return (uint16_t)hdr.records;
+} // uint16_t m1_sig_idx_records(void)
+
+
+
+/*============================================================================*/
+/*
+ * This function builds the index again from the files in the signal
+ * folders, for the files copied to the card over USB or saved before there
+ * was an index.
+ */
+/*============================================================================*/
+FRESULT m1_sig_idx_rebuild(uint16_t *pcount)
+{
+	S_M1_SigIdx_Header hdr;
+	char path[SIG_IDX_PATH_LEN];
+	uint32_t writes;
+	uint8_t i;
+	FIL file;
+	FRESULT res;
+
+	if ( pcount!=NULL )
+		*pcount = 0;
+	// The count of changes goes on from the old index, if any
+	writes = 0;
+	if ( sig_idx_open(&file, &hdr, false)==FR_OK )
+	{
+		writes = hdr.writes;
+		f_close(&file);
+	}
+	res = fs_directory_ensure(SIG_IDX_DIR);
+	if ( res!=FR_OK )
+		return res;
+	res = f_open(&file, SIG_IDX_FILE, FA_CREATE_ALWAYS | FA_READ | FA_WRITE);
+	if ( res!=FR_OK )
+		return res;
+
+	memset(&hdr, 0, sizeof(hdr));
+	hdr.writes = writes + 1;
+	hdr.magic = SIG_IDX_MAGIC;
+	hdr.version = SIG_IDX_VERSION;
+	hdr.record_size = sizeof(S_M1_SigIdx_Record);
+	res = sig_idx_write_header(&file, &hdr);
+
+	for ( i = 0; res==FR_OK && i < sizeof(sig_idx_folders)/sizeof(sig_idx_folders[0]); i++ )
+	{
+		strcpy(path, sig_idx_folders[i].dir);
+		res = sig_idx_walk(&file, &hdr, path, &sig_idx_folders[i], 0);
+		if ( res==FR_NO_PATH || res==FR_NO_FILE ) // Nothing saved of this kind
+			res = FR_OK;
+	} // for ( i = 0; ...
+
+	// The count goes in last, an interrupted rebuild leaves an empty index
+	if ( res==FR_OK )
+		res = sig_idx_write_header(&file, &hdr);
+	if ( f_close(&file)!=FR_OK && res==FR_OK )
+		res = FR_DISK_ERR;
+	if ( res==FR_OK && pcount!=NULL )
+		*pcount = (uint16_t)hdr.records;
+
+	return res;
+} // FRESULT m1_sig_idx_rebuild(uint16_t *pcount)
+
+
+
+/*============================================================================*/
+/*
+ * This function reads the protocol, frequency and UID from the header lines
+ * of a signal file. The keys of the Sub-GHz, IR, NFC and LF RFID formats do
+ * not overlap, so one pass handles them all.
+ */
+/*============================================================================*/
+bool m1_sig_idx_parse_file(const char *path, S_M1_SigIdx_Type type, S_M1_SigIdx_Record *prec)
+{
+	char line[SIG_IDX_LINE_LEN];
+	char *key, *value, *end;
+	bool raw = false;
+	uint8_t n;
+	FIL file;
+
+	memset(prec, 0, sizeof(*prec));
+	prec->type = type;
+	if ( !sig_idx_set_path(prec->path, path) )
+		return false;
+	if ( f_open(&file, path, FA_OPEN_EXISTING | FA_READ)!=FR_OK )
+		return false;
+
+	for ( n = 0; n < SIG_IDX_PARSE_LINES && f_gets(line, sizeof(line), &file)!=NULL; n++ )
+	{
+		value = strchr(line, ':');
+		if ( value==NULL )
+			continue;
+		*value++ = '\0';
+		key = line;
+		while ( *key==' ' )
+			key++;
+		while ( *value==' ' )
+			value++;
+		end = value + strlen(value);
+		while ( end > value && isspace((unsigned char)end[-1]) )
+			*--end = '\0';
+
+		if ( sig_idx_path_equal(key, "Frequency") )
+		{
+			if ( !prec->freq_hz )
+				prec->freq_hz = strtoul(value, NULL, 10);
+		}
+		else if ( sig_idx_path_equal(key, "Protocol") || sig_idx_path_equal(key, "Packettype") || sig_idx_path_equal(key, "Device type") )
+		{
+			if ( !prec->protocol[0] )
+				snprintf(prec->protocol, sizeof(prec->protocol), "%s", value);
+		}
+		else if ( sig_idx_path_equal(key, "UID") || sig_idx_path_equal(key, "HData") )
+		{
+			sig_idx_copy_hex(prec->uid, value);
+		}
+		else if ( sig_idx_path_equal(key, "Type") || sig_idx_path_equal(key, "Filetype") )
+		{
+			if ( sig_idx_stristr(value, "raw")!=NULL || sig_idx_stristr(value, "noise")!=NULL )
+				raw = true;
+		}
+		else if ( sig_idx_path_equal(key, "Data") )
+		{
+			break; // Only samples from here on
+		}
+	} // for ( n = 0; ...
+	f_close(&file);
+
+	if ( !prec->protocol[0] && (raw || type==SIG_IDX_SUBGHZ) )
+		strcpy(prec->protocol, "RAW");
+
+	return true;
+} // bool m1_sig_idx_parse_file(...)
+
+
+
+void m1_sig_idx_search_reset(S_M1_SigIdx_Search *psearch)
+{
+	memset(psearch, 0, sizeof(*psearch));
+} // void m1_sig_idx_search_reset(S_M1_SigIdx_Search *psearch)
+
+
+
+/*============================================================================*/
+/*
+ * This function finds the records that match a query, best first. Each is
+ * matched on its file name, protocol, frequency, UID and kind. A query that
+ * extends the previous one re-scores the previous hits only, when they held
+ * every match and the index has not changed since. An empty query lists
+ * everything.
+ */
+/*============================================================================*/
+FRESULT m1_sig_idx_search(S_M1_SigIdx_Search *psearch, const char *query)
+{
+	S_M1_SigIdx_Hit prev_hits[SIG_IDX_MAX_HITS];
+	S_M1_SigIdx_Header hdr;
+	S_M1_SigIdx_Record rec;
+	char q[SIG_IDX_QUERY_LEN];
+	uint32_t i, matches, n;
+	int16_t score;
+	bool narrow;
+	UINT br;
+	FIL file;
+	FRESULT res;
+
+	for ( i = 0; query[i] && i < sizeof(q) - 1; i++ )
+		q[i] = (char)tolower((unsigned char)query[i]);
+	q[i] = '\0';
+	narrow = psearch->complete && strncmp(q, psearch->query, strlen(psearch->query))==0;
+
+	n = psearch->n_hits;
+	memcpy(prev_hits, psearch->hits, n*sizeof(S_M1_SigIdx_Hit));
+	psearch->n_hits = 0;
+	psearch->complete = false;
+	strcpy(psearch->query, q);
+
+	res = sig_idx_open(&file, &hdr, false);
+	if ( res==FR_NO_FILE || res==FR_NO_PATH ) // No index, nothing saved yet
+	{
+		psearch->writes = 0;
+		psearch->complete = true;
+		return FR_OK;
+	}
+	if ( res!=FR_OK )
+		return res;
+	// A record added, replaced or dropped since may change the hits
+	if ( hdr.writes!=psearch->writes )
+		narrow = false;
+	psearch->writes = hdr.writes;
+
+	matches = 0;
+	if ( narrow )
+	{
+		for ( i = 0; res==FR_OK && i < n; i++ )
+		{
+			res = sig_idx_read_at(&file, prev_hits[i].record, &rec);
+			if ( res!=FR_OK || rec.type==SIG_IDX_FREE )
+				continue;
+			score = sig_idx_score_record(q, &rec);
+			if ( score >= 0 )
+			{
+				matches++;
+				sig_idx_insert_hit(psearch, prev_hits[i].record, score);
+			}
+		} // for ( i = 0; ...
+	} // if ( narrow )
+	else
+	{
+		res = f_lseek(&file, sizeof(hdr));
+		for ( i = 0; res==FR_OK && i < hdr.records; i++ )
+		{
+			res = f_read(&file, &rec, sizeof(rec), &br);
+			if ( res!=FR_OK || br!=sizeof(rec) || rec.type==SIG_IDX_FREE )
+				continue;
+			score = sig_idx_score_record(q, &rec);
+			if ( score >= 0 )
+			{
+				matches++;
+				sig_idx_insert_hit(psearch, (uint16_t)i, score);
+			}
+		} // for ( i = 0; ...
+	} // else
+	f_close(&file);
+
+	psearch->complete = (res==FR_OK && matches <= SIG_IDX_MAX_HITS);
+
+	return res;
+} // FRESULT m1_sig_idx_search(S_M1_SigIdx_Search *psearch, const char *query)
+
+
+
+/*============================================================================*/
+/*
+ * This function scores how well text matches query, ignoring case, or
+ * returns -1 if the characters of query are not all in text in order. The
+ * whole query in one run scores above any scattered match, runs that start
+ * a word or the text score higher.
+ */
+/*============================================================================*/
+int16_t m1_sig_idx_fuzzy_score(const char *query, const char *text)
+{
+	const char *found;
+	int16_t score;
+	int32_t prev;
+	size_t qlen, i, t;
+
+	qlen = strlen(query);
+	if ( !qlen )
+		return 0;
+
+	found = sig_idx_stristr(text, query);
+	if ( found!=NULL )
+	{
+		score = (int16_t)(8*qlen + 10);
+		if ( found==text )
+			score += 10;
+		else if ( !isalnum((unsigned char)found[-1]) )
+			score += 5;
+		return score;
+	} // if ( found!=NULL )
+
+	score = 0;
+	prev = -2;
+	t = 0;
+	for ( i = 0; i < qlen; i++ )
+	{
+		while ( text[t] && tolower((unsigned char)text[t])!=tolower((unsigned char)query[i]) )
+			t++;
+		if ( !text[t] )
+			return -1;
+		score++;
+		if ( (int32_t)t==prev + 1 )
+			score += 4;
+		if ( t==0 || !isalnum((unsigned char)text[t - 1]) )
+			score += 3;
+		prev = (int32_t)t;
+		t++;
+	} // for ( i = 0; i < qlen; i++ )
+
+	return score;
+} // int16_t m1_sig_idx_fuzzy_score(const char *query, const char *text)
+
+
+
+const char *m1_sig_idx_type_name(uint8_t type)
+{
+	return (type < SIG_IDX_TYPES) ? sig_idx_type_names[type] : "?";
+} // const char *m1_sig_idx_type_name(uint8_t type)
+
+
+
+// Sub-GHz in MHz as "433.920", IR carriers in kHz as "38kHz"
+void m1_sig_idx_format_freq(const S_M1_SigIdx_Record *prec, char *buf, uint8_t size)
+{
+	if ( !prec->freq_hz )
+		buf[0] = '\0';
+	else if ( prec->type==SIG_IDX_IR )
+		snprintf(buf, size, "%lukHz", (unsigned long)(prec->freq_hz/1000));
+	else
+		snprintf(buf, size, "%lu.%03lu", (unsigned long)(prec->freq_hz/1000000), (unsigned long)((prec->freq_hz/1000) % 1000));
+} // void m1_sig_idx_format_freq(const S_M1_SigIdx_Record *prec, char *buf, uint8_t size)
+
+
+
+/*============================================================================*/
+/*
+ * This function opens the index and reads its header. With create, a
+ * missing or unknown file is started empty, else it is FR_NO_FILE.
+ */
+/*============================================================================*/
+static FRESULT sig_idx_open(FIL *pfile, S_M1_SigIdx_Header *phdr, bool create)
+{
+	uint32_t avail;
+	UINT n;
+	FRESULT res;
+
+	if ( create )
+	{
+		res = fs_directory_ensure(SIG_IDX_DIR);
+		if ( res!=FR_OK )
+			return res;
+	}
+	res = f_open(pfile, SIG_IDX_FILE, create ? (FA_OPEN_ALWAYS | FA_READ | FA_WRITE) : (FA_OPEN_EXISTING | FA_READ));
+	if ( res!=FR_OK )
+		return res;
+
+	res = f_read(pfile, phdr, sizeof(*phdr), &n);
+	if ( res==FR_OK && (n!=sizeof(*phdr) || phdr->magic!=SIG_IDX_MAGIC || phdr->version!=SIG_IDX_VERSION
+			|| phdr->record_size!=sizeof(S_M1_SigIdx_Record)) )
+	{
+		res = FR_NO_FILE;
+		if ( create )
+		{
+			memset(phdr, 0, sizeof(*phdr));
+			phdr->magic = SIG_IDX_MAGIC;
+			phdr->version = SIG_IDX_VERSION;
+			phdr->record_size = sizeof(S_M1_SigIdx_Record);
+			res = sig_idx_write_header(pfile, phdr);
+			if ( res==FR_OK )
+				res = f_truncate(pfile);
+		} // if ( create )
+	}
+	if ( res!=FR_OK )
+	{
+		f_close(pfile);
+		return res;
+	}
+
+	// Records cut short by a lost write are not used
+	avail = (f_size(pfile) - sizeof(*phdr))/sizeof(S_M1_SigIdx_Record);
+	if ( phdr->records > avail )
+		phdr->records = avail;
+
+	return FR_OK;
+} // static FRESULT sig_idx_open(FIL *pfile, S_M1_SigIdx_Header *phdr, bool create)
+
+
+
+static FRESULT sig_idx_write_header(FIL *pfile, const S_M1_SigIdx_Header *phdr)
+{
+	UINT n;
+	FRESULT res;
+
+	res = f_lseek(pfile, 0);
+	if ( res==FR_OK )
+		res = f_write(pfile, phdr, sizeof(*phdr), &n);
+	if ( res==FR_OK && n!=sizeof(*phdr) )
+		res = FR_DISK_ERR;
+
+	return res;
+} // static FRESULT sig_idx_write_header(FIL *pfile, const S_M1_SigIdx_Header *phdr)
+
+
+
+static FRESULT sig_idx_read_at(FIL *pfile, uint32_t record, S_M1_SigIdx_Record *prec)
+{
+	UINT n;
+	FRESULT res;
+
+	res = f_lseek(pfile, sizeof(S_M1_SigIdx_Header) + record*sizeof(S_M1_SigIdx_Record));
+	if ( res==FR_OK )
+		res = f_read(pfile, prec, sizeof(*prec), &n);
+	if ( res==FR_OK && n!=sizeof(*prec) )
+		res = FR_DISK_ERR;
+
+	return res;
+} // static FRESULT sig_idx_read_at(FIL *pfile, uint32_t record, S_M1_SigIdx_Record *prec)
+
+
+
+static FRESULT sig_idx_write_at(FIL *pfile, uint32_t record, const S_M1_SigIdx_Record *prec)
+{
+	UINT n;
+	FRESULT res;
+
+	res = f_lseek(pfile, sizeof(S_M1_SigIdx_Header) + record*sizeof(S_M1_SigIdx_Record));
+	if ( res==FR_OK )
+		res = f_write(pfile, prec, sizeof(*prec), &n);
+	if ( res==FR_OK && n!=sizeof(*prec) )
+		res = FR_DISK_ERR;
+
+	return res;
+} // static FRESULT sig_idx_write_at(FIL *pfile, uint32_t record, const S_M1_SigIdx_Record *prec)
+
+
+
+/*============================================================================*/
+/*
+ * This function appends the signal files below path to the index. path is
+ * extended in place and restored.
+ */
+/*============================================================================*/
+static FRESULT sig_idx_walk(FIL *pidx, S_M1_SigIdx_Header *phdr, char *path, const S_M1_SigIdx_Folder *pfolder, uint8_t depth)
+{
+	S_M1_SigIdx_Record rec;
+	size_t len;
+	DIR dir;
+	UINT n;
+	FRESULT res;
+
+	res = f_opendir(&dir, path);
+	if ( res!=FR_OK )
+		return res;
+
+	len = strlen(path);
+	while ( 1 )
+	{
+		res = f_readdir(&dir, &sig_idx_fno);
+		if ( res!=FR_OK || !sig_idx_fno.fname[0] )
+			break;
+		if ( sig_idx_fno.fattrib & (AM_HID | AM_SYS) )
+			continue;
+		if ( len + 1 + strlen(sig_idx_fno.fname) >= SIG_IDX_PATH_LEN )
+			continue; // Too long to index
+		path[len] = '/';
+		strcpy(&path[len + 1], sig_idx_fno.fname);
+
+		if ( sig_idx_fno.fattrib & AM_DIR )
+		{
+			if ( depth < SIG_IDX_WALK_DEPTH )
+				res = sig_idx_walk(pidx, phdr, path, pfolder, depth + 1);
+		}
+		else if ( phdr->records < SIG_IDX_MAX_RECORDS && sig_idx_has_ext(path, pfolder)
+				&& m1_sig_idx_parse_file(path, pfolder->type, &rec) )
+		{
+			res = f_write(pidx, &rec, sizeof(rec), &n);
+			if ( res==FR_OK && n!=sizeof(rec) )
+				res = FR_DISK_ERR;
+			if ( res==FR_OK )
+				phdr->records++;
+		} // else if ( ... )
+
+		path[len] = '\0';
+		if ( res!=FR_OK )
+			break;
+	} // while ( 1 )
+	f_closedir(&dir);
+
+	return res;
+} // static FRESULT sig_idx_walk(...)
+
+
+
+// The save paths name files "/NFC/x.nfc" or "0:/NFC/x.nfc", both are kept as the latter
+static bool sig_idx_set_path(char *dst, const char *path)
+{
+	const char *prefix = (path[0]=='/') ? "0:" : "";
+
+	if ( strlen(prefix) + strlen(path) >= SIG_IDX_PATH_LEN )
+		return false;
+	strcpy(dst, prefix);
+	strcat(dst, path);
+
+	return true;
+} // static bool sig_idx_set_path(char *dst, const char *path)
+
+
+
+// FAT names ignore case
+static bool sig_idx_path_equal(const char *path1, const char *path2)
+{
+	while ( *path1 && tolower((unsigned char)*path1)==tolower((unsigned char)*path2) )
+	{
+		path1++;
+		path2++;
+	}
+
+	return tolower((unsigned char)*path1)==tolower((unsigned char)*path2);
+} // static bool sig_idx_path_equal(const char *path1, const char *path2)
+
+
+
+// path is top or a file below the folder top
+static bool sig_idx_path_in(const char *path, const char *top)
+{
+	while ( *top && tolower((unsigned char)*top)==tolower((unsigned char)*path) )
+	{
+		top++;
+		path++;
+	}
+
+	return *top=='\0' && (*path=='\0' || *path=='/');
+} // static bool sig_idx_path_in(const char *path, const char *top)
+
+
+
+static bool sig_idx_has_ext(const char *path, const S_M1_SigIdx_Folder *pfolder)
+{
+	const char *dot = strrchr(path, '.');
+	uint8_t i;
+
+	for ( i = 0; dot!=NULL && i < 2; i++ )
+	{
+		if ( pfolder->ext[i]!=NULL && sig_idx_path_equal(dot, pfolder->ext[i]) )
+			return true;
+	}
+
+	return false;
+} // static bool sig_idx_has_ext(const char *path, const S_M1_SigIdx_Folder *pfolder)
+
+
+
+static const char *sig_idx_stristr(const char *text, const char *part)
+{
+	size_t i;
+
+	for ( ; *text; text++ )
+	{
+		for ( i = 0; part[i] && tolower((unsigned char)text[i])==tolower((unsigned char)part[i]); i++ )
+			;
+		if ( !part[i] )
+			return text;
+	}
+
+	return NULL;
+} // static const char *sig_idx_stristr(const char *text, const char *part)
+
+
+
+// "04 a2:1F" is kept as "04A21F"
+static void sig_idx_copy_hex(char *dst, const char *src)
+{
+	uint8_t n = 0;
+
+	for ( ; *src && n < SIG_IDX_UID_LEN - 1; src++ )
+	{
+		if ( isxdigit((unsigned char)*src) )
+			dst[n++] = (char)toupper((unsigned char)*src);
+	}
+	dst[n] = '\0';
+} // static void sig_idx_copy_hex(char *dst, const char *src)
+
+
+
+static int16_t sig_idx_score_record(const char *query, const S_M1_SigIdx_Record *prec)
+{
+	char name[SIG_IDX_PATH_LEN], freq[16];
+	const char *base;
+	char *dot;
+	int16_t best, score;
+
+	base = strrchr(prec->path, '/');
+	strcpy(name, (base!=NULL) ? base + 1 : prec->path);
+	dot = strrchr(name, '.');
+	if ( dot!=NULL && dot!=name )
+		*dot = '\0';
+	m1_sig_idx_format_freq(prec, freq, sizeof(freq));
+
+	best = m1_sig_idx_fuzzy_score(query, name);
+	score = m1_sig_idx_fuzzy_score(query, prec->protocol);
+	if ( score > best )
+		best = score;
+	score = m1_sig_idx_fuzzy_score(query, prec->uid);
+	if ( score > best )
+		best = score;
+	score = m1_sig_idx_fuzzy_score(query, freq);
+	if ( score > best )
+		best = score;
+	score = m1_sig_idx_fuzzy_score(query, m1_sig_idx_type_name(prec->type));
+	if ( score > best )
+		best = score;
+
+	return best;
+} // static int16_t sig_idx_score_record(const char *query, const S_M1_SigIdx_Record *prec)
+
+
+
+// Best score first, the newer record first on a tie, the worst drops out when full
+static void sig_idx_insert_hit(S_M1_SigIdx_Search *psearch, uint16_t record, int16_t score)
+{
+	uint16_t i, n;
+
+	n = psearch->n_hits;
+	if ( n==SIG_IDX_MAX_HITS )
+	{
+		if ( score < psearch->hits[n - 1].score || (score==psearch->hits[n - 1].score && record < psearch->hits[n - 1].record) )
+			return;
+		n--;
+	}
+
+	for ( i = n; i > 0; i-- )
+	{
+		if ( score < psearch->hits[i - 1].score || (score==psearch->hits[i - 1].score && record < psearch->hits[i - 1].record) )
+			break;
+		psearch->hits[i] = psearch->hits[i - 1];
+	}
+	psearch->hits[i].record = record;
+	psearch->hits[i].score = score;
+	psearch->n_hits = n + 1;
+} // static void sig_idx_insert_hit(S_M1_SigIdx_Search *psearch, uint16_t record, int16_t score)
@@ -0,0 +1,86 @@
+/* See COPYING.txt for license details. */
+
+/*
+*
+* m1_signal_index.h
+*
+* Header for the index of saved signals
+*
+* Every Sub-GHz, IR, NFC and LF RFID file saved by the device gets a fixed
+* size record in SIG_IDX_FILE with its path, protocol, frequency and UID, so
+* a search reads one small file instead of opening and parsing every
+* capture on the card. Files copied over USB are picked up by a rebuild,
+* which walks the signal folders once.
+*
+* The search is incremental: a query that extends the previous one only
+* filters the previous hits, as long as all of them fitted and no record
+* was written since.
+*
+* M1 Project
+*
+*/
+
+#ifndef M1_SIGNAL_INDEX_H_
+#define M1_SIGNAL_INDEX_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "ff.h"
+
+#define SIG_IDX_FILE			"0:/System/signals.idx"
+#define SIG_IDX_PATH_LEN		80	// Longer paths are not indexed
+#define SIG_IDX_PROTOCOL_LEN	16
+#define SIG_IDX_UID_LEN			24	// Hex digits without spaces
+#define SIG_IDX_QUERY_LEN		24
+#define SIG_IDX_MAX_HITS		64
+#define SIG_IDX_FREE			0xFF	// Type of a removed record
+
+typedef enum
+{
+	SIG_IDX_SUBGHZ = 0,
+	SIG_IDX_IR,
+	SIG_IDX_NFC,
+	SIG_IDX_RFID,
+	SIG_IDX_TYPES
+} S_M1_SigIdx_Type;
+
+typedef struct
+{
+	uint8_t type; // S_M1_SigIdx_Type or SIG_IDX_FREE
+	uint8_t unused[3];
+	uint32_t freq_hz; // Sub-GHz frequency or IR carrier, 0 if unknown
+	char protocol[SIG_IDX_PROTOCOL_LEN];
+	char uid[SIG_IDX_UID_LEN];
+	char path[SIG_IDX_PATH_LEN];
+} S_M1_SigIdx_Record;
+
+typedef struct
+{
+	uint16_t record;
+	int16_t score;
+} S_M1_SigIdx_Hit;
+
+typedef struct
+{
+	char query[SIG_IDX_QUERY_LEN];
+	bool complete; // Every match is in hits
+	uint32_t writes; // Changes to the index when the hits were found
+	uint16_t n_hits; // Best first
+	S_M1_SigIdx_Hit hits[SIG_IDX_MAX_HITS];
+} S_M1_SigIdx_Search;
+
+void m1_sig_idx_add(S_M1_SigIdx_Type type, const char *path, const char *protocol, uint32_t freq_hz, const uint8_t *uid, uint8_t uid_len);
+FRESULT m1_sig_idx_put(const S_M1_SigIdx_Record *prec);
+FRESULT m1_sig_idx_remove(const char *path);
+FRESULT m1_sig_idx_rename(const char *old_path, const char *new_path);
+FRESULT m1_sig_idx_read(uint16_t record, S_M1_SigIdx_Record *prec);
+uint16_t m1_sig_idx_records(void);
+FRESULT m1_sig_idx_rebuild(uint16_t *pcount);
+bool m1_sig_idx_parse_file(const char *path, S_M1_SigIdx_Type type, S_M1_SigIdx_Record *prec);
+void m1_sig_idx_search_reset(S_M1_SigIdx_Search *psearch);
+FRESULT m1_sig_idx_search(S_M1_SigIdx_Search *psearch, const char *query);
+int16_t m1_sig_idx_fuzzy_score(const char *query, const char *text);
+const char *m1_sig_idx_type_name(uint8_t type);
+void m1_sig_idx_format_freq(const S_M1_SigIdx_Record *prec, char *buf, uint8_t size);
+
+#endif /* M1_SIGNAL_INDEX_H_ */
@@ -16,10 +16,14 @@
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "stm32h5xx_hal.h"
 #include "main.h"
 #include "m1_sdcard.h"
 #include "m1_storage.h"
+#include "m1_file_util.h"
+#include "m1_signal_index.h"
+#include "m1_virtual_kb.h"
 
 /*************************** D E F I N E S ************************************/
 
@@ -33,6 +37,12 @@
 
 #define SDCARD_EXPLORE_FUNCTIONS_N				1
 
+#define SEARCH_GUI_ROWS							5
+#define SEARCH_GUI_ROW_SPACE					10
+#define SEARCH_GUI_FIRST_ROW_Y					20
+#define SEARCH_GUI_NAME_LEN_MAX					18	// 5 pixel font, the kind goes on the right
+#define SEARCH_GUI_LINE_LEN_MAX					(M1_LCD_DISPLAY_WIDTH/5)
+
 //************************** S T R U C T U R E S *******************************
 
 /***************************** C O N S T A N T S ******************************/
@@ -52,6 +62,8 @@ static const char *sdcard_explore_options[] = {
 
 /***************************** V A R I A B L E S ******************************/
 
+static S_M1_SigIdx_Search sig_search; // Kept between visits, the last query is shown again
+
 static char info_filename[ESP_FILE_NAME_LEN_MAX];
 static char info_filepath[ESP_FILE_PATH_LEN_MAX];
 
@@ -70,6 +82,11 @@ void storage_explore(void);
 void storage_mount(void);
 void storage_unmount(void);
 void storage_format(void);
+void storage_search(void);
+static void search_gui_update(uint8_t sel_item, uint8_t top_item);
+static void search_details_update(const S_M1_SigIdx_Record *prec);
+static void search_run(const char *query);
+static void search_rebuild(void);
 static void browse_gui_update(uint8_t sel_item, char *file_name);
 static void browse_info_box_update(uint8_t box_y, char *new_info);
 static uint8_t browse_refresh(S_M1_file_info **f_info);
@@ -348,6 +365,272 @@ void storage_explore(void)
 
 
 
+/*============================================================================*/
+/**
+  * @brief  Finds saved Sub-GHz, IR, NFC and RFID files by name, protocol,
+  *         frequency or UID, from the signal index
+  * @param  None
+  * @retval None
+  */
+/*============================================================================*/
+void storage_search(void)
+{
+	S_M1_Buttons_Status this_button_status;
+	S_M1_Main_Q_t q_item;
+	S_M1_SigIdx_Record rec;
+	BaseType_t ret;
+	uint8_t sel_item, top_item, uret;
+	bool details;
+	char query[SIG_IDX_QUERY_LEN];
+
+	uret = m1_sdcard_get_status();
+	if ( uret!=SD_access_OK )
+	{
+		m1_message_box(&m1_u8g2, "SD card not ready", NULL, " ", "BACK");
+		xQueueReset(main_q_hdl); // Reset main q before return
+		return;
+	} // if ( uret!=SD_access_OK )
+
+	// First use, or the card was swapped
+	if ( !m1_sig_idx_records() )
+		search_rebuild();
+	strcpy(query, sig_search.query);
+	search_run(query);
+
+	sel_item = 0;
+	top_item = 0;
+	details = false;
+	search_gui_update(sel_item, top_item);
+
+	while (1 ) // Main loop of this task
+	{
+		// Wait for the notification from button_event_handler_task to subfunc_handler_task.
+		ret = xQueueReceive(main_q_hdl, &q_item, portMAX_DELAY);
+		if ( ret!=pdTRUE || q_item.q_evt_type!=Q_EVENT_KEYPAD )
+			continue;
+
+		// Notification is only sent to this task when there's any button activity,
+		// so it doesn't need to wait when reading the event from the queue
+		ret = xQueueReceive(button_events_q_hdl, &this_button_status, 0);
+		if ( details ) // Any of these keys goes back to the list
+		{
+			if ( this_button_status.event[BUTTON_BACK_KP_ID]==BUTTON_EVENT_CLICK
+				|| this_button_status.event[BUTTON_OK_KP_ID]==BUTTON_EVENT_CLICK )
+			{
+				details = false;
+				search_gui_update(sel_item, top_item);
+			}
+			continue;
+		} // if ( details )
+
+		if ( this_button_status.event[BUTTON_BACK_KP_ID]==BUTTON_EVENT_CLICK ) // user wants to exit?
+		{
+			xQueueReset(main_q_hdl); // Reset main q before return
+			break; // Exit and return to the calling task (subfunc_handler_task)
+		} // if ( this_button_status.event[BUTTON_BACK_KP_ID]==BUTTON_EVENT_CLICK )
+		else if ( this_button_status.event[BUTTON_UP_KP_ID]==BUTTON_EVENT_CLICK ) // go up?
+		{
+			if ( sel_item )
+				sel_item--;
+			else if ( sig_search.n_hits )
+				sel_item = sig_search.n_hits - 1;
+		} // else if ( this_button_status.event[BUTTON_UP_KP_ID]==BUTTON_EVENT_CLICK )
+		else if ( this_button_status.event[BUTTON_DOWN_KP_ID]==BUTTON_EVENT_CLICK ) // go down?
+		{
+			sel_item++;
+			if ( sel_item >= sig_search.n_hits )
+				sel_item = 0;
+		} // else if ( this_button_status.event[BUTTON_DOWN_KP_ID]==BUTTON_EVENT_CLICK )
+		else if ( this_button_status.event[BUTTON_LEFT_KP_ID]==BUTTON_EVENT_CLICK ) // edit the query?
+		{
+			// The old query is the default, so adding to it narrows the last hits
+			if ( m1_vkb_get_filename("Search:", query, query) )
+				search_run(query);
+			sel_item = 0;
+		} // else if ( this_button_status.event[BUTTON_LEFT_KP_ID]==BUTTON_EVENT_CLICK )
+		else if ( this_button_status.event[BUTTON_RIGHT_KP_ID]==BUTTON_EVENT_CLICK ) // clear or rebuild?
+		{
+			// The keyboard cannot enter an empty query, clearing is here
+			if ( query[0] )
+				query[0] = '\0';
+			else
+				search_rebuild();
+			m1_sig_idx_search_reset(&sig_search);
+			search_run(query);
+			sel_item = 0;
+		} // else if ( this_button_status.event[BUTTON_RIGHT_KP_ID]==BUTTON_EVENT_CLICK )
+		else if ( this_button_status.event[BUTTON_OK_KP_ID]==BUTTON_EVENT_CLICK ) // details?
+		{
+			if ( sel_item < sig_search.n_hits
+				&& m1_sig_idx_read(sig_search.hits[sel_item].record, &rec)==FR_OK )
+			{
+				if ( fs_file_exists(rec.path)==1 )
+				{
+					search_details_update(&rec);
+					details = true;
+					continue;
+				}
+				// Deleted or renamed over USB
+				m1_sig_idx_remove(rec.path);
+				m1_sig_idx_search_reset(&sig_search);
+				search_run(query);
+				if ( sel_item >= sig_search.n_hits )
+					sel_item = 0;
+			} // if ( sel_item < sig_search.n_hits ... )
+		} // else if ( this_button_status.event[BUTTON_OK_KP_ID]==BUTTON_EVENT_CLICK )
+
+		// Keep the selection in the visible rows
+		if ( sel_item < top_item )
+			top_item = sel_item;
+		else if ( sel_item >= top_item + SEARCH_GUI_ROWS )
+			top_item = sel_item - SEARCH_GUI_ROWS + 1;
+		search_gui_update(sel_item, top_item);
+	} // while (1 ) // Main loop of this task
+} // void storage_search(void)
+
+
+
+/*============================================================================*/
+/**
+  * @brief  Draws the query and the visible hits
+  * @param  sel_item: selected hit
+  * @param  top_item: hit on the first row
+  * @retval None
+  */
+/*============================================================================*/
+static void search_gui_update(uint8_t sel_item, uint8_t top_item)
+{
+	S_M1_SigIdx_Record rec;
+	char line[SEARCH_GUI_LINE_LEN_MAX + 1];
+	const char *name;
+	char *dot;
+	uint8_t i, y;
+
+	m1_u8g2_firstpage(); // This call required for page drawing in mode 1
+	u8g2_SetDrawColor(&m1_u8g2, M1_DISP_DRAW_COLOR_TXT);
+	u8g2_SetFont(&m1_u8g2, M1_DISP_FUNC_MENU_FONT_N);
+	snprintf(line, sizeof(line), "Find:%s", sig_search.query[0] ? sig_search.query : "*");
+	u8g2_DrawStr(&m1_u8g2, 0, 8, line);
+	snprintf(line, sizeof(line), "%u%s", sig_search.n_hits, sig_search.complete ? "" : "+");
+	u8g2_DrawStr(&m1_u8g2, M1_LCD_DISPLAY_WIDTH - 5*strlen(line), 8, line);
+	u8g2_DrawHLine(&m1_u8g2, 0, 10, M1_LCD_DISPLAY_WIDTH);
+
+	if ( !sig_search.n_hits )
+	{
+		u8g2_DrawStr(&m1_u8g2, 2, SEARCH_GUI_FIRST_ROW_Y, "No match");
+		u8g2_DrawStr(&m1_u8g2, 2, SEARCH_GUI_FIRST_ROW_Y + 2*SEARCH_GUI_ROW_SPACE, "LEFT: edit query");
+		u8g2_DrawStr(&m1_u8g2, 2, SEARCH_GUI_FIRST_ROW_Y + 3*SEARCH_GUI_ROW_SPACE, "RIGHT: clear/reindex");
+	} // if ( !sig_search.n_hits )
+
+	y = SEARCH_GUI_FIRST_ROW_Y;
+	for ( i = top_item; i < sig_search.n_hits && i < top_item + SEARCH_GUI_ROWS; i++ )
+	{
+		if ( m1_sig_idx_read(sig_search.hits[i].record, &rec)!=FR_OK )
+			break;
+		name = strrchr(rec.path, '/');
+		name = (name!=NULL) ? name + 1 : rec.path;
+		snprintf(line, SEARCH_GUI_NAME_LEN_MAX + 1, "%s", name);
+		dot = strrchr(line, '.');
+		if ( dot!=NULL && dot!=line )
+			*dot = '\0';
+
+		if ( i==sel_item )
+		{
+			u8g2_DrawBox(&m1_u8g2, 0, y - SEARCH_GUI_ROW_SPACE + 2, M1_LCD_DISPLAY_WIDTH, SEARCH_GUI_ROW_SPACE);
+			u8g2_SetDrawColor(&m1_u8g2, M1_DISP_DRAW_COLOR_BG); // set to background color
+		}
+		u8g2_DrawStr(&m1_u8g2, 2, y, line);
+		u8g2_DrawStr(&m1_u8g2, M1_LCD_DISPLAY_WIDTH - 5*strlen(m1_sig_idx_type_name(rec.type)) - 1, y, m1_sig_idx_type_name(rec.type));
+		u8g2_SetDrawColor(&m1_u8g2, M1_DISP_DRAW_COLOR_TXT); // return to text color
+		y += SEARCH_GUI_ROW_SPACE;
+	} // for ( i = top_item; ... )
+
+	m1_u8g2_nextpage(); // Update display RAM
+} // static void search_gui_update(uint8_t sel_item, uint8_t top_item)
+
+
+
+/*============================================================================*/
+/**
+  * @brief  Draws what the index holds of a hit
+  * @param  prec: record of the hit
+  * @retval None
+  */
+/*============================================================================*/
+static void search_details_update(const S_M1_SigIdx_Record *prec)
+{
+	char line[SEARCH_GUI_LINE_LEN_MAX + 1], freq[16];
+	size_t len;
+
+	m1_sig_idx_format_freq(prec, freq, sizeof(freq));
+
+	m1_u8g2_firstpage(); // This call required for page drawing in mode 1
+	u8g2_SetDrawColor(&m1_u8g2, M1_DISP_DRAW_COLOR_TXT);
+	u8g2_SetFont(&m1_u8g2, M1_DISP_FUNC_MENU_FONT_N);
+	snprintf(line, sizeof(line), "%s %s", m1_sig_idx_type_name(prec->type), prec->protocol);
+	u8g2_DrawStr(&m1_u8g2, 0, 8, line);
+	if ( freq[0] )
+	{
+		snprintf(line, sizeof(line), "Freq: %s%s", freq, (prec->type==SIG_IDX_SUBGHZ) ? "MHz" : "");
+		u8g2_DrawStr(&m1_u8g2, 0, 20, line);
+	}
+	if ( prec->uid[0] )
+	{
+		snprintf(line, sizeof(line), "UID: %s", prec->uid);
+		u8g2_DrawStr(&m1_u8g2, 0, 30, line);
+	}
+
+	// The path over two lines, the end of a longer one is cut
+	len = strlen(prec->path);
+	snprintf(line, sizeof(line), "%s", prec->path);
+	u8g2_DrawStr(&m1_u8g2, 0, 44, line);
+	if ( len > SEARCH_GUI_LINE_LEN_MAX )
+	{
+		snprintf(line, sizeof(line), "%s", &prec->path[SEARCH_GUI_LINE_LEN_MAX]);
+		u8g2_DrawStr(&m1_u8g2, 0, 54, line);
+	}
+
+	m1_u8g2_nextpage(); // Update display RAM
+} // static void search_details_update(const S_M1_SigIdx_Record *prec)
+
+
+
+/*============================================================================*/
+/**
+  * @brief  Runs a query, narrowing the last hits when it extends the last query
+  * @param  query: text to find
+  * @retval None
+  */
+/*============================================================================*/
+static void search_run(const char *query)
+{
+	if ( m1_sig_idx_search(&sig_search, query)!=FR_OK )
+		m1_sig_idx_search_reset(&sig_search);
+} // static void search_run(const char *query)
+
+
+
+/*============================================================================*/
+/**
+  * @brief  Builds the signal index again from the files on the SD card
+  * @param  None
+  * @retval None
+  */
+/*============================================================================*/
+static void search_rebuild(void)
+{
+	m1_u8g2_firstpage(); // This call required for page drawing in mode 1
+	u8g2_SetDrawColor(&m1_u8g2, M1_DISP_DRAW_COLOR_TXT);
+	u8g2_SetFont(&m1_u8g2, M1_DISP_FUNC_MENU_FONT_N);
+	u8g2_DrawStr(&m1_u8g2, 2, 30, "Indexing signals...");
+	m1_u8g2_nextpage(); // Update display RAM
+
+	m1_sig_idx_rebuild(NULL);
+	m1_sig_idx_search_reset(&sig_search);
+} // static void search_rebuild(void)
+
+
+
 /*============================================================================*/
 /**
   * @brief
@@ -25,6 +25,7 @@ void storage_explore(void);
 void storage_mount(void);
 void storage_unmount(void);
 void storage_format(void);
+void storage_search(void);
 S_M1_file_info *storage_browse(void);
 
 #endif /* M1_STORAGE_H_ */
@@ -23,8 +23,11 @@
 #include <string.h>
 
 // #include "m1_sub_ghz.h"
+#include "m1_cdc_stream.h"
+#include "m1_file_util.h"
 #include "m1_ring_buffer.h"
 #include "m1_sdcard_man.h"
+#include "m1_signal_index.h"
 #include "m1_storage.h"
 #include "m1_sub_ghz_decenc.h"
 #include "uiView.h"
@@ -260,8 +263,11 @@ volatile uint8_t subghz_rx_dma_block_tail = 0;
 volatile uint8_t subghz_rx_dma_block_count = 0;
 static uint32_t subghz_rx_dma_buffer[SUBGHZ_RX_DMA_BUFFER_SAMPLES]
     __attribute__((aligned(32)));
+// Pulse widths of one DMA block, moved to subghz_rx_rawdata_rb in one write
+static uint16_t subghz_rx_dma_pulses[SUBGHZ_RX_DMA_BLOCK_SAMPLES];
 static uint32_t subghz_rx_dma_prev_capture = 0;
 static bool subghz_rx_dma_have_prev_capture = false;
+static bool subghz_rx_stream_level; // Level of the next pulse on the USB stream
 static uint8_t subghz_uiview_gui_latest_param;
 static uint8_t subghz_replay_ret_code;
 static uint8_t subghz_replay_mod;
@@ -292,6 +298,7 @@ static void sub_ghz_rx_deinit(void);
 static uint8_t sub_ghz_ring_buffers_init(void);
 static void sub_ghz_ring_buffers_deinit(void);
 static uint8_t sub_ghz_rx_raw_save(bool header_init, bool last_data);
+static void sub_ghz_rx_raw_index(void);
 static void sub_ghz_tx_raw_init(void);
 static void sub_ghz_tx_raw_deinit(void);
 
@@ -777,13 +784,14 @@ static void subghz_rx_dma_process_blocks(void) {
     uint32_t start = (block_id == 0U) ? 0U : SUBGHZ_RX_DMA_BLOCK_SAMPLES;
     uint32_t end = start + SUBGHZ_RX_DMA_BLOCK_SAMPLES;
     uint32_t idx;
+    uint16_t n_pulses = 0;
+    uint16_t n_written;
 
     subghz_rx_dma_invalidate_block(start, SUBGHZ_RX_DMA_BLOCK_SAMPLES);
 
     for (idx = start; idx < end; idx++) {
       uint32_t cur_capture = subghz_rx_dma_buffer[idx];
       uint32_t pulse_width;
-      uint16_t pulse16;
 
       if (!subghz_rx_dma_have_prev_capture) {
         subghz_rx_dma_prev_capture = cur_capture;
@@ -806,14 +814,22 @@ static void subghz_rx_dma_process_blocks(void) {
       if (pulse_width > 0xFFFFU) {
         pulse_width = 0xFFFFU;
       }
-      if (ringbuffer_get_empty_slots(&subghz_rx_rawdata_rb) == 0U) {
-        subghz_rx_queue_drop_count++;
-        continue;
-      }
-      pulse16 = (uint16_t)pulse_width;
-      m1_ringbuffer_insert(&subghz_rx_rawdata_rb, (uint8_t *)&pulse16);
+      subghz_rx_dma_pulses[n_pulses++] = (uint16_t)pulse_width;
+    }
+
+    // Pulses that do not fit in the ring buffer are dropped and counted
+    n_written = m1_ringbuffer_write(&subghz_rx_rawdata_rb,
+                                    (const uint8_t *)subghz_rx_dma_pulses,
+                                    n_pulses);
+    subghz_rx_queue_drop_count += (uint32_t)(n_pulses - n_written);
+
+    if (m1_cdc_stream_source() == CDC_STREAM_SRC_SUBGHZ) {
+      subghz_rx_stream_level = m1_cdc_stream_put_pulses(
+          subghz_rx_dma_pulses, n_pulses, subghz_rx_stream_level);
     }
   }
+  if (m1_cdc_stream_source() == CDC_STREAM_SRC_SUBGHZ)
+    m1_cdc_stream_flush(false);
 
   while (1) {
     rcv_samples = ringbuffer_get_data_slots(&subghz_rx_rawdata_rb);
@@ -857,9 +873,11 @@ static int subghz_record_gui_message(void) {
       M1_LOG_N(M1_LOGDB_TAG, "Raw samples %lu\r\n", (unsigned long)rcv_samples);
       if (subghz_uiview_gui_latest_param ==
           SUBGHZ_RECORD_DISPLAY_PARAM_ACTIVE) {
-        subghz_record_gui_update(SUBGHZ_RECORD_DISPLAY_PARAM_ACTIVE);
+        // Counters of a burst of blocks are shown once per frame
+        m1_uiView_display_invalidate(SUBGHZ_RECORD_DISPLAY_PARAM_ACTIVE);
       }
-      vTaskDelay(10);
+    } else if (q_item.q_evt_type == Q_EVENT_UI_REDRAW) {
+      m1_uiView_display_redraw();
     } else if (q_item.q_evt_type == Q_EVENT_SUBGHZ_TX) {
       subghz_replay_ret_code = sub_ghz_replay_continue(subghz_replay_ret_code);
       if (subghz_replay_ret_code == SUB_GHZ_RAW_DATA_PARSER_IDLE) {
@@ -905,8 +923,11 @@ static int subghz_record_kp_handler(void) {
           sub_ghz_rx_raw_save(false, true);
           last_data_saved = true;
         } // if ( !last_data_saved )
+        if (m1_cdc_stream_source() == CDC_STREAM_SRC_SUBGHZ)
+          m1_cdc_stream_flush(true); // Last samples of the capture stream
         m1_sdm_task_stop(); // Stop sampling raw data and flush data to SD card
         m1_sdm_task_deinit();
+        sub_ghz_rx_raw_index();
         sub_ghz_set_opmode(SUB_GHZ_OPMODE_ISOLATED, subghz_scan_config.band, 0,
                            0);
 
@@ -995,8 +1016,11 @@ static int subghz_record_kp_handler(void) {
           sub_ghz_rx_raw_save(false, true);
           last_data_saved = true;
         } // if ( !last_data_saved )
+        if (m1_cdc_stream_source() == CDC_STREAM_SRC_SUBGHZ)
+          m1_cdc_stream_flush(true); // Last samples of the capture stream
         m1_sdm_task_stop(); // Stop sampling raw data and flush data to SD card
         m1_sdm_task_deinit();
+        sub_ghz_rx_raw_index();
         sub_ghz_set_opmode(SUB_GHZ_OPMODE_ISOLATED, subghz_scan_config.band, 0,
                            0);
 
@@ -1917,6 +1941,9 @@ static void sub_ghz_rx_init(void) {
 static void sub_ghz_rx_start(void) {
   subghz_rx_dma_prev_capture = 0;
   subghz_rx_dma_have_prev_capture = false;
+  subghz_rx_stream_level = true; // Captures start with a high pulse
+  m1_cdc_stream_set_info(
+      (uint32_t)(subghz_band_steps[subghz_scan_config.band][0] * 1000000));
   subghz_rx_queue_notify_pending = 0;
   subghz_rx_dma_ht_count = 0;
   subghz_rx_dma_tc_count = 0;
@@ -2747,6 +2774,27 @@ cleanup:
   return 0;
 } // static uint8_t sub_ghz_rx_raw_save(bool header_init, bool last_data)
 
+/*============================================================================*/
+/**
+ * @brief  Adds the recording just closed by the SD card task to the signal
+ *         index, with the frequency written in its header
+ * @param  None
+ * @retval None
+ */
+/*============================================================================*/
+static void sub_ghz_rx_raw_index(void) {
+  uint32_t freq32;
+
+  // Nothing to index when the file could not be created or was dropped
+  if (fs_file_exists((char *)datfile_info.dat_filename) != 1)
+    return;
+
+  freq32 = subghz_band_steps[subghz_scan_config.band][0] *
+           1000000; // Convert frequency from MHz to Hz
+  m1_sig_idx_add(SIG_IDX_SUBGHZ, (char *)datfile_info.dat_filename, "RAW",
+                 freq32, NULL, 0);
+} // static void sub_ghz_rx_raw_index(void)
+
 /*============================================================================*/
 /**
  * @brief Init the raw samples for replay
@@ -26,6 +26,7 @@
 #include "m1_esp32_hal.h"
 #include "battery.h"
 #include "m1_gpio.h"
+#include "m1_low_power.h"
 #include "m1_log_debug.h"
 /*************************** D E F I N E S ************************************/
 
@@ -61,6 +62,7 @@ void m1_system_init(void)
 	size_t free_heap;
 
 	m1_system_GPIO_init();
+	m1_low_power_init();
 
 	ret = xTaskCreate(m1_system_init_task, "m1_system_init_task_n", M1_TASK_STACK_SIZE_DEFAULT, NULL, TASK_PRIORITY_SYS_INIT, &sys_init_task_hdl);
 	(void)ret; /* Unused: result checked via assert. May need removal later. */
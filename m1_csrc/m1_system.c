@@ -91,8 +91,13 @@ void system_periodic_task(void *param) {
   uint8_t this_button_level, i;
   uint8_t event_change;
 
+  static uint8_t button_events_q_storage[sizeof(S_M1_Buttons_Status)];
+  static StaticQueue_t button_events_q_ctrl;
+
   // Create Queue.
-  button_events_q_hdl = xQueueCreate(1, sizeof(S_M1_Buttons_Status));
+  button_events_q_hdl =
+      xQueueCreateStatic(1, sizeof(S_M1_Buttons_Status),
+                         button_events_q_storage, &button_events_q_ctrl);
   assert(button_events_q_hdl != NULL);
 
   while (TRUE) {
@@ -415,13 +420,10 @@ static void battery_indicator_update(void) {
   S_M1_Power_Status_t SystemPowerStatus;
   uint8_t new_stat, running_id;
   static uint8_t old_stat = 0xFF;
-  static uint16_t batt_info_timer_count = 0;
 
-  batt_info_timer_count += SYSTEM_PERIODIC_TASK_DELAY;
-  if (batt_info_timer_count >= TASKDELAY_BATTERY_INFO_TIMER) {
-    batt_info_timer_count = 0;
-    battery_status_update();
-  } // if ( batt_info_timer_count >= TASKDELAY_BATTERY_INFO_TIMER )
+  // Only this task reads the gauge, everyone else gets the snapshot
+  if (!battery_status_poll())
+    return;
 
   battery_power_status_get(&SystemPowerStatus);
 
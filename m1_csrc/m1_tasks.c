@@ -20,6 +20,8 @@
 #include "lfrfid.h"
 //#include "m1_nfc.h"
 #include "nfc_driver.h"
+#include "m1_fusb302.h"
+#include "m1_wifi.h"
 
 /*************************** D E F I N E S ************************************/
 
@@ -28,10 +30,27 @@
 #define MAIN_QUEUE_ITEMS_MAX_N				256
 #define SDCARD_DET_QUEUE_ITEMS_MAX_N		10
 
+#define SYSTEM_TASK_STACK_DEPTH				M1_TASK_STACK_SIZE_DEFAULT
+#define SDCARD_TASK_STACK_DEPTH				M1_TASK_STACK_SIZE_DEFAULT
+#define MENU_MAIN_TASK_STACK_DEPTH			M1_TASK_STACK_SIZE_1024
+#define SUBFUNC_TASK_STACK_DEPTH			M1_TASK_STACK_SIZE_4096
+#define LOG_DB_TASK_STACK_DEPTH				M1_TASK_STACK_SIZE_1024
+#define IDLE_HANDLER_TASK_STACK_DEPTH		M1_TASK_STACK_SIZE_0512
+#define RUNONCE_TASK_STACK_DEPTH			M1_TASK_STACK_SIZE_0512
+#define SER2USB_TASK_STACK_DEPTH			M1_TASK_STACK_SIZE_2048
+#define USB_PD_TASK_STACK_DEPTH				M1_TASK_STACK_SIZE_0512
+#define WIFI_STA_TASK_STACK_DEPTH			M1_TASK_STACK_SIZE_1024
+
 //************************** C O N S T A N T **********************************/
 
 //************************** S T R U C T U R E S *******************************
 
+typedef struct
+{
+	TaskHandle_t *task_hdl;
+	uint16_t stack_depth; // 32-bit words
+} S_M1_Task_Stack_t;
+
 /***************************** V A R I A B L E S ******************************/
 
 extern IWDG_HandleTypeDef hiwdg;
@@ -46,9 +65,53 @@ QueueHandle_t	main_q_hdl;
 QueueHandle_t	sdcard_det_q_hdl;
 TaskHandle_t	runonce_task_hdl;
 
+// Static storage of the system queues and tasks: their RAM use is fixed at link time
+// and they never take (or fragment) the FreeRTOS heap
+static uint8_t			main_q_storage[MAIN_QUEUE_ITEMS_MAX_N*sizeof(S_M1_Main_Q_t)];
+static StaticQueue_t	main_q_ctrl;
+static uint8_t			sdcard_det_q_storage[SDCARD_DET_QUEUE_ITEMS_MAX_N*sizeof(S_M1_SdCard_Q_t)];
+static StaticQueue_t	sdcard_det_q_ctrl;
+
+static StackType_t		system_task_stack[SYSTEM_TASK_STACK_DEPTH];
+static StaticTask_t		system_task_tcb;
+static StackType_t		sdcard_task_stack[SDCARD_TASK_STACK_DEPTH];
+static StaticTask_t		sdcard_task_tcb;
+static StackType_t		menu_main_task_stack[MENU_MAIN_TASK_STACK_DEPTH];
+static StaticTask_t		menu_main_task_tcb;
+static StackType_t		subfunc_task_stack[SUBFUNC_TASK_STACK_DEPTH];
+static StaticTask_t		subfunc_task_tcb;
+static StackType_t		log_db_task_stack[LOG_DB_TASK_STACK_DEPTH];
+static StaticTask_t		log_db_task_tcb;
+static StackType_t		idle_handler_task_stack[IDLE_HANDLER_TASK_STACK_DEPTH];
+static StaticTask_t		idle_handler_task_tcb;
+static StackType_t		runonce_task_stack[RUNONCE_TASK_STACK_DEPTH];
+static StaticTask_t		runonce_task_tcb;
+static StackType_t		ser2usb_task_stack[SER2USB_TASK_STACK_DEPTH];
+static StaticTask_t		ser2usb_task_tcb;
+static StackType_t		usb_pd_task_stack[USB_PD_TASK_STACK_DEPTH];
+static StaticTask_t		usb_pd_task_tcb;
+static StackType_t		wifi_sta_task_stack[WIFI_STA_TASK_STACK_DEPTH];
+static StaticTask_t		wifi_sta_task_tcb;
+
+// Stack depth of the tasks created in m1_tasks_init(), FreeRTOS does not report it
+static const S_M1_Task_Stack_t m1_task_stacks[] =
+{
+	{&system_task_hdl,				SYSTEM_TASK_STACK_DEPTH},
+	{&sdcard_task_hdl,				SDCARD_TASK_STACK_DEPTH},
+	{&menu_main_handler_task_hdl,	MENU_MAIN_TASK_STACK_DEPTH},
+	{&subfunc_handler_task_hdl,		SUBFUNC_TASK_STACK_DEPTH},
+	{&log_db_task_hdl,				LOG_DB_TASK_STACK_DEPTH},
+	{&idle_task_hdl,				IDLE_HANDLER_TASK_STACK_DEPTH},
+	{&runonce_task_hdl,				RUNONCE_TASK_STACK_DEPTH},
+	{&usb2ser_task_hdl,				SER2USB_TASK_STACK_DEPTH},
+	{&usb_pd_task_hdl,				USB_PD_TASK_STACK_DEPTH},
+	{&wifi_sta_task_hdl,			WIFI_STA_TASK_STACK_DEPTH}
+};
+
 /********************* F U N C T I O N   P R O T O T Y P E S ******************/
 
 void m1_tasks_init(void);
+uint32_t m1_task_stack_depth(TaskHandle_t task);
 void vApplicationIdleHook(void);
 void vApplicationStackOverflowHook(TaskHandle_t xTask, char *pcTaskName);
 void vApplicationMallocFailedHook(void);
@@ -66,77 +129,84 @@ void m1_runonce_task_handler(void *param);
 /*============================================================================*/
 void m1_tasks_init(void)
 {
-	BaseType_t ret;
 	size_t free_heap;
 
-	main_q_hdl = xQueueCreate(MAIN_QUEUE_ITEMS_MAX_N, sizeof(S_M1_Main_Q_t));
+	main_q_hdl = xQueueCreateStatic(MAIN_QUEUE_ITEMS_MAX_N, sizeof(S_M1_Main_Q_t), main_q_storage, &main_q_ctrl);
 	assert(main_q_hdl != NULL);
 
-	sdcard_det_q_hdl = xQueueCreate(SDCARD_DET_QUEUE_ITEMS_MAX_N, sizeof(S_M1_SdCard_Q_t));
+	sdcard_det_q_hdl = xQueueCreateStatic(SDCARD_DET_QUEUE_ITEMS_MAX_N, sizeof(S_M1_SdCard_Q_t), sdcard_det_q_storage, &sdcard_det_q_ctrl);
 	assert(sdcard_det_q_hdl != NULL);
 
 	dummyTimerHandle = osTimerNew(m1_dummytimer_task, osTimerOnce, NULL, &dumyTimer_attributes);
 
-	ret = xTaskCreate(system_periodic_task, "system_periodic_task_n", M1_TASK_STACK_SIZE_DEFAULT, NULL, TASK_PRIORITY_SYSTEM_TASK_HANDLER, &system_task_hdl);
-	(void)ret; /* Unused: result checked via assert. May need removal later. */
-	assert(ret==pdPASS);
+	system_task_hdl = xTaskCreateStatic(system_periodic_task, "system_periodic_task_n", SYSTEM_TASK_STACK_DEPTH, NULL,
+										TASK_PRIORITY_SYSTEM_TASK_HANDLER, system_task_stack, &system_task_tcb);
 	assert(system_task_hdl!=NULL);
-	free_heap = xPortGetFreeHeapSize(); // xPortGetMinimumEverFreeHeapSize()
-	(void)free_heap; /* Unused: result checked via assert. May need removal later. */
-	assert(free_heap >= M1_LOW_FREE_HEAP_WARNING_SIZE);
 
-	ret = xTaskCreate(sdcard_detection_task, "sdcard_detection_task_n", M1_TASK_STACK_SIZE_DEFAULT, NULL, TASK_PRIORITY_SDCARD_HANDLER, &sdcard_task_hdl);
-	(void)ret; /* Unused: result checked via assert. May need removal later. */
-	assert(ret==pdPASS);
-	assert(system_task_hdl!=NULL);
-	free_heap = xPortGetFreeHeapSize();
-	(void)free_heap; /* Unused: result checked via assert. May need removal later. */
-	assert(free_heap >= M1_LOW_FREE_HEAP_WARNING_SIZE);
+	sdcard_task_hdl = xTaskCreateStatic(sdcard_detection_task, "sdcard_detection_task_n", SDCARD_TASK_STACK_DEPTH, NULL,
+										TASK_PRIORITY_SDCARD_HANDLER, sdcard_task_stack, &sdcard_task_tcb);
+	assert(sdcard_task_hdl!=NULL);
 
-	ret = xTaskCreate(menu_main_handler_task, "menu_main_handler_task_n", M1_TASK_STACK_SIZE_1024/*M1_TASK_STACK_SIZE_DEFAULT*/, NULL, TASK_PRIORITY_MENU_MAIN_HANDLER, &menu_main_handler_task_hdl);
-	(void)ret; /* Unused: result checked via assert. May need removal later. */
-	assert(ret==pdPASS);
+	menu_main_handler_task_hdl = xTaskCreateStatic(menu_main_handler_task, "menu_main_handler_task_n", MENU_MAIN_TASK_STACK_DEPTH, NULL,
+										TASK_PRIORITY_MENU_MAIN_HANDLER, menu_main_task_stack, &menu_main_task_tcb);
 	assert(menu_main_handler_task_hdl!=NULL);
-	free_heap = xPortGetFreeHeapSize();
-	(void)free_heap; /* Unused: result checked via assert. May need removal later. */
-	assert(free_heap >= M1_LOW_FREE_HEAP_WARNING_SIZE);
 
-	ret = xTaskCreate(subfunc_handler_task, "subfunc_handler_task_n", M1_TASK_STACK_SIZE_4096, NULL, TASK_PRIORITY_SUBFUNC_HANDLER, &subfunc_handler_task_hdl);
-	(void)ret; /* Unused: result checked via assert. May need removal later. */
-	assert(ret==pdPASS);
+	subfunc_handler_task_hdl = xTaskCreateStatic(subfunc_handler_task, "subfunc_handler_task_n", SUBFUNC_TASK_STACK_DEPTH, NULL,
+										TASK_PRIORITY_SUBFUNC_HANDLER, subfunc_task_stack, &subfunc_task_tcb);
 	assert(subfunc_handler_task_hdl!=NULL);
-	free_heap = xPortGetFreeHeapSize();
-	(void)free_heap; /* Unused: result checked via assert. May need removal later. */
-	assert(free_heap >= M1_LOW_FREE_HEAP_WARNING_SIZE);
 
-	ret = xTaskCreate(log_db_handler_task, "log_db_handler_task_n", M1_TASK_STACK_SIZE_1024, NULL, TASK_PRIORITY_LOG_DB_HANDLER, &log_db_task_hdl);
-	(void)ret; /* Unused: result checked via assert. May need removal later. */
-	assert(ret==pdPASS);
+	log_db_task_hdl = xTaskCreateStatic(log_db_handler_task, "log_db_handler_task_n", LOG_DB_TASK_STACK_DEPTH, NULL,
+										TASK_PRIORITY_LOG_DB_HANDLER, log_db_task_stack, &log_db_task_tcb);
 	assert(log_db_task_hdl!=NULL);
-	free_heap = xPortGetFreeHeapSize();
-	assert(free_heap >= M1_LOW_FREE_HEAP_WARNING_SIZE);
 
-	ret = xTaskCreate(idle_handler_task, "idle_handler_task_n", M1_TASK_STACK_SIZE_0512, NULL, TASK_PRIORITY_IDLE_HANDLER, &idle_task_hdl);
-	assert(ret==pdPASS);
+	idle_task_hdl = xTaskCreateStatic(idle_handler_task, "idle_handler_task_n", IDLE_HANDLER_TASK_STACK_DEPTH, NULL,
+										TASK_PRIORITY_IDLE_HANDLER, idle_handler_task_stack, &idle_handler_task_tcb);
 	assert(idle_task_hdl!=NULL);
-	free_heap = xPortGetFreeHeapSize();
-	assert(free_heap >= M1_LOW_FREE_HEAP_WARNING_SIZE);
 
-	ret = xTaskCreate(m1_runonce_task_handler, "m1_runonce_task_n", M1_TASK_STACK_SIZE_0512, NULL, TASK_PRIORITY_RUNONCE_TASK_HANDLER, &runonce_task_hdl);
-	assert(ret==pdPASS);
+	runonce_task_hdl = xTaskCreateStatic(m1_runonce_task_handler, "m1_runonce_task_n", RUNONCE_TASK_STACK_DEPTH, NULL,
+										TASK_PRIORITY_RUNONCE_TASK_HANDLER, runonce_task_stack, &runonce_task_tcb);
 	assert(runonce_task_hdl!=NULL);
-	free_heap = xPortGetFreeHeapSize();
-	assert(free_heap >= M1_LOW_FREE_HEAP_WARNING_SIZE);
 
-	ret = xTaskCreate(vSer2UsbTask, "m1_ser2usb_task_n", M1_TASK_STACK_SIZE_2048, NULL, TASK_PRIORITY_RUNONCE_TASK_HANDLER, &usb2ser_task_hdl);
-	assert(ret==pdPASS);
+	usb2ser_task_hdl = xTaskCreateStatic(vSer2UsbTask, "m1_ser2usb_task_n", SER2USB_TASK_STACK_DEPTH, NULL,
+										TASK_PRIORITY_RUNONCE_TASK_HANDLER, ser2usb_task_stack, &ser2usb_task_tcb);
 	assert(usb2ser_task_hdl!=NULL);
+
+	usb_pd_task_hdl = xTaskCreateStatic(usb_pd_task, "m1_usb_pd_task_n", USB_PD_TASK_STACK_DEPTH, NULL,
+										TASK_PRIORITY_USB_PD_HANDLER, usb_pd_task_stack, &usb_pd_task_tcb);
+	assert(usb_pd_task_hdl!=NULL);
+
+	wifi_sta_task_hdl = xTaskCreateStatic(wifi_sta_task, "m1_wifi_sta_task_n", WIFI_STA_TASK_STACK_DEPTH, NULL,
+										TASK_PRIORITY_WIFI_STA_HANDLER, wifi_sta_task_stack, &wifi_sta_task_tcb);
+	assert(wifi_sta_task_hdl!=NULL);
+
+	// The system tasks no longer come from the heap, it is left for the applications
 	free_heap = xPortGetFreeHeapSize();
+	(void)free_heap; /* Unused: result checked via assert. May need removal later. */
 	assert(free_heap >= M1_LOW_FREE_HEAP_WARNING_SIZE);
 } // void m1_tasks_init(void)
 
 
 
+/*============================================================================*/
+/*
+ * This function returns the stack depth (32-bit words) a task was created with,
+ * or 0 if the task was not created by m1_tasks_init().
+ */
+/*============================================================================*/
+uint32_t m1_task_stack_depth(TaskHandle_t task)
+{
+	uint8_t i;
+
+	for (i=0; i<sizeof(m1_task_stacks)/sizeof(m1_task_stacks[0]); i++)
+	{
+		if ( task!=NULL && *m1_task_stacks[i].task_hdl==task )
+			return m1_task_stacks[i].stack_depth;
+	}
+	return 0;
+} // uint32_t m1_task_stack_depth(TaskHandle_t task)
+
+
+
 /*============================================================================*/
 /*
  * This task is called by the OS when the system is in idle state.
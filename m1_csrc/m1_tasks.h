@@ -40,6 +40,7 @@
 #define TASK_PRIORITY_RUNONCE_TASK_HANDLER		(tskIDLE_PRIORITY + 1)
 #define TASK_PRIORITY_IDLE_HANDLER				(tskIDLE_PRIORITY + 1)
 #define TASK_PRIORITY_LOG_DB_HANDLER			(tskIDLE_PRIORITY + 3)
+#define TASK_PRIORITY_WIFI_STA_HANDLER			(tskIDLE_PRIORITY + 3) // Below the apps sharing the AT link with it
 #define TASK_PRIORITY_CLI_HANDLER				(tskIDLE_PRIORITY + 5)
 #define TASK_PRIORITY_MENU_MAIN_HANDLER			(tskIDLE_PRIORITY + 8)
 #define TASK_PRIORITY_SDCARD_HANDLER			(tskIDLE_PRIORITY + 10)
@@ -47,6 +48,7 @@
 #define TASK_PRIORITY_ESP32_TASKS				(tskIDLE_PRIORITY + 10)
 #define TASK_PRIORITY_SYSTEM_TASK_HANDLER		(tskNORMAL_PRIORITY + 0) // Must be at this priority for the Sub-GHz samples recording to work properly!
 #define TASK_PRIORITY_SUBFUNC_HANDLER			(tskNORMAL_PRIORITY + 0)
+#define TASK_PRIORITY_USB_PD_HANDLER			(tskNORMAL_PRIORITY + 1) // Answers within the 30ms tSenderResponse
 #define TASK_PRIORITY_SYS_INIT					(tskNORMAL_PRIORITY + 10) // Must be highest priority for all tasks
 
 #define TASKDELAY_SDCARD_DET_TASK				700 // ms, for SD card detection debouncing
@@ -99,6 +101,7 @@ typedef enum
 	Q_EVENT_BATTERY_UPDATED,
 	Q_EVENT_MENU_EXIT,
 	Q_EVENT_MENU_TIMEOUT,
+	Q_EVENT_UI_REDRAW, // A frame put off by m1_uiView_display_invalidate() is due
 	Q_EVENT_EOL
 } S_M1_Q_Event_Type_t;
 
@@ -136,6 +139,7 @@ typedef struct
 } S_M1_SdCardManager_Q_t;
 
 void m1_tasks_init(void);
+uint32_t m1_task_stack_depth(TaskHandle_t task);
 void vApplicationIdleHook(void);
 void m1_dummy_task(void *argument);
 
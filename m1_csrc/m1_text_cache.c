@@ -0,0 +1,263 @@
+/* See COPYING.txt for license details. */
+
+/*
+*
+* m1_text_cache.c
+*
+* Text run cache: strings rasterised once, blitted every frame
+*
+* M1 Project
+*
+*/
+
+/*************************** I N C L U D E S **********************************/
+
+#include <string.h>
+#include "m1_text_cache.h"
+
+/*************************** D E F I N E S ************************************/
+
+#define FNV_OFFSET_BASIS	0x811C9DC5u
+#define FNV_PRIME			0x01000193u
+
+//************************** C O N S T A N T **********************************/
+
+//************************** S T R U C T U R E S *******************************
+
+/***************************** V A R I A B L E S ******************************/
+
+/********************* F U N C T I O N   P R O T O T Y P E S ******************/
+
+void m1_text_cache_init(S_M1_Text_Cache *pc, m1_text_render_fn render);
+const S_M1_Text_Run *m1_text_cache_get(S_M1_Text_Cache *pc, const void *font, const char *str);
+void m1_text_cache_flush(S_M1_Text_Cache *pc);
+void m1_text_run_blit(const S_M1_Text_Run *prun, uint8_t *pbuf, uint16_t buf_w, uint16_t buf_h,
+						int16_t x, int16_t y, uint8_t color, bool solid, bool rot180);
+static uint32_t text_hash(const char *str, uint8_t *plen);
+static void text_run_trim(S_M1_Text_Run *prun);
+static void text_page_paint(uint8_t *pdst, uint8_t mask, uint8_t color);
+static uint8_t text_bits_reverse(uint8_t b);
+static void text_column_paint(uint8_t *pbuf, uint16_t buf_w, uint16_t buf_pages, int16_t page, int16_t x,
+								uint8_t back, uint8_t ink, uint8_t bg_color, uint8_t color, bool rot180);
+
+/*************** F U N C T I O N   I M P L E M E N T A T I O N ****************/
+
+void m1_text_cache_init(S_M1_Text_Cache *pc, m1_text_render_fn render)
+{
+	memset(pc, 0, sizeof(*pc));
+	pc->render = render;
+} // void m1_text_cache_init(S_M1_Text_Cache *pc, m1_text_render_fn render)
+
+
+
+// FNV-1a over the string; *plen is 0 if the string is too long to be cached
+static uint32_t text_hash(const char *str, uint8_t *plen)
+{
+	uint32_t hash = FNV_OFFSET_BASIS;
+	uint8_t len = 0;
+
+	while ( *str )
+	{
+		if ( len==M1_TEXT_CACHE_STR_MAX )
+		{
+			*plen = 0;
+			return 0;
+		}
+		hash ^= (uint8_t)*str++;
+		hash *= FNV_PRIME;
+		len++;
+	}
+	*plen = len;
+
+	return hash;
+} // static uint32_t text_hash(const char *str, uint8_t *plen)
+
+
+
+// Clears what the renderer left below the run or right of it
+static void text_run_trim(S_M1_Text_Run *prun)
+{
+	uint8_t page, rows;
+
+	for (page=0; page<M1_TEXT_CACHE_RUN_PAGES; page++)
+	{
+		if ( prun->h <= page*8 )
+			rows = 0;
+		else if ( prun->h >= (page + 1)*8 )
+			rows = 8;
+		else
+			rows = prun->h - page*8;
+
+		if ( rows < 8 )
+		{
+			uint8_t keep = (uint8_t)((1u << rows) - 1);
+			uint8_t col;
+
+			for (col=0; col<prun->w; col++)
+			{
+				prun->ink[page][col] &= keep;
+				prun->box[page][col] &= keep;
+			}
+		}
+		memset(&prun->ink[page][prun->w], 0, M1_TEXT_CACHE_RUN_W_MAX - prun->w);
+		memset(&prun->box[page][prun->w], 0, M1_TEXT_CACHE_RUN_W_MAX - prun->w);
+	} // for (page=0; ...)
+} // static void text_run_trim(S_M1_Text_Run *prun)
+
+
+
+/*============================================================================*/
+/*
+ * This function returns the run of str drawn with font, rendering it into the
+ * least recently used slot on a miss. It returns NULL if the string cannot be
+ * cached: the caller draws it the slow way.
+ */
+/*============================================================================*/
+const S_M1_Text_Run *m1_text_cache_get(S_M1_Text_Cache *pc, const void *font, const char *str)
+{
+	S_M1_Text_Slot *pslot, *pvictim;
+	uint32_t hash;
+	uint8_t len, i;
+
+	hash = text_hash(str, &len);
+	if ( !len || !pc->render )
+	{
+		pc->bypasses++;
+		return NULL;
+	}
+
+	pvictim = &pc->slot[0];
+	for (i=0; i<M1_TEXT_CACHE_SLOTS; i++)
+	{
+		pslot = &pc->slot[i];
+		if ( pslot->used && pslot->font==font && pslot->hash==hash && !strcmp(pslot->str, str) )
+		{
+			pslot->used = ++pc->clock;
+			pc->hits++;
+			return &pslot->run;
+		}
+		if ( pslot->used < pvictim->used )
+			pvictim = pslot;
+	} // for (i=0; ...)
+
+	pc->misses++;
+	pvictim->used = 0;
+	memset(&pvictim->run, 0, sizeof(pvictim->run));
+	if ( !pc->render(font, str, &pvictim->run) || pvictim->run.w > M1_TEXT_CACHE_RUN_W_MAX
+			|| pvictim->run.h > M1_TEXT_CACHE_RUN_PAGES*8 )
+	{
+		pc->bypasses++;
+		return NULL;
+	}
+	text_run_trim(&pvictim->run);
+
+	pvictim->font = font;
+	pvictim->hash = hash;
+	memcpy(pvictim->str, str, len + 1);
+	pvictim->used = ++pc->clock;
+
+	return &pvictim->run;
+} // const S_M1_Text_Run *m1_text_cache_get(S_M1_Text_Cache *pc, const void *font, const char *str)
+
+
+
+// Drops all runs, the fonts or the renderer have changed
+void m1_text_cache_flush(S_M1_Text_Cache *pc)
+{
+	uint8_t i;
+
+	for (i=0; i<M1_TEXT_CACHE_SLOTS; i++)
+		pc->slot[i].used = 0;
+	pc->clock = 0;
+} // void m1_text_cache_flush(S_M1_Text_Cache *pc)
+
+
+
+static void text_page_paint(uint8_t *pdst, uint8_t mask, uint8_t color)
+{
+	if ( color==M1_TEXT_COLOR_CLEAR )
+		*pdst &= (uint8_t)~mask;
+	else if ( color==M1_TEXT_COLOR_SET )
+		*pdst |= mask;
+	else
+		*pdst ^= mask;
+} // static void text_page_paint(uint8_t *pdst, uint8_t mask, uint8_t color)
+
+
+
+// Bit 0 becomes bit 7: a page of a 180 degree rotated buffer lists its rows bottom up
+static uint8_t text_bits_reverse(uint8_t b)
+{
+	b = (uint8_t)((b & 0xF0) >> 4 | (b & 0x0F) << 4);
+	b = (uint8_t)((b & 0xCC) >> 2 | (b & 0x33) << 2);
+
+	return (uint8_t)((b & 0xAA) >> 1 | (b & 0x55) << 1);
+} // static uint8_t text_bits_reverse(uint8_t b)
+
+
+
+// Paints one column byte of a page given in display coordinates, clipped to the buffer
+static void text_column_paint(uint8_t *pbuf, uint16_t buf_w, uint16_t buf_pages, int16_t page, int16_t x,
+								uint8_t back, uint8_t ink, uint8_t bg_color, uint8_t color, bool rot180)
+{
+	uint8_t *pdst;
+
+	if ( page < 0 || page >= (int16_t)buf_pages )
+		return;
+	if ( rot180 )
+	{
+		page = buf_pages - 1 - page;
+		x = buf_w - 1 - x;
+		back = text_bits_reverse(back);
+		ink = text_bits_reverse(ink);
+	}
+	pdst = &pbuf[page*buf_w + x];
+	text_page_paint(pdst, back, bg_color);
+	text_page_paint(pdst, ink, color);
+} // static void text_column_paint(uint8_t *pbuf, uint16_t buf_w, uint16_t buf_pages, int16_t page, int16_t x, ...)
+
+
+
+/*============================================================================*/
+/*
+ * This function draws the run into a page buffer of buf_w x buf_h pixels, with
+ * the string's x and baseline y, as u8g2_DrawStr() would: the ink in color
+ * and, in the solid font mode, the rest of the glyph boxes in the background
+ * color. Pixels off the buffer are clipped. With rot180 the buffer holds the
+ * display turned by 180 degrees, as u8g2 lays it out for U8G2_R2; x and y
+ * stay display coordinates. buf_h is a multiple of 8.
+ */
+/*============================================================================*/
+void m1_text_run_blit(const S_M1_Text_Run *prun, uint8_t *pbuf, uint16_t buf_w, uint16_t buf_h,
+						int16_t x, int16_t y, uint8_t color, bool solid, bool rot180)
+{
+	int16_t x0, y0, dst_page, col, dst_x;
+	uint16_t buf_pages, ink, back;
+	uint8_t page, shift, bg_color;
+
+	bg_color = (color==M1_TEXT_COLOR_CLEAR) ? M1_TEXT_COLOR_SET : M1_TEXT_COLOR_CLEAR;
+	buf_pages = buf_h/8;
+	x0 = x + prun->x_off;
+	y0 = y + prun->y_off;
+	// Floor division: the run may start above the buffer
+	dst_page = (y0 >= 0) ? y0/8 : -((7 - y0)/8);
+	shift = (uint8_t)(y0 - dst_page*8);
+
+	for (page=0; page<M1_TEXT_CACHE_RUN_PAGES && page*8 < prun->h; page++, dst_page++)
+	{
+		for (col=0; col<prun->w; col++)
+		{
+			dst_x = x0 + col;
+			if ( dst_x < 0 || dst_x >= (int16_t)buf_w )
+				continue;
+
+			ink = (uint16_t)(prun->ink[page][col] << shift);
+			back = solid ? (uint16_t)((prun->box[page][col] & ~prun->ink[page][col]) << shift) : 0;
+			text_column_paint(pbuf, buf_w, buf_pages, dst_page, dst_x, (uint8_t)back, (uint8_t)ink,
+								bg_color, color, rot180);
+			if ( shift )
+				text_column_paint(pbuf, buf_w, buf_pages, dst_page + 1, dst_x, (uint8_t)(back >> 8),
+									(uint8_t)(ink >> 8), bg_color, color, rot180);
+		} // for (col=0; ...)
+	} // for (page=0; ...)
+} // void m1_text_run_blit(const S_M1_Text_Run *prun, uint8_t *pbuf, uint16_t buf_w, uint16_t buf_h, ...)
@@ -0,0 +1,77 @@
+/* See COPYING.txt for license details. */
+
+/*
+*
+* m1_text_cache.h
+*
+* Header for the text run cache
+*
+* A text run is a string drawn with one font, rasterised once into the
+* display's page layout: one byte per column per 8 pixel rows, LSB on top.
+* A run keeps two masks, the ink and the glyph boxes, so that it can be
+* blitted in both the transparent and the solid font mode, in any draw color.
+* Menus and lists draw the same few strings every frame; the cache hands the
+* run back instead of decoding the compressed font again.
+*
+* The cache does not know about u8g2, the owner renders the misses with the
+* callback it was set up with.
+*
+* M1 Project
+*
+*/
+
+#ifndef M1_TEXT_CACHE_H_
+#define M1_TEXT_CACHE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define M1_TEXT_CACHE_SLOTS			16
+#define M1_TEXT_CACHE_STR_MAX		32 // Characters, longer strings are not cached
+#define M1_TEXT_CACHE_RUN_W_MAX		128 // pixel
+#define M1_TEXT_CACHE_RUN_PAGES		3 // 8 pixel rows each, 24 pixel high fonts at most
+
+#define M1_TEXT_COLOR_CLEAR			0
+#define M1_TEXT_COLOR_SET			1
+#define M1_TEXT_COLOR_XOR			2
+
+typedef struct
+{
+	int8_t x_off; // Column 0 of the run, relative to the x the string is drawn at
+	int8_t y_off; // Row 0 of the run, relative to the baseline
+	uint8_t w; // pixel
+	uint8_t h; // pixel
+	uint16_t advance; // Width returned to the caller, as u8g2_DrawStr() does
+	uint8_t ink[M1_TEXT_CACHE_RUN_PAGES][M1_TEXT_CACHE_RUN_W_MAX];
+	uint8_t box[M1_TEXT_CACHE_RUN_PAGES][M1_TEXT_CACHE_RUN_W_MAX]; // Glyph boxes, painted in the solid font mode
+} S_M1_Text_Run;
+
+// Rasterises str in font into prun, returns false if it cannot be cached
+typedef bool (*m1_text_render_fn)(const void *font, const char *str, S_M1_Text_Run *prun);
+
+typedef struct
+{
+	const void *font;
+	uint32_t hash;
+	uint32_t used; // LRU stamp, 0 for a free slot
+	char str[M1_TEXT_CACHE_STR_MAX + 1];
+	S_M1_Text_Run run;
+} S_M1_Text_Slot;
+
+typedef struct
+{
+	m1_text_render_fn render;
+	uint32_t clock;
+	uint32_t hits;
+	uint32_t misses;
+	uint32_t bypasses; // Strings that could not be cached
+	S_M1_Text_Slot slot[M1_TEXT_CACHE_SLOTS];
+} S_M1_Text_Cache;
+
+void m1_text_cache_init(S_M1_Text_Cache *pc, m1_text_render_fn render);
+const S_M1_Text_Run *m1_text_cache_get(S_M1_Text_Cache *pc, const void *font, const char *str);
+void m1_text_cache_flush(S_M1_Text_Cache *pc);
+void m1_text_run_blit(const S_M1_Text_Run *prun, uint8_t *pbuf, uint16_t buf_w, uint16_t buf_h,
+						int16_t x, int16_t y, uint8_t color, bool solid, bool rot180);
+
+#endif /* M1_TEXT_CACHE_H_ */
@@ -0,0 +1,173 @@
+/* See COPYING.txt for license details. */
+
+/*
+*
+* m1_text_draw.c
+*
+* Cached string drawing
+*
+* M1 Project
+*
+*/
+
+/*************************** I N C L U D E S **********************************/
+
+#include <string.h>
+#include "m1_text_draw.h"
+
+/*************************** D E F I N E S ************************************/
+
+#define TEXT_RUN_MARGIN_X			2 // pixel, for glyphs reaching left of their origin
+
+//************************** C O N S T A N T **********************************/
+
+//************************** S T R U C T U R E S *******************************
+
+/***************************** V A R I A B L E S ******************************/
+
+static u8g2_t *text_u8g2; // Display the cache draws for
+static S_M1_Text_Cache text_cache;
+static uint8_t text_render_buf[M1_TEXT_DRAW_BUF_SIZE]; // Scratch frame buffer the runs are rendered in
+
+/********************* F U N C T I O N   P R O T O T Y P E S ******************/
+
+void m1_text_draw_init(u8g2_t *u8g2);
+u8g2_uint_t m1_draw_str(u8g2_t *u8g2, u8g2_uint_t x, u8g2_uint_t y, const char *str);
+const S_M1_Text_Cache *m1_text_draw_cache(void);
+static bool text_run_render(const void *font, const char *str, S_M1_Text_Run *prun);
+
+/*************** F U N C T I O N   I M P L E M E N T A T I O N ****************/
+
+/*============================================================================*/
+/**
+  * @brief  Sets up the cache for a display, its runs are dropped
+  * @param  u8g2: display, set up with a full frame buffer
+  * @retval None
+  */
+/*============================================================================*/
+void m1_text_draw_init(u8g2_t *u8g2)
+{
+	text_u8g2 = u8g2;
+	m1_text_cache_init(&text_cache, text_run_render);
+} // void m1_text_draw_init(u8g2_t *u8g2)
+
+
+
+/*============================================================================*/
+/**
+  * @brief  Renders a text run for the cache, with the font the display is set to
+  *         The string is drawn twice in the solid font mode into a scratch
+  *         frame buffer: on a clear buffer for the ink, on a filled one for
+  *         the glyph boxes. The display is switched to U8G2_R0 meanwhile, so
+  *         the run is not rotated; in a full frame buffer R0 and R2 have the
+  *         same page window.
+  * @param  font: font the string is drawn with
+  * @param  str: string
+  * @param  prun: run to fill
+  * @retval false if the string does not fit in a run
+  */
+/*============================================================================*/
+static bool text_run_render(const void *font, const char *str, S_M1_Text_Run *prun)
+{
+	u8g2_t *u8g2 = text_u8g2;
+	const u8g2_cb_t *rotation;
+	uint8_t *pframe_buf;
+	uint8_t draw_color, is_transparent, page, col;
+	int16_t ascent, height, base_y;
+	u8g2_uint_t advance;
+
+	if ( u8g2==NULL || u8g2->font!=font )
+		return false;
+	if ( u8g2->pixel_buf_width*u8g2->tile_buf_height > sizeof(text_render_buf) ) // A byte per column per tile row
+		return false;
+
+	ascent = u8g2->font_info.max_char_height + u8g2->font_info.y_offset;
+	height = u8g2->font_info.max_char_height;
+	if ( height <= 0 || height > M1_TEXT_CACHE_RUN_PAGES*8 )
+		return false;
+	// DrawStr() moves the baseline by the font reference position
+	base_y = ascent - u8g2->font_calc_vref(u8g2);
+
+	pframe_buf = u8g2->tile_buf_ptr;
+	rotation = u8g2->cb;
+	draw_color = u8g2->draw_color;
+	is_transparent = u8g2->font_decode.is_transparent;
+	u8g2->tile_buf_ptr = text_render_buf;
+	u8g2->cb = U8G2_R0;
+	u8g2->draw_color = M1_TEXT_COLOR_SET;
+	u8g2->font_decode.is_transparent = 0;
+
+	memset(text_render_buf, 0x00, sizeof(text_render_buf));
+	advance = u8g2_DrawStr(u8g2, TEXT_RUN_MARGIN_X, base_y, str);
+	for (page=0; page<M1_TEXT_CACHE_RUN_PAGES; page++)
+		memcpy(prun->ink[page], &text_render_buf[page*u8g2->pixel_buf_width], M1_TEXT_CACHE_RUN_W_MAX);
+
+	// The background of the glyph boxes clears the filled buffer
+	memset(text_render_buf, 0xFF, sizeof(text_render_buf));
+	u8g2_DrawStr(u8g2, TEXT_RUN_MARGIN_X, base_y, str);
+	for (page=0; page<M1_TEXT_CACHE_RUN_PAGES; page++)
+	{
+		for (col=0; col<M1_TEXT_CACHE_RUN_W_MAX; col++)
+			prun->box[page][col] = (uint8_t)~text_render_buf[page*u8g2->pixel_buf_width + col] | prun->ink[page][col];
+	}
+
+	u8g2->tile_buf_ptr = pframe_buf;
+	u8g2->cb = rotation;
+	u8g2->draw_color = draw_color;
+	u8g2->font_decode.is_transparent = is_transparent;
+
+	if ( advance + 2*TEXT_RUN_MARGIN_X > M1_TEXT_CACHE_RUN_W_MAX )
+		return false;
+
+	prun->x_off = -TEXT_RUN_MARGIN_X;
+	prun->y_off = -ascent;
+	prun->w = advance + 2*TEXT_RUN_MARGIN_X;
+	prun->h = height;
+	prun->advance = advance;
+
+	return true;
+} // static bool text_run_render(const void *font, const char *str, S_M1_Text_Run *prun)
+
+
+
+/*============================================================================*/
+/**
+  * @brief  Draws a string like u8g2_DrawStr(), from the text run cache
+  *         Strings the cache cannot hold, and drawing set up in a way the
+  *         runs do not cover (R1/R3, rotated text, clip window, page mode),
+  *         go to u8g2_DrawStr().
+  * @param  u8g2: display
+  * @param  x, y: left and baseline of the string
+  * @param  str: string
+  * @retval Width of the string
+  */
+/*============================================================================*/
+u8g2_uint_t m1_draw_str(u8g2_t *u8g2, u8g2_uint_t x, u8g2_uint_t y, const char *str)
+{
+	const S_M1_Text_Run *prun = NULL;
+
+	if ( u8g2==text_u8g2 && (u8g2->cb==U8G2_R0 || u8g2->cb==U8G2_R2)
+			&& u8g2->font_decode.dir==0 && u8g2->tile_curr_row==0
+			&& u8g2->pixel_buf_height >= u8g2->height
+			&& u8g2->clip_x0==0 && u8g2->clip_y0==0
+			&& u8g2->clip_x1 >= u8g2->pixel_buf_width && u8g2->clip_y1 >= u8g2->pixel_buf_height )
+	{
+		prun = m1_text_cache_get(&text_cache, u8g2->font, str);
+	}
+	if ( !prun )
+		return u8g2_DrawStr(u8g2, x, y, str);
+
+	m1_text_run_blit(prun, u8g2->tile_buf_ptr, u8g2->pixel_buf_width, u8g2->pixel_buf_height,
+						(int16_t)x, (int16_t)(y + u8g2->font_calc_vref(u8g2)), u8g2->draw_color,
+						!u8g2->font_decode.is_transparent, u8g2->cb==U8G2_R2);
+
+	return prun->advance;
+} // u8g2_uint_t m1_draw_str(u8g2_t *u8g2, u8g2_uint_t x, u8g2_uint_t y, const char *str)
+
+
+
+// Hit and miss counts
+const S_M1_Text_Cache *m1_text_draw_cache(void)
+{
+	return &text_cache;
+} // const S_M1_Text_Cache *m1_text_draw_cache(void)
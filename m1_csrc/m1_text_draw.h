@@ -0,0 +1,29 @@
+/* See COPYING.txt for license details. */
+
+/*
+*
+* m1_text_draw.h
+*
+* Header for the cached string drawing
+*
+* m1_draw_str() is u8g2_DrawStr() served from the text run cache for the
+* display it was set up with. Runs are rendered unrotated; the blit follows
+* the display rotation (U8G2_R0 or U8G2_R2).
+*
+* M1 Project
+*
+*/
+
+#ifndef M1_TEXT_DRAW_H_
+#define M1_TEXT_DRAW_H_
+
+#include "u8g2.h"
+#include "m1_text_cache.h"
+
+#define M1_TEXT_DRAW_BUF_SIZE		(128*64/8) // Scratch frame buffer, as large as the display's
+
+void m1_text_draw_init(u8g2_t *u8g2);
+u8g2_uint_t m1_draw_str(u8g2_t *u8g2, u8g2_uint_t x, u8g2_uint_t y, const char *str);
+const S_M1_Text_Cache *m1_text_draw_cache(void);
+
+#endif /* M1_TEXT_DRAW_H_ */
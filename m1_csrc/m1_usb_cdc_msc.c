@@ -16,6 +16,7 @@
 #include "diskio.h"
 #include "m1_cli.h"
 #include "m1_compile_cfg.h"
+#include "m1_msc_cache.h"
 #include "m1_sdcard.h"
 #include "m1_sys_init.h"
 #include "main.h"
@@ -23,7 +24,8 @@
 
 /*************************** D E F I N E S ************************************/
 
-#define CHUNK_SIZE 512
+// Longest time a USART1 TX DMA transfer may take beyond its bit time
+#define USB2SER_TX_TIMEOUT_MARGIN_MS 100
 
 //************************** C O N S T A N T **********************************/
 
@@ -75,14 +77,16 @@ PCD_HandleTypeDef hpcd_USB_DRD_FS;
 
 StreamBufferHandle_t h_uart_rx_streambuf;
 SemaphoreHandle_t ser2usb_task_semaphore;
-SemaphoreHandle_t ser2usb_tx_semaphore;
 
 StreamBufferHandle_t h_usb_rx_streambuf;
 StreamBufferHandle_t h_usb_cli_rx_streambuf;
-SemaphoreHandle_t usb2ser_task_semaphore;
 SemaphoreHandle_t usb2ser_tx_semaphore;
 
 uint8_t usb_tx_temp_buffer[USB_TX_BUF_SIZE];
+// USB -> USART1: one buffer is sent by DMA while the other one is filled
+static uint8_t usb2ser_dma_buffer[2][USB2SER_DMA_CHUNK_SIZE];
+static volatile uint8_t usb2ser_comconfig_pending = 0;
+static S_M1_UsbBridge_Stats usb_bridge_stats;
 
 volatile uint16_t head_usart1_dma = 0;
 volatile uint16_t tail_usart1_dma = 0;
@@ -134,11 +138,6 @@ enCdcMode m1_usbcdc_mode = CDC_MODE_VCP;
 TaskHandle_t usb2ser_task_hdl;
 TaskHandle_t ser2usb_task_hdl;
 
-uint32_t DEBUG_dma_timeout = 0;
-uint32_t DEBUG_bytes_to_send = 0;
-uint32_t DEBUG_received_bytes = 0;
-volatile uint8_t tx_cptl_usart1 = 0;
-
 const osThreadAttr_t Usb2SerTask_attributes = {
     .name = "Usb2SerTask",
     .priority = (osPriority_t)TASK_PRIORITY_LOG_DB_HANDLER,
@@ -155,14 +154,22 @@ const osThreadAttr_t Ser2UsbTask_attributes = {
 
 uint8_t m1_usb_msc_process(void);
 uint8_t m1_usb_msc_sd_detected(void);
+void m1_usb_msc_flush(void);
 void vSer2UsbTask(void *pvParameters);
 void CDC_Signal_Next_Tx(void);
+static uint8_t cdc_stream_transmit(uint8_t *buf, uint16_t len);
+void m1_usb_cdc_stream(S_M1_CdcStream_Source source);
 void vUsb2SerTask(void *pvParameters);
 void usart_rxupdate_head_pointer(void);
 uint16_t usart_rxget_data_length(void);
 static void cdc_start_usb2ser(void);
+static void usb2ser_resume_usb_rx(void);
 void m1_usb_cdc_comdefault(void);
 void m1_usb_cdc_comconfig(void);
+void m1_usb_cdc_comconfig_from_isr(void);
+void m1_usb_bridge_get_stats(S_M1_UsbBridge_Stats *pstats);
+void m1_usb_bridge_count_error(void);
+void m1_usb_bridge_count_pause(void);
 void usb_cdc_init(void);
 #if 0 /* Unused: stub for future work. May need removal later. */
 static void usb_cdc_deinit(void);
@@ -233,6 +240,24 @@ uint8_t m1_usb_msc_sd_detected(void) {
   return detected;
 }
 
+/******************************************************************************/
+/*
+ * Writes the blocks the USB MSC sector cache still holds and empties the
+ * cache. Called before the firmware mounts the card again. The MSC class
+ * runs in the USB interrupt, which is held off meanwhile.
+ */
+/******************************************************************************/
+void m1_usb_msc_flush(void) {
+  uint32_t usb_irq_enabled = NVIC_GetEnableIRQ(USB_DRD_FS_IRQn);
+
+  if (usb_irq_enabled)
+    HAL_NVIC_DisableIRQ(USB_DRD_FS_IRQn);
+  m1_msc_cache_flush();
+  m1_msc_cache_invalidate();
+  if (usb_irq_enabled)
+    HAL_NVIC_EnableIRQ(USB_DRD_FS_IRQn);
+}
+
 /*============================================================================*/
 /**
  * @brief  USB CDC handler task - USART1 to USB CDC
@@ -251,37 +276,25 @@ void vSer2UsbTask(void *pvParameters) {
   cdc_start_usb2ser();
 
   for (;;) {
+    /* Wait for the previous USB transfer to complete (semaphore returned in
+     * TxCpltCallback). The USART1 data that arrives meanwhile piles up in the
+     * stream buffer and goes out in one transfer. */
+    if (xSemaphoreTake(ser2usb_task_semaphore, pdMS_TO_TICKS(500)) != pdTRUE) {
+      // Transfer lost, e.g. the cable was pulled
+    }
+
     /* Read data from the USART RX Stream Buffer (blocking) */
     received_bytes =
         xStreamBufferReceive(h_uart_rx_streambuf, (void *)usb_tx_temp_buffer,
                              sizeof(usb_tx_temp_buffer), portMAX_DELAY);
-    if (received_bytes > 0) {
-      /* Wait for previous USB transfer to complete (return semaphore in
-       * TxCpltCallback) */
-      // if(xSemaphoreTake(ser2usb_task_semaphore, portMAX_DELAY) == pdTRUE)
-      if (xSemaphoreTake(ser2usb_task_semaphore, pdMS_TO_TICKS(500)) ==
-          pdTRUE) {
-        if ((hUsbDeviceFS.pClassData != NULL) && (m1_USB_CDC_ready == 0)) {
-          /* Data transfer request */
-          if (CDC_Transmit_FS(usb_tx_temp_buffer, received_bytes) !=
-              USBD_OK) { // error handling
-            // Initialize flags and immediately return semaphore when
-            // transmission fails
-            xSemaphoreGive(ser2usb_task_semaphore);
-          }
-          // semaphore is given in TxCpltCallback when successful (not returned
-          // here)
-        } else {
-          // usb cable plug off
-          xSemaphoreGive(ser2usb_task_semaphore);
-        }
-      } else { // Error !!, cancel data
-        xSemaphoreGive(ser2usb_task_semaphore);
-      }
+    if ((received_bytes > 0) && (hUsbDeviceFS.pClassData != NULL) &&
+        (m1_USB_CDC_ready == 0)) {
+      /* Data transfer request */
+      if (CDC_Transmit_FS(usb_tx_temp_buffer, received_bytes) == USBD_OK)
+        continue; // semaphore is given in TxCpltCallback
     }
-    // vTaskDelay(pdMS_TO_TICKS(TASKDELAY_Ser2Usb_handler_task));
-    // m1_wdt_send_report(M1_REPORT_ID_SER2USB_HANDLER_TASK,
-    // TASKDELAY_Ser2Usb_handler_task);
+    // Nothing sent: usb cable plug off or transmission failed
+    xSemaphoreGive(ser2usb_task_semaphore);
   }
 } // void vSer2UsbTask(void *pvParameters)
 
@@ -299,6 +312,45 @@ void CDC_Signal_Next_Tx(void) {
   portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
 }
 
+/*============================================================================*/
+/**
+ * @brief  Starts a transfer of the binary capture stream, see m1_cdc_stream.h
+ * @param  buf  packet to send
+ * @param  len  packet length in bytes
+ * @retval USBD_OK if the transfer was started
+ */
+/*============================================================================*/
+static uint8_t cdc_stream_transmit(uint8_t *buf, uint16_t len) {
+  if ((hUsbDeviceFS.pClassData == NULL) || (m1_USB_CDC_ready != 0))
+    return USBD_FAIL; // usb cable plug off
+
+  return CDC_Transmit_FS(buf, len);
+}
+
+/*============================================================================*/
+/**
+ * @brief  Switches the CDC port between the CLI and the binary capture
+ *         stream. While streaming, CLI commands are still read from the port
+ *         and the debug log goes to USART1.
+ * @param  source  capture to stream, CDC_STREAM_SRC_NONE returns to the CLI
+ * @retval None
+ */
+/*============================================================================*/
+void m1_usb_cdc_stream(S_M1_CdcStream_Source source) {
+  if (m1_usbcdc_mode == CDC_MODE_VCP)
+    return; // The port belongs to the USART bridge
+
+  if (source == CDC_STREAM_SRC_NONE) {
+    m1_cdc_stream_stop();
+    m1_usbcdc_mode = CDC_MODE_LOG_CLI;
+    return;
+  }
+
+  m1_cdc_stream_init(cdc_stream_transmit);
+  m1_usbcdc_mode = CDC_MODE_STREAM;
+  m1_cdc_stream_start(source);
+}
+
 /*============================================================================*/
 /**
  * @brief  USB CDC handler task - USB CDC to USART1
@@ -307,132 +359,58 @@ void CDC_Signal_Next_Tx(void) {
  */
 /*============================================================================*/
 void vUsb2SerTask(void *pvParameters) {
+  TickType_t tx_timeout = pdMS_TO_TICKS(USB2SER_TX_TIMEOUT_MARGIN_MS);
+  uint8_t *buffer;
+  uint8_t buffer_idx = 0;
   size_t received_bytes;
-  size_t bytes_to_send;
-  size_t bytes_remaining;
-  uint8_t *current_buffer_ptr;
-  enCdcMode prev_cdc_mode = m1_usbcdc_mode;
-  (void)
-      prev_cdc_mode; /* Unused: stub for future work. May need removal later. */
+  uint32_t bit_ms;
 
   UNUSED(pvParameters);
 
-  const TickType_t xMaxBlockTime = pdMS_TO_TICKS(500);
-  (void)
-      xMaxBlockTime; /* Unused: stub for future work. May need removal later. */
-
   for (;;) {
-#if 0
-    /* Wait indefinitely until data arrives */
-    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(100));
-
-    /* USB CDC Mode change */
-    // debug : USB CDC mode changing test
-    if (prev_cdc_mode != m1_usbcdc_mode)
-    {
-      prev_cdc_mode = m1_usbcdc_mode;
-      //usb_cdc_init();
+    /* Fill one buffer while the DMA sends the other one */
+    buffer = usb2ser_dma_buffer[buffer_idx];
+    received_bytes = xStreamBufferReceive(h_usb_rx_streambuf, buffer,
+                                          USB2SER_DMA_CHUNK_SIZE, portMAX_DELAY);
+
+    /* Wait for the previous DMA transfer to complete (semaphore returned in
+     * HAL_UART_TxCpltCallback) */
+    if (xSemaphoreTake(usb2ser_tx_semaphore, tx_timeout) != pdTRUE) {
+      HAL_UART_AbortTransmit(&huart_logdb);
+      usb_bridge_stats.uart_tx_timeouts++;
+    }
 
+    /* The line coding is changed between transfers */
+    if (usb2ser_comconfig_pending) {
+      usb2ser_comconfig_pending = 0;
       m1_usb_cdc_comconfig();
     }
 
-#if 0
-                  // debug : USB CDC mode changing test
-#include "m1_usb_cdc_msc.h"
-                  extern enCdcMode m1_usbcdc_mode;
-
-
-                  if (m1_usbcdc_mode == CDC_MODE_LOG_CLI)
-                  {
-                    m1_usbcdc_mode = CDC_MODE_VCP;
-                  }
-                  else
-                  {
-                    m1_usbcdc_mode = CDC_MODE_LOG_CLI;
-                  }
-#endif
-
-#else
-    /* Wait indefinitely until data arrives */
-    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
-#endif
-
-    size_t data_available = xStreamBufferBytesAvailable(h_usb_rx_streambuf);
-    if (data_available == 0)
-      continue; // If there is no data, wait again
-
-#if 0
-    if( xSemaphoreTake(usb2ser_tx_semaphore, portMAX_DELAY) != pdTRUE ) // Remove or keep a mutex
-    {
+    /* Add what arrived while waiting */
+    if (received_bytes < USB2SER_DMA_CHUNK_SIZE) {
+      received_bytes += xStreamBufferReceive(
+          h_usb_rx_streambuf, &buffer[received_bytes],
+          USB2SER_DMA_CHUNK_SIZE - received_bytes, 0);
     }
-#endif
-    received_bytes =
-        xStreamBufferReceive(h_usb_rx_streambuf, (void *)logdb_tx_buffer,
-                             M1_LOGDB_TX_BUFFER_SIZE, 0);
-
-    if (DEBUG_received_bytes < received_bytes)
-      DEBUG_received_bytes = received_bytes;
-
-    if (received_bytes > 0) {
-      bytes_remaining = received_bytes;
-      current_buffer_ptr = logdb_tx_buffer;
+    usb2ser_resume_usb_rx();
 
-      while (bytes_remaining > 0) {
-        bytes_to_send =
-            (bytes_remaining > CHUNK_SIZE) ? CHUNK_SIZE : bytes_remaining;
-        // bytes_to_send = (bytes_remaining > M1_LOGDB_TX_BUFFER_SIZE) ?
-        // M1_LOGDB_TX_BUFFER_SIZE : bytes_remaining;
-
-        if (DEBUG_bytes_to_send < bytes_to_send)
-          DEBUG_bytes_to_send = bytes_to_send;
-
-        // Start USART1 transmission using GPDMA1 channel 1
-
-        tx_cptl_usart1 = 1;
-
-        if (HAL_UART_Transmit_DMA(&huart_logdb, current_buffer_ptr,
-                                  bytes_to_send) == HAL_OK) {
-#if 1
-          while (tx_cptl_usart1 == 1) {
-            osDelay(1);
-            DEBUG_dma_timeout++;
-          }
-
-#else
-          /* Wait for DMA transfer to complete */
-          if (xSemaphoreTake(usb2ser_tx_semaphore, xMaxBlockTime) != pdTRUE) {
-            // printf("DMA time out!\r\n");
-            HAL_UART_DMAStop(&huart_logdb);
-            huart_logdb.gState = HAL_UART_STATE_READY;
-
-            DEBUG_dma_timeout++;
-            break;
-          }
-#endif
-          // osDelay(1); //osDelay(10);
-
-          current_buffer_ptr += bytes_to_send;
-          bytes_remaining -= bytes_to_send;
-        } else {
-          // printf("HAL_UART_Transmit_DMA Failed to Start!\r\n");
-          break;
-        }
-      }
-
-      // After processing all data, if it was stopped, request to resume
-      if (usbcdc_rx_paused == 1) {
-        usbcdc_rx_paused = 0;
-
-        USBD_CDC_ReceivePacket(&hUsbDeviceFS);
-      }
+    if (received_bytes == 0) {
+      xSemaphoreGive(usb2ser_tx_semaphore);
+      continue;
     }
 
-    // if (xCommsSemaphore != NULL) xSemaphoreGive(xCommsSemaphore); //
-    // Returning a mutex
-
-    // vTaskDelay(pdMS_TO_TICKS(TASKDELAY_Usb2Ser_handler_task));
-    // m1_wdt_send_report(M1_REPORT_ID_USB2SER_HANDLER_TASK,
-    // TASKDELAY_Usb2Ser_handler_task);
+    // Start USART1 transmission using GPDMA1 channel 1
+    if (HAL_UART_Transmit_DMA(&huart_logdb, buffer, received_bytes) !=
+        HAL_OK) {
+      xSemaphoreGive(usb2ser_tx_semaphore);
+      continue;
+    }
+    // 10 bits per byte at the current rate, plus the margin
+    bit_ms = (uint32_t)((received_bytes * 10U * 1000U) /
+                        (huart_logdb.Init.BaudRate ? huart_logdb.Init.BaudRate
+                                                   : 1U));
+    tx_timeout = pdMS_TO_TICKS(bit_ms + USB2SER_TX_TIMEOUT_MARGIN_MS);
+    buffer_idx ^= 1;
   }
 } // void vUsb2SerTask(void *pvParameters)
 
@@ -486,15 +464,20 @@ void usart_rxdata_process_from_isr(void) {
                              : current_len;
     uint16_t part2_len = current_len - part1_len;
 
+    size_t sent = 0;
+
     if (part1_len > 0) {
-      xStreamBufferSendFromISR(h_uart_rx_streambuf,
-                               (void *)&logdb_rx_buffer[prev_tail], part1_len,
-                               &xHigherPriorityTaskWoken);
+      sent += xStreamBufferSendFromISR(h_uart_rx_streambuf,
+                                       (void *)&logdb_rx_buffer[prev_tail],
+                                       part1_len, &xHigherPriorityTaskWoken);
     }
     if (part2_len > 0) {
-      xStreamBufferSendFromISR(h_uart_rx_streambuf, (void *)&logdb_rx_buffer,
-                               part2_len, &xHigherPriorityTaskWoken);
+      sent += xStreamBufferSendFromISR(h_uart_rx_streambuf,
+                                       (void *)&logdb_rx_buffer, part2_len,
+                                       &xHigherPriorityTaskWoken);
     }
+    // USB did not keep up, the bytes that did not fit are lost
+    usb_bridge_stats.uart_rx_dropped += current_len - sent;
 
     // Update the volatile variable tail only after data copying is complete
     tail_usart1_dma = (prev_tail + current_len) % M1_LOGDB_RX_BUFFER_SIZE;
@@ -503,6 +486,24 @@ void usart_rxdata_process_from_isr(void) {
   portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
 }
 
+/*============================================================================*/
+/**
+ * @brief  Lets the host send again once the USB RX stream buffer has room
+ *         for a full packet. CDC_Receive_FS holds the host off (NAK) when
+ *         USART1 can not keep up.
+ * @param
+ * @retval
+ */
+/*============================================================================*/
+static void usb2ser_resume_usb_rx(void) {
+  if ((usbcdc_rx_paused == 1) && (xStreamBufferSpacesAvailable(
+                                      h_usb_rx_streambuf) >=
+                                  CDC_DATA_FS_MAX_PACKET_SIZE)) {
+    usbcdc_rx_paused = 0;
+    USBD_CDC_ReceivePacket(&hUsbDeviceFS);
+  }
+}
+
 /*============================================================================*/
 /**
  * @brief start usb2ser task
@@ -511,21 +512,30 @@ void usart_rxdata_process_from_isr(void) {
  */
 /*============================================================================*/
 static void cdc_start_usb2ser(void) {
+  /* The bridge buffers live for the whole run time, keep them off the heap.
+   * Stream buffers need one byte more than their capacity. */
+  static uint8_t uart_rx_sb_storage[RXSTREAMBUF_UART_SIZE + 1];
+  static StaticStreamBuffer_t uart_rx_sb_ctrl;
+  static uint8_t usb_rx_sb_storage[RXSTREAMBUF_USB_SIZE + 1];
+  static StaticStreamBuffer_t usb_rx_sb_ctrl;
+  static uint8_t usb_cli_rx_sb_storage[USB_RX_BUF_SIZE + 1];
+  static StaticStreamBuffer_t usb_cli_rx_sb_ctrl;
+
   // Prepare usart1 rx to usb tx */
-  h_uart_rx_streambuf = xStreamBufferCreate(RXSTREAMBUF_UART_SIZE, 1);
+  h_uart_rx_streambuf = xStreamBufferCreateStatic(
+      RXSTREAMBUF_UART_SIZE, 1, uart_rx_sb_storage, &uart_rx_sb_ctrl);
   ser2usb_task_semaphore = xSemaphoreCreateBinary();
   xSemaphoreGive(ser2usb_task_semaphore);
 
   /* Prepare usb rx to usart tx */
-  h_usb_rx_streambuf = xStreamBufferCreate(RXSTREAMBUF_USB_SIZE, 1);
-  h_usb_cli_rx_streambuf = xStreamBufferCreate(USB_RX_BUF_SIZE, 1);
+  h_usb_rx_streambuf = xStreamBufferCreateStatic(
+      RXSTREAMBUF_USB_SIZE, 1, usb_rx_sb_storage, &usb_rx_sb_ctrl);
+  h_usb_cli_rx_streambuf = xStreamBufferCreateStatic(
+      USB_RX_BUF_SIZE, 1, usb_cli_rx_sb_storage, &usb_cli_rx_sb_ctrl);
   if (h_usb_cli_rx_streambuf == NULL) {
     m1_usbcdc_mode = CDC_MODE_VCP;
   }
 
-  usb2ser_task_semaphore = xSemaphoreCreateBinary();
-  xSemaphoreGive(usb2ser_task_semaphore);
-
   usb2ser_tx_semaphore = xSemaphoreCreateBinary();
   xSemaphoreGive(usb2ser_tx_semaphore);
 
@@ -544,8 +554,10 @@ void m1_usb_cdc_comdefault(void) {
   /* Stop bit */
   if (huart_logdb.Init.StopBits == UART_STOPBITS_1)
     linecoding.format = 0;
-  else if (huart_logdb.Init.StopBits == UART_STOPBITS_2)
+  else if (huart_logdb.Init.StopBits == UART_STOPBITS_1_5)
     linecoding.format = 1;
+  else if (huart_logdb.Init.StopBits == UART_STOPBITS_2)
+    linecoding.format = 2;
 
   /* parity bit*/
   if (huart_logdb.Init.Parity == UART_PARITY_NONE)
@@ -563,26 +575,52 @@ void m1_usb_cdc_comdefault(void) {
     linecoding.datatype = 8;
 }
 
+/*============================================================================*/
+/**
+ * @brief  m1_usb_cdc_comconfig_from_isr
+ *         Called from CDC_Control_FS when the host sets the line coding.
+ *         USART1 is reconfigured by vUsb2SerTask between two transfers.
+ * @param  None.
+ * @retval None.
+ */
+/*============================================================================*/
+void m1_usb_cdc_comconfig_from_isr(void) {
+  BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+  usb2ser_comconfig_pending = 1;
+  if (h_usb_rx_streambuf != NULL) {
+    // Wake vUsb2SerTask without data
+    xStreamBufferSendCompletedFromISR(h_usb_rx_streambuf,
+                                      &xHigherPriorityTaskWoken);
+  }
+  portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+}
+
 /*============================================================================*/
 /**
  * @brief  m1_usb_cdc_comconfig
  *         Configure the COM Port with the parameters received from host.
+ *         Only USART1 is set up again, the DMA channels, the log buffers
+ *         and the interrupts stay as they are.
  * @param  None.
  * @retval None.
  * @note   When a configuration is not supported, a default value is used.
  */
 /*============================================================================*/
 void m1_usb_cdc_comconfig(void) {
-  /* Deinitialize USART1 */
-  m1_logdb_deinit();
+  /* Stop USART1 and both DMA transfers */
+  HAL_UART_Abort(&huart_logdb);
 
-  /* Initialize USART1 */
   /* Stop bit */
   switch (linecoding.format) {
   case 0:
     huart_logdb.Init.StopBits = UART_STOPBITS_1;
     break;
 
+  case 1:
+    huart_logdb.Init.StopBits = UART_STOPBITS_1_5;
+    break;
+
   case 2:
     huart_logdb.Init.StopBits = UART_STOPBITS_2;
     break;
@@ -611,11 +649,14 @@ void m1_usb_cdc_comconfig(void) {
     break;
   }
 
-  /* data type : 8bits and 9bits is supported */
+  /* data type : 7, 8 and 9 bits (parity included) are supported */
   switch (linecoding.datatype) {
   case 0x07:
-    /* configuration a parity (Even or Odd) */
-    huart_logdb.Init.WordLength = UART_WORDLENGTH_8B;
+    if (huart_logdb.Init.Parity == UART_PARITY_NONE) {
+      huart_logdb.Init.WordLength = UART_WORDLENGTH_7B;
+    } else {
+      huart_logdb.Init.WordLength = UART_WORDLENGTH_8B;
+    }
     break;
 
   case 0x08:
@@ -632,10 +673,58 @@ void m1_usb_cdc_comconfig(void) {
   }
 
   huart_logdb.Init.BaudRate = linecoding.bitrate;
+  if (huart_logdb.Init.BaudRate == 0) {
+    huart_logdb.Init.BaudRate = LOG_DEBUG_UART_BAUD;
+  }
+
+  if (HAL_UART_Init(&huart_logdb) != HAL_OK) {
+    usb_bridge_stats.uart_errors++;
+    return;
+  }
+  // The FIFO absorbs the DMA request latency at high baud rates
+  HAL_UARTEx_EnableFifoMode(&huart_logdb);
 
-  m1_logdb_init();
+  /* Restart the circular RX transfer from the start of the buffer */
+  taskENTER_CRITICAL();
+  head_usart1_dma = 0;
+  tail_usart1_dma = 0;
+  taskEXIT_CRITICAL();
+  __HAL_UART_ENABLE_IT(&huart_logdb, UART_IT_IDLE);
+  if (HAL_UART_Receive_DMA(&huart_logdb, (uint8_t *)logdb_rx_buffer,
+                           M1_LOGDB_RX_BUFFER_SIZE) != HAL_OK) {
+    usb_bridge_stats.uart_errors++;
+  }
+}
+
+/*============================================================================*/
+/**
+ * @brief  Returns the counters of the USB-USART1 bridge
+ * @param  pstats  filled with the counters
+ * @retval None.
+ */
+/*============================================================================*/
+void m1_usb_bridge_get_stats(S_M1_UsbBridge_Stats *pstats) {
+  *pstats = usb_bridge_stats;
 }
 
+/*============================================================================*/
+/**
+ * @brief  Counts a receive error of the bridge UART (overrun, framing, noise)
+ * @param  None.
+ * @retval None.
+ */
+/*============================================================================*/
+void m1_usb_bridge_count_error(void) { usb_bridge_stats.uart_errors++; }
+
+/*============================================================================*/
+/**
+ * @brief  Counts a USB OUT packet held back because USART1 is behind
+ * @param  None.
+ * @retval None.
+ */
+/*============================================================================*/
+void m1_usb_bridge_count_pause(void) { usb_bridge_stats.usb_rx_pauses++; }
+
 /*============================================================================*/
 /**
  * @brief  USB-CDC Initialization Function
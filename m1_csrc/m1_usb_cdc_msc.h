@@ -24,6 +24,7 @@
 #endif
 
 #include "usbd_cdc_if.h"
+#include "m1_cdc_stream.h"
 
 #include "app_freertos.h"
 #include "semphr.h"
@@ -34,18 +35,30 @@
 typedef enum
 {
   CDC_MODE_LOG_CLI = 0,
-  CDC_MODE_VCP
+  CDC_MODE_VCP,
+  CDC_MODE_STREAM /* CLI input, binary capture stream output (m1_cdc_stream.h) */
 } enCdcMode;
 
 /*********************************************/
 #define USB_FS_CHUNK_SIZE       64
 
 #define USB_RX_BUF_SIZE         1024  //128 //512 //1024  //(USB_FS_CHUNK_SIZE * 8)
-#define USB_TX_BUF_SIZE         1024  //(USB_FS_CHUNK_SIZE * 8)
+#define USB_TX_BUF_SIZE         2048  //(USB_FS_CHUNK_SIZE * 8)
+#define USB2SER_DMA_CHUNK_SIZE  1024  // Each of the two USART1 TX DMA buffers
 
-#define RXSTREAMBUF_UART_SIZE   256
+#define RXSTREAMBUF_UART_SIZE   4096  // ~44 ms of USART1 RX at 921600 baud
 #define RXSTREAMBUF_USB_SIZE    2048 //8192 //4096 //2048 //USB_RX_BUF_SIZE*2
 
+/*********************************************/
+/* USB-USART1 bridge (CDC_MODE_VCP) counters */
+typedef struct
+{
+  uint32_t uart_rx_dropped;  /* USART1 bytes lost, USB did not keep up */
+  uint32_t usb_rx_pauses;    /* USB OUT packets held back (NAK), USART1 busy */
+  uint32_t uart_tx_timeouts; /* USART1 TX DMA transfers aborted */
+  uint32_t uart_errors;      /* USART1 receive and setup errors */
+} S_M1_UsbBridge_Stats;
+
 /*********************************************/
 extern uint8_t CDC_InstID;
 
@@ -70,7 +83,6 @@ extern SemaphoreHandle_t usb2ser_tx_semaphore;
 
 extern volatile uint8_t usbcdc_rx_paused;
 extern volatile int8_t m1_USB_CDC_ready;
-extern volatile uint8_t tx_cptl_usart1;
 
 uint16_t usart_get_rx_data_length(void);
 void vUsb2SerTask(void *pvParameters);
@@ -82,8 +94,13 @@ void usb_rxdata_process(void);
 
 void USB_DRD_FS_IRQHandler(void);
 void CDC_Signal_Next_Tx(void);
+void m1_usb_cdc_stream(S_M1_CdcStream_Source source);
 void m1_usb_cdc_comdefault(void);
 void m1_usb_cdc_comconfig(void);
+void m1_usb_cdc_comconfig_from_isr(void);
+void m1_usb_bridge_get_stats(S_M1_UsbBridge_Stats *pstats);
+void m1_usb_bridge_count_error(void);
+void m1_usb_bridge_count_pause(void);
 
 /*********************************************/
 // USB MSC
@@ -91,6 +108,7 @@ extern volatile int8_t m1_USB_MSC_ready;
 
 uint8_t m1_usb_msc_process(void);
 uint8_t m1_usb_msc_sd_detected(void);
+void m1_usb_msc_flush(void);
 
 #endif /* M1_USB_CDC_MSC_H_ */
 
@@ -0,0 +1,606 @@
+/* See COPYING.txt for license details. */
+
+/*
+*
+* m1_usb_pd.c
+*
+* USB Power Delivery sink
+*
+* M1 Project
+*
+* Reference: USB Power Delivery Specification Rev. 3.1, chapters 6 and 8
+*/
+
+/*************************** I N C L U D E S **********************************/
+
+#include <stddef.h>
+#include <string.h>
+#include "m1_usb_pd.h"
+
+/*************************** D E F I N E S ************************************/
+
+//************************** C O N S T A N T **********************************/
+
+static const char *const sink_state_names[USB_PD_SNK_STATES] =
+{
+	"Detached",
+	"Wait caps",
+	"Select cap",
+	"Transition",
+	"Ready",
+	"Soft reset",
+	"Disabled"
+};
+
+//************************** S T R U C T U R E S *******************************
+
+/***************************** V A R I A B L E S ******************************/
+
+/********************* F U N C T I O N   P R O T O T Y P E S ******************/
+
+uint16_t m1_usb_pd_header(uint8_t type, uint8_t n_obj, uint8_t msg_id, uint8_t spec_rev);
+uint8_t m1_usb_pd_msg_encode(const S_M1_UsbPd_Msg *pmsg, uint8_t *buf);
+bool m1_usb_pd_msg_decode(const uint8_t *buf, uint8_t len, S_M1_UsbPd_Msg *pmsg);
+uint32_t m1_usb_pd_rdo_fixed(uint8_t position, uint16_t op_ma, uint16_t max_ma);
+uint8_t m1_usb_pd_select_pdo(const uint32_t *pdos, uint8_t n_pdos, uint16_t max_mv, uint16_t max_ma, uint16_t *pmv, uint16_t *pma);
+void m1_usb_pd_sink_init(S_M1_UsbPd_Sink *pe, const S_M1_UsbPd_Sink_Config *cfg);
+void m1_usb_pd_sink_attach(S_M1_UsbPd_Sink *pe, uint32_t now_ms);
+void m1_usb_pd_sink_detach(S_M1_UsbPd_Sink *pe);
+void m1_usb_pd_sink_rx(S_M1_UsbPd_Sink *pe, const S_M1_UsbPd_Msg *pmsg, uint32_t now_ms);
+void m1_usb_pd_sink_hard_reset_rx(S_M1_UsbPd_Sink *pe, uint32_t now_ms);
+void m1_usb_pd_sink_tick(S_M1_UsbPd_Sink *pe, uint32_t now_ms);
+uint32_t m1_usb_pd_sink_timeout(const S_M1_UsbPd_Sink *pe, uint32_t now_ms);
+const char *m1_usb_pd_sink_state_name(S_M1_UsbPd_Sink_State state);
+static void sink_timer_start(S_M1_UsbPd_Sink *pe, uint32_t now_ms, uint32_t period_ms);
+static void sink_enter(S_M1_UsbPd_Sink *pe, S_M1_UsbPd_Sink_State state, uint32_t now_ms, uint32_t period_ms);
+static void sink_protocol_reset(S_M1_UsbPd_Sink *pe);
+static void sink_contract_set(S_M1_UsbPd_Sink *pe, uint16_t mv, uint16_t ma);
+static bool sink_send(S_M1_UsbPd_Sink *pe, uint8_t type, uint8_t n_obj, const uint32_t *pobj);
+static void sink_hard_reset(S_M1_UsbPd_Sink *pe, uint32_t now_ms);
+static void sink_soft_reset(S_M1_UsbPd_Sink *pe, uint32_t now_ms);
+static void sink_unexpected(S_M1_UsbPd_Sink *pe, uint32_t now_ms);
+static void sink_evaluate_caps(S_M1_UsbPd_Sink *pe, const S_M1_UsbPd_Msg *pmsg, uint32_t now_ms);
+static void sink_send_caps(S_M1_UsbPd_Sink *pe);
+static void sink_rx_ctrl(S_M1_UsbPd_Sink *pe, uint8_t type, uint32_t now_ms);
+
+/*************** F U N C T I O N   I M P L E M E N T A T I O N ****************/
+
+/*============================================================================*/
+/*
+ * This function returns the header of a message sent by this sink: power role
+ * Sink, data role UFP.
+ */
+/*============================================================================*/
+uint16_t m1_usb_pd_header(uint8_t type, uint8_t n_obj, uint8_t msg_id, uint8_t spec_rev)
+{
+	return ((uint16_t)(n_obj & 0x07) << 12) | ((uint16_t)(msg_id & 0x07) << 9) | ((spec_rev & 0x03) << 6) | (type & 0x1F);
+} // uint16_t m1_usb_pd_header(uint8_t type, uint8_t n_obj, uint8_t msg_id, uint8_t spec_rev)
+
+
+
+/*============================================================================*/
+/*
+ * This function writes the header and data objects of a message little
+ * endian, as sent on the wire, and returns the number of bytes.
+ */
+/*============================================================================*/
+uint8_t m1_usb_pd_msg_encode(const S_M1_UsbPd_Msg *pmsg, uint8_t *buf)
+{
+	uint8_t i, n_obj = USB_PD_HDR_NUM_OBJ(pmsg->header);
+
+	buf[0] = pmsg->header & 0xFF;
+	buf[1] = pmsg->header >> 8;
+	for ( i = 0; i < n_obj; i++ )
+	{
+		buf[2 + 4*i] = pmsg->obj[i] & 0xFF;
+		buf[3 + 4*i] = (pmsg->obj[i] >> 8) & 0xFF;
+		buf[4 + 4*i] = (pmsg->obj[i] >> 16) & 0xFF;
+		buf[5 + 4*i] = pmsg->obj[i] >> 24;
+	}
+
+	return 2 + 4*n_obj;
+} // uint8_t m1_usb_pd_msg_encode(const S_M1_UsbPd_Msg *pmsg, uint8_t *buf)
+
+
+
+/*============================================================================*/
+/*
+ * This function reads a message from its bytes on the wire, the CRC
+ * excluded. It fails if the data objects of the header are missing.
+ */
+/*============================================================================*/
+bool m1_usb_pd_msg_decode(const uint8_t *buf, uint8_t len, S_M1_UsbPd_Msg *pmsg)
+{
+	uint8_t i, n_obj;
+
+	if ( len < 2 )
+		return false;
+	pmsg->header = buf[0] | ((uint16_t)buf[1] << 8);
+	n_obj = USB_PD_HDR_NUM_OBJ(pmsg->header);
+	if ( len < 2 + 4*n_obj )
+		return false;
+
+	memset(pmsg->obj, 0, sizeof(pmsg->obj));
+	for ( i = 0; i < n_obj; i++ )
+	{
+		pmsg->obj[i] = buf[2 + 4*i] | ((uint32_t)buf[3 + 4*i] << 8) | ((uint32_t)buf[4 + 4*i] << 16)
+			| ((uint32_t)buf[5 + 4*i] << 24);
+	}
+
+	return true;
+} // bool m1_usb_pd_msg_decode(const uint8_t *buf, uint8_t len, S_M1_UsbPd_Msg *pmsg)
+
+
+
+/*============================================================================*/
+/*
+ * This function returns the request data object of a fixed supply. The sink
+ * has USB data and keeps charging while the bus is suspended.
+ */
+/*============================================================================*/
+uint32_t m1_usb_pd_rdo_fixed(uint8_t position, uint16_t op_ma, uint16_t max_ma)
+{
+	return ((uint32_t)(position & 0x07) << 28) | USB_PD_RDO_USB_COMM | USB_PD_RDO_NO_USB_SUSPEND
+		| ((uint32_t)((op_ma/10) & 0x3FF) << 10) | ((max_ma/10) & 0x3FF);
+} // uint32_t m1_usb_pd_rdo_fixed(uint8_t position, uint16_t op_ma, uint16_t max_ma)
+
+
+
+/*============================================================================*/
+/*
+ * This function picks the fixed supply with the most power within max_mv and
+ * max_ma, the lower voltage on a tie. It returns its 1 based position, or 0
+ * if the capabilities do not start with vSafe5V as they must.
+ */
+/*============================================================================*/
+uint8_t m1_usb_pd_select_pdo(const uint32_t *pdos, uint8_t n_pdos, uint16_t max_mv, uint16_t max_ma, uint16_t *pmv, uint16_t *pma)
+{
+	uint32_t power, best_power = 0;
+	uint16_t mv, ma;
+	uint8_t i, best = 0;
+
+	if ( !n_pdos || USB_PD_PDO_TYPE(pdos[0])!=USB_PD_PDO_FIXED || USB_PD_PDO_FIXED_MV(pdos[0])!=USB_PD_VSAFE5V_MV )
+		return 0;
+
+	for ( i = 0; i < n_pdos && i < USB_PD_MAX_DATA_OBJ; i++ )
+	{
+		if ( USB_PD_PDO_TYPE(pdos[i])!=USB_PD_PDO_FIXED )
+			continue;
+		mv = USB_PD_PDO_FIXED_MV(pdos[i]);
+		ma = USB_PD_PDO_FIXED_MA(pdos[i]);
+		if ( mv > max_mv )
+			continue;
+		if ( ma > max_ma )
+			ma = max_ma;
+		power = (uint32_t)mv*ma;
+		if ( !best || power > best_power )
+		{
+			best = i + 1;
+			best_power = power;
+			*pmv = mv;
+			*pma = ma;
+		}
+	} // for ( i = 0; i < n_pdos && i < USB_PD_MAX_DATA_OBJ; i++ )
+
+	return best;
+} // uint8_t m1_usb_pd_select_pdo(const uint32_t *pdos, uint8_t n_pdos, uint16_t max_mv, uint16_t max_ma, uint16_t *pmv, uint16_t *pma)
+
+
+
+/*============================================================================*/
+/*
+ * This function initializes a detached sink. The contract starts at the
+ * Type-C default without calling back.
+ */
+/*============================================================================*/
+void m1_usb_pd_sink_init(S_M1_UsbPd_Sink *pe, const S_M1_UsbPd_Sink_Config *cfg)
+{
+	memset(pe, 0, sizeof(*pe));
+	pe->cfg = cfg;
+	pe->rx_id = -1;
+	pe->contract_mv = USB_PD_VSAFE5V_MV;
+	pe->contract_ma = USB_PD_DEFAULT_MA;
+} // void m1_usb_pd_sink_init(S_M1_UsbPd_Sink *pe, const S_M1_UsbPd_Sink_Config *cfg)
+
+
+
+// A source is attached: wait for its capabilities
+void m1_usb_pd_sink_attach(S_M1_UsbPd_Sink *pe, uint32_t now_ms)
+{
+	sink_protocol_reset(pe);
+	pe->hard_resets = 0;
+	pe->n_pdos = 0;
+	sink_enter(pe, USB_PD_SNK_WAIT_CAPS, now_ms, USB_PD_T_SINK_WAIT_CAP);
+} // void m1_usb_pd_sink_attach(S_M1_UsbPd_Sink *pe, uint32_t now_ms)
+
+
+
+void m1_usb_pd_sink_detach(S_M1_UsbPd_Sink *pe)
+{
+	pe->state = USB_PD_SNK_DETACHED;
+	pe->timer_on = false;
+	pe->n_pdos = 0;
+	pe->req_position = 0;
+	pe->explicit_contract = false;
+	sink_contract_set(pe, USB_PD_VSAFE5V_MV, USB_PD_DEFAULT_MA);
+} // void m1_usb_pd_sink_detach(S_M1_UsbPd_Sink *pe)
+
+
+
+/*============================================================================*/
+/*
+ * This function handles a message from the source. A retry of the last
+ * message, same MessageID, is dropped; Soft_Reset always goes through.
+ */
+/*============================================================================*/
+void m1_usb_pd_sink_rx(S_M1_UsbPd_Sink *pe, const S_M1_UsbPd_Msg *pmsg, uint32_t now_ms)
+{
+	uint8_t type = USB_PD_HDR_TYPE(pmsg->header);
+	uint8_t n_obj = USB_PD_HDR_NUM_OBJ(pmsg->header);
+	int8_t id = USB_PD_HDR_ID(pmsg->header);
+
+	if ( pe->state==USB_PD_SNK_DETACHED )
+		return;
+	if ( !n_obj && type==USB_PD_CTRL_GOODCRC )
+		return; // The PHY's business
+
+	if ( !n_obj && type==USB_PD_CTRL_SOFT_RESET )
+	{
+		sink_protocol_reset(pe);
+		pe->rx_id = id;
+		if ( !sink_send(pe, USB_PD_CTRL_ACCEPT, 0, NULL) )
+		{
+			sink_hard_reset(pe, now_ms);
+			return;
+		}
+		// The power contract stays until the next one
+		sink_enter(pe, USB_PD_SNK_WAIT_CAPS, now_ms, USB_PD_T_SINK_WAIT_CAP);
+		return;
+	} // if ( !n_obj && type==USB_PD_CTRL_SOFT_RESET )
+
+	if ( id==pe->rx_id )
+		return;
+	pe->rx_id = id;
+
+	if ( USB_PD_HDR_EXTENDED(pmsg->header) )
+	{
+		sink_unexpected(pe, now_ms);
+		return;
+	}
+	if ( !n_obj )
+	{
+		sink_rx_ctrl(pe, type, now_ms);
+		return;
+	}
+
+	switch ( type )
+	{
+		case USB_PD_DATA_SOURCE_CAP:
+			if ( pe->state==USB_PD_SNK_TRANSITION )
+				sink_hard_reset(pe, now_ms);
+			else
+				sink_evaluate_caps(pe, pmsg, now_ms);
+			break;
+
+		case USB_PD_DATA_VENDOR_DEFINED:
+		case USB_PD_DATA_BIST:
+			break; // Ignored, as by a device without VDM or BIST support
+
+		default:
+			sink_unexpected(pe, now_ms);
+			break;
+	} // switch ( type )
+} // void m1_usb_pd_sink_rx(S_M1_UsbPd_Sink *pe, const S_M1_UsbPd_Msg *pmsg, uint32_t now_ms)
+
+
+
+/*============================================================================*/
+/*
+ * This function handles Hard Reset signaled by the source: the source goes
+ * back to vSafe5V and sends its capabilities again.
+ */
+/*============================================================================*/
+void m1_usb_pd_sink_hard_reset_rx(S_M1_UsbPd_Sink *pe, uint32_t now_ms)
+{
+	if ( pe->state==USB_PD_SNK_DETACHED )
+		return;
+
+	sink_protocol_reset(pe);
+	pe->explicit_contract = false;
+	sink_contract_set(pe, USB_PD_VSAFE5V_MV, USB_PD_DEFAULT_MA);
+	sink_enter(pe, USB_PD_SNK_WAIT_CAPS, now_ms, USB_PD_T_HARD_RESET_RECOVER);
+} // void m1_usb_pd_sink_hard_reset_rx(S_M1_UsbPd_Sink *pe, uint32_t now_ms)
+
+
+
+/*============================================================================*/
+/*
+ * This function runs the timer of the current state. A source that does not
+ * answer gets Hard Reset, one that never sends capabilities is not PD.
+ */
+/*============================================================================*/
+void m1_usb_pd_sink_tick(S_M1_UsbPd_Sink *pe, uint32_t now_ms)
+{
+	if ( !pe->timer_on || (int32_t)(now_ms - pe->deadline_ms) < 0 )
+		return;
+	pe->timer_on = false;
+
+	switch ( pe->state )
+	{
+		case USB_PD_SNK_WAIT_CAPS:
+		case USB_PD_SNK_SELECT_CAP:
+		case USB_PD_SNK_TRANSITION:
+		case USB_PD_SNK_SOFT_RESET:
+			sink_hard_reset(pe, now_ms);
+			break;
+
+		default:
+			break;
+	} // switch ( pe->state )
+} // void m1_usb_pd_sink_tick(S_M1_UsbPd_Sink *pe, uint32_t now_ms)
+
+
+
+// Time left until the next call to m1_usb_pd_sink_tick() is due, UINT32_MAX if none
+uint32_t m1_usb_pd_sink_timeout(const S_M1_UsbPd_Sink *pe, uint32_t now_ms)
+{
+	if ( !pe->timer_on )
+		return UINT32_MAX;
+	if ( (int32_t)(pe->deadline_ms - now_ms) <= 0 )
+		return 0;
+
+	return pe->deadline_ms - now_ms;
+} // uint32_t m1_usb_pd_sink_timeout(const S_M1_UsbPd_Sink *pe, uint32_t now_ms)
+
+
+
+const char *m1_usb_pd_sink_state_name(S_M1_UsbPd_Sink_State state)
+{
+	if ( state >= USB_PD_SNK_STATES )
+		return "?";
+
+	return sink_state_names[state];
+} // const char *m1_usb_pd_sink_state_name(S_M1_UsbPd_Sink_State state)
+
+
+
+static void sink_timer_start(S_M1_UsbPd_Sink *pe, uint32_t now_ms, uint32_t period_ms)
+{
+	pe->timer_on = true;
+	pe->deadline_ms = now_ms + period_ms;
+} // static void sink_timer_start(S_M1_UsbPd_Sink *pe, uint32_t now_ms, uint32_t period_ms)
+
+
+
+// Enters state with a timer of period_ms, none if 0
+static void sink_enter(S_M1_UsbPd_Sink *pe, S_M1_UsbPd_Sink_State state, uint32_t now_ms, uint32_t period_ms)
+{
+	pe->state = state;
+	pe->timer_on = false;
+	if ( period_ms )
+		sink_timer_start(pe, now_ms, period_ms);
+} // static void sink_enter(S_M1_UsbPd_Sink *pe, S_M1_UsbPd_Sink_State state, uint32_t now_ms, uint32_t period_ms)
+
+
+
+// Message IDs start over after any reset, the revision is agreed again
+static void sink_protocol_reset(S_M1_UsbPd_Sink *pe)
+{
+	pe->tx_id = 0;
+	pe->rx_id = -1;
+	pe->spec_rev = pe->cfg->spec_rev;
+} // static void sink_protocol_reset(S_M1_UsbPd_Sink *pe)
+
+
+
+static void sink_contract_set(S_M1_UsbPd_Sink *pe, uint16_t mv, uint16_t ma)
+{
+	if ( pe->contract_mv==mv && pe->contract_ma==ma )
+		return;
+
+	pe->contract_mv = mv;
+	pe->contract_ma = ma;
+	if ( pe->cfg->contract!=NULL )
+		pe->cfg->contract(pe->cfg->ctx, mv, ma);
+} // static void sink_contract_set(S_M1_UsbPd_Sink *pe, uint16_t mv, uint16_t ma)
+
+
+
+/*============================================================================*/
+/*
+ * This function sends a message. The MessageID moves on whether or not the
+ * PHY got a GoodCRC, as the protocol layer does after its retries.
+ */
+/*============================================================================*/
+static bool sink_send(S_M1_UsbPd_Sink *pe, uint8_t type, uint8_t n_obj, const uint32_t *pobj)
+{
+	S_M1_UsbPd_Msg msg;
+	bool sent;
+
+	memset(&msg, 0, sizeof(msg));
+	msg.header = m1_usb_pd_header(type, n_obj, pe->tx_id, pe->spec_rev);
+	if ( n_obj )
+		memcpy(msg.obj, pobj, n_obj*sizeof(uint32_t));
+
+	sent = pe->cfg->transmit(pe->cfg->ctx, &msg);
+	pe->tx_id = (pe->tx_id + 1) & 0x07;
+
+	return sent;
+} // static bool sink_send(S_M1_UsbPd_Sink *pe, uint8_t type, uint8_t n_obj, const uint32_t *pobj)
+
+
+
+/*============================================================================*/
+/*
+ * This function signals Hard Reset, and drops back to the Type-C current if
+ * the source did not recover from nHardResetCount of them.
+ */
+/*============================================================================*/
+static void sink_hard_reset(S_M1_UsbPd_Sink *pe, uint32_t now_ms)
+{
+	sink_protocol_reset(pe);
+	pe->explicit_contract = false;
+	pe->req_position = 0;
+	sink_contract_set(pe, USB_PD_VSAFE5V_MV, USB_PD_DEFAULT_MA);
+
+	if ( pe->hard_resets >= USB_PD_N_HARD_RESET )
+	{
+		sink_enter(pe, USB_PD_SNK_DISABLED, now_ms, 0);
+		return;
+	}
+	pe->hard_resets++;
+	if ( pe->cfg->hard_reset!=NULL )
+		pe->cfg->hard_reset(pe->cfg->ctx);
+	sink_enter(pe, USB_PD_SNK_WAIT_CAPS, now_ms, USB_PD_T_HARD_RESET_RECOVER);
+} // static void sink_hard_reset(S_M1_UsbPd_Sink *pe, uint32_t now_ms)
+
+
+
+static void sink_soft_reset(S_M1_UsbPd_Sink *pe, uint32_t now_ms)
+{
+	sink_protocol_reset(pe);
+	if ( !sink_send(pe, USB_PD_CTRL_SOFT_RESET, 0, NULL) )
+	{
+		sink_hard_reset(pe, now_ms);
+		return;
+	}
+	sink_enter(pe, USB_PD_SNK_SOFT_RESET, now_ms, USB_PD_T_SENDER_RESPONSE);
+} // static void sink_soft_reset(S_M1_UsbPd_Sink *pe, uint32_t now_ms)
+
+
+
+/*============================================================================*/
+/*
+ * This function answers a message this sink does not expect now: a protocol
+ * error during a negotiation, Not_Supported (Reject in PD 2.0) otherwise.
+ */
+/*============================================================================*/
+static void sink_unexpected(S_M1_UsbPd_Sink *pe, uint32_t now_ms)
+{
+	switch ( pe->state )
+	{
+		case USB_PD_SNK_TRANSITION:
+			sink_hard_reset(pe, now_ms); // The supply may be changing
+			break;
+
+		case USB_PD_SNK_SELECT_CAP:
+		case USB_PD_SNK_SOFT_RESET:
+			sink_soft_reset(pe, now_ms);
+			break;
+
+		default:
+			sink_send(pe, (pe->spec_rev >= USB_PD_REV30) ? USB_PD_CTRL_NOT_SUPPORTED : USB_PD_CTRL_REJECT, 0, NULL);
+			break;
+	} // switch ( pe->state )
+} // static void sink_unexpected(S_M1_UsbPd_Sink *pe, uint32_t now_ms)
+
+
+
+/*============================================================================*/
+/*
+ * This function requests the best supply of new source capabilities. The
+ * contract revision is the lower of the two sides, PD 2.0 at least.
+ */
+/*============================================================================*/
+static void sink_evaluate_caps(S_M1_UsbPd_Sink *pe, const S_M1_UsbPd_Msg *pmsg, uint32_t now_ms)
+{
+	uint32_t rdo;
+	uint16_t mv = USB_PD_VSAFE5V_MV, ma = 0;
+	uint8_t rev = USB_PD_HDR_REV(pmsg->header);
+	uint8_t position;
+
+	pe->n_pdos = USB_PD_HDR_NUM_OBJ(pmsg->header);
+	memcpy(pe->pdos, pmsg->obj, pe->n_pdos*sizeof(uint32_t));
+	if ( rev < USB_PD_REV20 )
+		rev = USB_PD_REV20;
+	pe->spec_rev = (rev < pe->cfg->spec_rev) ? rev : pe->cfg->spec_rev;
+
+	position = m1_usb_pd_select_pdo(pe->pdos, pe->n_pdos, pe->cfg->max_mv, pe->cfg->max_ma, &mv, &ma);
+	if ( !position )
+	{
+		sink_hard_reset(pe, now_ms); // Invalid capabilities
+		return;
+	}
+
+	rdo = m1_usb_pd_rdo_fixed(position, ma, ma);
+	if ( !sink_send(pe, USB_PD_DATA_REQUEST, 1, &rdo) )
+	{
+		sink_hard_reset(pe, now_ms);
+		return;
+	}
+	pe->req_position = position;
+	pe->req_mv = mv;
+	pe->req_ma = ma;
+	sink_enter(pe, USB_PD_SNK_SELECT_CAP, now_ms, USB_PD_T_SENDER_RESPONSE);
+} // static void sink_evaluate_caps(S_M1_UsbPd_Sink *pe, const S_M1_UsbPd_Msg *pmsg, uint32_t now_ms)
+
+
+
+// vSafe5V first, then the highest voltage asked for if it is above
+static void sink_send_caps(S_M1_UsbPd_Sink *pe)
+{
+	uint32_t pdos[2];
+	uint8_t n = 1;
+
+	pdos[0] = USB_PD_PDO_FIXED_USB_COMM | ((uint32_t)(USB_PD_VSAFE5V_MV/50) << 10) | ((pe->cfg->max_ma/10) & 0x3FF);
+	if ( pe->cfg->max_mv > USB_PD_VSAFE5V_MV )
+	{
+		pdos[0] |= USB_PD_PDO_FIXED_HIGHER_CAP;
+		pdos[n++] = ((uint32_t)((pe->cfg->max_mv/50) & 0x3FF) << 10) | ((pe->cfg->max_ma/10) & 0x3FF);
+	}
+	sink_send(pe, USB_PD_DATA_SINK_CAP, n, pdos);
+} // static void sink_send_caps(S_M1_UsbPd_Sink *pe)
+
+
+
+static void sink_rx_ctrl(S_M1_UsbPd_Sink *pe, uint8_t type, uint32_t now_ms)
+{
+	switch ( type )
+	{
+		case USB_PD_CTRL_ACCEPT:
+			if ( pe->state==USB_PD_SNK_SELECT_CAP )
+				sink_enter(pe, USB_PD_SNK_TRANSITION, now_ms, USB_PD_T_PS_TRANSITION);
+			else if ( pe->state==USB_PD_SNK_SOFT_RESET )
+				sink_enter(pe, USB_PD_SNK_WAIT_CAPS, now_ms, USB_PD_T_SINK_WAIT_CAP);
+			else
+				sink_unexpected(pe, now_ms);
+			break;
+
+		case USB_PD_CTRL_REJECT:
+		case USB_PD_CTRL_WAIT:
+			if ( pe->state!=USB_PD_SNK_SELECT_CAP )
+				sink_unexpected(pe, now_ms);
+			else if ( pe->explicit_contract )
+				sink_enter(pe, USB_PD_SNK_READY, now_ms, 0); // The previous contract holds
+			else
+				sink_enter(pe, USB_PD_SNK_WAIT_CAPS, now_ms, USB_PD_T_SINK_WAIT_CAP);
+			break;
+
+		case USB_PD_CTRL_PS_RDY:
+			if ( pe->state!=USB_PD_SNK_TRANSITION )
+			{
+				sink_unexpected(pe, now_ms);
+				break;
+			}
+			pe->explicit_contract = true;
+			pe->hard_resets = 0;
+			sink_enter(pe, USB_PD_SNK_READY, now_ms, 0);
+			sink_contract_set(pe, pe->req_mv, pe->req_ma);
+			break;
+
+		case USB_PD_CTRL_GET_SINK_CAP:
+			if ( pe->state==USB_PD_SNK_SELECT_CAP || pe->state==USB_PD_SNK_TRANSITION )
+				sink_unexpected(pe, now_ms);
+			else
+				sink_send_caps(pe);
+			break;
+
+		case USB_PD_CTRL_PING:
+		case USB_PD_CTRL_GOTOMIN: // Nothing was offered to give back
+			break;
+
+		default: // Swaps, Get_Source_Cap and the others
+			sink_unexpected(pe, now_ms);
+			break;
+	} // switch ( type )
+} // static void sink_rx_ctrl(S_M1_UsbPd_Sink *pe, uint8_t type, uint32_t now_ms)
@@ -0,0 +1,164 @@
+/* See COPYING.txt for license details. */
+
+/*
+*
+* m1_usb_pd.h
+*
+* Header for the USB Power Delivery sink
+*
+* PD message encoding and the sink policy engine: it waits for the source
+* capabilities, requests the fixed supply with the most power within the
+* sink limits and reports the contract once the source is ready. The engine
+* does not touch the hardware: the PHY driver passes it the received
+* messages and the time, and it sends through the callbacks of its config.
+* GoodCRC is left to the PHY.
+*
+* M1 Project
+*
+* Reference: USB Power Delivery Specification Rev. 3.1, chapters 6 and 8
+*/
+
+#ifndef M1_USB_PD_H_
+#define M1_USB_PD_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define USB_PD_MAX_DATA_OBJ			7
+#define USB_PD_MAX_MSG_LEN			(2 + 4*USB_PD_MAX_DATA_OBJ) // Header and data objects, no CRC
+
+#define USB_PD_REV20				1
+#define USB_PD_REV30				2
+
+#define USB_PD_VSAFE5V_MV			5000
+#define USB_PD_DEFAULT_MA			500 // Type-C default current of a USB 2.0 port
+
+// Timers in ms, the upper limits of the spec
+#define USB_PD_T_SINK_WAIT_CAP		620
+#define USB_PD_T_SENDER_RESPONSE	30
+#define USB_PD_T_PS_TRANSITION		550
+#define USB_PD_T_HARD_RESET_RECOVER	2000 // VBUS off and on again, then the first capabilities
+#define USB_PD_N_HARD_RESET			2
+
+// Message header
+#define USB_PD_HDR_TYPE(h)			((h) & 0x1F)
+#define USB_PD_HDR_REV(h)			(((h) >> 6) & 0x03)
+#define USB_PD_HDR_ID(h)			(((h) >> 9) & 0x07)
+#define USB_PD_HDR_NUM_OBJ(h)		(((h) >> 12) & 0x07)
+#define USB_PD_HDR_EXTENDED(h)		(((h) >> 15) & 0x01)
+
+typedef enum
+{
+	USB_PD_CTRL_GOODCRC = 0x01,
+	USB_PD_CTRL_GOTOMIN = 0x02,
+	USB_PD_CTRL_ACCEPT = 0x03,
+	USB_PD_CTRL_REJECT = 0x04,
+	USB_PD_CTRL_PING = 0x05,
+	USB_PD_CTRL_PS_RDY = 0x06,
+	USB_PD_CTRL_GET_SOURCE_CAP = 0x07,
+	USB_PD_CTRL_GET_SINK_CAP = 0x08,
+	USB_PD_CTRL_DR_SWAP = 0x09,
+	USB_PD_CTRL_PR_SWAP = 0x0A,
+	USB_PD_CTRL_VCONN_SWAP = 0x0B,
+	USB_PD_CTRL_WAIT = 0x0C,
+	USB_PD_CTRL_SOFT_RESET = 0x0D,
+	USB_PD_CTRL_NOT_SUPPORTED = 0x10
+} S_M1_UsbPd_Ctrl_Type;
+
+typedef enum
+{
+	USB_PD_DATA_SOURCE_CAP = 0x01,
+	USB_PD_DATA_REQUEST = 0x02,
+	USB_PD_DATA_BIST = 0x03,
+	USB_PD_DATA_SINK_CAP = 0x04,
+	USB_PD_DATA_VENDOR_DEFINED = 0x0F
+} S_M1_UsbPd_Data_Type;
+
+// Power data object
+typedef enum
+{
+	USB_PD_PDO_FIXED = 0,
+	USB_PD_PDO_BATTERY,
+	USB_PD_PDO_VARIABLE,
+	USB_PD_PDO_AUGMENTED // PPS and others, not requested by this sink
+} S_M1_UsbPd_Pdo_Type;
+
+#define USB_PD_PDO_TYPE(pdo)			((S_M1_UsbPd_Pdo_Type)((pdo) >> 30))
+#define USB_PD_PDO_FIXED_MV(pdo)		((((pdo) >> 10) & 0x3FF)*50)
+#define USB_PD_PDO_FIXED_MA(pdo)		(((pdo) & 0x3FF)*10)
+#define USB_PD_PDO_FIXED_HIGHER_CAP		(1UL << 28) // Sink PDO: needs more than vSafe5V
+#define USB_PD_PDO_FIXED_USB_COMM		(1UL << 26)
+
+// Request data object of a fixed supply
+#define USB_PD_RDO_POSITION(rdo)		(((rdo) >> 28) & 0x07)
+#define USB_PD_RDO_MISMATCH				(1UL << 26)
+#define USB_PD_RDO_USB_COMM				(1UL << 25)
+#define USB_PD_RDO_NO_USB_SUSPEND		(1UL << 24)
+
+typedef struct
+{
+	uint16_t header;
+	uint32_t obj[USB_PD_MAX_DATA_OBJ];
+} S_M1_UsbPd_Msg;
+
+typedef enum
+{
+	USB_PD_SNK_DETACHED = 0,
+	USB_PD_SNK_WAIT_CAPS,		// Attached, waiting for Source_Capabilities
+	USB_PD_SNK_SELECT_CAP,		// Request sent, waiting for Accept
+	USB_PD_SNK_TRANSITION,		// Accepted, waiting for PS_RDY
+	USB_PD_SNK_READY,			// Explicit contract
+	USB_PD_SNK_SOFT_RESET,		// Soft_Reset sent, waiting for Accept
+	USB_PD_SNK_DISABLED,		// Not a PD source, Type-C current only until detached
+	USB_PD_SNK_STATES
+} S_M1_UsbPd_Sink_State;
+
+typedef struct
+{
+	uint16_t max_mv; // Highest fixed supply voltage requested
+	uint16_t max_ma; // Highest current drawn
+	uint8_t spec_rev; // Highest revision spoken, USB_PD_REV20 or USB_PD_REV30
+	// Sends a message, false if the PHY got no GoodCRC
+	bool (*transmit)(void *ctx, const S_M1_UsbPd_Msg *pmsg);
+	void (*hard_reset)(void *ctx); // Signals Hard Reset
+	// New power limits, vSafe5V at USB_PD_DEFAULT_MA when a contract is lost
+	void (*contract)(void *ctx, uint16_t mv, uint16_t ma);
+	void *ctx;
+} S_M1_UsbPd_Sink_Config;
+
+typedef struct
+{
+	const S_M1_UsbPd_Sink_Config *cfg;
+	S_M1_UsbPd_Sink_State state;
+	bool timer_on;
+	uint32_t deadline_ms;
+	uint8_t spec_rev; // Of the contract
+	uint8_t tx_id; // MessageIDCounter
+	int8_t rx_id; // MessageID of the last message received, -1 if none
+	uint8_t hard_resets;
+	uint8_t n_pdos;
+	uint32_t pdos[USB_PD_MAX_DATA_OBJ]; // Last source capabilities
+	uint8_t req_position; // 1 based, 0 if no request
+	uint16_t req_mv;
+	uint16_t req_ma;
+	bool explicit_contract;
+	uint16_t contract_mv;
+	uint16_t contract_ma;
+} S_M1_UsbPd_Sink;
+
+uint16_t m1_usb_pd_header(uint8_t type, uint8_t n_obj, uint8_t msg_id, uint8_t spec_rev);
+uint8_t m1_usb_pd_msg_encode(const S_M1_UsbPd_Msg *pmsg, uint8_t *buf);
+bool m1_usb_pd_msg_decode(const uint8_t *buf, uint8_t len, S_M1_UsbPd_Msg *pmsg);
+uint32_t m1_usb_pd_rdo_fixed(uint8_t position, uint16_t op_ma, uint16_t max_ma);
+uint8_t m1_usb_pd_select_pdo(const uint32_t *pdos, uint8_t n_pdos, uint16_t max_mv, uint16_t max_ma, uint16_t *pmv, uint16_t *pma);
+
+void m1_usb_pd_sink_init(S_M1_UsbPd_Sink *pe, const S_M1_UsbPd_Sink_Config *cfg);
+void m1_usb_pd_sink_attach(S_M1_UsbPd_Sink *pe, uint32_t now_ms);
+void m1_usb_pd_sink_detach(S_M1_UsbPd_Sink *pe);
+void m1_usb_pd_sink_rx(S_M1_UsbPd_Sink *pe, const S_M1_UsbPd_Msg *pmsg, uint32_t now_ms);
+void m1_usb_pd_sink_hard_reset_rx(S_M1_UsbPd_Sink *pe, uint32_t now_ms);
+void m1_usb_pd_sink_tick(S_M1_UsbPd_Sink *pe, uint32_t now_ms);
+uint32_t m1_usb_pd_sink_timeout(const S_M1_UsbPd_Sink *pe, uint32_t now_ms);
+const char *m1_usb_pd_sink_state_name(S_M1_UsbPd_Sink_State state);
+
+#endif /* M1_USB_PD_H_ */
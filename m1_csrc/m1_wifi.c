@@ -15,7 +15,10 @@
 #include "m1_wifi.h"
 #include "m1_esp32_hal.h"
 #include "m1_virtual_kb.h"
+#include "m1_sdcard.h"
 #include "m1_wifi_cred.h"
+#include "m1_wifi_mon.h"
+#include "m1_wifi_sta.h"
 #include "main.h"
 #include "stm32h5xx_hal.h"
 #include <stdbool.h>
@@ -35,10 +38,32 @@
 
 #define M1_GUI_ROW_SPACING 1
 
+#define WIFI_STA_PUMP_MS 200 // Longest hold of the AT link per response read
+#define WIFI_STA_RX_BUF_SIZE 512
+#define WIFI_STA_LINE_SIZE 160
+#define WIFI_STA_JOIN_WAIT_MS 30000 // First join result of a user join
+#define WIFI_STA_STATUS_REFRESH_MS 1000
+
+#define WIFI_MON_SWEEP_TIMEOUT 10 // seconds
+#define WIFI_MON_KEY_WAIT_MS 100 // Between sweeps
+#define WIFI_MON_GRAPH_TOP 14
+#define WIFI_MON_GRAPH_BOTTOM 51 // Baseline of the bars
+#define WIFI_MON_BAR_PITCH 9
+
 //************************** S T R U C T U R E S *******************************
 
 /***************************** V A R I A B L E S ******************************/
 
+TaskHandle_t wifi_sta_task_hdl;
+
+// The station manager and the blocking scan/join requests share the AT link
+static SemaphoreHandle_t wifi_at_mutex = NULL;
+static StaticSemaphore_t wifi_at_mutex_storage;
+static S_M1_Wifi_Sta wifi_sta;
+static bool wifi_sta_ready = false;
+// Static: the statistics do not fit the stack of the calling task
+static S_M1_Wifi_Mon wifi_mon;
+
 /********************* F U N C T I O N   P R O T O T Y P E S ******************/
 
 void menu_wifi_init(void);
@@ -52,6 +77,20 @@ static uint16_t wifi_ap_list_print(ctrl_cmd_t *app_resp, bool up_dir);
 static uint8_t wifi_ap_list_validation(ctrl_cmd_t *app_resp);
 static void wifi_auto_connect(void);
 static bool wifi_ensure_initialized(void);
+void wifi_at_lock(void);
+void wifi_at_unlock(void);
+bool wifi_sta_active(void);
+static bool wifi_sta_send(void *ctx, const char *cmd);
+static void wifi_sta_feed(const char *block, uint32_t now_ms);
+void wifi_sta_task(void *param);
+static void wifi_sta_start(const char *ssid, const char *pwd);
+static void wifi_sta_stop(void);
+void wifi_sta_link_reset(void);
+static void wifi_sta_status(S_M1_Wifi_Sta *pstatus);
+static bool wifi_sta_join_wait(S_M1_Wifi_Sta *pstatus);
+void wifi_monitor(void);
+static bool wifi_monitor_sweep(void);
+static void wifi_monitor_print(uint8_t channel, bool hist, bool logging);
 
 /*************** F U N C T I O N   I M P L E M E N T A T I O N ****************/
 
@@ -110,7 +149,9 @@ void wifi_scan_ap(void) {
     app_req.cmd_timeout_sec =
         M1_WIFI_AP_SCANNING_TIME; // DEFAULT_CTRL_RESP_TIMEOUT //30 sec
     app_req.msg_id = CTRL_RESP_GET_AP_SCAN_LIST;
+    wifi_at_lock();
     ret = wifi_ap_scan_list(&app_req);
+    wifi_at_unlock();
     ret = wifi_ap_list_validation(&app_req);
     if (ret) {
       list_count = wifi_ap_list_print(&app_req, true);
@@ -161,7 +202,8 @@ void wifi_scan_ap(void) {
           wifi_ap_list_print(NULL, false);
 
           xQueueReset(main_q_hdl); // Reset main q before return
-          m1_esp32_deinit();
+          if (!wifi_sta_active())
+            m1_esp32_deinit(); // Keep the link of a joined network
           break; // Exit and return to the calling task (subfunc_handler_task)
         } // if ( m1_buttons_status[BUTTON_BACK_KP_ID]==BUTTON_EVENT_CLICK )
         else if (this_button_status.event[BUTTON_UP_KP_ID] ==
@@ -433,22 +475,15 @@ static void wifi_auto_connect(void) {
   if (!get_esp32_main_init_status())
     return;
 
-  ctrl_cmd_t connect_req = CTRL_CMD_DEFAULT_REQ();
-  connect_req.cmd_timeout_sec = 10;
-  connect_req.msg_id = CTRL_REQ_CONNECT_AP;
-  snprintf((char *)connect_req.u.wifi_ap_config.ssid, SSID_LENGTH, "%s",
-           cred.ssid);
-
+  char decrypted_pwd[WIFI_MAX_PASSWORD_LEN + 1] = {0};
   if (cred.encrypted_len > 0) {
-    char decrypted_pwd[WIFI_MAX_PASSWORD_LEN + 1];
     wifi_cred_decrypt(cred.encrypted_password, (uint8_t *)decrypted_pwd,
                       cred.encrypted_len);
-    snprintf((char *)connect_req.u.wifi_ap_config.pwd, PASSWORD_LENGTH, "%s",
-             decrypted_pwd);
-    memset(decrypted_pwd, 0, sizeof(decrypted_pwd));
   }
 
-  (void)wifi_connect_ap(&connect_req); // silent fail by design
+  // Joins in the background and keeps rejoining, silent by design
+  wifi_sta_start(cred.ssid, decrypted_pwd);
+  memset(decrypted_pwd, 0, sizeof(decrypted_pwd));
 }
 
 static bool wifi_ensure_initialized(void) {
@@ -494,7 +529,9 @@ void wifi_join_network(void) {
   if (get_esp32_main_init_status()) {
     app_req.cmd_timeout_sec = M1_WIFI_AP_SCANNING_TIME;
     app_req.msg_id = CTRL_RESP_GET_AP_SCAN_LIST;
+    wifi_at_lock();
     ret = wifi_ap_scan_list(&app_req);
+    wifi_at_unlock();
     ret = wifi_ap_list_validation(&app_req);
 
     if (ret) {
@@ -726,20 +763,11 @@ void wifi_join_network(void) {
                     M1_LCD_DISPLAY_HEIGHT / 2 - 2, 18, 32, hourglass_18x32);
       m1_u8g2_nextpage();
 
-      // Prepare connect request
-      ctrl_cmd_t connect_req = CTRL_CMD_DEFAULT_REQ();
-      connect_req.cmd_timeout_sec = 15; // 15 seconds timeout
-      connect_req.msg_id = CTRL_REQ_CONNECT_AP;
-      snprintf((char *)connect_req.u.wifi_ap_config.ssid, SSID_LENGTH, "%s",
-               (char *)target_ssid);
-
-      if (need_password) {
-        strncpy((char *)connect_req.u.wifi_ap_config.pwd, password_buffer,
-                PASSWORD_LENGTH);
-      }
-
-      // Send connect command and wait for response
-      ret = wifi_connect_ap(&connect_req);
+      // The station manager joins and keeps the network joined
+      S_M1_Wifi_Sta sta_status;
+      wifi_sta_start((char *)target_ssid,
+                     need_password ? password_buffer : NULL);
+      ret = wifi_sta_join_wait(&sta_status) ? SUCCESS : ERROR;
 
       if (ret == SUCCESS) {
         if (need_password && strlen(password_buffer) > 0) {
@@ -770,7 +798,10 @@ void wifi_join_network(void) {
       } else {
         m1_u8g2_firstpage();
         u8g2_DrawStr(&m1_u8g2, 6, 15, "Connect failed!");
-        u8g2_DrawStr(&m1_u8g2, 6, 35, "Check password");
+        if (sta_status.join_error == M1_WIFI_STA_JOIN_ERR_NO_AP)
+          u8g2_DrawStr(&m1_u8g2, 6, 35, "Network not found");
+        else
+          u8g2_DrawStr(&m1_u8g2, 6, 35, "Check password");
         m1_u8g2_nextpage();
         m1_hard_delay(2000);
       }
@@ -921,41 +952,15 @@ void wifi_show_connection_status(void) {
   S_M1_Main_Q_t q_item;
   BaseType_t ret;
   bool exit_menu = false;
-  char status_ssid[33] = "";
-  char status_ip[17] = "Not connected";
-  int status_rssi = 0;
-  bool is_connected = false;
+  S_M1_Wifi_Sta status;
+  char display_line[24];
 
   // Initialize ESP32 if needed
   (void)wifi_ensure_initialized();
 
   while (!exit_menu) {
-    // Auto-refresh status
-    if (get_esp32_main_init_status()) {
-      ctrl_cmd_t status_req = CTRL_CMD_DEFAULT_REQ();
-      status_req.cmd_timeout_sec = 5;
-      status_req.msg_id = CTRL_REQ_GET_AP_CONFIG;
-
-      if (wifi_get_ap_config(&status_req) == SUCCESS &&
-          strncmp(status_req.u.wifi_ap_config.status, "CONNECTED",
-                  STATUS_LENGTH - 1) == 0) {
-        is_connected = true;
-        snprintf(status_ssid, sizeof(status_ssid), "%s",
-                 (char *)status_req.u.wifi_ap_config.ssid);
-        if (status_req.u.wifi_ap_config.out_mac[0]) {
-          strncpy(status_ip, status_req.u.wifi_ap_config.out_mac, 16);
-          status_ip[16] = '\0';
-        } else {
-          strcpy(status_ip, "IP: unknown");
-        }
-        status_rssi = status_req.u.wifi_ap_config.rssi;
-      } else {
-        is_connected = false;
-        status_ssid[0] = 0;
-        strcpy(status_ip, "Not connected");
-        status_rssi = 0;
-      }
-    }
+    // The station manager keeps the status fresh, this only reads it
+    wifi_sta_status(&status);
 
     m1_u8g2_firstpage();
     u8g2_SetFont(&m1_u8g2, M1_DISP_MAIN_MENU_FONT_N);
@@ -965,33 +970,50 @@ void wifi_show_connection_status(void) {
 
     if (!get_esp32_main_init_status()) {
       u8g2_DrawStr(&m1_u8g2, 6, 30, "ESP32 not ready");
-    } else if (!is_connected) {
+    } else if (status.state == M1_WIFI_STA_IDLE) {
       u8g2_DrawStr(&m1_u8g2, 6, 24, "Status: Disconnected");
       u8g2_DrawStr(&m1_u8g2, 6, 36, "No network");
     } else {
-      // Display actual connection info
-      char display_line[22];
-
-      u8g2_DrawStr(&m1_u8g2, 6, 22, "Status: Connected");
+      switch (status.state) {
+      case M1_WIFI_STA_CONNECTED:
+        u8g2_DrawStr(&m1_u8g2, 6, 22, "Status: Connected");
+        break;
+      case M1_WIFI_STA_JOINING:
+        u8g2_DrawStr(&m1_u8g2, 6, 22, "Status: Joining...");
+        break;
+      case M1_WIFI_STA_BACKOFF:
+        u8g2_DrawStr(&m1_u8g2, 6, 22, "Status: Reconnecting");
+        break;
+      default:
+        u8g2_DrawStr(&m1_u8g2, 6, 22, "Status: Rejected");
+        break;
+      }
 
       // SSID (truncate if needed)
-      strncpy(display_line, status_ssid, 21);
-      display_line[21] = '\0';
+      snprintf(display_line, 22, "%s", status.ssid);
       u8g2_DrawStr(&m1_u8g2, 6, 32, display_line);
 
-      // IP Address
-      u8g2_DrawStr(&m1_u8g2, 6, 42, status_ip);
-
-      // RSSI unknown until status AT command is implemented in SPI-AT glue
-      if (status_rssi == 0) {
-        strcpy(display_line, "RSSI: unknown");
-      } else {
-        sprintf(display_line, "RSSI: %ddBm", status_rssi);
+      if (status.state == M1_WIFI_STA_CONNECTED) {
+        u8g2_DrawStr(&m1_u8g2, 6, 42,
+                     status.ip[0] ? status.ip : "IP: pending");
+        if (status.rssi == 0) {
+          strcpy(display_line, "RSSI: unknown");
+        } else {
+          sprintf(display_line, "RSSI: %ddBm Ch%u", status.rssi,
+                  status.channel);
+        }
+        u8g2_DrawStr(&m1_u8g2, 6, 52, display_line);
+      } else if (status.state == M1_WIFI_STA_BACKOFF) {
+        int32_t wait_ms = (int32_t)(status.retry_ms - HAL_GetTick());
+        sprintf(display_line, "Retry %u in %lus", status.attempts + 1,
+                (unsigned long)(wait_ms > 0 ? (wait_ms + 999) / 1000 : 0));
+        u8g2_DrawStr(&m1_u8g2, 6, 42, display_line);
+      } else if (status.state == M1_WIFI_STA_FAILED) {
+        u8g2_DrawStr(&m1_u8g2, 6, 42, "Wrong password");
       }
-      u8g2_DrawStr(&m1_u8g2, 6, 52, display_line);
     }
 
-    if (is_connected) {
+    if (status.state != M1_WIFI_STA_IDLE) {
       u8g2_DrawStr(&m1_u8g2, 2, 62, "OK:Disconnect Back:Exit");
     } else {
       u8g2_DrawStr(&m1_u8g2, 2, 62, "Back: Exit");
@@ -999,7 +1021,8 @@ void wifi_show_connection_status(void) {
     m1_u8g2_nextpage();
 
     // Wait for button
-    ret = xQueueReceive(main_q_hdl, &q_item, pdMS_TO_TICKS(5000));
+    ret = xQueueReceive(main_q_hdl, &q_item,
+                        pdMS_TO_TICKS(WIFI_STA_STATUS_REFRESH_MS));
     if (ret == pdTRUE && q_item.q_evt_type == Q_EVENT_KEYPAD) {
       ret = xQueueReceive(button_events_q_hdl, &this_button_status, 0);
 
@@ -1007,20 +1030,14 @@ void wifi_show_connection_status(void) {
         exit_menu = true;
       } else if (this_button_status.event[BUTTON_OK_KP_ID] ==
                      BUTTON_EVENT_CLICK &&
-                 is_connected) {
-        // Disconnect
+                 status.state != M1_WIFI_STA_IDLE) {
+        // Disconnect, the manager stops rejoining
         m1_u8g2_firstpage();
         u8g2_DrawStr(&m1_u8g2, 6, 30, "Disconnecting...");
         m1_u8g2_nextpage();
 
-        ctrl_cmd_t disc_req = CTRL_CMD_DEFAULT_REQ();
-        disc_req.cmd_timeout_sec = 5;
-        disc_req.msg_id = CTRL_REQ_DISCONNECT_AP;
-        (void)wifi_disconnect_ap(&disc_req);
-
-        is_connected = false;
-        strcpy(status_ip, "Not connected");
-        m1_hard_delay(1000);
+        wifi_sta_stop();
+        vTaskDelay(pdMS_TO_TICKS(1000));
       }
     } else {
       // timeout -> refresh screen
@@ -1030,3 +1047,333 @@ void wifi_show_connection_status(void) {
 
   xQueueReset(main_q_hdl);
 }
+
+// Held around every exchange on the AT link, the BLE scanner takes it too
+void wifi_at_lock(void) {
+  taskENTER_CRITICAL();
+  if (wifi_at_mutex == NULL) {
+    wifi_at_mutex = xSemaphoreCreateMutexStatic(&wifi_at_mutex_storage);
+  }
+  taskEXIT_CRITICAL();
+  xSemaphoreTake(wifi_at_mutex, portMAX_DELAY);
+}
+
+void wifi_at_unlock(void) { xSemaphoreGive(wifi_at_mutex); }
+
+static bool wifi_sta_send(void *ctx, const char *cmd) {
+  (void)ctx;
+  return esp_at_send_line(cmd) == SUCCESS;
+}
+
+// Splits the response blocks into lines, a line may span two blocks
+static void wifi_sta_feed(const char *block, uint32_t now_ms) {
+  static char line[WIFI_STA_LINE_SIZE];
+  static uint16_t len = 0;
+
+  for (; *block; block++) {
+    if (*block == '\n') {
+      line[len] = '\0';
+      m1_wifi_sta_rx_line(&wifi_sta, line, now_ms);
+      len = 0;
+    } else if (*block != '\r' && len < sizeof(line) - 1) {
+      line[len++] = *block;
+    }
+  }
+}
+
+/*============================================================================*/
+/**
+ * @brief Runs the station manager: reads the ESP32 responses, times out the
+ *        commands, rejoins and polls the status. It sleeps while no network
+ *        is selected.
+ * @param
+ * @retval
+ */
+/*============================================================================*/
+void wifi_sta_task(void *param) {
+  static char rx_buf[WIFI_STA_RX_BUF_SIZE];
+  bool active;
+
+  (void)param;
+  for (;;) {
+    wifi_at_lock();
+    active = wifi_sta_ready && (wifi_sta.state != M1_WIFI_STA_IDLE ||
+                                wifi_sta.cmd != M1_WIFI_STA_CMD_NONE ||
+                                wifi_sta.quit_pending);
+    if (active) {
+      if (esp_at_read_response(rx_buf, sizeof(rx_buf), WIFI_STA_PUMP_MS))
+        wifi_sta_feed(rx_buf, HAL_GetTick());
+      m1_wifi_sta_tick(&wifi_sta, HAL_GetTick());
+    }
+    wifi_at_unlock();
+
+    if (!active)
+      ulTaskNotifyTake(pdTRUE, portMAX_DELAY); // Until wifi_sta_start()
+    else if (!get_esp32_main_init_status())
+      vTaskDelay(pdMS_TO_TICKS(WIFI_STA_PUMP_MS)); // No link: sends fail, joins back off
+  }
+} // void wifi_sta_task(void *param)
+
+static void wifi_sta_start(const char *ssid, const char *pwd) {
+  const S_M1_Wifi_Sta_Config cfg = {wifi_sta_send, NULL, NULL};
+
+  wifi_at_lock();
+  if (!wifi_sta_ready) {
+    m1_wifi_sta_init(&wifi_sta, &cfg);
+    wifi_sta_ready = true;
+  }
+  m1_wifi_sta_connect(&wifi_sta, ssid, pwd, HAL_GetTick());
+  wifi_at_unlock();
+  xTaskNotifyGive(wifi_sta_task_hdl);
+}
+
+static void wifi_sta_stop(void) {
+  wifi_at_lock();
+  if (wifi_sta_ready)
+    m1_wifi_sta_disconnect(&wifi_sta, HAL_GetTick());
+  wifi_at_unlock();
+}
+
+// The ESP32 was restarted behind the manager's back, called with the AT link
+// locked
+void wifi_sta_link_reset(void) {
+  if (wifi_sta_ready)
+    m1_wifi_sta_reset(&wifi_sta, HAL_GetTick());
+}
+
+// A network is selected, the ESP32 must stay up
+bool wifi_sta_active(void) {
+  S_M1_Wifi_Sta status;
+
+  wifi_sta_status(&status);
+  return status.state != M1_WIFI_STA_IDLE;
+}
+
+// Copy of the manager without the password
+static void wifi_sta_status(S_M1_Wifi_Sta *pstatus) {
+  wifi_at_lock();
+  if (wifi_sta_ready)
+    *pstatus = wifi_sta;
+  else
+    memset(pstatus, 0, sizeof(*pstatus));
+  wifi_at_unlock();
+  memset(pstatus->pwd, 0, sizeof(pstatus->pwd));
+}
+
+// Waits for the first join result, a network that does not join is dropped
+static bool wifi_sta_join_wait(S_M1_Wifi_Sta *pstatus) {
+  uint32_t t0 = HAL_GetTick();
+
+  do {
+    vTaskDelay(pdMS_TO_TICKS(WIFI_STA_PUMP_MS));
+    wifi_sta_status(pstatus);
+    if (pstatus->state == M1_WIFI_STA_CONNECTED)
+      return true;
+    if (pstatus->state == M1_WIFI_STA_FAILED || pstatus->attempts)
+      break;
+  } while (HAL_GetTick() - t0 < WIFI_STA_JOIN_WAIT_MS);
+
+  wifi_sta_stop();
+  return false;
+}
+
+/*============================================================================*/
+/**
+ * @brief Monitors the 2.4 GHz channels until the user leaves: AP scans are
+ *        repeated, the estimated load of each channel is graphed and every
+ *        sweep is logged to the SD card. Left/Right select a channel, OK
+ *        shows its RSSI histogram.
+ * @param
+ * @retval
+ */
+/*============================================================================*/
+void wifi_monitor(void) {
+  S_M1_Buttons_Status this_button_status;
+  S_M1_Main_Q_t q_item;
+  BaseType_t ret;
+  uint8_t channel = 1;
+  bool hist = false;
+  bool logging;
+  bool ready;
+
+  /* Graphic work starts here */
+  u8g2_SetFont(&m1_u8g2, M1_DISP_MAIN_MENU_FONT_N);
+  if (!wifi_ensure_initialized()) {
+    m1_u8g2_firstpage();
+    u8g2_DrawStr(&m1_u8g2, 6, 15, "Initializing...");
+    u8g2_DrawXBMP(&m1_u8g2, M1_LCD_DISPLAY_WIDTH / 2 - 18 / 2,
+                  M1_LCD_DISPLAY_HEIGHT / 2 - 2, 18, 32, hourglass_18x32);
+    m1_u8g2_nextpage();
+  }
+
+  m1_wifi_mon_init(&wifi_mon);
+  logging = m1_sd_detected() && m1_sdcard_get_status() == SD_access_OK;
+  ready = get_esp32_main_init_status();
+
+  m1_u8g2_firstpage();
+  if (ready) {
+    u8g2_DrawStr(&m1_u8g2, 6, 15, "Scanning channels...");
+    u8g2_DrawXBMP(&m1_u8g2, M1_LCD_DISPLAY_WIDTH / 2 - 18 / 2,
+                  M1_LCD_DISPLAY_HEIGHT / 2 - 2, 18, 32, hourglass_18x32);
+  } else {
+    u8g2_DrawStr(&m1_u8g2, 6, 15 + M1_GUI_ROW_SPACING + M1_GUI_FONT_HEIGHT,
+                 "ESP32 not ready!");
+  }
+  m1_u8g2_nextpage();
+
+  while (1) // Main loop of this task
+  {
+    if (ready && wifi_monitor_sweep()) {
+      if (logging &&
+          m1_wifi_mon_log(&wifi_mon, M1_WIFI_MON_LOG_FILE, HAL_GetTick()) != FR_OK) {
+        M1_LOG_I(M1_LOGDB_TAG, "Monitor log write failed\n\r");
+        logging = false; // Card removed or full, keep monitoring
+      }
+      wifi_monitor_print(channel, hist, logging);
+    }
+
+    // A sweep takes seconds, the keys pressed meanwhile are handled here
+    ret = xQueueReceive(main_q_hdl, &q_item,
+                        ready ? pdMS_TO_TICKS(WIFI_MON_KEY_WAIT_MS)
+                              : portMAX_DELAY);
+    if (ret == pdTRUE) {
+      if (q_item.q_evt_type == Q_EVENT_KEYPAD) {
+        // Notification is only sent to this task when there's any button
+        // activity, so it doesn't need to wait when reading the event from the
+        // queue
+        ret = xQueueReceive(button_events_q_hdl, &this_button_status, 0);
+        if (this_button_status.event[BUTTON_BACK_KP_ID] ==
+            BUTTON_EVENT_CLICK) // user wants to exit?
+        {
+          if (hist) {
+            hist = false;
+            wifi_monitor_print(channel, hist, logging);
+            continue;
+          }
+          xQueueReset(main_q_hdl); // Reset main q before return
+          if (!wifi_sta_active())
+            m1_esp32_deinit(); // Keep the link of a joined network
+          break; // Exit and return to the calling task (subfunc_handler_task)
+        } else if (!ready || !wifi_mon.sweeps) {
+          ; // Nothing to show yet
+        } else if (this_button_status.event[BUTTON_LEFT_KP_ID] ==
+                   BUTTON_EVENT_CLICK) {
+          channel = (channel > 1) ? channel - 1 : M1_WIFI_MON_CHANNELS;
+          wifi_monitor_print(channel, hist, logging);
+        } else if (this_button_status.event[BUTTON_RIGHT_KP_ID] ==
+                   BUTTON_EVENT_CLICK) {
+          channel = (channel < M1_WIFI_MON_CHANNELS) ? channel + 1 : 1;
+          wifi_monitor_print(channel, hist, logging);
+        } else if (this_button_status.event[BUTTON_OK_KP_ID] ==
+                   BUTTON_EVENT_CLICK) {
+          hist = !hist;
+          wifi_monitor_print(channel, hist, logging);
+        }
+      } // if ( q_item.q_evt_type==Q_EVENT_KEYPAD )
+    } // if (ret==pdTRUE)
+  } // while (1 ) // Main loop of this task
+} // void wifi_monitor(void)
+
+// One AP scan into the channel statistics
+static bool wifi_monitor_sweep(void) {
+  ctrl_cmd_t app_req = CTRL_CMD_DEFAULT_REQ();
+  wifi_scanlist_t *pap;
+  bool ok;
+  int i;
+
+  app_req.cmd_timeout_sec = WIFI_MON_SWEEP_TIMEOUT;
+  app_req.msg_id = CTRL_RESP_GET_AP_SCAN_LIST;
+  wifi_at_lock();
+  wifi_ap_scan_list(&app_req);
+  wifi_at_unlock();
+
+  ok = wifi_ap_list_validation(&app_req);
+  if (ok) {
+    m1_wifi_mon_sweep_begin(&wifi_mon);
+    pap = app_req.u.wifi_ap_scan.out_list;
+    for (i = 0; pap && i < app_req.u.wifi_ap_scan.count; i++)
+      m1_wifi_mon_ap(&wifi_mon, (int8_t)pap[i].rssi, (uint8_t)pap[i].channel);
+    m1_wifi_mon_sweep_end(&wifi_mon);
+  }
+  if (app_req.u.wifi_ap_scan.out_list != NULL)
+    free(app_req.u.wifi_ap_scan.out_list);
+
+  return ok;
+}
+
+/*============================================================================*/
+/**
+ * @brief Draws the load of all channels as bars, or the RSSI histogram of
+ *        the selected channel
+ * @param
+ * @retval
+ */
+/*============================================================================*/
+static void wifi_monitor_print(uint8_t channel, bool hist, bool logging) {
+  const S_M1_Wifi_Mon_Channel *pch = &wifi_mon.ch[channel - 1];
+  const uint8_t height = WIFI_MON_GRAPH_BOTTOM - WIFI_MON_GRAPH_TOP;
+  char prn_msg[32];
+  uint32_t peak;
+  uint8_t i, h, x;
+
+  m1_u8g2_firstpage();
+  u8g2_SetFont(&m1_u8g2, M1_DISP_MAIN_MENU_FONT_N);
+
+  if (hist) {
+    sprintf(prn_msg, "Ch %u RSSI, %lu seen", channel,
+            (unsigned long)pch->sightings);
+    u8g2_DrawStr(&m1_u8g2, 2, M1_GUI_FONT_HEIGHT, prn_msg);
+    peak = 1;
+    for (i = 0; i < M1_WIFI_MON_HIST_BINS; i++) {
+      if (pch->hist[i] > peak)
+        peak = pch->hist[i];
+    }
+    // Weakest bin on the left, 16 pixels per bin
+    for (i = 0; i < M1_WIFI_MON_HIST_BINS; i++) {
+      h = (uint8_t)(pch->hist[i] * height / peak);
+      if (h)
+        u8g2_DrawBox(&m1_u8g2, i * 16 + 2, WIFI_MON_GRAPH_BOTTOM - h, 12, h);
+    }
+    u8g2_DrawHLine(&m1_u8g2, 0, WIFI_MON_GRAPH_BOTTOM, M1_LCD_DISPLAY_WIDTH);
+    u8g2_DrawStr(&m1_u8g2, 0, M1_LCD_DISPLAY_HEIGHT - 1, "-90");
+    u8g2_DrawStr(&m1_u8g2, M1_LCD_DISPLAY_WIDTH / 2 - 9,
+                 M1_LCD_DISPLAY_HEIGHT - 1, "-60");
+    u8g2_DrawStr(&m1_u8g2, M1_LCD_DISPLAY_WIDTH - 3 * M1_GUI_FONT_WIDTH,
+                 M1_LCD_DISPLAY_HEIGHT - 1, "-30");
+    m1_u8g2_nextpage(); // Update display RAM
+    return;
+  }
+
+  sprintf(prn_msg, "APs:%u  #%lu", wifi_mon.aps, (unsigned long)wifi_mon.sweeps);
+  u8g2_DrawStr(&m1_u8g2, 2, M1_GUI_FONT_HEIGHT, prn_msg);
+  if (logging)
+    u8g2_DrawStr(&m1_u8g2, M1_LCD_DISPLAY_WIDTH - 3 * M1_GUI_FONT_WIDTH,
+                 M1_GUI_FONT_HEIGHT, "LOG");
+
+  // One bar per channel, the selected one with a tick under the baseline
+  for (i = 0; i < M1_WIFI_MON_CHANNELS; i++) {
+    x = 1 + i * WIFI_MON_BAR_PITCH;
+    h = wifi_mon.ch[i].load * height / 100;
+    if (h)
+      u8g2_DrawBox(&m1_u8g2, x, WIFI_MON_GRAPH_BOTTOM - h,
+                   WIFI_MON_BAR_PITCH - 2, h);
+    // Peak load as a dash above the bar
+    h = wifi_mon.ch[i].load_max * height / 100;
+    if (h)
+      u8g2_DrawHLine(&m1_u8g2, x, WIFI_MON_GRAPH_BOTTOM - h,
+                     WIFI_MON_BAR_PITCH - 2);
+    if (i + 1 == channel)
+      u8g2_DrawBox(&m1_u8g2, x, WIFI_MON_GRAPH_BOTTOM + 2,
+                   WIFI_MON_BAR_PITCH - 2, 2);
+  }
+  u8g2_DrawHLine(&m1_u8g2, 0, WIFI_MON_GRAPH_BOTTOM, M1_LCD_DISPLAY_WIDTH);
+
+  if (pch->rssi_best == M1_WIFI_MON_RSSI_NONE)
+    sprintf(prn_msg, "Ch%u %uAP %u%%", channel, pch->aps, pch->load);
+  else
+    sprintf(prn_msg, "Ch%u %uAP %ddBm %u%%", channel, pch->aps,
+            pch->rssi_best, pch->load);
+  u8g2_DrawStr(&m1_u8g2, 2, M1_LCD_DISPLAY_HEIGHT - 1, prn_msg);
+
+  m1_u8g2_nextpage(); // Update display RAM
+}
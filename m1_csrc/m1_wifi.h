@@ -14,11 +14,15 @@
 #ifndef M1_WIFI_H_
 #define M1_WIFI_H_
 
+#include <stdbool.h>
+#include "app_freertos.h"
+
 void menu_wifi_init(void);
 void menu_wifi_exit(void);
 
 void menu_wifi_init(void);
 void wifi_scan_ap(void);
+void wifi_monitor(void);
 void wifi_config(void);
 
 // WiFi credential functions (stubs for now)
@@ -26,5 +30,12 @@ void wifi_cred_init(void);
 void wifi_join_network(void);
 void wifi_show_saved_networks(void);
 void wifi_show_connection_status(void);
+void wifi_sta_task(void *param);
+void wifi_at_lock(void);
+void wifi_at_unlock(void);
+bool wifi_sta_active(void);
+void wifi_sta_link_reset(void);
+
+extern TaskHandle_t wifi_sta_task_hdl;
 
 #endif /* M1_WIFI_H_ */
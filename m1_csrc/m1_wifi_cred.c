@@ -6,21 +6,14 @@
 #include "ff.h"
 #include "m1_wifi_cred.h"
 #include "m1_crypto.h"
+#include "bit_util.h"
 
 static wifi_cred_db_t cred_db;
 static bool cred_db_loaded = false;
 
 static uint32_t cred_crc32(const uint8_t *data, uint32_t len)
 {
-    uint32_t crc = 0xFFFFFFFFu;
-    for (uint32_t i = 0; i < len; i++) {
-        crc ^= data[i];
-        for (uint8_t b = 0; b < 8; b++) {
-            uint32_t mask = -(crc & 1u);
-            crc = (crc >> 1) ^ (0xEDB88320u & mask);
-        }
-    }
-    return ~crc;
+    return ~crc32lsb(data, len, 0xEDB88320u, 0xFFFFFFFFu);
 }
 
 static uint32_t cred_db_checksum(uint16_t count)
@@ -0,0 +1,238 @@
+/* See COPYING.txt for license details. */
+
+/*
+*
+* m1_wifi_mon.c
+*
+* Wi-Fi channel monitor statistics
+*
+* M1 Project
+*
+*/
+
+/*************************** I N C L U D E S **********************************/
+
+#include <stdio.h>
+#include <string.h>
+#include "m1_wifi_mon.h"
+#include "m1_file_util.h"
+
+/*************************** D E F I N E S ************************************/
+
+// A 20 MHz channel spans 5 channel steps: an AP is felt up to 4 channels away
+#define WIFI_MON_OVERLAP			5
+// Load share of one AP: four APs heard at -70 dBm or stronger fill a channel
+#define WIFI_MON_AP_SHARE			25
+#define WIFI_MON_SHARE_RSSI_FULL	(-70)
+#define WIFI_MON_SHARE_RSSI_ZERO	(-95)
+#define WIFI_MON_LOAD_MAX			100
+
+#define WIFI_MON_LOG_ROW_SIZE		128
+
+//************************** C O N S T A N T **********************************/
+
+static const char wifi_mon_log_header[] = "time_ms,sweep,channel,aps,rssi_best,load,sightings,"
+											"h_lt90,h_90,h_80,h_70,h_60,h_50,h_40,h_ge30\n";
+
+//************************** S T R U C T U R E S *******************************
+
+/***************************** V A R I A B L E S ******************************/
+
+/********************* F U N C T I O N   P R O T O T Y P E S ******************/
+
+void m1_wifi_mon_init(S_M1_Wifi_Mon *pm);
+void m1_wifi_mon_sweep_begin(S_M1_Wifi_Mon *pm);
+bool m1_wifi_mon_ap(S_M1_Wifi_Mon *pm, int8_t rssi, uint8_t channel);
+void m1_wifi_mon_sweep_end(S_M1_Wifi_Mon *pm);
+uint8_t m1_wifi_mon_busiest(const S_M1_Wifi_Mon *pm);
+uint8_t m1_wifi_mon_hist_bin(int8_t rssi);
+FRESULT m1_wifi_mon_log(const S_M1_Wifi_Mon *pm, const char *path, uint32_t now_ms);
+static uint8_t ap_share(int8_t rssi);
+
+/*************** F U N C T I O N   I M P L E M E N T A T I O N ****************/
+
+void m1_wifi_mon_init(S_M1_Wifi_Mon *pm)
+{
+	memset(pm, 0, sizeof(*pm));
+	m1_wifi_mon_sweep_begin(pm);
+	for (uint8_t i=0; i<M1_WIFI_MON_CHANNELS; i++)
+		pm->ch[i].rssi_best = M1_WIFI_MON_RSSI_NONE;
+} // void m1_wifi_mon_init(S_M1_Wifi_Mon *pm)
+
+
+
+void m1_wifi_mon_sweep_begin(S_M1_Wifi_Mon *pm)
+{
+	S_M1_Wifi_Mon_Channel *pch;
+
+	for (pch=pm->ch; pch<pm->ch + M1_WIFI_MON_CHANNELS; pch++)
+	{
+		pch->aps_acc = 0;
+		pch->rssi_acc = M1_WIFI_MON_RSSI_NONE;
+		pch->load_acc = 0;
+	}
+	pm->sweep_aps = 0;
+} // void m1_wifi_mon_sweep_begin(S_M1_Wifi_Mon *pm)
+
+
+
+/*============================================================================*/
+/*
+ * This function counts an AP of the sweep in progress. It returns false for
+ * a channel out of the 2.4 GHz band.
+ */
+/*============================================================================*/
+bool m1_wifi_mon_ap(S_M1_Wifi_Mon *pm, int8_t rssi, uint8_t channel)
+{
+	S_M1_Wifi_Mon_Channel *pch;
+	uint8_t share, d;
+	int8_t i;
+
+	if ( channel < 1 || channel > M1_WIFI_MON_CHANNELS )
+		return false;
+
+	pch = &pm->ch[channel - 1];
+	if ( pch->aps_acc < UINT8_MAX )
+		pch->aps_acc++;
+	if ( rssi > pch->rssi_acc )
+		pch->rssi_acc = rssi;
+	pch->sightings++;
+	pch->hist[m1_wifi_mon_hist_bin(rssi)]++;
+	pm->sweep_aps++;
+
+	share = ap_share(rssi);
+	for (i=channel - WIFI_MON_OVERLAP + 1; i<channel + WIFI_MON_OVERLAP; i++)
+	{
+		if ( i < 1 || i > M1_WIFI_MON_CHANNELS )
+			continue;
+		d = (i > channel) ? i - channel : channel - i;
+		pm->ch[i - 1].load_acc += share*(WIFI_MON_OVERLAP - d)/WIFI_MON_OVERLAP;
+	}
+
+	return true;
+} // bool m1_wifi_mon_ap(S_M1_Wifi_Mon *pm, int8_t rssi, uint8_t channel)
+
+
+
+// Publishes the sweep in progress
+void m1_wifi_mon_sweep_end(S_M1_Wifi_Mon *pm)
+{
+	S_M1_Wifi_Mon_Channel *pch;
+
+	for (pch=pm->ch; pch<pm->ch + M1_WIFI_MON_CHANNELS; pch++)
+	{
+		pch->aps = pch->aps_acc;
+		pch->rssi_best = pch->rssi_acc;
+		pch->load = (pch->load_acc > WIFI_MON_LOAD_MAX) ? WIFI_MON_LOAD_MAX : pch->load_acc;
+		if ( pch->aps > pch->aps_max )
+			pch->aps_max = pch->aps;
+		if ( pch->load > pch->load_max )
+			pch->load_max = pch->load;
+	}
+	pm->aps = pm->sweep_aps;
+	pm->sweeps++;
+	m1_wifi_mon_sweep_begin(pm);
+} // void m1_wifi_mon_sweep_end(S_M1_Wifi_Mon *pm)
+
+
+
+// Channel of the highest load of the last sweep, the lowest one on a tie
+uint8_t m1_wifi_mon_busiest(const S_M1_Wifi_Mon *pm)
+{
+	uint8_t i, best = 0;
+
+	for (i=1; i<M1_WIFI_MON_CHANNELS; i++)
+	{
+		if ( pm->ch[i].load > pm->ch[best].load )
+			best = i;
+	}
+
+	return best + 1;
+} // uint8_t m1_wifi_mon_busiest(const S_M1_Wifi_Mon *pm)
+
+
+
+uint8_t m1_wifi_mon_hist_bin(int8_t rssi)
+{
+	int16_t bin;
+
+	if ( rssi < M1_WIFI_MON_HIST_FLOOR )
+		return 0;
+	bin = (rssi - M1_WIFI_MON_HIST_FLOOR)/10 + 1;
+
+	return (bin >= M1_WIFI_MON_HIST_BINS) ? M1_WIFI_MON_HIST_BINS - 1 : (uint8_t)bin;
+} // uint8_t m1_wifi_mon_hist_bin(int8_t rssi)
+
+
+
+/*============================================================================*/
+/*
+ * This function appends the last sweep to a CSV file, one row per channel.
+ * A new file starts with the column names.
+ */
+/*============================================================================*/
+FRESULT m1_wifi_mon_log(const S_M1_Wifi_Mon *pm, const char *path, uint32_t now_ms)
+{
+	const S_M1_Wifi_Mon_Channel *pch;
+	char dir[64];
+	char row[WIFI_MON_LOG_ROW_SIZE];
+	FIL file;
+	FRESULT res;
+	UINT bw;
+	int len;
+	uint8_t i, j;
+
+	fu_get_directory_path(path, dir, sizeof(dir));
+	if ( dir[0] )
+	{
+		res = fs_directory_ensure(dir);
+		if ( res!=FR_OK )
+			return res;
+	}
+	res = f_open(&file, path, FA_OPEN_APPEND | FA_WRITE);
+	if ( res!=FR_OK )
+		return res;
+
+	if ( f_size(&file)==0 )
+	{
+		res = f_write(&file, wifi_mon_log_header, strlen(wifi_mon_log_header), &bw);
+		if ( res==FR_OK && bw!=strlen(wifi_mon_log_header) )
+			res = FR_DENIED; // Card full
+	}
+
+	for (i=0; i<M1_WIFI_MON_CHANNELS && res==FR_OK; i++)
+	{
+		pch = &pm->ch[i];
+		if ( pch->rssi_best==M1_WIFI_MON_RSSI_NONE )
+			len = snprintf(row, sizeof(row), "%lu,%lu,%u,%u,,%u,%lu", (unsigned long)now_ms,
+							(unsigned long)pm->sweeps, i + 1, pch->aps, pch->load, (unsigned long)pch->sightings);
+		else
+			len = snprintf(row, sizeof(row), "%lu,%lu,%u,%u,%d,%u,%lu", (unsigned long)now_ms,
+							(unsigned long)pm->sweeps, i + 1, pch->aps, pch->rssi_best, pch->load,
+							(unsigned long)pch->sightings);
+		for (j=0; j<M1_WIFI_MON_HIST_BINS; j++)
+			len += snprintf(row + len, sizeof(row) - len, ",%lu", (unsigned long)pch->hist[j]);
+		len += snprintf(row + len, sizeof(row) - len, "\n");
+		res = f_write(&file, row, len, &bw);
+		if ( res==FR_OK && bw!=(UINT)len )
+			res = FR_DENIED;
+	} // for (i=0; i<M1_WIFI_MON_CHANNELS && res==FR_OK; i++)
+
+	f_close(&file);
+
+	return res;
+} // FRESULT m1_wifi_mon_log(const S_M1_Wifi_Mon *pm, const char *path, uint32_t now_ms)
+
+
+
+// Load share of an AP, none below the receiver floor, all of it from a close one
+static uint8_t ap_share(int8_t rssi)
+{
+	if ( rssi <= WIFI_MON_SHARE_RSSI_ZERO )
+		return 0;
+	if ( rssi >= WIFI_MON_SHARE_RSSI_FULL )
+		return WIFI_MON_AP_SHARE;
+
+	return (uint8_t)(WIFI_MON_AP_SHARE*(rssi - WIFI_MON_SHARE_RSSI_ZERO)/
+					(WIFI_MON_SHARE_RSSI_FULL - WIFI_MON_SHARE_RSSI_ZERO));
+} // static uint8_t ap_share(int8_t rssi)
@@ -0,0 +1,64 @@
+/* See COPYING.txt for license details. */
+
+/*
+*
+* m1_wifi_mon.h
+*
+* Header for the Wi-Fi channel monitor statistics
+*
+* The monitor repeats passive AP scans and keeps, for each 2.4 GHz channel,
+* the APs heard in the last sweep, how often APs were heard since the start,
+* the strongest signal and a histogram of the RSSI. The channel load is an
+* estimate: every AP adds a share weighted by its signal to its own channel
+* and, less, to the overlapping neighbours.
+*
+* Each sweep can be appended to a CSV log on the SD card.
+*
+* M1 Project
+*
+*/
+
+#ifndef M1_WIFI_MON_H_
+#define M1_WIFI_MON_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "ff.h"
+
+#define M1_WIFI_MON_CHANNELS		14 // 2.4 GHz, channel 1 at index 0
+#define M1_WIFI_MON_HIST_BINS		8 // 10 dB each, from below -90 to -30 and above
+#define M1_WIFI_MON_HIST_FLOOR		(-90)
+#define M1_WIFI_MON_RSSI_NONE		(-128) // Nothing heard
+#define M1_WIFI_MON_LOG_FILE		"0:/WIFI/monitor.csv"
+
+typedef struct
+{
+	uint8_t aps; // Last sweep
+	uint8_t aps_max;
+	int8_t rssi_best; // Last sweep
+	uint8_t load; // Last sweep, percent
+	uint8_t load_max;
+	uint8_t aps_acc; // Of the sweep in progress
+	int8_t rssi_acc;
+	uint16_t load_acc;
+	uint32_t sightings; // APs heard over all sweeps
+	uint32_t hist[M1_WIFI_MON_HIST_BINS];
+} S_M1_Wifi_Mon_Channel;
+
+typedef struct
+{
+	S_M1_Wifi_Mon_Channel ch[M1_WIFI_MON_CHANNELS];
+	uint32_t sweeps; // Completed
+	uint16_t sweep_aps; // In progress
+	uint16_t aps; // Last sweep, all channels
+} S_M1_Wifi_Mon;
+
+void m1_wifi_mon_init(S_M1_Wifi_Mon *pm);
+void m1_wifi_mon_sweep_begin(S_M1_Wifi_Mon *pm);
+bool m1_wifi_mon_ap(S_M1_Wifi_Mon *pm, int8_t rssi, uint8_t channel);
+void m1_wifi_mon_sweep_end(S_M1_Wifi_Mon *pm);
+uint8_t m1_wifi_mon_busiest(const S_M1_Wifi_Mon *pm);
+uint8_t m1_wifi_mon_hist_bin(int8_t rssi);
+FRESULT m1_wifi_mon_log(const S_M1_Wifi_Mon *pm, const char *path, uint32_t now_ms);
+
+#endif /* M1_WIFI_MON_H_ */
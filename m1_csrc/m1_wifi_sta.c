@@ -0,0 +1,469 @@
+/* See COPYING.txt for license details. */
+
+/*
+*
+* m1_wifi_sta.c
+*
+* Wi-Fi station connection manager over ESP-AT
+*
+* M1 Project
+*
+*/
+
+/*************************** I N C L U D E S **********************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "m1_wifi_sta.h"
+
+/*************************** D E F I N E S ************************************/
+
+#define AT_CRLF					"\r\n"
+#define AT_REQ_MODE_STA			"AT+CWMODE=1" AT_CRLF
+#define AT_REQ_RECONN_OFF		"AT+CWRECONNCFG=0,0" AT_CRLF // The manager does the rejoins
+#define AT_REQ_JOIN				"AT+CWJAP="
+#define AT_REQ_QUERY_AP			"AT+CWJAP?" AT_CRLF
+#define AT_REQ_QUERY_IP			"AT+CIPSTA?" AT_CRLF
+#define AT_REQ_QUIT				"AT+CWQAP" AT_CRLF
+
+#define AT_RES_JOIN_KEY			"+CWJAP:"
+#define AT_RES_IP_KEY			"+CIPSTA:ip:"
+#define AT_RES_NO_AP			"No AP"
+#define AT_EVT_DISCONNECT		"WIFI DISCONNECT"
+#define AT_EVT_GOT_IP			"WIFI GOT IP"
+
+//************************** C O N S T A N T **********************************/
+
+//************************** S T R U C T U R E S *******************************
+
+/***************************** V A R I A B L E S ******************************/
+
+/********************* F U N C T I O N   P R O T O T Y P E S ******************/
+
+void m1_wifi_sta_init(S_M1_Wifi_Sta *ps, const S_M1_Wifi_Sta_Config *cfg);
+void m1_wifi_sta_connect(S_M1_Wifi_Sta *ps, const char *ssid, const char *pwd, uint32_t now_ms);
+void m1_wifi_sta_disconnect(S_M1_Wifi_Sta *ps, uint32_t now_ms);
+void m1_wifi_sta_reset(S_M1_Wifi_Sta *ps, uint32_t now_ms);
+void m1_wifi_sta_rx_line(S_M1_Wifi_Sta *ps, const char *line, uint32_t now_ms);
+void m1_wifi_sta_tick(S_M1_Wifi_Sta *ps, uint32_t now_ms);
+uint16_t m1_wifi_sta_at_quote(char *dst, uint16_t size, const char *src);
+static bool sta_due(uint32_t deadline_ms, uint32_t now_ms);
+static void sta_changed(S_M1_Wifi_Sta *ps);
+static void sta_send(S_M1_Wifi_Sta *ps, S_M1_Wifi_Sta_Cmd cmd, const char *line, uint32_t timeout_ms, uint32_t now_ms);
+static void sta_send_join(S_M1_Wifi_Sta *ps, uint32_t now_ms);
+static void sta_status_clear(S_M1_Wifi_Sta *ps);
+static void sta_backoff(S_M1_Wifi_Sta *ps, uint32_t now_ms);
+static void sta_join_failed(S_M1_Wifi_Sta *ps, uint32_t now_ms);
+static void sta_link_lost(S_M1_Wifi_Sta *ps, uint32_t now_ms);
+static void sta_cmd_done(S_M1_Wifi_Sta *ps, bool ok, uint32_t now_ms);
+static void sta_parse_ap(S_M1_Wifi_Sta *ps, const char *info);
+static void sta_parse_ip(S_M1_Wifi_Sta *ps, const char *info);
+
+/*************** F U N C T I O N   I M P L E M E N T A T I O N ****************/
+
+void m1_wifi_sta_init(S_M1_Wifi_Sta *ps, const S_M1_Wifi_Sta_Config *cfg)
+{
+	memset(ps, 0, sizeof(*ps));
+	ps->cfg = *cfg;
+	ps->backoff_ms = M1_WIFI_STA_BACKOFF_MIN_MS;
+} // void m1_wifi_sta_init(S_M1_Wifi_Sta *ps, const S_M1_Wifi_Sta_Config *cfg)
+
+
+
+// Deadline check that survives the tick counter wrap
+static bool sta_due(uint32_t deadline_ms, uint32_t now_ms)
+{
+	return (int32_t)(now_ms - deadline_ms) >= 0;
+} // static bool sta_due(uint32_t deadline_ms, uint32_t now_ms)
+
+
+
+static void sta_changed(S_M1_Wifi_Sta *ps)
+{
+	if ( ps->cfg.changed )
+		ps->cfg.changed(ps->cfg.ctx);
+} // static void sta_changed(S_M1_Wifi_Sta *ps)
+
+
+
+// A command that cannot be sent times out at the next tick
+static void sta_send(S_M1_Wifi_Sta *ps, S_M1_Wifi_Sta_Cmd cmd, const char *line, uint32_t timeout_ms, uint32_t now_ms)
+{
+	ps->cmd = cmd;
+	ps->cmd_deadline_ms = now_ms + timeout_ms;
+	if ( !ps->cfg.send(ps->cfg.ctx, line) )
+		ps->cmd_deadline_ms = now_ms;
+} // static void sta_send(S_M1_Wifi_Sta *ps, S_M1_Wifi_Sta_Cmd cmd, const char *line, ...)
+
+
+
+/*============================================================================*/
+/*
+ * This function copies src into dst with the characters ESP-AT takes as
+ * separators escaped, as a quoted command parameter needs them. It returns
+ * the length written; src is cut short rather than dst overflowed.
+ */
+/*============================================================================*/
+uint16_t m1_wifi_sta_at_quote(char *dst, uint16_t size, const char *src)
+{
+	uint16_t n = 0;
+
+	if ( !size )
+		return 0;
+
+	while ( *src )
+	{
+		bool esc = (*src=='"' || *src==',' || *src=='\\');
+
+		if ( n + esc + 1 >= size )
+			break;
+		if ( esc )
+			dst[n++] = '\\';
+		dst[n++] = *src++;
+	}
+	dst[n] = '\0';
+
+	return n;
+} // uint16_t m1_wifi_sta_at_quote(char *dst, uint16_t size, const char *src)
+
+
+
+static void sta_send_join(S_M1_Wifi_Sta *ps, uint32_t now_ms)
+{
+	char cmd[M1_WIFI_STA_CMD_LEN];
+	uint16_t n;
+
+	n = sprintf(cmd, AT_REQ_JOIN "\"");
+	n += m1_wifi_sta_at_quote(&cmd[n], sizeof(cmd) - n, ps->ssid);
+	n += sprintf(&cmd[n], "\"");
+	if ( ps->pwd[0] )
+	{
+		n += sprintf(&cmd[n], ",\"");
+		n += m1_wifi_sta_at_quote(&cmd[n], sizeof(cmd) - n, ps->pwd);
+		n += sprintf(&cmd[n], "\"");
+	}
+	sprintf(&cmd[n], AT_CRLF);
+
+	sta_send(ps, M1_WIFI_STA_CMD_JOIN, cmd, M1_WIFI_STA_JOIN_TIMEOUT_MS, now_ms);
+	memset(cmd, 0, sizeof(cmd)); // It holds the password
+} // static void sta_send_join(S_M1_Wifi_Sta *ps, uint32_t now_ms)
+
+
+
+static void sta_status_clear(S_M1_Wifi_Sta *ps)
+{
+	ps->ip[0] = '\0';
+	ps->bssid[0] = '\0';
+	ps->rssi = 0;
+	ps->channel = 0;
+} // static void sta_status_clear(S_M1_Wifi_Sta *ps)
+
+
+
+/*============================================================================*/
+/*
+ * This function starts joining ssid, dropping the network joined before. The
+ * join goes out at once if no command is in flight, else at the next tick
+ * after it.
+ */
+/*============================================================================*/
+void m1_wifi_sta_connect(S_M1_Wifi_Sta *ps, const char *ssid, const char *pwd, uint32_t now_ms)
+{
+	snprintf(ps->ssid, sizeof(ps->ssid), "%s", ssid);
+	snprintf(ps->pwd, sizeof(ps->pwd), "%s", pwd ? pwd : "");
+	sta_status_clear(ps);
+	ps->quit_pending = false;
+	ps->join_error = 0;
+	ps->attempts = 0;
+	ps->backoff_ms = M1_WIFI_STA_BACKOFF_MIN_MS;
+	ps->state = M1_WIFI_STA_BACKOFF;
+	ps->retry_ms = now_ms;
+
+	m1_wifi_sta_tick(ps, now_ms);
+} // void m1_wifi_sta_connect(S_M1_Wifi_Sta *ps, const char *ssid, const char *pwd, uint32_t now_ms)
+
+
+
+// Leaves the network and forgets it
+void m1_wifi_sta_disconnect(S_M1_Wifi_Sta *ps, uint32_t now_ms)
+{
+	bool joined = (ps->state==M1_WIFI_STA_CONNECTED || ps->state==M1_WIFI_STA_JOINING);
+
+	memset(ps->pwd, 0, sizeof(ps->pwd));
+	ps->ssid[0] = '\0';
+	sta_status_clear(ps);
+	ps->state = M1_WIFI_STA_IDLE;
+	if ( joined )
+		ps->quit_pending = true;
+	sta_changed(ps);
+
+	m1_wifi_sta_tick(ps, now_ms);
+} // void m1_wifi_sta_disconnect(S_M1_Wifi_Sta *ps, uint32_t now_ms)
+
+
+
+// Waits before the next rejoin, each wait twice the one before up to the cap
+static void sta_backoff(S_M1_Wifi_Sta *ps, uint32_t now_ms)
+{
+	ps->state = M1_WIFI_STA_BACKOFF;
+	ps->retry_ms = now_ms + ps->backoff_ms;
+	ps->backoff_ms *= 2;
+	if ( ps->backoff_ms > M1_WIFI_STA_BACKOFF_MAX_MS )
+		ps->backoff_ms = M1_WIFI_STA_BACKOFF_MAX_MS;
+} // static void sta_backoff(S_M1_Wifi_Sta *ps, uint32_t now_ms)
+
+
+
+static void sta_join_failed(S_M1_Wifi_Sta *ps, uint32_t now_ms)
+{
+	ps->attempts++;
+	if ( ps->join_error==M1_WIFI_STA_JOIN_ERR_PASSWORD )
+		ps->state = M1_WIFI_STA_FAILED;
+	else
+		sta_backoff(ps, now_ms);
+	sta_changed(ps);
+} // static void sta_join_failed(S_M1_Wifi_Sta *ps, uint32_t now_ms)
+
+
+
+// The first rejoin after a drop waits the shortest backoff
+static void sta_link_lost(S_M1_Wifi_Sta *ps, uint32_t now_ms)
+{
+	ps->drops++;
+	sta_status_clear(ps);
+	sta_backoff(ps, now_ms);
+	sta_changed(ps);
+} // static void sta_link_lost(S_M1_Wifi_Sta *ps, uint32_t now_ms)
+
+
+
+/*============================================================================*/
+/*
+ * This function is told the ESP32 was restarted by someone else (AT+RST or
+ * the reset pin). The command in flight will not be answered and the network
+ * is gone: a joined link counts as a drop, a join under way is retried
+ * without counting as a failed attempt.
+ */
+/*============================================================================*/
+void m1_wifi_sta_reset(S_M1_Wifi_Sta *ps, uint32_t now_ms)
+{
+	ps->cmd = M1_WIFI_STA_CMD_NONE;
+	ps->quit_pending = false; // Not joined anymore, nothing to leave
+
+	if ( ps->state==M1_WIFI_STA_CONNECTED )
+	{
+		sta_link_lost(ps, now_ms);
+	}
+	else if ( ps->state==M1_WIFI_STA_JOINING )
+	{
+		sta_status_clear(ps);
+		sta_backoff(ps, now_ms);
+		sta_changed(ps);
+	}
+} // void m1_wifi_sta_reset(S_M1_Wifi_Sta *ps, uint32_t now_ms)
+
+
+
+/*============================================================================*/
+/*
+ * This function moves on once the command in flight has its final response,
+ * ok is false for ERROR, FAIL or a timeout.
+ */
+/*============================================================================*/
+static void sta_cmd_done(S_M1_Wifi_Sta *ps, bool ok, uint32_t now_ms)
+{
+	S_M1_Wifi_Sta_Cmd cmd = ps->cmd;
+
+	ps->cmd = M1_WIFI_STA_CMD_NONE;
+
+	switch ( cmd )
+	{
+		case M1_WIFI_STA_CMD_MODE:
+			if ( ps->state!=M1_WIFI_STA_JOINING )
+				break;
+			if ( ok )
+				sta_send(ps, M1_WIFI_STA_CMD_RECONN_CFG, AT_REQ_RECONN_OFF, M1_WIFI_STA_CMD_TIMEOUT_MS, now_ms);
+			else
+				sta_join_failed(ps, now_ms);
+			break;
+
+		case M1_WIFI_STA_CMD_RECONN_CFG: // Older ESP-AT releases lack it, the join goes on
+			if ( ps->state==M1_WIFI_STA_JOINING )
+				sta_send_join(ps, now_ms);
+			break;
+
+		case M1_WIFI_STA_CMD_JOIN:
+			if ( ps->state!=M1_WIFI_STA_JOINING )
+				break;
+			if ( !ok )
+			{
+				sta_join_failed(ps, now_ms);
+				break;
+			}
+			ps->state = M1_WIFI_STA_CONNECTED;
+			ps->attempts = 0;
+			ps->join_error = 0;
+			ps->backoff_ms = M1_WIFI_STA_BACKOFF_MIN_MS;
+			ps->connects++;
+			ps->poll_ms = now_ms; // RSSI and IP right away
+			sta_changed(ps);
+			break;
+
+		case M1_WIFI_STA_CMD_QUERY_AP:
+			if ( ps->state!=M1_WIFI_STA_CONNECTED || !ok )
+				break; // Asked again at the next poll
+			sta_send(ps, M1_WIFI_STA_CMD_QUERY_IP, AT_REQ_QUERY_IP, M1_WIFI_STA_CMD_TIMEOUT_MS, now_ms);
+			break;
+
+		case M1_WIFI_STA_CMD_QUERY_IP:
+			if ( ps->state!=M1_WIFI_STA_CONNECTED )
+				break;
+			ps->poll_ms = now_ms + M1_WIFI_STA_POLL_MS;
+			sta_changed(ps);
+			break;
+
+		default:
+			break;
+	} // switch ( cmd )
+} // static void sta_cmd_done(S_M1_Wifi_Sta *ps, bool ok, uint32_t now_ms)
+
+
+
+// +CWJAP:"<ssid>","<bssid>",<channel>,<rssi>[,...], the SSID may hold any character
+static void sta_parse_ap(S_M1_Wifi_Sta *ps, const char *info)
+{
+	const char *p = info;
+	char *end;
+
+	// The BSSID is the one field of a fixed size: "," + 17 characters + ",
+	while ( (p = strstr(p, "\",\""))!=NULL )
+	{
+		const char *bssid = p + 3;
+
+		if ( strlen(bssid) > M1_WIFI_STA_BSSID_LEN + 1 && bssid[M1_WIFI_STA_BSSID_LEN]=='"'
+				&& bssid[M1_WIFI_STA_BSSID_LEN + 1]==',' )
+		{
+			memcpy(ps->bssid, bssid, M1_WIFI_STA_BSSID_LEN);
+			ps->bssid[M1_WIFI_STA_BSSID_LEN] = '\0';
+			ps->channel = (uint8_t)strtol(&bssid[M1_WIFI_STA_BSSID_LEN + 2], &end, 10);
+			if ( *end==',' )
+				ps->rssi = (int8_t)strtol(end + 1, NULL, 10);
+			return;
+		}
+		p++;
+	} // while ( (p = strstr(p, "\",\""))!=NULL )
+} // static void sta_parse_ap(S_M1_Wifi_Sta *ps, const char *info)
+
+
+
+// +CIPSTA:ip:"<ip>"
+static void sta_parse_ip(S_M1_Wifi_Sta *ps, const char *info)
+{
+	const char *end;
+	size_t len;
+
+	if ( *info!='"' )
+		return;
+	info++;
+	end = strchr(info, '"');
+	if ( !end )
+		return;
+	len = end - info;
+	if ( len > M1_WIFI_STA_IP_LEN )
+		return;
+	memcpy(ps->ip, info, len);
+	ps->ip[len] = '\0';
+} // static void sta_parse_ip(S_M1_Wifi_Sta *ps, const char *info)
+
+
+
+/*============================================================================*/
+/*
+ * This function takes one response line of the ESP32, without its CR LF.
+ * Command echoes and lines it does not know are ignored.
+ */
+/*============================================================================*/
+void m1_wifi_sta_rx_line(S_M1_Wifi_Sta *ps, const char *line, uint32_t now_ms)
+{
+	if ( !strcmp(line, "OK") )
+	{
+		if ( ps->cmd!=M1_WIFI_STA_CMD_NONE )
+			sta_cmd_done(ps, true, now_ms);
+	}
+	else if ( !strcmp(line, "ERROR") || !strcmp(line, "FAIL") )
+	{
+		if ( ps->cmd!=M1_WIFI_STA_CMD_NONE )
+			sta_cmd_done(ps, false, now_ms);
+	}
+	else if ( !strncmp(line, AT_RES_JOIN_KEY, strlen(AT_RES_JOIN_KEY)) )
+	{
+		line += strlen(AT_RES_JOIN_KEY);
+		if ( ps->cmd==M1_WIFI_STA_CMD_JOIN && *line>='0' && *line<='9' )
+			ps->join_error = (uint8_t)atoi(line);
+		else if ( ps->cmd==M1_WIFI_STA_CMD_QUERY_AP && *line=='"' )
+			sta_parse_ap(ps, line);
+	}
+	else if ( !strncmp(line, AT_RES_IP_KEY, strlen(AT_RES_IP_KEY)) )
+	{
+		if ( ps->cmd==M1_WIFI_STA_CMD_QUERY_IP )
+			sta_parse_ip(ps, line + strlen(AT_RES_IP_KEY));
+	}
+	else if ( !strcmp(line, AT_RES_NO_AP) )
+	{
+		// The drop event was missed
+		if ( ps->cmd==M1_WIFI_STA_CMD_QUERY_AP && ps->state==M1_WIFI_STA_CONNECTED )
+			sta_link_lost(ps, now_ms);
+	}
+	else if ( !strcmp(line, AT_EVT_DISCONNECT) )
+	{
+		// While joining, the ESP32 reports each failed try; the join result follows
+		if ( ps->state==M1_WIFI_STA_CONNECTED )
+			sta_link_lost(ps, now_ms);
+	}
+	else if ( !strcmp(line, AT_EVT_GOT_IP) )
+	{
+		if ( ps->state==M1_WIFI_STA_CONNECTED )
+			ps->poll_ms = now_ms; // New lease
+	}
+} // void m1_wifi_sta_rx_line(S_M1_Wifi_Sta *ps, const char *line, uint32_t now_ms)
+
+
+
+/*============================================================================*/
+/*
+ * This function runs the command timeouts, the rejoins and the status polls.
+ * It is called periodically and after each batch of response lines.
+ */
+/*============================================================================*/
+void m1_wifi_sta_tick(S_M1_Wifi_Sta *ps, uint32_t now_ms)
+{
+	if ( ps->cmd!=M1_WIFI_STA_CMD_NONE )
+	{
+		if ( !sta_due(ps->cmd_deadline_ms, now_ms) )
+			return;
+		sta_cmd_done(ps, false, now_ms);
+		if ( ps->cmd!=M1_WIFI_STA_CMD_NONE )
+			return;
+	} // if ( ps->cmd!=M1_WIFI_STA_CMD_NONE )
+
+	if ( ps->quit_pending )
+	{
+		ps->quit_pending = false;
+		sta_send(ps, M1_WIFI_STA_CMD_QUIT, AT_REQ_QUIT, M1_WIFI_STA_CMD_TIMEOUT_MS, now_ms);
+		return;
+	}
+
+	if ( ps->state==M1_WIFI_STA_BACKOFF && sta_due(ps->retry_ms, now_ms) )
+	{
+		ps->state = M1_WIFI_STA_JOINING;
+		ps->join_error = 0;
+		sta_changed(ps);
+		sta_send(ps, M1_WIFI_STA_CMD_MODE, AT_REQ_MODE_STA, M1_WIFI_STA_CMD_TIMEOUT_MS, now_ms);
+	}
+	else if ( ps->state==M1_WIFI_STA_CONNECTED && sta_due(ps->poll_ms, now_ms) )
+	{
+		ps->poll_ms = now_ms + M1_WIFI_STA_POLL_MS; // Also if the query times out
+		sta_send(ps, M1_WIFI_STA_CMD_QUERY_AP, AT_REQ_QUERY_AP, M1_WIFI_STA_CMD_TIMEOUT_MS, now_ms);
+	}
+} // void m1_wifi_sta_tick(S_M1_Wifi_Sta *ps, uint32_t now_ms)
@@ -0,0 +1,105 @@
+/* See COPYING.txt for license details. */
+
+/*
+*
+* m1_wifi_sta.h
+*
+* Header for the Wi-Fi station connection manager
+*
+* The manager keeps the ESP32 joined to one network through the ESP-AT
+* command set: it selects station mode, joins, polls the RSSI and the IP
+* address while connected and rejoins with an exponential backoff when the
+* link drops or a join fails. A wrong password stops the retries.
+*
+* It is driven by the caller: AT command lines go out through the send
+* callback, the response lines (CR LF stripped) come back through
+* m1_wifi_sta_rx_line() and m1_wifi_sta_tick() runs the timeouts. Only one
+* command is in flight at a time. Times are in ms.
+*
+* M1 Project
+*
+*/
+
+#ifndef M1_WIFI_STA_H_
+#define M1_WIFI_STA_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define M1_WIFI_STA_SSID_LEN			32
+#define M1_WIFI_STA_PWD_LEN				64
+#define M1_WIFI_STA_IP_LEN				15 // "255.255.255.255"
+#define M1_WIFI_STA_BSSID_LEN			17 // "aa:bb:cc:dd:ee:ff"
+#define M1_WIFI_STA_CMD_LEN				(20 + 2*(M1_WIFI_STA_SSID_LEN + M1_WIFI_STA_PWD_LEN)) // All characters escaped
+
+#define M1_WIFI_STA_CMD_TIMEOUT_MS		5000
+#define M1_WIFI_STA_JOIN_TIMEOUT_MS		20000 // The ESP32 gives up joining after 15 s
+#define M1_WIFI_STA_POLL_MS				10000 // RSSI and IP refresh while connected
+#define M1_WIFI_STA_BACKOFF_MIN_MS		2000
+#define M1_WIFI_STA_BACKOFF_MAX_MS		60000
+
+// +CWJAP:<error code> of a failed join
+#define M1_WIFI_STA_JOIN_ERR_TIMEOUT	1
+#define M1_WIFI_STA_JOIN_ERR_PASSWORD	2
+#define M1_WIFI_STA_JOIN_ERR_NO_AP		3
+#define M1_WIFI_STA_JOIN_ERR_FAIL		4
+
+typedef enum
+{
+	M1_WIFI_STA_IDLE = 0, // No network
+	M1_WIFI_STA_JOINING,
+	M1_WIFI_STA_CONNECTED,
+	M1_WIFI_STA_BACKOFF, // Waiting to rejoin
+	M1_WIFI_STA_FAILED // Rejected for good, a new m1_wifi_sta_connect() is needed
+} S_M1_Wifi_Sta_State;
+
+typedef enum
+{
+	M1_WIFI_STA_CMD_NONE = 0,
+	M1_WIFI_STA_CMD_MODE,
+	M1_WIFI_STA_CMD_RECONN_CFG,
+	M1_WIFI_STA_CMD_JOIN,
+	M1_WIFI_STA_CMD_QUERY_AP,
+	M1_WIFI_STA_CMD_QUERY_IP,
+	M1_WIFI_STA_CMD_QUIT
+} S_M1_Wifi_Sta_Cmd;
+
+typedef struct
+{
+	bool (*send)(void *ctx, const char *cmd); // Command line with its CR LF
+	void (*changed)(void *ctx); // State or status changed, optional
+	void *ctx;
+} S_M1_Wifi_Sta_Config;
+
+typedef struct
+{
+	S_M1_Wifi_Sta_Config cfg;
+	S_M1_Wifi_Sta_State state;
+	S_M1_Wifi_Sta_Cmd cmd; // In flight
+	uint32_t cmd_deadline_ms;
+	uint32_t retry_ms; // Rejoin time in M1_WIFI_STA_BACKOFF
+	uint32_t poll_ms; // Next status poll in M1_WIFI_STA_CONNECTED
+	uint32_t backoff_ms; // Wait before the next rejoin
+	bool quit_pending; // Leave the network once the command in flight is done
+	char ssid[M1_WIFI_STA_SSID_LEN + 1];
+	char pwd[M1_WIFI_STA_PWD_LEN + 1];
+	// Status
+	char ip[M1_WIFI_STA_IP_LEN + 1];
+	char bssid[M1_WIFI_STA_BSSID_LEN + 1];
+	int8_t rssi; // dBm, 0 if unknown
+	uint8_t channel;
+	uint8_t join_error; // Last M1_WIFI_STA_JOIN_ERR_x, 0 if none
+	uint8_t attempts; // Failed joins since the last connection
+	uint32_t connects;
+	uint32_t drops; // Connections lost
+} S_M1_Wifi_Sta;
+
+void m1_wifi_sta_init(S_M1_Wifi_Sta *ps, const S_M1_Wifi_Sta_Config *cfg);
+void m1_wifi_sta_connect(S_M1_Wifi_Sta *ps, const char *ssid, const char *pwd, uint32_t now_ms);
+void m1_wifi_sta_disconnect(S_M1_Wifi_Sta *ps, uint32_t now_ms);
+void m1_wifi_sta_reset(S_M1_Wifi_Sta *ps, uint32_t now_ms);
+void m1_wifi_sta_rx_line(S_M1_Wifi_Sta *ps, const char *line, uint32_t now_ms);
+void m1_wifi_sta_tick(S_M1_Wifi_Sta *ps, uint32_t now_ms);
+uint16_t m1_wifi_sta_at_quote(char *dst, uint16_t size, const char *src);
+
+#endif /* M1_WIFI_STA_H_ */
@@ -16,6 +16,7 @@
 #include "m1_virtual_kb.h"
 #include "m1_storage.h"
 #include "uiView.h"
+#include "m1_compositor.h"
 
 /***************************** V A R I A B L E S ******************************/
 
@@ -26,6 +27,9 @@ static screen_timeout_cb_t s_timeoutCallback  = NULL;
 
 static S_M1_uiview_t uiview_view_list[VIEW_MODE_END];
 
+static S_M1_Compositor	uiview_compositor;
+static TimerHandle_t	uiview_frame_timer = NULL; // One Q_EVENT_UI_REDRAW per frame at most
+
 /********************* F U N C T I O N   P R O T O T Y P E S ******************/
 void m1_uiView_functions_register(uint8_t nMode,
         void (*create) (uint8_t param),
@@ -35,6 +39,11 @@ void m1_uiView_functions_register(uint8_t nMode,
 void m1_uiView_functions_init(int size, const view_func_t *table);
 void m1_uiView_display_switch(uint8_t mode, uint32_t lParam);
 void m1_uiView_display_update(uint32_t param);
+void m1_uiView_display_invalidate(uint32_t param);
+void m1_uiView_display_redraw(void);
+static void uiview_frame_render(uint8_t param);
+static void uiview_frame_timer_arm(void);
+static void uiview_frame_timer_cb(TimerHandle_t xTimer);
 static void prvScreenTimeoutTimerCb(TimerHandle_t xTimer);
 void uiScreen_timeout_init(void);
 void uiScreen_timeout_start(uint32_t timeout_ms, screen_timeout_cb_t cb);
@@ -77,6 +86,7 @@ void m1_uiView_functions_init(int size, const view_func_t *table)
 
 	uiview_current_mode = 0;
 	memset(uiview_view_list, 0, sizeof(uiview_view_list));
+	m1_compositor_init(&uiview_compositor, M1_COMPOSITOR_FRAME_MS);
 
 	for (i = 0; i < size; i++)
 	{
@@ -101,6 +111,7 @@ void m1_uiView_functions_init(int size, const view_func_t *table)
 void m1_uiView_display_switch(uint8_t mode, uint32_t lParam)
 {
 	uiScreen_timeout_cancel();
+	m1_compositor_cancel(&uiview_compositor);
 
 #if 0
 	if (uiview_current_mode == mode)
@@ -159,12 +170,104 @@ void m1_uiView_display_update(uint32_t param)
 		if (uiview_view_list[uiview_current_mode].update)
 		{
 			uiview_view_list[uiview_current_mode].update(param);
+			m1_compositor_frame_done(&uiview_compositor, HAL_GetTick());
 		}
 	}
 } // void m1_uiView_display_update(uint32_t param)
 
 
 
+/*============================================================================*/
+/**
+  * @brief  Asks for a redraw of the current screen from a data event. Bursts
+  *         are coalesced into one frame per M1_COMPOSITOR_FRAME_MS, drawn
+  *         with the last param. A frame put off comes back as
+  *         Q_EVENT_UI_REDRAW, for m1_uiView_display_redraw().
+  * @param  param passed to the update function of the screen
+  * @retval None
+  */
+/*============================================================================*/
+void m1_uiView_display_invalidate(uint32_t param)
+{
+	uint8_t frame_param;
+
+	if ( !uiview_current_mode || !uiview_view_list[uiview_current_mode].update )
+		return;
+
+	if ( m1_compositor_invalidate(&uiview_compositor, param, HAL_GetTick()) )
+	{
+		if ( m1_compositor_take(&uiview_compositor, HAL_GetTick(), &frame_param) )
+			uiview_frame_render(frame_param);
+	}
+	else
+	{
+		uiview_frame_timer_arm();
+	}
+} // void m1_uiView_display_invalidate(uint32_t param)
+
+
+
+/*============================================================================*/
+/**
+  * @brief  Draws the frame put off by m1_uiView_display_invalidate(), on
+  *         Q_EVENT_UI_REDRAW
+  * @param  None
+  * @retval None
+  */
+/*============================================================================*/
+void m1_uiView_display_redraw(void)
+{
+	uint8_t frame_param;
+
+	if ( m1_compositor_take(&uiview_compositor, HAL_GetTick(), &frame_param) )
+		uiview_frame_render(frame_param);
+	else
+		uiview_frame_timer_arm(); // A direct update moved the frame on, if still pending
+} // void m1_uiView_display_redraw(void)
+
+
+
+static void uiview_frame_render(uint8_t param)
+{
+	if ( uiview_current_mode && uiview_view_list[uiview_current_mode].update )
+		uiview_view_list[uiview_current_mode].update(param);
+} // static void uiview_frame_render(uint8_t param)
+
+
+
+// Sends Q_EVENT_UI_REDRAW when the pending frame is due
+static void uiview_frame_timer_arm(void)
+{
+	uint32_t due_ms = m1_compositor_due_in(&uiview_compositor, HAL_GetTick());
+	TickType_t ticks;
+
+	if ( due_ms==UINT32_MAX )
+		return;
+
+	if ( uiview_frame_timer==NULL )
+	{
+		uiview_frame_timer = xTimerCreate("UiFrame", 1, pdFALSE, NULL, uiview_frame_timer_cb);
+		if ( uiview_frame_timer==NULL )
+			return;
+	}
+	if ( xTimerIsTimerActive(uiview_frame_timer) )
+		return; // Due no later than this frame
+
+	ticks = pdMS_TO_TICKS(due_ms);
+	xTimerChangePeriod(uiview_frame_timer, ticks ? ticks : 1, 0); // Starts it
+} // static void uiview_frame_timer_arm(void)
+
+
+
+static void uiview_frame_timer_cb(TimerHandle_t xTimer)
+{
+	(void)xTimer;
+
+	m1_app_send_q_message(main_q_hdl, Q_EVENT_UI_REDRAW);
+} // static void uiview_frame_timer_cb(TimerHandle_t xTimer)
+
+
+
 /*============================================================================*/
 /**
   * @brief
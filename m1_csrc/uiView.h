@@ -36,6 +36,8 @@ void m1_uiView_functions_register (uint8_t nMode,
         void (*destroy)(uint8_t param),
         int (*message) (void));
 void m1_uiView_display_update(uint32_t param);
+void m1_uiView_display_invalidate(uint32_t param);
+void m1_uiView_display_redraw(void);
 int m1_uiView_q_message_process(void);
 void m1_uiView_functions_init(int size, const view_func_t *table);
 void m1_uiView_display_switch(uint8_t mode, uint32_t lParam);
@@ -0,0 +1,294 @@
+#!/usr/bin/env python3
+"""
+Receive the M1 binary edge timing stream and write it to a capture file.
+
+The device sends live Sub-GHz, LF RFID or IR edge timings over the USB CDC
+port after the CLI command "stream <subghz|lfrfid|ir>" (m1_csrc/m1_cdc_stream.h).
+This script sends the command, checks every packet (sync word, CRC, sequence
+number) and writes the samples as:
+- sgh: M1 Sub-GHz raw file (Filetype: M1 SubGHz NOISE), replayable on the M1
+- ir:  IR signals file with one raw signal per burst, as saved by IR learn
+- csv: one line per level: start time, level, duration in us
+
+Packet layout, little endian:
+    uint16 sync 0x314D ("M1"), uint8 version, uint8 source, uint16 seq,
+    uint16 n_samples, uint32 dropped, uint32 time_ms, uint32 info,
+    n_samples x uint16 (bit 15 level, bits 14..0 duration in us),
+    uint16 CRC-16/CCITT-FALSE over header and samples
+
+Usage:
+    cdc_stream_rx.py /dev/ttyACM0 subghz capture.sgh --seconds 10
+    cdc_stream_rx.py /dev/ttyACM0 ir remote.ir
+    cdc_stream_rx.py --input dump.bin lfrfid tag.csv
+
+The capture itself is started on the device as usual (Sub-GHz Record,
+IR Learn, 125 kHz RFID Read). Stop with Ctrl+C or --seconds.
+"""
+
+import argparse
+import struct
+import sys
+import time
+
+SYNC = b"M1"
+VERSION = 1
+HEADER = struct.Struct("<HBBHHIII")
+CRC_SIZE = 2
+BUF_SIZE = 4096
+SAMPLES_MAX = (BUF_SIZE - HEADER.size - CRC_SIZE) // 2
+LEVEL_BIT = 0x8000
+
+SOURCES = {"subghz": 1, "lfrfid": 2, "ir": 3}
+DEFAULT_FORMAT = {"subghz": "sgh", "lfrfid": "csv", "ir": "ir"}
+
+SGH_LINE_SAMPLES = 512  # SUBGHZ_RAW_DATA_SAMPLES_TO_RW
+SGH_SAMPLE_MAX = 0xFFFF
+SGH_PAD_US = 1500  # INTERPACKET_GAP_MIN
+IR_END_GAP_US = 150000  # IR_RAW_END_GAP_MS
+IR_MIN_EDGES = 6
+IR_EDGES_MAX = 1024
+IR_FREQ_DEFAULT = 38000
+
+
+def crc16_ccitt(data, crc=0xFFFF):
+    """CRC-16/CCITT-FALSE, crc16(data, len, 0x1021, 0xFFFF) on the device."""
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+class StreamParser:
+    """Splits the byte stream into packets, skipping text and corrupt data."""
+
+    def __init__(self, source):
+        self.source = source
+        self.buf = bytearray()
+        self.next_seq = None
+        self.packets = 0
+        self.bad = 0
+        self.lost_packets = 0
+        self.dropped = 0
+        self.info = 0
+
+    def feed(self, data):
+        """Yields (time_ms, samples) for every complete packet in data."""
+        self.buf += data
+        while True:
+            start = self.buf.find(SYNC)
+            if start < 0:
+                del self.buf[: max(0, len(self.buf) - 1)]
+                return
+            del self.buf[:start]
+            if len(self.buf) < HEADER.size:
+                return
+            _, version, source, seq, n, dropped, time_ms, info = HEADER.unpack_from(self.buf)
+            if version != VERSION or source != self.source or n > SAMPLES_MAX:
+                del self.buf[:1]
+                continue
+            size = HEADER.size + 2 * n + CRC_SIZE
+            if len(self.buf) < size:
+                return
+            (crc,) = struct.unpack_from("<H", self.buf, size - CRC_SIZE)
+            if crc != crc16_ccitt(self.buf[: size - CRC_SIZE]):
+                self.bad += 1
+                del self.buf[:1]
+                continue
+
+            samples = struct.unpack_from("<%dH" % n, self.buf, HEADER.size)
+            del self.buf[:size]
+            if self.next_seq is not None and seq != self.next_seq:
+                self.lost_packets += (seq - self.next_seq) & 0xFFFF
+            self.next_seq = (seq + 1) & 0xFFFF
+            self.packets += 1
+            self.dropped = dropped
+            self.info = info
+            yield time_ms, samples
+
+
+class Levels:
+    """Joins the samples of a split duration back into one level."""
+
+    def __init__(self, writer):
+        self.writer = writer
+        self.level = None
+        self.us = 0
+
+    def add(self, samples):
+        for sample in samples:
+            level = bool(sample & LEVEL_BIT)
+            us = sample & ~LEVEL_BIT
+            if level == self.level:
+                self.us += us
+                continue
+            if self.level is not None:
+                self.writer.level(self.level, self.us)
+            self.level, self.us = level, us
+
+    def close(self):
+        if self.level is not None:
+            self.writer.level(self.level, self.us)
+        self.writer.close()
+
+
+class CsvWriter:
+    def __init__(self, f, args, parser):
+        self.f = f
+        self.t = 0
+        f.write("start_us,level,duration_us\n")
+
+    def level(self, level, us):
+        self.f.write("%d,%d,%d\n" % (self.t, level, us))
+        self.t += us
+
+    def close(self):
+        pass
+
+
+class SghWriter:
+    """M1 Sub-GHz raw file, each Data: line holds high/low pairs."""
+
+    def __init__(self, f, args, parser):
+        self.f = f
+        self.args = args
+        self.parser = parser
+        self.line = []
+        self.header = False
+
+    def level(self, level, us):
+        if not self.line and not level:
+            return  # Lines start with a high pulse
+        if self.line and (len(self.line) % 2 == 0) != level:
+            return  # Cannot happen after Levels, keeps the pairs aligned
+        self.line.append(min(us, SGH_SAMPLE_MAX))
+        if len(self.line) >= SGH_LINE_SAMPLES:
+            self.flush_line()
+
+    def flush_line(self):
+        if not self.header:
+            freq = self.args.frequency or self.parser.info or 433920000
+            self.f.write("Filetype: M1 SubGHz NOISE\r\nVersion: 0.8\r\n")
+            self.f.write("Frequency: %d\r\nModulation: %s\r\n" % (freq, self.args.modulation))
+            self.header = True
+        if not self.line:
+            return
+        if len(self.line) % 2:
+            self.line.append(SGH_PAD_US)
+        self.f.write(
+            "Data:"
+            + "".join(" %s%d" % ("+" if i % 2 == 0 else "", us) for i, us in enumerate(self.line))
+            + "\r\n"
+        )
+        self.line = []
+
+    def close(self):
+        self.flush_line()
+
+
+class IrWriter:
+    """IR signals file, the stream is cut into signals at long spaces."""
+
+    def __init__(self, f, args, parser):
+        self.f = f
+        self.args = args
+        self.edges = []
+        self.count = 0
+        f.write("Filetype: IR signals file\nVersion: 1\n")
+
+    def level(self, mark, us):
+        if not mark and us >= IR_END_GAP_US:
+            self.flush_signal()
+            return
+        if not self.edges and not mark:
+            return  # Signals start with a mark
+        self.edges.append(us)
+
+    def flush_signal(self):
+        edges = self.edges[:IR_EDGES_MAX]
+        if len(edges) % 2 == 0 and edges:
+            edges.pop()  # Signals end with a mark
+        self.edges = []
+        if len(edges) < IR_MIN_EDGES:
+            return
+        self.count += 1
+        self.f.write("#\nname: %s_%d\ntype: raw\n" % (self.args.name, self.count))
+        self.f.write("frequency: %d\nduty_cycle: 0.330000\n" % (self.args.frequency or IR_FREQ_DEFAULT))
+        self.f.write("data: %s\n" % " ".join(str(us) for us in edges))
+
+    def close(self):
+        self.flush_signal()
+
+
+WRITERS = {"csv": CsvWriter, "sgh": SghWriter, "ir": IrWriter}
+
+
+def open_port(args):
+    import serial  # pyserial, only needed for live captures
+
+    port = serial.Serial(args.port, 115200, timeout=0.1)
+    port.reset_input_buffer()
+    port.write(b"\r\nstream %s\r\n" % args.source.encode())
+    return port
+
+
+def main():
+    ap = argparse.ArgumentParser(description="Receive the M1 binary edge timing stream")
+    ap.add_argument("port", nargs="?", help="serial port of the M1, e.g. /dev/ttyACM0 or COM3")
+    ap.add_argument("source", choices=sorted(SOURCES))
+    ap.add_argument("output", help="capture file to write")
+    ap.add_argument("--format", choices=sorted(WRITERS), help="default: sgh, csv or ir by source")
+    ap.add_argument("--input", help="read a saved byte stream instead of the serial port")
+    ap.add_argument("--dump", help="also save the received bytes to this file")
+    ap.add_argument("--seconds", type=float, default=0, help="stop after this time, 0 for Ctrl+C")
+    ap.add_argument("--frequency", type=int, default=0, help="Hz, default: from the device")
+    ap.add_argument("--modulation", default="OOK", help="Sub-GHz modulation (default OOK)")
+    ap.add_argument("--name", default="capture", help="IR signal name prefix")
+    args = ap.parse_args()
+    if not args.port and not args.input:
+        ap.error("a serial port or --input is required")
+
+    parser = StreamParser(SOURCES[args.source])
+    fmt = args.format or DEFAULT_FORMAT[args.source]
+    out = open(args.output, "w", newline="")
+    levels = Levels(WRITERS[fmt](out, args, parser))
+    dump = open(args.dump, "wb") if args.dump else None
+
+    port = None
+    if args.input:
+        chunks = iter([open(args.input, "rb").read()])
+    else:
+        port = open_port(args)
+        chunks = iter(lambda: port.read(BUF_SIZE), None)
+
+    end = time.monotonic() + args.seconds if args.seconds else None
+    try:
+        for data in chunks:
+            if dump:
+                dump.write(data)
+            for _, samples in parser.feed(data):
+                levels.add(samples)
+            if end and time.monotonic() >= end:
+                break
+    except KeyboardInterrupt:
+        pass
+    finally:
+        if port:
+            port.write(b"\r\nstream off\r\n")
+            port.close()
+        levels.close()
+        out.close()
+        if dump:
+            dump.close()
+
+    print(
+        "%d packets, %d lost, %d bad, %d samples dropped on the device"
+        % (parser.packets, parser.lost_packets, parser.bad, parser.dropped),
+        file=sys.stderr,
+    )
+    return 0 if parser.packets else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())